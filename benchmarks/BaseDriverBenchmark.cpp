@@ -0,0 +1,215 @@
+/**
+ * @file BaseDriverBenchmark.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief End-to-end benchmark of synchronous inference through the BaseDriver against the XRT mock
+ * @version 0.1
+ * @date 2024-02-29
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/ConfigurationStructs.h>
+#include <FINNCppDriver/utils/Logger.h>
+#include <FINNCppDriver/utils/Types.h>
+#include <benchmark/benchmark.h>
+
+#include <FINNCppDriver/core/BaseDriver.hpp>
+#include <FINNCppDriver/utils/FinnDatatypes.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "xrt_simulation.h"
+
+namespace {
+    const std::string xclbinPath = "finn-benchmark.xclbin";
+    const std::string inputDmaName = "StreamingDataflowPartition_0:{idma0}";
+    const std::string outputDmaName = "StreamingDataflowPartition_2:{odma0}";
+
+    /**
+     * @brief Creates the dummy xclbin the DeviceHandler expects on disk and removes it again
+     *
+     */
+    struct XclbinFile {
+        XclbinFile() {
+            std::ofstream file(xclbinPath);
+            file << "benchmark\n";
+        }
+        XclbinFile(XclbinFile&&) = delete;
+        XclbinFile(const XclbinFile&) = delete;
+        XclbinFile& operator=(XclbinFile&&) = delete;
+        XclbinFile& operator=(const XclbinFile&) = delete;
+        ~XclbinFile() { std::filesystem::remove(xclbinPath); }
+    };
+    const XclbinFile xclbinFile;
+
+    /**
+     * @brief Config of a network with one idma and one odma of the same shape: rows folds of pe elements each
+     *
+     * @param bitwidth Bitwidth of the input and output datatype
+     * @param rows Number of folds per sample
+     * @param pe Number of elements per fold
+     * @return Finn::Config
+     */
+    Finn::Config createConfig(unsigned int bitwidth, std::size_t rows, std::size_t pe) {
+        const shape_t normal = {1, rows * pe};
+        const shape_t folded = {1, rows, pe};
+        const shape_t packed = {1, rows, (pe * bitwidth + 7) / 8};
+        std::vector<std::shared_ptr<Finn::BufferDescriptor>> idmas = {std::make_shared<Finn::ExtendedBufferDescriptor>(inputDmaName, packed, normal, folded)};
+        std::vector<std::shared_ptr<Finn::BufferDescriptor>> odmas = {std::make_shared<Finn::ExtendedBufferDescriptor>(outputDmaName, packed, normal, folded)};
+        return Finn::Config{{Finn::DeviceWrapper(xclbinPath, 0, idmas, odmas)}};
+    }
+}  // namespace
+
+/**
+ * @brief inferSynchronous of a whole batch into a preallocated output. Arguments: elements per fold, folds per sample, batch size.
+ *
+ * @tparam B Bitwidth of the unsigned input and output datatype
+ */
+template<unsigned int B>
+static void BM_InferSynchronous(benchmark::State& state) {
+    using Dt = Finn::DatatypeUInt<B>;
+    using Driver = Finn::BaseDriver<true, Dt, Dt>;
+    using V = typename Driver::AutoDeducedRetType;
+    const auto pe = static_cast<std::size_t>(state.range(0));
+    const auto rows = static_cast<std::size_t>(state.range(1));
+    const auto batchSize = static_cast<uint>(state.range(2));
+
+    Driver driver(createConfig(B, rows, pe), batchSize);
+    std::mt19937 engine{42};
+    std::uniform_int_distribution<unsigned int> dist{0, static_cast<unsigned int>(Dt().max())};
+    Finn::vector<uint8_t> input(driver.getInputElementsPerSample() * batchSize);
+    std::generate(input.begin(), input.end(), [&]() { return static_cast<uint8_t>(dist(engine)); });
+    Finn::vector<V> output(driver.getOutputElementsPerSample() * batchSize);
+
+    for (auto _ : state) {
+        driver.inferSynchronous(input.begin(), input.end(), std::span<V>(output.data(), output.size()), 0, inputDmaName, 0, outputDmaName);
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * batchSize);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size() * sizeof(uint8_t)));
+}
+
+static void inferArguments(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"pe", "folds", "batch"});
+    for (int64_t pe : {8, 32, 128}) {
+        for (int64_t folds : {10, 100}) {
+            for (int64_t batch : {1, 16, 64}) {
+                benchmark->Args({pe, folds, batch});
+            }
+        }
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_InferSynchronous, 1)->Apply(inferArguments);
+BENCHMARK_TEMPLATE(BM_InferSynchronous, 2)->Apply(inferArguments);
+BENCHMARK_TEMPLATE(BM_InferSynchronous, 4)->Apply(inferArguments);
+BENCHMARK_TEMPLATE(BM_InferSynchronous, 7)->Apply(inferArguments);
+BENCHMARK_TEMPLATE(BM_InferSynchronous, 8)->Apply(inferArguments);
+
+/**
+ * @brief Like BM_InferSynchronous, but through a prepared inference session. Arguments: elements per fold, folds per sample, batch size.
+ *
+ * @tparam B Bitwidth of the unsigned input and output datatype
+ */
+template<unsigned int B>
+static void BM_InferSession(benchmark::State& state) {
+    using Dt = Finn::DatatypeUInt<B>;
+    using Driver = Finn::BaseDriver<true, Dt, Dt>;
+    using V = typename Driver::AutoDeducedRetType;
+    const auto pe = static_cast<std::size_t>(state.range(0));
+    const auto rows = static_cast<std::size_t>(state.range(1));
+    const auto batchSize = static_cast<uint>(state.range(2));
+
+    Driver driver(createConfig(B, rows, pe), batchSize);
+    std::mt19937 engine{42};
+    std::uniform_int_distribution<unsigned int> dist{0, static_cast<unsigned int>(Dt().max())};
+    Finn::vector<uint8_t> input(driver.getInputElementsPerSample() * batchSize);
+    std::generate(input.begin(), input.end(), [&]() { return static_cast<uint8_t>(dist(engine)); });
+    Finn::vector<V> output(driver.getOutputElementsPerSample() * batchSize);
+    auto session = driver.prepare(0, inputDmaName, 0, outputDmaName);
+
+    for (auto _ : state) {
+        session.infer(input.begin(), input.end(), std::span<V>(output.data(), output.size()));
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * batchSize);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size() * sizeof(uint8_t)));
+}
+
+BENCHMARK_TEMPLATE(BM_InferSession, 2)->Apply(inferArguments);
+BENCHMARK_TEMPLATE(BM_InferSession, 8)->Apply(inferArguments);
+
+/**
+ * @brief inferSynchronousScheduled from several benchmark threads sharing one driver. Arguments: batch size.
+ *
+ */
+static void BM_InferSynchronousScheduled(benchmark::State& state) {
+    using Dt = Finn::DatatypeUInt<4>;
+    using Driver = Finn::BaseDriver<true, Dt, Dt>;
+    using V = Driver::AutoDeducedRetType;
+    constexpr std::size_t rows = 10;
+    constexpr std::size_t pe = 32;
+    static std::unique_ptr<Driver> driver;
+    const auto batchSize = static_cast<uint>(state.range(0));
+    if (state.thread_index() == 0) {
+        driver = std::make_unique<Driver>(createConfig(4, rows, pe), batchSize);
+        driver->setBufferSlots(static_cast<unsigned int>(state.threads()));
+    }
+    Finn::vector<uint8_t> input(rows * pe * batchSize, 1);
+    Finn::vector<V> output(rows * pe * batchSize);
+
+    // All threads pass a barrier before the first iteration, so the driver exists from here on
+    for (auto _ : state) {
+        driver->inferSynchronousScheduled(input.begin(), input.end(), std::span<V>(output.data(), output.size()));
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * batchSize);
+    if (state.thread_index() == 0) {
+        driver.reset();
+    }
+}
+BENCHMARK(BM_InferSynchronousScheduled)->ArgName("batch")->Arg(1)->Arg(16)->ThreadRange(1, 4)->UseRealTime();
+
+/**
+ * @brief inferSynchronousPipelined of several batches against the simulation model of the XRT mock, so overlapping transfers and kernel runs shows up in the
+ * measured time. The model resembles a PCIe Gen3 x16 card. Arguments: buffer slots, batch size.
+ *
+ */
+static void BM_InferPipelinedSimulated(benchmark::State& state) {
+    using Dt = Finn::DatatypeUInt<4>;
+    using Driver = Finn::BaseDriver<true, Dt, Dt>;
+    using V = Driver::AutoDeducedRetType;
+    constexpr std::size_t rows = 10;
+    constexpr std::size_t pe = 32;
+    constexpr std::size_t batches = 8;
+    const auto slots = static_cast<unsigned int>(state.range(0));
+    const auto batchSize = static_cast<uint>(state.range(1));
+
+    Driver driver(createConfig(4, rows, pe), batchSize);
+    driver.setBufferSlots(slots);
+    Finn::vector<uint8_t> input(rows * pe * batchSize * batches, 1);
+    Finn::vector<V> output(rows * pe * batchSize * batches);
+
+    const auto previous = xrt::simulation::model();
+    xrt::simulation::configure(xrt::simulation::parse("sync_latency_us=10,sync_gbps=12,kernel_latency_us=2,sample_ns=1000,register_ns=1000,wait=spin"));
+    for (auto _ : state) {
+        driver.inferSynchronousPipelined(input.begin(), input.end(), std::span<V>(output.data(), output.size()), 0, inputDmaName, 0, outputDmaName);
+        benchmark::DoNotOptimize(output.data());
+    }
+    xrt::simulation::configure(previous);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * batches * batchSize));
+}
+BENCHMARK(BM_InferPipelinedSimulated)->ArgNames({"slots", "batch"})->ArgsProduct({{1, 2, 3}, {16, 256}})->UseRealTime();
+
+
+BENCHMARK_MAIN();
@@ -16,6 +16,7 @@
 #include <FINNCppDriver/utils/DataPacking.hpp>
 #include <bitset>
 #include <boost/dynamic_bitset.hpp>
+#include <numeric>
 #include <vector>
 
 static void BM_Boost_DynBitset(benchmark::State& state) {
@@ -64,5 +65,44 @@ static void BM_Boost_DynBitset2(benchmark::State& state) {
 // Register the function as a benchmark
 BENCHMARK(BM_Boost_DynBitset2)->Iterations(1000);
 
+static void BM_Finn_DynBitsetAppend(benchmark::State& state) {
+    constexpr std::size_t width = 7;
+    constexpr std::size_t values = 100000;
+    for (auto _ : state) {
+        DynamicBitset set(values * width);
+        for (std::size_t i = 0; i < values; ++i) {
+            set.appendBits(i, width);
+        }
+        benchmark::DoNotOptimize(set);
+    }
+}
+// Register the function as a benchmark
+BENCHMARK(BM_Finn_DynBitsetAppend)->Iterations(1000);
+
+static void BM_Finn_DynBitsetOr(benchmark::State& state) {
+    DynamicBitset set(1000000);
+    DynamicBitset other(1000000);
+    other.setSingleBit(12345);
+    for (auto _ : state) {
+        set |= other;
+        benchmark::DoNotOptimize(set.none());
+    }
+}
+// Register the function as a benchmark
+BENCHMARK(BM_Finn_DynBitsetOr)->Iterations(1000);
+
+static void BM_Finn_MergeBitsets(benchmark::State& state) {
+    Finn::vector<uint8_t> input(1000000);
+    std::iota(input.begin(), input.end(), 0);
+    auto bitsets = Finn::toBitset<Finn::DatatypeUInt<7>, true, false>(input);
+    for (auto _ : state) {
+        auto merged = Finn::mergeBitsets<Finn::DatatypeUInt<7>>(bitsets);
+        benchmark::DoNotOptimize(merged);
+    }
+}
+// Register the function as a benchmark
+BENCHMARK(BM_Finn_MergeBitsets)->Iterations(100);
+
+
 
 BENCHMARK_MAIN();
@@ -16,6 +16,7 @@
 #include <FINNCppDriver/core/DeviceBuffer/AsyncDeviceBuffers.hpp>
 #include <FINNCppDriver/core/DeviceBuffer/SyncDeviceBuffers.hpp>
 #include <FINNCppDriver/utils/FinnDatatypes.hpp>
+#include <atomic>
 #include <chrono>
 #include <fstream>
 #include <thread>
@@ -197,5 +198,66 @@ static void BM_StoreMultithreaded_CVRP(benchmark::State& state) {
 }
 BENCHMARK(BM_StoreMultithreaded_CVRP)->Iterations(iterations);
 
+/**
+ * @brief Number of batch elements moved through an asynchronous buffer per benchmark iteration
+ *
+ */
+const std::size_t asyncPartsPerIteration = 10000;
+
+static void BM_AsyncInputStore(benchmark::State& state) {
+    xrt::device device;
+    xrt::uuid uuid;
+    Finn::AsyncDeviceInputBuffer<uint8_t> idb("Tester", device, uuid, myShapePacked, static_cast<unsigned int>(state.range(0)));
+    Finn::vector<uint8_t> data(idb.size(SIZE_SPECIFIER::FEATUREMAP_SIZE), 1);
+    for (auto _ : state) {
+        // Blocks while the ring buffer is full, so this is bounded by the worker that moves the parts to the device
+        for (std::size_t i = 0; i < asyncPartsPerIteration; i++) {
+            idb.store({data.begin(), data.end()});
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * asyncPartsPerIteration));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * asyncPartsPerIteration * data.size()));
+}
+BENCHMARK(BM_AsyncInputStore)->ArgName("ringParts")->Arg(2)->Arg(16)->Arg(256)->UseRealTime();
+
+static void BM_AsyncOutputCallback(benchmark::State& state) {
+    xrt::device device;
+    xrt::uuid uuid;
+    Finn::AsyncDeviceOutputBuffer<uint8_t> odb("Tester", device, uuid, myShapePacked, static_cast<unsigned int>(state.range(0)));
+    std::atomic<std::size_t> results = 0;
+    odb.setResultCallback([&results](std::span<const uint8_t> result) {
+        benchmark::DoNotOptimize(result.data());
+        results.fetch_add(1, std::memory_order_relaxed);
+    });
+    for (auto _ : state) {
+        const std::size_t target = results.load() + asyncPartsPerIteration;
+        while (results.load(std::memory_order_relaxed) < target) {
+            std::this_thread::yield();
+        }
+    }
+    odb.setResultCallback({});
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * asyncPartsPerIteration));
+}
+BENCHMARK(BM_AsyncOutputCallback)->ArgName("ringParts")->Arg(2)->Arg(16)->UseRealTime();
+
+static void BM_AsyncOutputArchive(benchmark::State& state) {
+    xrt::device device;
+    xrt::uuid uuid;
+    Finn::AsyncDeviceOutputBuffer<uint8_t> odb("Tester", device, uuid, myShapePacked, static_cast<unsigned int>(state.range(0)));
+    odb.setArchiveCapacity(static_cast<std::size_t>(state.range(1)) * odb.size(SIZE_SPECIFIER::FEATUREMAP_SIZE));
+    odb.getDataChunks();
+    for (auto _ : state) {
+        std::size_t received = 0;
+        while (received < asyncPartsPerIteration) {
+            odb.archiveValidBufferParts();
+            for (auto&& chunk : odb.getDataChunks()) {
+                received += chunk.size() / odb.size(SIZE_SPECIFIER::FEATUREMAP_SIZE);
+            }
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * asyncPartsPerIteration));
+}
+BENCHMARK(BM_AsyncOutputArchive)->ArgNames({"ringParts", "archiveParts"})->ArgsProduct({{2, 16}, {16, 1024}})->UseRealTime();
+
 
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -0,0 +1,118 @@
+/**
+ * @file RingBufferBenchmark.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Producer/consumer benchmark of the multithreaded RingBuffer
+ * @version 0.1
+ * @date 2024-02-29
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/Logger.h>
+#include <benchmark/benchmark.h>
+
+#include <FINNCppDriver/utils/RingBuffer.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Number of parts moved through the ring buffer per benchmark iteration
+ *
+ */
+const std::size_t partsPerIteration = 10000;
+
+/**
+ * @brief One producer thread stores copies, the benchmark thread reads them out. Arguments: elements per part, parts of the ring buffer.
+ *
+ */
+static void BM_RingBufferStoreRead(benchmark::State& state) {
+    const auto elementsPerPart = static_cast<std::size_t>(state.range(0));
+    const auto parts = static_cast<std::size_t>(state.range(1));
+    Finn::RingBuffer<uint8_t, true> ringBuffer(parts, elementsPerPart);
+    std::vector<uint8_t> in(elementsPerPart, 1);
+    std::vector<uint8_t> out(elementsPerPart);
+
+    for (auto _ : state) {
+        std::jthread producer([&]() {
+            for (std::size_t i = 0; i < partsPerIteration; ++i) {
+                ringBuffer.store(in.begin(), in.end());
+            }
+        });
+        for (std::size_t i = 0; i < partsPerIteration; ++i) {
+            ringBuffer.read(out.begin());
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * partsPerIteration));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * partsPerIteration * elementsPerPart));
+}
+BENCHMARK(BM_RingBufferStoreRead)->ArgNames({"elements", "parts"})->ArgsProduct({{64, 4096}, {2, 16, 256}})->UseRealTime();
+
+/**
+ * @brief Like BM_RingBufferStoreRead, but both sides work in place on claimed parts instead of copying
+ *
+ */
+static void BM_RingBufferClaimCommit(benchmark::State& state) {
+    const auto elementsPerPart = static_cast<std::size_t>(state.range(0));
+    const auto parts = static_cast<std::size_t>(state.range(1));
+    Finn::RingBuffer<uint8_t, true> ringBuffer(parts, elementsPerPart);
+
+    for (auto _ : state) {
+        std::jthread producer([&]() {
+            for (std::size_t i = 0; i < partsPerIteration; ++i) {
+                auto part = ringBuffer.claimWrite();
+                part.front() = static_cast<uint8_t>(i);
+                ringBuffer.commitWrite();
+            }
+        });
+        for (std::size_t i = 0; i < partsPerIteration; ++i) {
+            auto part = ringBuffer.claimRead();
+            benchmark::DoNotOptimize(part.front());
+            ringBuffer.commitRead();
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * partsPerIteration));
+}
+BENCHMARK(BM_RingBufferClaimCommit)->ArgNames({"elements", "parts"})->ArgsProduct({{64, 4096}, {2, 16, 256}})->UseRealTime();
+
+/**
+ * @brief Several producer threads that serialize their stores with a mutex, as the buffer requires, contend for one ring buffer. Arguments: producers.
+ *
+ */
+static void BM_RingBufferContendedProducers(benchmark::State& state) {
+    constexpr std::size_t elementsPerPart = 1024;
+    constexpr std::size_t parts = 16;
+    const auto producers = static_cast<std::size_t>(state.range(0));
+    const std::size_t partsPerProducer = partsPerIteration / producers;
+    Finn::RingBuffer<uint8_t, true> ringBuffer(parts, elementsPerPart);
+    std::mutex producerMutex;
+    std::vector<uint8_t> in(elementsPerPart, 1);
+    std::vector<uint8_t> out(elementsPerPart);
+
+    for (auto _ : state) {
+        std::vector<std::jthread> threads;
+        threads.reserve(producers);
+        for (std::size_t p = 0; p < producers; ++p) {
+            threads.emplace_back([&]() {
+                for (std::size_t i = 0; i < partsPerProducer; ++i) {
+                    std::lock_guard guard(producerMutex);
+                    ringBuffer.store(in.begin(), in.end());
+                }
+            });
+        }
+        for (std::size_t i = 0; i < partsPerProducer * producers; ++i) {
+            ringBuffer.read(out.begin());
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * partsPerProducer * producers));
+}
+BENCHMARK(BM_RingBufferContendedProducers)->ArgName("producers")->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+
+BENCHMARK_MAIN();
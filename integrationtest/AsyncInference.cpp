@@ -14,7 +14,11 @@
 #include <FINNCppDriver/core/BaseDriver.hpp>
 #include <FINNCppDriver/utils/FinnDatatypes.hpp>
 #include <FINNCppDriver/utils/join.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <numeric>
+#include <span>
 #include <thread>
 
 #include "gtest/gtest.h"
@@ -26,65 +30,92 @@ namespace Finn {
 
 using namespace std::literals::chrono_literals;
 
-// TEST(AsyncInference, asyncInferenceTest) {
-//     std::string exampleNetworkConfig = "config.json";
-//     Finn::Config conf = Finn::createConfigFromPath(exampleNetworkConfig);
+TEST(AsyncInference, asyncInferenceTest) {
+    std::string exampleNetworkConfig = "config.json";
+    Finn::Config conf = Finn::createConfigFromPath(exampleNetworkConfig);
 
-//     auto driver = Finn::Driver<false>(conf, 10, 0, conf.deviceWrappers[0].idmas[0]->kernelName, 0, conf.deviceWrappers[0].odmas[0]->kernelName, 1, true);
+    auto driver = Finn::Driver<false>(conf, 0, conf.deviceWrappers[0].idmas[0]->kernelName, 0, conf.deviceWrappers[0].odmas[0]->kernelName, 1, true);
 
-//     Finn::vector<int8_t> data(driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, conf.deviceWrappers[0].idmas[0]->kernelName), 1);
+    Finn::vector<int8_t> data(driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, conf.deviceWrappers[0].idmas[0]->kernelName), 1);
 
-//     std::iota(data.begin(), data.end(), -127);
+    std::iota(data.begin(), data.end(), -127);
 
-//     // Run inference
-//     driver.input(data.begin(), data.end());
-//     std::this_thread::sleep_for(200ms);
-//     auto results = driver.getResults();
+    // Run inference
+    driver.input(data.begin(), data.end());
+    std::this_thread::sleep_for(200ms);
+    auto results = driver.getResults();
 
-//     Finn::vector<uint16_t> expectedResults = {254, 510, 253, 509, 252};
+    Finn::vector<uint16_t> expectedResults = {254, 510, 253, 509, 252};
 
-//     EXPECT_EQ(results, expectedResults);
-// }
-
-// TEST(AsyncInference, asyncBatchInferenceTest) {
-//     std::string exampleNetworkConfig = "config.json";
-//     Finn::Config conf = Finn::createConfigFromPath(exampleNetworkConfig);
-//     std::size_t batchLength = 10;
-
-//     auto driver = Finn::Driver<false>(conf, static_cast<uint>(batchLength), 0, conf.deviceWrappers[0].idmas[0]->kernelName, 0, conf.deviceWrappers[0].odmas[0]->kernelName, static_cast<uint>(batchLength), true);
-
-//     Finn::vector<int8_t> data(driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, conf.deviceWrappers[0].idmas[0]->kernelName) * batchLength, 1);
-
-//     for (std::size_t i = 0; i < batchLength; ++i) {
-//         std::iota(data.begin() + static_cast<decltype(data)::difference_type>(i * driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, conf.deviceWrappers[0].idmas[0]->kernelName)),
-//                   data.begin() + static_cast<decltype(data)::difference_type>((i + 1) * driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, conf.deviceWrappers[0].idmas[0]->kernelName)), -127);
-//     }
-
-//     // Run inference
-//     driver.input(data.begin(), data.end());
-//     std::this_thread::sleep_for(3000ms);
-//     auto results = driver.getResults();
-
-//     Finn::vector<uint16_t> expectedResults;
-
-//     for (std::size_t i = 0; i < batchLength; ++i) {
-//         expectedResults.insert(expectedResults.end(), {254, 510, 253, 509, 252});
-//     }
-
-//     EXPECT_EQ(results.size(), expectedResults.size());
-
-//     EXPECT_EQ(results, expectedResults);
+    EXPECT_EQ(results, expectedResults);
+}
 
-//     for (auto&& elem : results) {
-//         std::cout << elem << ",";
-//     }
-//     std::cout << "\n";
+TEST(AsyncInference, asyncBatchInferenceTest) {
+    std::string exampleNetworkConfig = "config.json";
+    Finn::Config conf = Finn::createConfigFromPath(exampleNetworkConfig);
+    std::size_t batchLength = 10;
+
+    auto driver = Finn::Driver<false>(conf, 0, conf.deviceWrappers[0].idmas[0]->kernelName, 0, conf.deviceWrappers[0].odmas[0]->kernelName, static_cast<uint>(batchLength), true);
+
+    Finn::vector<int8_t> data(driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, conf.deviceWrappers[0].idmas[0]->kernelName) * batchLength, 1);
+
+    for (std::size_t i = 0; i < batchLength; ++i) {
+        std::iota(data.begin() + static_cast<decltype(data)::difference_type>(i * driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, conf.deviceWrappers[0].idmas[0]->kernelName)),
+                  data.begin() + static_cast<decltype(data)::difference_type>((i + 1) * driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, conf.deviceWrappers[0].idmas[0]->kernelName)), -127);
+    }
+
+    Finn::vector<uint16_t> expectedResults;
+    for (std::size_t i = 0; i < batchLength; ++i) {
+        expectedResults.insert(expectedResults.end(), {254, 510, 253, 509, 252});
+    }
+
+    // Run inference and collect the results as they arrive, until all of them are there or the deadline passed
+    driver.input(data.begin(), data.end());
+    Finn::vector<uint16_t> results;
+    const auto deadline = std::chrono::steady_clock::now() + 3000ms;
+    while (results.size() < expectedResults.size() && std::chrono::steady_clock::now() < deadline) {
+        auto received = driver.getResults(0, conf.deviceWrappers[0].odmas[0]->kernelName, true);
+        if (received.empty()) {
+            std::this_thread::sleep_for(1ms);
+        }
+        results.insert(results.end(), received.begin(), received.end());
+    }
+
+    EXPECT_EQ(results, expectedResults);
+}
 
-//     for (auto&& elem : expectedResults) {
-//         std::cout << elem << ",";
-//     }
-//     std::cout << "\n";
-// }
+TEST(AsyncInference, asyncCallbackInferenceTest) {
+    std::string exampleNetworkConfig = "config.json";
+    Finn::Config conf = Finn::createConfigFromPath(exampleNetworkConfig);
+    std::size_t batchLength = 10;
+
+    auto driver = Finn::Driver<false>(conf, 0, conf.deviceWrappers[0].idmas[0]->kernelName, 0, conf.deviceWrappers[0].odmas[0]->kernelName, static_cast<uint>(batchLength), true);
+
+    std::mutex resultMutex;
+    std::condition_variable resultCv;
+    Finn::vector<uint16_t> results;
+    driver.setResultCallback<uint16_t>([&](std::span<const uint16_t> result) {
+        std::lock_guard guard(resultMutex);
+        results.insert(results.end(), result.begin(), result.end());
+        resultCv.notify_one();
+    });
+
+    Finn::vector<int8_t> data(driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, conf.deviceWrappers[0].idmas[0]->kernelName) * batchLength, 1);
+    for (std::size_t i = 0; i < batchLength; ++i) {
+        std::iota(data.begin() + static_cast<decltype(data)::difference_type>(i * driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, conf.deviceWrappers[0].idmas[0]->kernelName)),
+                  data.begin() + static_cast<decltype(data)::difference_type>((i + 1) * driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, conf.deviceWrappers[0].idmas[0]->kernelName)), -127);
+    }
+    driver.input(data.begin(), data.end());
+
+    Finn::vector<uint16_t> expectedResults;
+    for (std::size_t i = 0; i < batchLength; ++i) {
+        expectedResults.insert(expectedResults.end(), {254, 510, 253, 509, 252});
+    }
+
+    std::unique_lock lk(resultMutex);
+    EXPECT_TRUE(resultCv.wait_for(lk, 3000ms, [&] { return results.size() >= expectedResults.size(); }));
+    EXPECT_EQ(results, expectedResults);
+}
 
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -11,16 +11,27 @@
  */
 
 #include <algorithm>    // for generate
+#include <atomic>       // for atomic
+#include <csignal>      // for signal
 #include <chrono>       // for nanoseconds, ...
+#include <cmath>        // for ceil
 #include <cstddef>      // for size_t
 #include <cstdint>      // for uint64_t, uint8_t, ...
 #include <exception>    // for exception
 #include <filesystem>   // for path, exists
+#include <fstream>      // for ofstream
+#include <functional>   // for function
 #include <iostream>     // for streamsize
+#include <latch>        // for latch
+#include <map>          // for map
 #include <memory>       // for allocator_trai...
+#include <optional>     // for optional
 #include <random>       // for random_device, ...
+#include <span>         // for span
 #include <stdexcept>    // for invalid_argument
+#include <stop_token>   // for stop_source
 #include <string>       // for string
+#include <thread>       // for jthread
 #include <tuple>        // for tuple
 #include <type_traits>  // for remove_ref...
 #include <utility>      // for move
@@ -34,9 +45,21 @@
 #include <FINNCppDriver/utils/Logger.h>                // for FINN_LOG, ...
 #include <FINNCppDriver/utils/Types.h>                 // for shape_t
 
+#include <FINNCppDriver/core/Autotuner.hpp>        // for autotune
 #include <FINNCppDriver/core/BaseDriver.hpp>      // IWYU pragma: keep
+#include <FINNCppDriver/core/SharedMemoryDaemon.hpp>  // for SharedMemoryDaemon
+#include <FINNCppDriver/utils/Affinity.hpp>         // for pciNumaNode
+#include <FINNCppDriver/utils/ArrivalSchedule.hpp>  // for ArrivalSchedule
+#include <FINNCppDriver/utils/BoundedQueue.hpp>     // for BoundedQueue
+#include <FINNCppDriver/utils/NpyStream.hpp>        // for NpyReader, NpyWriter
+#include <FINNCppDriver/utils/PackedDataset.hpp>    // for PackedDatasetReader, ...
+#include <FINNCppDriver/utils/RingBuffer.hpp>       // for RingBuffer
+#include <FINNCppDriver/utils/TrafficLog.hpp>       // for TrafficLog
 #include <FINNCppDriver/utils/DataPacking.hpp>    // for AutoReturnType
 #include <FINNCppDriver/utils/DynamicMdSpan.hpp>  // for DynamicMdSpan
+#include <FINNCppDriver/utils/Instrumentation.hpp>     // for STAGE
+#include <FINNCppDriver/utils/SampleStatistics.hpp>    // for SampleStatistics
+#include <FINNCppDriver/utils/TimelineTracer.hpp>      // for TimelineTracer
 #include <boost/program_options.hpp>              // for variables_map
 #include <ext/alloc_traits.h>                     // for __alloc_tr...
 #include <xtensor/xadapt.hpp>                     // for adapt
@@ -99,6 +122,9 @@ std::string finnMainLogPrefix() { return "[FINNDriver] "; }
 void logDeviceInformation(logger_type& logger, xrt::device& device, const std::string& filename) {
     auto bdfInfo = device.get_info<xrt::info::device::bdf>();
     FINN_LOG(logger, loglevel::info) << "BDF: " << bdfInfo;
+    if (auto node = Finn::pciNumaNode(bdfInfo)) {
+        FINN_LOG(logger, loglevel::info) << "NUMA node: " << *node;
+    }
     auto xclbin = xrt::xclbin(filename);
     auto kernels = xclbin.get_kernels();
 
@@ -111,6 +137,10 @@ void logDeviceInformation(logger_type& logger, xrt::device& device, const std::s
         for (auto&& compUnit : knl.get_cus()) {
             FINN_LOG(logger, loglevel::info) << " \t\t\tCU: " << compUnit.get_name() << " Size: " << compUnit.get_size() << "\n";
         }
+        if (knl.get_cus().size() > 1) {
+            FINN_LOG(logger, loglevel::info) << "Kernel " << knl.get_name() << " is replicated " << knl.get_cus().size()
+                                             << " times. List every replica as an idma/odma pair and set replicatedComputeUnits in the config to run batches on all of them.\n";
+        }
     }
 }
 
@@ -133,80 +163,227 @@ Finn::Driver<SynchronousInference> createDriverFromConfig(const std::filesystem:
 template<typename O>
 using destribution_t = typename std::conditional_t<std::is_same_v<O, float>, std::uniform_real_distribution<O>, std::uniform_int_distribution<O>>;
 
+/**
+ * @brief Settings of the throughput mode
+ *
+ */
+struct ThroughputOptions {
+    /**
+     * @brief Number of measured inferences per run, summed over all threads. Ignored if duration is set.
+     *
+     */
+    std::size_t iterations = 5000;
+    /**
+     * @brief Number of unmeasured inferences per thread before every run
+     *
+     */
+    std::size_t warmup = 10;
+    /**
+     * @brief Length of every run in seconds. 0 runs a fixed number of iterations instead.
+     *
+     */
+    double duration = 0;
+    /**
+     * @brief Batch sizes to run, one run each
+     *
+     */
+    std::vector<uint> batchSizes;
+    /**
+     * @brief Number of host threads that issue inferences concurrently
+     *
+     */
+    unsigned int threads = 1;
+    /**
+     * @brief File the JSON report is written to, "-" for stdout. Empty if no JSON report should be written.
+     *
+     */
+    std::string jsonPath;
+};
+
+/**
+ * @brief Number of distinct random input batches every thread cycles through, so that inputs differ between iterations without generating them during the measurement
+ *
+ */
+constexpr std::size_t throughputInputVariants = 8;
+
+/**
+ * @brief Generate throughputInputVariants random input batches in the value range of the input datatype
+ *
+ * @tparam T Input datatype
+ * @param elements Number of input elements per batch
+ * @return std::vector<Finn::vector<T>>
+ */
 template<typename T>
-void runThroughputTestImpl(Finn::Driver<true>& baseDriver, std::size_t elementCount, uint batchSize) {
-    using dtype = T;
-    Finn::vector<dtype> testInputs(elementCount * batchSize);
+std::vector<Finn::vector<T>> generateInputVariants(std::size_t elements) {
+    std::mt19937 mersenneEngine{std::random_device{}()};
+    destribution_t<T> dist{static_cast<T>(InputFinnType().min()), static_cast<T>(InputFinnType().max())};
+    std::vector<Finn::vector<T>> inputs(throughputInputVariants, Finn::vector<T>(elements));
+    for (auto&& input : inputs) {
+        std::generate(input.begin(), input.end(), [&dist, &mersenneEngine]() { return dist(mersenneEngine); });
+    }
+    return inputs;
+}
 
-    std::random_device rndDevice;
-    std::mt19937 mersenneEngine{rndDevice()};  // Generates random integers
+/**
+ * @brief Collect the device metrics counted by the driver since their last reset
+ *
+ * @param baseDriver
+ * @return json Utilisation per device and counters per buffer
+ */
+json deviceMetricsToJson(const Finn::Driver<true>& baseDriver) {
+    json devices = json::array();
+    for (auto&& device : baseDriver.getDeviceMetrics()) {
+        json buffers = json::array();
+        for (auto&& buffer : device.buffers) {
+            buffers.push_back({{"kernelName", buffer.kernelName},
+                               {"input", buffer.ioMode == IO::INPUT},
+                               {"invocations", buffer.invocations},
+                               {"completions", buffer.completions},
+                               {"bytes", buffer.bytes},
+                               {"bandwidth_MB_per_s", buffer.bandwidth() / 1e6},
+                               {"busy_s", std::chrono::duration<double>(buffer.busyTime).count()},
+                               {"deviceCycles", buffer.deviceCycles},
+                               {"timeouts", buffer.timeouts}});
+        }
+        devices.push_back({{"xrtDeviceIndex", device.deviceIndex}, {"window_s", std::chrono::duration<double>(device.window).count()}, {"utilisation", device.utilisation()}, {"buffers", buffers}});
+    }
+    return devices;
+}
 
-    destribution_t<dtype> dist{static_cast<dtype>(InputFinnType().min()), static_cast<dtype>(InputFinnType().max())};
+/**
+ * @brief Collect the stage latencies recorded by the driver since their last reset
+ *
+ * @param baseDriver
+ * @return json Summary per stage with samples, in microseconds
+ */
+json stageLatenciesToJson(const Finn::Driver<true>& baseDriver) {
+    json stages = json::object();
+    for (std::size_t i = 0; i < Finn::stageCount; ++i) {
+        const auto stage = static_cast<Finn::STAGE>(i);
+        const auto summary = baseDriver.getStageLatency(stage);
+        if (summary.count > 0) {
+            constexpr double nsPerUs = 1000.0;
+            stages[Finn::stageName(stage)] = {{"count", summary.count},
+                                              {"mean", summary.mean / nsPerUs},
+                                              {"p50", static_cast<double>(summary.p50) / nsPerUs},
+                                              {"p99", static_cast<double>(summary.p99) / nsPerUs},
+                                              {"p999", static_cast<double>(summary.p999) / nsPerUs},
+                                              {"max", static_cast<double>(summary.max) / nsPerUs}};
+        }
+    }
+    return stages;
+}
 
-    auto gen = [&dist, &mersenneEngine]() { return dist(mersenneEngine); };
+/**
+ * @brief Write a report to the given JSON path of the benchmark modes
+ *
+ * @param logger
+ * @param report
+ * @param jsonPath File name, "-" for stdout, empty for no report
+ */
+void writeJsonReport(logger_type& logger, const json& report, const std::string& jsonPath) {
+    if (jsonPath == "-") {
+        std::cout << report.dump(2) << "\n";
+    } else if (!jsonPath.empty()) {
+        std::ofstream file(jsonPath);
+        if (!file) {
+            FinnUtils::logAndError<std::runtime_error>("Could not open " + jsonPath + " for the JSON report!");
+        }
+        file << report.dump(2) << "\n";
+        FINN_LOG(logger, loglevel::info) << finnMainLogPrefix() << "Wrote JSON report to " << jsonPath;
+    }
+}
 
-    constexpr size_t nTestruns = 5000;
-    std::chrono::duration<double> sumRuntimeEnd2End{};
+/**
+ * @brief Run one measurement of the throughput mode with the current batch size of the driver
+ *
+ * @tparam T Input datatype
+ * @param baseDriver
+ * @param elementCount Number of input elements per sample
+ * @param options
+ * @return json Report of the run
+ */
+template<typename T>
+json runThroughputTestImpl(Finn::Driver<true>& baseDriver, std::size_t elementCount, const ThroughputOptions& options) {
+    using dtype = T;
+    using V = Finn::Driver<true>::AutoDeducedRetType;
+    const uint batchSize = baseDriver.getBatchSize();
+    const std::size_t outputElements = baseDriver.getOutputElementsPerSample() * batchSize;
 
-    // Warmup
-    std::fill(testInputs.begin(), testInputs.end(), 1);
-    auto warmup = baseDriver.inferSynchronous(testInputs.begin(), testInputs.end());
-    Finn::DoNotOptimize(warmup);
+    std::atomic<std::size_t> issued = 0;
+    std::latch warmedUp(static_cast<std::ptrdiff_t>(options.threads) + 1);
+    std::latch finished(static_cast<std::ptrdiff_t>(options.threads));
+    std::vector<std::vector<double>> latencies(options.threads);
+    std::chrono::steady_clock::time_point deadline;
+    std::atomic<bool> started = false;
 
-    for (size_t i = 0; i < nTestruns; ++i) {
-        std::generate(testInputs.begin(), testInputs.end(), gen);
-        const auto start = std::chrono::high_resolution_clock::now();
-        auto ret = baseDriver.inferSynchronous(testInputs.begin(), testInputs.end());
-        Finn::DoNotOptimize(ret);
-        const auto end = std::chrono::high_resolution_clock::now();
+    auto worker = [&](unsigned int threadIndex) {
+        const auto inputs = generateInputVariants<dtype>(elementCount * batchSize);
+        Finn::vector<V> output(outputElements);
+        auto infer = [&](std::size_t i) {
+            const auto& input = inputs[i % throughputInputVariants];
+            baseDriver.inferSynchronousScheduled(input.begin(), input.end(), std::span<V>(output.data(), output.size()));
+            Finn::DoNotOptimize(output);
+        };
 
-        sumRuntimeEnd2End += (end - start);
-    }
+        for (std::size_t i = 0; i < options.warmup; ++i) {
+            infer(i);
+        }
+        warmedUp.arrive_and_wait();
+        started.wait(false);
 
-    std::chrono::duration<double> sumRuntimePacking{};
-    std::chrono::duration<double> sumRuntimeUnpacking{};
-    std::chrono::duration<double> sumRuntimeReshaping{};
+        auto& samples = latencies[threadIndex];
+        samples.reserve((options.duration > 0) ? 1024 : options.iterations / options.threads + 1);
+        for (std::size_t i = 0;; ++i) {
+            if (options.duration > 0 ? std::chrono::steady_clock::now() >= deadline : issued.fetch_add(1, std::memory_order_relaxed) >= options.iterations) {
+                break;
+            }
+            const auto start = std::chrono::steady_clock::now();
+            infer(i);
+            const auto end = std::chrono::steady_clock::now();
+            samples.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+        finished.count_down();
+    };
 
-    for (size_t i = 0; i < nTestruns; ++i) {
-        std::generate(testInputs.begin(), testInputs.end(), gen);
-        const auto start = std::chrono::high_resolution_clock::now();
-        static auto foldedShape = static_cast<Finn::ExtendedBufferDescriptor*>(baseDriver.getConfig().deviceWrappers[0].idmas[0].get())->foldedShape;
-        foldedShape[0] = batchSize;
-        const Finn::DynamicMdSpan reshapedInput(testInputs.begin(), testInputs.end(), foldedShape);
-        const auto reshape = std::chrono::high_resolution_clock::now();
-        auto packed = Finn::packMultiDimensionalInputs<InputFinnType>(testInputs.begin(), testInputs.end(), reshapedInput, foldedShape.back());
-        Finn::DoNotOptimize(packed);
-        const auto end = std::chrono::high_resolution_clock::now();
+    std::vector<std::jthread> threads;
+    threads.reserve(options.threads);
+    for (unsigned int t = 0; t < options.threads; ++t) {
+        threads.emplace_back(worker, t);
+    }
+    warmedUp.arrive_and_wait();
+    // Only the measured inferences contribute to the stage latencies and device metrics
+    baseDriver.resetLatencyStatistics();
+    baseDriver.resetDeviceMetrics();
+    const auto start = std::chrono::steady_clock::now();
+    deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(options.duration));
+    started = true;
+    started.notify_all();
+    finished.wait();
+    const auto end = std::chrono::steady_clock::now();
+    threads.clear();
 
-        sumRuntimeReshaping += (reshape - start);
-        sumRuntimePacking += (end - reshape);
+    std::vector<double> merged;
+    for (auto&& samples : latencies) {
+        merged.insert(merged.end(), samples.begin(), samples.end());
     }
+    const auto stats = Finn::SampleStatistics::compute(merged);
+    const double wallTime = std::chrono::duration<double>(end - start).count();
+    const double throughput = (wallTime > 0) ? static_cast<double>(stats.count * batchSize) / wallTime : 0;
 
-    auto packedOutput = baseDriver.getConfig().deviceWrappers[0].odmas[0]->packedShape;
-    packedOutput[0] = batchSize;
-    std::vector<uint8_t> unpackingInputs(FinnUtils::shapeToElements(packedOutput));
-    for (size_t i = 0; i < nTestruns; ++i) {
-        const auto start = std::chrono::high_resolution_clock::now();
-        auto foldedOutput = static_cast<Finn::ExtendedBufferDescriptor*>(baseDriver.getConfig().deviceWrappers[0].odmas[0].get())->foldedShape;
-        foldedOutput[0] = batchSize;
-        const Finn::DynamicMdSpan reshapedOutput(unpackingInputs.begin(), unpackingInputs.end(), packedOutput);
-        auto unpacked = Finn::unpackMultiDimensionalOutputs<OutputFinnType>(unpackingInputs.begin(), unpackingInputs.end(), reshapedOutput, foldedOutput);
-        Finn::DoNotOptimize(unpacked);
-        const auto end = std::chrono::high_resolution_clock::now();
-        sumRuntimeUnpacking += (end - start);
+    const json stages = stageLatenciesToJson(baseDriver);
+    const json devices = deviceMetricsToJson(baseDriver);
+
+    std::cout << "Batch size " << batchSize << ", " << options.threads << " thread(s), " << stats.count << " inferences in " << wallTime << "s\n";
+    std::cout << "  Throughput: " << throughput << " inferences/s\n";
+    std::cout << "  End2end latency [us]: mean " << stats.mean << ", stddev " << stats.stddev << ", min " << stats.min << ", p50 " << stats.p50 << ", p90 " << stats.p90 << ", p99 " << stats.p99 << ", p99.9 "
+              << stats.p999 << ", max " << stats.max << "\n";
+    if (!stages.empty()) {
+        std::cout << "  Stage latencies (measured independently, they overlap between threads):\n" << baseDriver.getLatencyReport();
     }
+    std::cout << Finn::formatDeviceMetrics(baseDriver.getDeviceMetrics());
 
-    std::cout << "Avg. end2end latency: " << (static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(sumRuntimeEnd2End).count()) / nTestruns / 1000) << "us\n";
-    std::cout << "Avg. end2end throughput: " << 1 / (static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(sumRuntimeEnd2End).count()) / nTestruns / batchSize / 1000 / 1000 / 1000) << " inferences/s\n";
-    std::cout << "Avg. packing latency: " << (static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(sumRuntimePacking).count()) / nTestruns) << "ns\n";
-    std::cout << "Avg. folding latency: " << (static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(sumRuntimeReshaping).count()) / nTestruns) << "ns\n";
-    std::cout << "Avg. unpacking latency: " << (static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(sumRuntimeUnpacking).count()) / nTestruns) << "ns\n";
-    std::cout << "Avg. raw inference latency:"
-              << (static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(sumRuntimeEnd2End).count()) / nTestruns) -
-                     (static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(sumRuntimePacking).count()) / nTestruns) -
-                     (static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(sumRuntimeReshaping).count()) / nTestruns) -
-                     (static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(sumRuntimeUnpacking).count()) / nTestruns)
-              << "ns\n";
+    return {{"batchSize", batchSize}, {"threads", options.threads}, {"wallTime_s", wallTime}, {"throughput_inferences_per_s", throughput}, {"latency_us", stats}, {"stages_us", stages}, {"devices", devices}};
 }
 
 /**
@@ -214,33 +391,378 @@ void runThroughputTestImpl(Finn::Driver<true>& baseDriver, std::size_t elementCo
  *
  * @param baseDriver
  * @param logger
+ * @param options
  */
-void runThroughputTest(Finn::Driver<true>& baseDriver, logger_type& logger) {
+void runThroughputTest(Finn::Driver<true>& baseDriver, logger_type& logger, const ThroughputOptions& options) {
     FINN_LOG(logger, loglevel::info) << finnMainLogPrefix() << "Device Information: ";
     logDeviceInformation(logger, baseDriver.getDeviceHandler(0).getDevice(), baseDriver.getConfig().deviceWrappers[0].xclbin);
 
-    size_t elementcount = FinnUtils::shapeToElements((std::static_pointer_cast<Finn::ExtendedBufferDescriptor>(baseDriver.getConfig().deviceWrappers[0].idmas[0]))->normalShape);
-    uint batchSize = baseDriver.getBatchSize();
+    const size_t elementcount = baseDriver.getInputElementsPerSample();
     FINN_LOG(logger, loglevel::info) << finnMainLogPrefix() << "Input element count " << std::to_string(elementcount);
-    FINN_LOG(logger, loglevel::info) << finnMainLogPrefix() << "Batch size: " << batchSize;
+    if (options.threads > 1) {
+        // One buffer set per thread, so the host work of one thread overlaps with the execution of another
+        baseDriver.setBufferSlots(options.threads);
+    }
+
+    json report = {{"xclbin", baseDriver.getConfig().deviceWrappers[0].xclbin.string()}, {"iterations", options.iterations}, {"warmup", options.warmup}, {"duration_s", options.duration}, {"runs", json::array()}};
+    for (uint batchSize : options.batchSizes) {
+        FINN_LOG(logger, loglevel::info) << finnMainLogPrefix() << "Batch size: " << batchSize;
+        baseDriver.setBatchSize(batchSize);
+        constexpr bool isInteger = InputFinnType().isInteger();
+        if constexpr (isInteger) {
+            using dtype = Finn::UnpackingAutoRetType::IntegralType<InputFinnType>;
+            report["runs"].push_back(runThroughputTestImpl<dtype>(baseDriver, elementcount, options));
+        } else {
+            report["runs"].push_back(runThroughputTestImpl<float>(baseDriver, elementcount, options));
+        }
+    }
+
+    writeJsonReport(logger, report, options.jsonPath);
+}
+
+/**
+ * @brief Settings of the open loop load mode
+ *
+ */
+struct LoadOptions {
+    /**
+     * @brief Target rate in requests (batches) per second for generated arrivals
+     *
+     */
+    double qps = 0;
+    /**
+     * @brief "poisson", "uniform" or "replay"
+     *
+     */
+    std::string arrivals = "poisson";
+    /**
+     * @brief Arrival trace for "replay", one timestamp in seconds per line
+     *
+     */
+    std::string tracePath;
+    /**
+     * @brief Factor the gaps of a replayed trace are divided by
+     *
+     */
+    double speedup = 1.0;
+    /**
+     * @brief Seed of the Poisson arrivals
+     *
+     */
+    std::uint64_t seed = 0;
+    /**
+     * @brief Number of generated requests. Ignored if duration is set or a trace is replayed.
+     *
+     */
+    std::size_t requests = 5000;
+    /**
+     * @brief Length of the generated schedule in seconds, 0 to generate a fixed number of requests instead
+     *
+     */
+    double duration = 0;
+    /**
+     * @brief Number of unmeasured closed loop inferences per producer before the run
+     *
+     */
+    std::size_t warmup = 10;
+    /**
+     * @brief Number of producer threads. Bounds the number of requests in flight, requests that find all producers busy queue up.
+     *
+     */
+    unsigned int producers = 1;
+    /**
+     * @brief File the JSON report is written to, "-" for stdout. Empty if no JSON report should be written.
+     *
+     */
+    std::string jsonPath;
+};
+
+/**
+ * @brief Build the schedule of intended send times from the load options
+ *
+ * @param options
+ * @return Finn::ArrivalSchedule
+ */
+Finn::ArrivalSchedule createArrivalSchedule(const LoadOptions& options) {
+    if (options.arrivals == "replay") {
+        return Finn::replayArrivals(options.tracePath, options.speedup);
+    }
+    const std::size_t count = (options.duration > 0) ? static_cast<std::size_t>(std::ceil(options.qps * options.duration)) : options.requests;
+    if (options.arrivals == "uniform") {
+        return Finn::uniformArrivals(options.qps, count);
+    }
+    return Finn::poissonArrivals(options.qps, count, options.seed);
+}
 
+/**
+ * @brief Replay the arrival schedule against the driver. Producer threads take the requests in order, wait for their intended send time and run them. Latencies are
+ * measured from the intended send time, so a request that has to wait for a free producer accounts for that wait, and a slow
+ * accelerator cannot hide its backlog by slowing down the load (coordinated omission).
+ *
+ * @tparam T Input datatype
+ * @param baseDriver
+ * @param elementCount Number of input elements per sample
+ * @param schedule
+ * @param options
+ * @return json Report of the run
+ */
+template<typename T>
+json runLoadTestImpl(Finn::Driver<true>& baseDriver, std::size_t elementCount, const Finn::ArrivalSchedule& schedule, const LoadOptions& options) {
+    using V = Finn::Driver<true>::AutoDeducedRetType;
+    const uint batchSize = baseDriver.getBatchSize();
+    const std::size_t outputElements = baseDriver.getOutputElementsPerSample() * batchSize;
+
+    std::atomic<std::size_t> next = 0;
+    std::latch warmedUp(static_cast<std::ptrdiff_t>(options.producers) + 1);
+    std::chrono::steady_clock::time_point start;
+    std::atomic<bool> started = false;
+    // Per request, so the producers never share a cache line while recording
+    std::vector<double> latency(schedule.size());
+    std::vector<double> service(schedule.size());
+    std::vector<double> sendLag(schedule.size());
+
+    auto producer = [&]() {
+        const auto inputs = generateInputVariants<T>(elementCount * batchSize);
+        Finn::vector<V> output(outputElements);
+        auto infer = [&](std::size_t i) {
+            const auto& input = inputs[i % throughputInputVariants];
+            baseDriver.inferSynchronousScheduled(input.begin(), input.end(), std::span<V>(output.data(), output.size()));
+            Finn::DoNotOptimize(output);
+        };
+        for (std::size_t i = 0; i < options.warmup; ++i) {
+            infer(i);
+        }
+        warmedUp.arrive_and_wait();
+        started.wait(false);
+
+        for (std::size_t i = next.fetch_add(1, std::memory_order_relaxed); i < schedule.size(); i = next.fetch_add(1, std::memory_order_relaxed)) {
+            const auto intended = start + schedule[i];
+            std::this_thread::sleep_until(intended);
+            const auto sent = std::chrono::steady_clock::now();
+            infer(i);
+            const auto done = std::chrono::steady_clock::now();
+            latency[i] = std::chrono::duration<double, std::micro>(done - intended).count();
+            service[i] = std::chrono::duration<double, std::micro>(done - sent).count();
+            sendLag[i] = std::chrono::duration<double, std::micro>(sent - intended).count();
+        }
+    };
+
+    std::vector<std::jthread> threads;
+    threads.reserve(options.producers);
+    for (unsigned int t = 0; t < options.producers; ++t) {
+        threads.emplace_back(producer);
+    }
+    warmedUp.arrive_and_wait();
+    baseDriver.resetLatencyStatistics();
+    start = std::chrono::steady_clock::now();
+    started = true;
+    started.notify_all();
+    threads.clear();
+    const auto end = std::chrono::steady_clock::now();
+
+    const auto latencyStats = Finn::SampleStatistics::compute(latency);
+    const auto serviceStats = Finn::SampleStatistics::compute(service);
+    const auto lagStats = Finn::SampleStatistics::compute(sendLag);
+    const double wallTime = std::chrono::duration<double>(end - start).count();
+    const double offered = schedule.empty() ? 0 : static_cast<double>(schedule.size()) / std::max(std::chrono::duration<double>(schedule.back()).count(), 1e-9);
+    const double achieved = (wallTime > 0) ? static_cast<double>(schedule.size()) / wallTime : 0;
+
+    std::cout << "Open loop, batch size " << batchSize << ", " << options.producers << " producer(s), " << schedule.size() << " requests in " << wallTime << "s\n";
+    std::cout << "  Offered load: " << offered << " requests/s, achieved: " << achieved << " requests/s (" << achieved * batchSize << " inferences/s)\n";
+    std::cout << "  Latency from intended send time [us]: mean " << latencyStats.mean << ", stddev " << latencyStats.stddev << ", p50 " << latencyStats.p50 << ", p90 " << latencyStats.p90 << ", p99 "
+              << latencyStats.p99 << ", p99.9 " << latencyStats.p999 << ", max " << latencyStats.max << "\n";
+    std::cout << "  Service time [us]: p50 " << serviceStats.p50 << ", p99 " << serviceStats.p99 << ", p99.9 " << serviceStats.p999 << "\n";
+    std::cout << "  Queueing delay [us]: p50 " << lagStats.p50 << ", p99 " << lagStats.p99 << ", p99.9 " << lagStats.p999 << "\n";
+
+    return {{"batchSize", batchSize},
+            {"producers", options.producers},
+            {"arrivals", options.arrivals},
+            {"requests", schedule.size()},
+            {"wallTime_s", wallTime},
+            {"offered_requests_per_s", offered},
+            {"achieved_requests_per_s", achieved},
+            {"latency_us", latencyStats},
+            {"service_us", serviceStats},
+            {"queueing_us", lagStats},
+            {"stages_us", stageLatenciesToJson(baseDriver)}};
+}
+
+/**
+ * @brief Run the open loop load test
+ *
+ * @param baseDriver
+ * @param logger
+ * @param options
+ */
+void runLoadTest(Finn::Driver<true>& baseDriver, logger_type& logger, const LoadOptions& options) {
+    FINN_LOG(logger, loglevel::info) << finnMainLogPrefix() << "Device Information: ";
+    logDeviceInformation(logger, baseDriver.getDeviceHandler(0).getDevice(), baseDriver.getConfig().deviceWrappers[0].xclbin);
+    if (options.producers > 1) {
+        baseDriver.setBufferSlots(options.producers);
+    }
+    const auto schedule = createArrivalSchedule(options);
+    FINN_LOG(logger, loglevel::info) << finnMainLogPrefix() << "Replaying " << schedule.size() << " " << options.arrivals << " arrivals";
+
+    json report;
     constexpr bool isInteger = InputFinnType().isInteger();
     if constexpr (isInteger) {
-        using dtype = Finn::UnpackingAutoRetType::IntegralType<InputFinnType>;
-        runThroughputTestImpl<dtype>(baseDriver, elementcount, batchSize);
-        // benchmark each step in call chain for int
+        report = runLoadTestImpl<Finn::UnpackingAutoRetType::IntegralType<InputFinnType>>(baseDriver, baseDriver.getInputElementsPerSample(), schedule, options);
     } else {
-        runThroughputTestImpl<float>(baseDriver, elementcount, batchSize);
+        report = runLoadTestImpl<float>(baseDriver, baseDriver.getInputElementsPerSample(), schedule, options);
     }
+    report["xclbin"] = baseDriver.getConfig().deviceWrappers[0].xclbin.string();
+    writeJsonReport(logger, report, options.jsonPath);
 }
 
+/**
+ * @brief Settings of the replay mode
+ *
+ */
+struct ReplayOptions {
+    /**
+     * @brief Traffic log written by --capture
+     *
+     */
+    std::string logPath;
+    /**
+     * @brief Factor the recorded gaps are divided by, 0 to send every request as soon as the previous one is done
+     *
+     */
+    double speedup = 1.0;
+    /**
+     * @brief File the JSON report is written to, "-" for stdout. Empty if no JSON report should be written.
+     *
+     */
+    std::string jsonPath;
+};
+
+/**
+ * @brief Play a traffic log back against the driver with the recorded batch sizes and gaps. Requests run one after another from a single thread, like the driver
+ * of a single client saw them. Latencies are measured from the intended send time, so requests that queue up behind a slow one account for their wait.
+ * Logs with inputs are run on the recorded packed data, logs without on random inputs of the recorded batch sizes, which includes packing in the measurement.
+ *
+ * @tparam T Input datatype
+ * @param baseDriver
+ * @param log
+ * @param options
+ * @return json Report of the run
+ */
 template<typename T>
-void loadInferDump(Finn::Driver<true>& baseDriver, xt::detail::npy_file& loadedNpyFile, const std::string& outputFile) {
-    auto xtensorArray = std::move(loadedNpyFile).cast<T, xt::layout_type::dynamic>();
-    Finn::vector<T> vec(xtensorArray.begin(), xtensorArray.end());
-    auto ret = baseDriver.inferSynchronous(vec.begin(), vec.end());
-    auto xarr = xt::adapt(ret, (std::static_pointer_cast<Finn::ExtendedBufferDescriptor>(baseDriver.getConfig().deviceWrappers[0].odmas[0]))->normalShape);
-    xt::dump_npy(outputFile, xarr);
+json runReplayImpl(Finn::Driver<true>& baseDriver, const Finn::TrafficLog& log, const ReplayOptions& options) {
+    using V = Finn::Driver<true>::AutoDeducedRetType;
+    const auto schedule = log.arrivals(options.speedup);
+    const std::size_t inputPerSample = baseDriver.getInputElementsPerSample();
+    const uint maxSamples = log.maxSamples();
+    if (maxSamples > baseDriver.getMaxBatchSize()) {
+        baseDriver.setMaxBatchSize(maxSamples);
+    }
+    const auto inputs = log.hasInputs ? std::vector<Finn::vector<T>>{} : generateInputVariants<T>(inputPerSample * maxSamples);
+    Finn::vector<V> output(baseDriver.getOutputElementsPerSample() * maxSamples);
+
+    std::vector<double> latency(schedule.size());
+    std::vector<double> service(schedule.size());
+    std::vector<double> sendLag(schedule.size());
+    std::map<std::uint32_t, std::size_t> batchMix;
+    std::size_t samples = 0;
+    baseDriver.resetLatencyStatistics();
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < schedule.size(); ++i) {
+        const auto& record = log.records[i];
+        if (record.samples != baseDriver.getBatchSize()) {
+            baseDriver.setBatchSize(record.samples);
+        }
+        if (log.hasInputs && record.input.size() != baseDriver.getPackedInputBytes(baseDriver.getDefaultInputDeviceIndex(), baseDriver.getDefaultInputKernelName())) {
+            FinnUtils::logAndError<std::runtime_error>("Request " + std::to_string(i) + " of the traffic log does not match the input of the accelerator. Replay logs of other bitstreams without inputs!");
+        }
+        const auto intended = start + schedule[i];
+        std::this_thread::sleep_until(intended);
+        const auto sent = std::chrono::steady_clock::now();
+        if (log.hasInputs) {
+            auto results = baseDriver.inferSynchronousPrepacked(std::span<const uint8_t>(record.input), baseDriver.getDefaultInputDeviceIndex(), baseDriver.getDefaultInputKernelName(),
+                                                                baseDriver.getDefaultOutputDeviceIndex(), baseDriver.getDefaultOutputKernelName());
+            Finn::DoNotOptimize(results);
+        } else {
+            const auto& input = inputs[i % throughputInputVariants];
+            baseDriver.inferSynchronous(input.begin(), input.begin() + static_cast<std::ptrdiff_t>(inputPerSample * record.samples), std::span<V>(output.data(), output.size()),
+                                        baseDriver.getDefaultInputDeviceIndex(), baseDriver.getDefaultInputKernelName(), baseDriver.getDefaultOutputDeviceIndex(), baseDriver.getDefaultOutputKernelName());
+            Finn::DoNotOptimize(output);
+        }
+        const auto done = std::chrono::steady_clock::now();
+        latency[i] = std::chrono::duration<double, std::micro>(done - intended).count();
+        service[i] = std::chrono::duration<double, std::micro>(done - sent).count();
+        sendLag[i] = std::chrono::duration<double, std::micro>(sent - intended).count();
+        ++batchMix[record.samples];
+        samples += record.samples;
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    const auto latencyStats = Finn::SampleStatistics::compute(latency);
+    const auto serviceStats = Finn::SampleStatistics::compute(service);
+    const auto lagStats = Finn::SampleStatistics::compute(sendLag);
+    const double wallTime = std::chrono::duration<double>(end - start).count();
+    const double achieved = (wallTime > 0) ? static_cast<double>(schedule.size()) / wallTime : 0;
+
+    std::cout << "Replay of " << schedule.size() << " requests (" << samples << " samples) at speedup " << options.speedup << " in " << wallTime << "s, " << (log.hasInputs ? "recorded" : "random") << " inputs\n";
+    std::cout << "  Achieved: " << achieved << " requests/s (" << ((wallTime > 0) ? static_cast<double>(samples) / wallTime : 0) << " inferences/s)\n";
+    std::cout << "  Latency from intended send time [us]: mean " << latencyStats.mean << ", stddev " << latencyStats.stddev << ", p50 " << latencyStats.p50 << ", p90 " << latencyStats.p90 << ", p99 "
+              << latencyStats.p99 << ", p99.9 " << latencyStats.p999 << ", max " << latencyStats.max << "\n";
+    std::cout << "  Service time [us]: p50 " << serviceStats.p50 << ", p99 " << serviceStats.p99 << ", p99.9 " << serviceStats.p999 << "\n";
+    std::cout << "  Queueing delay [us]: p50 " << lagStats.p50 << ", p99 " << lagStats.p99 << ", p99.9 " << lagStats.p999 << "\n";
+    json cache = nullptr;
+    if (const auto cacheStats = baseDriver.getResultCacheStatistics(); cacheStats) {
+        std::cout << "  Result cache: hit rate " << cacheStats->hitRate() * 100.0 << "%, " << cacheStats->skippedBatches << " batches without the device, " << cacheStats->entries << " entries in "
+                  << cacheStats->bytes << " bytes\n";
+        cache = {{"hits", cacheStats->hits},
+                 {"misses", cacheStats->misses},
+                 {"hitRate", cacheStats->hitRate()},
+                 {"skippedBatches", cacheStats->skippedBatches},
+                 {"evictions", cacheStats->evictions},
+                 {"entries", cacheStats->entries},
+                 {"bytes", cacheStats->bytes}};
+    }
+
+    json mix = json::object();
+    for (auto&& [batchSize, count] : batchMix) {
+        mix[std::to_string(batchSize)] = count;
+    }
+    return {{"requests", schedule.size()},
+            {"samples", samples},
+            {"speedup", options.speedup},
+            {"recordedInputs", log.hasInputs},
+            {"batchSizes", mix},
+            {"wallTime_s", wallTime},
+            {"achieved_requests_per_s", achieved},
+            {"latency_us", latencyStats},
+            {"service_us", serviceStats},
+            {"queueing_us", lagStats},
+            {"resultCache", cache},
+            {"stages_us", stageLatenciesToJson(baseDriver)}};
+}
+
+/**
+ * @brief Run the replay mode
+ *
+ * @param baseDriver
+ * @param logger
+ * @param options
+ */
+void runReplay(Finn::Driver<true>& baseDriver, logger_type& logger, const ReplayOptions& options) {
+    const auto log = Finn::readTrafficLog(options.logPath);
+    if (log.records.empty()) {
+        FinnUtils::logAndError<std::runtime_error>("The traffic log " + options.logPath + " holds no requests!");
+    }
+    FINN_LOG(logger, loglevel::info) << finnMainLogPrefix() << "Replaying " << log.records.size() << " requests from " << options.logPath;
+
+    json report;
+    constexpr bool isInteger = InputFinnType().isInteger();
+    if constexpr (isInteger) {
+        report = runReplayImpl<Finn::UnpackingAutoRetType::IntegralType<InputFinnType>>(baseDriver, log, options);
+    } else {
+        report = runReplayImpl<float>(baseDriver, log, options);
+    }
+    report["xclbin"] = baseDriver.getConfig().deviceWrappers[0].xclbin.string();
+    report["log"] = options.logPath;
+    writeJsonReport(logger, report, options.jsonPath);
 }
 
 /**
@@ -249,80 +771,452 @@ void loadInferDump(Finn::Driver<true>& baseDriver, xt::detail::npy_file& loadedN
  */
 constexpr size_t typeStringByteSizePos = 2;
 /**
- * @brief Executes inference on the input file if input type is a floating point type
- * @attention This function does no checking of the datatype contained in the loadedNpyFile! Passing a npy file containing a non floating point type is UB.
+ * @brief Get the configuration of the default input of the driver
  *
- * @param loadedNpyFile Input file
- * @param baseDriver Reference to driver used for inference
+ * @param baseDriver
+ * @return const Finn::ExtendedBufferDescriptor&
+ */
+const Finn::ExtendedBufferDescriptor& defaultInputDescriptor(const Finn::Driver<true>& baseDriver) {
+    return *std::static_pointer_cast<Finn::ExtendedBufferDescriptor>(baseDriver.getConfig().deviceWrappers[0].idmas[0]);
+}
+
+/**
+ * @brief Get the configuration of the default output of the driver
+ *
+ * @param baseDriver
+ * @return const Finn::ExtendedBufferDescriptor&
+ */
+const Finn::ExtendedBufferDescriptor& defaultOutputDescriptor(const Finn::Driver<true>& baseDriver) {
+    return *std::static_pointer_cast<Finn::ExtendedBufferDescriptor>(baseDriver.getConfig().deviceWrappers[0].odmas[0]);
+}
+
+/**
+ * @brief Shape of the output npy file for the given number of samples
+ *
+ * @param baseDriver
+ * @param samples
+ * @return shape_t
+ */
+shape_t outputNpyShape(const Finn::Driver<true>& baseDriver, std::size_t samples) {
+    shape_t shape = defaultOutputDescriptor(baseDriver).normalShape;
+    shape.front() = samples;
+    return shape;
+}
+
+/**
+ * @brief Fill the rest of a partially filled batch with copies of its first sample, so that whole batches can be run. The results of the copies are dropped.
+ *
+ * @tparam T
+ * @param batch
+ * @param validElements Number of valid values at the start of the batch
+ * @param elementsPerSample
+ */
+template<typename T>
+void padBatch(std::span<T> batch, std::size_t validElements, std::size_t elementsPerSample) {
+    for (std::size_t i = validElements; i < batch.size(); ++i) {
+        batch[i] = batch[i % elementsPerSample];
+    }
+}
+
+/**
+ * @brief Infer a npy file chunk by chunk. A reader thread fills the next input chunk and a writer thread appends the previous output chunk to the output file while the
+ * current chunk is inferred, so only two input and two output chunks are held in memory at any time.
+ *
+ * @tparam T Type of the values in the input file
+ * @param baseDriver
+ * @param reader Input file, positioned at the start of its data
  * @param outputFile Name of output file
+ * @param chunkBatches Number of batches per chunk
  */
-void inferFloatingPoint(Finn::Driver<true>& baseDriver, xt::detail::npy_file& loadedNpyFile, const std::string& outputFile) {
-    size_t sizePos = typeStringByteSizePos;
-    int size = std::stoi(loadedNpyFile.m_typestring, &sizePos);
-    if (size == 4) {
-        // float
-        loadInferDump<float>(baseDriver, loadedNpyFile, outputFile);
-    } else if (size == 8) {
-        // double
-        loadInferDump<double>(baseDriver, loadedNpyFile, outputFile);
-    } else {
-        FinnUtils::logAndError<std::runtime_error>("Unsupported floating point type detected when loading input npy file!");
+template<typename T>
+void streamInferDump(Finn::Driver<true>& baseDriver, Finn::NpyReader& reader, const std::string& outputFile, std::size_t chunkBatches) {
+    using V = Finn::Driver<true>::AutoDeducedRetType;
+    const std::size_t inputPerSample = baseDriver.getInputElementsPerSample();
+    const std::size_t outputPerSample = baseDriver.getOutputElementsPerSample();
+    if (reader.elements() % inputPerSample != 0) {
+        FinnUtils::logAndError<std::runtime_error>("The input file holds " + std::to_string(reader.elements()) + " values, which is not a multiple of the " + std::to_string(inputPerSample) + " input values per sample!");
+    }
+    const std::size_t samples = reader.elements() / inputPerSample;
+    const std::size_t chunkSamples = chunkBatches * baseDriver.getBatchSize();
+    const std::size_t chunks = (samples + chunkSamples - 1) / chunkSamples;
+
+    Finn::NpyWriter writer(outputFile, Finn::npyTypestring<V>(), outputNpyShape(baseDriver, samples));
+
+    constexpr std::size_t chunksInFlight = 2;
+    Finn::RingBuffer<T, true> inputChunks(chunksInFlight, chunkSamples * inputPerSample);
+    Finn::RingBuffer<V, true> outputChunks(chunksInFlight, chunkSamples * outputPerSample);
+    std::stop_source abort;
+    std::exception_ptr readError;
+    std::exception_ptr writeError;
+
+    std::jthread readerThread([&]() {
+        try {
+            for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+                auto part = inputChunks.claimWrite(abort.get_token());
+                if (part.empty()) {
+                    return;
+                }
+                // The last chunk is padded to whole batches
+                padBatch(part, reader.read(part), inputPerSample);
+                inputChunks.commitWrite();
+            }
+        } catch (...) {
+            readError = std::current_exception();
+            abort.request_stop();
+        }
+    });
+    std::jthread writerThread([&]() {
+        try {
+            for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+                auto part = outputChunks.claimRead(abort.get_token());
+                if (part.empty()) {
+                    return;
+                }
+                writer.append(part.first(std::min(chunkSamples, samples - chunk * chunkSamples) * outputPerSample));
+                outputChunks.commitRead();
+            }
+            writer.close();
+        } catch (...) {
+            writeError = std::current_exception();
+            abort.request_stop();
+        }
+    });
+
+    try {
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+            auto input = inputChunks.claimRead(abort.get_token());
+            auto output = outputChunks.claimWrite(abort.get_token());
+            if (input.empty() || output.empty()) {
+                break;
+            }
+            baseDriver.inferSynchronousPipelined(input.begin(), input.end(), output, baseDriver.getDefaultInputDeviceIndex(), baseDriver.getDefaultInputKernelName(), baseDriver.getDefaultOutputDeviceIndex(),
+                                                 baseDriver.getDefaultOutputKernelName());
+            inputChunks.commitRead();
+            outputChunks.commitWrite();
+        }
+    } catch (...) {
+        abort.request_stop();
+        throw;
+    }
+    readerThread.join();
+    writerThread.join();
+    if (readError) {
+        std::rethrow_exception(readError);
+    }
+    if (writeError) {
+        std::rethrow_exception(writeError);
     }
 }
 
 /**
- * @brief Executes inference on the input file if input type is a signed integer type
- * @attention This function does no checking of the datatype contained in the loadedNpyFile! Passing a npy file containing a non signed integer type is UB.
+ * @brief Call func with a std::type_identity of the C++ type that matches a numpy type string
+ *
+ * @tparam Func
+ * @param typestring Numpy type string, e.g. "<f4"
+ * @param size Size of one value in bytes
+ * @param func
+ */
+template<typename Func>
+void dispatchNpyType(const std::string& typestring, std::size_t size, Func&& func) {
+    switch (typestring[1]) {
+        case 'f':
+            if (size == 4) {
+                return func(std::type_identity<float>{});
+            } else if (size == 8) {
+                return func(std::type_identity<double>{});
+            }
+            break;
+        case 'i':
+            if (size == 1) {
+                return func(std::type_identity<int8_t>{});
+            } else if (size == 2) {
+                return func(std::type_identity<int16_t>{});
+            } else if (size == 4) {
+                return func(std::type_identity<int32_t>{});
+            } else if (size == 8) {
+                return func(std::type_identity<int64_t>{});
+            }
+            break;
+        case 'b':
+        case 'u':
+            if (size == 1) {
+                return func(std::type_identity<uint8_t>{});
+            } else if (size == 2) {
+                return func(std::type_identity<uint16_t>{});
+            } else if (size == 4) {
+                return func(std::type_identity<uint32_t>{});
+            } else if (size == 8) {
+                return func(std::type_identity<uint64_t>{});
+            }
+            break;
+        default:
+            break;
+    }
+    FinnUtils::logAndError<std::runtime_error>("Loading a numpy array with type string " + typestring + " is currently not supported.");
+}
+
+/**
+ * @brief Stream an input file through the driver in chunks, @see streamInferDump
  *
  * @param baseDriver
- * @param loadedNpyFile
+ * @param inputFile
  * @param outputFile
+ * @param chunkBatches Number of batches per chunk
  */
-void inferSignedInteger(Finn::Driver<true>& baseDriver, xt::detail::npy_file& loadedNpyFile, const std::string& outputFile) {
-    size_t sizePos = typeStringByteSizePos;
-    int size = std::stoi(loadedNpyFile.m_typestring, &sizePos);
-    if (size == 1) {
-        // int8_t
-        loadInferDump<int8_t>(baseDriver, loadedNpyFile, outputFile);
-    } else if (size == 2) {
-        // int16_t
-        loadInferDump<int16_t>(baseDriver, loadedNpyFile, outputFile);
-    } else if (size == 4) {
-        // int32_t
-        loadInferDump<int32_t>(baseDriver, loadedNpyFile, outputFile);
-    } else if (size == 8) {
-        // int64_t
-        loadInferDump<int64_t>(baseDriver, loadedNpyFile, outputFile);
-    } else {
-        FinnUtils::logAndError<std::runtime_error>("Unsupported signed integer type detected when loading input npy file!");
+void streamInputFile(Finn::Driver<true>& baseDriver, const std::string& inputFile, const std::string& outputFile, std::size_t chunkBatches) {
+    Finn::NpyReader reader(inputFile);
+    dispatchNpyType(reader.getTypestring(), reader.getItemSize(), [&]<typename T>(std::type_identity<T>) { streamInferDump<T>(baseDriver, reader, outputFile, chunkBatches); });
+}
+
+/**
+ * @brief Pack a npy file into a packed dataset for the default input of the driver, so that later runs skip packing
+ *
+ * @param baseDriver
+ * @param inputFile npy file
+ * @param outputFile Packed dataset
+ */
+void packInputFile(Finn::Driver<true>& baseDriver, const std::string& inputFile, const std::string& outputFile) {
+    Finn::NpyReader reader(inputFile);
+    const std::size_t inputPerSample = baseDriver.getInputElementsPerSample();
+    if (reader.elements() % inputPerSample != 0) {
+        FinnUtils::logAndError<std::runtime_error>("The input file holds " + std::to_string(reader.elements()) + " values, which is not a multiple of the " + std::to_string(inputPerSample) + " input values per sample!");
     }
+    const auto& descriptor = defaultInputDescriptor(baseDriver);
+    const Finn::PackedDatasetHeader header{"input", Finn::describeDatatype<InputFinnType>(), descriptor.foldedShape, descriptor.packedShape, reader.elements() / inputPerSample};
+    Finn::PackedDatasetWriter writer(outputFile, header);
+
+    dispatchNpyType(reader.getTypestring(), reader.getItemSize(), [&]<typename T>(std::type_identity<T>) {
+        Finn::vector<T> batch(inputPerSample * baseDriver.getBatchSize());
+        Finn::vector<uint8_t> packed(baseDriver.getPackedInputBytes(baseDriver.getDefaultInputDeviceIndex(), baseDriver.getDefaultInputKernelName()));
+        for (std::size_t read = reader.read(std::span<T>(batch)); read > 0; read = reader.read(std::span<T>(batch))) {
+            padBatch(std::span<T>(batch), read, inputPerSample);
+            baseDriver.packBatch(batch.begin(), batch.end(), std::span<uint8_t>(packed), baseDriver.getDefaultInputDeviceIndex(), baseDriver.getDefaultInputKernelName());
+            writer.append(std::span<const uint8_t>(packed).first(read / inputPerSample * header.bytesPerSample()));
+        }
+    });
+    writer.close();
 }
 
 /**
- * @brief Executes inference on the input file if input type is a unsigned integer type
- * @attention This function does no checking of the datatype contained in the loadedNpyFile! Passing a npy file containing a non unsigned integer type is UB.
+ * @brief Run a packed dataset through the driver. Every batch is read from the file straight into the mapped input buffer, without packing.
  *
  * @param baseDriver
- * @param loadedNpyFile
- * @param outputFile
+ * @param inputFile Packed dataset for the default input
+ * @param outputFile npy file, or packed dataset for the default output if packedOutput is set
+ * @param packedOutput Store the results without unpacking them
  */
-void inferUnsignedInteger(Finn::Driver<true>& baseDriver, xt::detail::npy_file& loadedNpyFile, const std::string& outputFile) {
-    size_t sizePos = typeStringByteSizePos;
-    int size = std::stoi(loadedNpyFile.m_typestring, &sizePos);
-    if (size == 1) {
-        // uint8_t
-        loadInferDump<uint8_t>(baseDriver, loadedNpyFile, outputFile);
-    } else if (size == 2) {
-        // uint16_t
-        loadInferDump<uint16_t>(baseDriver, loadedNpyFile, outputFile);
-    } else if (size == 4) {
-        // uint32_t
-        loadInferDump<uint32_t>(baseDriver, loadedNpyFile, outputFile);
-    } else if (size == 8) {
-        // uint64_t
-        loadInferDump<uint64_t>(baseDriver, loadedNpyFile, outputFile);
+void runWithPackedFile(Finn::Driver<true>& baseDriver, const std::string& inputFile, const std::string& outputFile, bool packedOutput) {
+    using V = Finn::Driver<true>::AutoDeducedRetType;
+    Finn::PackedDatasetReader reader(inputFile);
+    const auto& inputHeader = reader.getHeader();
+    inputHeader.validate("input", Finn::describeDatatype<InputFinnType>(), defaultInputDescriptor(baseDriver));
+    const auto& outputDescriptor = defaultOutputDescriptor(baseDriver);
+    const Finn::PackedDatasetHeader outputHeader{"output", Finn::describeDatatype<OutputFinnType>(), outputDescriptor.foldedShape, outputDescriptor.packedShape, inputHeader.samples};
+    const std::size_t outputPerSample = baseDriver.getOutputElementsPerSample();
+
+    std::optional<Finn::PackedDatasetWriter> packedWriter;
+    std::optional<Finn::NpyWriter> npyWriter;
+    Finn::vector<V> unpacked;
+    if (packedOutput) {
+        packedWriter.emplace(outputFile, outputHeader);
     } else {
-        FinnUtils::logAndError<std::runtime_error>("Unsupported floating point type detected when loading input npy file!");
+        npyWriter.emplace(outputFile, Finn::npyTypestring<V>(), outputNpyShape(baseDriver, inputHeader.samples));
+        unpacked.resize(outputPerSample * baseDriver.getBatchSize());
+    }
+
+    auto map = baseDriver.getPackedInputMap(baseDriver.getDefaultInputDeviceIndex(), baseDriver.getDefaultInputKernelName());
+    for (std::size_t read = reader.read(map); read > 0; read = reader.read(map)) {
+        padBatch(map, read * inputHeader.bytesPerSample(), inputHeader.bytesPerSample());
+        auto results = baseDriver.runPrepacked(baseDriver.getDefaultOutputDeviceIndex(), baseDriver.getDefaultOutputKernelName());
+        if (packedOutput) {
+            packedWriter->append(results.first(read * outputHeader.bytesPerSample()));
+        } else {
+            baseDriver.unpackBatch(results, std::span<V>(unpacked), baseDriver.getDefaultOutputDeviceIndex(), baseDriver.getDefaultOutputKernelName());
+            npyWriter->append(std::span<const V>(unpacked).first(read * outputPerSample));
+        }
+    }
+    if (packedOutput) {
+        packedWriter->close();
+    } else {
+        npyWriter->close();
+    }
+}
+
+/**
+ * @brief Unpack a packed dataset of results of the default output into a npy file
+ *
+ * @param baseDriver
+ * @param inputFile Packed dataset for the default output
+ * @param outputFile npy file
+ */
+void unpackOutputFile(Finn::Driver<true>& baseDriver, const std::string& inputFile, const std::string& outputFile) {
+    using V = Finn::Driver<true>::AutoDeducedRetType;
+    Finn::PackedDatasetReader reader(inputFile);
+    const auto& header = reader.getHeader();
+    header.validate("output", Finn::describeDatatype<OutputFinnType>(), defaultOutputDescriptor(baseDriver));
+    const std::size_t outputPerSample = baseDriver.getOutputElementsPerSample();
+    Finn::NpyWriter writer(outputFile, Finn::npyTypestring<V>(), outputNpyShape(baseDriver, header.samples));
+
+    Finn::vector<uint8_t> packed(baseDriver.getPackedOutputBytes(baseDriver.getDefaultOutputDeviceIndex(), baseDriver.getDefaultOutputKernelName()));
+    Finn::vector<V> unpacked(outputPerSample * baseDriver.getBatchSize());
+    for (std::size_t read = reader.read(std::span<uint8_t>(packed)); read > 0; read = reader.read(std::span<uint8_t>(packed))) {
+        padBatch(std::span<uint8_t>(packed), read * header.bytesPerSample(), header.bytesPerSample());
+        baseDriver.unpackBatch(std::span<const uint8_t>(packed), std::span<V>(unpacked), baseDriver.getDefaultOutputDeviceIndex(), baseDriver.getDefaultOutputKernelName());
+        writer.append(std::span<const V>(unpacked).first(read * outputPerSample));
+    }
+    writer.close();
+}
+
+/**
+ * @brief Configuration of the pipeline the execute mode runs whole npy files through
+ *
+ */
+struct FilePipelineOptions {
+    /**
+     * @brief Number of threads loading and decoding input files in parallel
+     *
+     */
+    unsigned int loaders = 1;
+    /**
+     * @brief Number of files that may wait between two stages of the pipeline
+     *
+     */
+    std::size_t queueDepth = 2;
+};
+
+/**
+ * @brief An input file that is loaded and decoded, waiting for inference
+ *
+ */
+struct LoadedFile {
+    std::string outputFile;
+    /**
+     * @brief Runs the decoded values, which keep the type of the input file, through the driver
+     *
+     */
+    std::function<Finn::vector<Finn::Driver<true>::AutoDeducedRetType>(Finn::Driver<true>&)> infer;
+};
+
+/**
+ * @brief The results of a file, waiting to be written
+ *
+ */
+struct InferredFile {
+    std::string outputFile;
+    Finn::vector<Finn::Driver<true>::AutoDeducedRetType> results;
+};
+
+/**
+ * @brief Load a whole npy file and decode it to the C++ type matching its type string
+ *
+ * @param inputFile
+ * @param outputFile File the results are written to later
+ * @return LoadedFile
+ */
+LoadedFile loadInputFile(const std::string& inputFile, const std::string& outputFile) {
+    // using normal xnpy::load_npy will not work because it requires a destination type
+    // instead use xnpy::detail::load_npy_file und then convert by hand based on m_typestring of xnpy::detail::npy_file
+    std::ifstream stream(inputFile, std::ifstream::binary);
+    if (!stream) {
+        FinnUtils::logAndError<std::runtime_error>("io error: failed to open a file.");
+    }
+    auto loadedFile = xt::detail::load_npy_file(stream);
+    if (loadedFile.m_typestring[0] == '>') {
+        FinnUtils::logAndError<std::runtime_error>("At the moment only files created on little endian systems are supported!\n");
+    }
+
+    LoadedFile loaded{outputFile, {}};
+    const std::size_t size = std::stoul(loadedFile.m_typestring.substr(typeStringByteSizePos));
+    dispatchNpyType(loadedFile.m_typestring, size, [&]<typename T>(std::type_identity<T>) {
+        Finn::vector<T> vec;
+        if (loadedFile.m_typestring[1] == 'b') {
+            auto xtensorArray = std::move(loadedFile).cast<bool, xt::layout_type::dynamic>();
+            vec.assign(xtensorArray.begin(), xtensorArray.end());
+        } else {
+            auto xtensorArray = std::move(loadedFile).cast<T, xt::layout_type::dynamic>();
+            vec.assign(xtensorArray.begin(), xtensorArray.end());
+        }
+        loaded.infer = [vec = std::move(vec)](Finn::Driver<true>& driver) { return driver.inferSynchronous(vec.begin(), vec.end()); };
+    });
+    return loaded;
+}
+
+/**
+ * @brief Run whole npy files through a pipeline of three stages connected by bounded queues: loader threads read and decode the input files, the calling thread
+ * runs them on the device and a writer thread dumps the results. The device thereby keeps working while files are loaded and written. The files are processed in
+ * the order in which the loaders finish them.
+ *
+ * @param baseDriver
+ * @param inputFiles
+ * @param outputFiles One per input file
+ * @param options
+ */
+void runFilePipeline(Finn::Driver<true>& baseDriver, const std::vector<std::string>& inputFiles, const std::vector<std::string>& outputFiles, const FilePipelineOptions& options) {
+    const std::size_t outputPerSample = baseDriver.getOutputElementsPerSample();
+    Finn::BoundedQueue<LoadedFile> loadedFiles(options.queueDepth);
+    Finn::BoundedQueue<InferredFile> inferredFiles(options.queueDepth);
+    std::stop_source abort;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    auto fail = [&]() {
+        {
+            std::lock_guard guard(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        abort.request_stop();
+    };
+
+    std::atomic<std::size_t> nextFile = 0;
+    std::latch loadersDone(options.loaders);
+    std::vector<std::jthread> loaderThreads;
+    loaderThreads.reserve(options.loaders);
+    for (unsigned int i = 0; i < options.loaders; ++i) {
+        loaderThreads.emplace_back([&]() {
+            try {
+                for (std::size_t file = nextFile++; file < inputFiles.size() && !abort.stop_requested(); file = nextFile++) {
+                    if (!loadedFiles.push(loadInputFile(inputFiles[file], outputFiles[file]), abort.get_token())) {
+                        break;
+                    }
+                }
+            } catch (...) {
+                fail();
+            }
+            // The last loader lets the device stage drain the queue and stop
+            loadersDone.count_down();
+            if (loadersDone.try_wait()) {
+                loadedFiles.close();
+            }
+        });
+    }
+    std::jthread writerThread([&]() {
+        try {
+            for (auto inferred = inferredFiles.pop(abort.get_token()); inferred; inferred = inferredFiles.pop(abort.get_token())) {
+                auto xarr = xt::adapt(inferred->results, outputNpyShape(baseDriver, inferred->results.size() / outputPerSample));
+                xt::dump_npy(inferred->outputFile, xarr);
+            }
+        } catch (...) {
+            fail();
+        }
+    });
+
+    try {
+        for (auto loaded = loadedFiles.pop(abort.get_token()); loaded; loaded = loadedFiles.pop(abort.get_token())) {
+            if (!inferredFiles.push(InferredFile{loaded->outputFile, loaded->infer(baseDriver)}, abort.get_token())) {
+                break;
+            }
+        }
+    } catch (...) {
+        fail();
+    }
+    inferredFiles.close();
+    for (auto& thread : loaderThreads) {
+        thread.join();
+    }
+    writerThread.join();
+    if (error) {
+        std::rethrow_exception(error);
     }
 }
 
@@ -333,56 +1227,166 @@ void inferUnsignedInteger(Finn::Driver<true>& baseDriver, xt::detail::npy_file&
  * @param logger Logger to be used
  * @param inputFiles Files used for inference input
  * @param outputFiles Filenames used for output files
+ * @param chunkBatches Stream the files in chunks of this many batches, 0 to load every file at once
+ * @param packedOutput Store the results of packed input files without unpacking them
+ * @param pipelineOptions Pipeline for the files that are neither streamed nor packed, @see runFilePipeline
  */
-void runWithInputFile(Finn::Driver<true>& baseDriver, logger_type& logger, const std::vector<std::string>& inputFiles, const std::vector<std::string>& outputFiles) {
+void runWithInputFile(Finn::Driver<true>& baseDriver, logger_type& logger, const std::vector<std::string>& inputFiles, const std::vector<std::string>& outputFiles, std::size_t chunkBatches = 0,
+                      bool packedOutput = false, const FilePipelineOptions& pipelineOptions = {}) {
     FINN_LOG(logger, loglevel::info) << finnMainLogPrefix() << "Running driver on input files";
     logDeviceInformation(logger, baseDriver.getDeviceHandler(0).getDevice(), baseDriver.getConfig().deviceWrappers[0].xclbin);
+    if (chunkBatches > 0) {
+        // A second buffer slot lets inferSynchronousPipelined overlap the batches of a chunk
+        baseDriver.setBufferSlots(2);
+    }
 
+    // Packed and streamed files are already pipelined internally, all others are loaded whole and pipelined with each other
+    std::vector<std::string> wholeInputFiles;
+    std::vector<std::string> wholeOutputFiles;
     for (auto&& [inp, out] = std::tuple{inputFiles.begin(), outputFiles.begin()}; inp != inputFiles.end(); ++inp, ++out) {
-        // load npy file and process it
-        // using normal xnpy::load_npy will not work because it requires a destination type
-        // instead use xnpy::detail::load_npy_file und then concert by hand based on m_typestring of xnpy::detail::npy_file
-        std::ifstream stream(*inp, std::ifstream::binary);
-        if (!stream) {
-            FinnUtils::logAndError<std::runtime_error>("io error: failed to open a file.");
-        }
-
-        auto loadedFile = xt::detail::load_npy_file(stream);
-
-        if (loadedFile.m_typestring[0] == '<') {
-            // little endian
-            switch (loadedFile.m_typestring[1]) {
-                case 'f': {
-                    inferFloatingPoint(baseDriver, loadedFile, *out);
-                    break;
-                }
-                case 'i': {
-                    inferSignedInteger(baseDriver, loadedFile, *out);
-                    break;
-                }
-                case 'b': {
-                    auto xtensorArray = std::move(loadedFile).cast<bool, xt::layout_type::dynamic>();
-                    Finn::vector<uint8_t> vec(xtensorArray.begin(), xtensorArray.end());
-                    auto ret = baseDriver.inferSynchronous(vec.begin(), vec.end());
-                    auto xarr = xt::adapt(ret, (std::static_pointer_cast<Finn::ExtendedBufferDescriptor>(baseDriver.getConfig().deviceWrappers[0].odmas[0]))->normalShape);
-                    xt::dump_npy(*out, xarr);
-                    break;
-                }
-                case 'u': {
-                    inferUnsignedInteger(baseDriver, loadedFile, *out);
-                    break;
-                }
-                default:
-                    std::string errorString = "Loading a numpy array with type identifier string ";
-                    errorString += loadedFile.m_typestring[1];
-                    errorString += " is currently not supported.";
-                    FinnUtils::logAndError<std::runtime_error>(errorString);
-            }
-        } else {
-            // all other endians
-            FinnUtils::logAndError<std::runtime_error>("At the moment only files created on little endian systems are supported!\n");
+        if (Finn::isPackedDataset(*inp)) {
+            runWithPackedFile(baseDriver, *inp, *out, packedOutput);
+            continue;
+        }
+        if (chunkBatches > 0) {
+            streamInputFile(baseDriver, *inp, *out, chunkBatches);
+            continue;
+        }
+        wholeInputFiles.push_back(*inp);
+        wholeOutputFiles.push_back(*out);
+    }
+    if (!wholeInputFiles.empty()) {
+        runFilePipeline(baseDriver, wholeInputFiles, wholeOutputFiles, pipelineOptions);
+    }
+}
+
+/**
+ * @brief Settings of the serve mode
+ *
+ */
+struct ServeOptions {
+    /**
+     * @brief Name of the shared memory ring clients open
+     *
+     */
+    std::string ringName = "/finn-driver";
+    /**
+     * @brief Number of requests all clients together can have in flight
+     *
+     */
+    std::size_t slots = 64;
+    /**
+     * @brief Longest time a request waits for requests of other clients
+     *
+     */
+    std::chrono::microseconds maxDelay{100};
+    /**
+     * @brief Time between two logs of the device metrics, 0 to not log them
+     *
+     */
+    std::chrono::milliseconds metricsInterval{0};
+};
+
+/**
+ * @brief Set by SIGINT and SIGTERM to stop the serve mode
+ *
+ */
+volatile std::sig_atomic_t stopServing = 0;
+
+/**
+ * @brief Serve packed requests of local client processes from a shared memory ring until the process is interrupted
+ *
+ * @param baseDriver
+ * @param logger
+ * @param options
+ */
+void runDaemon(Finn::Driver<true>& baseDriver, logger_type& logger, const ServeOptions& options) {
+    std::signal(SIGINT, [](int) { stopServing = 1; });
+    std::signal(SIGTERM, [](int) { stopServing = 1; });
+    {
+        Finn::SharedMemoryDaemon<Finn::Driver<true>> daemon(baseDriver, options.ringName, options.slots, options.maxDelay);
+        FINN_LOG(logger, loglevel::info) << finnMainLogPrefix() << "Serving " << options.ringName << ", stop with SIGINT or SIGTERM";
+        if (options.metricsInterval.count() > 0) {
+            baseDriver.startMetricsExport(options.metricsInterval);
+        }
+        while (stopServing == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
+        baseDriver.stopMetricsExport();
+        FINN_LOG(logger, loglevel::info) << finnMainLogPrefix() << "Served " << daemon.getRequestCount() << " requests in " << daemon.getBatchCount() << " batches";
     }
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+}
+
+/**
+ * @brief Settings of the autotune mode
+ *
+ */
+struct AutotuneModeOptions {
+    /**
+     * @brief Candidates and measurement settings
+     *
+     */
+    Finn::AutotuneOptions tuner;
+    /**
+     * @brief Config the tuning is stored in
+     *
+     */
+    std::string configPath;
+    /**
+     * @brief File the config with the tuning is written to, the config itself if empty
+     *
+     */
+    std::string outputPath;
+    /**
+     * @brief File the JSON report of all candidates is written to, "-" for stdout. Empty if no JSON report should be written.
+     *
+     */
+    std::string jsonPath;
+};
+
+/**
+ * @brief Sweep the candidates of the autotuner on the device and store the fastest setting within the latency bound in the config
+ *
+ * @param baseDriver
+ * @param logger
+ * @param options
+ */
+void runAutotune(Finn::Driver<true>& baseDriver, logger_type& logger, const AutotuneModeOptions& options) {
+    FINN_LOG(logger, loglevel::info) << finnMainLogPrefix() << "Device Information: ";
+    logDeviceInformation(logger, baseDriver.getDeviceHandler(0).getDevice(), baseDriver.getConfig().deviceWrappers[0].xclbin);
+
+    Finn::AutotuneResult result;
+    constexpr bool isInteger = InputFinnType().isInteger();
+    if constexpr (isInteger) {
+        using dtype = Finn::UnpackingAutoRetType::IntegralType<InputFinnType>;
+        const auto samples = generateInputVariants<dtype>(baseDriver.getInputElementsPerSample());
+        result = Finn::autotune<dtype>(baseDriver, std::span<const dtype>(samples.front()), options.tuner);
+    } else {
+        const auto samples = generateInputVariants<float>(baseDriver.getInputElementsPerSample());
+        result = Finn::autotune<float>(baseDriver, std::span<const float>(samples.front()), options.tuner);
+    }
+
+    json candidates = json::array();
+    std::cout << "batch  threads  slots  throughput[1/s]  p99 latency[us]\n";
+    for (auto&& candidate : result.candidates) {
+        std::cout << candidate.tuning.batchSize << "  " << candidate.tuning.hostThreads << "  " << candidate.tuning.bufferSlots << "  " << candidate.tuning.throughput << "  " << candidate.tuning.latencyP99
+                  << (candidate.feasible ? "" : "  (exceeds the latency bound)") << "\n";
+        json entry = candidate.tuning;
+        entry["feasible"] = candidate.feasible;
+        candidates.push_back(entry);
+    }
+    writeJsonReport(logger, {{"xclbin", baseDriver.getConfig().deviceWrappers[0].xclbin.string()}, {"latencyBound_us", options.tuner.latencyBound}, {"candidates", candidates}}, options.jsonPath);
+
+    if (!result.best) {
+        FinnUtils::logAndError<std::runtime_error>("No setting meets the latency bound of " + std::to_string(options.tuner.latencyBound) + "us, the config was not changed!");
+    }
+    const auto& best = *result.best;
+    FINN_LOG(logger, loglevel::info) << finnMainLogPrefix() << "Best setting: batch size " << best.batchSize << ", " << best.hostThreads << " host threads, " << best.bufferSlots << " buffer slots with "
+                                     << best.throughput << " inferences/s and a p99 latency of " << best.latencyP99 << "us";
+    Finn::writeTuningToConfig(options.configPath, best, options.outputPath);
+    FINN_LOG(logger, loglevel::info) << finnMainLogPrefix() << "Stored the tuning in " << (options.outputPath.empty() ? options.configPath : options.outputPath);
 }
 
 /**
@@ -391,7 +1395,7 @@ void runWithInputFile(Finn::Driver<true>& baseDriver, logger_type& logger, const
  * @param mode User input string for selected mode
  */
 void validateDriverMode(const std::string& mode) {
-    if (mode != "execute" && mode != "throughput") {
+    if (mode != "execute" && mode != "throughput" && mode != "load" && mode != "replay" && mode != "autotune" && mode != "pack" && mode != "unpack" && mode != "serve") {
         throw finnBoost::program_options::error_with_option_name("'" + mode + "' is not a valid driver mode!", "exec_mode");
     }
 
@@ -409,6 +1413,83 @@ void validateBatchSize(int batch) {
     }
 }
 
+/**
+ * @brief Validates the user input for the iteration count of the throughput mode
+ *
+ * @param iterations User input iteration count
+ */
+void validateIterations(std::size_t iterations) {
+    if (iterations == 0) {
+        throw finnBoost::program_options::error_with_option_name("The iteration count must be positive", "iterations");
+    }
+}
+
+/**
+ * @brief Validates the user input for the duration of the throughput mode
+ *
+ * @param duration User input duration in seconds
+ */
+void validateDuration(double duration) {
+    if (duration < 0) {
+        throw finnBoost::program_options::error_with_option_name("The duration must not be negative, but is '" + std::to_string(duration) + "'", "duration");
+    }
+}
+
+/**
+ * @brief Validates the user input for the thread count of the throughput mode
+ *
+ * @param threads User input thread count
+ */
+void validateThreads(unsigned int threads) {
+    if (threads == 0) {
+        throw finnBoost::program_options::error_with_option_name("At least one thread is required", "threads");
+    }
+}
+
+/**
+ * @brief Validates the user input for the loader count of the execute mode
+ *
+ * @param loaders User input loader count
+ */
+void validateLoaders(unsigned int loaders) {
+    if (loaders == 0) {
+        throw finnBoost::program_options::error_with_option_name("At least one loader is required", "loaders");
+    }
+}
+
+/**
+ * @brief Validates the user input for the queue depth of the execute mode
+ *
+ * @param depth User input queue depth
+ */
+void validateQueueDepth(std::size_t depth) {
+    if (depth == 0) {
+        throw finnBoost::program_options::error_with_option_name("The queue depth has to be at least 1", "queuedepth");
+    }
+}
+
+/**
+ * @brief Validates the user input for the arrival process of the load mode
+ *
+ * @param arrivals User input arrival process
+ */
+void validateArrivals(const std::string& arrivals) {
+    if (arrivals != "poisson" && arrivals != "uniform" && arrivals != "replay") {
+        throw finnBoost::program_options::error_with_option_name("'" + arrivals + "' is not a valid arrival process!", "arrivals");
+    }
+}
+
+/**
+ * @brief Validates the user input for the memory policy
+ *
+ * @param policy Policy string to be validated
+ */
+void validateMemoryPolicy(const std::string& policy) {
+    if (policy != "fail" && policy != "degrade") {
+        throw finnBoost::program_options::error_with_option_name("'" + policy + "' is not a valid memory policy!", "memorypolicy");
+    }
+}
+
 /**
  * @brief Validates the user input for the config path. Also checks if file exists
  *
@@ -441,6 +1522,129 @@ void validateInputPath(const std::vector<std::string>& path) {
 
 namespace po = finnBoost::program_options;
 
+/**
+ * @brief Apply the tuning the autotune mode stored in the config, unless --ignoretuning was given. An explicit --batchsize takes precedence over the tuned one.
+ *
+ * @param driver
+ * @param varMap
+ */
+void applyConfiguredTuning(Finn::Driver<true>& driver, const po::variables_map& varMap) {
+    if (const auto tuning = driver.getConfiguredTuning(); tuning && !varMap["ignoretuning"].as<bool>()) {
+        driver.applyTuning(*tuning, varMap["batchsize"].defaulted());
+    }
+}
+
+/**
+ * @brief Limit the host memory of the driver if --memorybudget was given, and log the footprint the buffers will have
+ *
+ * @param driver
+ * @param logger
+ * @param varMap
+ */
+void applyMemoryBudget(Finn::Driver<true>& driver, logger_type& logger, const po::variables_map& varMap) {
+    constexpr double bytesPerMB = 1e6;
+    if (const double budget = varMap["memorybudget"].as<double>(); budget > 0) {
+        driver.setMemoryBudget(static_cast<std::size_t>(budget * bytesPerMB), (varMap["memorypolicy"].as<std::string>() == "degrade") ? MEMORY_POLICY::DEGRADE : MEMORY_POLICY::FAIL);
+    }
+    const auto plan = driver.getMemoryPlan();
+    FINN_LOG(logger, loglevel::info) << finnMainLogPrefix() << "Host buffers need up to " << static_cast<double>(plan.bytes) / bytesPerMB << "MB with " << plan.bufferSlots << " buffer slot(s)";
+}
+
+/**
+ * @brief Bound every kernel run of the driver if --executetimeout was given, so a stuck kernel fails the inference instead of hanging the driver
+ *
+ * @param driver
+ * @param varMap
+ */
+void applyExecuteTimeout(Finn::Driver<true>& driver, const po::variables_map& varMap) {
+    if (const unsigned int timeout = varMap["executetimeout"].as<unsigned int>(); timeout > 0) {
+        driver.setExecuteTimeout(std::chrono::milliseconds(timeout));
+    }
+}
+
+/**
+ * @brief Serve repeated samples from a result cache if --resultcache or --cacheentries was given
+ *
+ * @param driver
+ * @param varMap
+ */
+void applyResultCache(Finn::Driver<true>& driver, const po::variables_map& varMap) {
+    constexpr double bytesPerMB = 1e6;
+    const double cacheMB = varMap["resultcache"].as<double>();
+    const std::size_t cacheEntries = varMap["cacheentries"].as<std::size_t>();
+    if (cacheMB > 0 || cacheEntries > 0) {
+        driver.enableResultCache(static_cast<std::size_t>(cacheMB * bytesPerMB), cacheEntries);
+    }
+}
+
+/**
+ * @brief Start recording the inference requests of the driver if --capture was given
+ *
+ * @param driver
+ * @param varMap
+ */
+void startCapture(Finn::Driver<true>& driver, const po::variables_map& varMap) {
+    if (varMap.count("capture") != 0) {
+        driver.startCapture(varMap["capture"].as<std::string>(), varMap["captureinputs"].as<bool>());
+    }
+}
+
+/**
+ * @brief Close the traffic log of a running capture
+ *
+ * @param driver
+ * @param logger
+ */
+void finishCapture(Finn::Driver<true>& driver, logger_type& logger) {
+    if (const std::size_t recorded = driver.stopCapture(); recorded > 0) {
+        FINN_LOG(logger, loglevel::info) << finnMainLogPrefix() << "Captured " << recorded << " requests";
+    }
+}
+
+/**
+ * @brief Records a timeline of host and device activity while it is alive if --timeline was given, and writes it as a Chrome trace when it is destroyed
+ *
+ */
+class TimelineExport {
+     private:
+    std::string path;
+    logger_type& logger;
+
+     public:
+    /**
+     * @brief Start recording if --timeline was given
+     *
+     * @param varMap
+     * @param pLogger
+     */
+    TimelineExport(const po::variables_map& varMap, logger_type& pLogger) : logger(pLogger) {
+        if (varMap.count("timeline") != 0) {
+            path = varMap["timeline"].as<std::string>();
+            Finn::TimelineTracer::global().enable(varMap["timelineevents"].as<std::size_t>());
+        }
+    }
+    TimelineExport(const TimelineExport&) = delete;
+    TimelineExport& operator=(const TimelineExport&) = delete;
+
+    /**
+     * @brief Stop recording and write the trace. Failing to write it only logs a warning, so it cannot hide the result of the run.
+     *
+     */
+    ~TimelineExport() {
+        if (path.empty()) {
+            return;
+        }
+        auto& tracer = Finn::TimelineTracer::global();
+        tracer.disable();
+        try {
+            tracer.writeChromeTrace(path);
+            FINN_LOG(logger, loglevel::info) << finnMainLogPrefix() << "Wrote " << tracer.eventCount() << " timeline events to " << path;
+        } catch (const std::exception& e) {
+            FINN_LOG(logger, loglevel::warning) << finnMainLogPrefix() << "Could not write the timeline: " << e.what();
+        }
+    }
+};
+
 /**
  * @brief Main entrypoint for the frontend of the C++ Finn driver
  *
@@ -457,11 +1661,42 @@ int main(int argc, char* argv[]) {
         po::options_description desc{"Options"};
         //clang-format off
         desc.add_options()("help,h", "Display help")("exec_mode,e", po::value<std::string>()->default_value("throughput")->notifier(&validateDriverMode),
-                                                     R"(Please select functional verification ("execute") or throughput test ("throughput")")("configpath,c", po::value<std::string>()->required()->notifier(&validateConfigPath),
+                                                     R"(Please select functional verification ("execute"), closed loop throughput test ("throughput") open loop load test ("load"), replaying a captured traffic log ("replay"), tuning batch size, host threads and pipeline depth for this device ("autotune"), packing input files for the device ("pack"), unpacking packed output files ("unpack") or serving other processes through shared memory ("serve"))")("configpath,c", po::value<std::string>()->required()->notifier(&validateConfigPath),
                                                                                                                                               "Required: Path to the config.json file emitted by the FINN compiler")(
             "input,i", po::value<std::vector<std::string>>()->multitoken()->composing()->notifier(&validateInputPath), "Path to one or more input files (npy format). Only required if mode is set to \"file\"")(
             "output,o", po::value<std::vector<std::string>>()->multitoken()->composing(), "Path to one or more output files (npy format). Only required if mode is set to \"file\"")(
-            "batchsize,b", po::value<int>()->default_value(1)->notifier(&validateBatchSize), "Number of samples for inference");
+            "batchsize,b", po::value<int>()->default_value(1)->notifier(&validateBatchSize), "Number of samples for inference")(
+            "chunkbatches", po::value<std::size_t>()->default_value(0), "Execute mode: Stream the input files in chunks of this many batches instead of loading them at once")(
+            "loaders", po::value<unsigned int>()->default_value(1)->notifier(&validateLoaders), "Execute mode: Number of threads loading input files while others are inferred")(
+            "queuedepth", po::value<std::size_t>()->default_value(2)->notifier(&validateQueueDepth), "Execute mode: Number of loaded or inferred files that may wait for the next stage")(
+            "packedoutput", po::bool_switch()->default_value(false), "Execute mode: Write the results of packed input files as packed output files, to be unpacked later")(
+            "iterations,n", po::value<std::size_t>()->default_value(5000)->notifier(&validateIterations), "Throughput mode: Measured inferences per run, summed over all threads")(
+            "warmup,w", po::value<std::size_t>()->default_value(10), "Throughput mode: Unmeasured inferences per thread before every run")(
+            "duration,d", po::value<double>()->default_value(0)->notifier(&validateDuration), "Throughput mode: Length of every run in seconds, overrides the iteration count if positive")(
+            "batchsizes", po::value<std::vector<int>>()->multitoken()->composing(), "Throughput mode: Run once per given batch size instead of only with --batchsize. Autotune mode: Batch sizes to try")(
+            "threads,t", po::value<unsigned int>()->default_value(1)->notifier(&validateThreads), "Throughput mode: Number of threads issuing inferences concurrently")(
+            "json,j", po::value<std::string>(), R"(Throughput, load and replay mode: Write a JSON report to the given file ("-" for stdout))")(
+            "qps", po::value<double>()->default_value(0), "Load mode: Target rate in requests (batches) per second")(
+            "arrivals", po::value<std::string>()->default_value("poisson")->notifier(&validateArrivals), R"(Load mode: Arrival process, "poisson", "uniform" or "replay")")(
+            "trace", po::value<std::string>(), "Load mode: Arrival trace for --arrivals replay, one timestamp in seconds per line. Replay mode: Traffic log written by --capture")(
+            "speedup", po::value<double>()->default_value(1.0), "Load and replay mode: Factor the gaps of a replayed trace are divided by. Replay mode: 0 replays as fast as possible")(
+            "capture", po::value<std::string>(), "Execute, throughput, load and serve mode: Record the inference requests into a traffic log for the replay mode")(
+            "captureinputs", po::bool_switch()->default_value(false), "Also record the packed inputs with --capture, to replay on the recorded data")(
+            "seed", po::value<std::uint64_t>()->default_value(0), "Load mode: Seed of the Poisson arrivals")(
+            "latencybound", po::value<double>()->default_value(0), "Autotune mode: Bound on the p99 batch latency in microseconds, 0 for the highest throughput regardless of latency")(
+            "tunetime", po::value<unsigned int>()->default_value(100), "Autotune mode: Milliseconds every candidate setting is measured for")(
+            "executetimeout", po::value<unsigned int>()->default_value(0), "Milliseconds a kernel run may take before the inference fails and its device is recovered, 0 to wait forever. Overrides executeTimeoutMs of the config")(
+            "ignoretuning", po::bool_switch()->default_value(false), "Do not apply the tuning stored in the config by the autotune mode")(
+            "memorybudget", po::value<double>()->default_value(0), "Limit the host memory of the buffers, archives and staging of the driver to this many MB, 0 for no limit")(
+            "memorypolicy", po::value<std::string>()->default_value("fail")->notifier(&validateMemoryPolicy), R"(Exceed the memory budget by failing at startup ("fail") or by giving up buffer slots and archive capacity ("degrade"))")(
+            "resultcache", po::value<double>()->default_value(0), "Replay mode: Serve repeated samples from a cache of their results of up to this many MB, 0 for no cache")(
+            "cacheentries", po::value<std::size_t>()->default_value(0), "Replay mode: Number of samples the result cache holds at most, 0 for no bound")(
+            "ring", po::value<std::string>()->default_value("/finn-driver"), "Serve mode: Name of the shared memory ring clients open")(
+            "slots", po::value<std::size_t>()->default_value(64), "Serve mode: Number of requests all clients together can have in flight")(
+            "maxdelay", po::value<unsigned int>()->default_value(100), "Serve mode: Longest time in microseconds a request waits for requests of other clients")(
+            "metricsinterval", po::value<unsigned int>()->default_value(0), "Serve mode: Log the bandwidth and utilisation of the devices every this many milliseconds, 0 to disable")(
+            "timeline", po::value<std::string>(), "Record host and device activity and write it as a Chrome/Perfetto trace to this file at exit")(
+            "timelineevents", po::value<std::size_t>()->default_value(Finn::defaultTimelineCapacity), "Number of timeline events kept per thread, older events are overwritten");
         //clang-format on
         po::variables_map varMap;
         po::store(po::parse_command_line(argc, argv, desc), varMap);
@@ -476,9 +1711,10 @@ int main(int argc, char* argv[]) {
         po::notify(varMap);
 
         FINN_LOG(logger, loglevel::info) << finnMainLogPrefix() << "Parsed command line params";
+        const TimelineExport timeline(varMap, logger);
 
         // Switch on modes
-        if (varMap["exec_mode"].as<std::string>() == "execute") {
+        if (const auto& mode = varMap["exec_mode"].as<std::string>(); mode == "execute" || mode == "pack" || mode == "unpack") {
             if (varMap.count("input") == 0) {
                 FinnUtils::logAndError<std::invalid_argument>("No input file(s) specified for file execution mode!");
             }
@@ -489,10 +1725,131 @@ int main(int argc, char* argv[]) {
                 FinnUtils::logAndError<std::invalid_argument>("Same amount of input and output files required!");
             }
             auto driver = createDriverFromConfig<true>(varMap["configpath"].as<std::string>(), static_cast<uint>(varMap["batchsize"].as<int>()));
-            runWithInputFile(driver, logger, varMap["input"].as<std::vector<std::string>>(), varMap["output"].as<std::vector<std::string>>());
+            const auto& inputFiles = varMap["input"].as<std::vector<std::string>>();
+            const auto& outputFiles = varMap["output"].as<std::vector<std::string>>();
+            if (mode == "execute") {
+                FilePipelineOptions pipelineOptions;
+                pipelineOptions.loaders = varMap["loaders"].as<unsigned int>();
+                pipelineOptions.queueDepth = varMap["queuedepth"].as<std::size_t>();
+                applyMemoryBudget(driver, logger, varMap);
+                applyExecuteTimeout(driver, varMap);
+                applyConfiguredTuning(driver, varMap);
+                startCapture(driver, varMap);
+                runWithInputFile(driver, logger, inputFiles, outputFiles, varMap["chunkbatches"].as<std::size_t>(), varMap["packedoutput"].as<bool>(), pipelineOptions);
+                finishCapture(driver, logger);
+            } else {
+                for (auto&& [inp, out] = std::tuple{inputFiles.begin(), outputFiles.begin()}; inp != inputFiles.end(); ++inp, ++out) {
+                    if (mode == "pack") {
+                        packInputFile(driver, *inp, *out);
+                    } else {
+                        unpackOutputFile(driver, *inp, *out);
+                    }
+                }
+            }
         } else if (varMap["exec_mode"].as<std::string>() == "throughput") {
+            ThroughputOptions options;
+            options.iterations = varMap["iterations"].as<std::size_t>();
+            options.warmup = varMap["warmup"].as<std::size_t>();
+            options.duration = varMap["duration"].as<double>();
+            options.threads = varMap["threads"].as<unsigned int>();
+            if (varMap.count("json") != 0) {
+                options.jsonPath = varMap["json"].as<std::string>();
+            }
+            std::vector<int> batchSizes{varMap["batchsize"].as<int>()};
+            if (varMap.count("batchsizes") != 0) {
+                batchSizes = varMap["batchsizes"].as<std::vector<int>>();
+            }
+            for (int batch : batchSizes) {
+                validateBatchSize(batch);
+                options.batchSizes.push_back(static_cast<uint>(batch));
+            }
+            // Allocate the buffers once for the largest batch size of the sweep
+            auto driver = createDriverFromConfig<true>(varMap["configpath"].as<std::string>(), *std::max_element(options.batchSizes.begin(), options.batchSizes.end()));
+            applyMemoryBudget(driver, logger, varMap);
+            applyExecuteTimeout(driver, varMap);
+            startCapture(driver, varMap);
+            runThroughputTest(driver, logger, options);
+            finishCapture(driver, logger);
+        } else if (varMap["exec_mode"].as<std::string>() == "load") {
+            LoadOptions options;
+            options.qps = varMap["qps"].as<double>();
+            options.arrivals = varMap["arrivals"].as<std::string>();
+            options.speedup = varMap["speedup"].as<double>();
+            options.seed = varMap["seed"].as<std::uint64_t>();
+            options.requests = varMap["iterations"].as<std::size_t>();
+            options.duration = varMap["duration"].as<double>();
+            options.warmup = varMap["warmup"].as<std::size_t>();
+            options.producers = varMap["threads"].as<unsigned int>();
+            if (varMap.count("json") != 0) {
+                options.jsonPath = varMap["json"].as<std::string>();
+            }
+            if (options.arrivals == "replay") {
+                if (varMap.count("trace") == 0) {
+                    FinnUtils::logAndError<std::invalid_argument>("No arrival trace specified for --arrivals replay!");
+                }
+                options.tracePath = varMap["trace"].as<std::string>();
+            } else if (options.qps <= 0) {
+                FinnUtils::logAndError<std::invalid_argument>("The load mode needs a positive --qps!");
+            }
+            auto driver = createDriverFromConfig<true>(varMap["configpath"].as<std::string>(), static_cast<uint>(varMap["batchsize"].as<int>()));
+            applyMemoryBudget(driver, logger, varMap);
+            applyExecuteTimeout(driver, varMap);
+            applyConfiguredTuning(driver, varMap);
+            startCapture(driver, varMap);
+            runLoadTest(driver, logger, options);
+            finishCapture(driver, logger);
+        } else if (varMap["exec_mode"].as<std::string>() == "serve") {
+            ServeOptions options;
+            options.ringName = varMap["ring"].as<std::string>();
+            options.slots = varMap["slots"].as<std::size_t>();
+            options.maxDelay = std::chrono::microseconds(varMap["maxdelay"].as<unsigned int>());
+            options.metricsInterval = std::chrono::milliseconds(varMap["metricsinterval"].as<unsigned int>());
+            auto driver = createDriverFromConfig<true>(varMap["configpath"].as<std::string>(), static_cast<uint>(varMap["batchsize"].as<int>()));
+            applyMemoryBudget(driver, logger, varMap);
+            applyExecuteTimeout(driver, varMap);
+            applyConfiguredTuning(driver, varMap);
+            startCapture(driver, varMap);
+            runDaemon(driver, logger, options);
+            finishCapture(driver, logger);
+        } else if (varMap["exec_mode"].as<std::string>() == "replay") {
+            ReplayOptions options;
+            if (varMap.count("trace") == 0) {
+                FinnUtils::logAndError<std::invalid_argument>("No traffic log specified for the replay mode, use --trace!");
+            }
+            options.logPath = varMap["trace"].as<std::string>();
+            options.speedup = varMap["speedup"].as<double>();
+            if (varMap.count("json") != 0) {
+                options.jsonPath = varMap["json"].as<std::string>();
+            }
             auto driver = createDriverFromConfig<true>(varMap["configpath"].as<std::string>(), static_cast<uint>(varMap["batchsize"].as<int>()));
-            runThroughputTest(driver, logger);
+            applyMemoryBudget(driver, logger, varMap);
+            applyExecuteTimeout(driver, varMap);
+            applyConfiguredTuning(driver, varMap);
+            applyResultCache(driver, varMap);
+            runReplay(driver, logger, options);
+        } else if (varMap["exec_mode"].as<std::string>() == "autotune") {
+            AutotuneModeOptions options;
+            options.configPath = varMap["configpath"].as<std::string>();
+            if (varMap.count("output") != 0) {
+                options.outputPath = varMap["output"].as<std::vector<std::string>>().front();
+            }
+            if (varMap.count("json") != 0) {
+                options.jsonPath = varMap["json"].as<std::string>();
+            }
+            options.tuner.latencyBound = varMap["latencybound"].as<double>();
+            options.tuner.measureTime = std::chrono::milliseconds(varMap["tunetime"].as<unsigned int>());
+            if (varMap.count("batchsizes") != 0) {
+                options.tuner.batchSizes.clear();
+                for (int batch : varMap["batchsizes"].as<std::vector<int>>()) {
+                    validateBatchSize(batch);
+                    options.tuner.batchSizes.push_back(static_cast<uint>(batch));
+                }
+            }
+            auto driver = createDriverFromConfig<true>(options.configPath, *std::max_element(options.tuner.batchSizes.begin(), options.tuner.batchSizes.end()));
+            // Threads beyond the CPUs local to the device would only be pinned onto the same CPUs again
+            const auto& localCpus = driver.getDeviceHandler(driver.getDefaultInputDeviceIndex()).getLocalCpus();
+            options.tuner.limitThreads(localCpus.empty() ? std::thread::hardware_concurrency() : static_cast<unsigned int>(localCpus.size()));
+            runAutotune(driver, logger, options);
         } else {
             FinnUtils::logAndError<std::invalid_argument>("Unknown driver mode: " + varMap["exec_mode"].as<std::string>());
         }
@@ -4,13 +4,22 @@
 #define FINNDRIVERUSEDDATATYPES
 #include "../core/BaseDriver.hpp"
 #include "../utils/FinnDatatypes.hpp"
+#include "../utils/StaticShapes.hpp"
 
 using InputFinnType = Finn::DatatypeInt<2>;
 using OutputFinnType = Finn::DatatypeBinary;
 
+// Shapes known at compile time are optional, they are used if the FINN compiler generated FinnDriverUsedShapes.h next to this header
+#if __has_include("FinnDriverUsedShapes.h")
+    #include "FinnDriverUsedShapes.h"  // IWYU pragma: keep
+#else
+using InputFinnShape = Finn::DynamicBufferShape;
+using OutputFinnShape = Finn::DynamicBufferShape;
+#endif
+
 namespace Finn {
     template<bool SynchronousInference>
-    using Driver = Finn::BaseDriver<SynchronousInference, InputFinnType, OutputFinnType>;
+    using Driver = Finn::BaseDriver<SynchronousInference, InputFinnType, OutputFinnType, uint8_t, InputFinnShape, OutputFinnShape>;
 }  // namespace Finn
 
 
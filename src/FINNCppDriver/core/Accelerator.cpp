@@ -18,13 +18,54 @@
 #include <FINNCppDriver/utils/Logger.h>                // for operator<<, DevNull
 
 #include <algorithm>  // for count_if, find_if, tra...
+#include <chrono>     // for steady_clock
 #include <cstddef>    // for size_t
+#include <exception>  // for exception_ptr
+#include <future>     // for async, future
 #include <iterator>   // for back_insert_iterator
+#include <optional>   // for optional
 #include <stdexcept>  // for runtime_error
 
 namespace Finn {
-    Accelerator::Accelerator(const std::vector<DeviceWrapper>& deviceDefinitions, bool synchronousInference, unsigned int hostBufferSize) {
-        std::transform(deviceDefinitions.begin(), deviceDefinitions.end(), std::back_inserter(devices), [hostBufferSize, synchronousInference](const DeviceWrapper& dew) { return DeviceHandler(dew, synchronousInference, hostBufferSize); });
+    Accelerator::Accelerator(const std::vector<DeviceWrapper>& deviceDefinitions, bool synchronousInference, unsigned int hostBufferSize, unsigned int bufferSlots) {
+        const auto start = std::chrono::steady_clock::now();
+        // Opening and programming a card takes seconds, so all cards are brought up at the same time. The first device is set up by this thread.
+        std::vector<std::future<DeviceHandler>> pending;
+        pending.reserve(deviceDefinitions.size());
+        for (std::size_t i = 1; i < deviceDefinitions.size(); ++i) {
+            pending.emplace_back(std::async(std::launch::async, [&dew = deviceDefinitions[i], hostBufferSize, synchronousInference, bufferSlots]() { return DeviceHandler(dew, synchronousInference, hostBufferSize, bufferSlots); }));
+        }
+        devices.reserve(deviceDefinitions.size());
+        if (!deviceDefinitions.empty()) {
+            devices.emplace_back(deviceDefinitions.front(), synchronousInference, hostBufferSize, bufferSlots);
+        }
+        // Waits for all devices before the first exception is rethrown
+        std::exception_ptr error;
+        for (auto&& device : pending) {
+            try {
+                devices.emplace_back(device.get());
+            } catch (...) {
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        for (auto&& device : devices) {
+            const auto& times = device.getStartupTimes();
+            FINN_LOG(Logger::getLogger(), loglevel::info) << loggerPrefix() << "Startup of device " << device.getDeviceIndex() << ": open " << std::chrono::duration<double, std::milli>(times.open).count() << "ms, xclbin "
+                                                          << std::chrono::duration<double, std::milli>(times.program).count() << "ms" << (times.reprogrammed ? "" : " (not reprogrammed)");
+        }
+        FINN_LOG(Logger::getLogger(), loglevel::info) << loggerPrefix() << "Brought up " << devices.size() << " device(s) in " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << "ms";
+        scheduler = std::make_unique<Scheduler>(devices.size());
+        for (auto&& pool : scheduler->slotPools) {
+            pool.reset(bufferSlots);
+        }
+        for (std::size_t position = 0; position < devices.size(); ++position) {
+            scheduler->pairPools[position].reset(devices[position].getComputeUnitPairs().size());
+        }
     }
 
     std::string Accelerator::loggerPrefix() { return "[Accelerator] "; }
@@ -51,6 +92,19 @@ namespace Finn {
 
     std::vector<DeviceHandler>::iterator Accelerator::end() { return devices.end(); }
 
+    std::size_t Accelerator::deviceCount() const { return devices.size(); }
+
+    void Accelerator::setSchedulingPolicy(SCHEDULING_POLICY policy) {
+        if (policy != SCHEDULING_POLICY::ROUND_ROBIN && policy != SCHEDULING_POLICY::LEAST_OUTSTANDING) {
+            FinnUtils::logAndError<std::invalid_argument>("Invalid scheduling policy!");
+        }
+        scheduler->policy = policy;
+    }
+
+    SCHEDULING_POLICY Accelerator::getSchedulingPolicy() const { return scheduler->policy; }
+
+    unsigned int Accelerator::getOutstandingWork(std::size_t position) const { return scheduler->outstanding.at(position).load(std::memory_order_relaxed); }
+
 
     /****** USER METHODS ******/
 
@@ -70,12 +124,180 @@ namespace Finn {
         return {devices[0], ""};
     }
 
+    std::size_t Accelerator::getAvailableBufferSets(std::size_t position) const { return scheduler->slotPools.at(position).available(); }
+
+    std::size_t Accelerator::getAvailableComputeUnits(std::size_t position) const { return scheduler->pairPools.at(position).available(); }
+
+    std::size_t Accelerator::pickDevice() {
+        if (devices.empty()) {
+            FinnUtils::logAndError<std::runtime_error>("Something went wrong. The device list should not be empty.");
+        }
+        const std::size_t count = devices.size();
+        while (true) {
+            // Start the search at a rotating position, so ties between idle devices are broken round robin as well
+            const std::size_t first = scheduler->nextDevice.fetch_add(1, std::memory_order_relaxed) % count;
+            std::optional<std::size_t> position;
+            unsigned int least = 0;
+            for (std::size_t offset = 0; offset < count; ++offset) {
+                const std::size_t candidate = (first + offset) % count;
+                // Stuck devices get no work until they were recovered, so their batches go to the healthy ones
+                if (devices[candidate].isStuck()) {
+                    continue;
+                }
+                const unsigned int load = scheduler->outstanding[candidate].load(std::memory_order_relaxed);
+                if (!position || load < least) {
+                    position = candidate;
+                    least = load;
+                }
+                if (scheduler->policy == SCHEDULING_POLICY::ROUND_ROBIN || least == 0) {
+                    break;
+                }
+            }
+            if (!position) {
+                FinnUtils::logAndError<KernelTimeoutError>(loggerPrefix() + "All devices are stuck, there is no device to run on until one was recovered");
+            }
+            scheduler->outstanding[*position].fetch_add(1);
+            // Checked again after counting the work, so a recovery that saw the device drained cannot miss it
+            if (!devices[*position].isStuck()) {
+                return *position;
+            }
+            scheduler->outstanding[*position].fetch_sub(1);
+        }
+    }
+
+    DeviceLease Accelerator::acquireDevice() {
+        const std::size_t position = pickDevice();
+        return {devices[position], position, scheduler->locks[position], scheduler->outstanding[position]};
+    }
+
+    BufferSetLease Accelerator::acquireBufferSet() {
+        const std::size_t position = pickDevice();
+        return {devices[position], position, scheduler->slotPools[position], scheduler->locks[position], scheduler->outstanding[position]};
+    }
+
+    std::vector<DeviceMetricsSnapshot> Accelerator::getMetrics() const {
+        std::vector<DeviceMetricsSnapshot> snapshots;
+        snapshots.reserve(devices.size());
+        for (auto&& device : devices) {
+            snapshots.emplace_back(device.getMetrics());
+        }
+        return snapshots;
+    }
+
+    std::vector<DeviceFootprint> Accelerator::getMemoryFootprint() const {
+        std::vector<DeviceFootprint> footprints;
+        footprints.reserve(devices.size());
+        for (auto&& device : devices) {
+            footprints.emplace_back(device.getMemoryFootprint());
+        }
+        return footprints;
+    }
+
+    void Accelerator::resetMetrics() {
+        for (auto&& device : devices) {
+            device.resetMetrics();
+        }
+    }
+
+    ComputeUnitLease Accelerator::acquireComputeUnits() {
+        const std::size_t position = pickDevice();
+        return {devices[position], position, scheduler->pairPools[position], scheduler->outstanding[position]};
+    }
+
     void Accelerator::setBatchSize(uint batchsize) {
         for (auto&& elem : devices) {
             elem.setBatchSize(batchsize);
         }
     }
 
+    void Accelerator::setMaxBatchSize(uint maxBatchSize) {
+        for (auto&& elem : devices) {
+            elem.setMaxBatchSize(maxBatchSize);
+        }
+    }
+
+    void Accelerator::allocateBuffers() {
+        if (devices.size() == 1) {
+            devices.front().allocateBuffers();
+            return;
+        }
+        std::vector<std::future<void>> pending;
+        pending.reserve(devices.size());
+        for (auto&& device : devices) {
+            pending.emplace_back(std::async(std::launch::async, [&device]() { device.allocateBuffers(); }));
+        }
+        for (auto&& allocation : pending) {
+            allocation.get();
+        }
+    }
+
+    void Accelerator::setBufferSlots(unsigned int bufferSlots) {
+        for (auto&& elem : devices) {
+            elem.setBufferSlots(bufferSlots);
+        }
+        for (auto&& pool : scheduler->slotPools) {
+            pool.reset(bufferSlots);
+        }
+    }
+
+    void Accelerator::setActiveBufferSlot(std::size_t slot) {
+        for (auto&& elem : devices) {
+            elem.setActiveBufferSlot(slot);
+        }
+    }
+
+    void Accelerator::setWaitPolicy(WAIT_POLICY policy, unsigned int spinBudget) {
+        for (auto&& elem : devices) {
+            elem.setWaitPolicy(policy, spinBudget);
+        }
+    }
+
+    void Accelerator::setExecuteTimeout(std::chrono::microseconds timeout) {
+        for (auto&& elem : devices) {
+            elem.setExecuteTimeout(timeout);
+        }
+    }
+
+    bool Accelerator::recoverDevice(std::size_t position) {
+        DeviceHandler& device = devices.at(position);
+        if (!device.isStuck() || scheduler->outstanding[position].load() != 0) {
+            return false;
+        }
+        device.recover();
+        return true;
+    }
+
+    std::size_t Accelerator::recoverStuckDevices() {
+        std::size_t recovered = 0;
+        for (std::size_t position = 0; position < devices.size(); ++position) {
+            try {
+                recovered += recoverDevice(position) ? 1 : 0;
+            } catch (const std::exception& e) {
+                // The device stays stuck, so the next attempt tries again
+                FINN_LOG(Logger::getLogger(), loglevel::error) << loggerPrefix() << "Could not recover device " << devices[position].getDeviceIndex() << ": " << e.what();
+            }
+        }
+        return recovered;
+    }
+
+    std::uint64_t Accelerator::getRecoveries() const {
+        std::uint64_t recoveries = 0;
+        for (auto&& elem : devices) {
+            recoveries += elem.getRecoveries();
+        }
+        return recoveries;
+    }
+
+    void Accelerator::setArchiveCapacity(std::size_t bytes) {
+        for (auto&& elem : devices) {
+            elem.setArchiveCapacity(bytes);
+        }
+    }
+
+    void Accelerator::setResultCallback(unsigned int deviceIndex, const std::string& outputBufferKernelName, packedResultCallback_t callback) {
+        getDeviceHandler(deviceIndex).setResultCallback(outputBufferKernelName, std::move(callback));
+    }
+
     bool Accelerator::run() {
         bool ret = true;
         for (auto&& dev : devices) {
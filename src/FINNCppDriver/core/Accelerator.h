@@ -16,10 +16,15 @@
 #include <FINNCppDriver/core/DeviceHandler.h>  // for DeviceHandler, Uncheck...
 #include <FINNCppDriver/utils/Types.h>         // for vector, SIZE_SPECIFIER
 
-#include <cinttypes>  // for uint8_t
-#include <cstddef>    // for size_t
-#include <string>     // for string
-#include <vector>     // for vector, vector<>::iter...
+#include <atomic>              // for atomic
+#include <chrono>              // for microseconds
+#include <cinttypes>           // for uint8_t
+#include <condition_variable>  // for condition_variable
+#include <cstddef>             // for size_t
+#include <memory>              // for unique_ptr
+#include <mutex>               // for mutex, unique_lock
+#include <string>              // for string
+#include <vector>              // for vector, vector<>::iter...
 
 namespace Finn {
     struct DeviceWrapper;
@@ -27,6 +32,252 @@ namespace Finn {
 
 
 namespace Finn {
+    /**
+     * @brief Exclusive access to one device of an accelerator for one unit of work, handed out by Accelerator::acquireDevice. The device counts as busy until the lease is destroyed.
+     *
+     */
+    class DeviceLease {
+         private:
+        DeviceHandler* device;
+        std::size_t devicePosition;
+        std::atomic<unsigned int>* outstanding;
+        std::unique_lock<std::mutex> lock;
+
+         public:
+        /**
+         * @brief Construct a new Device Lease. Blocks until the device is free.
+         *
+         * @param pDevice
+         * @param pDevicePosition Position of the device in the accelerator (and in Config::deviceWrappers)
+         * @param deviceLock Lock guarding the device
+         * @param pOutstanding Work counter of the device. Already incremented by the caller, decremented on destruction.
+         */
+        DeviceLease(DeviceHandler& pDevice, std::size_t pDevicePosition, std::mutex& deviceLock, std::atomic<unsigned int>& pOutstanding)
+            : device(&pDevice), devicePosition(pDevicePosition), outstanding(&pOutstanding), lock(deviceLock) {}
+        DeviceLease(DeviceLease&&) = delete;
+        DeviceLease(const DeviceLease&) = delete;
+        DeviceLease& operator=(DeviceLease&&) = delete;
+        DeviceLease& operator=(const DeviceLease&) = delete;
+        /**
+         * @brief Destroy the Device Lease object, unlock the device and count the work as done
+         *
+         */
+        ~DeviceLease() {
+            lock.unlock();
+            outstanding->fetch_sub(1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Get the leased device
+         *
+         * @return DeviceHandler&
+         */
+        DeviceHandler& get() { return *device; }
+
+        /**
+         * @brief Get the position of the leased device in the accelerator
+         *
+         * @return std::size_t
+         */
+        std::size_t position() const { return devicePosition; }
+    };
+
+    /**
+     * @brief Free buffer slots of one device. Every slot is an independent set of input and output buffer objects that one thread can pack, run and unpack at a time.
+     *
+     */
+    class BufferSlotPool {
+         private:
+        std::mutex poolMutex;
+        std::condition_variable released;
+        std::vector<std::size_t> freeSlots;
+
+         public:
+        /**
+         * @brief Make the slots 0 to slots - 1 available. Must not be called while slots are checked out.
+         *
+         * @param slots
+         */
+        void reset(std::size_t slots) {
+            std::lock_guard guard(poolMutex);
+            freeSlots.clear();
+            // Handed out from the back, so slot 0 is used first
+            for (std::size_t slot = slots; slot > 0; --slot) {
+                freeSlots.push_back(slot - 1);
+            }
+        }
+
+        /**
+         * @brief Check out a slot. Blocks until one is free.
+         *
+         * @return std::size_t
+         */
+        std::size_t acquire() {
+            std::unique_lock lock(poolMutex);
+            released.wait(lock, [this]() { return !freeSlots.empty(); });
+            const std::size_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            return slot;
+        }
+
+        /**
+         * @brief Return a slot checked out with acquire
+         *
+         * @param slot
+         */
+        void release(std::size_t slot) {
+            {
+                std::lock_guard guard(poolMutex);
+                freeSlots.push_back(slot);
+            }
+            released.notify_one();
+        }
+
+        /**
+         * @brief Number of slots that are currently not checked out
+         *
+         * @return std::size_t
+         */
+        std::size_t available() {
+            std::lock_guard guard(poolMutex);
+            return freeSlots.size();
+        }
+    };
+
+    /**
+     * @brief One buffer slot of a device, checked out by one thread, handed out by Accelerator::acquireBufferSet. The thread packs into and unpacks from the maps of its slot
+     * without any lock, and only holds the device (lockDevice) while the slot is executed. Several threads can thus have inferences in flight on the same device.
+     *
+     */
+    class BufferSetLease {
+         private:
+        DeviceHandler* device;
+        std::size_t devicePosition;
+        BufferSlotPool* pool;
+        std::size_t bufferSlot;
+        std::mutex* deviceLock;
+        std::atomic<unsigned int>* outstanding;
+
+         public:
+        /**
+         * @brief Construct a new Buffer Set Lease. Blocks until a slot of the device is free.
+         *
+         * @param pDevice
+         * @param pDevicePosition Position of the device in the accelerator (and in Config::deviceWrappers)
+         * @param pPool Free slots of the device
+         * @param pDeviceLock Lock guarding the execution on the device
+         * @param pOutstanding Work counter of the device. Already incremented by the caller, decremented on destruction.
+         */
+        BufferSetLease(DeviceHandler& pDevice, std::size_t pDevicePosition, BufferSlotPool& pPool, std::mutex& pDeviceLock, std::atomic<unsigned int>& pOutstanding)
+            : device(&pDevice), devicePosition(pDevicePosition), pool(&pPool), bufferSlot(pPool.acquire()), deviceLock(&pDeviceLock), outstanding(&pOutstanding) {}
+        BufferSetLease(BufferSetLease&&) = delete;
+        BufferSetLease(const BufferSetLease&) = delete;
+        BufferSetLease& operator=(BufferSetLease&&) = delete;
+        BufferSetLease& operator=(const BufferSetLease&) = delete;
+        /**
+         * @brief Destroy the Buffer Set Lease object, return the slot and count the work as done
+         *
+         */
+        ~BufferSetLease() {
+            pool->release(bufferSlot);
+            outstanding->fetch_sub(1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Get the device the slot belongs to
+         *
+         * @return DeviceHandler&
+         */
+        DeviceHandler& get() { return *device; }
+
+        /**
+         * @brief Get the position of the device in the accelerator
+         *
+         * @return std::size_t
+         */
+        std::size_t position() const { return devicePosition; }
+
+        /**
+         * @brief Get the checked out buffer slot
+         *
+         * @return std::size_t
+         */
+        std::size_t slot() const { return bufferSlot; }
+
+        /**
+         * @brief Lock the device for running the slot. Select the slot with DeviceHandler::setActiveBufferSlot only while holding this lock.
+         *
+         * @return std::unique_lock<std::mutex>
+         */
+        [[nodiscard]] std::unique_lock<std::mutex> lockDevice() { return std::unique_lock(*deviceLock); }
+    };
+
+    /**
+     * @brief One compute unit pair of a device (@see DeviceHandler::getComputeUnitPairs), checked out by one thread, handed out by Accelerator::acquireComputeUnits.
+     * The pair has its own buffers, so the thread packs, runs and unpacks without holding the device, while the other pairs of the device run batches of other threads.
+     *
+     */
+    class ComputeUnitLease {
+         private:
+        DeviceHandler* device;
+        std::size_t devicePosition;
+        BufferSlotPool* pool;
+        std::size_t pairIndex;
+        std::atomic<unsigned int>* outstanding;
+
+         public:
+        /**
+         * @brief Construct a new Compute Unit Lease. Blocks until a pair of the device is idle.
+         *
+         * @param pDevice
+         * @param pDevicePosition Position of the device in the accelerator (and in Config::deviceWrappers)
+         * @param pPool Idle pairs of the device
+         * @param pOutstanding Work counter of the device. Already incremented by the caller, decremented on destruction.
+         */
+        ComputeUnitLease(DeviceHandler& pDevice, std::size_t pDevicePosition, BufferSlotPool& pPool, std::atomic<unsigned int>& pOutstanding)
+            : device(&pDevice), devicePosition(pDevicePosition), pool(&pPool), pairIndex(pPool.acquire()), outstanding(&pOutstanding) {}
+        ComputeUnitLease(ComputeUnitLease&&) = delete;
+        ComputeUnitLease(const ComputeUnitLease&) = delete;
+        ComputeUnitLease& operator=(ComputeUnitLease&&) = delete;
+        ComputeUnitLease& operator=(const ComputeUnitLease&) = delete;
+        /**
+         * @brief Destroy the Compute Unit Lease object, return the pair and count the work as done
+         *
+         */
+        ~ComputeUnitLease() {
+            pool->release(pairIndex);
+            outstanding->fetch_sub(1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Get the device the pair belongs to
+         *
+         * @return DeviceHandler&
+         */
+        DeviceHandler& get() { return *device; }
+
+        /**
+         * @brief Get the position of the device in the accelerator
+         *
+         * @return std::size_t
+         */
+        std::size_t position() const { return devicePosition; }
+
+        /**
+         * @brief Get the index of the pair in DeviceHandler::getComputeUnitPairs
+         *
+         * @return std::size_t
+         */
+        std::size_t index() const { return pairIndex; }
+
+        /**
+         * @brief Get the checked out pair
+         *
+         * @return const ComputeUnitPair&
+         */
+        const ComputeUnitPair& pair() const { return device->getComputeUnitPairs()[pairIndex]; }
+    };
+
     /**
      * @brief The Accelerator class wraps one or more Devices into a single Accelerator
      *
@@ -39,6 +290,35 @@ namespace Finn {
          */
         std::vector<DeviceHandler> devices;
 
+        /**
+         * @brief Bookkeeping of the device scheduler. Kept behind a pointer so the accelerator stays movable.
+         *
+         */
+        struct Scheduler {
+            SCHEDULING_POLICY policy = SCHEDULING_POLICY::LEAST_OUTSTANDING;
+            std::atomic<std::size_t> nextDevice = 0;
+            std::vector<std::mutex> locks;
+            /**
+             * @brief Leases of every device that are held or waited for. Every lease decrements the counter of its device with release ordering as the last thing
+             * it does and recoverDevice only reprograms a device whose counter it reads as 0, so the recovery sees all buffer accesses of the leases as finished.
+             *
+             */
+            std::vector<std::atomic<unsigned int>> outstanding;
+            std::vector<BufferSlotPool> slotPools;
+            std::vector<BufferSlotPool> pairPools;
+
+            explicit Scheduler(std::size_t deviceCount) : locks(deviceCount), outstanding(deviceCount), slotPools(deviceCount), pairPools(deviceCount) {}
+        };
+        std::unique_ptr<Scheduler> scheduler = std::make_unique<Scheduler>(0);
+
+        /**
+         * @brief Pick a device according to the scheduling policy and count one unit of outstanding work on it. Stuck devices are skipped, if all devices are stuck a
+         * KernelTimeoutError is thrown.
+         *
+         * @return std::size_t Position of the device
+         */
+        std::size_t pickDevice();
+
         /**
          * @brief A small prefix to determine where the log write came from
          *
@@ -49,13 +329,14 @@ namespace Finn {
          public:
         Accelerator() = default;
         /**
-         * @brief Construct a new Accelerator object using a list of DeviceWrappers
+         * @brief Construct a new Accelerator object using a list of DeviceWrappers. The devices are opened and programmed in parallel.
          *
          * @param deviceDefinitions Vector of @ref DeviceWrapper
          * @param synchronousInference Decides if synchronous or asynchronous inference should be used
          * @param hostBufferSize Size of ringbuffer to initialize
+         * @param bufferSlots Number of XRT buffer objects per synchronous DeviceBuffer (multi buffering)
          */
-        explicit Accelerator(const std::vector<DeviceWrapper>& deviceDefinitions, bool synchronousInference, unsigned int hostBufferSize);
+        explicit Accelerator(const std::vector<DeviceWrapper>& deviceDefinitions, bool synchronousInference, unsigned int hostBufferSize, unsigned int bufferSlots = 1);
         /**
          * @brief Construct a new Accelerator object
          *
@@ -116,6 +397,95 @@ namespace Finn {
          */
         bool containsDevice(unsigned int deviceIndex);
 
+        /**
+         * @brief Number of devices of the accelerator
+         *
+         * @return std::size_t
+         */
+        std::size_t deviceCount() const;
+
+        /**
+         * @brief Set the strategy acquireDevice uses to pick a device
+         *
+         * @param policy
+         */
+        void setSchedulingPolicy(SCHEDULING_POLICY policy);
+
+        /**
+         * @brief Get the scheduling policy
+         *
+         * @return SCHEDULING_POLICY
+         */
+        SCHEDULING_POLICY getSchedulingPolicy() const;
+
+        /**
+         * @brief Pick a device according to the scheduling policy and lease it for one unit of work. Blocks until the picked device is free. Stuck devices are skipped, a KernelTimeoutError is thrown if all devices are stuck.
+         * Thread safe, so several threads can drive different devices at the same time.
+         *
+         * @return DeviceLease
+         */
+        DeviceLease acquireDevice();
+
+        /**
+         * @brief Pick a device according to the scheduling policy and check out one of its buffer slots (@see setBufferSlots). Blocks until a slot of the picked device is free.
+         * Unlike acquireDevice, the device itself is not held, so as many threads as there are slots can work on the same device at the same time.
+         *
+         * @return BufferSetLease
+         */
+        BufferSetLease acquireBufferSet();
+
+        /**
+         * @brief Number of buffer slots of the device at the given position that are currently not checked out
+         *
+         * @param position
+         * @return std::size_t
+         */
+        std::size_t getAvailableBufferSets(std::size_t position) const;
+
+        /**
+         * @brief Pick a device according to the scheduling policy and check out one of its idle compute unit pairs. Blocks until a pair of the picked device is idle.
+         * Devices without replicated compute units have a single pair, that is shared with acquireDevice and acquireBufferSet, so these must not be mixed.
+         *
+         * @return ComputeUnitLease
+         */
+        ComputeUnitLease acquireComputeUnits();
+
+        /**
+         * @brief Number of compute unit pairs of the device at the given position that are currently idle
+         *
+         * @param position
+         * @return std::size_t
+         */
+        std::size_t getAvailableComputeUnits(std::size_t position) const;
+
+        /**
+         * @brief Get the transfer and execution counters of all devices, @see DeviceHandler::getMetrics
+         *
+         * @return std::vector<DeviceMetricsSnapshot> One entry per device, in the order of the devices
+         */
+        std::vector<DeviceMetricsSnapshot> getMetrics() const;
+
+        /**
+         * @brief Get the host memory held by the buffers of all devices, @see DeviceHandler::getMemoryFootprint
+         *
+         * @return std::vector<DeviceFootprint> One entry per device, in the order of the devices
+         */
+        std::vector<DeviceFootprint> getMemoryFootprint() const;
+
+        /**
+         * @brief Reset the counters of all devices, @see DeviceHandler::resetMetrics
+         *
+         */
+        void resetMetrics();
+
+        /**
+         * @brief Number of leases that are currently held or waited for on the device at the given position
+         *
+         * @param position
+         * @return unsigned int
+         */
+        unsigned int getOutstandingWork(std::size_t position) const;
+
         /**
          * @brief Factory to create a functon that can store data without index checks because they are checked beforehand. The created function only takes the data vector.
          * @attention (Currently on this commit) This also does NOT do checks on the length of the passed data vector and is _NOT THREAD SAFE_!
@@ -133,6 +503,89 @@ namespace Finn {
          */
         void setBatchSize(uint batchsize);
 
+        /**
+         * @brief Allocate the buffers of all devices for the given maximum batch size. @see DeviceHandler::setMaxBatchSize
+         *
+         * @param maxBatchSize
+         */
+        void setMaxBatchSize(uint maxBatchSize);
+
+        /**
+         * @brief Allocate the buffer objects of all devices in parallel now instead of on first use (@see DeviceHandler::allocateBuffers)
+         *
+         */
+        void allocateBuffers();
+
+        /**
+         * @brief Set the number of XRT buffer objects per synchronous DeviceBuffer on all devices. Must not be called while buffer sets are checked out.
+         *
+         * @param bufferSlots
+         */
+        void setBufferSlots(unsigned int bufferSlots);
+
+        /**
+         * @brief Select the buffer slot used by all buffers of all devices for the next run / read
+         *
+         * @param slot
+         */
+        void setActiveBufferSlot(std::size_t slot);
+
+        /**
+         * @brief Set the strategy all buffers of all devices use to wait for kernel completion
+         *
+         * @param policy
+         * @param spinBudget Number of polls before yielding (only used by WAIT_POLICY::SPIN_YIELD)
+         */
+        void setWaitPolicy(WAIT_POLICY policy, unsigned int spinBudget = defaultSpinBudget);
+
+        /**
+         * @brief Bound the time a synchronous wait gives a kernel run on all devices, @see DeviceHandler::setExecuteTimeout
+         *
+         * @param timeout 0 to wait forever
+         */
+        void setExecuteTimeout(std::chrono::microseconds timeout);
+
+        /**
+         * @brief Recover the device at the given position if it is stuck and drained, that is no lease of it is held or waited for. The scheduler stops handing out
+         * stuck devices, so a stuck device drains as its leases are returned. @see DeviceHandler::recover
+         * @attention Only leases are waited for. The device must not be used through getDeviceHandler by another thread at the same time.
+         *
+         * @param position
+         * @return true The device was reprogrammed
+         * @return false The device is healthy or still has leases out
+         */
+        bool recoverDevice(std::size_t position);
+
+        /**
+         * @brief Recover all stuck devices that are drained, @see recoverDevice. A device that cannot be reprogrammed stays stuck and is logged.
+         *
+         * @return std::size_t Number of recovered devices
+         */
+        std::size_t recoverStuckDevices();
+
+        /**
+         * @brief Number of recoveries of all devices so far, @see DeviceHandler::getRecoveries. Thread safe.
+         *
+         * @return std::uint64_t
+         */
+        std::uint64_t getRecoveries() const;
+
+        /**
+         * @brief Set the memory cap for the archived results of all asynchronous output buffers of all devices
+         *
+         * @param bytes 0 removes the cap
+         */
+        void setArchiveCapacity(std::size_t bytes);
+
+        /**
+         * @brief Register a callback for the packed results of an asynchronous output buffer on the given device
+         *
+         * @param deviceIndex
+         * @param outputBufferKernelName
+         * @param callback Invoked from the buffer's worker thread for every batch element. An empty function removes the callback.
+         */
+        void setResultCallback(unsigned int deviceIndex, const std::string& outputBufferKernelName, packedResultCallback_t callback);
+
         /**
          * @brief Run the accelerator with the stored input
          *
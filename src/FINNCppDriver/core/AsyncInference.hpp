@@ -0,0 +1,288 @@
+/**
+ * @file AsyncInference.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Ties the results of asynchronous inferences to the requests that produced them, for futures and coroutines
+ * @version 0.1
+ * @date 2024-02-12
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef ASYNCINFERENCE
+#define ASYNCINFERENCE
+
+#include <FINNCppDriver/utils/FinnUtils.h>
+#include <FINNCppDriver/utils/Logger.h>
+#include <FINNCppDriver/utils/Types.h>
+
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace Finn {
+    /**
+     * @brief Requests that wait for results of one asynchronous output buffer, in submission order. A FINN dataflow accelerator processes its input stream in order,
+     * so the n-th batch element that leaves the output DMA belongs to the n-th batch element that was stored into the input DMA. Every request is completed as soon
+     * as all of its batch elements have arrived.
+     *
+     */
+    class AsyncCompletionQueue {
+         public:
+        /**
+         * @brief Called once per request with the packed results of all its batch elements, or with the error that prevented them
+         *
+         */
+        using completion_t = std::function<void(Finn::vector<uint8_t>&&, std::exception_ptr)>;
+
+         private:
+        struct Pending {
+            std::size_t id;
+            std::size_t remainingParts;
+            Finn::vector<uint8_t> packed;
+            completion_t complete;
+        };
+
+        std::mutex queueMutex;
+        std::deque<Pending> pending;
+        std::size_t nextId = 0;
+        std::atomic<std::size_t> unmatched = 0;
+
+        /**
+         * @brief A logger prefix to determine the source of a log write
+         *
+         * @return std::string
+         */
+        static std::string loggerPrefix() { return "[AsyncCompletionQueue] "; }
+
+         public:
+        AsyncCompletionQueue() = default;
+        AsyncCompletionQueue(AsyncCompletionQueue&&) = delete;
+        AsyncCompletionQueue(const AsyncCompletionQueue&) = delete;
+        AsyncCompletionQueue& operator=(AsyncCompletionQueue&&) = delete;
+        AsyncCompletionQueue& operator=(const AsyncCompletionQueue&) = delete;
+
+        /**
+         * @brief Destroy the Async Completion Queue object. Requests that are still waiting are completed with an error.
+         *
+         */
+        ~AsyncCompletionQueue() {
+            const auto error = std::make_exception_ptr(std::runtime_error(loggerPrefix() + "Driver was destroyed before the result arrived"));
+            for (auto&& request : pending) {
+                request.complete({}, error);
+            }
+        }
+
+        /**
+         * @brief Append a request. Has to happen before its input is stored, otherwise its results could arrive first.
+         *
+         * @param parts Number of batch elements of the request
+         * @param bytesPerPart Number of packed bytes per batch element
+         * @param complete
+         * @return std::size_t Identifier of the request, @see cancel
+         */
+        std::size_t enqueue(std::size_t parts, std::size_t bytesPerPart, completion_t complete) {
+            Finn::vector<uint8_t> packed;
+            packed.reserve(parts * bytesPerPart);
+            std::lock_guard guard(queueMutex);
+            pending.push_back({nextId, parts, std::move(packed), std::move(complete)});
+            return nextId++;
+        }
+
+        /**
+         * @brief Remove a request whose input could not be stored and complete it with the given error
+         *
+         * @param id
+         * @param error
+         */
+        void cancel(std::size_t id, std::exception_ptr error) {
+            completion_t complete;
+            {
+                std::lock_guard guard(queueMutex);
+                auto request = std::find_if(pending.begin(), pending.end(), [id](const Pending& req) { return req.id == id; });
+                if (request == pending.end()) {
+                    return;
+                }
+                complete = std::move(request->complete);
+                pending.erase(request);
+            }
+            complete({}, error);
+        }
+
+        /**
+         * @brief Hand the packed result of the next batch element to the oldest request. Called from the worker thread of the output buffer.
+         *
+         * @param part
+         */
+        void deliver(std::span<const uint8_t> part) {
+            Pending finished;
+            {
+                std::lock_guard guard(queueMutex);
+                if (pending.empty()) {
+                    unmatched.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                Pending& oldest = pending.front();
+                oldest.packed.insert(oldest.packed.end(), part.begin(), part.end());
+                if (--oldest.remainingParts > 0) {
+                    return;
+                }
+                finished = std::move(oldest);
+                pending.pop_front();
+            }
+            // Completed outside of the lock, so the completion may submit the next request
+            finished.complete(std::move(finished.packed), nullptr);
+        }
+
+        /**
+         * @brief Number of requests that are still waiting for results
+         *
+         * @return std::size_t
+         */
+        std::size_t inFlight() {
+            std::lock_guard guard(queueMutex);
+            return pending.size();
+        }
+
+        /**
+         * @brief Number of batch elements that arrived while no request was waiting. These were dropped.
+         *
+         * @return std::size_t
+         */
+        std::size_t getUnmatchedResults() const { return unmatched.load(std::memory_order_relaxed); }
+    };
+
+    namespace detail {
+        /**
+         * @brief Shared state between an AsyncInference and the completion of its request
+         *
+         * @tparam V Output datatype
+         */
+        template<typename V>
+        class AsyncInferenceState {
+             private:
+            Finn::vector<V> result;
+            std::exception_ptr error;
+            /**
+             * @brief nullptr while nobody waits, the address of the waiting coroutine, or this once the result is set
+             *
+             */
+            std::atomic<void*> continuation = nullptr;
+
+             public:
+            /**
+             * @brief Set the result and resume the waiting coroutine, if any. Called exactly once.
+             *
+             * @param pResult
+             * @param pError
+             */
+            void complete(Finn::vector<V>&& pResult, std::exception_ptr pError) {
+                result = std::move(pResult);
+                error = std::move(pError);
+                if (void* waiting = continuation.exchange(this, std::memory_order_acq_rel); waiting != nullptr) {
+                    std::coroutine_handle<>::from_address(waiting).resume();
+                }
+            }
+
+            /**
+             * @brief Check if the result is set
+             *
+             * @return true
+             * @return false
+             */
+            bool ready() const { return continuation.load(std::memory_order_acquire) == this; }
+
+            /**
+             * @brief Register the coroutine to resume on completion
+             *
+             * @param handle
+             * @return true The coroutine was registered and stays suspended
+             * @return false The result was set in the meantime, so the coroutine has to continue right away
+             */
+            bool suspend(std::coroutine_handle<> handle) {
+                void* expected = nullptr;
+                return continuation.compare_exchange_strong(expected, handle.address(), std::memory_order_acq_rel);
+            }
+
+            /**
+             * @brief Take the result, or rethrow the error that prevented it
+             *
+             * @return Finn::vector<V>
+             */
+            Finn::vector<V> take() {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+                return std::move(result);
+            }
+        };
+    }  // namespace detail
+
+    /**
+     * @brief Awaitable result of one asynchronous inference. co_await suspends the coroutine until all batch elements of the request have been read from the device
+     * and returns the unpacked result (or throws the error that prevented it).
+     * @attention The coroutine is resumed on the worker thread of the output buffer. Long running work after the co_await delays all following results of that output,
+     * so hand it off to an executor if necessary.
+     *
+     * @tparam V Output datatype
+     */
+    template<typename V>
+    class AsyncInference {
+         private:
+        std::shared_ptr<detail::AsyncInferenceState<V>> state;
+
+         public:
+        /**
+         * @brief Construct a new Async Inference object
+         *
+         * @param pState
+         */
+        explicit AsyncInference(std::shared_ptr<detail::AsyncInferenceState<V>> pState) : state(std::move(pState)) {}
+
+        /**
+         * @brief Check if the result has arrived
+         *
+         * @return true
+         * @return false
+         */
+        bool ready() const { return state->ready(); }
+
+        /**
+         * @brief Part of the awaitable interface
+         *
+         * @return true
+         * @return false
+         */
+        bool await_ready() const noexcept { return state->ready(); }
+
+        /**
+         * @brief Part of the awaitable interface
+         *
+         * @param handle
+         * @return true
+         * @return false
+         */
+        bool await_suspend(std::coroutine_handle<> handle) { return state->suspend(handle); }
+
+        /**
+         * @brief Part of the awaitable interface
+         *
+         * @return Finn::vector<V>
+         */
+        Finn::vector<V> await_resume() { return state->take(); }
+    };
+}  // namespace Finn
+
+#endif  // ASYNCINFERENCE
@@ -0,0 +1,219 @@
+/**
+ * @file Autotuner.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Sweeps batch size, host thread count and pipeline depth of a synchronous driver on the live device and picks the fastest setting under a latency bound
+ * @version 0.1
+ * @date 2024-03-13
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef AUTOTUNER
+#define AUTOTUNER
+
+#include <FINNCppDriver/utils/ConfigurationStructs.h>
+#include <FINNCppDriver/utils/FinnUtils.h>
+#include <FINNCppDriver/utils/Types.h>
+
+#include <FINNCppDriver/utils/SampleStatistics.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Finn {
+    /**
+     * @brief Candidates and measurement settings of an autotune run
+     *
+     */
+    struct AutotuneOptions {
+        /**
+         * @brief Batch sizes to try
+         *
+         */
+        std::vector<unsigned int> batchSizes = {1, 2, 4, 8, 16, 32, 64, 128, 256};
+        /**
+         * @brief Numbers of host threads packing and unpacking to try
+         *
+         */
+        std::vector<unsigned int> hostThreads = {1, 2, 4, 8};
+        /**
+         * @brief Numbers of buffer slots (pipeline depths) to try
+         *
+         */
+        std::vector<unsigned int> bufferSlots = {1, 2, 3};
+        /**
+         * @brief Bound on the 99th percentile of the batch latency in microseconds, 0 if unbounded
+         *
+         */
+        double latencyBound = 0;
+        /**
+         * @brief Time every candidate is measured for
+         *
+         */
+        std::chrono::milliseconds measureTime{100};
+        /**
+         * @brief Minimum number of measured runs per candidate, even if they take longer than measureTime
+         *
+         */
+        std::size_t minRuns = 5;
+        /**
+         * @brief Unmeasured runs per candidate, so buffers are allocated and caches are warm
+         *
+         */
+        std::size_t warmup = 2;
+        /**
+         * @brief Batches every run pipelines, at least twice the number of buffer slots are used so the pipeline is full for most of a run
+         *
+         */
+        std::size_t batchesPerRun = 8;
+
+        /**
+         * @brief Limit the thread candidates to the number of threads the host can run in parallel
+         *
+         * @param maxThreads
+         */
+        void limitThreads(unsigned int maxThreads) {
+            std::erase_if(hostThreads, [maxThreads](unsigned int threads) { return threads > std::max(maxThreads, 1U); });
+            if (hostThreads.empty()) {
+                hostThreads.push_back(1);
+            }
+        }
+    };
+
+    /**
+     * @brief Measurement of one candidate
+     *
+     */
+    struct AutotuneCandidate {
+        /**
+         * @brief Settings with their measured throughput and latency
+         *
+         */
+        DriverTuning tuning;
+        /**
+         * @brief True if the latency is within the bound
+         *
+         */
+        bool feasible = false;
+    };
+
+    /**
+     * @brief Outcome of an autotune run
+     *
+     */
+    struct AutotuneResult {
+        /**
+         * @brief All measured candidates in the order they were measured
+         *
+         */
+        std::vector<AutotuneCandidate> candidates;
+        /**
+         * @brief Feasible candidate with the highest throughput, empty if no candidate met the latency bound
+         *
+         */
+        std::optional<DriverTuning> best;
+    };
+
+    /**
+     * @brief Measure every combination of the candidates of the options on the default input and output of the driver with inferSynchronousPipelined, and apply
+     * the fastest one that meets the latency bound. Candidates are ordered so that buffers are only reallocated when the number of buffer slots changes. Larger
+     * batch sizes of a combination are skipped once one exceeds the latency bound, as they only take longer.
+     *
+     * The latency of a batch cannot be observed in the pipeline, it is estimated as the time per batch of a run times the pipeline depth: in a full pipeline every
+     * batch occupies its buffer slot for that long.
+     *
+     * @tparam T Input datatype
+     * @tparam DriverType Synchronous Finn::BaseDriver
+     * @param driver
+     * @param samples Whole input samples that are repeated to fill the batches
+     * @param options
+     * @return AutotuneResult
+     */
+    template<typename T, typename DriverType>
+    AutotuneResult autotune(DriverType& driver, std::span<const T> samples, const AutotuneOptions& options) {
+        using V = typename DriverType::AutoDeducedRetType;
+        if (options.batchSizes.empty() || options.hostThreads.empty() || options.bufferSlots.empty()) {
+            FinnUtils::logAndError<std::invalid_argument>("The autotuner needs at least one candidate for the batch size, the host threads and the buffer slots!");
+        }
+        const std::size_t elementsPerSample = driver.getInputElementsPerSample();
+        if (samples.empty() || samples.size() % elementsPerSample != 0) {
+            FinnUtils::logAndError<std::invalid_argument>("The autotuner needs whole input samples of " + std::to_string(elementsPerSample) + " elements!");
+        }
+        std::vector<unsigned int> batchSizes = options.batchSizes;
+        std::sort(batchSizes.begin(), batchSizes.end());
+        if (batchSizes.front() == 0) {
+            FinnUtils::logAndError<std::invalid_argument>("Autotune batch sizes must be positive!");
+        }
+        const unsigned int maxBatch = batchSizes.back();
+        const unsigned int maxSlots = *std::max_element(options.bufferSlots.begin(), options.bufferSlots.end());
+        const std::size_t batchesPerRun = std::max<std::size_t>({options.batchesPerRun, 2 * static_cast<std::size_t>(maxSlots), 1});
+
+        Finn::vector<T> input(elementsPerSample * maxBatch * batchesPerRun);
+        for (std::size_t i = 0; i < input.size(); ++i) {
+            input[i] = samples[i % samples.size()];
+        }
+        Finn::vector<V> output(driver.getOutputElementsPerSample() * maxBatch * batchesPerRun);
+        if (driver.getMaxBatchSize() < maxBatch) {
+            driver.setMaxBatchSize(maxBatch);
+        }
+
+        AutotuneResult result;
+        for (unsigned int slots : options.bufferSlots) {
+            for (unsigned int threads : options.hostThreads) {
+                for (unsigned int batchSize : batchSizes) {
+                    AutotuneCandidate candidate;
+                    candidate.tuning.batchSize = batchSize;
+                    candidate.tuning.hostThreads = threads;
+                    candidate.tuning.bufferSlots = slots;
+                    candidate.tuning.latencyBound = options.latencyBound;
+                    driver.applyTuning(candidate.tuning);
+
+                    const auto inputEnd = input.begin() + static_cast<std::ptrdiff_t>(elementsPerSample * batchSize * batchesPerRun);
+                    auto run = [&]() {
+                        const auto start = std::chrono::steady_clock::now();
+                        driver.inferSynchronousPipelined(input.begin(), inputEnd, std::span<V>(output), driver.getDefaultInputDeviceIndex(), driver.getDefaultInputKernelName(),
+                                                         driver.getDefaultOutputDeviceIndex(), driver.getDefaultOutputKernelName());
+                        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+                    };
+                    for (std::size_t i = 0; i < options.warmup; ++i) {
+                        run();
+                    }
+
+                    const double depth = static_cast<double>(std::min<std::size_t>(slots, batchesPerRun));
+                    std::vector<double> latencies;
+                    double total = 0;
+                    const auto deadline = std::chrono::steady_clock::now() + options.measureTime;
+                    while (latencies.size() < options.minRuns || std::chrono::steady_clock::now() < deadline) {
+                        const double runTime = run();
+                        total += runTime;
+                        latencies.push_back(runTime / static_cast<double>(batchesPerRun) * depth);
+                    }
+                    constexpr double usPerSecond = 1e6;
+                    candidate.tuning.throughput = (total > 0) ? static_cast<double>(latencies.size() * batchesPerRun * batchSize) / (total / usPerSecond) : 0;
+                    candidate.tuning.latencyP99 = SampleStatistics::compute(latencies).p99;
+                    candidate.feasible = options.latencyBound <= 0 || candidate.tuning.latencyP99 <= options.latencyBound;
+                    result.candidates.push_back(candidate);
+                    if (candidate.feasible && (!result.best || candidate.tuning.throughput > result.best->throughput)) {
+                        result.best = candidate.tuning;
+                    }
+                    if (!candidate.feasible) {
+                        break;
+                    }
+                }
+            }
+        }
+        if (result.best) {
+            driver.applyTuning(*result.best);
+        }
+        return result;
+    }
+}  // namespace Finn
+
+#endif  // AUTOTUNER
@@ -18,21 +18,48 @@
 #include <FINNCppDriver/utils/Logger.h>
 #include <FINNCppDriver/utils/Types.h>
 
+#include <FINNCppDriver/core/AsyncInference.hpp>
+#include <FINNCppDriver/core/DeviceBuffer/SyncDeviceBuffers.hpp>
+#include <FINNCppDriver/core/DeviceWatchdog.hpp>
 #include <FINNCppDriver/utils/DataPacking.hpp>
-#include <FINNCppDriver/utils/DynamicMdSpan.hpp>
+#include <FINNCppDriver/utils/DeviceMetrics.hpp>
 #include <FINNCppDriver/utils/FinnDatatypes.hpp>
+#include <FINNCppDriver/utils/InputLayout.hpp>
+#include <FINNCppDriver/utils/Instrumentation.hpp>
+#include <FINNCppDriver/utils/MemoryArena.hpp>
+#include <FINNCppDriver/utils/MemoryBudget.hpp>
+#include <FINNCppDriver/utils/Postprocessing.hpp>
+#include <FINNCppDriver/utils/ResultCache.hpp>
+#include <FINNCppDriver/utils/StaticShapes.hpp>
+#include <FINNCppDriver/utils/ThreadPool.hpp>
+#include <FINNCppDriver/utils/TrafficLog.hpp>
+#include <FINNCppDriver/utils/TransferPlan.h>
 #include <FINNCppDriver/utils/join.hpp>
+#include <algorithm>
+#include <atomic>
 #include <bitset>
 #include <cinttypes>  // for uint8_t
+#include <exception>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <iterator>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "Accelerator.h"
 #include "ert.h"
-#include "omp.h"
 
 
 namespace Finn {
@@ -43,10 +70,38 @@ namespace Finn {
      * @tparam F The FINN input datatype
      * @tparam S The FINN output datatype
      * @tparam T The C-datatype used to pass data to the FPGA
+     * @tparam InputShape StaticBufferShape of the default input if the shapes are known at compile time, @see FinnDriverUsedShapes.h.in
+     * @tparam OutputShape StaticBufferShape of the default output if the shapes are known at compile time
      */
-    template<bool SynchronousInference, IsDatatype F, IsDatatype S, typename T = uint8_t>
+    template<bool SynchronousInference, IsDatatype F, IsDatatype S, typename T = uint8_t, typename InputShape = DynamicBufferShape, typename OutputShape = DynamicBufferShape>
     class BaseDriver {
+        static_assert(InputShape::template fits<F>(), "The static input shape does not fit the bitwidth of the input datatype!");
+        static_assert(OutputShape::template fits<S>(), "The static output shape does not fit the bitwidth of the output datatype!");
+
          private:
+        /**
+         * @brief Packs inputs and unpacks outputs. Shared with the unpacking of asynchronous results, which keep the pool they were submitted with.
+         *
+         */
+        std::shared_ptr<ThreadPool> hostPool = std::make_shared<ThreadPool>();
+        /**
+         * @brief Requests of inferAsync waiting for their results, per output (device index, kernel name). Declared before the accelerator, so the worker threads
+         * that deliver into them are stopped before the queues are destroyed.
+         *
+         */
+        std::map<std::pair<uint, std::string>, std::unique_ptr<AsyncCompletionQueue>> completionQueues;
+        /**
+         * @brief Guards completionQueues and asyncStoreMutexes. Only held for lookups and never while waiting for space in a ring buffer, so getAsyncInFlight and
+         * submissions to other inputs do not wait for a full ring.
+         *
+         */
+        std::unique_ptr<std::mutex> asyncSubmitMutex = std::make_unique<std::mutex>();
+        /**
+         * @brief Serializes inferAsync submissions per input (device index, kernel name) from registering the request to storing its input, so the order of the
+         * completion queue matches the order of the stored inputs. Never taken by the worker threads, which keep draining the ring while a submission waits for space.
+         *
+         */
+        std::map<std::pair<uint, std::string>, std::unique_ptr<std::mutex>> asyncStoreMutexes;
         Accelerator accelerator;
         Config configuration;
         logger_type& logger = Logger::getLogger();
@@ -56,7 +111,101 @@ namespace Finn {
         uint defaultOutputDeviceIndex = 0;
         std::string defaultOutputKernelName;
         uint batchElements = 1;
+        uint maxBatchElements = 1;
         bool forceAchieval = false;
+        uint bufferSlots = 1;
+        /**
+         * @brief Host memory budget in bytes, 0 if unbounded. @see setMemoryBudget
+         *
+         */
+        std::size_t memoryBudget = 0;
+        MEMORY_POLICY memoryPolicy = MEMORY_POLICY::FAIL;
+        /**
+         * @brief Changed whenever the buffers or transfer plans are rebuilt, so that prepared sessions can detect that their handles are stale
+         *
+         */
+        std::size_t sessionGeneration = 0;
+
+        /**
+         * @brief Generation prepared sessions are checked against. Recoveries free the buffers without going through the driver, e.g. from the watchdog, so they are
+         * counted in as well. Both counters only grow, so any change of either one changes the sum.
+         *
+         * @return std::size_t
+         */
+        std::size_t currentGeneration() const { return sessionGeneration + static_cast<std::size_t>(accelerator.getRecoveries()); }
+
+        /**
+         * @brief Transfer plans of the inputs and outputs used so far, indexed by device index and kernel name
+         *
+         */
+        using PlanCache = std::map<uint, std::map<std::string, TransferPlan, std::less<>>>;
+        /**
+         * @brief Transfer plans of every batch size used so far, indexed by batch size. Kept when the batch size changes, so that switching between batch sizes per
+         * inference does not rebuild them.
+         *
+         */
+        std::map<uint, PlanCache> inputPlans;
+        std::map<uint, PlanCache> outputPlans;
+        /**
+         * @brief Host layouts of the inputs that are not given in their normal shape, indexed by device index and kernel name. Attached to the transfer plans of these inputs.
+         *
+         */
+        std::map<uint, std::map<std::string, std::shared_ptr<const InputLayout>, std::less<>>> inputLayouts;
+
+        /**
+         * @brief Default input and output of a device that batches are scheduled to. The plans point into inputPlans and outputPlans.
+         *
+         */
+        struct ScheduledDevice {
+            uint deviceIndex = 0;
+            std::string inputKernelName;
+            std::string outputKernelName;
+            const TransferPlan* inputPlan = nullptr;
+            const TransferPlan* outputPlan = nullptr;
+        };
+        /**
+         * @brief Scheduling targets in the order of Config::deviceWrappers (and thus of the accelerator's devices). Built up front, so scheduled inferences only read shared state.
+         *
+         */
+        std::vector<ScheduledDevice> scheduledDevices;
+
+        /**
+         * @brief One device of a model parallel pipeline: the input it consumes and the output it produces
+         *
+         */
+        struct PipelineStage {
+            uint deviceIndex = 0;
+            std::string inputKernelName;
+            std::string outputKernelName;
+        };
+        /**
+         * @brief Stages of the model parallel pipeline described by the producer links in the config, in execution order. Empty if the config has no links.
+         *
+         */
+        std::vector<PipelineStage> pipelineStages;
+
+        /**
+         * @brief Periodic export of the device metrics, empty if none is running. Declared after the accelerator, so it is stopped before the devices are destroyed.
+         *
+         */
+        std::unique_ptr<MetricsExporter> metricsExporter;
+        /**
+         * @brief Recovery of stuck devices, empty if none is running. Declared after the accelerator, so it is stopped before the devices are destroyed.
+         *
+         */
+        std::unique_ptr<DeviceWatchdog> watchdog;
+        // Kept behind a pointer so the driver stays movable
+        std::unique_ptr<TrafficRecorder> trafficRecorder;
+        /**
+         * @brief Cached results of single samples, empty unless enableResultCache was called. @see runCached
+         *
+         */
+        std::unique_ptr<ResultCache> resultCache;
+        /**
+         * @brief Packed results of a batch that was served partly from the result cache
+         *
+         */
+        std::vector<uint8_t> cachedResults;
 
         /**
          * @brief A logger prefix to determine the source of a log write
@@ -84,6 +233,12 @@ namespace Finn {
             defaultOutputDeviceIndex = configuration.deviceWrappers[0].xrtDeviceIndex;
             defaultOutputKernelName = configuration.deviceWrappers[0].odmas[0]->kernelName;
             batchElements = batchSize;
+            maxBatchElements = batchSize;
+            ++sessionGeneration;
+            placeHostPool();
+            validateStaticShapes();
+            prepareScheduledDevices();
+            preparePipeline();
 #ifdef UNITTEST
             logDriver();
 #endif
@@ -193,254 +348,2266 @@ namespace Finn {
          *
          * @param kernelName
          */
-        void setDefaultOutputKernelName(const std::string& kernelName) { defaultInputKernelName = kernelName; }
+        void setDefaultOutputKernelName(const std::string& kernelName) { defaultOutputKernelName = kernelName; }
 
         /**
-         * @brief Set the Batch Size
+         * @brief Get the Default Input Device Index
          *
-         * @param elements
+         * @return uint
          */
-        void setBatchSize(uint elements) {
-            batchElements = elements;
-            accelerator.setBatchSize(batchElements);
-        }
+        uint getDefaultInputDeviceIndex() const { return defaultInputDeviceIndex; }
 
         /**
-         * @brief Get the Batch Size
+         * @brief Get the Default Output Device Index
          *
-         * @return Returns the Batch size
+         * @return uint
          */
-        uint getBatchSize() { return batchElements; }
+        uint getDefaultOutputDeviceIndex() const { return defaultOutputDeviceIndex; }
 
         /**
-         * @brief Set the Force Achieval
+         * @brief Get the Default Input Kernel Name
          *
-         * @param force
+         * @return const std::string&
          */
-        void setForceAchieval(bool force) { forceAchieval = force; }
+        const std::string& getDefaultInputKernelName() const { return defaultInputKernelName; }
 
         /**
-         * @brief Get the Config object. Simple getter to check things outside the driver
+         * @brief Get the Default Output Kernel Name
          *
-         * @return Config
+         * @return const std::string&
          */
-        Config getConfig() const { return configuration; }
+        const std::string& getDefaultOutputKernelName() const { return defaultOutputKernelName; }
 
         /**
-         * @brief Get the Device object, specified by its index
+         * @brief Number of (folded) input elements of one batch element on the default input
          *
-         * @param index
-         * @return DeviceHandler&
+         * @return std::size_t
          */
-        DeviceHandler& getDeviceHandler(uint index) { return accelerator.getDeviceHandler(index); }
+        std::size_t getInputElementsPerSample() const {
+            const auto& foldedShape = findInputDescriptor(defaultInputDeviceIndex, defaultInputKernelName)->foldedShape;
+            return foldedShape.empty() ? 0 : FinnUtils::shapeToElements(foldedShape) / std::max<std::size_t>(foldedShape.front(), 1);
+        }
 
         /**
-         * @brief Get a specific buffer object specified by its name and the device it is on
+         * @brief Number of (folded) output elements of one batch element on the default output
          *
-         * @param deviceIndex
-         * @param bufferName
-         * @return DeviceInputBuffer<uint8_t>
+         * @return std::size_t
          */
-        std::shared_ptr<DeviceInputBuffer<uint8_t>> getInputBuffer(uint deviceIndex, const std::string& bufferName) { return getDeviceHandler(deviceIndex).getInputBuffer(bufferName); }
+        std::size_t getOutputElementsPerSample() const {
+            const auto& foldedShape = findOutputDescriptor(defaultOutputDeviceIndex, defaultOutputKernelName)->foldedShape;
+            return foldedShape.empty() ? 0 : FinnUtils::shapeToElements(foldedShape) / std::max<std::size_t>(foldedShape.front(), 1);
+        }
 
         /**
-         * @brief Return the size (type specified by SIZE_SPECIFIER) at the given device at the given buffer
+         * @brief Set the Batch Size. For synchronous inference this is cheap as long as elements does not exceed the maximum batch size (@see setMaxBatchSize):
+         * the buffers are not reallocated, only the valid part is transferred and the kernels are told to process fewer repetitions.
          *
-         * @param ss
-         * @param deviceIndex
-         * @param bufferName
-         * @return size_t
+         * @param elements
          */
-        size_t size(SIZE_SPECIFIER ss, uint deviceIndex, const std::string& bufferName) { return accelerator.size(ss, deviceIndex, bufferName); }
-
+        void setBatchSize(uint elements) {
+            if (elements == batchElements) {
+                return;
+            }
+            // Asynchronous buffers are always reallocated for the new batch size
+            const uint newMaxBatch = SynchronousInference ? std::max(maxBatchElements, elements) : elements;
+            if (newMaxBatch != maxBatchElements) {
+                fitBuffersToBudget(newMaxBatch);
+            }
+            batchElements = elements;
+            maxBatchElements = newMaxBatch;
+            accelerator.setBatchSize(batchElements);
+            ++sessionGeneration;
+            prepareScheduledDevices();
+        }
 
         /**
-         * @brief Store input into the driver for asynchronous inference
+         * @brief Allocate all device buffers for the given number of batch elements once, so that any smaller batch size can be set per inference without reallocation.
+         * Reinitializes all buffers! The current batch size is reduced if it exceeds the new maximum.
          *
-         * @tparam IteratorType
-         * @param first
-         * @param last
-         * @param inputDeviceIndex FPGA device to be used for inference
-         * @param inputBufferKernelName Identifier of the input kernel
-         * @param batchSize Batch size contained in the input
+         * @param elements
          */
-        template<typename IteratorType, typename = std::enable_if<!SynchronousInference>>
-        void input(IteratorType first, IteratorType last, uint inputDeviceIndex, const std::string& inputBufferKernelName, uint batchSize) {
-            FINN_LOG_DEBUG(logger, loglevel::info) << loggerPrefix() << "Store data for asynchronous inference.";
-            auto packed = Finn::pack<F>(first, last);
-            auto storeFunc = accelerator.storeFactory(inputDeviceIndex, inputBufferKernelName);
-
-            if (std::abs(std::distance(packed.begin(), packed.end())) != size(SIZE_SPECIFIER::FEATUREMAP_SIZE, inputDeviceIndex, inputBufferKernelName) * batchSize) {
-                FinnUtils::logAndError<std::runtime_error>("Input length (" + std::to_string(std::abs(std::distance(packed.begin(), packed.end()))) + ") does not match up with batches*inputsize_per_batch (" +
-                                                           std::to_string(size(SIZE_SPECIFIER::FEATUREMAP_SIZE, inputDeviceIndex, inputBufferKernelName)) + "*" + std::to_string(batchSize) + "=" +
-                                                           std::to_string(size(SIZE_SPECIFIER::FEATUREMAP_SIZE, inputDeviceIndex, inputBufferKernelName) * batchSize) + ")");
+        void setMaxBatchSize(uint elements) {
+            fitBuffersToBudget(elements);
+            accelerator.setMaxBatchSize(elements);
+            maxBatchElements = elements;
+            ++sessionGeneration;
+            if (batchElements > elements) {
+                setBatchSize(elements);
             }
-
-            storeFunc(packed.begin(), packed.end());
         }
 
         /**
-         * @brief Store input into the driver for asynchronous inference
+         * @brief Get the batch size the device buffers are allocated for
          *
-         * @tparam IteratorType
-         * @tparam typename
-         * @param first
-         * @param last
+         * @return uint
          */
-        template<typename IteratorType, typename = std::enable_if<!SynchronousInference>>
-        void input(IteratorType first, IteratorType last) {
-            input(first, last, defaultInputDeviceIndex, defaultInputKernelName, batchElements);
-        }
+        uint getMaxBatchSize() const { return maxBatchElements; }
 
         /**
-         * @brief Get the results of a asynchronous inference
+         * @brief Allocate the device buffers of all devices now. Otherwise they are allocated on first use, so that the first inference pays for the allocation.
          *
-         * @tparam V
-         * @param outputDeviceIndex FPGA device from which data should be received
-         * @param outputBufferKernelName Identifier of the output kernel
-         * @param forceArchival Should data be explicitly polled?
-         * @return Finn::vector<V>
          */
-        template<typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<!SynchronousInference>>
-        [[nodiscard]] Finn::vector<V> getResults(uint outputDeviceIndex, const std::string& outputBufferKernelName, bool forceArchival) {
-            // TODO(linusjun): maybe this method should block until data is available?
-            auto result = accelerator.getOutputData(outputDeviceIndex, outputBufferKernelName, forceArchival);
-            return unpack<S, V>(result);
+        void allocateBuffers() { accelerator.allocateBuffers(); }
+
+        /**
+         * @brief Set the number of XRT buffer objects every synchronous DeviceBuffer rotates between. Values larger than one enable pipelining in inferSynchronousPipelined. Reinitializes all buffers!
+         * With a memory budget and MEMORY_POLICY::DEGRADE fewer slots may be set, @see getBufferSlots.
+         *
+         * @param slots
+         */
+        void setBufferSlots(uint slots) {
+            slots = fitMemoryBudget(memoryDemands(), maxBatchElements, slots);
+            accelerator.setBufferSlots(slots);
+            bufferSlots = slots;
+            ++sessionGeneration;
         }
 
         /**
-         * @brief Get the results of a asynchronous inference
+         * @brief Apply settings found by the autotune mode. Buffers are only reinitialized if the batch size exceeds the allocated one or the number of buffer slots
+         * changes. The host threads stay pinned to the CPUs local to the device for AFFINITY_POLICY::DEVICE_LOCAL.
          *
-         * @tparam V
-         * @tparam typename
-         * @return Finn::vector<V>
+         * @param tuning
+         * @param withBatchSize Also apply the batch size. False keeps the batch size the driver was created with, e.g. if it was given explicitly.
          */
-        template<typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<!SynchronousInference>>
-        [[nodiscard]] Finn::vector<V> getResults() {
-            // TODO(linusjun): maybe this method should block until data is available?
-            auto result = accelerator.getOutputData(defaultOutputDeviceIndex, defaultOutputKernelName, forceAchieval);
-            return unpack<S, V>(result);
+        void applyTuning(const DriverTuning& tuning, bool withBatchSize = true) {
+            if (tuning.batchSize == 0 || tuning.bufferSlots == 0) {
+                FinnUtils::logAndError<std::invalid_argument>("A tuning needs a batch size and a number of buffer slots of at least 1!");
+            }
+            if (tuning.bufferSlots != bufferSlots) {
+                setBufferSlots(tuning.bufferSlots);
+            }
+            if (withBatchSize) {
+                if (SynchronousInference && tuning.batchSize > maxBatchElements) {
+                    setMaxBatchSize(tuning.batchSize);
+                }
+                setBatchSize(tuning.batchSize);
+            }
+            if (tuning.hostThreads > 0 && tuning.hostThreads != hostPool->size()) {
+                setHostThreadPool(tuning.hostThreads, accelerator.getDeviceHandler(defaultInputDeviceIndex).getLocalCpus());
+            }
+            FINN_LOG(logger, loglevel::info) << loggerPrefix() << "Applied tuning: batch size " << batchElements << ", " << hostPool->size() << " host threads, " << bufferSlots << " buffer slots";
         }
 
         /**
-         * @brief Implements the synchronous inference operation
+         * @brief Get the tuning stored with the first device of the config, if any
          *
-         * @tparam IteratorType
-         * @tparam V Return datatype, usually automatically determined
-         * @tparam typename
-         * @param first Iterator to first element of input
-         * @param last  Iterator to end of input
-         * @param inputDeviceIndex index of input FPGA
-         * @param inputBufferKernelName name of input kernel
-         * @param outputDeviceIndex index of output FPGA
-         * @param outputBufferKernelName name of output kernel
-         * @param forceArchival
-         * @return Finn::vector<V>
+         * @return std::optional<DriverTuning>
          */
-        template<typename IteratorType, typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<SynchronousInference>>
-        [[nodiscard]] Finn::vector<V> inferSynchronous(IteratorType first, IteratorType last, uint inputDeviceIndex, const std::string& inputBufferKernelName, uint outputDeviceIndex, const std::string& outputBufferKernelName,
-                                                       bool forceArchival) {
-            using IterValueType = typename std::iterator_traits<IteratorType>::value_type;
-            static auto foldedShape = static_cast<Finn::ExtendedBufferDescriptor*>(configuration.deviceWrappers[inputDeviceIndex].idmas[0].get())->foldedShape;
-            foldedShape[0] = batchElements;
-            const Finn::DynamicMdSpan reshapedInput(first, last, foldedShape);
+        std::optional<DriverTuning> getConfiguredTuning() const { return configuration.deviceWrappers.empty() ? std::nullopt : configuration.deviceWrappers[0].tuning; }
 
-            auto packed = Finn::packMultiDimensionalInputs<F, IteratorType>(first, last, reshapedInput, foldedShape.back());
+        /**
+         * @brief Set the strategy used to wait for kernel completion on all devices. Overrides the waitPolicy given in the config.
+         *
+         * @param policy WAIT_POLICY::SPIN (lowest latency, occupies a core), WAIT_POLICY::SPIN_YIELD (spins for spinBudget polls, then yields) or WAIT_POLICY::INTERRUPT (blocks on the IP interrupt)
+         * @param spinBudget Number of polls before yielding (only used by WAIT_POLICY::SPIN_YIELD)
+         */
+        void setWaitPolicy(WAIT_POLICY policy, unsigned int spinBudget = defaultSpinBudget) { accelerator.setWaitPolicy(policy, spinBudget); }
 
-            auto result = infer(packed.begin(), packed.end(), inputDeviceIndex, inputBufferKernelName, outputDeviceIndex, outputBufferKernelName, batchElements, forceArchival);
+        /**
+         * @brief Bound the time every synchronous kernel run may take on all devices. Overrides the executeTimeoutMs given in the config. A run that misses it fails with
+         * a KernelTimeoutError instead of hanging, and its device is stuck until it was recovered (@see recoverStuckDevices, startWatchdog). The scheduled inference
+         * functions run a batch that timed out again on another device.
+         *
+         * @param timeout 0 to wait forever
+         */
+        void setExecuteTimeout(std::chrono::microseconds timeout) { accelerator.setExecuteTimeout(timeout); }
 
-            static auto packedOutput = configuration.deviceWrappers[inputDeviceIndex].odmas[0]->packedShape;
-            packedOutput[0] = batchElements;
-            static auto foldedOutput = static_cast<Finn::ExtendedBufferDescriptor*>(configuration.deviceWrappers[inputDeviceIndex].odmas[0].get())->foldedShape;
-            foldedOutput[0] = batchElements;
-            const Finn::DynamicMdSpan reshapedOutput(result.begin(), result.end(), packedOutput);
-            auto unpacked = Finn::unpackMultiDimensionalOutputs<S, Finn::vector<uint8_t>::iterator, false, V>(result.begin(), result.end(), reshapedOutput, foldedOutput);
+        /**
+         * @brief Reprogram all devices that are stuck after a kernel timeout, so they can run again. Meant for the thread that drives the driver, e.g. after it caught a
+         * KernelTimeoutError. Devices with leases out (@see inferSynchronousScheduled) are skipped.
+         *
+         * @return std::size_t Number of recovered devices
+         */
+        std::size_t recoverStuckDevices() { return accelerator.recoverStuckDevices(); }
 
-            return unpacked;
+        /**
+         * @brief Recover stuck devices from a background thread until stopWatchdog is called, @see DeviceWatchdog. Replaces a running watchdog.
+         * @attention Only use this together with the scheduled inference functions (inferSynchronousScheduled, inferSynchronousReplicated and
+         * inferSynchronousDataParallel). The driver must not be moved while the watchdog is running.
+         *
+         * @param interval Time between two checks for stuck devices
+         */
+        void startWatchdog(std::chrono::milliseconds interval) {
+            stopWatchdog();
+            watchdog = std::make_unique<DeviceWatchdog>(accelerator, interval);
         }
 
         /**
-         * @brief Implements the synchronous inference operation
+         * @brief Stop the watchdog, if one is running
          *
-         * @tparam IteratorType
-         * @tparam V
-         * @tparam typename
-         * @param first
-         * @param last
-         * @return Finn::vector<V>
          */
-        template<typename IteratorType, typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<SynchronousInference>>
-        [[nodiscard]] Finn::vector<V> inferSynchronous(IteratorType first, IteratorType last) {
-            return inferSynchronous(first, last, defaultInputDeviceIndex, defaultInputKernelName, defaultOutputDeviceIndex, defaultOutputKernelName, forceAchieval);
-        }
+        void stopWatchdog() { watchdog.reset(); }
 
         /**
-         * @brief Implements the synchronous inference operation
+         * @brief Set the memory cap for results that asynchronous output buffers keep until they are retrieved with getResults. Overrides the archiveCapacity given in
+         * the config. While an output buffer is at its cap, it stops reading from the device, so the accelerator stalls instead of the host memory growing.
+         * With a memory budget the cap is checked against it first, and reduced to the memory that is left with MEMORY_POLICY::DEGRADE.
          *
-         * @tparam U
-         * @tparam V
-         * @tparam typename
-         * @param data
-         * @param inputDeviceIndex
-         * @param inputBufferKernelName
-         * @param outputDeviceIndex
-         * @param outputBufferKernelName
-         * @param forceArchival
-         * @return Finn::vector<V>
+         * @param bytes 0 removes the cap, or with a memory budget limits the archives to the memory that is left
          */
-        template<typename U, typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<SynchronousInference>>
-        [[nodiscard]] Finn::vector<V> inferSynchronous(const Finn::vector<U>& data, uint inputDeviceIndex, const std::string& inputBufferKernelName, uint outputDeviceIndex, const std::string& outputBufferKernelName, bool forceArchival) {
-            return inferSynchronous(data.begin(), data.end(), inputDeviceIndex, inputBufferKernelName, outputDeviceIndex, outputBufferKernelName, batchElements, forceArchival);
+        void setArchiveCapacity(std::size_t bytes) {
+            auto demands = memoryDemands();
+            for (auto&& demand : demands) {
+                demand.archiveCapacity = bytes;
+            }
+            // Checked before anything is changed, so a rejected cap leaves the driver as it was
+            fitMemoryBudget(demands, maxBatchElements, bufferSlots);
+            for (auto&& devWrap : configuration.deviceWrappers) {
+                devWrap.archiveCapacity = bytes;
+            }
+            if (memoryBudget == 0) {
+                accelerator.setArchiveCapacity(bytes);
+            }
         }
 
         /**
-         * @brief Implements the synchronous inference operation
+         * @brief Limit the host memory of the driver: the buffer objects, ring buffers and archives of all devices plus the staging memory of asynchronous requests.
+         * Settings that do not fit are rejected before anything is allocated (MEMORY_POLICY::FAIL), or first cost buffer slots and then archive capacity
+         * (MEMORY_POLICY::DEGRADE). Unbounded archives are capped to the memory that is left. The batch size is never reduced. Applies to the current settings right
+         * away and to every later change of the batch size, buffer slots or archive capacity.
          *
-         * @tparam U
-         * @tparam V
-         * @tparam typename
-         * @param data
-         * @return Finn::vector<V>
+         * @param bytes Budget in bytes, 0 removes the budget (archive caps set by it stay in place)
+         * @param policy
          */
-        template<typename U, typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<SynchronousInference>>
-        [[nodiscard]] Finn::vector<V> inferSynchronous(const Finn::vector<U>& data) {
-            return inferSynchronous(data, defaultInputDeviceIndex, defaultInputKernelName, defaultOutputDeviceIndex, defaultOutputKernelName, batchElements, forceAchieval);
+        void setMemoryBudget(std::size_t bytes, MEMORY_POLICY policy = MEMORY_POLICY::FAIL) {
+            if (policy == MEMORY_POLICY::INVALID) {
+                FinnUtils::logAndError<std::invalid_argument>("Invalid memory policy!");
+            }
+            const auto previousBudget = memoryBudget;
+            const auto previousPolicy = memoryPolicy;
+            memoryBudget = bytes;
+            memoryPolicy = policy;
+            try {
+                fitBuffersToBudget(maxBatchElements);
+            } catch (...) {
+                memoryBudget = previousBudget;
+                memoryPolicy = previousPolicy;
+                throw;
+            }
         }
 
+        /**
+         * @brief Get the host memory budget in bytes, 0 if unbounded
+         *
+         * @return std::size_t
+         */
+        std::size_t getMemoryBudget() const { return memoryBudget; }
 
-         protected:
         /**
+         * @brief Get the host memory the buffers of all devices currently hold. Buffers that are not allocated yet are not part of it.
          *
-         * @brief Do an inference with the given data. This assumes already flattened data in uint8_t's. Specify inputs and outputs.
+         * @return MemoryFootprint
+         */
+        MemoryFootprint getMemoryFootprint() const { return {accelerator.getMemoryFootprint(), stagingBytes(maxBatchElements), memoryBudget}; }
+
+        /**
+         * @brief Get the host memory the current settings need at most, including buffers that are not allocated yet
          *
-         * @param first Iterator to first element in input sequence
-         * @param last  Iterator to last element in input sequence
-         * @param inputDeviceIndex
-         * @param inputBufferKernelName
-         * @param outputDeviceIndex
-         * @param outputBufferKernelName
-         * @param batchSize
-         * @param forceArchival If true, the data gets written to LTS either way, ensuring that there is data to be read!
-         * @return Finn::vector<uint8_t>
+         * @return MemoryPlan
          */
-        template<typename IteratorType>
-        [[nodiscard]] Finn::vector<uint8_t> infer(IteratorType first, IteratorType last, uint inputDeviceIndex, const std::string& inputBufferKernelName, uint outputDeviceIndex, const std::string& outputBufferKernelName, uint batchSize,
-                                                  bool forceArchival) {
-            const auto start = std::chrono::high_resolution_clock::now();
-            FINN_LOG_DEBUG(logger, loglevel::info) << loggerPrefix() << "Starting inference (raw data)";
-            auto storeFunc = accelerator.storeFactory(inputDeviceIndex, inputBufferKernelName);
+        MemoryPlan getMemoryPlan() const { return planMemory(memoryDemands(), maxBatchElements, bufferSlots, stagingBytes(maxBatchElements), memoryBudget, memoryPolicy); }
 
-            if (std::abs(std::distance(first, last)) != size(SIZE_SPECIFIER::TOTAL_DATA_SIZE, inputDeviceIndex, inputBufferKernelName)) {
-                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " Input length (" + std::to_string(std::abs(std::distance(first, last))) + ") does not match up with batches*inputsize_per_batch (" +
-                                                           std::to_string(size(SIZE_SPECIFIER::FEATUREMAP_SIZE, inputDeviceIndex, inputBufferKernelName)) + "*" + std::to_string(batchSize) + "=" +
-                                                           std::to_string(size(SIZE_SPECIFIER::TOTAL_DATA_SIZE, inputDeviceIndex, inputBufferKernelName)) + ")");
-            }
-            const auto end = std::chrono::high_resolution_clock::now();
+        /**
+         * @brief Get the latency distribution of an inference stage, merged over all threads. Samples are only recorded if the driver was built with
+         * FINN_ENABLE_INSTRUMENTATION, otherwise the summary is empty.
+         * @note The samples are shared by all drivers of the process.
+         *
+         * @param stage
+         * @return LatencySummary Count, mean, p50, p99, p999 and max in nanoseconds
+         */
+        LatencySummary getStageLatency(STAGE stage) const { return LatencyRecorder::global().summary(stage); }
 
-            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
-            std::cout << "preamble infer took " << ns << " ns\n";
+        /**
+         * @brief Get a table of the latency distributions of all stages with samples. @see getStageLatency
+         *
+         * @return std::string
+         */
+        std::string getLatencyReport() const { return LatencyRecorder::global().report(); }
 
-            bool stored = storeFunc(first, last);
+        /**
+         * @brief Drop all recorded stage latencies
+         *
+         */
+        void resetLatencyStatistics() { LatencyRecorder::global().reset(); }
+
+        /**
+         * @brief Log the latency report periodically from a background thread until stopLatencyDump is called
+         *
+         * @param interval
+         */
+        void startLatencyDump(std::chrono::milliseconds interval) { LatencyRecorder::global().startPeriodicDump(interval); }
+
+        /**
+         * @brief Stop the periodic latency report
+         *
+         */
+        void stopLatencyDump() { LatencyRecorder::global().stopPeriodicDump(); }
+
+        /**
+         * @brief Record the inference stages of every thread and the kernel runs of every compute unit on a timeline from now on. Drops earlier events. Spans are only
+         * recorded if the driver was built with FINN_ENABLE_INSTRUMENTATION.
+         * @note The timeline is shared by all drivers of the process.
+         *
+         * @param eventsPerThread Every thread keeps this many of its latest events
+         */
+        void startTimeline(std::size_t eventsPerThread = defaultTimelineCapacity) { TimelineTracer::global().enable(eventsPerThread); }
+
+        /**
+         * @brief Stop recording the timeline. The events are kept until the next startTimeline.
+         *
+         */
+        void stopTimeline() { TimelineTracer::global().disable(); }
+
+        /**
+         * @brief Write the recorded timeline in the Chrome trace format, which chrome://tracing and ui.perfetto.dev open. Can be called while the timeline is recorded.
+         *
+         * @param path
+         */
+        void writeTimeline(const std::filesystem::path& path) const { TimelineTracer::global().writeChromeTrace(path); }
+
+        /**
+         * @brief Get the bytes moved, transfer times, kernel busy times and run counts of every idma and odma, and the utilisation of every device since the last reset.
+         * Unlike the stage latencies, these are always counted.
+         *
+         * @return std::vector<DeviceMetricsSnapshot> One entry per device, in the order of Config::deviceWrappers
+         */
+        std::vector<DeviceMetricsSnapshot> getDeviceMetrics() const { return accelerator.getMetrics(); }
+
+        /**
+         * @brief Reset the device metrics. Must not be called while they are exported or read by another thread.
+         *
+         */
+        void resetDeviceMetrics() { accelerator.resetMetrics(); }
+
+        /**
+         * @brief Hand the device metrics to a sink periodically from a background thread until stopMetricsExport is called. Replaces a running export.
+         * @attention The driver must not be moved while the export is running.
+         *
+         * @param interval
+         * @param sink Empty to log the metrics as a table
+         */
+        void startMetricsExport(std::chrono::milliseconds interval, MetricsExporter::sink_t sink = {}) {
+            stopMetricsExport();
+            metricsExporter = std::make_unique<MetricsExporter>(interval, [this]() { return getDeviceMetrics(); }, std::move(sink));
+        }
+
+        /**
+         * @brief Stop the periodic metrics export, if one is running
+         *
+         */
+        void stopMetricsExport() { metricsExporter.reset(); }
+
+        /**
+         * @brief Record every following inference request (time, batch size and optionally the packed input) into a traffic log, which the replay mode of the driver
+         * can play back. Replaces a running capture.
+         * @attention Must not be called while other threads run inferences.
+         *
+         * @param path
+         * @param recordInputs Also store the packed inputs. Makes the log as large as the traffic, but the replay then runs on the recorded data.
+         */
+        void startCapture(const std::filesystem::path& path, bool recordInputs) {
+            stopCapture();
+            trafficRecorder = std::make_unique<TrafficRecorder>(path, recordInputs);
+            FINN_LOG(logger, loglevel::info) << loggerPrefix() << "Capturing inference requests to " << path.string();
+        }
+
+        /**
+         * @brief Stop a running capture and close its log
+         * @attention Must not be called while other threads run inferences.
+         *
+         * @return std::size_t Number of recorded requests
+         */
+        std::size_t stopCapture() {
+            if (!trafficRecorder) {
+                return 0;
+            }
+            const std::size_t recorded = trafficRecorder->count();
+            trafficRecorder.reset();
+            return recorded;
+        }
+
+        /**
+         * @brief Record a request into the running capture. Called for every batch the driver packs, and by users that fill the mapped input buffer themselves before runPrepacked.
+         *
+         * @param samples Batch size of the request
+         * @param packedInput Packed input of the request
+         */
+        void recordRequest(std::size_t samples, std::span<const uint8_t> packedInput) {
+            if (trafficRecorder) {
+                trafficRecorder->record(static_cast<std::uint32_t>(samples), packedInput);
+            }
+        }
+
+        /**
+         * @brief Declare that the host data of an input is stored in another layout than its normal shape, e.g. NCHW for an NHWC network. All inferences on this
+         * input then transpose, fold and pack it in a single pass (@see packPermutedInputs) instead of expecting a transposed copy. Rebuilds the transfer plans.
+         *
+         * @param layout Layout of one sample, its normal shape has to be the normal shape of the input without the batch dimension
+         * @param inputDeviceIndex
+         * @param inputBufferKernelName
+         */
+        void setInputLayout(const InputLayout& layout, uint inputDeviceIndex, const std::string& inputBufferKernelName) {
+            const auto* descriptor = findInputDescriptor(inputDeviceIndex, inputBufferKernelName);
+            const shape_t sampleShape(descriptor->normalShape.begin() + 1, descriptor->normalShape.end());
+            if (layout.normalShape() != sampleShape) {
+                FinnUtils::logAndError<std::invalid_argument>(loggerPrefix() + "Input layout " + FinnUtils::shapeToString(layout.sourceShape) + " permutes to " + FinnUtils::shapeToString(layout.normalShape()) +
+                                                              ", but input " + inputBufferKernelName + " has samples of normal shape " + FinnUtils::shapeToString(sampleShape) + "!");
+            }
+            inputLayouts[inputDeviceIndex][inputBufferKernelName] = std::make_shared<const InputLayout>(layout);
+            invalidatePlans();
+        }
+
+        /**
+         * @brief Declare the host layout of the default input, @see setInputLayout
+         *
+         * @param layout
+         */
+        void setInputLayout(const InputLayout& layout) { setInputLayout(layout, defaultInputDeviceIndex, defaultInputKernelName); }
+
+        /**
+         * @brief Expect the host data of an input in its normal shape again
+         *
+         * @param inputDeviceIndex
+         * @param inputBufferKernelName
+         */
+        void clearInputLayout(uint inputDeviceIndex, const std::string& inputBufferKernelName) {
+            if (auto device = inputLayouts.find(inputDeviceIndex); device != inputLayouts.end() && device->second.erase(inputBufferKernelName) > 0) {
+                invalidatePlans();
+            }
+        }
+
+        /**
+         * @brief Serve repeated samples of synchronous inferences from an LRU cache of their results instead of the device. Every sample of a batch is looked up by
+         * its packed input, and only the misses are run, compacted into a smaller batch. Replaces a running cache. Only supported for networks with a single input
+         * and output on one device, because the batch of every other buffer would not match the compacted one.
+         * @attention Only correct for accelerators whose results depend on nothing but the input of the sample.
+         *
+         * @param maxBytes Upper bound on the bytes of cached inputs and results, 0 for no bound
+         * @param maxEntries Upper bound on the number of cached samples, 0 for no bound
+         */
+        void enableResultCache(std::size_t maxBytes, std::size_t maxEntries = 0) {
+            if (maxBytes == 0 && maxEntries == 0) {
+                FinnUtils::logAndError<std::invalid_argument>(loggerPrefix() + "The result cache needs a bound on its bytes or entries!");
+            }
+            if (configuration.deviceWrappers.size() != 1 || configuration.deviceWrappers[0].idmas.size() != 1 || configuration.deviceWrappers[0].odmas.size() != 1) {
+                FinnUtils::logAndError<std::invalid_argument>(loggerPrefix() + "The result cache is only supported for networks with a single input and output on one device!");
+            }
+            resultCache = std::make_unique<ResultCache>(maxBytes, maxEntries);
+            FINN_LOG(logger, loglevel::info) << loggerPrefix() << "Caching results of up to " << maxBytes << " bytes and " << maxEntries << " samples (0 is unbounded)";
+        }
+
+        /**
+         * @brief Stop caching results and drop the cache
+         *
+         */
+        void disableResultCache() {
+            resultCache.reset();
+            cachedResults = {};
+        }
+
+        /**
+         * @brief Get the hit rate and memory of the result cache
+         *
+         * @return std::optional<ResultCacheStatistics> Empty if no cache is enabled
+         */
+        std::optional<ResultCacheStatistics> getResultCacheStatistics() const {
+            if (!resultCache) {
+                return std::nullopt;
+            }
+            return resultCache->getStatistics();
+        }
+
+        /**
+         * @brief Set the strategy used to distribute batches over the devices in inferSynchronousScheduled and inferSynchronousDataParallel
+         *
+         * @param policy SCHEDULING_POLICY::ROUND_ROBIN or SCHEDULING_POLICY::LEAST_OUTSTANDING (default)
+         */
+        void setSchedulingPolicy(SCHEDULING_POLICY policy) { accelerator.setSchedulingPolicy(policy); }
+
+        /**
+         * @brief Get the scheduling policy
+         *
+         * @return SCHEDULING_POLICY
+         */
+        SCHEDULING_POLICY getSchedulingPolicy() const { return accelerator.getSchedulingPolicy(); }
+
+        /**
+         * @brief Replace the host thread pool used to pack inputs and unpack outputs. Asynchronous results that are already submitted and registered result
+         * callbacks keep unpacking with the previous pool.
+         *
+         * @param threads Number of threads, including the thread calling the inference. 1 packs and unpacks on the calling thread.
+         * @param cpus CPUs the worker threads are pinned to. Empty to not pin them.
+         * @param grainBytes Minimum number of bytes a thread works on. Smaller inputs are processed on the calling thread only.
+         */
+        void setHostThreadPool(std::size_t threads, const std::vector<unsigned int>& cpus = {}, std::size_t grainBytes = ThreadPool::defaultGrainBytes) {
+            hostPool = std::make_shared<ThreadPool>(threads, cpus, grainBytes);
+        }
+
+        /**
+         * @brief Get the host thread pool
+         *
+         * @return ThreadPool&
+         */
+        ThreadPool& getHostThreadPool() { return *hostPool; }
+
+        /**
+         * @brief Get the kernel names of all inputs of a device, in the order of the config. This is the order of the tensors passed to inferSynchronousMultiIO.
+         *
+         * @param deviceIndex
+         * @return std::vector<std::string>
+         */
+        std::vector<std::string> getInputKernelNames(uint deviceIndex) const {
+            const DeviceWrapper& devWrap = findDeviceWrapper(deviceIndex);
+            std::vector<std::string> names;
+            std::transform(devWrap.idmas.begin(), devWrap.idmas.end(), std::back_inserter(names), [](const auto& idma) { return idma->kernelName; });
+            return names;
+        }
+
+        /**
+         * @brief Get the kernel names of all outputs of a device, in the order of the config. This is the order of the tensors returned by inferSynchronousMultiIO.
+         *
+         * @param deviceIndex
+         * @return std::vector<std::string>
+         */
+        std::vector<std::string> getOutputKernelNames(uint deviceIndex) const {
+            const DeviceWrapper& devWrap = findDeviceWrapper(deviceIndex);
+            std::vector<std::string> names;
+            std::transform(devWrap.odmas.begin(), devWrap.odmas.end(), std::back_inserter(names), [](const auto& odma) { return odma->kernelName; });
+            return names;
+        }
+
+        /**
+         * @brief Number of devices in the model parallel pipeline described by the config. 0 if the config does not link any devices.
+         *
+         * @return std::size_t
+         */
+        std::size_t getPipelineDepth() const { return pipelineStages.size(); }
+
+        /**
+         * @brief Get the number of buffer slots
+         *
+         * @return uint
+         */
+        uint getBufferSlots() const { return bufferSlots; }
+
+        /**
+         * @brief Get the Batch Size
+         *
+         * @return Returns the Batch size
+         */
+        uint getBatchSize() { return batchElements; }
+
+        /**
+         * @brief Set the Force Achieval
+         *
+         * @param force
+         */
+        void setForceAchieval(bool force) { forceAchieval = force; }
+
+        /**
+         * @brief Get the Config object. Simple getter to check things outside the driver
+         *
+         * @return Config
+         */
+        Config getConfig() const { return configuration; }
+
+        /**
+         * @brief Get the accelerator that holds all devices of the driver
+         *
+         * @return Accelerator&
+         */
+        Accelerator& getAccelerator() { return accelerator; }
+
+        /**
+         * @brief Get the Device object, specified by its index
+         *
+         * @param index
+         * @return DeviceHandler&
+         */
+        DeviceHandler& getDeviceHandler(uint index) { return accelerator.getDeviceHandler(index); }
+
+        /**
+         * @brief Get a specific buffer object specified by its name and the device it is on
+         *
+         * @param deviceIndex
+         * @param bufferName
+         * @return DeviceInputBuffer<uint8_t>
+         */
+        std::shared_ptr<DeviceInputBuffer<uint8_t>> getInputBuffer(uint deviceIndex, const std::string& bufferName) { return getDeviceHandler(deviceIndex).getInputBuffer(bufferName); }
+
+        /**
+         * @brief Get a specific output buffer object specified by its name and the device it is on
+         *
+         * @param deviceIndex
+         * @param bufferName
+         * @return std::shared_ptr<DeviceOutputBuffer<uint8_t>>
+         */
+        std::shared_ptr<DeviceOutputBuffer<uint8_t>> getOutputBuffer(uint deviceIndex, const std::string& bufferName) { return getDeviceHandler(deviceIndex).getOutputBuffer(bufferName); }
+
+        /**
+         * @brief Return the size (type specified by SIZE_SPECIFIER) at the given device at the given buffer
+         *
+         * @param ss
+         * @param deviceIndex
+         * @param bufferName
+         * @return size_t
+         */
+        size_t size(SIZE_SPECIFIER ss, uint deviceIndex, const std::string& bufferName) { return accelerator.size(ss, deviceIndex, bufferName); }
+
+
+        /**
+         * @brief Store input into the driver for asynchronous inference
+         *
+         * @tparam IteratorType
+         * @param first
+         * @param last
+         * @param inputDeviceIndex FPGA device to be used for inference
+         * @param inputBufferKernelName Identifier of the input kernel
+         * @param batchSize Batch size contained in the input
+         */
+        template<typename IteratorType, typename = std::enable_if<!SynchronousInference>>
+        void input(IteratorType first, IteratorType last, uint inputDeviceIndex, const std::string& inputBufferKernelName, uint batchSize) {
+            FINN_LOG_DEBUG(logger, loglevel::info) << loggerPrefix() << "Store data for asynchronous inference.";
+            auto packed = Finn::pack<F>(first, last);
+            auto storeFunc = accelerator.storeFactory(inputDeviceIndex, inputBufferKernelName);
+
+            if (std::abs(std::distance(packed.begin(), packed.end())) != size(SIZE_SPECIFIER::FEATUREMAP_SIZE, inputDeviceIndex, inputBufferKernelName) * batchSize) {
+                FinnUtils::logAndError<std::runtime_error>("Input length (" + std::to_string(std::abs(std::distance(packed.begin(), packed.end()))) + ") does not match up with batches*inputsize_per_batch (" +
+                                                           std::to_string(size(SIZE_SPECIFIER::FEATUREMAP_SIZE, inputDeviceIndex, inputBufferKernelName)) + "*" + std::to_string(batchSize) + "=" +
+                                                           std::to_string(size(SIZE_SPECIFIER::FEATUREMAP_SIZE, inputDeviceIndex, inputBufferKernelName) * batchSize) + ")");
+            }
+
+            storeFunc(packed.begin(), packed.end());
+        }
+
+        /**
+         * @brief Store input into the driver for asynchronous inference
+         *
+         * @tparam IteratorType
+         * @tparam typename
+         * @param first
+         * @param last
+         */
+        template<typename IteratorType, typename = std::enable_if<!SynchronousInference>>
+        void input(IteratorType first, IteratorType last) {
+            input(first, last, defaultInputDeviceIndex, defaultInputKernelName, batchElements);
+        }
+
+        /**
+         * @brief Get the results of a asynchronous inference
+         *
+         * @tparam V
+         * @param outputDeviceIndex FPGA device from which data should be received
+         * @param outputBufferKernelName Identifier of the output kernel
+         * @param forceArchival Should data be explicitly polled?
+         * @return Finn::vector<V>
+         */
+        template<typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<!SynchronousInference>>
+        [[nodiscard]] Finn::vector<V> getResults(uint outputDeviceIndex, const std::string& outputBufferKernelName, bool forceArchival) {
+            // TODO(linusjun): maybe this method should block until data is available?
+            auto result = accelerator.getOutputData(outputDeviceIndex, outputBufferKernelName, forceArchival);
+            return unpackParts<V>(result, *findOutputDescriptor(outputDeviceIndex, outputBufferKernelName));
+        }
+
+        /**
+         * @brief Get the results of a asynchronous inference
+         *
+         * @tparam V
+         * @tparam typename
+         * @return Finn::vector<V>
+         */
+        template<typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<!SynchronousInference>>
+        [[nodiscard]] Finn::vector<V> getResults() {
+            return getResults<V>(defaultOutputDeviceIndex, defaultOutputKernelName, forceAchieval);
+        }
+
+        /**
+         * @brief Register a callback that is notified with the unpacked result of every batch element of an asynchronous inference, instead of polling getResults().
+         * The callback is invoked from the worker thread of the output buffer and the span is only valid during the call. While a callback is registered, results are not archived.
+         * Passing an empty function removes the callback.
+         *
+         * @tparam V Output datatype
+         * @param callback
+         * @param outputDeviceIndex FPGA device from which data should be received
+         * @param outputBufferKernelName Identifier of the output kernel
+         */
+        template<typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<!SynchronousInference>>
+        void setResultCallback(std::type_identity_t<std::function<void(std::span<const V>)>> callback, uint outputDeviceIndex, const std::string& outputBufferKernelName) {
+            if (!callback) {
+                accelerator.setResultCallback(outputDeviceIndex, outputBufferKernelName, {});
+                return;
+            }
+            const auto* descriptor = findOutputDescriptor(outputDeviceIndex, outputBufferKernelName);
+            // Every part of the asynchronous buffers holds exactly one batch element
+            auto plan = TransferPlan::forBatchSize(descriptor->foldedShape, descriptor->packedShape, 1, S().bitwidth());
+            Finn::vector<V> unpacked(plan.elements());
+            auto unpack = [callback = std::move(callback), plan = std::move(plan), unpacked = std::move(unpacked), pool = hostPool](std::span<const uint8_t> packed) mutable {
+                unpackOutput<V>(packed, plan, std::span<V>(unpacked.data(), unpacked.size()), pool.get());
+                callback(std::span<const V>(unpacked.data(), unpacked.size()));
+            };
+            accelerator.setResultCallback(outputDeviceIndex, outputBufferKernelName, std::move(unpack));
+        }
+
+        /**
+         * @brief Register a result callback on the default output. @see setResultCallback
+         *
+         * @tparam V Output datatype
+         * @param callback
+         */
+        template<typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<!SynchronousInference>>
+        void setResultCallback(std::type_identity_t<std::function<void(std::span<const V>)>> callback) {
+            setResultCallback<V>(std::move(callback), defaultOutputDeviceIndex, defaultOutputKernelName);
+        }
+
+        /**
+         * @brief Start an asynchronous inference and get a future for its result. The input is packed and stored for the worker thread of the input buffer as with input(),
+         * and the future becomes ready once all batch elements of this request have been read from the output. Thread safe, so many requests can be in flight at once.
+         * @attention The results of the output are delivered to the requests in submission order, so input() / getResults() and setResultCallback must not be used on
+         * the same input and output at the same time.
+         *
+         * @tparam IteratorType
+         * @tparam V Output datatype
+         * @param first Iterator to first element of input
+         * @param last  Iterator to end of input
+         * @param inputDeviceIndex FPGA device to be used for inference
+         * @param inputBufferKernelName Identifier of the input kernel
+         * @param outputDeviceIndex FPGA device from which data should be received
+         * @param outputBufferKernelName Identifier of the output kernel
+         * @param batchSize Batch size contained in the input
+         * @return std::future<Finn::vector<V>>
+         */
+        template<typename IteratorType, typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<!SynchronousInference>>
+        [[nodiscard]] std::future<Finn::vector<V>> inferAsync(IteratorType first, IteratorType last, uint inputDeviceIndex, const std::string& inputBufferKernelName, uint outputDeviceIndex,
+                                                              const std::string& outputBufferKernelName, uint batchSize) {
+            auto promise = std::make_shared<std::promise<Finn::vector<V>>>();
+            auto future = promise->get_future();
+            submitAsync<V>(first, last, inputDeviceIndex, inputBufferKernelName, outputDeviceIndex, outputBufferKernelName, batchSize, [promise](Finn::vector<V>&& result, std::exception_ptr error) {
+                if (error) {
+                    promise->set_exception(error);
+                } else {
+                    promise->set_value(std::move(result));
+                }
+            });
+            return future;
+        }
+
+        /**
+         * @brief Start an asynchronous inference on the default input and output. @see inferAsync
+         *
+         * @tparam IteratorType
+         * @tparam V Output datatype
+         * @param first Iterator to first element of input
+         * @param last  Iterator to end of input. Has to contain one batch of the current batch size.
+         * @return std::future<Finn::vector<V>>
+         */
+        template<typename IteratorType, typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<!SynchronousInference>>
+        [[nodiscard]] std::future<Finn::vector<V>> inferAsync(IteratorType first, IteratorType last) {
+            return inferAsync<IteratorType, V>(first, last, defaultInputDeviceIndex, defaultInputKernelName, defaultOutputDeviceIndex, defaultOutputKernelName, batchElements);
+        }
+
+        /**
+         * @brief Start an asynchronous inference and get an awaitable for its result, so a coroutine can co_await it instead of blocking a thread. @see inferAsync, AsyncInference
+         *
+         * @tparam IteratorType
+         * @tparam V Output datatype
+         * @param first Iterator to first element of input
+         * @param last  Iterator to end of input
+         * @param inputDeviceIndex FPGA device to be used for inference
+         * @param inputBufferKernelName Identifier of the input kernel
+         * @param outputDeviceIndex FPGA device from which data should be received
+         * @param outputBufferKernelName Identifier of the output kernel
+         * @param batchSize Batch size contained in the input
+         * @return AsyncInference<V>
+         */
+        template<typename IteratorType, typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<!SynchronousInference>>
+        [[nodiscard]] AsyncInference<V> inferAwaitable(IteratorType first, IteratorType last, uint inputDeviceIndex, const std::string& inputBufferKernelName, uint outputDeviceIndex,
+                                                       const std::string& outputBufferKernelName, uint batchSize) {
+            auto state = std::make_shared<detail::AsyncInferenceState<V>>();
+            submitAsync<V>(first, last, inputDeviceIndex, inputBufferKernelName, outputDeviceIndex, outputBufferKernelName, batchSize,
+                           [state](Finn::vector<V>&& result, std::exception_ptr error) { state->complete(std::move(result), std::move(error)); });
+            return AsyncInference<V>(std::move(state));
+        }
+
+        /**
+         * @brief Start an asynchronous inference on the default input and output and get an awaitable for its result. @see inferAwaitable
+         *
+         * @tparam IteratorType
+         * @tparam V Output datatype
+         * @param first Iterator to first element of input
+         * @param last  Iterator to end of input. Has to contain one batch of the current batch size.
+         * @return AsyncInference<V>
+         */
+        template<typename IteratorType, typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<!SynchronousInference>>
+        [[nodiscard]] AsyncInference<V> inferAwaitable(IteratorType first, IteratorType last) {
+            return inferAwaitable<IteratorType, V>(first, last, defaultInputDeviceIndex, defaultInputKernelName, defaultOutputDeviceIndex, defaultOutputKernelName, batchElements);
+        }
+
+        /**
+         * @brief Number of inferAsync / inferAwaitable requests on the given output that are still waiting for results
+         *
+         * @param outputDeviceIndex
+         * @param outputBufferKernelName
+         * @return std::size_t
+         */
+        std::size_t getAsyncInFlight(uint outputDeviceIndex, const std::string& outputBufferKernelName) {
+            std::lock_guard guard(*asyncSubmitMutex);
+            auto queue = completionQueues.find({outputDeviceIndex, outputBufferKernelName});
+            return (queue == completionQueues.end()) ? 0 : queue->second->inFlight();
+        }
+
+        /**
+         * @brief Run a synchronous inference and return a view on the packed results in the mapped output buffer. No copy of the output is made.
+         * @attention The returned span is only valid until the next inference or change of the batch size!
+         *
+         * @tparam IteratorType
+         * @param first Iterator to first element of input
+         * @param last  Iterator to end of input
+         * @param inputDeviceIndex index of input FPGA
+         * @param inputBufferKernelName name of input kernel
+         * @param outputDeviceIndex index of output FPGA
+         * @param outputBufferKernelName name of output kernel
+         * @return std::span<const uint8_t>
+         */
+        template<typename IteratorType, typename = std::enable_if<SynchronousInference>>
+        [[nodiscard]] std::span<const uint8_t> inferSynchronousPacked(IteratorType first, IteratorType last, uint inputDeviceIndex, const std::string& inputBufferKernelName, uint outputDeviceIndex,
+                                                                      const std::string& outputBufferKernelName) {
+            // Pack directly into the mapped input buffer to avoid an intermediate allocation and copy
+            packInput(first, last, getInputPlan(inputDeviceIndex, inputBufferKernelName), getInputBuffer(inputDeviceIndex, inputBufferKernelName)->getMap());
+            return resultCache ? runCached(inputDeviceIndex, inputBufferKernelName, outputDeviceIndex, outputBufferKernelName) : runPrepacked(outputDeviceIndex, outputBufferKernelName);
+        }
+
+        /**
+         * @brief Number of packed bytes of one batch on the given input for the current batch size
+         *
+         * @param inputDeviceIndex
+         * @param inputBufferKernelName
+         * @return std::size_t
+         */
+        std::size_t getPackedInputBytes(uint inputDeviceIndex, const std::string& inputBufferKernelName) { return getInputPlan(inputDeviceIndex, inputBufferKernelName).bytes(); }
+
+        /**
+         * @brief Number of packed bytes of one batch on the given output for the current batch size
+         *
+         * @param outputDeviceIndex
+         * @param outputBufferKernelName
+         * @return std::size_t
+         */
+        std::size_t getPackedOutputBytes(uint outputDeviceIndex, const std::string& outputBufferKernelName) { return getOutputPlan(outputDeviceIndex, outputBufferKernelName).bytes(); }
+
+        /**
+         * @brief Pack a batch into the device format of the given input without running it, e.g. to store it and skip packing in later runs (@see inferSynchronousPrepacked)
+         *
+         * @tparam IteratorType
+         * @param first Iterator to first element of input
+         * @param last  Iterator to end of input
+         * @param packed Destination, has to hold exactly getPackedInputBytes() bytes
+         * @param inputDeviceIndex index of input FPGA
+         * @param inputBufferKernelName name of input kernel
+         */
+        template<typename IteratorType>
+        void packBatch(IteratorType first, IteratorType last, std::span<uint8_t> packed, uint inputDeviceIndex, const std::string& inputBufferKernelName) {
+            packInput(first, last, getInputPlan(inputDeviceIndex, inputBufferKernelName), packed, false);
+        }
+
+        /**
+         * @brief Get the mapped input buffer of the current batch. Packed data written here is transferred by the next runPrepacked, which allows filling the buffer
+         * directly from a file.
+         *
+         * @param inputDeviceIndex
+         * @param inputBufferKernelName
+         * @return std::span<uint8_t>
+         */
+        std::span<uint8_t> getPackedInputMap(uint inputDeviceIndex, const std::string& inputBufferKernelName) {
+            return getInputBuffer(inputDeviceIndex, inputBufferKernelName)->getMap().first(getPackedInputBytes(inputDeviceIndex, inputBufferKernelName));
+        }
+
+        /**
+         * @brief Run the accelerator on the data that is already in the mapped input buffers and return a view on the packed results in the mapped output buffer
+         * @attention The returned span is only valid until the next inference or change of the batch size!
+         *
+         * @param outputDeviceIndex index of output FPGA
+         * @param outputBufferKernelName name of output kernel
+         * @return std::span<const uint8_t>
+         */
+        template<typename = std::enable_if<SynchronousInference>>
+        [[nodiscard]] std::span<const uint8_t> runPrepacked(uint outputDeviceIndex, const std::string& outputBufferKernelName) {
+            accelerator.run();
+            accelerator.wait();
+            accelerator.read();
+            return getOutputBuffer(outputDeviceIndex, outputBufferKernelName)->getMap().first(getPackedOutputBytes(outputDeviceIndex, outputBufferKernelName));
+        }
+
+        /**
+         * @brief Run a synchronous inference on a batch that is already in the device format, e.g. produced by packBatch. The data is only copied into the mapped input buffer.
+         * @attention The returned span is only valid until the next inference or change of the batch size!
+         *
+         * @param packedInput Exactly getPackedInputBytes() bytes
+         * @param inputDeviceIndex index of input FPGA
+         * @param inputBufferKernelName name of input kernel
+         * @param outputDeviceIndex index of output FPGA
+         * @param outputBufferKernelName name of output kernel
+         * @return std::span<const uint8_t> Packed results in the mapped output buffer
+         */
+        template<typename = std::enable_if<SynchronousInference>>
+        [[nodiscard]] std::span<const uint8_t> inferSynchronousPrepacked(std::span<const uint8_t> packedInput, uint inputDeviceIndex, const std::string& inputBufferKernelName, uint outputDeviceIndex,
+                                                                         const std::string& outputBufferKernelName) {
+            auto map = getPackedInputMap(inputDeviceIndex, inputBufferKernelName);
+            if (packedInput.size() != map.size()) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " Packed input length (" + std::to_string(packedInput.size()) + ") does not match up with the input buffer size (" + std::to_string(map.size()) + ")");
+            }
+            recordRequest(batchElements, packedInput);
+            std::copy(packedInput.begin(), packedInput.end(), map.begin());
+            return resultCache ? runCached(inputDeviceIndex, inputBufferKernelName, outputDeviceIndex, outputBufferKernelName) : runPrepacked(outputDeviceIndex, outputBufferKernelName);
+        }
+
+        /**
+         * @brief Unpack the packed results of one batch of the given output, e.g. results that were stored packed by an earlier run
+         *
+         * @tparam V Output datatype
+         * @param packedOutput Packed results of one batch (getPackedOutputBytes() bytes)
+         * @param output Has to hold batchSize * unpacked output featuremap elements
+         * @param outputDeviceIndex index of output FPGA
+         * @param outputBufferKernelName name of output kernel
+         * @return std::size_t Number of elements written to output
+         */
+        template<typename V>
+        std::size_t unpackBatch(std::span<const uint8_t> packedOutput, std::span<V> output, uint outputDeviceIndex, const std::string& outputBufferKernelName) {
+            return unpackOutput<V>(packedOutput, getOutputPlan(outputDeviceIndex, outputBufferKernelName), output, hostPool.get());
+        }
+
+        /**
+         * @brief Reduce the packed results of one batch of the given output to class indices, @see Postprocessing
+         *
+         * @param packedOutput Packed results of one batch (getPackedOutputBytes() bytes)
+         * @param stage
+         * @param output Has to hold batchSize * stage.resultsPerSample() indices
+         * @param outputDeviceIndex index of output FPGA
+         * @param outputBufferKernelName name of output kernel
+         * @return std::size_t Number of indices written to output
+         */
+        std::size_t postprocessBatch(std::span<const uint8_t> packedOutput, const Postprocessing& stage, std::span<std::size_t> output, uint outputDeviceIndex, const std::string& outputBufferKernelName) {
+            return Finn::postprocessPacked<S>(packedOutput, getOutputPlan(outputDeviceIndex, outputBufferKernelName), stage, output, hostPool.get());
+        }
+
+        /**
+         * @brief Run a synchronous inference and reduce the results to class indices (argmax, top-k or threshold) directly on the mapped output buffer. The full output is
+         * never unpacked, which saves the unpacking and memory traffic for models with many classes.
+         *
+         * @tparam IteratorType
+         * @param first Iterator to first element of input
+         * @param last  Iterator to end of input
+         * @param stage Postprocessing applied to every sample
+         * @param output Has to hold batchSize * stage.resultsPerSample() indices
+         * @param inputDeviceIndex index of input FPGA
+         * @param inputBufferKernelName name of input kernel
+         * @param outputDeviceIndex index of output FPGA
+         * @param outputBufferKernelName name of output kernel
+         * @return std::size_t Number of indices written to output
+         */
+        template<typename IteratorType, typename = std::enable_if<SynchronousInference>>
+        std::size_t inferSynchronousPostprocessed(IteratorType first, IteratorType last, const Postprocessing& stage, std::span<std::size_t> output, uint inputDeviceIndex, const std::string& inputBufferKernelName,
+                                                  uint outputDeviceIndex, const std::string& outputBufferKernelName) {
+            const auto packedResult = inferSynchronousPacked(first, last, inputDeviceIndex, inputBufferKernelName, outputDeviceIndex, outputBufferKernelName);
+            return postprocessBatch(packedResult, stage, output, outputDeviceIndex, outputBufferKernelName);
+        }
+
+        /**
+         * @brief Run a synchronous inference on the default input and output and reduce the results to class indices, @see inferSynchronousPostprocessed
+         *
+         * @tparam IteratorType
+         * @param first Iterator to first element of input
+         * @param last  Iterator to end of input
+         * @param stage Postprocessing applied to every sample
+         * @return Finn::vector<std::size_t> stage.resultsPerSample() indices per sample
+         */
+        template<typename IteratorType, typename = std::enable_if<SynchronousInference>>
+        [[nodiscard]] Finn::vector<std::size_t> inferSynchronousPostprocessed(IteratorType first, IteratorType last, const Postprocessing& stage) {
+            Finn::vector<std::size_t> indices(static_cast<std::size_t>(batchElements) * stage.resultsPerSample());
+            inferSynchronousPostprocessed(first, last, stage, std::span<std::size_t>(indices.data(), indices.size()), defaultInputDeviceIndex, defaultInputKernelName, defaultOutputDeviceIndex, defaultOutputKernelName);
+            return indices;
+        }
+
+        /**
+         * @brief Implements the synchronous inference operation. Results are unpacked straight from the mapped output buffer into the given output buffer.
+         * @attention Not thread safe. Use inferSynchronousScheduled to run inferences from several threads.
+         *
+         * @tparam IteratorType
+         * @tparam V Output datatype
+         * @param first Iterator to first element of input
+         * @param last  Iterator to end of input
+         * @param output Output buffer. Has to hold at least batchSize * unpacked output featuremap elements
+         * @param inputDeviceIndex index of input FPGA
+         * @param inputBufferKernelName name of input kernel
+         * @param outputDeviceIndex index of output FPGA
+         * @param outputBufferKernelName name of output kernel
+         * @return std::size_t Number of elements written to output
+         */
+        template<typename IteratorType, typename V, typename = std::enable_if<SynchronousInference>>
+        std::size_t inferSynchronous(IteratorType first, IteratorType last, std::span<V> output, uint inputDeviceIndex, const std::string& inputBufferKernelName, uint outputDeviceIndex, const std::string& outputBufferKernelName) {
+            auto packedResult = inferSynchronousPacked(first, last, inputDeviceIndex, inputBufferKernelName, outputDeviceIndex, outputBufferKernelName);
+            return unpackOutput<V>(packedResult, getOutputPlan(outputDeviceIndex, outputBufferKernelName), output, hostPool.get());
+        }
+
+        /**
+         * @brief Run a synchronous inference on the default input and output and hand the results to a callback chunk by chunk, while the kernel still produces the
+         * rest of the batch. The odma is started for one chunk of samples at a time, and each finished chunk is synced back and unpacked while the next one is written,
+         * so the first results of large batches are available long before the whole batch is done. Only supported if the default input and output form a compute unit
+         * pair (@see DeviceHandler::getComputeUnitPairs) of the only device of the accelerator.
+         * @attention Not thread safe, like inferSynchronous.
+         *
+         * @tparam IteratorType
+         * @tparam V Output datatype
+         * @tparam Callback Invocable as void(std::size_t firstSample, std::span<const V> results)
+         * @param first Iterator to first element of input
+         * @param last  Iterator to end of input
+         * @param output Output buffer. Has to hold at least batchSize * unpacked output featuremap elements
+         * @param chunkSamples Samples per chunk. Rounded up so that every chunk starts at an address the odma can write to, @see SyncDeviceOutputBuffer::alignChunk
+         * @param onChunk Called in order of the samples with the unpacked results of every chunk, which stay valid in output
+         * @return std::size_t Number of elements written to output
+         */
+        template<typename IteratorType, typename V, typename Callback, typename = std::enable_if<SynchronousInference>>
+        std::size_t inferSynchronousStreaming(IteratorType first, IteratorType last, std::span<V> output, std::size_t chunkSamples, Callback&& onChunk) {
+            DeviceHandler& device = getDeviceHandler(defaultOutputDeviceIndex);
+            const auto& pairs = device.getComputeUnitPairs();
+            const bool isPair = std::any_of(pairs.begin(), pairs.end(), [this](const ComputeUnitPair& pair) { return pair.inputKernelName == defaultInputKernelName && pair.outputKernelName == defaultOutputKernelName; });
+            if (accelerator.deviceCount() != 1 || defaultInputDeviceIndex != defaultOutputDeviceIndex || !isPair || device.getInputBufferMap().size() != pairs.size() || device.getOutputBufferMap().size() != pairs.size()) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " Streaming inference needs the default input and output to be a compute unit pair of a single device!");
+            }
+            device.allocateBuffers();
+            auto input = getInputBuffer(defaultInputDeviceIndex, defaultInputKernelName);
+            auto outputBuffer = std::dynamic_pointer_cast<SyncDeviceOutputBuffer<uint8_t>>(getOutputBuffer(defaultOutputDeviceIndex, defaultOutputKernelName));
+            const TransferPlan& batchPlan = getOutputPlan(defaultOutputDeviceIndex, defaultOutputKernelName);
+            if (output.size() < batchPlan.elements()) {
+                FinnUtils::logAndError<std::length_error>(loggerPrefix() + " Output buffer for streaming is too small (" + std::to_string(output.size()) + " elements given, " + std::to_string(batchPlan.elements()) + " elements needed)!");
+            }
+            packInput(first, last, getInputPlan(defaultInputDeviceIndex, defaultInputKernelName), input->getMap());
+
+            const std::size_t batch = batchElements;
+            const std::size_t chunk = std::min<std::size_t>(outputBuffer->alignChunk(chunkSamples), batch);
+            const std::size_t elementsPerSample = batchPlan.elements() / batch;
+            const auto* descriptor = findOutputDescriptor(defaultOutputDeviceIndex, defaultOutputKernelName);
+            const auto chunkPlan = TransferPlan::forBatchSize(descriptor->foldedShape, descriptor->packedShape, static_cast<unsigned int>(chunk), S().bitwidth());
+
+            // Output first, like DeviceHandler::run. The input kernel moves the whole batch at once and blocks whenever the odma is between two chunks.
+            input->upload();
+            outputBuffer->runChunk(0, chunk);
+            input->run();
+            for (std::size_t firstSample = 0; firstSample < batch; firstSample += chunk) {
+                const std::size_t samples = std::min(chunk, batch - firstSample);
+                outputBuffer->wait();
+                if (firstSample + samples < batch) {
+                    outputBuffer->runChunk(firstSample + samples, std::min(chunk, batch - firstSample - samples));
+                }
+                auto packed = outputBuffer->readChunk(firstSample, samples);
+                auto results = output.subspan(firstSample * elementsPerSample, samples * elementsPerSample);
+                if (samples == chunk) {
+                    unpackOutput<V>(packed, chunkPlan, results, hostPool.get());
+                } else {
+                    unpackOutput<V>(packed, TransferPlan::forBatchSize(descriptor->foldedShape, descriptor->packedShape, static_cast<unsigned int>(samples), S().bitwidth()), results, hostPool.get());
+                }
+                onChunk(firstSample, std::span<const V>(results));
+            }
+            return batchPlan.elements();
+        }
+
+        /**
+         * @brief A synchronous inference on one input and output whose buffers, mapped memory and transfer plans were resolved once by prepare(). infer() does not look
+         * up names, copy strings or touch shared pointers, so the host path at small batch sizes only packs, runs and unpacks. A session becomes stale when the batch
+         * size, maximum batch size or number of buffer slots of its driver changes, or when a device is recovered (by recoverStuckDevices or the watchdog), which frees
+         * the mapped memory the session refers to. A stale session has to be prepared again. It must not outlive or be moved across its driver.
+         * @attention Not thread safe, like inferSynchronous.
+         *
+         */
+        class InferenceSession {
+             private:
+            friend class BaseDriver;
+            BaseDriver* driver = nullptr;
+            std::size_t generation = 0;
+            std::span<uint8_t> inputMap;
+            std::span<const uint8_t> outputMap;
+            TransferPlan inputPlan;
+            TransferPlan outputPlan;
+
+            InferenceSession(BaseDriver& pDriver, std::span<uint8_t> pInputMap, std::span<const uint8_t> pOutputMap, const TransferPlan& pInputPlan, const TransferPlan& pOutputPlan)
+                : driver(&pDriver), generation(pDriver.currentGeneration()), inputMap(pInputMap), outputMap(pOutputMap), inputPlan(pInputPlan), outputPlan(pOutputPlan) {}
+
+            void checkCurrent() const {
+                if (driver == nullptr || generation != driver->currentGeneration()) {
+                    FinnUtils::logAndError<std::logic_error>(loggerPrefix() + " Inference session is stale, prepare it again after changing the batch size or buffers or recovering a device!");
+                }
+            }
+
+             public:
+            /**
+             * @brief Construct an empty session, @see BaseDriver::prepare
+             *
+             */
+            InferenceSession() = default;
+
+            /**
+             * @brief Check if the session can still be used
+             *
+             * @return true
+             * @return false
+             */
+            bool valid() const { return driver != nullptr && generation == driver->currentGeneration(); }
+
+            /**
+             * @brief Get the transfer plan of the input
+             *
+             * @return const TransferPlan&
+             */
+            const TransferPlan& getInputPlan() const { return inputPlan; }
+
+            /**
+             * @brief Get the transfer plan of the output
+             *
+             * @return const TransferPlan&
+             */
+            const TransferPlan& getOutputPlan() const { return outputPlan; }
+
+            /**
+             * @brief Pack a batch into the mapped input buffer, run the accelerator and return a view on the packed results, @see BaseDriver::inferSynchronousPacked
+             * @attention The returned span is only valid until the next inference!
+             *
+             * @tparam IteratorType
+             * @param first Iterator to first element of input
+             * @param last Iterator to end of input
+             * @return std::span<const uint8_t>
+             */
+            template<typename IteratorType>
+            [[nodiscard]] std::span<const uint8_t> inferPacked(IteratorType first, IteratorType last) {
+                checkCurrent();
+                driver->packInput(first, last, inputPlan, inputMap);
+                driver->accelerator.run();
+                driver->accelerator.wait();
+                driver->accelerator.read();
+                return outputMap;
+            }
+
+            /**
+             * @brief Run an inference on a batch and unpack the results into output, @see BaseDriver::inferSynchronous
+             *
+             * @tparam IteratorType
+             * @tparam V Output datatype
+             * @param first Iterator to first element of input
+             * @param last Iterator to end of input
+             * @param output Has to hold at least getOutputPlan().elements() elements
+             * @return std::size_t Number of elements written to output
+             */
+            template<typename IteratorType, typename V>
+            std::size_t infer(IteratorType first, IteratorType last, std::span<V> output) {
+                return unpackOutput<V>(inferPacked(first, last), outputPlan, output, driver->hostPool.get());
+            }
+
+            /**
+             * @brief Run an inference on a batch and reduce the results to class indices, @see BaseDriver::inferSynchronousPostprocessed
+             *
+             * @tparam IteratorType
+             * @param first Iterator to first element of input
+             * @param last Iterator to end of input
+             * @param stage Postprocessing applied to every sample
+             * @param output Has to hold batchSize * stage.resultsPerSample() indices
+             * @return std::size_t Number of indices written to output
+             */
+            template<typename IteratorType>
+            std::size_t inferPostprocessed(IteratorType first, IteratorType last, const Postprocessing& stage, std::span<std::size_t> output) {
+                return Finn::postprocessPacked<S>(inferPacked(first, last), outputPlan, stage, output, driver->hostPool.get());
+            }
+        };
+
+        /**
+         * @brief Resolve the buffers, mapped memory and transfer plans of an input and output for the current batch size once, @see InferenceSession. The buffers are
+         * allocated now if they were not yet.
+         *
+         * @param inputDeviceIndex index of input FPGA
+         * @param inputBufferKernelName name of input kernel
+         * @param outputDeviceIndex index of output FPGA
+         * @param outputBufferKernelName name of output kernel
+         * @return InferenceSession
+         */
+        template<typename = std::enable_if<SynchronousInference>>
+        [[nodiscard]] InferenceSession prepare(uint inputDeviceIndex, const std::string& inputBufferKernelName, uint outputDeviceIndex, const std::string& outputBufferKernelName) {
+            const TransferPlan& inputPlan = getInputPlan(inputDeviceIndex, inputBufferKernelName);
+            const TransferPlan& outputPlan = getOutputPlan(outputDeviceIndex, outputBufferKernelName);
+            auto inputMap = getInputBuffer(inputDeviceIndex, inputBufferKernelName)->getMap(0);
+            auto outputMap = getOutputBuffer(outputDeviceIndex, outputBufferKernelName)->getMap(0);
+            if (inputMap.size() < inputPlan.bytes() || outputMap.size() < outputPlan.bytes()) {
+                FinnUtils::logAndError<std::length_error>(loggerPrefix() + " The buffers of " + inputBufferKernelName + " and " + outputBufferKernelName + " are smaller than their transfer plans!");
+            }
+            return InferenceSession(*this, inputMap.first(inputPlan.bytes()), outputMap.first(outputPlan.bytes()), inputPlan, outputPlan);
+        }
+
+        /**
+         * @brief Prepare a session on the default input and output, @see prepare
+         *
+         * @return InferenceSession
+         */
+        template<typename = std::enable_if<SynchronousInference>>
+        [[nodiscard]] InferenceSession prepare() {
+            return prepare(defaultInputDeviceIndex, defaultInputKernelName, defaultOutputDeviceIndex, defaultOutputKernelName);
+        }
+
+        /**
+         * @brief Run synchronous inference on an input that contains several batches. With more than one buffer slot (@see setBufferSlots) the batches are pipelined:
+         * batch k+1 is packed while batch k executes on the FPGA, and batch k-1 is unpacked while batch k+1 executes. Two slots are sufficient for this.
+         *
+         * @tparam IteratorType Random access iterator
+         * @tparam V Output datatype
+         * @param first Iterator to first element of input
+         * @param last  Iterator to end of input. The input has to contain a whole number of batches.
+         * @param output Output buffer. Has to hold the unpacked outputs of all batches
+         * @param inputDeviceIndex index of input FPGA
+         * @param inputBufferKernelName name of input kernel
+         * @param outputDeviceIndex index of output FPGA
+         * @param outputBufferKernelName name of output kernel
+         * @return std::size_t Number of elements written to output
+         */
+        template<std::random_access_iterator IteratorType, typename V, typename = std::enable_if<SynchronousInference>>
+        std::size_t inferSynchronousPipelined(IteratorType first, IteratorType last, std::span<V> output, uint inputDeviceIndex, const std::string& inputBufferKernelName, uint outputDeviceIndex,
+                                              const std::string& outputBufferKernelName) {
+            const TransferPlan& inputPlan = getInputPlan(inputDeviceIndex, inputBufferKernelName);
+            const TransferPlan& outputPlan = getOutputPlan(outputDeviceIndex, outputBufferKernelName);
+            const auto inputElementsPerBatch = static_cast<std::ptrdiff_t>(inputPlan.elements());
+            const std::size_t outputElementsPerBatch = outputPlan.elements();
+            const auto totalInputs = std::distance(first, last);
+            if (totalInputs % inputElementsPerBatch != 0) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " Input length (" + std::to_string(totalInputs) + ") is not a multiple of the batch input size (" + std::to_string(inputElementsPerBatch) + ")");
+            }
+            const auto batches = static_cast<std::size_t>(totalInputs / inputElementsPerBatch);
+            if (output.size() < batches * outputElementsPerBatch) {
+                FinnUtils::logAndError<std::length_error>(loggerPrefix() + " Output buffer too small for " + std::to_string(batches) + " batches");
+            }
+            auto batchBegin = [&](std::size_t batch) { return first + static_cast<std::ptrdiff_t>(batch) * inputElementsPerBatch; };
+            auto batchOutput = [&](std::size_t batch) { return output.subspan(batch * outputElementsPerBatch, outputElementsPerBatch); };
+
+            if (bufferSlots < 2) {  // No buffers to overlap with, so run batch by batch
+                for (std::size_t batch = 0; batch < batches; ++batch) {
+                    inferSynchronous(batchBegin(batch), batchBegin(batch + 1), batchOutput(batch), inputDeviceIndex, inputBufferKernelName, outputDeviceIndex, outputBufferKernelName);
+                }
+                return batches * outputElementsPerBatch;
+            }
+
+            auto inputBuffer = getInputBuffer(inputDeviceIndex, inputBufferKernelName);
+            auto outputBuffer = getOutputBuffer(outputDeviceIndex, outputBufferKernelName);
+            auto unpackBatch = [&](std::size_t batch) {
+                unpackOutput<V>(outputBuffer->getMap(batch % bufferSlots), outputPlan, batchOutput(batch), hostPool.get());
+            };
+
+            if (batches > 0) {
+                packInput(batchBegin(0), batchBegin(1), inputPlan, inputBuffer->getMap(0));
+                accelerator.setActiveBufferSlot(0);
+                accelerator.run();
+            }
+            for (std::size_t batch = 1; batch < batches; ++batch) {
+                const std::size_t slot = batch % bufferSlots;
+                // Packing and uploading overlap with the execution of the previous batch, the upload also with its readback
+                packInput(batchBegin(batch), batchBegin(batch + 1), inputPlan, inputBuffer->getMap(slot));
+                inputBuffer->upload(slot);
+                accelerator.wait();
+                accelerator.read();
+
+                accelerator.setActiveBufferSlot(slot);
+                accelerator.run();
+                // Overlaps with the execution of the current batch
+                unpackBatch(batch - 1);
+            }
+            if (batches > 0) {
+                accelerator.wait();
+                accelerator.read();
+                unpackBatch(batches - 1);
+                accelerator.setActiveBufferSlot(0);
+            }
+            return batches * outputElementsPerBatch;
+        }
+
+        /**
+         * @brief Run synchronous inference on a network with several inputs and outputs. All inputs are packed in parallel on the host thread pool,
+         * then all DMAs of the device are started together and all outputs are unpacked in parallel.
+         *
+         * @tparam U Input datatype
+         * @tparam V Output datatype
+         * @param inputs One tensor per input of the device, in the order of getInputKernelNames
+         * @param outputs One output buffer per output of the device, in the order of getOutputKernelNames. Each has to hold the unpacked output of one batch.
+         * @param deviceIndex FPGA device to run on
+         * @return std::size_t Number of elements written to all outputs
+         */
+        template<typename U, typename V, typename = std::enable_if<SynchronousInference>>
+        std::size_t inferSynchronousMultiIO(const std::vector<std::span<const U>>& inputs, const std::vector<std::span<V>>& outputs, uint deviceIndex) {
+            const DeviceWrapper& devWrap = findDeviceWrapper(deviceIndex);
+            if (inputs.size() != devWrap.idmas.size() || outputs.size() != devWrap.odmas.size()) {
+                FinnUtils::logAndError<std::invalid_argument>(loggerPrefix() + " Device " + std::to_string(deviceIndex) + " has " + std::to_string(devWrap.idmas.size()) + " inputs and " + std::to_string(devWrap.odmas.size()) +
+                                                              " outputs, but " + std::to_string(inputs.size()) + " inputs and " + std::to_string(outputs.size()) + " outputs were given");
+            }
+            DeviceHandler& device = getDeviceHandler(deviceIndex);
+            // Resolve plans and buffers before going parallel, the plan cache is not thread safe
+            std::vector<const TransferPlan*> inputPlanList;
+            std::vector<std::span<uint8_t>> inputMaps;
+            for (auto&& idma : devWrap.idmas) {
+                inputPlanList.emplace_back(&getInputPlan(deviceIndex, idma->kernelName));
+                inputMaps.emplace_back(device.getInputBuffer(idma->kernelName)->getMap());
+            }
+            std::vector<const TransferPlan*> outputPlanList;
+            std::vector<std::span<uint8_t>> outputMaps;
+            for (auto&& odma : devWrap.odmas) {
+                outputPlanList.emplace_back(&getOutputPlan(deviceIndex, odma->kernelName));
+                outputMaps.emplace_back(device.getOutputBuffer(odma->kernelName)->getMap());
+            }
+
+            // Every tensor is worth a chunk of its own, tensors are split further only if they are alone on the pool
+            hostPool->parallelFor(inputs.size(), hostPool->grainBytes(), [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    // A request of several tensors is recorded once, with its first input
+                    packInput(inputs[i].begin(), inputs[i].end(), *inputPlanList[i], inputMaps[i], i == 0);
+                }
+            });
+            device.run();
+            device.wait();
+            device.read();
+            std::atomic<std::size_t> written = 0;
+            hostPool->parallelFor(outputs.size(), hostPool->grainBytes(), [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    written += unpackOutput<V>(outputMaps[i], *outputPlanList[i], outputs[i], hostPool.get());
+                }
+            });
+            return written;
+        }
+
+        /**
+         * @brief Run synchronous inference on a network with several inputs and outputs. @see inferSynchronousMultiIO
+         *
+         * @tparam U Input datatype
+         * @tparam V Output datatype
+         * @param inputs One tensor per input of the device, in the order of getInputKernelNames
+         * @param deviceIndex FPGA device to run on
+         * @return std::vector<Finn::vector<V>> One tensor per output of the device, in the order of getOutputKernelNames
+         */
+        template<typename U, typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<SynchronousInference>>
+        [[nodiscard]] std::vector<Finn::vector<V>> inferSynchronousMultiIO(const std::vector<std::span<const U>>& inputs, uint deviceIndex) {
+            std::vector<Finn::vector<V>> results;
+            std::vector<std::span<V>> outputs;
+            for (auto&& odma : findDeviceWrapper(deviceIndex).odmas) {
+                results.emplace_back(getOutputPlan(deviceIndex, odma->kernelName).elements());
+                outputs.emplace_back(results.back().data(), results.back().size());
+            }
+            inferSynchronousMultiIO(inputs, outputs, deviceIndex);
+            return results;
+        }
+
+        /**
+         * @brief Run synchronous inference on a network with several inputs and outputs on the default device. @see inferSynchronousMultiIO
+         *
+         * @tparam U Input datatype
+         * @tparam V Output datatype
+         * @param inputs One tensor per input of the default input device, in the order of getInputKernelNames
+         * @return std::vector<Finn::vector<V>> One tensor per output of the device, in the order of getOutputKernelNames
+         */
+        template<typename U, typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<SynchronousInference>>
+        [[nodiscard]] std::vector<Finn::vector<V>> inferSynchronousMultiIO(const std::vector<std::span<const U>>& inputs) {
+            return inferSynchronousMultiIO<U, V>(inputs, defaultInputDeviceIndex);
+        }
+
+        /**
+         * @brief Run one batch of synchronous inference on a device picked by the scheduling policy (@see setSchedulingPolicy), using the first input and output of that device.
+         * Thread safe and reentrant: every call checks out one buffer slot (@see setBufferSlots) of the picked device, packs into and unpacks from it without holding any lock,
+         * and only holds the device while the slot is executed. With n slots per device, n callers can thus have inferences in flight on the same device, and the host work
+         * of one caller overlaps with the execution of another. Concurrent callers are spread over all devices of the accelerator.
+         * @attention All devices are expected to run the same design. Changing the batch size or the number of buffer slots while inferences are running is not allowed,
+         * and neither is mixing this with the other (single threaded) inference functions.
+         *
+         * @tparam IteratorType
+         * @tparam V Output datatype
+         * @param first Iterator to first element of input
+         * @param last  Iterator to end of input
+         * A batch whose device missed the execute timeout (@see setExecuteTimeout) is run again on another device, up to once per device, before the KernelTimeoutError
+         * is passed on.
+         *
+         * @param output Output buffer. Has to hold at least batchSize * unpacked output featuremap elements
+         * @return std::size_t Number of elements written to output
+         */
+        template<typename IteratorType, typename V, typename = std::enable_if<SynchronousInference>>
+        std::size_t inferSynchronousScheduled(IteratorType first, IteratorType last, std::span<V> output) {
+            return requeueOnTimeout([&]() {
+                auto lease = accelerator.acquireBufferSet();
+                const ScheduledDevice& target = scheduledDevices[lease.position()];
+                DeviceHandler& device = lease.get();
+                packInput(first, last, *target.inputPlan, device.getInputBuffer(target.inputKernelName)->getMap(lease.slot()));
+                {
+                    auto deviceLock = lease.lockDevice();
+                    device.setActiveBufferSlot(lease.slot());
+                    device.run();
+                    device.wait();
+                    device.read();
+                }
+                return unpackOutput<V>(device.getOutputBuffer(target.outputKernelName)->getMap(lease.slot()), *target.outputPlan, output, hostPool.get());
+            });
+        }
+
+        /**
+         * @brief Run one batch that is already in the device format (@see packBatch) on a device picked by the scheduling policy, like inferSynchronousScheduled.
+         * The packed input is copied into a buffer set of the device and the packed results are copied out before the lease is returned, so packing and unpacking
+         * can happen on other threads than the device work. Thread safe.
+         *
+         * @param packedInput Exactly getPackedInputBytes() bytes of the default input
+         * @param packedOutput Receives exactly getPackedOutputBytes() bytes of the default output
+         */
+        template<typename = std::enable_if<SynchronousInference>>
+        void inferSynchronousScheduledPrepacked(std::span<const uint8_t> packedInput, std::span<uint8_t> packedOutput) {
+            const ScheduledDevice& first = scheduledDevices.front();
+            if (packedInput.size() != first.inputPlan->bytes() || packedOutput.size() != first.outputPlan->bytes()) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Packed batch of " + std::to_string(packedInput.size()) + " input and " + std::to_string(packedOutput.size()) + " output bytes does not match the " +
+                                                           std::to_string(first.inputPlan->bytes()) + " and " + std::to_string(first.outputPlan->bytes()) + " bytes of the buffers");
+            }
+            recordRequest(batchElements, packedInput);
+            requeueOnTimeout([&]() {
+                auto lease = accelerator.acquireBufferSet();
+                const ScheduledDevice& target = scheduledDevices[lease.position()];
+                DeviceHandler& device = lease.get();
+                std::copy(packedInput.begin(), packedInput.end(), device.getInputBuffer(target.inputKernelName)->getMap(lease.slot()).begin());
+                {
+                    auto deviceLock = lease.lockDevice();
+                    device.setActiveBufferSlot(lease.slot());
+                    device.run();
+                    device.wait();
+                    device.read();
+                }
+                auto results = device.getOutputBuffer(target.outputKernelName)->getMap(lease.slot());
+                std::copy(results.begin(), results.begin() + static_cast<std::ptrdiff_t>(packedOutput.size()), packedOutput.begin());
+                return packedOutput.size();
+            });
+        }
+
+        /**
+         * @brief Run one batch of synchronous inference on an idle compute unit pair of the accelerator. On devices with replicated compute units (@see
+         * DeviceWrapper::replicatedComputeUnits) every idma/odma pair has its own buffers and runs independently, so as many callers as there are pairs can have a batch on
+         * the card at the same time and a design replicated n times reaches up to n times the throughput. Other devices contribute their first input and output as one pair.
+         * Thread safe, so several threads can drive different pairs at the same time.
+         * @attention All pairs are expected to run the same design. Changing the batch size while inferences are running is not allowed, and neither is mixing this with the
+         * other inference functions. The pairs always use the active buffer slot.
+         *
+         * @tparam IteratorType
+         * @tparam V Output datatype
+         * @param first Iterator to first element of input
+         * @param last  Iterator to end of input
+         * @param output Output buffer. Has to hold at least batchSize * unpacked output featuremap elements
+         * @return std::size_t Number of elements written to output
+         */
+        template<typename IteratorType, typename V, typename = std::enable_if<SynchronousInference>>
+        std::size_t inferSynchronousReplicated(IteratorType first, IteratorType last, std::span<V> output) {
+            return requeueOnTimeout([&]() {
+                auto lease = accelerator.acquireComputeUnits();
+                const ScheduledDevice& target = scheduledDevices[lease.position()];
+                DeviceHandler& device = lease.get();
+                const ComputeUnitPair& pair = lease.pair();
+                packInput(first, last, *target.inputPlan, device.getInputBuffer(pair.inputKernelName)->getMap());
+                device.run(pair);
+                device.wait(pair);
+                device.read(pair);
+                return unpackOutput<V>(device.getOutputBuffer(pair.outputKernelName)->getMap(), *target.outputPlan, output, hostPool.get());
+            });
+        }
+
+        /**
+         * @brief Number of compute unit pairs of all devices, that is how many batches inferSynchronousReplicated can have in flight at once
+         *
+         * @return std::size_t
+         */
+        std::size_t getComputeUnitPairCount() {
+            return std::accumulate(accelerator.begin(), accelerator.end(), std::size_t{0}, [](std::size_t sum, const DeviceHandler& device) { return sum + device.getComputeUnitPairs().size(); });
+        }
+
+        /**
+         * @brief Run synchronous inference on an input that contains several batches and spread the batches over all devices of the accelerator.
+         * One host thread per buffer slot of every device pulls batches and dispatches them with inferSynchronousScheduled, so faster devices process more batches with
+         * SCHEDULING_POLICY::LEAST_OUTSTANDING, and with several slots the host work of a batch overlaps with the execution of another one on the same device.
+         * Devices with replicated compute units are driven by one thread per compute unit pair with inferSynchronousReplicated instead.
+         * The results are written to the output in input order. With a single device this is the same as inferSynchronousPipelined on the default input and output.
+         *
+         * @tparam IteratorType Random access iterator
+         * @tparam V Output datatype
+         * @param first Iterator to first element of input
+         * @param last  Iterator to end of input. The input has to contain a whole number of batches.
+         * @param output Output buffer. Has to hold the unpacked outputs of all batches
+         * @return std::size_t Number of elements written to output
+         */
+        template<std::random_access_iterator IteratorType, typename V, typename = std::enable_if<SynchronousInference>>
+        std::size_t inferSynchronousDataParallel(IteratorType first, IteratorType last, std::span<V> output) {
+            // Replicated compute units are driven pair by pair, each with one thread, instead of slot by slot
+            const std::size_t computeUnitPairs = getComputeUnitPairCount();
+            const bool replicated = computeUnitPairs > scheduledDevices.size();
+            if (scheduledDevices.size() < 2 && !replicated) {
+                return inferSynchronousPipelined(first, last, output, defaultInputDeviceIndex, defaultInputKernelName, defaultOutputDeviceIndex, defaultOutputKernelName);
+            }
+            const auto inputElementsPerBatch = static_cast<std::ptrdiff_t>(scheduledDevices[0].inputPlan->elements());
+            const std::size_t outputElementsPerBatch = scheduledDevices[0].outputPlan->elements();
+            if (std::any_of(scheduledDevices.begin(), scheduledDevices.end(), [&](const ScheduledDevice& target) {
+                    return static_cast<std::ptrdiff_t>(target.inputPlan->elements()) != inputElementsPerBatch || target.outputPlan->elements() != outputElementsPerBatch;
+                })) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " Data parallel inference requires all devices to have the same input and output sizes");
+            }
+            const auto totalInputs = std::distance(first, last);
+            if (totalInputs % inputElementsPerBatch != 0) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " Input length (" + std::to_string(totalInputs) + ") is not a multiple of the batch input size (" + std::to_string(inputElementsPerBatch) + ")");
+            }
+            const auto batches = static_cast<std::size_t>(totalInputs / inputElementsPerBatch);
+            if (output.size() < batches * outputElementsPerBatch) {
+                FinnUtils::logAndError<std::length_error>(loggerPrefix() + " Output buffer too small for " + std::to_string(batches) + " batches");
+            }
+
+            std::atomic<std::size_t> nextBatch = 0;
+            std::vector<std::exception_ptr> errors(std::min<std::size_t>(replicated ? computeUnitPairs : scheduledDevices.size() * bufferSlots, batches));
+            auto work = [&](std::exception_ptr& error) {
+                try {
+                    for (std::size_t batch = nextBatch.fetch_add(1, std::memory_order_relaxed); batch < batches; batch = nextBatch.fetch_add(1, std::memory_order_relaxed)) {
+                        auto batchBegin = first + static_cast<std::ptrdiff_t>(batch) * inputElementsPerBatch;
+                        if (replicated) {
+                            inferSynchronousReplicated(batchBegin, batchBegin + inputElementsPerBatch, output.subspan(batch * outputElementsPerBatch, outputElementsPerBatch));
+                        } else {
+                            inferSynchronousScheduled(batchBegin, batchBegin + inputElementsPerBatch, output.subspan(batch * outputElementsPerBatch, outputElementsPerBatch));
+                        }
+                    }
+                } catch (...) {
+                    error = std::current_exception();
+                    // Stop the other threads from starting new batches
+                    nextBatch.store(batches, std::memory_order_relaxed);
+                }
+            };
+            {
+                std::vector<std::jthread> threads;
+                threads.reserve(errors.size());
+                for (auto& error : errors) {
+                    threads.emplace_back(work, std::ref(error));
+                }
+            }
+            for (auto&& error : errors) {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+            return batches * outputElementsPerBatch;
+        }
+
+        /**
+         * @brief Run synchronous inference through a network that is partitioned over several devices (@see getPipelineDepth). The output of every stage is handed to the next
+         * stage device to device (XRT P2P, with a host fallback), and batches are interleaved: while stage s processes batch k, stage s+1 processes batch k-1, so all devices are busy.
+         * Without links in the config this is the same as inferSynchronousPipelined on the default input and output.
+         *
+         * @tparam IteratorType Random access iterator
+         * @tparam V Output datatype
+         * @param first Iterator to first element of input
+         * @param last  Iterator to end of input. The input has to contain a whole number of batches.
+         * @param output Output buffer. Has to hold the unpacked outputs of the last stage for all batches
+         * @return std::size_t Number of elements written to output
+         */
+        template<std::random_access_iterator IteratorType, typename V, typename = std::enable_if<SynchronousInference>>
+        std::size_t inferSynchronousModelParallel(IteratorType first, IteratorType last, std::span<V> output) {
+            if (pipelineStages.empty()) {
+                return inferSynchronousPipelined(first, last, output, defaultInputDeviceIndex, defaultInputKernelName, defaultOutputDeviceIndex, defaultOutputKernelName);
+            }
+            const TransferPlan& inputPlan = getInputPlan(pipelineStages.front().deviceIndex, pipelineStages.front().inputKernelName);
+            const TransferPlan& outputPlan = getOutputPlan(pipelineStages.back().deviceIndex, pipelineStages.back().outputKernelName);
+            const auto inputElementsPerBatch = static_cast<std::ptrdiff_t>(inputPlan.elements());
+            const std::size_t outputElementsPerBatch = outputPlan.elements();
+            const auto totalInputs = std::distance(first, last);
+            if (totalInputs % inputElementsPerBatch != 0) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " Input length (" + std::to_string(totalInputs) + ") is not a multiple of the batch input size (" + std::to_string(inputElementsPerBatch) + ")");
+            }
+            const auto batches = static_cast<std::size_t>(totalInputs / inputElementsPerBatch);
+            if (output.size() < batches * outputElementsPerBatch) {
+                FinnUtils::logAndError<std::length_error>(loggerPrefix() + " Output buffer too small for " + std::to_string(batches) + " batches");
+            }
+
+            std::vector<std::shared_ptr<DeviceInputBuffer<uint8_t>>> inputs;
+            std::vector<std::shared_ptr<DeviceOutputBuffer<uint8_t>>> outputs;
+            for (auto&& stage : pipelineStages) {
+                inputs.emplace_back(getInputBuffer(stage.deviceIndex, stage.inputKernelName));
+                outputs.emplace_back(getOutputBuffer(stage.deviceIndex, stage.outputKernelName));
+            }
+            const std::size_t stages = pipelineStages.size();
+            // Stage s works on batch step - s
+            auto active = [&](std::size_t stage, std::size_t step) { return step >= stage && step - stage < batches; };
+            for (std::size_t step = 0; step + 1 < batches + stages; ++step) {
+                // Hand over the results of the previous step before any stage overwrites them
+                for (std::size_t stage = stages - 1; stage > 0; --stage) {
+                    if (active(stage, step)) {
+                        inputs[stage]->loadFrom(*outputs[stage - 1]);
+                    }
+                }
+                if (step < batches) {
+                    auto batchBegin = first + static_cast<std::ptrdiff_t>(step) * inputElementsPerBatch;
+                    packInput(batchBegin, batchBegin + inputElementsPerBatch, inputPlan, inputs.front()->getMap());
+                }
+                for (std::size_t stage = 0; stage < stages; ++stage) {
+                    if (active(stage, step)) {
+                        outputs[stage]->run();
+                        inputs[stage]->run();
+                    }
+                }
+                for (std::size_t stage = 0; stage < stages; ++stage) {
+                    if (active(stage, step)) {
+                        outputs[stage]->wait();
+                    }
+                }
+                if (step + 1 >= stages) {
+                    const std::size_t batch = step + 1 - stages;
+                    outputs.back()->read();
+                    unpackOutput<V>(outputs.back()->getMap(), outputPlan, output.subspan(batch * outputElementsPerBatch, outputElementsPerBatch), hostPool.get());
+                }
+            }
+            return batches * outputElementsPerBatch;
+        }
+
+        /**
+         * @brief Implements the synchronous inference operation
+         *
+         * @tparam IteratorType
+         * @tparam V Return datatype, usually automatically determined
+         * @tparam typename
+         * @param first Iterator to first element of input
+         * @param last  Iterator to end of input
+         * @param inputDeviceIndex index of input FPGA
+         * @param inputBufferKernelName name of input kernel
+         * @param outputDeviceIndex index of output FPGA
+         * @param outputBufferKernelName name of output kernel
+         * @param forceArchival Unused for synchronous inference, results are always read directly from the output buffer
+         * @return Finn::vector<V>
+         */
+        template<typename IteratorType, typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<SynchronousInference>>
+        [[nodiscard]] Finn::vector<V> inferSynchronous(IteratorType first, IteratorType last, uint inputDeviceIndex, const std::string& inputBufferKernelName, uint outputDeviceIndex, const std::string& outputBufferKernelName,
+                                                       [[maybe_unused]] bool forceArchival) {
+            Finn::vector<V> unpacked(getOutputPlan(outputDeviceIndex, outputBufferKernelName).elements());
+            inferSynchronous(first, last, std::span<V>(unpacked.data(), unpacked.size()), inputDeviceIndex, inputBufferKernelName, outputDeviceIndex, outputBufferKernelName);
+            return unpacked;
+        }
+
+        /**
+         * @brief Implements the synchronous inference operation
+         *
+         * @tparam IteratorType
+         * @tparam V
+         * @tparam typename
+         * @param first
+         * @param last
+         * @return Finn::vector<V>
+         */
+        template<typename IteratorType, typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<SynchronousInference>>
+        [[nodiscard]] Finn::vector<V> inferSynchronous(IteratorType first, IteratorType last) {
+            return inferSynchronous(first, last, defaultInputDeviceIndex, defaultInputKernelName, defaultOutputDeviceIndex, defaultOutputKernelName, forceAchieval);
+        }
+
+        /**
+         * @brief Implements the synchronous inference operation
+         *
+         * @tparam U
+         * @tparam V
+         * @tparam typename
+         * @param data
+         * @param inputDeviceIndex
+         * @param inputBufferKernelName
+         * @param outputDeviceIndex
+         * @param outputBufferKernelName
+         * @param forceArchival
+         * @return Finn::vector<V>
+         */
+        template<typename U, typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<SynchronousInference>>
+        [[nodiscard]] Finn::vector<V> inferSynchronous(const Finn::vector<U>& data, uint inputDeviceIndex, const std::string& inputBufferKernelName, uint outputDeviceIndex, const std::string& outputBufferKernelName, bool forceArchival) {
+            return inferSynchronous(data.begin(), data.end(), inputDeviceIndex, inputBufferKernelName, outputDeviceIndex, outputBufferKernelName, batchElements, forceArchival);
+        }
+
+        /**
+         * @brief Implements the synchronous inference operation
+         *
+         * @tparam U
+         * @tparam V
+         * @tparam typename
+         * @param data
+         * @return Finn::vector<V>
+         */
+        template<typename U, typename V = Finn::UnpackingAutoRetType::AutoRetType<S>, typename = std::enable_if<SynchronousInference>>
+        [[nodiscard]] Finn::vector<V> inferSynchronous(const Finn::vector<U>& data) {
+            return inferSynchronous(data, defaultInputDeviceIndex, defaultInputKernelName, defaultOutputDeviceIndex, defaultOutputKernelName, batchElements, forceAchieval);
+        }
+
+
+         protected:
+        /**
+         * @brief Find the configuration of the given device
+         *
+         * @param deviceIndex
+         * @return const DeviceWrapper&
+         */
+        const DeviceWrapper& findDeviceWrapper(uint deviceIndex) const {
+            auto devWrap = std::find_if(configuration.deviceWrappers.begin(), configuration.deviceWrappers.end(), [deviceIndex](const DeviceWrapper& dew) { return dew.xrtDeviceIndex == deviceIndex; });
+            if (devWrap == configuration.deviceWrappers.end()) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " No device with index " + std::to_string(deviceIndex));
+            }
+            return *devWrap;
+        }
+
+        /**
+         * @brief Find the configuration of the given output buffer
+         *
+         * @param outputDeviceIndex
+         * @param outputBufferKernelName
+         * @return const ExtendedBufferDescriptor*
+         */
+        const ExtendedBufferDescriptor* findOutputDescriptor(uint outputDeviceIndex, const std::string& outputBufferKernelName) const {
+            for (auto&& devWrap : configuration.deviceWrappers) {
+                if (devWrap.xrtDeviceIndex != outputDeviceIndex) {
+                    continue;
+                }
+                for (auto&& odma : devWrap.odmas) {
+                    if (odma->kernelName == outputBufferKernelName) {
+                        return static_cast<const ExtendedBufferDescriptor*>(odma.get());
+                    }
+                }
+            }
+            FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " No output buffer " + outputBufferKernelName + " on device " + std::to_string(outputDeviceIndex));
+            return nullptr;
+        }
+
+        /**
+         * @brief Unpack a sequence of packed batch elements (e.g. the archive of an asynchronous output buffer) according to the shapes of the given output
+         *
+         * @tparam V Output datatype
+         * @param packed Packed batch elements
+         * @param descriptor Configuration of the output the data came from
+         * @return Finn::vector<V>
+         */
+        template<typename V>
+        Finn::vector<V> unpackParts(const Finn::vector<uint8_t>& packed, const ExtendedBufferDescriptor& descriptor) {
+            const auto bytesPerPart = TransferPlan::forBatchSize(descriptor.foldedShape, descriptor.packedShape, 1, S().bitwidth()).bytes();
+            const auto plan = TransferPlan::forBatchSize(descriptor.foldedShape, descriptor.packedShape, static_cast<unsigned int>(packed.size() / bytesPerPart), S().bitwidth());
+            Finn::vector<V> unpacked(plan.elements());
+            unpackOutput<V>(std::span<const uint8_t>(packed.data(), packed.size()), plan, std::span<V>(unpacked.data(), unpacked.size()), hostPool.get());
+            return unpacked;
+        }
+
+        /**
+         * @brief Find the configuration of the given input buffer
+         *
+         * @param inputDeviceIndex
+         * @param inputBufferKernelName
+         * @return const ExtendedBufferDescriptor*
+         */
+        const ExtendedBufferDescriptor* findInputDescriptor(uint inputDeviceIndex, const std::string& inputBufferKernelName) const {
+            for (auto&& devWrap : configuration.deviceWrappers) {
+                if (devWrap.xrtDeviceIndex != inputDeviceIndex) {
+                    continue;
+                }
+                for (auto&& idma : devWrap.idmas) {
+                    if (idma->kernelName == inputBufferKernelName) {
+                        return static_cast<const ExtendedBufferDescriptor*>(idma.get());
+                    }
+                }
+            }
+            FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " No input buffer " + inputBufferKernelName + " on device " + std::to_string(inputDeviceIndex));
+            return nullptr;
+        }
+
+        /**
+         * @brief Get the transfer plan of the given input for the current batch size. The plan is built on first use of the batch size and cached until the host layout changes.
+         *
+         * @param inputDeviceIndex
+         * @param inputBufferKernelName
+         * @return const TransferPlan&
+         */
+        const TransferPlan& getInputPlan(uint inputDeviceIndex, const std::string& inputBufferKernelName) {
+            auto& plans = inputPlans[batchElements][inputDeviceIndex];
+            if (auto plan = plans.find(inputBufferKernelName); plan != plans.end()) {
+                return plan->second;
+            }
+            return plans.emplace(inputBufferKernelName, makeInputPlan(inputDeviceIndex, inputBufferKernelName, batchElements)).first->second;
+        }
+
+        /**
+         * @brief Drop the cached transfer plans of all batch sizes, e.g. after a host layout changed, and rebuild the scheduling targets that point into them
+         *
+         */
+        void invalidatePlans() {
+            inputPlans.clear();
+            outputPlans.clear();
+            ++sessionGeneration;
+            prepareScheduledDevices();
+        }
+
+        /**
+         * @brief Build the transfer plan of an input for a batch size, with the host layout set by setInputLayout attached
+         *
+         * @param inputDeviceIndex
+         * @param inputBufferKernelName
+         * @param batchSize
+         * @return TransferPlan
+         */
+        TransferPlan makeInputPlan(uint inputDeviceIndex, const std::string& inputBufferKernelName, uint batchSize) const {
+            const auto* descriptor = findInputDescriptor(inputDeviceIndex, inputBufferKernelName);
+            auto plan = TransferPlan::forBatchSize(descriptor->foldedShape, descriptor->packedShape, batchSize, F().bitwidth());
+            if (auto device = inputLayouts.find(inputDeviceIndex); device != inputLayouts.end()) {
+                if (auto layout = device->second.find(inputBufferKernelName); layout != device->second.end()) {
+                    plan.sourceLayout = layout->second;
+                }
+            }
+            return plan;
+        }
+
+        /**
+         * @brief Get the transfer plan of the given output for the current batch size. The plan is built on first use of the batch size and cached.
+         *
+         * @param outputDeviceIndex
+         * @param outputBufferKernelName
+         * @return const TransferPlan&
+         */
+        const TransferPlan& getOutputPlan(uint outputDeviceIndex, const std::string& outputBufferKernelName) {
+            auto& plans = outputPlans[batchElements][outputDeviceIndex];
+            if (auto plan = plans.find(outputBufferKernelName); plan != plans.end()) {
+                return plan->second;
+            }
+            const auto* descriptor = findOutputDescriptor(outputDeviceIndex, outputBufferKernelName);
+            return plans.emplace(outputBufferKernelName, TransferPlan::forBatchSize(descriptor->foldedShape, descriptor->packedShape, batchElements, S().bitwidth())).first->second;
+        }
+
+        /**
+         * @brief Memory demands of all buffers of the config with the current archive caps
+         *
+         * @return std::vector<BufferDemand>
+         */
+        std::vector<BufferDemand> memoryDemands() const {
+            std::vector<BufferDemand> demands;
+            for (auto&& devWrap : configuration.deviceWrappers) {
+                for (auto&& descriptor : devWrap.idmas) {
+                    demands.push_back({descriptor->kernelName, IO::INPUT, SynchronousInference, FinnUtils::shapeToElements(descriptor->packedShape), 0, devWrap.memoryArena && !descriptor->producer});
+                }
+                for (auto&& descriptor : devWrap.odmas) {
+                    demands.push_back({descriptor->kernelName, IO::OUTPUT, SynchronousInference, FinnUtils::shapeToElements(descriptor->packedShape), devWrap.archiveCapacity, devWrap.memoryArena});
+                }
+            }
+            return demands;
+        }
+
+        /**
+         * @brief Staging memory of the driver. Synchronous inference packs straight into the buffer objects, asynchronous requests are packed into a staging area
+         * before they are copied into the ring buffer, which holds at most one batch of the largest input per submitting thread.
+         *
+         * @param maxBatch
+         * @return std::size_t
+         */
+        std::size_t stagingBytes(uint maxBatch) const {
+            if constexpr (SynchronousInference) {
+                return 0;
+            }
+            std::size_t largest = 0;
+            for (auto&& devWrap : configuration.deviceWrappers) {
+                for (auto&& descriptor : devWrap.idmas) {
+                    largest = std::max(largest, FinnUtils::shapeToElements(descriptor->packedShape) * maxBatch);
+                }
+            }
+            return largest;
+        }
+
+        /**
+         * @brief Check settings against the memory budget and apply the archive cap they leave room for. Nothing is changed if they do not fit.
+         *
+         * @param demands
+         * @param maxBatch
+         * @param slots Requested number of buffer slots
+         * @return uint Number of buffer slots that fit, smaller than requested only with MEMORY_POLICY::DEGRADE
+         */
+        uint fitMemoryBudget(const std::vector<BufferDemand>& demands, uint maxBatch, uint slots) {
+            if (memoryBudget == 0) {
+                return slots;
+            }
+            const auto plan = planMemory(demands, maxBatch, slots, stagingBytes(maxBatch), memoryBudget, memoryPolicy);
+            if (plan.degraded) {
+                FINN_LOG(logger, loglevel::warning) << loggerPrefix() << "Reduced the host buffers to fit the memory budget of " << memoryBudget << " bytes: " << plan.bufferSlots << " of " << slots
+                                                    << " buffer slot(s), archive capacity " << plan.archiveCapacity << " bytes";
+            }
+            if constexpr (!SynchronousInference) {
+                accelerator.setArchiveCapacity(plan.archiveCapacity);
+            }
+            return plan.bufferSlots;
+        }
+
+        /**
+         * @brief Fit the buffers for the given batch size into the memory budget, giving up buffer slots if the policy permits it
+         *
+         * @param maxBatch
+         */
+        void fitBuffersToBudget(uint maxBatch) {
+            if (const uint slots = fitMemoryBudget(memoryDemands(), maxBatch, bufferSlots); slots != bufferSlots) {
+                accelerator.setBufferSlots(slots);
+                bufferSlots = slots;
+                ++sessionGeneration;
+            }
+        }
+
+        /**
+         * @brief Pin the host thread pool to the CPUs local to the default input device if its affinity policy is DEVICE_LOCAL, so inputs are packed into and outputs are
+         * unpacked from its buffers on the NUMA node of the card
+         *
+         */
+        void placeHostPool() {
+            const auto& cpus = accelerator.getDeviceHandler(defaultInputDeviceIndex).getLocalCpus();
+            if (!cpus.empty()) {
+                setHostThreadPool(std::min(ThreadPool::defaultThreads(), cpus.size()), cpus);
+            }
+        }
+
+        /**
+         * @brief Build the transfer plans of the first input and output of every device for the scheduler
+         *
+         */
+        void prepareScheduledDevices() {
+            scheduledDevices.clear();
+            scheduledDevices.reserve(configuration.deviceWrappers.size());
+            for (auto&& devWrap : configuration.deviceWrappers) {
+                if (devWrap.idmas.empty() || devWrap.odmas.empty()) {
+                    FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " Device " + std::to_string(devWrap.xrtDeviceIndex) + " needs at least one input and one output to be scheduled");
+                }
+                ScheduledDevice target{devWrap.xrtDeviceIndex, devWrap.idmas[0]->kernelName, devWrap.odmas[0]->kernelName};
+                target.inputPlan = &getInputPlan(target.deviceIndex, target.inputKernelName);
+                target.outputPlan = &getOutputPlan(target.deviceIndex, target.outputKernelName);
+                // The replicas share the plans of the first pair
+                if (devWrap.replicatedComputeUnits) {
+                    for (std::size_t i = 1; i < devWrap.idmas.size(); ++i) {
+                        if (getInputPlan(target.deviceIndex, devWrap.idmas[i]->kernelName).bytes() != target.inputPlan->bytes() ||
+                            getOutputPlan(target.deviceIndex, devWrap.odmas[i]->kernelName).elements() != target.outputPlan->elements()) {
+                            FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " The replicated compute units of device " + std::to_string(devWrap.xrtDeviceIndex) + " differ in their folded shapes");
+                        }
+                    }
+                }
+                scheduledDevices.emplace_back(std::move(target));
+            }
+        }
+
+        /**
+         * @brief Follow the producer links of the config from the first input that is supplied by the host to the last device, whose first output is the pipeline output
+         *
+         */
+        void preparePipeline() {
+            pipelineStages.clear();
+            // (producer device, producer kernel) -> consuming input
+            std::map<std::pair<uint, std::string>, std::pair<uint, std::string>> consumers;
+            for (auto&& devWrap : configuration.deviceWrappers) {
+                for (auto&& idma : devWrap.idmas) {
+                    if (idma->producer) {
+                        consumers.emplace(std::make_pair(idma->producer->xrtDeviceIndex, idma->producer->kernelName), std::make_pair(devWrap.xrtDeviceIndex, idma->kernelName));
+                    }
+                }
+            }
+            if (consumers.empty()) {
+                return;
+            }
+            auto findFeedingOutput = [&](const DeviceWrapper& devWrap) -> const BufferDescriptor* {
+                auto feeds = std::find_if(devWrap.odmas.begin(), devWrap.odmas.end(), [&](const auto& odma) { return consumers.contains({devWrap.xrtDeviceIndex, odma->kernelName}); });
+                return (feeds == devWrap.odmas.end()) ? nullptr : feeds->get();
+            };
+
+            // The pipeline starts at the first device that feeds another one and has an input supplied by the host
+            std::pair<uint, std::string> current;
+            bool found = false;
+            for (auto&& devWrap : configuration.deviceWrappers) {
+                auto hostInput = std::find_if(devWrap.idmas.begin(), devWrap.idmas.end(), [](const auto& idma) { return !idma->producer; });
+                if (hostInput != devWrap.idmas.end() && findFeedingOutput(devWrap) != nullptr) {
+                    current = {devWrap.xrtDeviceIndex, (*hostInput)->kernelName};
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " The device links in the config do not form a pipeline with a host input");
+            }
+            while (true) {
+                const DeviceWrapper& devWrap = findDeviceWrapper(current.first);
+                if (pipelineStages.size() >= configuration.deviceWrappers.size()) {
+                    FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " The device links in the config contain a cycle");
+                }
+                const BufferDescriptor* feeds = findFeedingOutput(devWrap);
+                if (feeds == nullptr) {
+                    if (devWrap.odmas.empty()) {
+                        FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " Last pipeline stage on device " + std::to_string(devWrap.xrtDeviceIndex) + " has no output");
+                    }
+                    pipelineStages.push_back({current.first, current.second, devWrap.odmas[0]->kernelName});
+                    break;
+                }
+                pipelineStages.push_back({current.first, current.second, feeds->kernelName});
+                current = consumers.at({devWrap.xrtDeviceIndex, feeds->kernelName});
+            }
+            FINN_LOG(logger, loglevel::info) << loggerPrefix() << "Model parallel pipeline over " << pipelineStages.size() << " devices";
+        }
+
+        /**
+         * @brief Get the completion queue of an output. The first call registers the queue as result callback of the output buffer. Requires asyncSubmitMutex to be held.
+         *
+         * @param outputDeviceIndex
+         * @param outputBufferKernelName
+         * @return AsyncCompletionQueue&
+         */
+        AsyncCompletionQueue& getCompletionQueue(uint outputDeviceIndex, const std::string& outputBufferKernelName) {
+            auto [queue, inserted] = completionQueues.try_emplace({outputDeviceIndex, outputBufferKernelName});
+            if (inserted) {
+                queue->second = std::make_unique<AsyncCompletionQueue>();
+                accelerator.setResultCallback(outputDeviceIndex, outputBufferKernelName, [target = queue->second.get()](std::span<const uint8_t> packed) { target->deliver(packed); });
+            }
+            return *queue->second;
+        }
+
+        /**
+         * @brief Pack and store the input of an asynchronous request and register its completion. @see inferAsync
+         *
+         * @tparam V Output datatype
+         * @tparam IteratorType
+         * @tparam Completion Callable with signature void(Finn::vector<V>&&, std::exception_ptr)
+         * @param first Iterator to first element of input
+         * @param last  Iterator to end of input
+         * @param inputDeviceIndex
+         * @param inputBufferKernelName
+         * @param outputDeviceIndex
+         * @param outputBufferKernelName
+         * @param batchSize Batch size contained in the input
+         * @param completion Invoked exactly once, usually from the worker thread of the output buffer
+         */
+        template<typename V, typename IteratorType, typename Completion>
+        void submitAsync(IteratorType first, IteratorType last, uint inputDeviceIndex, const std::string& inputBufferKernelName, uint outputDeviceIndex, const std::string& outputBufferKernelName, uint batchSize,
+                         Completion&& completion) {
+            if (batchSize == 0) {
+                FinnUtils::logAndError<std::invalid_argument>(loggerPrefix() + " Asynchronous requests need at least one batch element");
+            }
+            auto storeFunc = accelerator.storeFactory(inputDeviceIndex, inputBufferKernelName);
+            const auto inputPlan = makeInputPlan(inputDeviceIndex, inputBufferKernelName, batchSize);
+            if (static_cast<std::size_t>(std::abs(std::distance(first, last))) != inputPlan.elements()) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " Input length (" + std::to_string(std::abs(std::distance(first, last))) + ") does not match up with batches*inputsize_per_batch (" +
+                                                           std::to_string(inputPlan.elements()) + ")");
+            }
+            // Only needed until the input is copied into the ring buffer
+            MemoryArena& arena = MemoryArena::threadLocal();
+            MemoryArena::Scope scope(arena);
+            arena_vector<uint8_t> packed(inputPlan.bytes(), ArenaAllocator<uint8_t>(arena));
+            packInput(first, last, inputPlan, std::span<uint8_t>(packed.data(), packed.size()));
+            const auto* descriptor = findOutputDescriptor(outputDeviceIndex, outputBufferKernelName);
+            const std::size_t bytesPerPart = size(SIZE_SPECIFIER::FEATUREMAP_SIZE, outputDeviceIndex, outputBufferKernelName);
+            // Unpacking happens on the worker thread of the output buffer once all parts of the request have arrived
+            auto complete = [plan = TransferPlan::forBatchSize(descriptor->foldedShape, descriptor->packedShape, batchSize, S().bitwidth()), pool = hostPool, completion = std::forward<Completion>(completion)](
+                                Finn::vector<uint8_t>&& result, std::exception_ptr error) mutable {
+                if (error) {
+                    completion(Finn::vector<V>(), error);
+                    return;
+                }
+                Finn::vector<V> unpacked(plan.elements());
+                try {
+                    unpackOutput<V>(result, plan, std::span<V>(unpacked.data(), unpacked.size()), pool.get());
+                } catch (...) {
+                    completion(Finn::vector<V>(), std::current_exception());
+                    return;
+                }
+                completion(std::move(unpacked), nullptr);
+            };
+
+            AsyncCompletionQueue* queue = nullptr;
+            std::mutex* storeMutex = nullptr;
+            {
+                std::lock_guard guard(*asyncSubmitMutex);
+                queue = &getCompletionQueue(outputDeviceIndex, outputBufferKernelName);
+                auto& slot = asyncStoreMutexes[{inputDeviceIndex, inputBufferKernelName}];
+                if (!slot) {
+                    slot = std::make_unique<std::mutex>();
+                }
+                storeMutex = slot.get();
+            }
+            // Blocks while the ring is full, which the input worker resolves on its own
+            std::lock_guard storeGuard(*storeMutex);
+            const std::size_t id = queue->enqueue(batchSize, bytesPerPart, std::move(complete));
+            try {
+                storeFunc(packed.begin(), packed.end());
+            } catch (...) {
+                queue->cancel(id, std::current_exception());
+                throw;
+            }
+        }
+
+        /**
+         * @brief Run the batch in the mapped input buffer like runPrepacked, but look up every sample in the result cache first. The misses are moved to the front of
+         * the input buffer and run as a smaller batch, which the device buffers support without reallocation, and a batch of hits only does not touch the device at all.
+         * @attention The returned span is only valid until the next inference or change of the batch size!
+         *
+         * @param inputDeviceIndex
+         * @param inputBufferKernelName
+         * @param outputDeviceIndex
+         * @param outputBufferKernelName
+         * @return std::span<const uint8_t> Packed results of the whole batch, in the mapped output buffer if no sample was a hit
+         */
+        std::span<const uint8_t> runCached(uint inputDeviceIndex, const std::string& inputBufferKernelName, uint outputDeviceIndex, const std::string& outputBufferKernelName) {
+            auto inputMap = getPackedInputMap(inputDeviceIndex, inputBufferKernelName);
+            const std::size_t outputBytes = getPackedOutputBytes(outputDeviceIndex, outputBufferKernelName);
+            const std::size_t inputPerSample = inputMap.size() / batchElements;
+            const std::size_t outputPerSample = outputBytes / batchElements;
+            auto sampleInput = [&](std::size_t sample) { return inputMap.subspan(sample * inputPerSample, inputPerSample); };
+
+            cachedResults.resize(outputBytes);
+            std::span<uint8_t> results(cachedResults);
+            std::vector<std::size_t> misses;
+            for (std::size_t sample = 0; sample < batchElements; ++sample) {
+                if (!resultCache->lookup(sampleInput(sample), results.subspan(sample * outputPerSample, outputPerSample))) {
+                    // Compact the misses, a miss only ever moves to a slot in front of it
+                    if (misses.size() != sample) {
+                        std::copy_n(sampleInput(sample).begin(), inputPerSample, sampleInput(misses.size()).begin());
+                    }
+                    misses.push_back(sample);
+                }
+            }
+            if (misses.empty()) {
+                resultCache->countSkippedBatch();
+                return results;
+            }
+            if (misses.size() == batchElements) {
+                auto deviceResults = runPrepacked(outputDeviceIndex, outputBufferKernelName);
+                for (std::size_t sample = 0; sample < batchElements; ++sample) {
+                    resultCache->insert(sampleInput(sample), deviceResults.subspan(sample * outputPerSample, outputPerSample));
+                }
+                return deviceResults;
+            }
+
+            // Only the valid part of the buffers is transferred for the smaller batch
+            accelerator.setBatchSize(static_cast<uint>(misses.size()));
+            try {
+                accelerator.run();
+                accelerator.wait();
+                accelerator.read();
+            } catch (...) {
+                accelerator.setBatchSize(batchElements);
+                throw;
+            }
+            accelerator.setBatchSize(batchElements);
+            auto deviceResults = getOutputBuffer(outputDeviceIndex, outputBufferKernelName)->getMap();
+            for (std::size_t miss = 0; miss < misses.size(); ++miss) {
+                auto result = deviceResults.subspan(miss * outputPerSample, outputPerSample);
+                std::copy(result.begin(), result.end(), results.begin() + static_cast<std::ptrdiff_t>(misses[miss] * outputPerSample));
+                resultCache->insert(sampleInput(miss), result);
+            }
+            return results;
+        }
+
+        /**
+         * @brief Pack one batch of input into the given mapped input buffer region
+         *
+         * @tparam IteratorType
+         * @param first Iterator to first element of input
+         * @param last  Iterator to end of input
+         * @param plan Transfer plan of the input buffer
+         * @param inputMap Mapped memory of the input buffer (slot) the packed data is written to
+         * @param record Record the batch into a running capture, false for batches that are only packed and not run
+         */
+        template<typename IteratorType>
+        void packInput(IteratorType first, IteratorType last, const TransferPlan& plan, std::span<uint8_t> inputMap, bool record = true) {
+            {
+                FINN_TIME_STAGE(VALIDATE);
+                if (plan.bytes() != inputMap.size()) {
+                    FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " Packed input length (" + std::to_string(plan.bytes()) + ") does not match up with the input buffer size (" + std::to_string(inputMap.size()) + ")");
+                }
+            }
+            bool packedStatic = false;
+            if constexpr (InputShape::isStatic && std::random_access_iterator<IteratorType>) {
+                if (InputShape::matches(plan) && !plan.sourceLayout) {
+                    Finn::packStaticInputs<F, InputShape>(first, last, plan.innerDims, inputMap, hostPool.get());
+                    packedStatic = true;
+                }
+            }
+            if (!packedStatic) {
+                Finn::packMultiDimensionalInputs<F>(first, last, plan, inputMap, hostPool.get());
+            }
+            if (record) {
+                recordRequest(plan.packedShape[0], inputMap);
+            }
+        }
+
+        /**
+         * @brief Unpack an output following its transfer plan. Uses the kernels specialised for OutputShape if the plan has its row geometry.
+         *
+         * @tparam V Output datatype
+         * @param packed Packed output bytes
+         * @param plan Transfer plan of the output buffer
+         * @param output Has to hold at least plan.elements() elements
+         * @param pool Thread pool to unpack with, unpacks on the calling thread if nullptr
+         * @return std::size_t Number of elements written to output
+         */
+        template<typename V>
+        static std::size_t unpackOutput(std::span<const uint8_t> packed, const TransferPlan& plan, std::span<V> output, ThreadPool* pool = nullptr) {
+            if constexpr (OutputShape::isStatic) {
+                if (OutputShape::matches(plan)) {
+                    return Finn::unpackStaticOutputs<S, OutputShape, V>(packed, plan.innerDims, output, pool);
+                }
+            }
+            return Finn::unpackMultiDimensionalOutputs<S, V>(packed, plan, output, pool);
+        }
+
+        /**
+         * @brief Run a scheduled batch until a device finishes it in time. A batch that timed out left its device stuck and returned its lease, so the next attempt is
+         * scheduled on another device. Nothing was written to the output of a failed attempt, the outputs are only read after the wait.
+         *
+         * @tparam Attempt
+         * @param attempt Schedules and runs the batch once
+         * @return std::size_t Number of elements written to output
+         */
+        template<typename Attempt>
+        std::size_t requeueOnTimeout(Attempt&& attempt) {
+            for (std::size_t tries = 1;; ++tries) {
+                try {
+                    return attempt();
+                } catch (const KernelTimeoutError&) {
+                    if (tries >= accelerator.deviceCount()) {
+                        throw;
+                    }
+                    FINN_LOG(logger, loglevel::warning) << loggerPrefix() << "Requeueing batch after a kernel timeout (attempt " << tries + 1 << " of " << accelerator.deviceCount() << ")";
+                }
+            }
+        }
+
+        /**
+         * @brief Check that the compile time shapes, if any, describe the default input and output of the config
+         *
+         */
+        void validateStaticShapes() {
+            if constexpr (InputShape::isStatic) {
+                if (!InputShape::matches(*findInputDescriptor(defaultInputDeviceIndex, defaultInputKernelName))) {
+                    FinnUtils::logAndError<std::invalid_argument>(loggerPrefix() + "The compile time shapes of the input do not match input " + defaultInputKernelName + " of the config!");
+                }
+            }
+            if constexpr (OutputShape::isStatic) {
+                if (!OutputShape::matches(*findOutputDescriptor(defaultOutputDeviceIndex, defaultOutputKernelName))) {
+                    FinnUtils::logAndError<std::invalid_argument>(loggerPrefix() + "The compile time shapes of the output do not match output " + defaultOutputKernelName + " of the config!");
+                }
+            }
+        }
+
+        /**
+         *
+         * @brief Do an inference with the given data. This assumes already flattened data in uint8_t's. Specify inputs and outputs.
+         *
+         * @param first Iterator to first element in input sequence
+         * @param last  Iterator to last element in input sequence
+         * @param inputDeviceIndex
+         * @param inputBufferKernelName
+         * @param outputDeviceIndex
+         * @param outputBufferKernelName
+         * @param batchSize
+         * @param forceArchival If true, the data gets written to LTS either way, ensuring that there is data to be read!
+         * @return Finn::vector<uint8_t>
+         */
+        template<typename IteratorType>
+        [[nodiscard]] Finn::vector<uint8_t> infer(IteratorType first, IteratorType last, uint inputDeviceIndex, const std::string& inputBufferKernelName, uint outputDeviceIndex, const std::string& outputBufferKernelName, uint batchSize,
+                                                  bool forceArchival) {
+            FINN_LOG_DEBUG(logger, loglevel::info) << loggerPrefix() << "Starting inference (raw data)";
+            auto storeFunc = accelerator.storeFactory(inputDeviceIndex, inputBufferKernelName);
+
+            {
+                FINN_TIME_STAGE(VALIDATE);
+                if (std::abs(std::distance(first, last)) != size(SIZE_SPECIFIER::TOTAL_DATA_SIZE, inputDeviceIndex, inputBufferKernelName)) {
+                    FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " Input length (" + std::to_string(std::abs(std::distance(first, last))) + ") does not match up with batches*inputsize_per_batch (" +
+                                                               std::to_string(size(SIZE_SPECIFIER::FEATUREMAP_SIZE, inputDeviceIndex, inputBufferKernelName)) + "*" + std::to_string(batchSize) + "=" +
+                                                               std::to_string(size(SIZE_SPECIFIER::TOTAL_DATA_SIZE, inputDeviceIndex, inputBufferKernelName)) + ")");
+                }
+            }
+
+            bool stored = storeFunc(first, last);
 
             accelerator.run();
 
@@ -448,6 +2615,18 @@ namespace Finn {
             Finn::vector<uint8_t> data(first, last);
             FINN_LOG(logger, loglevel::info) << "Readback from device buffer confirming data was written to board successfully: " << isSyncedDataEquivalent(inputDeviceIndex, inputBufferKernelName, data);
 #endif
+            return collectResults(outputDeviceIndex, outputBufferKernelName, forceArchival);
+        }
+
+        /**
+         * @brief Wait for a started run of the accelerator to finish and read back the results
+         *
+         * @param outputDeviceIndex
+         * @param outputBufferKernelName
+         * @param forceArchival If true, the data gets written to LTS either way, ensuring that there is data to be read!
+         * @return Finn::vector<uint8_t>
+         */
+        [[nodiscard]] Finn::vector<uint8_t> collectResults(uint outputDeviceIndex, const std::string& outputBufferKernelName, bool forceArchival) {
             accelerator.wait();
 
             FINN_LOG_DEBUG(logger, loglevel::info) << "Reading out buffers";
@@ -16,13 +16,74 @@
 #include <FINNCppDriver/utils/FinnUtils.h>
 
 #include <FINNCppDriver/core/DeviceBuffer/DeviceBuffer.hpp>
+#include <FINNCppDriver/utils/SegmentedStorage.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stop_token>
 #include <thread>
 
 #include "ert.h"
 
 namespace Finn {
 
+    /**
+     * @brief Hands the number of samples every run of an asynchronous input moved to the paired asynchronous output, so that the output DMA is started once per
+     * input run and for exactly as many samples, instead of speculatively one sample at a time.
+     *
+     */
+    class AsyncLaunchChannel {
+         private:
+        mutable std::mutex launchMutex;
+        std::condition_variable_any launched;
+        std::size_t pendingParts = 0;
+
+         public:
+        /**
+         * @brief Announce that an input run for the given number of samples was started
+         *
+         * @param parts
+         */
+        void post(std::size_t parts) {
+            {
+                std::lock_guard guard(launchMutex);
+                pendingParts += parts;
+            }
+            launched.notify_one();
+        }
+
+        /**
+         * @brief Wait until input samples were announced and take up to maxParts of them
+         *
+         * @param maxParts Number of samples the output buffer object can hold
+         * @param stoken Aborts the wait
+         * @return std::size_t Number of samples taken, 0 if stop was requested
+         */
+        std::size_t take(std::size_t maxParts, std::stop_token stoken) {
+            std::unique_lock lock(launchMutex);
+            if (!launched.wait(lock, stoken, [this]() { return pendingParts > 0; })) {
+                return 0;
+            }
+            const std::size_t parts = std::min(pendingParts, maxParts);
+            pendingParts -= parts;
+            return parts;
+        }
+
+        /**
+         * @brief Number of announced samples the output was not started for yet
+         *
+         * @return std::size_t
+         */
+        std::size_t pending() const {
+            std::lock_guard guard(launchMutex);
+            return pendingParts;
+        }
+    };
+
     namespace detail {
         /**
          * @brief Wrapper that contains the ringbuffer used by Asynchronous Input & Output Buffers
@@ -82,8 +143,15 @@ namespace Finn {
              * @return AsyncBufferWrapper&
              */
             AsyncBufferWrapper& operator=(const AsyncBufferWrapper& buf) = delete;
-#ifdef UNITTEST
+
              public:
+            /**
+             * @brief Get the host memory of the ring buffer
+             *
+             * @return std::size_t
+             */
+            std::size_t ringBufferBytes() const { return ringBuffer.size(SIZE_SPECIFIER::BYTES); }
+#ifdef UNITTEST
             RingBuffer<T, true>& testGetRingBuffer() { return this->ringBuffer; }
 #endif
         };
@@ -98,20 +166,43 @@ namespace Finn {
     class AsyncDeviceInputBuffer : public DeviceInputBuffer<T>, public detail::AsyncBufferWrapper<T> {
          private:
         friend class DeviceInputBuffer<T>;
+        /**
+         * @brief True while a started run of the IP core has not been observed to finish. Only accessed by the worker thread.
+         *
+         */
+        bool runInFlight = false;
+        /**
+         * @brief Paired output that is told about every run, empty if the output DMA is started on its own
+         *
+         */
+        std::shared_ptr<AsyncLaunchChannel> launches;
         std::jthread workerThread;
 
         /**
-         * @brief Internal run method used by the runner thread
+         * @brief Internal run method used by the runner thread. Transfers all batch elements that are waiting in the ring buffer, up to the capacity of the buffer object,
+         * with one sync and one kernel run, and waits for the run to complete before the map is overwritten.
          *
          */
         void runInternal(std::stop_token stoken) {
+            FINN_TRACE_THREAD_NAME(this->name + " worker");
             const std::size_t elementCount = this->ringBuffer.size(SIZE_SPECIFIER::FEATUREMAP_SIZE);
             while (!stoken.stop_requested()) {
-                if (!this->loadMap(stoken)) {  // blocks
+                if (runInFlight) {
+                    if (!this->waitForCompletion(stoken)) {
+                        break;
+                    }
+                    runInFlight = false;
+                }
+                const std::size_t parts = this->loadMap(stoken);  // blocks
+                if (parts == 0) {
                     break;
                 }
-                this->sync(elementCount);
-                // this->execute(); TODO(linusjun): Fix all this shit!
+                this->sync(parts * elementCount);
+                this->execute(static_cast<uint32_t>(parts));
+                runInFlight = true;
+                if (launches) {
+                    launches->post(parts);
+                }
             }
             FINN_LOG(this->logger, loglevel::info) << "Asynchronous Input buffer runner terminated";
         }
@@ -124,12 +215,22 @@ namespace Finn {
          * @param device XRT device
          * @param pAssociatedKernel XRT kernel
          * @param pShapePacked packed shape of input
-         * @param ringBufferSizeFactor size of ringbuffer in input elements (batch elements)
+         * @param ringBufferSizeFactor size of ringbuffer in input elements (batch elements). The buffer object holds as many, so a full ring buffer is moved with one run.
+         * @param pLaunches Channel to the paired output buffer, or nullptr
+         * @param policy Wait policy of the worker thread, @see setWaitPolicy
+         * @param pSpinBudget
          */
-        AsyncDeviceInputBuffer(const std::string& pCUName, xrt::device& device, xrt::uuid& pDevUUID, const shapePacked_t& pShapePacked, unsigned int ringBufferSizeFactor)
-            : DeviceInputBuffer<T>(pCUName, device, pDevUUID, pShapePacked),
+        AsyncDeviceInputBuffer(const std::string& pCUName, xrt::device& device, xrt::uuid& pDevUUID, const shapePacked_t& pShapePacked, unsigned int ringBufferSizeFactor,
+                               std::shared_ptr<AsyncLaunchChannel> pLaunches = nullptr, WAIT_POLICY policy = WAIT_POLICY::SPIN, unsigned int pSpinBudget = defaultSpinBudget)
+            : DeviceInputBuffer<T>(pCUName, device, pDevUUID, pShapePacked, std::max(ringBufferSizeFactor, 1U)),
               detail::AsyncBufferWrapper<T>(ringBufferSizeFactor, FinnUtils::shapeToElements(pShapePacked)),
-              workerThread(std::jthread(std::bind_front(&AsyncDeviceInputBuffer::runInternal, this))){};
+              launches(std::move(pLaunches)) {
+            // The shape describes a single batch element, as everywhere else for asynchronous buffers
+            this->shapePacked[0] = 1;
+            // Set before the worker starts, so it never has to be restarted for the initial policy
+            DeviceInputBuffer<T>::setWaitPolicy(policy, pSpinBudget);
+            workerThread = std::jthread(std::bind_front(&AsyncDeviceInputBuffer::runInternal, this));
+        };
 
         /**
          * @brief Construct a new Async Device Input Buffer object
@@ -166,6 +267,22 @@ namespace Finn {
          */
         AsyncDeviceInputBuffer& operator=(const AsyncDeviceInputBuffer& buf) = delete;
 
+        /**
+         * @brief Set the wait policy. The worker thread is paused while the policy is changed, and left alone if nothing changes.
+         *
+         * @param policy
+         * @param pSpinBudget
+         */
+        void setWaitPolicy(WAIT_POLICY policy, unsigned int pSpinBudget = defaultSpinBudget) override {
+            if (policy == this->waitPolicy && pSpinBudget == this->spinBudget) {
+                return;
+            }
+            workerThread.request_stop();
+            workerThread.join();
+            DeviceInputBuffer<T>::setWaitPolicy(policy, pSpinBudget);
+            workerThread = std::jthread(std::bind_front(&AsyncDeviceInputBuffer::runInternal, this));
+        }
+
         /**
          * @brief Return the size of the buffer as specified by the argument. Bytes returns all bytes the buffer takes up, elements returns the number of T-values, numbers the number of F-values.
          *
@@ -185,15 +302,30 @@ namespace Finn {
 
          protected:
         /**
-         * @brief  Load data from the ring buffer into the memory map of the device.
+         * @brief Load data from the ring buffer into the memory map of the device. Blocks until one part is available and then takes all parts that are waiting,
+         * up to the capacity of the buffer object, one after another into the map.
          * @attention Invalidates the data that was moved to map
          *
-         * @return true
-         * @return false
+         * @return std::size_t Number of parts in the map, 0 if stop was requested
          */
-        bool loadMap(std::stop_token stoken) {
-            FINN_LOG(this->logger, loglevel::info) << "Data transfer of input data to FPGA!\n";
-            return this->ringBuffer.read(this->map, stoken);
+        std::size_t loadMap(std::stop_token stoken) {
+            FINN_LOG_THROTTLED(this->logger, loglevel::info, std::chrono::seconds(1)) << "Data transfer of input data to FPGA!\n";
+            auto part = this->ringBuffer.claimRead(stoken);  // blocks
+            if (part.empty()) {
+                return 0;
+            }
+            FINN_TRACE_SCOPE("loadMap");
+            const std::size_t maxParts = this->getMaxBatchSize();
+            std::size_t parts = 0;
+            while (true) {
+                std::copy(part.begin(), part.end(), this->map + parts * part.size());
+                this->ringBuffer.commitRead();
+                // Parts that are stored while this one was copied are taken along, but the worker never waits for more
+                if (++parts == maxParts || this->ringBuffer.empty()) {
+                    return parts;
+                }
+                part = this->ringBuffer.claimRead();
+            }
         }
 
         /**
@@ -213,31 +345,131 @@ namespace Finn {
      */
     template<typename T>
     class AsyncDeviceOutputBuffer : public DeviceOutputBuffer<T>, public detail::AsyncBufferWrapper<T> {
+         public:
+        /**
+         * @brief Callback invoked by the worker thread with the packed result of every batch element. The span is only valid during the call.
+         *
+         */
+        using ResultCallback = std::function<void(std::span<const T>)>;
+
+         private:
+        /**
+         * @brief Results that left the ring buffer and wait to be retrieved by the user
+         *
+         */
+        SegmentedStorage<T> longTermStorage;
+        /**
+         * @brief Serializes the consumers of the ring buffer
+         *
+         */
         std::mutex ltsMutex;
+        /**
+         * @brief Guards resultCallback. Only held to copy or replace it, never while the callback runs, so the callback can call back into the buffer.
+         *
+         */
+        std::mutex callbackMutex;
+        /**
+         * @brief Held by the worker thread while it runs a callback, so setResultCallback can wait until the replaced callback returned
+         *
+         */
+        std::mutex invocationMutex;
+        std::shared_ptr<const ResultCallback> resultCallback;
+        std::atomic<std::thread::id> workerId;
+        /**
+         * @brief True while a started run of the IP core has not been observed to finish. Only accessed by the worker thread.
+         *
+         */
+        bool runInFlight = false;
+        /**
+         * @brief Number of batch elements the run in flight reads
+         *
+         */
+        std::size_t runParts = 0;
+        /**
+         * @brief Number of batch elements of the last finished run that were already handed on. Lets a paused worker continue where it stopped.
+         *
+         */
+        std::size_t publishedParts = 0;
+        /**
+         * @brief Input runs to start the output DMA for, empty if it is started speculatively for one batch element at a time
+         *
+         */
+        std::shared_ptr<AsyncLaunchChannel> launches;
         std::jthread workerThread;
 
-         private:
+        /**
+         * @brief Internal run method used by the reader thread. Starts the output DMA, for as many batch elements as the paired input run moved or for one batch element
+         * if there is no paired input, waits for its completion and only then syncs the results and hands them to the registered callback or the ring buffer.
+         *
+         */
         void readInternal(std::stop_token stoken) {
+            FINN_TRACE_THREAD_NAME(this->name + " reader");
+            workerId = std::this_thread::get_id();
             FINN_LOG_DEBUG(this->logger, loglevel::info) << this->loggerPrefix() << "Starting to read from the device";
             const std::size_t elementCount = this->ringBuffer.size(SIZE_SPECIFIER::FEATUREMAP_SIZE);
             while (!stoken.stop_requested()) {
-                // auto outExecuteResult = execute();
-                // std::cout << outExecuteResult << "\n";
-                // if (outExecuteResult != ERT_CMD_STATE_COMPLETED && outExecuteResult != ERT_CMD_STATE_ERROR && outExecuteResult != ERT_CMD_STATE_ABORT) {
-                //     continue;
-                // }
-                // if (outExecuteResult == ERT_CMD_STATE_ERROR || outExecuteResult == ERT_CMD_STATE_ABORT) {
-                //     FINN_LOG(this->logger, loglevel::error) << "A problem has occured during the read process of the FPGA output.";
-                //     continue;
-                // }
-                this->sync(elementCount);
-                saveMap();
-                if (this->ringBuffer.full()) {  // TODO(linusjun): Allow registering of callback for this event?
-                    archiveValidBufferParts();
+                // Finish handing on the results of the last run, in case the worker was paused in the middle of it
+                if (publishedParts < runParts && !runInFlight && !publishMap(stoken)) {
+                    break;
+                }
+                if (!runInFlight) {
+                    publishedParts = 0;
+                    runParts = launches ? launches->take(this->getMaxBatchSize(), stoken) : 1;  // blocks
+                    if (runParts == 0) {
+                        break;
+                    }
+                    this->execute(static_cast<uint32_t>(runParts));
+                    runInFlight = true;
+                }
+                if (!this->waitForCompletion(stoken)) {
+                    break;
+                }
+                runInFlight = false;
+                this->sync(runParts * elementCount);
+                if (!publishMap(stoken)) {
+                    break;
                 }
             }
         }
 
+        /**
+         * @brief Hand the batch elements of the last run that are still in the memory map to the result callback, if one is registered, or to the ring buffer otherwise
+         *
+         * @param stoken
+         * @return true
+         * @return false Stop was requested before all data could be stored
+         */
+        bool publishMap(std::stop_token stoken) {
+            const std::size_t elementCount = this->ringBuffer.size(SIZE_SPECIFIER::FEATUREMAP_SIZE);
+            while (publishedParts < runParts) {
+                const T* first = this->map + publishedParts * elementCount;
+                {
+                    std::lock_guard invocation(invocationMutex);
+                    std::shared_ptr<const ResultCallback> callback;
+                    {
+                        std::lock_guard guard(callbackMutex);
+                        callback = resultCallback;
+                    }
+                    if (callback) {
+                        (*callback)(std::span<const T>(first, elementCount));
+                        ++publishedParts;
+                        continue;
+                    }
+                }
+                if (!saveMap(stoken, first)) {
+                    return false;
+                }
+                ++publishedParts;
+                // Once the archive is at its cap, nothing further is taken from the device until the user retrieved results
+                while (this->ringBuffer.full()) {
+                    if (archiveValidBufferParts() == 0 && !longTermStorage.waitForSpace(stoken)) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
          public:
         /**
          * @brief Construct a new Async Device Output Buffer object
@@ -246,12 +478,23 @@ namespace Finn {
          * @param device XRT device
          * @param pAssociatedKernel XRT kernel
          * @param pShapePacked packed shape of input
-         * @param ringBufferSizeFactor size of ringbuffer in input elements (batch elements)
+         * @param ringBufferSizeFactor size of ringbuffer in input elements (batch elements). The buffer object holds as many, so one run can read a whole input run.
+         * @param pLaunches Channel from the paired input buffer, or nullptr to start the output DMA speculatively for one batch element at a time
+         * @param policy Wait policy of the worker thread, @see setWaitPolicy
+         * @param pSpinBudget
          */
-        AsyncDeviceOutputBuffer(const std::string& pCUName, xrt::device& device, xrt::uuid& pDevUUID, const shapePacked_t& pShapePacked, unsigned int ringBufferSizeFactor)
-            : DeviceOutputBuffer<T>(pCUName, device, pDevUUID, pShapePacked),
+        AsyncDeviceOutputBuffer(const std::string& pCUName, xrt::device& device, xrt::uuid& pDevUUID, const shapePacked_t& pShapePacked, unsigned int ringBufferSizeFactor,
+                                std::shared_ptr<AsyncLaunchChannel> pLaunches = nullptr, WAIT_POLICY policy = WAIT_POLICY::SPIN, unsigned int pSpinBudget = defaultSpinBudget)
+            : DeviceOutputBuffer<T>(pCUName, device, pDevUUID, pShapePacked, std::max(ringBufferSizeFactor, 1U)),
               detail::AsyncBufferWrapper<T>(ringBufferSizeFactor, FinnUtils::shapeToElements(pShapePacked)),
-              workerThread(std::jthread(std::bind_front(&AsyncDeviceOutputBuffer::readInternal, this))){};
+              longTermStorage(FinnUtils::shapeToElements(pShapePacked), ringBufferSizeFactor, capacityToParts(defaultArchiveCapacity, FinnUtils::shapeToElements(pShapePacked))),
+              launches(std::move(pLaunches)) {
+            // The shape describes a single batch element, as everywhere else for asynchronous buffers
+            this->shapePacked[0] = 1;
+            // Set before the worker starts, so it never has to be restarted for the initial policy
+            DeviceOutputBuffer<T>::setWaitPolicy(policy, pSpinBudget);
+            workerThread = std::jthread(std::bind_front(&AsyncDeviceOutputBuffer::readInternal, this));
+        };
 
         /**
          * @brief Construct a new Async Device Output Buffer object (Move constructor)
@@ -290,6 +533,43 @@ namespace Finn {
          */
         AsyncDeviceOutputBuffer& operator=(const AsyncDeviceOutputBuffer& buf) = delete;
 
+        /**
+         * @brief Set the wait policy. The worker thread is paused while the policy is changed, and left alone if nothing changes.
+         * Results the worker already read from the device but could not hand on before it was paused are published when it resumes.
+         *
+         * @param policy
+         * @param pSpinBudget
+         */
+        void setWaitPolicy(WAIT_POLICY policy, unsigned int pSpinBudget = defaultSpinBudget) override {
+            if (policy == this->waitPolicy && pSpinBudget == this->spinBudget) {
+                return;
+            }
+            workerThread.request_stop();
+            workerThread.join();
+            DeviceOutputBuffer<T>::setWaitPolicy(policy, pSpinBudget);
+            workerThread = std::jthread(std::bind_front(&AsyncDeviceOutputBuffer::readInternal, this));
+        }
+
+        /**
+         * @brief Register a callback that is invoked from the worker thread with the packed result of every batch element as soon as it was read from the device.
+         * While a callback is registered, results are not stored in the ring buffer or the archive. Passing an empty function restores the archiving behaviour.
+         * The callback may call back into the buffer, including replacing or clearing itself. Called from another thread, this waits until a running call of the
+         * replaced callback returned.
+         *
+         * @param callback
+         */
+        void setResultCallback(ResultCallback callback) {
+            auto replacement = callback ? std::make_shared<const ResultCallback>(std::move(callback)) : nullptr;
+            {
+                std::lock_guard guard(callbackMutex);
+                resultCallback.swap(replacement);
+            }
+            // Called from the callback itself, the worker cannot be waited for. Otherwise the replaced callback is not running anymore once this returns.
+            if (std::this_thread::get_id() != workerId.load()) {
+                std::lock_guard invocation(invocationMutex);
+            }
+        }
+
         /**
          * @brief Return the size of the buffer as specified by the argument. Bytes returns all bytes the buffer takes up, elements returns the number of T-values, numbers the number of F-values.
          *
@@ -299,35 +579,65 @@ namespace Finn {
         size_t size(SIZE_SPECIFIER ss) override { return this->ringBuffer.size(ss); }
 
         /**
-         * @brief Put every valid read part of the ring buffer into the archive. This invalides them so that they are not put into the archive again.
-         * @note After the function is executed, all parts are invalid.
-         * @note This function can be executed manually instead of wait for it to be called by read() when the ring buffer is full.
+         * @brief Move valid parts of the ring buffer into the archive, as far as its capacity permits. The archive mutex serializes the consumers of the ring buffer.
+         * Archived parts are invalidated, so that they are not put into the archive again.
+         * @note This function can be executed manually instead of waiting for the worker thread to call it when the ring buffer is full.
          *
+         * @return std::size_t Number of archived parts
          */
-        void archiveValidBufferParts() {
+        std::size_t archiveValidBufferParts() {
             std::lock_guard guard(ltsMutex);
-            this->longTermStorage.reserve(this->longTermStorage.size() + this->ringBuffer.size());
-            this->ringBuffer.readAllValidParts(std::back_inserter(this->longTermStorage));
+            std::size_t archived = 0;
+            for (std::size_t available = this->ringBuffer.size(); archived < available; ++archived) {
+                if (!longTermStorage.tryAppend(this->ringBuffer.claimRead())) {
+                    break;
+                }
+                this->ringBuffer.commitRead();
+            }
+            return archived;
         }
 
         /**
-         * @brief Return the archive.
+         * @brief Return the archive and clear it. The archived chunks are swapped out under the lock and only joined afterwards.
          *
          * @return Finn::vector<T>
          */
-        Finn::vector<T> getData() {
-            std::lock_guard guard(ltsMutex);
-            Finn::vector<T> tmp(this->longTermStorage);
-            clearArchive();
-            return tmp;
-        }
+        Finn::vector<T> getData() override { return longTermStorage.take(); }
 
         /**
-         * @brief Reserve enough storage for the expectedEntries number of entries. Note however that because this is a vec of vecs, this only allocates memory for the pointers, not the data itself.
+         * @brief Return the archive as the chunks it was stored in and clear it. Avoids joining the chunks into one vector.
          *
-         * @param expectedEntries
+         * @return SegmentedStorage<T>::chunks_t
          */
-        void allocateLongTermStorage([[maybe_unused]] unsigned int expectedEntries) { this->longTermStorage.reserve(expectedEntries * this->ringBuffer.size(SIZE_SPECIFIER::FEATUREMAP_SIZE)); }
+        typename SegmentedStorage<T>::chunks_t getDataChunks() { return longTermStorage.takeChunks(); }
+
+        /**
+         * @brief Set the memory cap of the archive. While the archive is full, the worker thread stops reading from the device until results are retrieved.
+         *
+         * @param bytes Cap in bytes, rounded down to whole batch elements but at least one. 0 removes the cap.
+         */
+        void setArchiveCapacity(std::size_t bytes) { longTermStorage.setCapacity(capacityToParts(bytes, longTermStorage.getElementsPerPart())); }
+
+        /**
+         * @brief Get the memory cap of the archive in bytes, 0 if unbounded
+         *
+         * @return std::size_t
+         */
+        std::size_t getArchiveCapacity() const { return longTermStorage.getCapacity() * longTermStorage.getElementsPerPart() * sizeof(T); }
+
+        /**
+         * @brief Number of batch elements currently held by the archive
+         *
+         * @return std::size_t
+         */
+        std::size_t getArchivedParts() const { return longTermStorage.size(); }
+
+        /**
+         * @brief Host memory currently held by the archive
+         *
+         * @return std::size_t
+         */
+        std::size_t getArchivedBytes() const { return longTermStorage.size() * longTermStorage.getElementsPerPart() * sizeof(T); }
 
         /**
          * @brief Not supported by the AsyncDeviceOutputBuffer.
@@ -346,19 +656,50 @@ namespace Finn {
 
          protected:
         /**
-         * @brief Store the contents of the memory map into the ring buffer.
+         * @brief Store one batch element of the memory map into the next free part of the ring buffer.
          *
+         * @param stoken Aborts waiting for a free part
+         * @param first Start of the batch element in the map
+         * @return true
+         * @return false Stop was requested before a part became free
          */
-        void saveMap() {
-            FINN_LOG(this->logger, loglevel::info) << "Data transfer of output from FPGA!\n";
-            this->ringBuffer.template store<T*>(this->map, this->ringBuffer.size(SIZE_SPECIFIER::FEATUREMAP_SIZE));
+        bool saveMap(std::stop_token stoken, const T* first) {
+            FINN_LOG_THROTTLED(this->logger, loglevel::info, std::chrono::seconds(1)) << "Data transfer of output from FPGA!\n";
+            auto part = this->ringBuffer.claimWrite(stoken);
+            if (part.empty()) {
+                return false;
+            }
+            FINN_TRACE_SCOPE("saveMap");
+            std::copy(first, first + part.size(), part.begin());
+            this->ringBuffer.commitWrite();
+            return true;
         }
 
         /**
          * @brief Clear the archive of all it's entries
          *
          */
-        void clearArchive() { this->longTermStorage.clear(); }
+        void clearArchive() { longTermStorage.clear(); }
+
+        /**
+         * @brief Convert a cap in bytes into whole batch elements
+         *
+         * @param bytes 0 if unbounded
+         * @param elementsPerPart
+         * @return std::size_t
+         */
+        static std::size_t capacityToParts(std::size_t bytes, std::size_t elementsPerPart) {
+            if (bytes == 0) {
+                return 0;
+            }
+            return std::max<std::size_t>(1, bytes / (elementsPerPart * sizeof(T)));
+        }
+
+#ifdef UNITTEST
+         public:
+        unsigned int testGetLongTermStorageSize() const { return longTermStorage.elements(); }
+        SegmentedStorage<T>& testGetLTS() { return longTermStorage; }
+#endif
     };
 }  // namespace Finn
 
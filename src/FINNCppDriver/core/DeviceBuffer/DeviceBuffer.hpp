@@ -16,11 +16,21 @@
 #include <FINNCppDriver/utils/Logger.h>
 #include <FINNCppDriver/utils/Types.h>
 
+#include <FINNCppDriver/core/DeviceBuffer/DeviceMemoryArena.hpp>
+#include <FINNCppDriver/utils/DeviceMetrics.hpp>
+#include <FINNCppDriver/utils/Instrumentation.hpp>
 #include <FINNCppDriver/utils/RingBuffer.hpp>
 #include <boost/type_index.hpp>
 #include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
 #include <future>
+#include <memory>
+#include <optional>
 #include <span>
+#include <stdexcept>
+#include <stop_token>
 #include <thread>
 
 #include "experimental/xrt_ip.h"
@@ -36,6 +46,16 @@ constexpr uint32_t CSR_OFFSET = 0x0;
 enum ert_cmd_state;
 
 namespace Finn {
+    /**
+     * @brief Thrown if a kernel run missed the execute timeout of its buffer (@see DeviceBuffer::setExecuteTimeout), or if a device is used again after that before it
+     * was recovered. The kernel may still be running, so its buffers must not be reused until the device was reprogrammed.
+     *
+     */
+    class KernelTimeoutError : public std::runtime_error {
+         public:
+        using std::runtime_error::runtime_error;
+    };
+
     /**
      * @brief Parent class for DeviceBuffer objects.
      *
@@ -55,53 +75,325 @@ namespace Finn {
          */
         shapePacked_t shapePacked;
         /**
-         * @brief Numbers of type T: When F has bitwidth 2, and T has bitwidth 8, the folded shape would be (1,2,10) and the packed (1,2,3) and thus 6
+         * @brief Numbers of type T: When F has bitwidth 2, and T has bitwidth 8, the folded shape would be (1,2,10) and the packed (1,2,3) and thus 6. Rounded up to the
+         * next power of two for buffer objects of their own, exact for sub-buffers of a device memory arena.
          *
          */
         size_t mapSize;
+        /**
+         * @brief Number of batch elements the buffer objects were allocated for. The active batch size (shapePacked[0]) can be anything up to this.
+         *
+         */
+        unsigned int maxBatchSize;
+        /**
+         * @brief Memory group of the buffer objects. Queried once, because xrt::kernel must not be created after the IP core was acquired
+         *
+         */
+        unsigned int groupId;
+        /**
+         * @brief Device memory arena the buffer objects are sub-buffers of, empty if they are buffer objects of their own. Declared before them, so it outlives them.
+         *
+         */
+        std::shared_ptr<DeviceMemoryArena> arena;
         /**
          * @brief XRT buffer object; This is used to interact with FPGA memory
          *
          */
         xrt::bo internalBo;
+        /**
+         * @brief Additional XRT buffer objects used for multi buffering (slot 1 to n-1; slot 0 is internalBo)
+         *
+         */
+        std::vector<xrt::bo> additionalBos;
+        /**
+         * @brief Mapped memory of every buffer slot
+         *
+         */
+        std::vector<T*> slotMaps;
+        /**
+         * @brief FPGA addresses of every buffer slot
+         *
+         */
+        std::vector<long long> slotAddresses;
+        /**
+         * @brief Index of the buffer slot that is currently used by map, bufAdr, sync and execute
+         *
+         */
+        std::size_t activeSlot = 0;
         /**
          * @brief XRT IP core associated with this Buffer
          *
          */
         xrt::ip assocIPCore;
         /**
-         * @brief Mapped buffer; Part of the XRT buffer object
+         * @brief Mapped buffer of the active slot; Part of the XRT buffer object
          *
          */
         T* map;
         /**
-         * @brief 64 bit adress of the buffer located on the FPGA card
+         * @brief 64 bit adress of the active buffer slot located on the FPGA card
          *
          */
-        const long long bufAdr;
+        long long bufAdr;
         /**
          * @brief Logger
          *
          */
         logger_type& logger;
+        /**
+         * @brief Strategy used by wait() to detect the completion of the kernel
+         *
+         */
+        WAIT_POLICY waitPolicy = WAIT_POLICY::SPIN;
+        /**
+         * @brief Number of register polls before WAIT_POLICY::SPIN_YIELD starts yielding the CPU
+         *
+         */
+        unsigned int spinBudget = defaultSpinBudget;
+        /**
+         * @brief Interrupt notification of the IP core. Only set for WAIT_POLICY::INTERRUPT
+         *
+         */
+        std::optional<xrt::ip::interrupt> ipInterrupt;
+        /**
+         * @brief Longest time a synchronous wait gives a kernel run from its start, 0 to wait forever
+         *
+         */
+        std::chrono::microseconds executeTimeout{0};
+        /**
+         * @brief Asynchronous sync of a buffer slot that was started but not joined yet. At most one transfer per buffer is in flight.
+         *
+         */
+        std::optional<xrt::bo::async_handle> pendingTransfer;
+        /**
+         * @brief Buffer slot of the pending transfer
+         *
+         */
+        std::size_t pendingSlot = 0;
+        /**
+         * @brief Bytes of the pending transfer
+         *
+         */
+        std::size_t pendingBytes = 0;
+        /**
+         * @brief Start of the pending transfer
+         *
+         */
+        std::chrono::steady_clock::time_point pendingStart;
+        /**
+         * @brief Transfer and execution counters. Shared with the DeviceHandler, so they survive the reallocation of the buffer.
+         *
+         */
+        std::shared_ptr<BufferMetrics> metrics = std::make_shared<BufferMetrics>();
+        /**
+         * @brief Start of the kernel run that was not seen completing yet
+         *
+         */
+        std::optional<std::chrono::steady_clock::time_point> executeStart;
+        /**
+         * @brief Buffer slot of the kernel run that was not seen completing yet
+         *
+         */
+        std::size_t executeSlot = 0;
+        /**
+         * @brief Timeline track the kernel runs of this buffer are recorded on, empty to not record them. @see TimelineTracer::deviceTrack
+         *
+         */
+        std::optional<std::uint32_t> timelineTrack;
+        /**
+         * @brief Register of the IP core that holds the cycles of the last run, if the bitstream provides one
+         *
+         */
+        std::optional<uint32_t> cycleCounterOffset;
+        /**
+         * @brief The buffer objects are in memory that host and programmable logic share without a cache that needs maintenance (embedded platforms), so syncs are
+         * skipped and pack and unpack work on the memory the kernels access
+         *
+         */
+        bool sharedMemory = false;
+
+        /**
+         * @brief Count the completion of the kernel run started by the last execute
+         *
+         */
+        void countCompletion() {
+            if (!executeStart) {
+                return;
+            }
+            const auto end = std::chrono::steady_clock::now();
+            metrics->countCompletion(end - *executeStart);
+#ifdef FINN_ENABLE_INSTRUMENTATION
+            if (timelineTrack) {
+                TimelineTracer::global().record(*timelineTrack, "run", *executeStart, end, static_cast<std::int64_t>(executeSlot), oldRepetitions);
+            }
+#endif  // FINN_ENABLE_INSTRUMENTATION
+            executeStart.reset();
+            if (cycleCounterOffset) {
+                metrics->countCycles(assocIPCore.read_register(*cycleCounterOffset));
+            }
+        }
+
+        /**
+         * @brief Check if the IP core signals idle
+         *
+         * @return true
+         * @return false
+         */
+        bool isIdle() const { return (assocIPCore.read_register(CSR_OFFSET) & IP_IDLE) == IP_IDLE; }
+
+        /**
+         * @brief Point in time the current kernel run has to be finished by
+         *
+         * @return std::optional<std::chrono::steady_clock::time_point> Empty if there is no execute timeout
+         */
+        std::optional<std::chrono::steady_clock::time_point> deadline() const {
+            if (executeTimeout.count() == 0) {
+                return std::nullopt;
+            }
+            return executeStart.value_or(std::chrono::steady_clock::now()) + executeTimeout;
+        }
+
+        /**
+         * @brief Give up on a kernel run that missed its deadline. The run is not counted as completed, since the kernel may still be busy.
+         *
+         */
+        [[noreturn]] void timedOut() {
+            metrics->countTimeout();
+            FinnUtils::logAndError<KernelTimeoutError>(loggerPrefix() + "Kernel did not finish within " + std::to_string(executeTimeout.count()) + "us");
+        }
+
+        /**
+         * @brief Throw a KernelTimeoutError if the deadline passed
+         *
+         * @param until
+         */
+        void checkDeadline(const std::optional<std::chrono::steady_clock::time_point>& until) {
+            if (until && std::chrono::steady_clock::now() >= *until) {
+                timedOut();
+            }
+        }
 
         void busyWait() {
             // Wait until the IP is DONE
-            uint32_t axi_ctrl = 0;
-            while ((axi_ctrl & IP_IDLE) != IP_IDLE) {
-                axi_ctrl = assocIPCore.read_register(CSR_OFFSET);
+            const auto until = deadline();
+            while (!isIdle()) {
+                checkDeadline(until);
+            }
+        }
+
+        /**
+         * @brief Poll the IP core for spinBudget iterations, afterwards yield the CPU between polls
+         *
+         */
+        void spinYieldWait() {
+            for (unsigned int i = 0; i < spinBudget; ++i) {
+                if (isIdle()) {
+                    return;
+                }
+                FinnUtils::cpuRelax();
+            }
+            const auto until = deadline();
+            while (!isIdle()) {
+                checkDeadline(until);
+                std::this_thread::yield();
+            }
+        }
+
+        /**
+         * @brief Block on the interrupt of the IP core until it is done. Does not poll.
+         *
+         */
+        void interruptWait() {
+            if (isIdle()) {
+                return;
+            }
+            const auto until = deadline();
+            if (!until) {
+                ipInterrupt->wait();
+                return;
+            }
+            const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(*until - std::chrono::steady_clock::now());
+            if ((remaining.count() <= 0 || ipInterrupt->wait(remaining) == std::cv_status::timeout) && !isIdle()) {
+                timedOut();
+            }
+        }
+
+        /**
+         * @brief Wait for the IP core to finish using the configured WAIT_POLICY. Throws a KernelTimeoutError if the run misses the execute timeout.
+         *
+         */
+        void waitForCompletion() {
+            FINN_TIME_STAGE(WAIT);
+            switch (waitPolicy) {
+                case WAIT_POLICY::SPIN_YIELD:
+                    spinYieldWait();
+                    break;
+                case WAIT_POLICY::INTERRUPT:
+                    interruptWait();
+                    break;
+                default:
+                    busyWait();
+                    break;
+            }
+            countCompletion();
+        }
+
+        /**
+         * @brief Wait for the IP core to finish using the configured WAIT_POLICY, but give up as soon as a stop is requested. Used by the asynchronous worker threads.
+         * There is no deadline, because asynchronous kernels legitimately wait as long as no data arrives.
+         *
+         * @param stoken
+         * @return true IP core finished
+         * @return false Stop was requested before the IP core finished
+         */
+        bool waitForCompletion(const std::stop_token& stoken) {
+            using namespace std::literals::chrono_literals;
+            FINN_TIME_STAGE(WAIT);
+            for (unsigned int polls = 0; !isIdle(); ++polls) {
+                if (stoken.stop_requested()) {
+                    return false;
+                }
+                if (waitPolicy == WAIT_POLICY::INTERRUPT) {
+                    ipInterrupt->wait(100ms);  // Timeout only bounds the reaction time to a stop request
+                } else if (waitPolicy == WAIT_POLICY::SPIN_YIELD && polls >= spinBudget) {
+                    std::this_thread::yield();
+                } else {
+                    FinnUtils::cpuRelax();
+                }
             }
+            countCompletion();
+            return true;
         }
 
          private:
         unsigned int getGroupId(const xrt::device& device, const xrt::uuid& uuid, const std::string& computeUnit) { return xrt::kernel(device, uuid, computeUnit).group_id(0); }
 
+        /**
+         * @brief Allocate the buffer object of one buffer slot, from the arena if there is one
+         *
+         * @param device
+         * @param boFlags
+         * @return xrt::bo
+         */
+        xrt::bo allocateBo(xrt::device& device, xrt::bo::flags boFlags) {
+            if (arena) {
+                return arena->allocate(mapSize * sizeof(T));
+            }
+            return xrt::bo(device, mapSize * sizeof(T), boFlags, groupId);
+        }
+
         /**
          * @brief Used for deciding if execute needs to write data registers or not
          *
          */
         uint32_t oldRepetitions = 0;
 
+        /**
+         * @brief Used for deciding if execute needs to write the buffer address or not
+         *
+         */
+        long long oldBufAdr = -1;
+
          public:
         /**
          * @brief Construct a new Device Buffer object
@@ -110,19 +402,36 @@ namespace Finn {
          * @param device XRT device
          * @param pAssociatedKernel XRT kernel
          * @param pShapePacked packed shape of input
+         * @param batchSize batch size
+         * @param bufferSlots Number of XRT buffer objects to rotate between (multi buffering)
+         * @param boFlags Allocation flags of the XRT buffer objects (e.g. xrt::bo::flags::p2p for buffers that are written by other devices)
+         * @param pArena Device memory arena of the memory group of the compute unit to take the buffer objects from, or nullptr to allocate them on their own
          */
-        DeviceBuffer(const std::string& pCUName, xrt::device& device, xrt::uuid& pDevUUID, const shapePacked_t& pShapePacked, unsigned int batchSize = 1)
+        DeviceBuffer(const std::string& pCUName, xrt::device& device, xrt::uuid& pDevUUID, const shapePacked_t& pShapePacked, unsigned int batchSize = 1, unsigned int bufferSlots = 1,
+                     xrt::bo::flags boFlags = xrt::bo::flags::normal, std::shared_ptr<DeviceMemoryArena> pArena = nullptr)
             : name(pCUName),
               shapePacked(pShapePacked),
-              mapSize(FinnUtils::getActualBufferSize(FinnUtils::shapeToElements(pShapePacked) * batchSize)),
-              internalBo(xrt::bo(device, mapSize * sizeof(T), getGroupId(device, pDevUUID, pCUName))),
+              mapSize(pArena ? std::max<std::size_t>(FinnUtils::shapeToElements(pShapePacked) * batchSize, 1) : FinnUtils::getActualBufferSize(FinnUtils::shapeToElements(pShapePacked) * batchSize)),
+              maxBatchSize(batchSize),
+              groupId(pArena ? pArena->getGroupId() : getGroupId(device, pDevUUID, pCUName)),
+              arena(std::move(pArena)),
+              internalBo(allocateBo(device, boFlags)),
               map(internalBo.template map<T*>()),
               assocIPCore(xrt::ip(device, pDevUUID, pCUName)),  // Using xrt::kernel/getGroupId after this point leads to a total bricking of the FPGA card!!
               bufAdr(internalBo.address()),
               logger(Logger::getLogger()) {
             shapePacked[0] = batchSize;
+            slotMaps.push_back(map);
+            slotAddresses.push_back(bufAdr);
+            additionalBos.reserve(bufferSlots > 1 ? bufferSlots - 1 : 0);
+            for (unsigned int i = 1; i < bufferSlots; ++i) {
+                additionalBos.emplace_back(allocateBo(device, boFlags));
+                slotMaps.push_back(additionalBos.back().template map<T*>());
+                slotAddresses.push_back(additionalBos.back().address());
+                std::fill(slotMaps.back(), slotMaps.back() + mapSize, 0);
+            }
             FINN_LOG(logger, loglevel::info) << "[DeviceBuffer] "
-                                             << "New Device Buffer of size " << mapSize * sizeof(T) << "bytes with group id " << 0 << "\n";
+                                             << "New Device Buffer of size " << mapSize * sizeof(T) << "bytes with group id " << groupId << " and " << slotMaps.size() << " buffer slot(s)\n";
             FINN_LOG(logger, loglevel::info) << "[DeviceBuffer] "
                                              << "Initializing DeviceBuffer " << name << " (SHAPE PACKED: " << FinnUtils::shapeToString(pShapePacked) << " inputs of the given shape, MAP SIZE: " << mapSize << ")\n";
             std::fill(map, map + mapSize, 0);
@@ -136,11 +445,32 @@ namespace Finn {
             : name(std::move(buf.name)),
               shapePacked(std::move(buf.shapePacked)),
               mapSize(buf.mapSize),
+              maxBatchSize(buf.maxBatchSize),
+              groupId(buf.groupId),
+              arena(std::move(buf.arena)),
               internalBo(std::move(buf.internalBo)),
+              additionalBos(std::move(buf.additionalBos)),
+              slotMaps(std::move(buf.slotMaps)),
+              slotAddresses(std::move(buf.slotAddresses)),
+              activeSlot(buf.activeSlot),
               assocIPCore(std::move(buf.assocIPCore)),
               map(std::move(buf.map)),
-              bufAdr(internalBo.address()),
-              logger(Logger::getLogger()) {}
+              bufAdr(buf.bufAdr),
+              logger(Logger::getLogger()),
+              waitPolicy(buf.waitPolicy),
+              spinBudget(buf.spinBudget),
+              ipInterrupt(std::move(buf.ipInterrupt)),
+              executeTimeout(buf.executeTimeout),
+              pendingTransfer(std::move(buf.pendingTransfer)),
+              pendingSlot(buf.pendingSlot),
+              pendingBytes(buf.pendingBytes),
+              pendingStart(buf.pendingStart),
+              metrics(std::move(buf.metrics)),
+              executeStart(buf.executeStart),
+              executeSlot(buf.executeSlot),
+              timelineTrack(buf.timelineTrack),
+              cycleCounterOffset(buf.cycleCounterOffset),
+              sharedMemory(buf.sharedMemory) {}
 
         /**
          * @brief Construct a new Device Buffer object (Deleted copy constructor)
@@ -179,6 +509,26 @@ namespace Finn {
          */
         virtual size_t size(SIZE_SPECIFIER ss) = 0;
 
+        /**
+         * @brief Set the number of batch elements the next runs transfer and process, up to the batch size the buffer was allocated for.
+         * Nothing is reallocated: only the valid part of the buffer is synced, and the repetitions register is updated on the next execution.
+         *
+         * @param batchSize
+         */
+        virtual void setActiveBatchSize(unsigned int batchSize) {
+            if (batchSize == 0 || batchSize > maxBatchSize) {
+                FinnUtils::logAndError<std::invalid_argument>("Batch size " + std::to_string(batchSize) + " is not supported by buffer " + name + " (allocated for " + std::to_string(maxBatchSize) + ")");
+            }
+            shapePacked[0] = batchSize;
+        }
+
+        /**
+         * @brief Get the number of batch elements the buffer objects were allocated for
+         *
+         * @return unsigned int
+         */
+        unsigned int getMaxBatchSize() const { return maxBatchSize; }
+
         /**
          * @brief Get the name of the device buffer
          *
@@ -193,6 +543,57 @@ namespace Finn {
          */
         virtual shape_t& getPackedShape() { return shapePacked; }
 
+        /**
+         * @brief Get a view on the part of the mapped XRT buffer that holds the current batch. Writing into this span skips the host side copy of store(), but the data only reaches the FPGA with the next run().
+         * @attention Only use this for synchronous buffers. Asynchronous buffers write the map from their worker threads!
+         *
+         * @return std::span<T>
+         */
+        std::span<T> getMap() { return std::span<T>(map, FinnUtils::shapeToElements(shapePacked)); }
+
+        /**
+         * @brief Get a view on the mapped memory of the given buffer slot. @see getMap()
+         *
+         * @param slot
+         * @return std::span<T>
+         */
+        std::span<T> getMap(std::size_t slot) { return std::span<T>(slotMaps.at(slot), FinnUtils::shapeToElements(shapePacked)); }
+
+        /**
+         * @brief Get the number of buffer slots of this buffer
+         *
+         * @return std::size_t
+         */
+        std::size_t getBufferSlots() const { return slotMaps.size(); }
+
+        /**
+         * @brief Get the host memory of the XRT buffer objects of all buffer slots
+         *
+         * @return std::size_t
+         */
+        std::size_t bufferObjectBytes() const { return mapSize * sizeof(T) * slotMaps.size(); }
+
+        /**
+         * @brief Get the index of the currently active buffer slot
+         *
+         * @return std::size_t
+         */
+        std::size_t getActiveBufferSlot() const { return activeSlot; }
+
+        /**
+         * @brief Select the buffer slot that is used by the next sync and run. This does not move any data.
+         *
+         * @param slot
+         */
+        void setActiveBufferSlot(std::size_t slot) {
+            if (slot >= slotMaps.size()) {
+                FinnUtils::logAndError<std::out_of_range>("Buffer slot " + std::to_string(slot) + " does not exist in buffer " + name + " (" + std::to_string(slotMaps.size()) + " slots)");
+            }
+            activeSlot = slot;
+            map = slotMaps[slot];
+            bufAdr = slotAddresses[slot];
+        }
+
         /**
          * @brief Run the associated kernel
          *
@@ -201,11 +602,116 @@ namespace Finn {
          */
         virtual bool run() = 0;
 
+        /**
+         * @brief Wait for the associated kernel to finish. How the wait is done is decided by the WAIT_POLICY, @see setWaitPolicy
+         *
+         * @return true Success
+         * @return false Fail
+         */
         virtual bool wait() {
-            busyWait();
+            waitForCompletion();
             return true;
         };
 
+        /**
+         * @brief Set the strategy used to wait for kernel completion
+         *
+         * @param policy WAIT_POLICY::SPIN polls the control register, WAIT_POLICY::SPIN_YIELD polls pBudget times and yields afterwards, WAIT_POLICY::INTERRUPT blocks on the IP interrupt
+         * @param pSpinBudget Number of polls before yielding (only used by WAIT_POLICY::SPIN_YIELD)
+         */
+        virtual void setWaitPolicy(WAIT_POLICY policy, unsigned int pSpinBudget = defaultSpinBudget) {
+            if (policy == WAIT_POLICY::INVALID) {
+                FinnUtils::logAndError<std::invalid_argument>("Invalid wait policy for buffer " + name);
+            }
+            if (policy == WAIT_POLICY::INTERRUPT && !ipInterrupt) {
+                ipInterrupt = assocIPCore.create_interrupt_notify();
+                ipInterrupt->enable();
+            } else if (policy != WAIT_POLICY::INTERRUPT && ipInterrupt) {
+                ipInterrupt->disable();
+                ipInterrupt.reset();
+            }
+            waitPolicy = policy;
+            spinBudget = pSpinBudget;
+        }
+
+        /**
+         * @brief Get the current wait policy
+         *
+         * @return WAIT_POLICY
+         */
+        WAIT_POLICY getWaitPolicy() const { return waitPolicy; }
+
+        /**
+         * @brief Bound the time wait() gives a kernel run from its start. A run that misses it makes wait() throw a KernelTimeoutError instead of blocking forever.
+         * Only synchronous waits are bounded, asynchronous kernels wait for data as long as it takes.
+         *
+         * @param timeout 0 to wait forever
+         */
+        void setExecuteTimeout(std::chrono::microseconds timeout) {
+            if (timeout.count() < 0) {
+                FinnUtils::logAndError<std::invalid_argument>("Negative execute timeout for buffer " + name);
+            }
+            executeTimeout = timeout;
+        }
+
+        /**
+         * @brief Get the execute timeout, @see setExecuteTimeout
+         *
+         * @return std::chrono::microseconds
+         */
+        std::chrono::microseconds getExecuteTimeout() const { return executeTimeout; }
+
+        /**
+         * @brief Check if an asynchronous transfer of this buffer was started and not joined yet
+         *
+         * @return true
+         * @return false
+         */
+        bool transferPending() const { return pendingTransfer.has_value(); }
+
+        /**
+         * @brief Count the transfers and executions of this buffer in the given counters from now on, e.g. to keep counting across a reallocation
+         *
+         * @param pMetrics
+         */
+        void setMetrics(std::shared_ptr<BufferMetrics> pMetrics) { metrics = std::move(pMetrics); }
+
+        /**
+         * @brief Get the transfer and execution counters of this buffer
+         *
+         * @return const BufferMetrics&
+         */
+        const BufferMetrics& getMetrics() const { return *metrics; }
+
+        /**
+         * @brief Read the cycles of every run from a register of the IP core after it completed. @see BufferDescriptor::cycleCounterOffset
+         *
+         * @param offset Empty to not read any register
+         */
+        void setCycleCounter(std::optional<uint32_t> offset) { cycleCounterOffset = offset; }
+
+        /**
+         * @brief Record the kernel runs of this buffer that are waited for on a track of the timeline, while the TimelineTracer is enabled
+         *
+         * @param track @see TimelineTracer::deviceTrack
+         */
+        void setTimelineTrack(std::uint32_t track) { timelineTrack = track; }
+
+        /**
+         * @brief Skip all syncs of the buffer objects, because host and programmable logic see the same memory. @see sharedMemory
+         *
+         * @param pSharedMemory
+         */
+        void setSharedMemory(bool pSharedMemory) { sharedMemory = pSharedMemory; }
+
+        /**
+         * @brief Check if syncs of the buffer objects are skipped, @see setSharedMemory
+         *
+         * @return true
+         * @return false
+         */
+        bool hasSharedMemory() const { return sharedMemory; }
+
          protected:
         /**
          * @brief Returns a device prefix for logging
@@ -221,25 +727,133 @@ namespace Finn {
          */
         virtual void sync(std::size_t bytes) = 0;
 
-        void execute(const uint32_t repetitions = 1) {
+        /**
+         * @brief Get the XRT buffer object of the given slot
+         *
+         * @param slot
+         * @return xrt::bo&
+         */
+        xrt::bo& slotBo(std::size_t slot) { return (slot == 0) ? internalBo : additionalBos[slot - 1]; }
+
+        /**
+         * @brief Get the XRT buffer object of the active slot
+         *
+         * @return xrt::bo&
+         */
+        xrt::bo& activeBo() { return slotBo(activeSlot); }
+
+        /**
+         * @brief Start an asynchronous sync of the first bytes of a buffer slot. A transfer of this buffer that is still in flight is joined first.
+         *
+         * @param direction
+         * @param slot
+         * @param bytes
+         */
+        void startTransfer(xclBOSyncDirection direction, std::size_t slot, std::size_t bytes) {
+            if (slot >= slotMaps.size()) {
+                FinnUtils::logAndError<std::out_of_range>("Buffer slot " + std::to_string(slot) + " does not exist in buffer " + name + " (" + std::to_string(slotMaps.size()) + " slots)");
+            }
+            finishTransfer();
+            if (sharedMemory) {
+                return;
+            }
+            pendingStart = std::chrono::steady_clock::now();
+            pendingTransfer = slotBo(slot).async(direction, bytes, 0);
+            pendingSlot = slot;
+            pendingBytes = bytes;
+        }
+
+        /**
+         * @brief Check if a transfer of the active slot is in flight
+         *
+         * @return true
+         * @return false
+         */
+        bool activeTransferPending() const { return pendingTransfer.has_value() && pendingSlot == activeSlot; }
+
+        /**
+         * @brief Join the pending transfer, if there is one
+         *
+         * @return true A transfer was joined
+         * @return false Nothing was in flight
+         */
+        bool finishTransfer() {
+            if (!pendingTransfer) {
+                return false;
+            }
+            pendingTransfer->wait();
+            pendingTransfer.reset();
+            metrics->countTransfer(pendingBytes, std::chrono::steady_clock::now() - pendingStart);
+            return true;
+        }
+
+        /**
+         * @brief Copy the packed data of the active slot of source into the active slot of target. With tryPeerToPeer, the buffer objects are copied device to device,
+         * which works across devices if XRT supports P2P for them. Otherwise (or if the copy fails) the data is synced from the source device into the target map.
+         *
+         * @param source Buffer whose device memory holds the data
+         * @param target Buffer to fill
+         * @param tryPeerToPeer Attempt a device to device copy first
+         * @return true if the data was copied device to device, false if it was bounced through the host (the target still has to be synced to its device)
+         */
+        static bool copyActiveSlot(DeviceBuffer& source, DeviceBuffer& target, bool tryPeerToPeer) {
+            const std::size_t bytes = FinnUtils::shapeToElements(source.shapePacked) * sizeof(T);
+            if (bytes != FinnUtils::shapeToElements(target.shapePacked) * sizeof(T)) {
+                FinnUtils::logAndError<std::length_error>("Cannot copy buffer " + source.name + " (" + std::to_string(bytes) + " bytes) into buffer " + target.name + " (" +
+                                                          std::to_string(FinnUtils::shapeToElements(target.shapePacked) * sizeof(T)) + " bytes)");
+            }
+            if (tryPeerToPeer) {
+                try {
+                    const auto start = std::chrono::steady_clock::now();
+                    target.activeBo().copy(source.activeBo(), bytes);
+                    target.metrics->countTransfer(bytes, std::chrono::steady_clock::now() - start);
+                    return true;
+                } catch (const std::exception& e) {
+                    FINN_LOG(target.logger, loglevel::warning) << target.loggerPrefix() << "Device to device copy from " << source.name << " not available, copying through the host instead: " << e.what();
+                }
+            }
+            if (!source.sharedMemory) {
+                const auto start = std::chrono::steady_clock::now();
+                source.activeBo().sync(XCL_BO_SYNC_BO_FROM_DEVICE, bytes, 0);
+                source.metrics->countTransfer(bytes, std::chrono::steady_clock::now() - start);
+            }
+            std::memcpy(target.map, source.map, bytes);
+            return false;
+        }
+
+        /**
+         * @brief Start the kernel on the active slot
+         *
+         * @param repetitions Number of samples the kernel moves
+         * @param byteOffset Offset into the active slot the kernel starts at, used to run a batch in chunks of samples
+         */
+        void execute(const uint32_t repetitions = 1, std::size_t byteOffset = 0) {
+            FINN_TIME_STAGE(EXECUTE);
             // writes the buffer adress
             constexpr uint32_t offset_buf = 0x10;
             constexpr uint32_t offset_rep = 0x1C;
 
-            // If repetition number is the same as for the last call, then nothing has to be written before starting the Kernel
-            if (repetitions == oldRepetitions) {
+            // If repetition number and buffer are the same as for the last call, then nothing has to be written before starting the Kernel
+            metrics->countInvocation();
+            const long long address = bufAdr + static_cast<long long>(byteOffset);
+            if (repetitions == oldRepetitions && address == oldBufAdr) {
+                executeStart = std::chrono::steady_clock::now();
+                executeSlot = activeSlot;
                 assocIPCore.write_register(CSR_OFFSET, IP_START);
                 return;
             }
             oldRepetitions = repetitions;
+            oldBufAdr = address;
 
-            assocIPCore.write_register(offset_buf, bufAdr);
-            assocIPCore.write_register(offset_buf + 4, bufAdr >> 32);
+            assocIPCore.write_register(offset_buf, address);
+            assocIPCore.write_register(offset_buf + 4, address >> 32);
 
             // writes the repetitions
             assocIPCore.write_register(offset_rep, repetitions);
 
             // Start inference
+            executeStart = std::chrono::steady_clock::now();
+            executeSlot = activeSlot;
             assocIPCore.write_register(CSR_OFFSET, IP_START);
         }
     };
@@ -272,6 +886,26 @@ namespace Finn {
          *
          */
         const IO ioMode = IO::INPUT;
+        /**
+         * @brief Whether loadFrom still attempts device to device copies. Cleared after the first failed attempt.
+         *
+         */
+        bool peerToPeer = true;
+        /**
+         * @brief Set if the device memory of the active slot is newer than the map (filled by loadFrom), so the next run must not sync the map to the device
+         *
+         */
+        bool deviceDataCurrent = false;
+        /**
+         * @brief How the map is moved to the kernel, @see setTransferMode
+         *
+         */
+        TRANSFER_MODE transferMode = TRANSFER_MODE::MEMORY_BUFFERED;
+        /**
+         * @brief Samples per chunk of a streamed run
+         *
+         */
+        unsigned int streamChunkSamples = 1;
 
          public:
         /**
@@ -281,8 +915,75 @@ namespace Finn {
          * @param device XRT device
          * @param pAssociatedKernel XRT kernel
          * @param pShapePacked packed shape of input
+         * @param boFlags Allocation flags of the XRT buffer objects
+         * @param pArena Device memory arena to take the buffer objects from, or nullptr
+         */
+        DeviceInputBuffer(const std::string& pCUName, xrt::device& device, xrt::uuid& pDevUUID, const shapePacked_t& pShapePacked, unsigned int batchSize = 1, unsigned int bufferSlots = 1,
+                          xrt::bo::flags boFlags = xrt::bo::flags::normal, std::shared_ptr<DeviceMemoryArena> pArena = nullptr)
+            : DeviceBuffer<T>(pCUName, device, pDevUUID, pShapePacked, batchSize, bufferSlots, boFlags, std::move(pArena)){};
+
+        /**
+         * @brief Fill the active slot with the finished results of the active slot of an output buffer, usually on the previous device of a model parallel pipeline.
+         * The data is copied device to device (XRT P2P) if possible and bounced through the host otherwise, but never through getData() / store().
+         * @attention This function is NOT THREAD SAFE!
+         *
+         * @param source Output buffer with the same packed size as this buffer
+         * @return true if the data was copied device to device
+         * @return false if the data was copied through the host
+         */
+        bool loadFrom(DeviceBuffer<T>& source) {
+            peerToPeer = DeviceBuffer<T>::copyActiveSlot(source, *this, peerToPeer);
+            deviceDataCurrent = peerToPeer;
+            return peerToPeer;
+        }
+
+        /**
+         * @brief Start syncing the map of a buffer slot to the device without waiting for it. The next run of that slot joins the transfer instead of syncing again, so the
+         * uploads of several buffers, or the upload of the next batch and the readback of the current one, are in flight together. Does nothing for the active slot if
+         * loadFrom already filled its device memory or its upload is already in flight.
+         * @attention Only use this for synchronous buffers. Asynchronous buffers sync from their worker threads!
+         *
+         * @param slot
+         */
+        void upload(std::size_t slot) {
+            // A streamed run uploads the active slot chunk by chunk while the kernel already reads the first samples
+            if (slot == this->activeSlot && (deviceDataCurrent || this->activeTransferPending() || transferMode == TRANSFER_MODE::STREAMED)) {
+                return;
+            }
+            FINN_TIME_STAGE(SYNC_TO_DEVICE);
+            this->startTransfer(XCL_BO_SYNC_BO_TO_DEVICE, slot, FinnUtils::shapeToElements(this->shapePacked) * sizeof(T));
+        }
+
+        /**
+         * @brief Start syncing the map of the active slot to the device, @see upload(std::size_t)
+         *
+         */
+        void upload() { upload(this->activeSlot); }
+
+        /**
+         * @brief Select how the map is moved to the kernel. TRANSFER_MODE::MEMORY_BUFFERED syncs the whole batch before the kernel starts. TRANSFER_MODE::STREAMED
+         * syncs the batch in chunks of samples and starts the kernel on every chunk as soon as it arrived, while the next chunk is synced.
+         *
+         * @param mode
+         * @param chunkSamples Samples per chunk of a streamed run, rounded up to the alignment of the kernel
+         */
+        void setTransferMode(TRANSFER_MODE mode, unsigned int chunkSamples = 1) {
+            if (mode == TRANSFER_MODE::INVALID) {
+                FinnUtils::logAndError<std::invalid_argument>("Invalid transfer mode for buffer " + this->name);
+            }
+            if (chunkSamples == 0) {
+                FinnUtils::logAndError<std::invalid_argument>("Streamed buffer " + this->name + " needs at least one sample per chunk");
+            }
+            transferMode = mode;
+            streamChunkSamples = chunkSamples;
+        }
+
+        /**
+         * @brief Get the transfer mode of the buffer
+         *
+         * @return TRANSFER_MODE
          */
-        DeviceInputBuffer(const std::string& pCUName, xrt::device& device, xrt::uuid& pDevUUID, const shapePacked_t& pShapePacked, unsigned int batchSize = 1) : DeviceBuffer<T>(pCUName, device, pDevUUID, pShapePacked, batchSize){};
+        TRANSFER_MODE getTransferMode() const { return transferMode; }
 
         /**
          * @brief Store the given vector of data in the FPGA mem map
@@ -299,7 +1000,33 @@ namespace Finn {
          * @brief Sync data from the map to the device.
          *
          */
-        void sync(std::size_t bytes) override { this->internalBo.sync(XCL_BO_SYNC_BO_TO_DEVICE, bytes, 0); }
+        void sync(std::size_t bytes) override {
+            if (this->sharedMemory) {
+                return;
+            }
+            FINN_TIME_STAGE(SYNC_TO_DEVICE);
+            const auto start = std::chrono::steady_clock::now();
+            this->activeBo().sync(XCL_BO_SYNC_BO_TO_DEVICE, bytes, 0);
+            this->metrics->countTransfer(bytes, std::chrono::steady_clock::now() - start);
+        }
+
+        /**
+         * @brief Make sure the device memory of the active slot holds the map before the kernel starts. Joins an upload of the active slot that is in flight, and
+         * syncs the map otherwise, unless loadFrom already filled the device memory.
+         *
+         * @param bytes
+         */
+        void ensureUploaded(std::size_t bytes) {
+            if (this->activeTransferPending()) {
+                FINN_TIME_STAGE(SYNC_TO_DEVICE);
+                this->finishTransfer();
+            } else if (!deviceDataCurrent) {
+                // A transfer of another slot has to be done before this one is started
+                this->finishTransfer();
+                sync(bytes);
+            }
+            deviceDataCurrent = false;
+        }
 
          private:
         template<typename InputIt>
@@ -336,16 +1063,6 @@ namespace Finn {
          *
          */
         const IO ioMode = IO::OUTPUT;
-        /**
-         * @brief Data storage until data is requested by user
-         *
-         */
-        Finn::vector<T> longTermStorage;
-        /**
-         * @brief Timeout for kernels
-         *
-         */
-        unsigned int msExecuteTimeout = 1000;
 
          public:
         /**
@@ -355,8 +1072,11 @@ namespace Finn {
          * @param device XRT device
          * @param pAssociatedKernel XRT kernel
          * @param pShapePacked packed shape of input
+         * @param pArena Device memory arena to take the buffer objects from, or nullptr
          */
-        DeviceOutputBuffer(const std::string& pCUName, xrt::device& device, xrt::uuid& pDevUUID, const shapePacked_t& pShapePacked, unsigned int batchSize = 1) : DeviceBuffer<T>(pCUName, device, pDevUUID, pShapePacked, batchSize){};
+        DeviceOutputBuffer(const std::string& pCUName, xrt::device& device, xrt::uuid& pDevUUID, const shapePacked_t& pShapePacked, unsigned int batchSize = 1, unsigned int bufferSlots = 1,
+                           std::shared_ptr<DeviceMemoryArena> pArena = nullptr)
+            : DeviceBuffer<T>(pCUName, device, pDevUUID, pShapePacked, batchSize, bufferSlots, xrt::bo::flags::normal, std::move(pArena)){};
 
         /**
          * @brief Return stored data from storage
@@ -370,13 +1090,34 @@ namespace Finn {
          */
         virtual bool read() = 0;
 
+        /**
+         * @brief Start syncing the active slot from the device without waiting for it. The next read joins the transfer, so the readback of several buffers is in flight together.
+         * @attention Only use this for synchronous buffers. Asynchronous buffers sync from their worker threads!
+         *
+         */
+        void startRead() {
+            if (this->activeTransferPending()) {
+                return;
+            }
+            FINN_TIME_STAGE(SYNC_FROM_DEVICE);
+            this->startTransfer(XCL_BO_SYNC_BO_FROM_DEVICE, this->activeSlot, this->size(SIZE_SPECIFIER::BYTES));
+        }
+
          protected:
         /**
          * @brief Sync data from the FPGA into the memory map
          *
          * @return * void
          */
-        void sync(std::size_t bytes) override { this->internalBo.sync(XCL_BO_SYNC_BO_FROM_DEVICE, bytes, 0); }
+        void sync(std::size_t bytes) override {
+            if (this->sharedMemory) {
+                return;
+            }
+            FINN_TIME_STAGE(SYNC_FROM_DEVICE);
+            const auto start = std::chrono::steady_clock::now();
+            this->activeBo().sync(XCL_BO_SYNC_BO_FROM_DEVICE, bytes, 0);
+            this->metrics->countTransfer(bytes, std::chrono::steady_clock::now() - start);
+        }
 
 #ifdef UNITTEST
          public:
@@ -402,9 +1143,7 @@ namespace Finn {
 
         void testSetMap(const Finn::vector<T>& data) { testSetMap(data.begin(), data.end()); }
 
-        unsigned int testGetLongTermStorageSize() const { return longTermStorage.size(); }
         xrt::bo& testGetInternalBO() { return this->interalBo; }
-        Finn::vector<T>& testGetLTS() { return longTermStorage; }
 #endif
     };
 }  // namespace Finn
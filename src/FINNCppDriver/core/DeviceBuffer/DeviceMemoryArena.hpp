@@ -0,0 +1,106 @@
+/**
+ * @file DeviceMemoryArena.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief One large XRT buffer object per memory bank, carved into exactly sized sub-buffers for the device buffers
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef DEVICEMEMORYARENA
+#define DEVICEMEMORYARENA
+
+#include <FINNCppDriver/utils/FinnUtils.h>
+
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include "xrt/xrt_bo.h"
+#include "xrt/xrt_device.h"
+
+namespace Finn {
+    /**
+     * @brief Device memory of one memory bank, allocated as a single buffer object. Device buffers take sub-buffers of it that are rounded up to
+     * FinnUtils::subBufferAlignment instead of the next power of two, so the bank fits larger batches and more buffer slots. The arena has to outlive its
+     * sub-buffers, which is why device buffers hold it by shared pointer.
+     *
+     */
+    class DeviceMemoryArena {
+         private:
+        xrt::bo parent;
+        unsigned int groupId;
+        std::size_t capacity;
+        std::size_t used = 0;
+        std::mutex mutex;
+
+         public:
+        /**
+         * @brief Allocate the memory of the arena and map it
+         *
+         * @param device XRT device
+         * @param bytes Size of the arena, the sum of getAlignedBufferSize of all sub-buffers that will be taken from it
+         * @param pGroupId Memory group (bank) of the arena
+         * @param boFlags Allocation flags of the buffer object
+         */
+        DeviceMemoryArena(xrt::device& device, std::size_t bytes, unsigned int pGroupId, xrt::bo::flags boFlags = xrt::bo::flags::normal)
+            : parent(device, FinnUtils::getAlignedBufferSize(bytes), boFlags, pGroupId), groupId(pGroupId), capacity(FinnUtils::getAlignedBufferSize(bytes)) {
+            parent.map<uint8_t*>();
+        }
+
+        DeviceMemoryArena(DeviceMemoryArena&&) = delete;
+        DeviceMemoryArena(const DeviceMemoryArena&) = delete;
+        DeviceMemoryArena& operator=(DeviceMemoryArena&&) = delete;
+        DeviceMemoryArena& operator=(const DeviceMemoryArena&) = delete;
+        ~DeviceMemoryArena() = default;
+
+        /**
+         * @brief Take the next sub-buffer of the arena
+         *
+         * @param bytes Size of the sub-buffer, its offset in the arena is advanced by getAlignedBufferSize(bytes)
+         * @return xrt::bo
+         * @throws std::length_error If the arena has no room left for the sub-buffer
+         */
+        xrt::bo allocate(std::size_t bytes) {
+            const std::size_t aligned = FinnUtils::getAlignedBufferSize(bytes);
+            std::lock_guard guard(mutex);
+            if (used + aligned > capacity) {
+                FinnUtils::logAndError<std::length_error>("Device memory arena of group " + std::to_string(groupId) + " has " + std::to_string(capacity - used) + " of " + std::to_string(capacity) +
+                                                          " bytes left, which is not enough for a sub-buffer of " + std::to_string(bytes) + " bytes!");
+            }
+            const std::size_t offset = used;
+            used += aligned;
+            return xrt::bo(parent, bytes, offset);
+        }
+
+        /**
+         * @brief Get the memory group of the arena
+         *
+         * @return unsigned int
+         */
+        unsigned int getGroupId() const { return groupId; }
+
+        /**
+         * @brief Get the size of the arena in bytes
+         *
+         * @return std::size_t
+         */
+        std::size_t getCapacity() const { return capacity; }
+
+        /**
+         * @brief Get the bytes taken by sub-buffers, including their alignment
+         *
+         * @return std::size_t
+         */
+        std::size_t getUsed() {
+            std::lock_guard guard(mutex);
+            return used;
+        }
+    };
+}  // namespace Finn
+
+#endif  // DEVICEMEMORYARENA
@@ -16,6 +16,11 @@
 #include <FINNCppDriver/core/DeviceBuffer/DeviceBuffer.hpp>
 #include <FINNCppDriver/utils/join.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <span>
+
 #include "ert.h"
 
 namespace Finn {
@@ -30,8 +35,13 @@ namespace Finn {
          * @param pAssociatedKernel XRT kernel
          * @param pShapePacked packed shape of input
          * @param batchSize batch size
+         * @param bufferSlots Number of XRT buffer objects used for multi buffering
+         * @param boFlags Allocation flags of the XRT buffer objects
+         * @param pArena Device memory arena to take the buffer objects from, or nullptr to allocate them on their own
          */
-        SyncDeviceInputBuffer(const std::string& pCUName, xrt::device& device, xrt::uuid& pDevUUID, const shapePacked_t& pShapePacked, unsigned int batchSize) : DeviceInputBuffer<T>(pCUName, device, pDevUUID, pShapePacked, batchSize) {
+        SyncDeviceInputBuffer(const std::string& pCUName, xrt::device& device, xrt::uuid& pDevUUID, const shapePacked_t& pShapePacked, unsigned int batchSize, unsigned int bufferSlots = 1,
+                              xrt::bo::flags boFlags = xrt::bo::flags::normal, std::shared_ptr<DeviceMemoryArena> pArena = nullptr)
+            : DeviceInputBuffer<T>(pCUName, device, pDevUUID, pShapePacked, batchSize, bufferSlots, boFlags, std::move(pArena)) {
             FINN_LOG(this->logger, loglevel::info) << "[SyncDeviceInputBuffer] "
                                                    << "Initializing DeviceBuffer " << this->name << " (SHAPE PACKED: " << FinnUtils::shapeToString(pShapePacked) << " inputs of the given shape, MAP SIZE: " << this->mapSize << ")\n";
             this->shapePacked[0] = batchSize;
@@ -111,6 +121,7 @@ namespace Finn {
          */
         bool store(std::span<const T> data) override {
             std::copy(data.begin(), data.end(), this->map);
+            this->deviceDataCurrent = false;
             return true;
         }
 
@@ -122,10 +133,69 @@ namespace Finn {
          */
         bool run() override {
             FINN_LOG_DEBUG(this->logger, loglevel::info) << this->loggerPrefix() << "DeviceBuffer (" << this->name << ") executing...";
-            this->sync(FinnUtils::shapeToElements(this->shapePacked));
+            if (this->transferMode == TRANSFER_MODE::STREAMED && !this->deviceDataCurrent && !this->activeTransferPending()) {
+                return runStreamed();
+            }
+            // Data copied device to device by loadFrom is already in place, syncing the map would overwrite it
+            this->ensureUploaded(FinnUtils::shapeToElements(this->shapePacked));
             this->execute(this->shapePacked[0]);
             return true;
         }
+
+        /**
+         * @brief Byte alignment of the device addresses chunks of a streamed batch start at. Matches the widest AXI master interface of a FINN idma (512 bit).
+         *
+         */
+        static constexpr std::size_t chunkAlignment = 64;
+
+        /**
+         * @brief Packed bytes of one sample
+         *
+         * @return std::size_t
+         */
+        std::size_t bytesPerSample() const { return FinnUtils::shapeToElements(this->shapePacked) / this->shapePacked[0] * sizeof(T); }
+
+        /**
+         * @brief Round a number of samples up so that chunks of it start at offsets the idma can read from, @see chunkAlignment
+         *
+         * @param samples
+         * @return std::size_t
+         */
+        std::size_t alignChunk(std::size_t samples) const {
+            const std::size_t step = chunkAlignment / std::gcd(bytesPerSample(), chunkAlignment);
+            return std::max<std::size_t>(1, (samples + step - 1) / step) * step;
+        }
+
+         private:
+        /**
+         * @brief Sync the map of the active slot to the device chunk by chunk. The kernel is started on every chunk as soon as it arrived and reads it while the next
+         * chunk is synced, so the first samples reach the accelerator after one chunk instead of after the whole batch. The kernel is still running on the last chunk
+         * when this returns, like after a buffered run.
+         *
+         * @return true
+         */
+        bool runStreamed() {
+            // A transfer of another slot has to be done before this one is started
+            this->finishTransfer();
+            const std::size_t samples = this->shapePacked[0];
+            const std::size_t bytes = bytesPerSample();
+            const std::size_t chunk = std::min<std::size_t>(alignChunk(this->streamChunkSamples), samples);
+            for (std::size_t first = 0; first < samples; first += chunk) {
+                const std::size_t count = std::min(chunk, samples - first);
+                if (!this->sharedMemory) {
+                    FINN_TIME_STAGE(SYNC_TO_DEVICE);
+                    const auto start = std::chrono::steady_clock::now();
+                    this->activeBo().sync(XCL_BO_SYNC_BO_TO_DEVICE, count * bytes, first * bytes);
+                    this->metrics->countTransfer(count * bytes, std::chrono::steady_clock::now() - start);
+                }
+                if (first > 0) {
+                    // The kernel has to be done with the previous chunk before it can be started on this one
+                    this->wait();
+                }
+                this->execute(static_cast<uint32_t>(count), first * bytes);
+            }
+            return true;
+        }
     };
 
     /**
@@ -139,6 +209,12 @@ namespace Finn {
         std::size_t elementCount;
 
          public:
+        /**
+         * @brief Byte alignment of the device addresses chunks of a batch start at. Matches the widest AXI master interface of a FINN odma (512 bit).
+         *
+         */
+        static constexpr std::size_t chunkAlignment = 64;
+
         /**
          * @brief Construct a new Synchronous Device Output Buffer object
          *
@@ -147,8 +223,12 @@ namespace Finn {
          * @param pAssociatedKernel XRT kernel
          * @param pShapePacked packed shape of input
          * @param ringBufferSizeFactor size of ringbuffer in input elements (batch elements)
+         * @param bufferSlots Number of XRT buffer objects used for multi buffering
+         * @param pArena Device memory arena to take the buffer objects from, or nullptr to allocate them on their own
          */
-        SyncDeviceOutputBuffer(const std::string& pCUName, xrt::device& device, xrt::uuid& pDevUUID, const shapePacked_t& pShapePacked, unsigned int batchSize) : DeviceOutputBuffer<T>(pCUName, device, pDevUUID, pShapePacked) {
+        SyncDeviceOutputBuffer(const std::string& pCUName, xrt::device& device, xrt::uuid& pDevUUID, const shapePacked_t& pShapePacked, unsigned int batchSize, unsigned int bufferSlots = 1,
+                               std::shared_ptr<DeviceMemoryArena> pArena = nullptr)
+            : DeviceOutputBuffer<T>(pCUName, device, pDevUUID, pShapePacked, batchSize, bufferSlots, std::move(pArena)) {
             this->shapePacked[0] = batchSize;
             elementCount = FinnUtils::shapeToElements(this->shapePacked);
         };
@@ -210,6 +290,16 @@ namespace Finn {
             }
         }
 
+        /**
+         * @brief Set the number of batch elements the next runs read back. @see DeviceBuffer::setActiveBatchSize
+         *
+         * @param batchSize
+         */
+        void setActiveBatchSize(unsigned int batchSize) override {
+            DeviceOutputBuffer<T>::setActiveBatchSize(batchSize);
+            elementCount = FinnUtils::shapeToElements(this->shapePacked);
+        }
+
         /**
          * @brief Return the data contained in the FPGA Buffer map.
          *
@@ -233,13 +323,72 @@ namespace Finn {
         }
 
         /**
-         * @brief Read the specified number of batchSize. If a read fails, immediately return. If all are successful, the kernel state of the last run is returned
+         * @brief Packed bytes of one sample
+         *
+         * @return std::size_t
+         */
+        std::size_t bytesPerSample() const { return elementCount / this->shapePacked[0] * sizeof(T); }
+
+        /**
+         * @brief Round a number of samples up so that chunks of it start at offsets the odma can write to, @see chunkAlignment
+         *
+         * @param samples
+         * @return std::size_t
+         */
+        std::size_t alignChunk(std::size_t samples) const {
+            const std::size_t step = chunkAlignment / std::gcd(bytesPerSample(), chunkAlignment);
+            return std::max<std::size_t>(1, (samples + step - 1) / step) * step;
+        }
+
+        /**
+         * @brief Execute the output kernel for a chunk of the samples of the active slot only, so earlier chunks can be read back while it runs.
+         * @attention firstSample * bytesPerSample() has to be a multiple of chunkAlignment, @see alignChunk
+         *
+         * @param firstSample
+         * @param samples
+         * @return true
+         * @return false
+         */
+        bool runChunk(std::size_t firstSample, std::size_t samples) {
+            FINN_LOG_DEBUG(this->logger, loglevel::info) << this->loggerPrefix() << "DeviceBuffer (" << this->name << ") executing samples " << firstSample << " to " << firstSample + samples;
+            this->execute(static_cast<uint32_t>(samples), firstSample * bytesPerSample());
+            return true;
+        }
+
+        /**
+         * @brief Sync the results of a chunk of samples of the active slot into the memory map
+         *
+         * @param firstSample
+         * @param samples
+         * @return std::span<const T> Packed results of the chunk in the memory map
+         */
+        std::span<const T> readChunk(std::size_t firstSample, std::size_t samples) {
+            FINN_TIME_STAGE(SYNC_FROM_DEVICE);
+            const std::size_t offset = firstSample * bytesPerSample();
+            const std::size_t bytes = samples * bytesPerSample();
+            if (!this->sharedMemory) {
+                const auto start = std::chrono::steady_clock::now();
+                this->activeBo().sync(XCL_BO_SYNC_BO_FROM_DEVICE, bytes, offset);
+                this->metrics->countTransfer(bytes, std::chrono::steady_clock::now() - start);
+            }
+            return {this->map + offset / sizeof(T), bytes / sizeof(T)};
+        }
+
+        /**
+         * @brief Read the specified number of batchSize. Joins the transfer started by startRead, or syncs the active slot if none is in flight. A transfer of another
+         * slot is joined first.
          *
          * @return bool
          */
         bool read() override {
             FINN_LOG_DEBUG(this->logger, loglevel::info) << this->loggerPrefix() << "Synching  " << elementCount << " bytes from the device";
-            this->sync(elementCount);
+            if (this->activeTransferPending()) {
+                FINN_TIME_STAGE(SYNC_FROM_DEVICE);
+                this->finishTransfer();
+            } else {
+                this->finishTransfer();
+                this->sync(elementCount);
+            }
             return true;
         }
     };
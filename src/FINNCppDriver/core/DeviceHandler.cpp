@@ -17,12 +17,15 @@
 #include <FINNCppDriver/core/DeviceBuffer/AsyncDeviceBuffers.hpp>
 #include <FINNCppDriver/core/DeviceBuffer/DeviceBuffer.hpp>
 #include <FINNCppDriver/core/DeviceBuffer/SyncDeviceBuffers.hpp>
+#include <FINNCppDriver/utils/Affinity.hpp>
+#include <FINNCppDriver/utils/TimelineTracer.hpp>
 #include <algorithm>  // for copy
 #include <boost/cstdint.hpp>
 #include <cerrno>
 #include <chrono>
 #include <filesystem>  // for path
 #include <iosfwd>
+#include <map>
 #include <memory>
 #include <numeric>
 #include <stdexcept>
@@ -37,13 +40,40 @@
 namespace fs = std::filesystem;
 
 namespace Finn {
-    DeviceHandler::DeviceHandler(const DeviceWrapper& devWrap, bool pSynchronousInference, unsigned int hostBufferSize)
-        : synchronousInference(pSynchronousInference), devInformation(devWrap), xrtDeviceIndex(devWrap.xrtDeviceIndex), xclbinPath(devWrap.xclbin) {
+    DeviceHandler::DeviceHandler(const DeviceWrapper& devWrap, bool pSynchronousInference, unsigned int hostBufferSize, unsigned int pBufferSlots)
+        : synchronousInference(pSynchronousInference),
+          devInformation(devWrap),
+          batchsize(hostBufferSize),
+          maxBatchSize(hostBufferSize),
+          bufferSlots(pBufferSlots),
+          xrtDeviceIndex(devWrap.xrtDeviceIndex),
+          xclbinPath(devWrap.xclbin),
+          executeTimeout(std::chrono::milliseconds(devWrap.executeTimeoutMs)) {
         checkDeviceWrapper(devWrap);
+        if (devWrap.replicatedComputeUnits) {
+            for (std::size_t i = 0; i < devWrap.idmas.size(); ++i) {
+                computeUnitPairs.emplace_back(ComputeUnitPair{devWrap.idmas[i]->kernelName, devWrap.odmas[i]->kernelName});
+            }
+        } else {
+            computeUnitPairs.emplace_back(ComputeUnitPair{devWrap.idmas.front()->kernelName, devWrap.odmas.front()->kernelName});
+        }
+        for (auto&& descriptor : devWrap.idmas) {
+            bufferMetrics.emplace(descriptor->kernelName, std::make_shared<BufferMetrics>());
+        }
+        for (auto&& descriptor : devWrap.odmas) {
+            bufferMetrics.emplace(descriptor->kernelName, std::make_shared<BufferMetrics>());
+        }
+        auto start = std::chrono::steady_clock::now();
         initializeDevice();
+        auto opened = std::chrono::steady_clock::now();
         loadXclbinSetUUID();
-        initializeBufferObjects(devWrap, hostBufferSize, pSynchronousInference);
-        FINN_LOG(Logger::getLogger(), loglevel::info) << loggerPrefix() << "Finished setting up device " << xrtDeviceIndex;
+        auto programmed = std::chrono::steady_clock::now();
+        startupTimes.open = opened - start;
+        startupTimes.program = programmed - opened;
+        // The buffer objects are allocated on first use, so that reconfiguring the batch size or the buffer slots right after construction does not allocate twice
+        FINN_LOG(Logger::getLogger(), loglevel::info) << loggerPrefix() << "Finished setting up device " << xrtDeviceIndex << " (open " << std::chrono::duration<double, std::milli>(startupTimes.open).count()
+                                                      << "ms, xclbin " << std::chrono::duration<double, std::milli>(startupTimes.program).count() << "ms" << (startupTimes.reprogrammed ? "" : " (already loaded, not reprogrammed)")
+                                                      << ", buffers are allocated on first use)";
     }
 
     std::string DeviceHandler::loggerPrefix() { return "[DeviceHandler] "; }
@@ -71,6 +101,18 @@ namespace Finn {
         if (devWrap.odmas.empty()) {
             throw std::invalid_argument("Empty output kernel list. Abort.");
         }
+        if (devWrap.waitPolicy == WAIT_POLICY::INVALID) {
+            throw std::invalid_argument("Unknown wait policy. Valid policies are spin, spinYield and interrupt. Abort.");
+        }
+        if (devWrap.affinityPolicy == AFFINITY_POLICY::INVALID) {
+            throw std::invalid_argument("Unknown affinity policy. Valid policies are none and deviceLocal. Abort.");
+        }
+        if (devWrap.platform == PLATFORM::INVALID) {
+            throw std::invalid_argument("Unknown platform. Valid platforms are alveo and embedded. Abort.");
+        }
+        if (devWrap.coherentMemory && devWrap.platform != PLATFORM::EMBEDDED) {
+            throw std::invalid_argument("Coherent memory is only supported on the embedded platform. Abort.");
+        }
         for (auto&& bufDesc : devWrap.odmas) {
             if (bufDesc->kernelName.empty()) {
                 throw std::invalid_argument("Empty kernel name. Abort.");
@@ -79,40 +121,185 @@ namespace Finn {
                 throw std::invalid_argument("Empty buffer shape. Abort.");
             }
         }
+        if (devWrap.replicatedComputeUnits) {
+            if (devWrap.idmas.size() != devWrap.odmas.size()) {
+                throw std::invalid_argument("Replicated compute units need as many idmas as odmas. Abort.");
+            }
+            auto sameShape = [](const auto& descriptors) {
+                return std::all_of(descriptors.begin(), descriptors.end(), [&](const auto& descriptor) { return descriptor->packedShape == descriptors.front()->packedShape; });
+            };
+            if (!sameShape(devWrap.idmas) || !sameShape(devWrap.odmas)) {
+                throw std::invalid_argument("Replicated compute units need the same shapes for all idmas and for all odmas. Abort.");
+            }
+            if (std::any_of(devWrap.idmas.begin(), devWrap.idmas.end(), [](const auto& idma) { return idma->producer.has_value(); })) {
+                throw std::invalid_argument("Replicated compute units cannot be fed by another device. Abort.");
+            }
+        }
     }
 
     void DeviceHandler::initializeDevice() {
         FINN_LOG(Logger::getLogger(), loglevel::info) << loggerPrefix() << "(" << xrtDeviceIndex << ") "
                                                       << "Initializing xrt::device, loading xclbin and assigning IP\n";
         device = xrt::device(xrtDeviceIndex);
+        if (devInformation.affinityPolicy != AFFINITY_POLICY::DEVICE_LOCAL) {
+            return;
+        }
+        const std::string bdf = device.get_info<xrt::info::device::bdf>();
+        numaNode = pciNumaNode(bdf);
+        if (numaNode) {
+            localCpus = numaNodeCpus(*numaNode);
+        }
+        if (localCpus.empty()) {
+            FINN_LOG(Logger::getLogger(), loglevel::warning) << loggerPrefix() << "(" << xrtDeviceIndex << ") "
+                                                             << "Could not determine the CPUs local to PCIe device " << bdf << ", leaving thread and memory placement to the OS";
+            return;
+        }
+        FINN_LOG(Logger::getLogger(), loglevel::info) << loggerPrefix() << "(" << xrtDeviceIndex << ") "
+                                                      << "PCIe device " << bdf << " is attached to NUMA node " << *numaNode << " with " << localCpus.size() << " CPUs";
     }
 
     void DeviceHandler::loadXclbinSetUUID() {
         FINN_LOG(Logger::getLogger(), loglevel::info) << loggerPrefix() << "(" << xrtDeviceIndex << ") "
                                                       << "Loading XCLBIN and setting uuid\n";
-        uuid = device.load_xclbin(xclbinPath);
+        xrt::xclbin xclbin(xclbinPath);
+        if (device.get_xclbin_uuid() == xclbin.get_uuid()) {
+            // Reprogramming the card with the xclbin it already runs only costs time. Registering the xclbin is enough to create kernels and IPs.
+            FINN_LOG(Logger::getLogger(), loglevel::info) << loggerPrefix() << "(" << xrtDeviceIndex << ") "
+                                                          << "Card already runs " << xclbinPath << ", skipping reprogramming\n";
+            uuid = device.register_xclbin(xclbin);
+            startupTimes.reprogrammed = false;
+        } else {
+            uuid = device.load_xclbin(xclbin);
+            startupTimes.reprogrammed = true;
+        }
+    }
+
+    void DeviceHandler::allocateBuffers() {
+        std::call_once(*bufferAllocation, [this]() {
+            auto start = std::chrono::steady_clock::now();
+            // Allocating from the device local CPUs places the host pages of the buffers on the node of the card, they are first touched when the maps are cleared. The
+            // worker threads of asynchronous buffers inherit the restriction.
+            ScopedThreadAffinity placement(localCpus);
+            initializeBufferObjects(devInformation, maxBatchSize, synchronousInference);
+            applyActiveBatchSize();
+            startupTimes.allocate = std::chrono::steady_clock::now() - start;
+            FINN_LOG(Logger::getLogger(), loglevel::info) << loggerPrefix() << "Allocated the buffer objects of device " << xrtDeviceIndex << " in " << std::chrono::duration<double, std::milli>(startupTimes.allocate).count() << "ms";
+        });
+    }
+
+    bool DeviceHandler::buffersAllocated() const { return !inputBufferMap.empty(); }
+
+    const DeviceStartupTimes& DeviceHandler::getStartupTimes() const { return startupTimes; }
+
+    std::optional<unsigned int> DeviceHandler::getNumaNode() const { return numaNode; }
+
+    const std::vector<unsigned int>& DeviceHandler::getLocalCpus() const { return localCpus; }
+
+    void DeviceHandler::invalidateBufferObjects() {
+        inputBufferMap.clear();
+        outputBufferMap.clear();
+        bufferAllocation = std::make_unique<std::once_flag>();
+    }
+
+    std::unordered_map<std::string, std::shared_ptr<DeviceMemoryArena>> DeviceHandler::createMemoryArenas(const DeviceWrapper& devWrap, unsigned int hostBufferSize) {
+        std::unordered_map<std::string, std::shared_ptr<DeviceMemoryArena>> arenas;
+        // The memory groups are queried for all compute units before any buffer acquires its IP core, xrt::kernel must not be created afterwards
+        std::map<unsigned int, std::vector<std::pair<std::string, std::size_t>>> groups;
+        auto add = [&](const std::shared_ptr<BufferDescriptor>& descriptor) {
+            const std::size_t bytes = FinnUtils::getAlignedBufferSize(FinnUtils::shapeToElements(descriptor->packedShape) * hostBufferSize) * bufferSlots;
+            groups[xrt::kernel(device, uuid, descriptor->kernelName).group_id(0)].emplace_back(descriptor->kernelName, bytes);
+        };
+        for (auto&& descriptor : devWrap.idmas) {
+            if (!descriptor->producer) {
+                add(descriptor);
+            }
+        }
+        for (auto&& descriptor : devWrap.odmas) {
+            add(descriptor);
+        }
+        for (auto&& [groupId, kernels] : groups) {
+            std::size_t bytes = 0;
+            for (auto&& kernel : kernels) {
+                bytes += kernel.second;
+            }
+            try {
+                auto arena = std::make_shared<DeviceMemoryArena>(device, bytes, groupId, devWrap.coherentMemory ? xrt::bo::flags::cacheable : xrt::bo::flags::normal);
+                for (auto&& kernel : kernels) {
+                    arenas.emplace(kernel.first, arena);
+                }
+                FINN_LOG(Logger::getLogger(), loglevel::info) << loggerPrefix() << "Allocated a device memory arena of " << bytes << " bytes for " << kernels.size() << " buffer(s) in memory group " << groupId;
+            } catch (const std::exception& e) {
+                FINN_LOG(Logger::getLogger(), loglevel::warning) << loggerPrefix() << "Could not allocate a device memory arena of " << bytes << " bytes in memory group " << groupId
+                                                                 << ", allocating its buffers on their own: " << e.what();
+            }
+        }
+        return arenas;
     }
 
     void DeviceHandler::initializeBufferObjects(const DeviceWrapper& devWrap, unsigned int hostBufferSize, bool pSynchronousInference) {
         FINN_LOG(Logger::getLogger(), loglevel::info) << loggerPrefix() << "(" << xrtDeviceIndex << ") "
                                                       << "Initializing buffer objects\n";
+        // Contiguous memory is scarce on embedded platforms (CMA), so their buffers are always carved from arenas
+        const bool useArenas = devWrap.memoryArena || devWrap.platform == PLATFORM::EMBEDDED;
+        const auto arenas = (pSynchronousInference && useArenas) ? createMemoryArenas(devWrap, hostBufferSize) : std::unordered_map<std::string, std::shared_ptr<DeviceMemoryArena>>{};
+        auto arenaOf = [&arenas](const std::string& kernelName) -> std::shared_ptr<DeviceMemoryArena> {
+            auto arena = arenas.find(kernelName);
+            return (arena == arenas.end()) ? nullptr : arena->second;
+        };
+        // With a single input and output, the output DMA is started once per input run and for as many samples. Otherwise it is not clear which input an output belongs to.
+        const auto launches = (!pSynchronousInference && devWrap.idmas.size() == 1 && devWrap.odmas.size() == 1) ? std::make_shared<Finn::AsyncLaunchChannel>() : nullptr;
         for (auto&& ebdptr : devWrap.idmas) {
-            if (pSynchronousInference) {
-                inputBufferMap.emplace(std::make_pair(ebdptr->kernelName, std::make_shared<Finn::SyncDeviceInputBuffer<uint8_t>>(ebdptr->kernelName, device, uuid, ebdptr->packedShape, hostBufferSize)));
+            if (pSynchronousInference && ebdptr->producer) {
+                // Inputs fed by another device are allocated as P2P buffers, so the producer's results can be copied device to device
+                try {
+                    inputBufferMap.emplace(std::make_pair(ebdptr->kernelName, std::make_shared<Finn::SyncDeviceInputBuffer<uint8_t>>(ebdptr->kernelName, device, uuid, ebdptr->packedShape, hostBufferSize, bufferSlots, xrt::bo::flags::p2p)));
+                } catch (const std::exception& e) {
+                    FINN_LOG(Logger::getLogger(), loglevel::warning) << loggerPrefix() << "Could not allocate P2P buffer for " << ebdptr->kernelName << ", falling back to host transfers: " << e.what();
+                    inputBufferMap.emplace(std::make_pair(ebdptr->kernelName, std::make_shared<Finn::SyncDeviceInputBuffer<uint8_t>>(ebdptr->kernelName, device, uuid, ebdptr->packedShape, hostBufferSize, bufferSlots)));
+                }
+            } else if (pSynchronousInference) {
+                inputBufferMap.emplace(std::make_pair(ebdptr->kernelName, std::make_shared<Finn::SyncDeviceInputBuffer<uint8_t>>(ebdptr->kernelName, device, uuid, ebdptr->packedShape, hostBufferSize, bufferSlots,
+                                                                                                                                   xrt::bo::flags::normal, arenaOf(ebdptr->kernelName))));
             } else {
-                inputBufferMap.emplace(std::make_pair(ebdptr->kernelName, std::make_shared<Finn::AsyncDeviceInputBuffer<uint8_t>>(ebdptr->kernelName, device, uuid, ebdptr->packedShape, hostBufferSize)));
+                inputBufferMap.emplace(std::make_pair(ebdptr->kernelName, std::make_shared<Finn::AsyncDeviceInputBuffer<uint8_t>>(ebdptr->kernelName, device, uuid, ebdptr->packedShape, hostBufferSize, launches,
+                                                                                                                                    devWrap.waitPolicy, devWrap.spinBudget)));
             }
         }
         for (auto&& ebdptr : devWrap.odmas) {
             if (pSynchronousInference) {
-                auto ptr = std::make_shared<Finn::SyncDeviceOutputBuffer<uint8_t>>(ebdptr->kernelName, device, uuid, ebdptr->packedShape, hostBufferSize);
+                auto ptr = std::make_shared<Finn::SyncDeviceOutputBuffer<uint8_t>>(ebdptr->kernelName, device, uuid, ebdptr->packedShape, hostBufferSize, bufferSlots, arenaOf(ebdptr->kernelName));
                 outputBufferMap.emplace(std::make_pair(ebdptr->kernelName, ptr));
             } else {
-                auto ptr = std::make_shared<Finn::AsyncDeviceOutputBuffer<uint8_t>>(ebdptr->kernelName, device, uuid, ebdptr->packedShape, hostBufferSize);
-                ptr->allocateLongTermStorage(hostBufferSize * 5);
+                auto ptr = std::make_shared<Finn::AsyncDeviceOutputBuffer<uint8_t>>(ebdptr->kernelName, device, uuid, ebdptr->packedShape, hostBufferSize, launches, devWrap.waitPolicy, devWrap.spinBudget);
+                ptr->setArchiveCapacity(devWrap.archiveCapacity);
                 outputBufferMap.emplace(std::make_pair(ebdptr->kernelName, ptr));
             }
         }
+        applyWaitPolicy();
+        applyExecuteTimeout();
+        for (auto&& ebdptr : devWrap.idmas) {
+            auto& buffer = inputBufferMap.at(ebdptr->kernelName);
+            buffer->setMetrics(bufferMetrics.at(ebdptr->kernelName));
+            buffer->setCycleCounter(ebdptr->cycleCounterOffset);
+            buffer->setSharedMemory(devWrap.platform == PLATFORM::EMBEDDED);
+            buffer->setTimelineTrack(TimelineTracer::global().deviceTrack(xrtDeviceIndex, ebdptr->kernelName));
+            if (ebdptr->transferMode == TRANSFER_MODE::STREAMED && !pSynchronousInference) {
+                // Asynchronous buffers already move every batch the moment it was stored
+                FINN_LOG(Logger::getLogger(), loglevel::warning) << loggerPrefix() << "Transfer mode streamed is only supported for synchronous inference, " << ebdptr->kernelName << " stays memory buffered";
+            } else {
+                buffer->setTransferMode(ebdptr->transferMode, ebdptr->streamChunkSamples);
+            }
+        }
+        for (auto&& ebdptr : devWrap.odmas) {
+            if (ebdptr->transferMode != TRANSFER_MODE::MEMORY_BUFFERED) {
+                FinnUtils::logAndError<std::invalid_argument>("Output buffer " + ebdptr->kernelName + " has to be memory buffered. Use inferSynchronousStreaming to read results back in chunks.");
+            }
+            auto& buffer = outputBufferMap.at(ebdptr->kernelName);
+            buffer->setMetrics(bufferMetrics.at(ebdptr->kernelName));
+            buffer->setCycleCounter(ebdptr->cycleCounterOffset);
+            buffer->setSharedMemory(devWrap.platform == PLATFORM::EMBEDDED);
+            buffer->setTimelineTrack(TimelineTracer::global().deviceTrack(xrtDeviceIndex, ebdptr->kernelName));
+        }
         FINN_LOG(Logger::getLogger(), loglevel::info) << loggerPrefix() << "Finished initializing buffer objects on device " << xrtDeviceIndex;
 
 #ifndef NDEBUG
@@ -123,40 +310,209 @@ namespace Finn {
     /****** GETTER / SETTER ******/
 
     void DeviceHandler::setBatchSize(uint pBatchsize) {
+        if (pBatchsize == 0) {
+            FinnUtils::logAndError<std::invalid_argument>("The batch size has to be at least one!");
+        }
         if (this->batchsize == pBatchsize) {
             return;
-        } else {
+        }
+        if (this->synchronousInference && pBatchsize <= this->maxBatchSize) {
             this->batchsize = pBatchsize;
-            inputBufferMap.clear();
-            outputBufferMap.clear();
-            initializeBufferObjects(this->devInformation, pBatchsize, this->synchronousInference);
+            applyActiveBatchSize();
+            return;
+        }
+        this->batchsize = pBatchsize;
+        this->maxBatchSize = pBatchsize;
+        invalidateBufferObjects();
+    }
+
+    void DeviceHandler::setMaxBatchSize(uint pMaxBatchSize) {
+        if (pMaxBatchSize == 0) {
+            FinnUtils::logAndError<std::invalid_argument>("The batch size has to be at least one!");
+        }
+        if (this->maxBatchSize == pMaxBatchSize) {
+            return;
+        }
+        this->maxBatchSize = pMaxBatchSize;
+        this->batchsize = std::min(this->batchsize, pMaxBatchSize);
+        invalidateBufferObjects();
+    }
+
+    uint DeviceHandler::getMaxBatchSize() const { return maxBatchSize; }
+
+    void DeviceHandler::applyActiveBatchSize() {
+        if (!synchronousInference) {
+            return;
+        }
+        // cppcheck-suppress unusedVariable
+        for (auto&& [key, value] : inputBufferMap) {
+            value->setActiveBatchSize(batchsize);
+        }
+        // cppcheck-suppress unusedVariable
+        for (auto&& [key, value] : outputBufferMap) {
+            value->setActiveBatchSize(batchsize);
+        }
+    }
+
+    void DeviceHandler::setBufferSlots(unsigned int pBufferSlots) {
+        if (pBufferSlots == 0) {
+            FinnUtils::logAndError<std::invalid_argument>("At least one buffer slot is needed per DeviceBuffer!");
+        }
+        if (this->bufferSlots == pBufferSlots) {
+            return;
+        }
+        this->bufferSlots = pBufferSlots;
+        invalidateBufferObjects();
+    }
+
+    void DeviceHandler::setWaitPolicy(WAIT_POLICY policy, unsigned int spinBudget) {
+        devInformation.waitPolicy = policy;
+        devInformation.spinBudget = spinBudget;
+        applyWaitPolicy();
+    }
+
+    void DeviceHandler::setExecuteTimeout(std::chrono::microseconds timeout) {
+        if (timeout.count() < 0) {
+            FinnUtils::logAndError<std::invalid_argument>("The execute timeout must not be negative!");
+        }
+        executeTimeout = timeout;
+        applyExecuteTimeout();
+    }
+
+    std::chrono::microseconds DeviceHandler::getExecuteTimeout() const { return executeTimeout; }
+
+    bool DeviceHandler::isStuck() const { return health->stuck.load(); }
+
+    std::uint64_t DeviceHandler::getRecoveries() const { return health->recoveries.load(std::memory_order_relaxed); }
+
+    void DeviceHandler::recover() {
+        auto start = std::chrono::steady_clock::now();
+        invalidateBufferObjects();
+        // Loading the xclbin again, even though the card already runs it, resets the kernels
+        uuid = device.load_xclbin(xrt::xclbin(xclbinPath));
+        startupTimes.reprogrammed = true;
+        health->recoveries.fetch_add(1, std::memory_order_relaxed);
+        health->stuck.store(false);
+        FINN_LOG(Logger::getLogger(), loglevel::warning) << loggerPrefix() << "Recovered device " << xrtDeviceIndex << " by reprogramming it in "
+                                                         << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << "ms";
+    }
+
+    void DeviceHandler::setArchiveCapacity(std::size_t bytes) {
+        devInformation.archiveCapacity = bytes;
+        // cppcheck-suppress unusedVariable
+        for (auto&& [key, value] : outputBufferMap) {
+            if (auto asyncBuffer = std::dynamic_pointer_cast<AsyncDeviceOutputBuffer<uint8_t>>(value)) {
+                asyncBuffer->setArchiveCapacity(bytes);
+            }
+        }
+    }
+
+    void DeviceHandler::applyWaitPolicy() {
+        // cppcheck-suppress unusedVariable
+        for (auto&& [key, value] : inputBufferMap) {
+            value->setWaitPolicy(devInformation.waitPolicy, devInformation.spinBudget);
+        }
+        // cppcheck-suppress unusedVariable
+        for (auto&& [key, value] : outputBufferMap) {
+            value->setWaitPolicy(devInformation.waitPolicy, devInformation.spinBudget);
+        }
+    }
+
+    void DeviceHandler::applyExecuteTimeout() {
+        // Asynchronous kernels wait for data as long as it takes, so only synchronous runs get a deadline
+        const std::chrono::microseconds timeout = synchronousInference ? executeTimeout : std::chrono::microseconds(0);
+        // cppcheck-suppress unusedVariable
+        for (auto&& [key, value] : inputBufferMap) {
+            value->setExecuteTimeout(timeout);
+        }
+        // cppcheck-suppress unusedVariable
+        for (auto&& [key, value] : outputBufferMap) {
+            value->setExecuteTimeout(timeout);
+        }
+    }
+
+    void DeviceHandler::checkNotStuck() const {
+        if (isStuck()) {
+            FinnUtils::logAndError<KernelTimeoutError>(loggerPrefix() + "Device " + std::to_string(xrtDeviceIndex) + " has a stuck kernel and has to be recovered first");
+        }
+    }
+
+    void DeviceHandler::markStuck() {
+        health->stuck.store(true);
+        FINN_LOG(Logger::getLogger(), loglevel::error) << loggerPrefix() << "Device " << xrtDeviceIndex << " missed the execute timeout of " << executeTimeout.count() << "us, it is stuck until it was recovered";
+    }
+
+    void DeviceHandler::setResultCallback(const std::string& outputBufferKernelName, packedResultCallback_t callback) {
+        auto asyncBuffer = std::dynamic_pointer_cast<AsyncDeviceOutputBuffer<uint8_t>>(getOutputBuffer(outputBufferKernelName));
+        if (!asyncBuffer) {
+            FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " Result callbacks are only supported for asynchronous output buffers (" + outputBufferKernelName + ")");
+        }
+        asyncBuffer->setResultCallback(std::move(callback));
+    }
+
+    void DeviceHandler::setActiveBufferSlot(std::size_t slot) {
+        allocateBuffers();
+        // cppcheck-suppress unusedVariable
+        for (auto&& [key, value] : inputBufferMap) {
+            value->setActiveBufferSlot(slot);
+        }
+        // cppcheck-suppress unusedVariable
+        for (auto&& [key, value] : outputBufferMap) {
+            value->setActiveBufferSlot(slot);
         }
     }
 
     [[maybe_unused]] xrt::device& DeviceHandler::getDevice() { return device; }
 
     [[maybe_unused]] bool DeviceHandler::containsBuffer(const std::string& kernelBufferName, IO ioMode) {
+        // Answered from the configuration, so that asking does not allocate the buffers
+        auto hasName = [&kernelBufferName](const auto& descriptor) { return descriptor->kernelName == kernelBufferName; };
         if (ioMode == IO::INPUT) {
-            return inputBufferMap.contains(kernelBufferName);
+            return std::any_of(devInformation.idmas.begin(), devInformation.idmas.end(), hasName);
         } else if (ioMode == IO::OUTPUT) {
-            return outputBufferMap.contains(kernelBufferName);
+            return std::any_of(devInformation.odmas.begin(), devInformation.odmas.end(), hasName);
         }
         return false;
     }
 
-    [[maybe_unused]] std::unordered_map<std::string, std::shared_ptr<DeviceInputBuffer<uint8_t>>>& DeviceHandler::getInputBufferMap() { return inputBufferMap; }
+    [[maybe_unused]] std::unordered_map<std::string, std::shared_ptr<DeviceInputBuffer<uint8_t>>>& DeviceHandler::getInputBufferMap() {
+        allocateBuffers();
+        return inputBufferMap;
+    }
 
-    [[maybe_unused]] std::unordered_map<std::string, std::shared_ptr<DeviceOutputBuffer<uint8_t>>>& DeviceHandler::getOutputBufferMap() { return outputBufferMap; }
+    [[maybe_unused]] std::unordered_map<std::string, std::shared_ptr<DeviceOutputBuffer<uint8_t>>>& DeviceHandler::getOutputBufferMap() {
+        allocateBuffers();
+        return outputBufferMap;
+    }
 
-    [[maybe_unused]] std::shared_ptr<DeviceInputBuffer<uint8_t>>& DeviceHandler::getInputBuffer(const std::string& name) { return inputBufferMap.at(name); }
+    [[maybe_unused]] std::shared_ptr<DeviceInputBuffer<uint8_t>>& DeviceHandler::getInputBuffer(const std::string& name) {
+        allocateBuffers();
+        return inputBufferMap.at(name);
+    }
 
-    [[maybe_unused]] std::shared_ptr<DeviceOutputBuffer<uint8_t>>& DeviceHandler::getOutputBuffer(const std::string& name) { return outputBufferMap.at(name); }
+    [[maybe_unused]] std::shared_ptr<DeviceOutputBuffer<uint8_t>>& DeviceHandler::getOutputBuffer(const std::string& name) {
+        allocateBuffers();
+        return outputBufferMap.at(name);
+    }
 
     [[maybe_unused]] unsigned int DeviceHandler::getDeviceIndex() const { return xrtDeviceIndex; }
 
     bool DeviceHandler::run() {
+        if (devInformation.replicatedComputeUnits) {
+            // The other replicas are only driven pair by pair
+            return run(computeUnitPairs.front());
+        }
+        checkNotStuck();
         // Start the output kernels before the input to overlap the execution in a better way
+        allocateBuffers();
         bool ret = true;
+        if (synchronousInference) {
+            // Put the uploads of all inputs in flight together, every input kernel only joins its own upload before it starts
+            // cppcheck-suppress unusedVariable
+            for (auto&& [key, value] : inputBufferMap) {
+                value->upload();
+            }
+        }
         // cppcheck-suppress unusedVariable
         for (auto&& [key, value] : outputBufferMap) {
             ret &= value->run();
@@ -169,18 +525,38 @@ namespace Finn {
     }
 
     bool DeviceHandler::wait() {
+        if (devInformation.replicatedComputeUnits) {
+            return wait(computeUnitPairs.front());
+        }
         // We only need to wait for the outputs, because inputs have to finish before outputs
+        allocateBuffers();
         bool ret = true;
-        // cppcheck-suppress unusedVariable
-        for (auto&& [key, value] : outputBufferMap) {
-            ret &= value->wait();
+        try {
+            // cppcheck-suppress unusedVariable
+            for (auto&& [key, value] : outputBufferMap) {
+                ret &= value->wait();
+            }
+        } catch (const KernelTimeoutError&) {
+            markStuck();
+            throw;
         }
         return ret;
     }
 
     bool DeviceHandler::read() {
+        if (devInformation.replicatedComputeUnits) {
+            return read(computeUnitPairs.front());
+        }
         // Sync data back from the FPGA
+        allocateBuffers();
         bool ret = true;
+        if (synchronousInference) {
+            // Put the readback of all outputs in flight together before joining the first one
+            // cppcheck-suppress unusedVariable
+            for (auto&& [key, value] : outputBufferMap) {
+                value->startRead();
+            }
+        }
         // cppcheck-suppress unusedVariable
         for (auto&& [key, value] : outputBufferMap) {
             ret &= value->read();
@@ -188,8 +564,84 @@ namespace Finn {
         return ret;
     }
 
+    bool DeviceHandler::run(const ComputeUnitPair& pair) {
+        checkNotStuck();
+        allocateBuffers();
+        auto& output = outputBufferMap.at(pair.outputKernelName);
+        auto& input = inputBufferMap.at(pair.inputKernelName);
+        if (synchronousInference) {
+            input->upload();
+        }
+        // Output first, like run() does for the whole device
+        bool ret = output->run();
+        ret &= input->run();
+        return ret;
+    }
+
+    bool DeviceHandler::wait(const ComputeUnitPair& pair) {
+        allocateBuffers();
+        try {
+            return outputBufferMap.at(pair.outputKernelName)->wait();
+        } catch (const KernelTimeoutError&) {
+            markStuck();
+            throw;
+        }
+    }
+
+    bool DeviceHandler::read(const ComputeUnitPair& pair) {
+        allocateBuffers();
+        return outputBufferMap.at(pair.outputKernelName)->read();
+    }
+
+    const std::vector<ComputeUnitPair>& DeviceHandler::getComputeUnitPairs() const { return computeUnitPairs; }
+
+    DeviceMetricsSnapshot DeviceHandler::getMetrics() const {
+        DeviceMetricsSnapshot snapshot{xrtDeviceIndex, std::chrono::steady_clock::now() - metricsSince, {}};
+        snapshot.buffers.reserve(bufferMetrics.size());
+        for (auto&& descriptor : devInformation.idmas) {
+            snapshot.buffers.emplace_back(bufferMetrics.at(descriptor->kernelName)->snapshot(descriptor->kernelName, IO::INPUT));
+        }
+        for (auto&& descriptor : devInformation.odmas) {
+            snapshot.buffers.emplace_back(bufferMetrics.at(descriptor->kernelName)->snapshot(descriptor->kernelName, IO::OUTPUT));
+        }
+        return snapshot;
+    }
+
+    DeviceFootprint DeviceHandler::getMemoryFootprint() const {
+        DeviceFootprint footprint{xrtDeviceIndex, {}};
+        for (auto&& descriptor : devInformation.idmas) {
+            if (auto buffer = inputBufferMap.find(descriptor->kernelName); buffer != inputBufferMap.end()) {
+                BufferFootprint entry{descriptor->kernelName, IO::INPUT, buffer->second->bufferObjectBytes()};
+                if (auto asyncBuffer = std::dynamic_pointer_cast<AsyncDeviceInputBuffer<uint8_t>>(buffer->second)) {
+                    entry.ringBufferBytes = asyncBuffer->ringBufferBytes();
+                }
+                footprint.buffers.emplace_back(std::move(entry));
+            }
+        }
+        for (auto&& descriptor : devInformation.odmas) {
+            if (auto buffer = outputBufferMap.find(descriptor->kernelName); buffer != outputBufferMap.end()) {
+                BufferFootprint entry{descriptor->kernelName, IO::OUTPUT, buffer->second->bufferObjectBytes()};
+                if (auto asyncBuffer = std::dynamic_pointer_cast<AsyncDeviceOutputBuffer<uint8_t>>(buffer->second)) {
+                    entry.ringBufferBytes = asyncBuffer->ringBufferBytes();
+                    entry.archiveBytes = asyncBuffer->getArchivedBytes();
+                    entry.archiveCapacity = asyncBuffer->getArchiveCapacity();
+                }
+                footprint.buffers.emplace_back(std::move(entry));
+            }
+        }
+        return footprint;
+    }
+
+    void DeviceHandler::resetMetrics() {
+        // cppcheck-suppress unusedVariable
+        for (auto&& [key, value] : bufferMetrics) {
+            value->reset();
+        }
+        metricsSince = std::chrono::steady_clock::now();
+    }
 
     [[maybe_unused]] Finn::vector<uint8_t> DeviceHandler::retrieveResults(const std::string& outputBufferKernelName, bool forceArchival) {
+        allocateBuffers();
         if (!outputBufferMap.contains(outputBufferKernelName)) {
             auto newlineFold = [](std::string a, const auto& b) { return std::move(a) + '\n' + std::move(b.first); };
             std::string existingNames = "Existing buffer names:";
@@ -197,13 +649,15 @@ namespace Finn {
             FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + " [retrieve] Tried accessing kernel/buffer with name " + outputBufferKernelName + " but this kernel / buffer does not exist! " + existingNames);
         }
         if (forceArchival) {
-            // TODO(linusjun): Fix for asynchronous inference
-            // outputBufferMap.at(outputBufferKernelName)->archiveValidBufferParts();
+            if (auto asyncBuffer = std::dynamic_pointer_cast<AsyncDeviceOutputBuffer<uint8_t>>(outputBufferMap.at(outputBufferKernelName))) {
+                asyncBuffer->archiveValidBufferParts();
+            }
         }
         return outputBufferMap.at(outputBufferKernelName)->getData();
     }
 
     size_t DeviceHandler::size(SIZE_SPECIFIER ss, const std::string& bufferName) {
+        allocateBuffers();
         if (inputBufferMap.contains(bufferName)) {
             return inputBufferMap.at(bufferName)->size(ss);
         } else if (outputBufferMap.contains(bufferName)) {
@@ -19,9 +19,15 @@
 #include <stddef.h>                         // for size_t
 
 #include <FINNCppDriver/core/DeviceBuffer/DeviceBuffer.hpp>
+#include <FINNCppDriver/utils/DeviceMetrics.hpp>
+#include <FINNCppDriver/utils/MemoryBudget.hpp>
+#include <atomic>         // for atomic
+#include <chrono>         // for nanoseconds
 #include <cstdint>        // for uint8_t
 #include <iterator>       // for iterator_traits
 #include <memory>         // for shared_ptr
+#include <mutex>          // for once_flag
+#include <optional>       // for optional
 #include <span>           // for span
 #include <stdexcept>      // for runtime_error
 #include <string>         // for string
@@ -34,6 +40,52 @@
 
 namespace Finn {
     class UncheckedStore;
+
+    /**
+     * @brief Time spent in the phases of bringing up a device
+     *
+     */
+    struct DeviceStartupTimes {
+        /**
+         * @brief Opening the xrt::device
+         *
+         */
+        std::chrono::nanoseconds open{0};
+        /**
+         * @brief Reading the xclbin and programming the card with it, or only registering it if the card already ran the same xclbin
+         *
+         */
+        std::chrono::nanoseconds program{0};
+        /**
+         * @brief Allocating the buffer objects, 0 until they are allocated on first use
+         *
+         */
+        std::chrono::nanoseconds allocate{0};
+        /**
+         * @brief False if programming was skipped, because the card already reported the uuid of the xclbin
+         *
+         */
+        bool reprogrammed = false;
+    };
+
+    /**
+     * @brief An input and an output kernel of a device that process a batch together. Devices with DeviceWrapper::replicatedComputeUnits have one pair per replica of the
+     * design, all other devices have a single pair of their first input and first output.
+     *
+     */
+    struct ComputeUnitPair {
+        /**
+         * @brief Kernel name of the idma
+         *
+         */
+        std::string inputKernelName;
+        /**
+         * @brief Kernel name of the odma
+         *
+         */
+        std::string outputKernelName;
+    };
+
     /**
      * @brief Object of DeviceHandler is responsible to handle a programming of a Device and communication to it
      *
@@ -60,6 +112,18 @@ namespace Finn {
          */
         uint batchsize = 1;
 
+        /**
+         * @brief The batch size the buffers are allocated for. Synchronous buffers run any batch size up to this without being reallocated.
+         *
+         */
+        uint maxBatchSize = 1;
+
+        /**
+         * @brief Number of XRT buffer objects per synchronous DeviceBuffer (multi buffering)
+         *
+         */
+        unsigned int bufferSlots = 1;
+
         /**
          * @brief The xrt device itself
          *
@@ -79,6 +143,77 @@ namespace Finn {
         std::string xclbinPath;
         xrt::uuid uuid;
 
+        /**
+         * @brief NUMA node the PCIe slot of the device is attached to. Only resolved for AFFINITY_POLICY::DEVICE_LOCAL.
+         *
+         */
+        std::optional<unsigned int> numaNode;
+
+        /**
+         * @brief CPUs of numaNode. The buffers are allocated and their worker threads are started from these CPUs. Empty if the placement is left to the OS.
+         *
+         */
+        std::vector<unsigned int> localCpus;
+
+        /**
+         * @brief Input and output kernels that run a batch together, one pair per replicated compute unit
+         *
+         */
+        std::vector<ComputeUnitPair> computeUnitPairs;
+
+        /**
+         * @brief Counters of every idma and odma by kernel name. Created with the handler and handed to the buffers whenever they are allocated.
+         *
+         */
+        std::unordered_map<std::string, std::shared_ptr<BufferMetrics>> bufferMetrics;
+
+        /**
+         * @brief Time the counters were last reset
+         *
+         */
+        std::chrono::steady_clock::time_point metricsSince = std::chrono::steady_clock::now();
+
+        /**
+         * @brief Timings of the bring-up of this device
+         *
+         */
+        DeviceStartupTimes startupTimes;
+
+        /**
+         * @brief The buffer objects are allocated on first use through this flag. Replaced by a fresh flag whenever the buffers have to be reallocated. Kept behind a
+         * pointer so the handler stays movable.
+         *
+         */
+        std::unique_ptr<std::once_flag> bufferAllocation = std::make_unique<std::once_flag>();
+
+        /**
+         * @brief Longest time a synchronous wait gives a kernel run of this device, 0 to wait forever. Starts with DeviceWrapper::executeTimeoutMs.
+         *
+         */
+        std::chrono::microseconds executeTimeout{0};
+
+        /**
+         * @brief Health of the device. Set by the thread that saw a kernel miss its deadline and read by the scheduler and the watchdog from other threads.
+         *
+         */
+        struct DeviceHealth {
+            /**
+             * @brief A kernel run missed its execute timeout and the device was not recovered since
+             *
+             */
+            std::atomic<bool> stuck = false;
+            /**
+             * @brief Number of times the device was reprogrammed to recover from a stuck kernel
+             *
+             */
+            std::atomic<std::uint64_t> recoveries = 0;
+        };
+        /**
+         * @brief Kept behind a pointer so the handler stays movable
+         *
+         */
+        std::unique_ptr<DeviceHealth> health = std::make_unique<DeviceHealth>();
+
         /**
          * @brief Map containing all DeviceInputBuffers for this device
          *
@@ -99,8 +234,9 @@ namespace Finn {
          * @param devWrap
          * @param synchronousInference
          * @param hostBufferSize
+         * @param pBufferSlots Number of XRT buffer objects per synchronous DeviceBuffer
          */
-        explicit DeviceHandler(const DeviceWrapper& devWrap, bool synchronousInference, unsigned int hostBufferSize);
+        explicit DeviceHandler(const DeviceWrapper& devWrap, bool synchronousInference, unsigned int hostBufferSize, unsigned int pBufferSlots = 1);
         /**
          * @brief Default move constructor
          *
@@ -130,12 +266,104 @@ namespace Finn {
         ~DeviceHandler() = default;
 
         /**
-         * @brief Sets the input batch size. Needs to reinitialize all buffers!
+         * @brief Sets the input batch size. Synchronous buffers only change their active batch size as long as batchsize does not exceed the maximum batch size.
+         * Larger batch sizes (and any change for asynchronous buffers) reinitialize all buffers!
          *
          * @param batchsize
          */
         void setBatchSize(uint batchsize);
 
+        /**
+         * @brief Allocate all buffers for the given number of batch elements, so that every smaller batch size can be set without reallocation. Reinitializes all buffers!
+         * The current batch size is kept if it fits, otherwise it is reduced to the new maximum.
+         *
+         * @param pMaxBatchSize
+         */
+        void setMaxBatchSize(uint pMaxBatchSize);
+
+        /**
+         * @brief Get the batch size the buffers are allocated for
+         *
+         * @return uint
+         */
+        uint getMaxBatchSize() const;
+
+        /**
+         * @brief Sets the number of XRT buffer objects per synchronous DeviceBuffer. Needs to reinitialize all buffers!
+         *
+         * @param pBufferSlots
+         */
+        void setBufferSlots(unsigned int pBufferSlots);
+
+        /**
+         * @brief Select the buffer slot used by all buffers of this device for the next run / read
+         *
+         * @param slot
+         */
+        void setActiveBufferSlot(std::size_t slot);
+
+        /**
+         * @brief Set the strategy all buffers of this device use to wait for kernel completion
+         *
+         * @param policy
+         * @param spinBudget Number of polls before yielding (only used by WAIT_POLICY::SPIN_YIELD)
+         */
+        void setWaitPolicy(WAIT_POLICY policy, unsigned int spinBudget = defaultSpinBudget);
+
+        /**
+         * @brief Bound the time wait() gives a synchronous kernel run of this device. A run that misses it makes wait() throw a KernelTimeoutError and marks the device as
+         * stuck, @see isStuck
+         *
+         * @param timeout 0 to wait forever
+         */
+        void setExecuteTimeout(std::chrono::microseconds timeout);
+
+        /**
+         * @brief Get the execute timeout of the device, @see setExecuteTimeout
+         *
+         * @return std::chrono::microseconds
+         */
+        std::chrono::microseconds getExecuteTimeout() const;
+
+        /**
+         * @brief Check if a kernel of this device missed its execute timeout. A stuck device throws a KernelTimeoutError on every run until it was recovered. Thread safe.
+         *
+         * @return true
+         * @return false
+         */
+        bool isStuck() const;
+
+        /**
+         * @brief Number of times the device was recovered, @see recover
+         *
+         * @return std::uint64_t
+         */
+        std::uint64_t getRecoveries() const;
+
+        /**
+         * @brief Bring a stuck device back into service by reprogramming the card with its xclbin, which resets all kernels. The buffers are dropped first, so their IP
+         * cores are released before the card is programmed, and they are allocated again on next use. Results of runs that were in flight are lost.
+         * Mapped memory obtained from the buffers before (e.g. getMap) is freed, so prepared inference sessions of a driver become stale (@see getRecoveries).
+         * @attention No other thread may use the device or its buffers while it is recovered.
+         *
+         */
+        void recover();
+
+        /**
+         * @brief Set the memory cap for the archived results of all asynchronous output buffers of this device. @see AsyncDeviceOutputBuffer::setArchiveCapacity
+         *
+         * @param bytes 0 removes the cap
+         */
+        void setArchiveCapacity(std::size_t bytes);
+
+        /**
+         * @brief Register a callback for the packed results of an asynchronous output buffer. @see AsyncDeviceOutputBuffer::setResultCallback
+         *
+         * @param outputBufferKernelName
+         * @param callback Invoked from the buffer's worker thread for every batch element. An empty function removes the callback.
+         */
+        void setResultCallback(const std::string& outputBufferKernelName, packedResultCallback_t callback);
+
         /**
          * @brief Check if a correct DeviceWrapper configuration was given
          *
@@ -172,7 +400,8 @@ namespace Finn {
         std::unordered_map<std::string, std::shared_ptr<DeviceOutputBuffer<uint8_t>>>& getOutputBufferMap();
 
         /**
-         * @brief Run the device with the stored input
+         * @brief Run the device with the stored input. For synchronous inference the uploads of all inputs are started together first. Devices with replicated compute
+         * units only run their first pair, the same holds for wait and read.
          *
          * @return true success
          * @return false failure
@@ -188,13 +417,69 @@ namespace Finn {
         bool wait();
 
         /**
-         * @brief Reads the output buffers
+         * @brief Reads the output buffers. For synchronous inference the readback of all outputs is started together before the first one is joined.
          *
          * @return true success
          * @return false failure
          */
         bool read();
 
+        /**
+         * @brief Run only the kernels of one compute unit pair. Different pairs use disjoint buffers, so they can be run, waited for and read from different threads at the
+         * same time, as long as every pair is only used by one thread at a time.
+         *
+         * @param pair
+         * @return true success
+         * @return false failure
+         */
+        bool run(const ComputeUnitPair& pair);
+
+        /**
+         * @brief Wait for the run of one compute unit pair to finish
+         *
+         * @param pair
+         * @return true success
+         * @return false failure
+         */
+        bool wait(const ComputeUnitPair& pair);
+
+        /**
+         * @brief Read the output buffer of one compute unit pair
+         *
+         * @param pair
+         * @return true success
+         * @return false failure
+         */
+        bool read(const ComputeUnitPair& pair);
+
+        /**
+         * @brief Get the compute unit pairs of the device
+         *
+         * @return const std::vector<ComputeUnitPair>&
+         */
+        const std::vector<ComputeUnitPair>& getComputeUnitPairs() const;
+
+        /**
+         * @brief Get the transfer and execution counters of all idmas and odmas since the last reset. Thread safe, does not allocate the buffers.
+         *
+         * @return DeviceMetricsSnapshot
+         */
+        DeviceMetricsSnapshot getMetrics() const;
+
+        /**
+         * @brief Get the host memory currently held by the idmas and odmas. Does not allocate the buffers, the footprint has no buffers while they are not allocated.
+         * Must not be called concurrently with a reconfiguration of the buffers.
+         *
+         * @return DeviceFootprint
+         */
+        DeviceFootprint getMemoryFootprint() const;
+
+        /**
+         * @brief Set the counters of all buffers to zero and restart the time window of the utilisation. Must not be called concurrently with getMetrics.
+         *
+         */
+        void resetMetrics();
+
         /**
          * @brief Read from the output buffer on the host. This does NOT execute the output kernel
          *
@@ -235,6 +520,7 @@ namespace Finn {
          */
         template<typename IteratorType>
         bool store(IteratorType first, IteratorType last, const std::string& inputBufferKernelName) {
+            allocateBuffers();
             if (!inputBufferMap.contains(inputBufferKernelName)) {
                 FinnUtils::logAndError<std::runtime_error>("Tried accessing kernel/buffer with name " + inputBufferKernelName + " but this kernel / buffer does not exist!");
             }
@@ -257,20 +543,63 @@ namespace Finn {
          */
         std::shared_ptr<DeviceOutputBuffer<uint8_t>>& getOutputBuffer(const std::string& name);
 
+        /**
+         * @brief Allocate the buffer objects now instead of on first use, so that the first inference does not pay for it. Does nothing if they are allocated already.
+         * Safe to call from multiple threads.
+         *
+         */
+        void allocateBuffers();
+
+        /**
+         * @brief Check if the buffer objects are currently allocated
+         *
+         * @return true
+         * @return false
+         */
+        bool buffersAllocated() const;
+
+        /**
+         * @brief Get the timings of the bring-up of this device
+         *
+         * @return const DeviceStartupTimes&
+         */
+        const DeviceStartupTimes& getStartupTimes() const;
+
+        /**
+         * @brief Get the NUMA node the PCIe slot of this device is attached to
+         *
+         * @return std::optional<unsigned int> Empty if the affinity policy is NONE or the platform does not report the locality of the device
+         */
+        std::optional<unsigned int> getNumaNode() const;
+
+        /**
+         * @brief Get the CPUs local to this device. Threads that pack inputs for or unpack outputs from this device should run on them.
+         *
+         * @return const std::vector<unsigned int>& Empty if the placement is left to the OS
+         */
+        const std::vector<unsigned int>& getLocalCpus() const;
+
 
          protected:
         /**
-         * @brief Initialize the device by it's given xrtDeviceIndex, initializing the "device" member variable
+         * @brief Initialize the device by it's given xrtDeviceIndex, initializing the "device" member variable. Resolves the CPUs local to the device for
+         * AFFINITY_POLICY::DEVICE_LOCAL.
          *
          */
         void initializeDevice();
 
         /**
-         * @brief Loading the given xclbin by it's path. Sets the "uuid" member variable
+         * @brief Loading the given xclbin by it's path. Sets the "uuid" member variable. Programming the card is skipped if it already runs an xclbin with the same uuid.
          *
          */
         void loadXclbinSetUUID();
 
+        /**
+         * @brief Drop all buffer objects. They are allocated again with the current configuration on next use.
+         *
+         */
+        void invalidateBufferObjects();
+
         /**
          * @brief Create DeviceBuffers for every idma/odma in the DeviceWrapper.
          *
@@ -280,6 +609,46 @@ namespace Finn {
          */
         void initializeBufferObjects(const DeviceWrapper& devWrap, unsigned int hostBufferSize, bool pSynchronousInference);
 
+        /**
+         * @brief Create one device memory arena per memory group that holds all buffer slots of the synchronous buffers of the group, if the config asks for arenas.
+         * Inputs fed by another device keep their own P2P buffer objects. If an arena cannot be allocated, its buffers fall back to buffer objects of their own.
+         *
+         * @param devWrap
+         * @param hostBufferSize
+         * @return std::unordered_map<std::string, std::shared_ptr<DeviceMemoryArena>> Arena of every kernel that takes its buffer objects from one
+         */
+        std::unordered_map<std::string, std::shared_ptr<DeviceMemoryArena>> createMemoryArenas(const DeviceWrapper& devWrap, unsigned int hostBufferSize);
+
+        /**
+         * @brief Apply the wait policy stored in devInformation to all buffers
+         *
+         */
+        void applyWaitPolicy();
+
+        /**
+         * @brief Apply the execute timeout to all buffers. Leaves the wait policy and the worker threads of asynchronous buffers alone.
+         *
+         */
+        void applyExecuteTimeout();
+
+        /**
+         * @brief Throw a KernelTimeoutError if the device is stuck, so a run never starts kernels that did not finish the previous one
+         *
+         */
+        void checkNotStuck() const;
+
+        /**
+         * @brief Mark the device as stuck after a kernel missed its deadline
+         *
+         */
+        void markStuck();
+
+        /**
+         * @brief Apply the current batch size to all synchronous buffers without reallocating them
+         *
+         */
+        void applyActiveBatchSize();
+
          private:
         /**
          * @brief A logger prefix to determine the source of a log write
@@ -301,6 +670,7 @@ namespace Finn {
         template<typename IteratorType>
         bool storeUnchecked(IteratorType first, IteratorType last, const std::string& inputBufferKernelName) {
             static_assert(std::is_same<typename std::iterator_traits<IteratorType>::value_type, uint8_t>::value);
+            allocateBuffers();
             return inputBufferMap.at(inputBufferKernelName)->store(std::span<const uint8_t>(first, last));
         }
 
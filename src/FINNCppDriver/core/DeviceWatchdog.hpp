@@ -0,0 +1,93 @@
+/**
+ * @file DeviceWatchdog.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Background thread that brings devices with stuck kernels back into service
+ * @version 0.1
+ * @date 2024-03-20
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef DEVICEWATCHDOG
+#define DEVICEWATCHDOG
+
+#include <FINNCppDriver/utils/Logger.h>
+
+#include <FINNCppDriver/core/Accelerator.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+
+namespace Finn {
+    /**
+     * @brief Periodically recovers the devices of an accelerator whose kernels missed their execute timeout (@see DeviceHandler::setExecuteTimeout). A wait that
+     * misses its deadline marks its device as stuck, the scheduler then hands the device no more work, and once all leases of the device were returned the watchdog
+     * reprograms it. Meanwhile the batches go to the healthy devices.
+     * @attention Only leases are waited for, so the devices must only be used through the scheduled inference functions while the watchdog runs.
+     *
+     */
+    class DeviceWatchdog {
+         private:
+        std::atomic<std::size_t> recovered = 0;
+        std::mutex wakeupMutex;
+        std::condition_variable_any wakeup;
+        std::jthread watchdog;
+
+        /**
+         * @brief A logger prefix to determine the source of a log write
+         *
+         * @return std::string
+         */
+        static std::string loggerPrefix() { return "[DeviceWatchdog] "; }
+
+         public:
+        /**
+         * @brief Start watching
+         *
+         * @param accelerator Has to outlive the watchdog
+         * @param interval Time between two checks. Bounds how long a stuck device is out of service after it was drained.
+         */
+        DeviceWatchdog(Accelerator& accelerator, std::chrono::milliseconds interval) {
+            watchdog = std::jthread([this, &accelerator, interval](const std::stop_token& stoken) {
+                std::unique_lock lock(wakeupMutex);
+                while (!wakeup.wait_for(lock, stoken, interval, [&stoken]() { return stoken.stop_requested(); })) {
+                    if (const std::size_t devices = accelerator.recoverStuckDevices(); devices > 0) {
+                        recovered.fetch_add(devices, std::memory_order_relaxed);
+                        FINN_LOG(Logger::getLogger(), loglevel::info) << loggerPrefix() << "Recovered " << devices << " stuck device(s)";
+                    }
+                }
+            });
+        }
+
+        DeviceWatchdog(DeviceWatchdog&&) = delete;
+        DeviceWatchdog(const DeviceWatchdog&) = delete;
+        DeviceWatchdog& operator=(DeviceWatchdog&&) = delete;
+        DeviceWatchdog& operator=(const DeviceWatchdog&) = delete;
+
+        /**
+         * @brief Stop watching. Waits for a recovery that is in progress.
+         *
+         */
+        ~DeviceWatchdog() {
+            watchdog.request_stop();
+            if (watchdog.joinable()) {
+                watchdog.join();
+            }
+        }
+
+        /**
+         * @brief Number of devices the watchdog recovered so far
+         *
+         * @return std::size_t
+         */
+        std::size_t getRecoveredDevices() const { return recovered.load(std::memory_order_relaxed); }
+    };
+}  // namespace Finn
+
+#endif  // DEVICEWATCHDOG
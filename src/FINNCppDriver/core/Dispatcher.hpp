@@ -0,0 +1,197 @@
+/**
+ * @file Dispatcher.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Dispatcher thread shared by the front-ends that serve requests of many clients with one driver
+ * @version 0.1
+ * @date 2024-03-21
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef DISPATCHER
+#define DISPATCHER
+
+#include <FINNCppDriver/utils/FinnUtils.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace Finn {
+    /**
+     * @brief Thread that serves the requests of a front-end (DynamicBatcher, SharedMemoryDaemon, ModelScheduler), together with the lock and the condition variable
+     * of the queue the front-end keeps its requests in. The thread calls the step function of the front-end until it returns false. On stop, requests that were
+     * accepted before are still served, because the step function only returns false once there is nothing left to do, and later submissions are rejected.
+     *
+     * Front-ends call stop() first thing in their destructor, so the thread never sees a partially destroyed owner.
+     */
+    class Dispatcher {
+         public:
+        /**
+         * @brief Serves the next batch of requests. Returns false once the dispatcher is stopping and nothing is left to serve.
+         *
+         */
+        using step_t = std::function<bool(const std::stop_token&)>;
+
+         private:
+        std::string owner;
+        std::mutex queueMutex;
+        std::condition_variable queueChanged;
+        bool stopping = false;
+
+        std::atomic<std::size_t> batches = 0;
+        std::atomic<std::size_t> served = 0;
+
+        std::jthread thread;
+
+         public:
+        /**
+         * @brief Construct a new Dispatcher object. The thread is only started by start().
+         *
+         * @param pOwner Logger prefix of the front-end, used for errors
+         */
+        explicit Dispatcher(std::string pOwner) : owner(std::move(pOwner)) {}
+
+        /**
+         * @brief Destroy the Dispatcher object. Stops the thread if the owner did not do so already.
+         *
+         */
+        ~Dispatcher() { stop(); }
+
+        Dispatcher(Dispatcher&&) = delete;
+        Dispatcher(const Dispatcher&) = delete;
+        Dispatcher& operator=(Dispatcher&&) = delete;
+        Dispatcher& operator=(const Dispatcher&) = delete;
+
+        /**
+         * @brief Start the thread. Has to be called after the owner is completely initialized.
+         *
+         * @param step
+         */
+        void start(step_t step) {
+            thread = std::jthread([this, serve = std::move(step)](const std::stop_token& stop) {
+                while (serve(stop)) {
+                    // Every call serves one batch
+                }
+            });
+        }
+
+        /**
+         * @brief Stop accepting requests, wake the thread and wait until it served what was accepted before
+         *
+         */
+        void stop() {
+            {
+                std::lock_guard guard(queueMutex);
+                stopping = true;
+            }
+            queueChanged.notify_all();
+            thread.request_stop();
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+
+        /**
+         * @brief Lock the queue of the owner
+         *
+         * @return std::unique_lock<std::mutex>
+         */
+        [[nodiscard]] std::unique_lock<std::mutex> lock() { return std::unique_lock(queueMutex); }
+
+        /**
+         * @brief Add a request to the queue of the owner. Thread safe.
+         *
+         * @tparam Enqueue Callable that adds the request while the queue is locked and returns true if the thread has to be woken up for it
+         * @param enqueue
+         * @throws std::runtime_error If the dispatcher is stopping
+         */
+        template<typename Enqueue>
+        void submit(Enqueue&& enqueue) {
+            bool wake = false;
+            {
+                std::lock_guard guard(queueMutex);
+                if (stopping) {
+                    FinnUtils::logAndError<std::runtime_error>(owner + "Shutting down, no more requests are accepted");
+                }
+                wake = std::forward<Enqueue>(enqueue)();
+            }
+            if (wake) {
+                queueChanged.notify_one();
+            }
+        }
+
+        /**
+         * @brief Wait with the queue locked until there is work or the dispatcher is stopping
+         *
+         * @tparam Predicate
+         * @param lock Lock returned by lock()
+         * @param hasWork
+         * @return true There is work
+         * @return false Stopping and nothing left to do
+         */
+        template<typename Predicate>
+        bool wait(std::unique_lock<std::mutex>& lock, Predicate hasWork) {
+            queueChanged.wait(lock, [&]() { return stopping || hasWork(); });
+            return hasWork();
+        }
+
+        /**
+         * @brief Wait with the queue locked until the predicate holds, the deadline passed or the dispatcher is stopping
+         *
+         * @tparam Predicate
+         * @param lock Lock returned by lock()
+         * @param deadline
+         * @param ready
+         */
+        template<typename Predicate>
+        void waitUntil(std::unique_lock<std::mutex>& lock, std::chrono::steady_clock::time_point deadline, Predicate ready) {
+            queueChanged.wait_until(lock, deadline, [&]() { return stopping || ready(); });
+        }
+
+        /**
+         * @brief Check if the dispatcher is stopping. Has to be called with the queue locked.
+         *
+         * @return true
+         * @return false
+         */
+        bool isStopping() const { return stopping; }
+
+        /**
+         * @brief Count a batch that is about to be served. Front-ends count before they hand out any result, so a client that holds its result knows its batch is
+         * included in the statistics.
+         *
+         * @param requests Number of requests of the batch
+         */
+        void countBatch(std::size_t requests) {
+            batches.fetch_add(1, std::memory_order_relaxed);
+            served.fetch_add(requests, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Number of batches served so far
+         *
+         * @return std::size_t
+         */
+        std::size_t getBatchCount() const { return batches.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Number of requests served so far
+         *
+         * @return std::size_t
+         */
+        std::size_t getRequestCount() const { return served.load(std::memory_order_relaxed); }
+    };
+}  // namespace Finn
+
+#endif  // DISPATCHER
@@ -0,0 +1,220 @@
+/**
+ * @file DynamicBatcher.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Coalesces single sample requests of many client threads into batched synchronous inferences
+ * @version 0.1
+ * @date 2024-02-05
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef DYNAMICBATCHER
+#define DYNAMICBATCHER
+
+#include <FINNCppDriver/utils/FinnUtils.h>
+#include <FINNCppDriver/utils/Logger.h>
+#include <FINNCppDriver/utils/Types.h>
+
+#include <FINNCppDriver/core/Dispatcher.hpp>
+#include <FINNCppDriver/utils/MemoryArena.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <future>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Finn {
+    /**
+     * @brief Front-end for serving many small requests with one synchronous driver. Client threads submit single samples and receive their result through a future.
+     * A dispatcher thread collects pending samples until either maxBatch samples are waiting or the oldest sample has waited for maxDelay, then runs them as one
+     * batch on the default input and output of the driver and scatters the results back. This amortizes the per invocation overhead (register writes, buffer syncs,
+     * waiting for the kernel) over the whole batch while bounding the additional latency.
+     *
+     * @attention The batcher is the only user of the driver while it exists. The driver must not be used or moved by other threads during that time.
+     *
+     * @tparam DriverType Synchronous Finn::BaseDriver
+     * @tparam U Input datatype of the samples
+     * @tparam V Output datatype of the results
+     */
+    template<typename DriverType, typename U, typename V = typename DriverType::AutoDeducedRetType>
+    class DynamicBatcher {
+         private:
+        /**
+         * @brief One submitted sample
+         *
+         */
+        struct Request {
+            Finn::vector<U> sample;
+            std::promise<Finn::vector<V>> result;
+            std::chrono::steady_clock::time_point arrival;
+        };
+
+        DriverType& driver;
+        std::chrono::microseconds maxDelay;
+        unsigned int maxBatch;
+        std::size_t inputElements;
+        std::size_t outputElements;
+
+        // Guarded by the lock of the dispatcher
+        std::deque<Request> pending;
+
+        // Gathered inputs and outputs of a batch, only used by the dispatcher thread
+        MemoryArena arena;
+
+        Dispatcher dispatcher{loggerPrefix()};
+
+        /**
+         * @brief A logger prefix to determine the source of a log write
+         *
+         * @return std::string
+         */
+        static std::string loggerPrefix() { return "[DynamicBatcher] "; }
+
+        /**
+         * @brief Wait for the next batch to be complete. Returns an empty batch once the batcher is stopped and all pending requests are served.
+         *
+         * @return std::vector<Request>
+         */
+        std::vector<Request> collectBatch() {
+            auto lock = dispatcher.lock();
+            if (!dispatcher.wait(lock, [this]() { return !pending.empty(); })) {
+                return {};
+            }
+            if (!dispatcher.isStopping()) {
+                dispatcher.waitUntil(lock, pending.front().arrival + maxDelay, [this]() { return pending.size() >= maxBatch; });
+            }
+            const std::size_t count = std::min<std::size_t>(pending.size(), maxBatch);
+            std::vector<Request> batch;
+            batch.reserve(count);
+            std::move(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(count), std::back_inserter(batch));
+            pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(count));
+            return batch;
+        }
+
+        /**
+         * @brief Run one batch on the driver and fulfill the promises of its requests
+         *
+         * @param batch
+         */
+        void runBatch(std::vector<Request>& batch) {
+            dispatcher.countBatch(batch.size());
+            try {
+                MemoryArena::Scope scope(arena);
+                arena_vector<U> input(batch.size() * inputElements, ArenaAllocator<U>(arena));
+                for (std::size_t i = 0; i < batch.size(); ++i) {
+                    std::copy(batch[i].sample.begin(), batch[i].sample.end(), input.begin() + static_cast<std::ptrdiff_t>(i * inputElements));
+                }
+                arena_vector<V> output(batch.size() * outputElements, ArenaAllocator<V>(arena));
+                driver.setBatchSize(static_cast<unsigned int>(batch.size()));
+                driver.inferSynchronous(input.begin(), input.end(), std::span<V>(output.data(), output.size()), driver.getDefaultInputDeviceIndex(), driver.getDefaultInputKernelName(),
+                                        driver.getDefaultOutputDeviceIndex(), driver.getDefaultOutputKernelName());
+                for (std::size_t i = 0; i < batch.size(); ++i) {
+                    auto first = output.begin() + static_cast<std::ptrdiff_t>(i * outputElements);
+                    batch[i].result.set_value(Finn::vector<V>(first, first + static_cast<std::ptrdiff_t>(outputElements)));
+                }
+            } catch (...) {
+                for (auto&& request : batch) {
+                    request.result.set_exception(std::current_exception());
+                }
+            }
+        }
+
+        /**
+         * @brief Step of the dispatcher thread
+         *
+         * @return true
+         * @return false Stopped and all pending requests are served
+         */
+        bool serveNext() {
+            auto batch = collectBatch();
+            if (batch.empty()) {
+                return false;
+            }
+            runBatch(batch);
+            return true;
+        }
+
+         public:
+        /**
+         * @brief Construct a new Dynamic Batcher and start its dispatcher thread
+         *
+         * @param pDriver Synchronous driver. If pMaxBatch exceeds its maximum batch size, the device buffers are reallocated once for pMaxBatch.
+         * @param pMaxDelay Longest time a sample waits for other samples before its batch is dispatched
+         * @param pMaxBatch Largest number of samples per batch. 0 uses the maximum batch size of the driver.
+         */
+        DynamicBatcher(DriverType& pDriver, std::chrono::microseconds pMaxDelay, unsigned int pMaxBatch = 0)
+            : driver(pDriver),
+              maxDelay(pMaxDelay),
+              maxBatch((pMaxBatch == 0) ? pDriver.getMaxBatchSize() : pMaxBatch),
+              inputElements(pDriver.getInputElementsPerSample()),
+              outputElements(pDriver.getOutputElementsPerSample()) {
+            if (maxBatch > driver.getMaxBatchSize()) {
+                driver.setMaxBatchSize(maxBatch);
+            }
+            dispatcher.start([this](const std::stop_token&) { return serveNext(); });
+        }
+
+        /**
+         * @brief Destroy the Dynamic Batcher object. Requests that are still pending are run before the dispatcher terminates.
+         *
+         */
+        ~DynamicBatcher() { dispatcher.stop(); }
+
+        DynamicBatcher(DynamicBatcher&&) = delete;
+        DynamicBatcher(const DynamicBatcher&) = delete;
+        DynamicBatcher& operator=(DynamicBatcher&&) = delete;
+        DynamicBatcher& operator=(const DynamicBatcher&) = delete;
+
+        /**
+         * @brief Submit one sample for inference. Thread safe.
+         *
+         * @param sample Exactly one batch element worth of (folded) input elements
+         * @return std::future<Finn::vector<V>> Output of the sample
+         */
+        [[nodiscard]] std::future<Finn::vector<V>> submit(std::span<const U> sample) {
+            if (sample.size() != inputElements) {
+                FinnUtils::logAndError<std::invalid_argument>(loggerPrefix() + "Sample has " + std::to_string(sample.size()) + " elements, but " + std::to_string(inputElements) + " are expected");
+            }
+            Request request{Finn::vector<U>(sample.begin(), sample.end()), {}, std::chrono::steady_clock::now()};
+            auto future = request.result.get_future();
+            dispatcher.submit([&]() {
+                pending.emplace_back(std::move(request));
+                // The dispatcher only needs to wake up for the first sample of a batch and once the batch is full
+                return pending.size() == 1 || pending.size() >= maxBatch;
+            });
+            return future;
+        }
+
+        /**
+         * @brief Largest number of samples per batch
+         *
+         * @return unsigned int
+         */
+        unsigned int getMaxBatch() const { return maxBatch; }
+
+        /**
+         * @brief Number of batches run so far
+         *
+         * @return std::size_t
+         */
+        std::size_t getBatchCount() const { return dispatcher.getBatchCount(); }
+
+        /**
+         * @brief Number of requests served so far
+         *
+         * @return std::size_t
+         */
+        std::size_t getRequestCount() const { return dispatcher.getRequestCount(); }
+    };
+}  // namespace Finn
+
+#endif  // DYNAMICBATCHER
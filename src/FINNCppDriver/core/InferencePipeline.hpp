@@ -0,0 +1,463 @@
+/**
+ * @file InferencePipeline.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Streams batches from a source through packing, the devices and unpacking into a sink, every stage on its own threads
+ * @version 0.1
+ * @date 2024-03-21
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef INFERENCEPIPELINE
+#define INFERENCEPIPELINE
+
+#include <FINNCppDriver/utils/FinnUtils.h>
+#include <FINNCppDriver/utils/Logger.h>
+#include <FINNCppDriver/utils/Types.h>
+
+#include <FINNCppDriver/utils/BoundedQueue.hpp>
+#include <FINNCppDriver/utils/NpyStream.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+#include <latch>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Finn {
+    /**
+     * @brief Pulls the input of the next batch. Writes up to batch.size() elements, always whole samples, and returns the number of elements written. Returning 0 ends
+     * the stream, a partial batch is only allowed as the last one. Called from one thread at a time.
+     *
+     * @tparam T Input datatype
+     */
+    template<typename T>
+    using PipelineSource = std::function<std::size_t(std::span<T> batch)>;
+
+    /**
+     * @brief Receives the results of one batch, without the padding of a partial last batch. Called from one thread at a time.
+     *
+     * @tparam V Output datatype
+     * @param firstSample Position of the first sample of the batch in the stream
+     * @param results Valid until the sink returns
+     */
+    template<typename V>
+    using PipelineSink = std::function<void(std::size_t firstSample, std::span<const V> results)>;
+
+    /**
+     * @brief Source reading a range, e.g. of a container that holds the whole input
+     *
+     * @tparam IteratorType
+     * @param first
+     * @param last Has to be valid until the pipeline finished
+     * @return PipelineSource<typename std::iterator_traits<IteratorType>::value_type>
+     */
+    template<typename IteratorType>
+    PipelineSource<typename std::iterator_traits<IteratorType>::value_type> iteratorSource(IteratorType first, IteratorType last) {
+        return [first, last](auto batch) mutable {
+            const auto count = std::min(batch.size(), static_cast<std::size_t>(std::distance(first, last)));
+            auto end = std::next(first, static_cast<std::ptrdiff_t>(count));
+            std::copy(first, end, batch.begin());
+            first = end;
+            return count;
+        };
+    }
+
+    /**
+     * @brief Source asking a generator for one sample after another
+     *
+     * @tparam T Input datatype
+     * @param sampleElements Input elements of one sample, @see BaseDriver::getInputElementsPerSample
+     * @param next Writes the next sample into the given span and returns true, or returns false at the end of the stream
+     * @return PipelineSource<T>
+     */
+    template<typename T>
+    PipelineSource<T> generatorSource(std::size_t sampleElements, std::function<bool(std::span<T> sample)> next) {
+        return [sampleElements, next = std::move(next)](std::span<T> batch) {
+            std::size_t filled = 0;
+            while (filled + sampleElements <= batch.size() && next(batch.subspan(filled, sampleElements))) {
+                filled += sampleElements;
+            }
+            return filled;
+        };
+    }
+
+    /**
+     * @brief Source streaming an npy file in batches, so the file does not have to fit into memory. T has to match the type of the file.
+     *
+     * @tparam T Input datatype
+     * @param path
+     * @return PipelineSource<T>
+     */
+    template<typename T>
+    PipelineSource<T> npySource(const std::filesystem::path& path) {
+        auto reader = std::make_shared<NpyReader>(path);
+        return [reader](std::span<T> batch) { return reader->read(batch); };
+    }
+
+    /**
+     * @brief Threads of every stage of an InferencePipeline
+     *
+     */
+    struct PipelineOptions {
+        /**
+         * @brief Threads packing batches
+         *
+         */
+        unsigned int packers = 1;
+        /**
+         * @brief Threads driving the devices, 0 for one per buffer set of the accelerator (devices times buffer slots)
+         *
+         */
+        unsigned int deviceWorkers = 0;
+        /**
+         * @brief Threads unpacking batches
+         *
+         */
+        unsigned int unpackers = 1;
+        /**
+         * @brief Number of batches in flight, 0 for enough to keep every thread busy. Every batch owns its input, packed and output buffers, so this bounds the memory
+         * of the pipeline. The source waits while all batches are in use.
+         *
+         */
+        std::size_t batchBuffers = 0;
+        /**
+         * @brief Hand the results to the sink in the order of the source. Otherwise they are handed over as soon as they are unpacked.
+         *
+         */
+        bool ordered = true;
+    };
+
+    /**
+     * @brief Time the threads of one stage spent working, excluding the time they waited for other stages
+     *
+     */
+    struct PipelineStageStatistics {
+        unsigned int threads = 0;
+        std::chrono::nanoseconds busy{0};
+
+        /**
+         * @brief Share of the run the threads of the stage were busy
+         *
+         * @param elapsed Duration of the run
+         * @return double Between 0 and 1, the stage with the highest utilisation limits the throughput
+         */
+        double utilisation(std::chrono::nanoseconds elapsed) const { return (elapsed.count() > 0 && threads > 0) ? static_cast<double>(busy.count()) / (static_cast<double>(elapsed.count()) * threads) : 0.0; }
+    };
+
+    /**
+     * @brief Result of InferencePipeline::run
+     *
+     */
+    struct PipelineStatistics {
+        std::size_t batches = 0;
+        std::size_t samples = 0;
+        std::chrono::nanoseconds elapsed{0};
+        PipelineStageStatistics source;
+        PipelineStageStatistics pack;
+        PipelineStageStatistics device;
+        PipelineStageStatistics unpack;
+        PipelineStageStatistics sink;
+
+        /**
+         * @brief Throughput of the run
+         *
+         * @return double
+         */
+        double samplesPerSecond() const { return (elapsed.count() > 0) ? static_cast<double>(samples) / std::chrono::duration<double>(elapsed).count() : 0.0; }
+    };
+
+    /**
+     * @brief Runs a stream of batches through the stages source, pack, device, unpack and sink. Every stage has its own threads, and the stages are connected by
+     * bounded queues, so packing the next batches, running the devices and unpacking earlier results overlap. The device stage schedules the batches over all devices
+     * of the accelerator (@see BaseDriver::inferSynchronousScheduledPrepacked). A fixed pool of batch buffers is recycled through the stages: no buffer is allocated
+     * while the pipeline runs, and the source automatically slows down to the speed of the slowest stage once all buffers are in flight.
+     * @attention The pipeline is the only user of the driver while it runs. The batch size must not change during a run.
+     *
+     * @tparam DriverType Synchronous Finn::BaseDriver
+     * @tparam T Input datatype
+     * @tparam V Output datatype
+     */
+    template<typename DriverType, typename T, typename V = typename DriverType::AutoDeducedRetType>
+    class InferencePipeline {
+         private:
+        /**
+         * @brief Buffers of one batch in flight
+         *
+         */
+        struct Batch {
+            std::size_t index = 0;
+            std::size_t samples = 0;
+            Finn::vector<T> input;
+            Finn::vector<uint8_t> packedInput;
+            Finn::vector<uint8_t> packedOutput;
+            Finn::vector<V> output;
+        };
+        using BatchQueue = BoundedQueue<std::unique_ptr<Batch>>;
+
+        DriverType& driver;
+        PipelineOptions options;
+
+        /**
+         * @brief A logger prefix to determine the source of a log write
+         *
+         * @return std::string
+         */
+        static std::string loggerPrefix() { return "[InferencePipeline] "; }
+
+        /**
+         * @brief State shared by the threads of one run
+         *
+         */
+        struct Run {
+            std::stop_source abort;
+            std::mutex errorMutex;
+            std::exception_ptr error;
+
+            /**
+             * @brief Remember the first error and stop all stages
+             *
+             */
+            void fail() {
+                {
+                    std::lock_guard guard(errorMutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+                abort.request_stop();
+            }
+        };
+
+        /**
+         * @brief Time a stage works on a batch
+         *
+         */
+        class BusyTimer {
+            std::atomic<std::chrono::nanoseconds::rep>& busy;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+             public:
+            explicit BusyTimer(std::atomic<std::chrono::nanoseconds::rep>& pBusy) : busy(pBusy) {}
+            ~BusyTimer() { busy.fetch_add((std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed); }
+            BusyTimer(BusyTimer&&) = delete;
+            BusyTimer(const BusyTimer&) = delete;
+            BusyTimer& operator=(BusyTimer&&) = delete;
+            BusyTimer& operator=(const BusyTimer&) = delete;
+        };
+
+        /**
+         * @brief Start the threads of a stage that takes batches from one queue, works on them and passes them to the next queue. The last thread to finish closes the
+         * next queue, so the following stage drains it and stops.
+         *
+         * @tparam Work
+         * @param threads Receives the started threads
+         * @param count Number of threads
+         * @param in
+         * @param out
+         * @param run
+         * @param busy Sums up the time spent in work
+         * @param done Counts the finished threads of the stage
+         * @param work Called with every batch
+         */
+        template<typename Work>
+        static void startStage(std::vector<std::jthread>& threads, unsigned int count, BatchQueue& in, BatchQueue& out, Run& run, std::atomic<std::chrono::nanoseconds::rep>& busy, std::latch& done, Work work) {
+            for (unsigned int i = 0; i < count; ++i) {
+                threads.emplace_back([&in, &out, &run, &busy, &done, work]() {
+                    try {
+                        for (auto batch = in.pop(run.abort.get_token()); batch; batch = in.pop(run.abort.get_token())) {
+                            {
+                                BusyTimer timer(busy);
+                                work(**batch);
+                            }
+                            if (!out.push(std::move(*batch), run.abort.get_token())) {
+                                break;
+                            }
+                        }
+                    } catch (...) {
+                        run.fail();
+                    }
+                    done.count_down();
+                    if (done.try_wait()) {
+                        out.close();
+                    }
+                });
+            }
+        }
+
+         public:
+        /**
+         * @brief Construct a new pipeline on the default input and output of the driver
+         *
+         * @param pDriver Synchronous driver, has to outlive the pipeline
+         * @param pOptions
+         */
+        explicit InferencePipeline(DriverType& pDriver, const PipelineOptions& pOptions = {}) : driver(pDriver), options(pOptions) {
+            if (options.packers == 0 || options.unpackers == 0) {
+                FinnUtils::logAndError<std::invalid_argument>(loggerPrefix() + "Every stage needs at least one thread!");
+            }
+            if (options.deviceWorkers == 0) {
+                options.deviceWorkers = static_cast<unsigned int>(driver.getAccelerator().deviceCount() * driver.getBufferSlots());
+            }
+            if (options.batchBuffers == 0) {
+                // One batch for every thread, and one waiting in front of every stage
+                options.batchBuffers = options.packers + options.deviceWorkers + options.unpackers + 5;
+            }
+        }
+
+        /**
+         * @brief Get the options with the defaults resolved
+         *
+         * @return const PipelineOptions&
+         */
+        const PipelineOptions& getOptions() const { return options; }
+
+        /**
+         * @brief Stream everything the source provides through the pipeline. Blocks until the sink received the last results. The first error raised by any stage stops
+         * the run and is rethrown here.
+         *
+         * @param source
+         * @param sink
+         * @return PipelineStatistics
+         */
+        PipelineStatistics run(PipelineSource<T> source, PipelineSink<V> sink) {
+            const std::size_t batchSize = driver.getBatchSize();
+            const std::size_t inputPerSample = driver.getInputElementsPerSample();
+            const std::size_t outputPerSample = driver.getOutputElementsPerSample();
+            const std::size_t packedInputBytes = driver.getPackedInputBytes(driver.getDefaultInputDeviceIndex(), driver.getDefaultInputKernelName());
+            const std::size_t packedOutputBytes = driver.getPackedOutputBytes(driver.getDefaultOutputDeviceIndex(), driver.getDefaultOutputKernelName());
+
+            // The queues can hold every batch, so only the pool ever blocks a stage that has a batch to pass on
+            BatchQueue freeBatches(options.batchBuffers);
+            BatchQueue loaded(options.batchBuffers);
+            BatchQueue packed(options.batchBuffers);
+            BatchQueue computed(options.batchBuffers);
+            BatchQueue unpacked(options.batchBuffers);
+            for (std::size_t i = 0; i < options.batchBuffers; ++i) {
+                auto batch = std::make_unique<Batch>();
+                batch->input.resize(batchSize * inputPerSample);
+                batch->packedInput.resize(packedInputBytes);
+                batch->packedOutput.resize(packedOutputBytes);
+                batch->output.resize(batchSize * outputPerSample);
+                freeBatches.push(std::move(batch));
+            }
+
+            Run state;
+            std::array<std::atomic<std::chrono::nanoseconds::rep>, 5> busy{};
+            std::latch packersDone(options.packers);
+            std::latch devicesDone(options.deviceWorkers);
+            std::latch unpackersDone(options.unpackers);
+            std::size_t batches = 0;
+            std::size_t samples = 0;
+            const auto start = std::chrono::steady_clock::now();
+
+            std::vector<std::jthread> threads;
+            threads.reserve(1 + options.packers + options.deviceWorkers + options.unpackers + 1);
+            threads.emplace_back([&]() {
+                try {
+                    for (auto batch = freeBatches.pop(state.abort.get_token()); batch; batch = freeBatches.pop(state.abort.get_token())) {
+                        std::size_t filled = 0;
+                        {
+                            BusyTimer timer(busy[0]);
+                            filled = source(std::span<T>((*batch)->input));
+                        }
+                        if (filled == 0) {
+                            break;
+                        }
+                        if (filled % inputPerSample != 0 || filled > (*batch)->input.size()) {
+                            FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "The source returned " + std::to_string(filled) + " elements, which is not a whole number of samples of " + std::to_string(inputPerSample) +
+                                                                       " elements!");
+                        }
+                        // The padding of a partial last batch is never handed to the sink
+                        std::fill((*batch)->input.begin() + static_cast<std::ptrdiff_t>(filled), (*batch)->input.end(), T{});
+                        (*batch)->index = batches++;
+                        (*batch)->samples = filled / inputPerSample;
+                        samples += (*batch)->samples;
+                        const bool last = filled < (*batch)->input.size();
+                        if (!loaded.push(std::move(*batch), state.abort.get_token()) || last) {
+                            break;
+                        }
+                    }
+                } catch (...) {
+                    state.fail();
+                }
+                loaded.close();
+            });
+            startStage(threads, options.packers, loaded, packed, state, busy[1], packersDone, [this](Batch& batch) {
+                driver.packBatch(batch.input.begin(), batch.input.end(), std::span<uint8_t>(batch.packedInput), driver.getDefaultInputDeviceIndex(), driver.getDefaultInputKernelName());
+            });
+            startStage(threads, options.deviceWorkers, packed, computed, state, busy[2], devicesDone,
+                       [this](Batch& batch) { driver.inferSynchronousScheduledPrepacked(std::span<const uint8_t>(batch.packedInput), std::span<uint8_t>(batch.packedOutput)); });
+            startStage(threads, options.unpackers, computed, unpacked, state, busy[3], unpackersDone, [this](Batch& batch) {
+                driver.template unpackBatch<V>(std::span<const uint8_t>(batch.packedOutput), std::span<V>(batch.output), driver.getDefaultOutputDeviceIndex(), driver.getDefaultOutputKernelName());
+            });
+            threads.emplace_back([&]() {
+                try {
+                    std::map<std::size_t, std::unique_ptr<Batch>> waiting;
+                    std::size_t next = 0;
+                    auto deliver = [&](std::unique_ptr<Batch> batch) {
+                        {
+                            BusyTimer timer(busy[4]);
+                            sink(batch->index * batchSize, std::span<const V>(batch->output).first(batch->samples * outputPerSample));
+                        }
+                        freeBatches.push(std::move(batch));
+                    };
+                    for (auto batch = unpacked.pop(state.abort.get_token()); batch; batch = unpacked.pop(state.abort.get_token())) {
+                        if (!options.ordered) {
+                            deliver(std::move(*batch));
+                            continue;
+                        }
+                        // The batch the sink waits for always holds a buffer already, so waiting batches can never starve it
+                        waiting.emplace((*batch)->index, std::move(*batch));
+                        for (auto first = waiting.begin(); first != waiting.end() && first->first == next; first = waiting.begin()) {
+                            deliver(std::move(first->second));
+                            waiting.erase(first);
+                            ++next;
+                        }
+                    }
+                } catch (...) {
+                    state.fail();
+                }
+                // Lets the source stop if the sink failed while it waits for a buffer
+                freeBatches.close();
+            });
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            if (state.error) {
+                std::rethrow_exception(state.error);
+            }
+
+            PipelineStatistics statistics;
+            statistics.batches = batches;
+            statistics.samples = samples;
+            statistics.elapsed = std::chrono::steady_clock::now() - start;
+            auto stage = [&busy](std::size_t index, unsigned int threadCount) { return PipelineStageStatistics{threadCount, std::chrono::nanoseconds(busy[index].load())}; };
+            statistics.source = stage(0, 1);
+            statistics.pack = stage(1, options.packers);
+            statistics.device = stage(2, options.deviceWorkers);
+            statistics.unpack = stage(3, options.unpackers);
+            statistics.sink = stage(4, 1);
+            FINN_LOG(Logger::getLogger(), loglevel::info) << loggerPrefix() << "Streamed " << samples << " samples in " << batches << " batches at " << statistics.samplesPerSecond() << " samples/s";
+            return statistics;
+        }
+    };
+}  // namespace Finn
+
+#endif  // INFERENCEPIPELINE
@@ -0,0 +1,501 @@
+/**
+ * @file ModelHost.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Hosts several models on the same cards: keeps their configs and settings, loads their xclbins on demand and groups requests by model to switch rarely
+ * @version 0.1
+ * @date 2024-03-16
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef MODELHOST
+#define MODELHOST
+
+#include <FINNCppDriver/utils/ConfigurationStructs.h>
+#include <FINNCppDriver/utils/FinnUtils.h>
+#include <FINNCppDriver/utils/Logger.h>
+#include <FINNCppDriver/utils/Types.h>
+
+#include <FINNCppDriver/core/Dispatcher.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <future>
+#include <map>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "xrt/xrt_device.h"
+#include "xrt/xrt_uuid.h"
+
+namespace Finn {
+    /**
+     * @brief Switch statistics of a ModelHost
+     *
+     */
+    struct ModelSwitchStatistics {
+        /**
+         * @brief Number of times a model was made resident, including the first time
+         *
+         */
+        std::size_t switches = 0;
+        /**
+         * @brief Number of models whose driver was destroyed to make room for another model
+         *
+         */
+        std::size_t evictions = 0;
+        /**
+         * @brief Time spent creating drivers, summed over all switches
+         *
+         */
+        std::chrono::nanoseconds switchTime{0};
+        /**
+         * @brief Time the last switch took
+         *
+         */
+        std::chrono::nanoseconds lastSwitchTime{0};
+    };
+
+    /**
+     * @brief Several models on the same cards. Every model is a config whose driver only exists while the model is resident. Models are co-hosted, i.e. resident at
+     * the same time, if they use the same xclbin on every card they share and no compute unit twice. A model whose xclbin differs from the one a card currently runs
+     * is switched in by destroying the drivers of the models it conflicts with and creating its own, which programs the card. Models that keep running are not
+     * touched, so their buffers stay allocated.
+     *
+     * The config, the xclbin uuids and the batch size, maximum batch size and buffer slots of every model are kept while it is evicted and applied again when it is
+     * switched back in. Device memory cannot be kept across xclbins, as XRT releases it when another xclbin is loaded.
+     *
+     * @attention Not thread safe. @see ModelScheduler for serving requests of multiple threads.
+     *
+     * @tparam DriverType Synchronous Finn::BaseDriver. All models share its datatypes.
+     */
+    template<typename DriverType>
+    class ModelHost {
+         public:
+        /**
+         * @brief Output datatype of the models
+         *
+         */
+        using V = typename DriverType::AutoDeducedRetType;
+
+         private:
+        /**
+         * @brief One registered model
+         *
+         */
+        struct Model {
+            Config config;
+            /**
+             * @brief Uuid of the xclbin of every xrt device index the model uses
+             *
+             */
+            std::map<unsigned int, xrt::uuid> bitstreams;
+            /**
+             * @brief Settings restored when the model is switched in
+             *
+             */
+            unsigned int batchSize = 1;
+            unsigned int maxBatchSize = 1;
+            unsigned int bufferSlots = 1;
+            std::optional<DriverType> driver;
+        };
+
+        std::map<std::string, Model> models;
+        ModelSwitchStatistics stats;
+        logger_type& logger;
+
+        /**
+         * @brief A logger prefix to determine the source of a log write
+         *
+         * @return std::string
+         */
+        static std::string loggerPrefix() { return "[ModelHost] "; }
+
+        Model& find(const std::string& name) {
+            auto model = models.find(name);
+            if (model == models.end()) {
+                FinnUtils::logAndError<std::invalid_argument>(loggerPrefix() + "Unknown model " + name);
+            }
+            return model->second;
+        }
+
+        const Model& find(const std::string& name) const { return const_cast<ModelHost*>(this)->find(name); }
+
+        /**
+         * @brief Check if two models can be resident at the same time
+         *
+         * @param first
+         * @param second
+         * @return true Both use the same xclbin on every card they share, and no compute unit twice
+         * @return false
+         */
+        static bool compatible(const Model& first, const Model& second) {
+            for (auto&& [deviceIndex, uuid] : first.bitstreams) {
+                auto other = second.bitstreams.find(deviceIndex);
+                if (other != second.bitstreams.end() && !(other->second == uuid)) {
+                    return false;
+                }
+            }
+            for (auto&& devWrap : first.config.deviceWrappers) {
+                for (auto&& otherWrap : second.config.deviceWrappers) {
+                    if (devWrap.xrtDeviceIndex != otherWrap.xrtDeviceIndex) {
+                        continue;
+                    }
+                    for (auto&& descriptors : {&devWrap.idmas, &devWrap.odmas}) {
+                        for (auto&& descriptor : *descriptors) {
+                            auto usedBy = [&descriptor](const std::vector<std::shared_ptr<BufferDescriptor>>& others) {
+                                return std::any_of(others.begin(), others.end(), [&descriptor](const auto& other) { return other->kernelName == descriptor->kernelName; });
+                            };
+                            if (usedBy(otherWrap.idmas) || usedBy(otherWrap.odmas)) {
+                                return false;
+                            }
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief Keep the settings of a resident model and destroy its driver
+         *
+         * @param name
+         * @param model
+         */
+        void evict(const std::string& name, Model& model) {
+            model.batchSize = model.driver->getBatchSize();
+            model.maxBatchSize = model.driver->getMaxBatchSize();
+            model.bufferSlots = model.driver->getBufferSlots();
+            model.driver.reset();
+            ++stats.evictions;
+            FINN_LOG(logger, loglevel::info) << loggerPrefix() << "Evicted model " << name;
+        }
+
+         public:
+        /**
+         * @brief Construct an empty host
+         *
+         */
+        ModelHost() : logger(Logger::getLogger()) {}
+
+        ModelHost(ModelHost&&) = delete;
+        ModelHost(const ModelHost&) = delete;
+        ModelHost& operator=(ModelHost&&) = delete;
+        ModelHost& operator=(const ModelHost&) = delete;
+        ~ModelHost() = default;
+
+        /**
+         * @brief Register a model. Its xclbins are read to know which models can be co-hosted, but nothing is loaded onto the cards yet.
+         *
+         * @param name Name requests refer to the model by
+         * @param config
+         * @param batchSize Batch size the buffers of the model are allocated for when it is first switched in
+         */
+        void addModel(const std::string& name, const Config& config, unsigned int batchSize = 1) {
+            if (models.contains(name)) {
+                FinnUtils::logAndError<std::invalid_argument>(loggerPrefix() + "Model " + name + " is already registered");
+            }
+            if (config.deviceWrappers.empty() || batchSize == 0) {
+                FinnUtils::logAndError<std::invalid_argument>(loggerPrefix() + "Model " + name + " needs at least one device and a batch size of at least 1");
+            }
+            Model model;
+            model.config = config;
+            model.batchSize = batchSize;
+            model.maxBatchSize = batchSize;
+            for (auto&& devWrap : config.deviceWrappers) {
+                model.bitstreams.emplace(devWrap.xrtDeviceIndex, xrt::xclbin(devWrap.xclbin.string()).get_uuid());
+            }
+            models.emplace(name, std::move(model));
+        }
+
+        /**
+         * @brief Register a model from its config file. @see addModel(const std::string&, const Config&, unsigned int)
+         *
+         * @param name
+         * @param configPath
+         * @param batchSize
+         */
+        void addModel(const std::string& name, const std::filesystem::path& configPath, unsigned int batchSize = 1) { addModel(name, createConfigFromPath(configPath), batchSize); }
+
+        /**
+         * @brief Unregister a model, destroying its driver if it is resident
+         *
+         * @param name
+         */
+        void removeModel(const std::string& name) {
+            if (models.erase(name) == 0) {
+                FinnUtils::logAndError<std::invalid_argument>(loggerPrefix() + "Unknown model " + name);
+            }
+        }
+
+        /**
+         * @brief Make a model resident. Resident models it conflicts with are evicted first, co-hosted models stay as they are.
+         *
+         * @param name
+         * @return DriverType& Driver of the model, valid until the model is evicted
+         */
+        DriverType& activate(const std::string& name) {
+            Model& model = find(name);
+            if (model.driver) {
+                return *model.driver;
+            }
+            const auto start = std::chrono::steady_clock::now();
+            // Drivers that hold compute units or another xclbin of the cards of this model have to release them before the cards can be programmed
+            for (auto&& [otherName, other] : models) {
+                if (other.driver && !compatible(model, other)) {
+                    evict(otherName, other);
+                }
+            }
+            model.driver.emplace(model.config, model.maxBatchSize);
+            model.driver->setForceAchieval(true);
+            if (model.bufferSlots != model.driver->getBufferSlots()) {
+                model.driver->setBufferSlots(model.bufferSlots);
+            }
+            model.driver->setBatchSize(model.batchSize);
+            const auto duration = std::chrono::steady_clock::now() - start;
+            ++stats.switches;
+            stats.switchTime += duration;
+            stats.lastSwitchTime = duration;
+            FINN_LOG(logger, loglevel::info) << loggerPrefix() << "Switched in model " << name << " in " << std::chrono::duration<double, std::milli>(duration).count() << "ms";
+            return *model.driver;
+        }
+
+        /**
+         * @brief Run a synchronous inference of whole samples on the default input and output of a model, switching it in if needed
+         *
+         * @tparam U Input datatype
+         * @param name
+         * @param input Folded input of one or more samples
+         * @return Finn::vector<V> Results of all samples
+         */
+        template<typename U>
+        Finn::vector<V> infer(const std::string& name, std::span<const U> input) {
+            auto& driver = activate(name);
+            const std::size_t elementsPerSample = driver.getInputElementsPerSample();
+            if (input.empty() || input.size() % elementsPerSample != 0) {
+                FinnUtils::logAndError<std::invalid_argument>(loggerPrefix() + "Model " + name + " needs whole input samples of " + std::to_string(elementsPerSample) + " elements");
+            }
+            const auto samples = static_cast<unsigned int>(input.size() / elementsPerSample);
+            if (samples > driver.getMaxBatchSize()) {
+                driver.setMaxBatchSize(samples);
+            }
+            driver.setBatchSize(samples);
+            Finn::vector<V> output(samples * driver.getOutputElementsPerSample());
+            driver.inferSynchronous(input.begin(), input.end(), std::span<V>(output), driver.getDefaultInputDeviceIndex(), driver.getDefaultInputKernelName(), driver.getDefaultOutputDeviceIndex(),
+                                    driver.getDefaultOutputKernelName());
+            return output;
+        }
+
+        /**
+         * @brief Check if a model is resident
+         *
+         * @param name
+         * @return true
+         * @return false
+         */
+        bool isResident(const std::string& name) const { return find(name).driver.has_value(); }
+
+        /**
+         * @brief Check if two registered models can be resident at the same time
+         *
+         * @param first
+         * @param second
+         * @return true
+         * @return false
+         */
+        bool canCoHost(const std::string& first, const std::string& second) const { return compatible(find(first), find(second)); }
+
+        /**
+         * @brief Get the names of all registered models
+         *
+         * @return std::vector<std::string>
+         */
+        std::vector<std::string> getModels() const {
+            std::vector<std::string> names;
+            for (auto&& entry : models) {
+                names.push_back(entry.first);
+            }
+            return names;
+        }
+
+        /**
+         * @brief Get the names of the resident models
+         *
+         * @return std::vector<std::string>
+         */
+        std::vector<std::string> getResidentModels() const {
+            std::vector<std::string> names;
+            for (auto&& [name, model] : models) {
+                if (model.driver) {
+                    names.push_back(name);
+                }
+            }
+            return names;
+        }
+
+        /**
+         * @brief Get the switch statistics
+         *
+         * @return const ModelSwitchStatistics&
+         */
+        const ModelSwitchStatistics& getStatistics() const { return stats; }
+    };
+
+    /**
+     * @brief Serves requests for the models of a ModelHost from many threads. A dispatcher thread keeps one queue per model and serves the requests of resident
+     * models first, so the cards are only switched once no resident model has work left. A request of another model that has waited longer than maxWait forces a
+     * switch anyway, which bounds how long a busy model can starve the others. Among the models waiting for a switch, the one with the oldest request goes first.
+     * Requests of one model are served in submission order.
+     *
+     * @attention The scheduler is the only user of the host while it exists.
+     *
+     * @tparam DriverType Synchronous Finn::BaseDriver
+     * @tparam U Input datatype
+     */
+    template<typename DriverType, typename U>
+    class ModelScheduler {
+         public:
+        /**
+         * @brief Output datatype of the models
+         *
+         */
+        using V = typename ModelHost<DriverType>::V;
+
+         private:
+        /**
+         * @brief One submitted request
+         *
+         */
+        struct Request {
+            Finn::vector<U> input;
+            std::promise<Finn::vector<V>> result;
+            std::chrono::steady_clock::time_point arrival;
+        };
+
+        ModelHost<DriverType>& host;
+        std::chrono::microseconds maxWait;
+
+        // Guarded by the lock of the dispatcher
+        std::map<std::string, std::deque<Request>> queues;
+        std::size_t pendingRequests = 0;
+
+        Dispatcher dispatcher{loggerPrefix()};
+
+        static std::string loggerPrefix() { return "[ModelScheduler] "; }
+
+        /**
+         * @brief Choose the model to serve next. Called with the queue lock held and at least one request pending.
+         *
+         * @return std::string
+         */
+        std::string nextModel() {
+            const auto now = std::chrono::steady_clock::now();
+            std::optional<std::string> resident;
+            std::optional<std::string> oldest;
+            std::chrono::steady_clock::time_point oldestArrival = std::chrono::steady_clock::time_point::max();
+            for (auto&& [name, queue] : queues) {
+                if (queue.empty()) {
+                    continue;
+                }
+                if (host.isResident(name)) {
+                    // Among resident models the one with the oldest request, so co-hosted models take turns
+                    if (!resident || queue.front().arrival < queues.at(*resident).front().arrival) {
+                        resident = name;
+                    }
+                } else if (queue.front().arrival < oldestArrival) {
+                    oldest = name;
+                    oldestArrival = queue.front().arrival;
+                }
+            }
+            if (oldest && (!resident || now - oldestArrival > maxWait)) {
+                return *oldest;
+            }
+            return *resident;
+        }
+
+        /**
+         * @brief Step of the dispatcher thread. Pending requests are served before it terminates.
+         *
+         * @return true
+         * @return false Stopped and all pending requests are served
+         */
+        bool serveNext() {
+            Request request;
+            std::string model;
+            {
+                auto lock = dispatcher.lock();
+                if (!dispatcher.wait(lock, [this]() { return pendingRequests > 0; })) {
+                    return false;
+                }
+                model = nextModel();
+                auto& queue = queues.at(model);
+                request = std::move(queue.front());
+                queue.pop_front();
+                --pendingRequests;
+            }
+            try {
+                request.result.set_value(host.template infer<U>(model, std::span<const U>(request.input)));
+            } catch (...) {
+                request.result.set_exception(std::current_exception());
+            }
+            return true;
+        }
+
+         public:
+        /**
+         * @brief Construct a new Model Scheduler and start its dispatcher thread
+         *
+         * @param pHost Host with all models requests may refer to
+         * @param pMaxWait Longest time a request of a model that is not resident waits while resident models have work, before the cards are switched to it
+         */
+        ModelScheduler(ModelHost<DriverType>& pHost, std::chrono::microseconds pMaxWait) : host(pHost), maxWait(pMaxWait) {
+            for (auto&& name : host.getModels()) {
+                queues[name];
+            }
+            dispatcher.start([this](const std::stop_token&) { return serveNext(); });
+        }
+
+        /**
+         * @brief Destroy the Model Scheduler object. Requests that are still pending are served before the dispatcher terminates.
+         *
+         */
+        ~ModelScheduler() { dispatcher.stop(); }
+
+        ModelScheduler(ModelScheduler&&) = delete;
+        ModelScheduler(const ModelScheduler&) = delete;
+        ModelScheduler& operator=(ModelScheduler&&) = delete;
+        ModelScheduler& operator=(const ModelScheduler&) = delete;
+
+        /**
+         * @brief Submit a request for a model. Thread safe.
+         *
+         * @param model Name of a model of the host
+         * @param input Folded input of one or more samples
+         * @return std::future<Finn::vector<V>> Results of all samples
+         */
+        [[nodiscard]] std::future<Finn::vector<V>> submit(const std::string& model, std::span<const U> input) {
+            Request request{Finn::vector<U>(input.begin(), input.end()), {}, std::chrono::steady_clock::now()};
+            auto future = request.result.get_future();
+            dispatcher.submit([&]() {
+                auto queue = queues.find(model);
+                if (queue == queues.end()) {
+                    FinnUtils::logAndError<std::invalid_argument>(loggerPrefix() + "Unknown model " + model);
+                }
+                queue->second.emplace_back(std::move(request));
+                ++pendingRequests;
+                return true;
+            });
+            return future;
+        }
+    };
+}  // namespace Finn
+
+#endif  // MODELHOST
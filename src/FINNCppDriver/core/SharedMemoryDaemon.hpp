@@ -0,0 +1,275 @@
+/**
+ * @file SharedMemoryDaemon.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Serves packed requests of other local processes from a shared memory ring with one synchronous driver
+ * @version 0.1
+ * @date 2024-03-09
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef SHAREDMEMORYDAEMON
+#define SHAREDMEMORYDAEMON
+
+#include <FINNCppDriver/utils/FinnUtils.h>
+#include <FINNCppDriver/utils/Logger.h>
+#include <FINNCppDriver/utils/Types.h>
+
+#include <FINNCppDriver/core/DeviceBuffer/DeviceBuffer.hpp>
+#include <FINNCppDriver/core/Dispatcher.hpp>
+#include <FINNCppDriver/utils/SharedMemoryRing.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+namespace Finn {
+    /**
+     * @brief Lets several processes on a host share one accelerator. The daemon owns the driver, and with it the devices, the loaded xclbins and the buffer objects,
+     * and publishes a SharedMemoryRing for its default input and output. Clients open the ring by name and write packed samples into its slots
+     * (SharedMemoryRing::acquire/submit/wait/release), so they neither program the card nor allocate device memory themselves.
+     *
+     * A dispatcher thread collects submitted slots of all clients until maxBatch samples are waiting or the oldest of them was seen maxDelay ago, like the
+     * DynamicBatcher does for threads. The samples are copied into the mapped input buffer, run as one batch and the packed results are copied back into the slots.
+     *
+     * @attention The daemon is the only user of the driver while it exists. The driver must not be used or moved by other threads during that time.
+     *
+     * @tparam DriverType Synchronous Finn::BaseDriver
+     */
+    template<typename DriverType>
+    class SharedMemoryDaemon {
+         private:
+        DriverType& driver;
+        std::chrono::microseconds maxDelay;
+        unsigned int maxBatch;
+        std::size_t inputBytes;
+        std::size_t outputBytes;
+        SharedMemoryRing ring;
+        /**
+         * @brief Next time the slots of clients that died are reclaimed, only used by the dispatcher thread
+         *
+         */
+        std::chrono::steady_clock::time_point nextReclaim;
+
+        Dispatcher dispatcher{loggerPrefix()};
+
+        static constexpr std::chrono::seconds reclaimPeriod{1};
+
+        /**
+         * @brief A logger prefix to determine the source of a log write
+         *
+         * @return std::string
+         */
+        static std::string loggerPrefix() { return "[SharedMemoryDaemon] "; }
+
+        /**
+         * @brief Packed bytes of one sample for the current configuration of the driver
+         *
+         * @param pDriver
+         * @param input
+         * @return std::size_t
+         */
+        static std::size_t bytesPerSample(DriverType& pDriver, bool input) {
+            const std::size_t batchBytes = input ? pDriver.getPackedInputBytes(pDriver.getDefaultInputDeviceIndex(), pDriver.getDefaultInputKernelName())
+                                                 : pDriver.getPackedOutputBytes(pDriver.getDefaultOutputDeviceIndex(), pDriver.getDefaultOutputKernelName());
+            return batchBytes / pDriver.getBatchSize();
+        }
+
+        /**
+         * @brief Wait for the next batch of submitted slots, ordered by submission. Once the daemon is stopped, the slots that are still submitted are taken without
+         * waiting for maxDelay, and an empty batch is returned when none are left.
+         *
+         * @param stop
+         * @return std::vector<std::size_t>
+         */
+        std::vector<std::size_t> collectBatch(const std::stop_token& stop) {
+            std::vector<std::size_t> batch;
+            std::optional<std::chrono::steady_clock::time_point> firstSeen;
+            SharedMemoryBackoff backoff;
+            while (true) {
+                const bool stopping = stop.stop_requested();
+                reclaimSlots();
+                batch.clear();
+                for (std::size_t slot = 0; slot < ring.slots(); ++slot) {
+                    if (ring.state(slot) == SLOT_STATE::SUBMITTED) {
+                        batch.push_back(slot);
+                    }
+                }
+                if (batch.empty() && stopping) {
+                    return batch;
+                }
+                if (!batch.empty()) {
+                    const auto now = std::chrono::steady_clock::now();
+                    if (!firstSeen) {
+                        firstSeen = now;
+                    }
+                    if (stopping || batch.size() >= maxBatch || now >= *firstSeen + maxDelay) {
+                        std::sort(batch.begin(), batch.end(), [this](std::size_t lhs, std::size_t rhs) { return ring.ticket(lhs) < ring.ticket(rhs); });
+                        batch.resize(std::min<std::size_t>(batch.size(), maxBatch));
+                        for (std::size_t slot : batch) {
+                            // Only the daemon takes submitted slots, so this cannot fail
+                            ring.transition(slot, SLOT_STATE::SUBMITTED, SLOT_STATE::RUNNING);
+                        }
+                        return batch;
+                    }
+                }
+                backoff.pause();
+            }
+        }
+
+        /**
+         * @brief Free the slots of clients that died without releasing them, at most once per reclaimPeriod
+         *
+         */
+        void reclaimSlots() {
+            const auto now = std::chrono::steady_clock::now();
+            if (now < nextReclaim) {
+                return;
+            }
+            nextReclaim = now + reclaimPeriod;
+            if (const std::size_t reclaimed = ring.reclaimAbandoned(); reclaimed > 0) {
+                FINN_LOG(Logger::getLogger(), loglevel::warning) << loggerPrefix() << "Reclaimed " << reclaimed << " slots of clients that are gone";
+            }
+        }
+
+        /**
+         * @brief Run one batch of slots and hand the results back to the clients
+         *
+         * @param batch
+         */
+        void runBatch(const std::vector<std::size_t>& batch) {
+            dispatcher.countBatch(batch.size());
+            try {
+                driver.setBatchSize(static_cast<unsigned int>(batch.size()));
+                auto inputMap = driver.getPackedInputMap(driver.getDefaultInputDeviceIndex(), driver.getDefaultInputKernelName());
+                for (std::size_t i = 0; i < batch.size(); ++i) {
+                    auto sample = ring.input(batch[i]);
+                    std::copy(sample.begin(), sample.end(), inputMap.begin() + static_cast<std::ptrdiff_t>(i * inputBytes));
+                }
+                driver.recordRequest(batch.size(), inputMap);
+                auto results = driver.runPrepacked(driver.getDefaultOutputDeviceIndex(), driver.getDefaultOutputKernelName());
+                for (std::size_t i = 0; i < batch.size(); ++i) {
+                    auto result = results.subspan(i * outputBytes, outputBytes);
+                    std::copy(result.begin(), result.end(), ring.output(batch[i]).begin());
+                    ring.publish(batch[i], SLOT_STATE::DONE);
+                }
+            } catch (const KernelTimeoutError& e) {
+                FINN_LOG(Logger::getLogger(), loglevel::error) << loggerPrefix() << "Batch of " << batch.size() << " requests failed: " << e.what();
+                failBatch(batch);
+                // The daemon is the only user of the driver, so the stuck device can be reprogrammed right away
+                try {
+                    driver.recoverStuckDevices();
+                } catch (const std::exception& recoveryError) {
+                    FINN_LOG(Logger::getLogger(), loglevel::error) << loggerPrefix() << "Recovery failed: " << recoveryError.what();
+                }
+            } catch (const std::exception& e) {
+                FINN_LOG(Logger::getLogger(), loglevel::error) << loggerPrefix() << "Batch of " << batch.size() << " requests failed: " << e.what();
+                failBatch(batch);
+            }
+        }
+
+        /**
+         * @brief Hand back the slots of a failed batch that did not get their result yet
+         *
+         * @param batch
+         */
+        void failBatch(const std::vector<std::size_t>& batch) {
+            for (std::size_t slot : batch) {
+                if (ring.state(slot) == SLOT_STATE::RUNNING) {
+                    ring.publish(slot, SLOT_STATE::FAILED);
+                }
+            }
+        }
+
+        /**
+         * @brief Step of the dispatcher thread
+         *
+         * @param stop
+         * @return true
+         * @return false The daemon is stopped and all submitted requests are served
+         */
+        bool serveNext(const std::stop_token& stop) {
+            auto batch = collectBatch(stop);
+            if (batch.empty()) {
+                return false;
+            }
+            runBatch(batch);
+            return true;
+        }
+
+         public:
+        /**
+         * @brief Create the ring and start serving it
+         *
+         * @param pDriver Synchronous driver. If pMaxBatch exceeds its maximum batch size, the device buffers are reallocated once for pMaxBatch.
+         * @param ringName Name of the shared memory object clients open, starting with "/"
+         * @param slots Number of requests all clients together can have in flight
+         * @param pMaxDelay Longest time a request waits for requests of other clients before its batch is run
+         * @param pMaxBatch Largest number of samples per batch. 0 uses the maximum batch size of the driver.
+         */
+        SharedMemoryDaemon(DriverType& pDriver, const std::string& ringName, std::size_t slots, std::chrono::microseconds pMaxDelay, unsigned int pMaxBatch = 0)
+            : driver(pDriver),
+              maxDelay(pMaxDelay),
+              maxBatch((pMaxBatch == 0) ? pDriver.getMaxBatchSize() : pMaxBatch),
+              inputBytes(bytesPerSample(pDriver, true)),
+              outputBytes(bytesPerSample(pDriver, false)),
+              ring(SharedMemoryRing::create(ringName, slots, inputBytes, outputBytes)) {
+            // More samples than slots can never be waiting at once
+            maxBatch = static_cast<unsigned int>(std::min<std::size_t>(maxBatch, slots));
+            if (maxBatch > driver.getMaxBatchSize()) {
+                driver.setMaxBatchSize(maxBatch);
+            }
+            FINN_LOG(Logger::getLogger(), loglevel::info) << loggerPrefix() << "Serving " << ringName << " with " << slots << " slots of " << inputBytes << " input and " << outputBytes << " output bytes, batches of up to "
+                                                          << maxBatch << " samples";
+            dispatcher.start([this](const std::stop_token& stop) { return serveNext(stop); });
+        }
+
+        /**
+         * @brief Serve the requests that are already submitted, then stop serving and remove the ring. Clients that submit later get an error while waiting for their result.
+         *
+         */
+        ~SharedMemoryDaemon() { dispatcher.stop(); }
+
+        SharedMemoryDaemon(SharedMemoryDaemon&&) = delete;
+        SharedMemoryDaemon(const SharedMemoryDaemon&) = delete;
+        SharedMemoryDaemon& operator=(SharedMemoryDaemon&&) = delete;
+        SharedMemoryDaemon& operator=(const SharedMemoryDaemon&) = delete;
+
+        /**
+         * @brief Get the ring served by the daemon
+         *
+         * @return const SharedMemoryRing&
+         */
+        const SharedMemoryRing& getRing() const { return ring; }
+
+        /**
+         * @brief Largest number of samples per batch
+         *
+         * @return unsigned int
+         */
+        unsigned int getMaxBatch() const { return maxBatch; }
+
+        /**
+         * @brief Number of batches run so far
+         *
+         * @return std::size_t
+         */
+        std::size_t getBatchCount() const { return dispatcher.getBatchCount(); }
+
+        /**
+         * @brief Number of requests served so far
+         *
+         * @return std::size_t
+         */
+        std::size_t getRequestCount() const { return dispatcher.getRequestCount(); }
+    };
+}  // namespace Finn
+
+#endif  // SHAREDMEMORYDAEMON
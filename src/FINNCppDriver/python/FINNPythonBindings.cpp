@@ -0,0 +1,343 @@
+/**
+ * @file FINNPythonBindings.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Python module "finn_driver" exposing the synchronous C++ driver to NumPy users without copying inputs or outputs
+ * @version 0.1
+ * @date 2024-03-08
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/ConfigurationStructs.h>
+#include <FINNCppDriver/utils/FinnUtils.h>
+#include <FINNCppDriver/utils/Types.h>
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <FINNCppDriver/core/BaseDriver.hpp>
+#include <FINNCppDriver/utils/Postprocessing.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// NOLINTBEGIN
+#define MSTR(x) #x
+#define STRNGFY(x) MSTR(x)
+// NOLINTEND
+
+#ifndef FINN_HEADER_LOCATION
+    #include <FINNCppDriver/config/FinnDriverUsedDatatypes.h>  // IWYU pragma: keep
+#else
+    #include STRNGFY(FINN_HEADER_LOCATION)  // IWYU pragma: keep
+#endif
+
+namespace py = pybind11;
+
+namespace {
+    using Driver = Finn::Driver<true>;
+    using OutputType = Driver::AutoDeducedRetType;
+
+    /**
+     * @brief Host memory that outlives the driver call that filled it. NumPy arrays returned to Python keep a reference, so a result stays valid after the next
+     * inference or a change of the batch size. The buffer is reused while no array refers to it anymore.
+     *
+     * @tparam T
+     */
+    template<typename T>
+    using SharedStorage = std::shared_ptr<Finn::vector<T>>;
+
+    /**
+     * @brief Wrap shared host memory into a NumPy array without copying
+     *
+     * @tparam T
+     * @param storage
+     * @param shape
+     * @return py::array_t<T>
+     */
+    template<typename T>
+    py::array_t<T> toArray(const SharedStorage<T>& storage, const std::vector<py::ssize_t>& shape) {
+        auto* owner = new SharedStorage<T>(storage);
+        py::capsule base(owner, [](void* ptr) { delete static_cast<SharedStorage<T>*>(ptr); });
+        return py::array_t<T>(shape, storage->data(), base);
+    }
+
+    /**
+     * @brief Get a buffer for elements values that no NumPy array refers to. The previous buffer is reused if possible.
+     *
+     * @tparam T
+     * @param storage
+     * @param elements
+     * @return Finn::vector<T>&
+     */
+    template<typename T>
+    Finn::vector<T>& reuseOrAllocate(SharedStorage<T>& storage, std::size_t elements) {
+        if (!storage || storage.use_count() > 1) {
+            storage = std::make_shared<Finn::vector<T>>(elements);
+        } else if (storage->size() != elements) {
+            storage->resize(elements);
+        }
+        return *storage;
+    }
+
+    /**
+     * @brief Check that an array can be read or written in place
+     *
+     * @param array
+     * @param name
+     */
+    void checkContiguous(const py::array& array, const std::string& name) {
+        if ((array.flags() & py::array::c_style) == 0) {
+            throw py::value_error(name + " has to be C contiguous to be used without copying, e.g. pass numpy.ascontiguousarray(" + name + ")");
+        }
+    }
+
+    /**
+     * @brief Call func with a typed pointer to the elements of a NumPy array. Supports the integer, boolean and floating point dtypes. Has to be called with the GIL held.
+     *
+     * @tparam Func
+     * @param array
+     * @param func
+     * @return decltype(auto)
+     */
+    template<typename Func>
+    decltype(auto) dispatchInput(const py::array& array, Func&& func) {
+        const auto dtype = array.dtype();
+        const char kind = dtype.kind();
+        const auto itemsize = dtype.itemsize();
+        const void* data = array.data();
+        if (kind == 'b') {
+            // NumPy stores booleans as bytes holding 0 or 1
+            return func(static_cast<const uint8_t*>(data));
+        }
+        if (kind == 'i') {
+            switch (itemsize) {
+                case 1:
+                    return func(static_cast<const int8_t*>(data));
+                case 2:
+                    return func(static_cast<const int16_t*>(data));
+                case 4:
+                    return func(static_cast<const int32_t*>(data));
+                case 8:
+                    return func(static_cast<const int64_t*>(data));
+                default:
+                    break;
+            }
+        }
+        if (kind == 'u') {
+            switch (itemsize) {
+                case 1:
+                    return func(static_cast<const uint8_t*>(data));
+                case 2:
+                    return func(static_cast<const uint16_t*>(data));
+                case 4:
+                    return func(static_cast<const uint32_t*>(data));
+                case 8:
+                    return func(static_cast<const uint64_t*>(data));
+                default:
+                    break;
+            }
+        }
+        if (kind == 'f' && itemsize == 4) {
+            return func(static_cast<const float*>(data));
+        }
+        if (kind == 'f' && itemsize == 8) {
+            return func(static_cast<const double*>(data));
+        }
+        throw py::type_error("Unsupported input dtype " + py::str(dtype).cast<std::string>() + ", use an integer, boolean or floating point array");
+    }
+
+    /**
+     * @brief Synchronous driver for the default input and output of an accelerator. Inputs are packed straight from the memory of the given array, the GIL is
+     * released while packing, running the accelerator, waiting for it and unpacking. The number of samples of a call sets the batch size of the driver.
+     *
+     */
+    class PyDriver {
+         private:
+        std::unique_ptr<Driver> driver;
+        Driver::InferenceSession session;
+        std::size_t inputElementsPerSample = 0;
+        std::size_t outputElementsPerSample = 0;
+        shape_t outputShape;
+        SharedStorage<OutputType> outputs;
+        SharedStorage<std::size_t> indices;
+        /**
+         * @brief Serialises inferences of several Python threads, they only run in parallel to the rest of the interpreter
+         *
+         */
+        std::mutex inferLock;
+
+        /**
+         * @brief Number of samples in an input array. Has to be called with the GIL held.
+         *
+         * @param input
+         * @return std::size_t
+         */
+        std::size_t samplesOf(const py::array& input) const {
+            checkContiguous(input, "input");
+            const auto elements = static_cast<std::size_t>(input.size());
+            if (elements == 0 || elements % inputElementsPerSample != 0) {
+                throw py::value_error("Input holds " + std::to_string(elements) + " values, which is not a multiple of the " + std::to_string(inputElementsPerSample) + " values of a sample");
+            }
+            return elements / inputElementsPerSample;
+        }
+
+        /**
+         * @brief Resize the batch of the driver and prepare the session again if necessary. Has to be called with inferLock held.
+         *
+         * @param samples
+         */
+        void prepareFor(std::size_t samples) {
+            if (samples != driver->getBatchSize()) {
+                driver->setBatchSize(static_cast<uint>(samples));
+            }
+            if (!session.valid()) {
+                session = driver->prepare();
+            }
+        }
+
+        /**
+         * @brief Shape of the unpacked output of a batch
+         *
+         * @param samples
+         * @return std::vector<py::ssize_t>
+         */
+        std::vector<py::ssize_t> outputShapeFor(std::size_t samples) const {
+            std::vector<py::ssize_t> shape(outputShape.begin(), outputShape.end());
+            shape.front() = static_cast<py::ssize_t>(samples);
+            return shape;
+        }
+
+         public:
+        /**
+         * @brief Create a driver from a runtime config, @see Finn::BaseDriver
+         *
+         * @param configPath
+         * @param batchSize
+         */
+        PyDriver(const std::string& configPath, uint batchSize) : driver(std::make_unique<Driver>(configPath, batchSize)) {
+            inputElementsPerSample = driver->getInputElementsPerSample();
+            outputElementsPerSample = driver->getOutputElementsPerSample();
+            const auto config = driver->getConfig();
+            outputShape = std::dynamic_pointer_cast<Finn::ExtendedBufferDescriptor>(config.deviceWrappers.at(0).odmas.at(0))->normalShape;
+            if (outputShape.empty()) {
+                outputShape = {1, outputElementsPerSample};
+            }
+            session = driver->prepare();
+        }
+
+        PyDriver(PyDriver&&) = delete;
+        PyDriver(const PyDriver&) = delete;
+        PyDriver& operator=(PyDriver&&) = delete;
+        PyDriver& operator=(const PyDriver&) = delete;
+        ~PyDriver() = default;
+
+        /**
+         * @brief Run a batch and unpack the results into out or into driver owned memory
+         *
+         * @param input Any C contiguous array, its size determines the number of samples
+         * @param out Optional C contiguous, writeable array of the output dtype that receives the results
+         * @return py::array A view on the results, out if it was given
+         */
+        py::array infer(const py::array& input, std::optional<py::array> out) {
+            const std::size_t samples = samplesOf(input);
+            const std::size_t outputElements = samples * outputElementsPerSample;
+            OutputType* target = nullptr;
+            if (out) {
+                checkContiguous(*out, "out");
+                const auto expected = py::dtype::of<OutputType>();
+                if (out->dtype().kind() != expected.kind() || out->dtype().itemsize() != expected.itemsize() || !out->writeable()) {
+                    throw py::type_error("out has to be a writeable array of dtype " + py::str(expected).cast<std::string>());
+                }
+                if (static_cast<std::size_t>(out->size()) < outputElements) {
+                    throw py::value_error("out is too small for " + std::to_string(outputElements) + " output values");
+                }
+                target = static_cast<OutputType*>(out->mutable_data());
+            }
+            SharedStorage<OutputType> storage;
+            dispatchInput(input, [&](const auto* data) {
+                py::gil_scoped_release release;
+                std::lock_guard guard(inferLock);
+                prepareFor(samples);
+                if (target == nullptr) {
+                    target = reuseOrAllocate(outputs, outputElements).data();
+                    storage = outputs;
+                }
+                session.infer(data, data + samples * inputElementsPerSample, std::span<OutputType>(target, outputElements));
+            });
+            return out ? *out : py::array(toArray(storage, outputShapeFor(samples)));
+        }
+
+        /**
+         * @brief Run a batch and reduce it to class indices without unpacking the full output, @see Finn::Postprocessing
+         *
+         * @param input
+         * @param stage
+         * @return py::array_t<std::size_t> Shape (samples, stage.resultsPerSample())
+         */
+        py::array_t<std::size_t> inferPostprocessed(const py::array& input, const Finn::Postprocessing& stage) {
+            const std::size_t samples = samplesOf(input);
+            SharedStorage<std::size_t> storage;
+            dispatchInput(input, [&](const auto* data) {
+                py::gil_scoped_release release;
+                std::lock_guard guard(inferLock);
+                prepareFor(samples);
+                auto& result = reuseOrAllocate(indices, samples * stage.resultsPerSample());
+                storage = indices;
+                session.inferPostprocessed(data, data + samples * inputElementsPerSample, stage, std::span<std::size_t>(result.data(), result.size()));
+            });
+            return toArray(storage, {static_cast<py::ssize_t>(samples), static_cast<py::ssize_t>(stage.resultsPerSample())});
+        }
+
+        uint getBatchSize() { return driver->getBatchSize(); }
+
+        void setBatchSize(uint batchSize) {
+            py::gil_scoped_release release;
+            std::lock_guard guard(inferLock);
+            driver->setBatchSize(batchSize);
+        }
+
+        std::size_t getInputElementsPerSample() const { return inputElementsPerSample; }
+
+        std::size_t getOutputElementsPerSample() const { return outputElementsPerSample; }
+
+        std::vector<py::ssize_t> getOutputShape() const { return outputShapeFor(1); }
+
+        void setHostThreads(std::size_t threads) {
+            py::gil_scoped_release release;
+            std::lock_guard guard(inferLock);
+            driver->setHostThreadPool(threads);
+        }
+    };
+}  // namespace
+
+// NOLINTNEXTLINE
+PYBIND11_MODULE(finn_driver, module) {
+    module.doc() = "Python interface of the FINN C++ driver. Inputs are read from NumPy arrays in place and outputs are returned as arrays backed by driver memory.";
+
+    py::class_<Finn::Postprocessing>(module, "Postprocessing", "Reduction of every output sample to class indices")
+        .def_static("argmax", &Finn::Postprocessing::argmax)
+        .def_static("top_k", &Finn::Postprocessing::topK, py::arg("k"))
+        .def_static("threshold", &Finn::Postprocessing::threshold, py::arg("minimum"), py::arg("k") = 1)
+        .def_property_readonly("results_per_sample", &Finn::Postprocessing::resultsPerSample);
+
+    py::class_<PyDriver>(module, "Driver", "Synchronous driver for the default input and output of an accelerator")
+        .def(py::init<const std::string&, uint>(), py::arg("config"), py::arg("batch_size") = 1, "Program the devices of a runtime config and allocate buffers for batch_size samples")
+        .def("infer", &PyDriver::infer, py::arg("input"), py::arg("out").noconvert() = std::nullopt,
+             "Run the samples in input and return the unpacked results. Without out the results are backed by driver memory that is reused once no array refers to it anymore. "
+             "The batch size follows the number of samples in input.")
+        .def("infer_postprocessed", &PyDriver::inferPostprocessed, py::arg("input"), py::arg("stage"), "Run the samples in input and return the class indices of every sample")
+        .def_property("batch_size", &PyDriver::getBatchSize, &PyDriver::setBatchSize)
+        .def_property_readonly("input_elements_per_sample", &PyDriver::getInputElementsPerSample)
+        .def_property_readonly("output_elements_per_sample", &PyDriver::getOutputElementsPerSample)
+        .def_property_readonly("output_shape", &PyDriver::getOutputShape, "Unpacked output shape of one sample, including the batch dimension")
+        .def("set_host_threads", &PyDriver::setHostThreads, py::arg("threads"), "Number of threads packing inputs and unpacking outputs, including the calling thread");
+}
@@ -0,0 +1,199 @@
+/**
+ * @file Affinity.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Discovery of the NUMA node local to a PCIe device and pinning of threads to its CPUs
+ * @version 0.1
+ * @date 2024-03-08
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef AFFINITY_HPP
+#define AFFINITY_HPP
+
+#include <FINNCppDriver/utils/Logger.h>
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace Finn {
+    /**
+     * @brief Parse a Linux CPU list like "0-3,8,10-11" as found in sysfs. Malformed parts are skipped.
+     *
+     * @param list
+     * @return std::vector<unsigned int> Sorted CPU ids without duplicates
+     */
+    inline std::vector<unsigned int> parseCpuList(std::string_view list) {
+        std::vector<unsigned int> cpus;
+        while (!list.empty()) {
+            const std::size_t comma = list.find(',');
+            std::string_view part = list.substr(0, comma);
+            list = (comma == std::string_view::npos) ? std::string_view{} : list.substr(comma + 1);
+            while (!part.empty() && (part.back() == '\n' || part.back() == ' ')) {
+                part.remove_suffix(1);
+            }
+            unsigned int first = 0;
+            auto [end, error] = std::from_chars(part.data(), part.data() + part.size(), first);
+            if (error != std::errc() || end == part.data()) {
+                continue;
+            }
+            unsigned int last = first;
+            if (end != part.data() + part.size()) {
+                if (*end != '-' || std::from_chars(end + 1, part.data() + part.size(), last).ec != std::errc() || last < first) {
+                    continue;
+                }
+            }
+            for (unsigned int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        std::sort(cpus.begin(), cpus.end());
+        cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+        return cpus;
+    }
+
+    /**
+     * @brief Get the NUMA node the PCIe slot of a device is attached to
+     *
+     * @param bdf Bus:device.function of the device as reported by XRT, with or without PCI domain (e.g. "0000:3b:00.1" or "3b:00.1")
+     * @param sysfs Root of the sysfs tree
+     * @return std::optional<unsigned int> Empty if the platform does not report a node for the device (e.g. single socket systems report -1)
+     */
+    inline std::optional<unsigned int> pciNumaNode(const std::string& bdf, const std::filesystem::path& sysfs = "/sys") {
+        const std::string address = (std::count(bdf.begin(), bdf.end(), ':') < 2) ? "0000:" + bdf : bdf;
+        std::ifstream file(sysfs / "bus" / "pci" / "devices" / address / "numa_node");
+        int node = -1;
+        if (!(file >> node) || node < 0) {
+            return std::nullopt;
+        }
+        return static_cast<unsigned int>(node);
+    }
+
+    /**
+     * @brief Get the CPUs of a NUMA node
+     *
+     * @param node
+     * @param sysfs Root of the sysfs tree
+     * @return std::vector<unsigned int> Empty if the node does not exist
+     */
+    inline std::vector<unsigned int> numaNodeCpus(unsigned int node, const std::filesystem::path& sysfs = "/sys") {
+        std::ifstream file(sysfs / "devices" / "system" / "node" / ("node" + std::to_string(node)) / "cpulist");
+        std::string list;
+        std::getline(file, list);
+        return parseCpuList(list);
+    }
+
+    /**
+     * @brief Get the CPUs local to the PCIe slot of a device, @see pciNumaNode
+     *
+     * @param bdf
+     * @param sysfs Root of the sysfs tree
+     * @return std::vector<unsigned int> Empty if the locality of the device is unknown
+     */
+    inline std::vector<unsigned int> pciLocalCpus(const std::string& bdf, const std::filesystem::path& sysfs = "/sys") {
+        const auto node = pciNumaNode(bdf, sysfs);
+        return node ? numaNodeCpus(*node, sysfs) : std::vector<unsigned int>{};
+    }
+
+    /**
+     * @brief Restricts the calling thread to a set of CPUs for the lifetime of the object and restores the previous affinity afterwards. Threads created in the meantime
+     * inherit the restriction, and memory first touched in the meantime is placed on the NUMA node of the CPUs by the default Linux memory policy. An empty set of CPUs
+     * leaves the thread untouched.
+     *
+     */
+    class ScopedThreadAffinity {
+#ifdef __linux__
+        cpu_set_t previous{};
+#endif
+        bool applied = false;
+
+         public:
+        /**
+         * @brief Restrict the calling thread to the given CPUs
+         *
+         * @param cpus
+         */
+        explicit ScopedThreadAffinity(const std::vector<unsigned int>& cpus) {
+            if (cpus.empty()) {
+                return;
+            }
+#ifdef __linux__
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (unsigned int cpu : cpus) {
+                if (cpu < CPU_SETSIZE) {
+                    CPU_SET(cpu, &set);
+                }
+            }
+            if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &previous) != 0 || pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) != 0) {
+                FINN_LOG(Logger::getLogger(), loglevel::warning) << "[ScopedThreadAffinity] Could not restrict the thread to the device local CPUs";
+                return;
+            }
+            applied = true;
+#else
+            FINN_LOG(Logger::getLogger(), loglevel::warning) << "[ScopedThreadAffinity] Thread affinity is not supported on this platform";
+#endif
+        }
+
+        /**
+         * @brief Restore the previous affinity of the thread
+         *
+         */
+        ~ScopedThreadAffinity() {
+#ifdef __linux__
+            if (applied) {
+                pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &previous);
+            }
+#endif
+        }
+
+        ScopedThreadAffinity(ScopedThreadAffinity&&) = delete;
+        ScopedThreadAffinity(const ScopedThreadAffinity&) = delete;
+        ScopedThreadAffinity& operator=(ScopedThreadAffinity&&) = delete;
+        ScopedThreadAffinity& operator=(const ScopedThreadAffinity&) = delete;
+
+        /**
+         * @brief Check if the thread is currently restricted by this object
+         *
+         * @return true
+         * @return false
+         */
+        bool active() const { return applied; }
+    };
+
+    /**
+     * @brief Get the CPUs the calling thread may run on
+     *
+     * @return std::vector<unsigned int> Empty if not supported
+     */
+    inline std::vector<unsigned int> currentThreadCpus() {
+        std::vector<unsigned int> cpus;
+#ifdef __linux__
+        cpu_set_t set;
+        if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0) {
+            for (unsigned int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+#endif
+        return cpus;
+    }
+}  // namespace Finn
+
+#endif  // AFFINITY_HPP
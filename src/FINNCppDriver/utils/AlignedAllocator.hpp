@@ -15,9 +15,27 @@
 #ifndef ALIGNEDALLOCATOR_HPP
 #define ALIGNEDALLOCATOR_HPP
 
+#include <atomic>
 #include <iostream>
 #include <limits>
 
+/**
+ * @brief Process wide counters of the allocations made by all AlignedAllocators (and thus all Finn::vectors). Compare two snapshots to check that a code path does not allocate.
+ *
+ */
+struct AlignedAllocationCounter {
+    /**
+     * @brief Number of calls to AlignedAllocator::allocate
+     *
+     */
+    static inline std::atomic<std::size_t> allocations = 0;
+    /**
+     * @brief Number of bytes requested from AlignedAllocator::allocate
+     *
+     */
+    static inline std::atomic<std::size_t> bytes = 0;
+};
+
 /**
  * @brief Allocator class for aligned allocs.This allocator is compatible to the
  * aligned allocators provided by libraries such as Intel MKL and OpenBLAS.
@@ -175,6 +193,8 @@ class AlignedAllocator {
         size_t allocBytes = ((bytes / TALIGN) + ((bytes % TALIGN != 0) ? 1 : 0)) * TALIGN;  // Only a multiple of TALIGN can be allocated.
 
         if ((ptr = static_cast<T*>(aligned_alloc(TALIGN, allocBytes)))) {
+            AlignedAllocationCounter::allocations.fetch_add(1, std::memory_order_relaxed);
+            AlignedAllocationCounter::bytes.fetch_add(allocBytes, std::memory_order_relaxed);
             return ptr;
         }
 
@@ -0,0 +1,116 @@
+/**
+ * @file ArrivalSchedule.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Intended send times of requests for open loop load generation
+ * @version 0.1
+ * @date 2024-02-28
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef ARRIVALSCHEDULE
+#define ARRIVALSCHEDULE
+
+#include <FINNCppDriver/utils/FinnUtils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Finn {
+    /**
+     * @brief Offsets of the intended send times of requests from the start of a run, in ascending order
+     *
+     */
+    using ArrivalSchedule = std::vector<std::chrono::nanoseconds>;
+
+    /**
+     * @brief Arrivals of a Poisson process: exponentially distributed gaps with the given mean rate
+     *
+     * @param rate Mean number of requests per second
+     * @param count Number of requests
+     * @param seed Seed of the random gaps, so runs can be repeated
+     * @return ArrivalSchedule
+     */
+    inline ArrivalSchedule poissonArrivals(double rate, std::size_t count, std::uint64_t seed) {
+        if (rate <= 0) {
+            FinnUtils::logAndError<std::invalid_argument>("The arrival rate has to be positive!");
+        }
+        std::mt19937_64 engine(seed);
+        std::exponential_distribution<double> gap(rate);
+        ArrivalSchedule schedule;
+        schedule.reserve(count);
+        double time = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            time += gap(engine);
+            schedule.emplace_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(time)));
+        }
+        return schedule;
+    }
+
+    /**
+     * @brief Arrivals with a constant gap
+     *
+     * @param rate Number of requests per second
+     * @param count Number of requests
+     * @return ArrivalSchedule
+     */
+    inline ArrivalSchedule uniformArrivals(double rate, std::size_t count) {
+        if (rate <= 0) {
+            FinnUtils::logAndError<std::invalid_argument>("The arrival rate has to be positive!");
+        }
+        ArrivalSchedule schedule;
+        schedule.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            schedule.emplace_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(static_cast<double>(i) / rate)));
+        }
+        return schedule;
+    }
+
+    /**
+     * @brief Replay recorded arrivals. The file holds one timestamp in seconds per line, e.g. taken from a production trace. Timestamps are sorted and made relative to
+     * the first one. Empty lines and lines starting with # are skipped.
+     *
+     * @param path
+     * @param speedup Factor the recorded gaps are divided by, to replay a trace at a higher or lower rate
+     * @return ArrivalSchedule
+     */
+    inline ArrivalSchedule replayArrivals(const std::filesystem::path& path, double speedup = 1.0) {
+        if (speedup <= 0) {
+            FinnUtils::logAndError<std::invalid_argument>("The replay speedup has to be positive!");
+        }
+        std::ifstream file(path);
+        if (!file) {
+            FinnUtils::logAndError<std::runtime_error>("Could not open arrival trace " + path.string() + "!");
+        }
+        std::vector<double> timestamps;
+        for (std::string line; std::getline(file, line);) {
+            if (line.empty() || line.front() == '#') {
+                continue;
+            }
+            try {
+                timestamps.push_back(std::stod(line));
+            } catch (const std::exception&) {
+                FinnUtils::logAndError<std::runtime_error>("Invalid timestamp '" + line + "' in arrival trace " + path.string() + "!");
+            }
+        }
+        std::sort(timestamps.begin(), timestamps.end());
+        ArrivalSchedule schedule;
+        schedule.reserve(timestamps.size());
+        for (double timestamp : timestamps) {
+            schedule.emplace_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>((timestamp - timestamps.front()) / speedup)));
+        }
+        return schedule;
+    }
+}  // namespace Finn
+
+#endif  // ARRIVALSCHEDULE
@@ -0,0 +1,126 @@
+/**
+ * @file BoundedQueue.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Blocking FIFO queue of limited capacity to connect the stages of a pipeline
+ * @version 0.1
+ * @date 2024-03-05
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef BOUNDEDQUEUE
+#define BOUNDEDQUEUE
+
+#include <FINNCppDriver/utils/FinnUtils.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <stop_token>
+#include <utility>
+
+namespace Finn {
+    /**
+     * @brief FIFO queue that holds at most capacity elements. Unlike the RingBuffer, the elements can have any size, e.g. whole loaded files. Any number of producers
+     * and consumers can use it concurrently. Producers block while the queue is full, which limits the memory held by a pipeline. Once all producers are done, close()
+     * lets the consumers drain the remaining elements and then stop.
+     *
+     * @tparam T
+     */
+    template<typename T>
+    class BoundedQueue {
+         private:
+        std::size_t capacity;
+        std::deque<T> elements;
+        bool closed = false;
+        std::mutex mutex;
+        std::condition_variable_any notFull;
+        std::condition_variable_any notEmpty;
+
+         public:
+        /**
+         * @brief Construct a new Bounded Queue object
+         *
+         * @param pCapacity Maximum number of queued elements, at least 1
+         */
+        explicit BoundedQueue(std::size_t pCapacity) : capacity(pCapacity) {
+            if (capacity == 0) {
+                FinnUtils::logAndError<std::invalid_argument>("A bounded queue needs a capacity of at least 1!");
+            }
+        }
+
+        /**
+         * @brief Append an element, waiting for a free place if the queue is full
+         *
+         * @param element
+         * @param stoken Cancels the wait
+         * @return true The element was queued
+         * @return false The queue was closed or the wait was cancelled, the element was dropped
+         */
+        bool push(T element, std::stop_token stoken = {}) {
+            std::unique_lock lock(mutex);
+            if (!notFull.wait(lock, stoken, [this]() { return closed || elements.size() < capacity; }) || closed) {
+                return false;
+            }
+            elements.push_back(std::move(element));
+            lock.unlock();
+            notEmpty.notify_one();
+            return true;
+        }
+
+        /**
+         * @brief Take the oldest element, waiting for one if the queue is empty
+         *
+         * @param stoken Cancels the wait
+         * @return std::optional<T> Empty once the queue is closed and drained, or if the wait was cancelled
+         */
+        std::optional<T> pop(std::stop_token stoken = {}) {
+            std::unique_lock lock(mutex);
+            if (!notEmpty.wait(lock, stoken, [this]() { return closed || !elements.empty(); }) || elements.empty()) {
+                return std::nullopt;
+            }
+            std::optional<T> element(std::move(elements.front()));
+            elements.pop_front();
+            lock.unlock();
+            notFull.notify_one();
+            return element;
+        }
+
+        /**
+         * @brief No more elements are accepted. Already queued elements can still be popped.
+         *
+         */
+        void close() {
+            {
+                std::lock_guard guard(mutex);
+                closed = true;
+            }
+            notFull.notify_all();
+            notEmpty.notify_all();
+        }
+
+        /**
+         * @brief Number of queued elements
+         *
+         * @return std::size_t
+         */
+        std::size_t size() {
+            std::lock_guard guard(mutex);
+            return elements.size();
+        }
+
+        /**
+         * @brief Get the capacity of the queue
+         *
+         * @return std::size_t
+         */
+        std::size_t getCapacity() const { return capacity; }
+    };
+}  // namespace Finn
+
+#endif  // BOUNDEDQUEUE
@@ -15,9 +15,13 @@
 
 #include <FINNCppDriver/utils/Types.h>
 
+#include <cstdint>
+#include <filesystem>
 #include <fstream>
 #include <memory>
 #include <nlohmann/json.hpp>
+#include <optional>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
@@ -69,7 +73,52 @@ namespace nlohmann {
 }  // namespace nlohmann
 
 
+/**
+ * @brief JSON <-> WAIT_POLICY. Unknown strings are mapped to WAIT_POLICY::INVALID
+ *
+ */
+// NOLINTNEXTLINE
+NLOHMANN_JSON_SERIALIZE_ENUM(WAIT_POLICY, {{WAIT_POLICY::INVALID, nullptr}, {WAIT_POLICY::SPIN, "spin"}, {WAIT_POLICY::SPIN_YIELD, "spinYield"}, {WAIT_POLICY::INTERRUPT, "interrupt"}})
+
+/**
+ * @brief JSON <-> AFFINITY_POLICY. Unknown strings are mapped to AFFINITY_POLICY::INVALID
+ *
+ */
+// NOLINTNEXTLINE
+NLOHMANN_JSON_SERIALIZE_ENUM(AFFINITY_POLICY, {{AFFINITY_POLICY::INVALID, nullptr}, {AFFINITY_POLICY::NONE, "none"}, {AFFINITY_POLICY::DEVICE_LOCAL, "deviceLocal"}})
+
+/**
+ * @brief JSON <-> PLATFORM. Unknown strings are mapped to PLATFORM::INVALID
+ *
+ */
+// NOLINTNEXTLINE
+NLOHMANN_JSON_SERIALIZE_ENUM(PLATFORM, {{PLATFORM::INVALID, nullptr}, {PLATFORM::ALVEO, "alveo"}, {PLATFORM::EMBEDDED, "embedded"}})
+
+/**
+ * @brief JSON <-> TRANSFER_MODE. Unknown strings are mapped to TRANSFER_MODE::INVALID
+ *
+ */
+// NOLINTNEXTLINE
+NLOHMANN_JSON_SERIALIZE_ENUM(TRANSFER_MODE, {{TRANSFER_MODE::INVALID, nullptr}, {TRANSFER_MODE::MEMORY_BUFFERED, "memoryBuffered"}, {TRANSFER_MODE::STREAMED, "streamed"}})
+
 namespace Finn {
+    /**
+     * @brief Reference to a buffer on a (possibly different) device
+     *
+     */
+    struct BufferLink {
+        /**
+         * @brief XRT device index of the device the buffer is on
+         *
+         */
+        unsigned int xrtDeviceIndex = 0;
+        /**
+         * @brief Kernel name of the buffer
+         *
+         */
+        std::string kernelName;
+    };
+
     /**
      * @brief A small storage struct to manage the description of Buffers
      *
@@ -93,6 +142,30 @@ namespace Finn {
          */
         unsigned int slrIndex = 0;
 
+        /**
+         * @brief Output buffer that feeds this input buffer in a model parallel pipeline over several devices ("producer" in the config). Empty if the input is supplied by the host.
+         *
+         */
+        std::optional<BufferLink> producer;
+
+        /**
+         * @brief Offset of a register of the IP core that holds the clock cycles of its last run, if the bitstream provides such a counter ("cycleCounterOffset" in the config)
+         *
+         */
+        std::optional<uint32_t> cycleCounterOffset;
+
+        /**
+         * @brief How the data of the buffer is moved to its kernel (optional, "transferMode" in the config). TRANSFER_MODE::STREAMED is only supported for idmas.
+         *
+         */
+        TRANSFER_MODE transferMode = TRANSFER_MODE::MEMORY_BUFFERED;
+
+        /**
+         * @brief Samples per chunk of a streamed buffer (optional, "streamChunkSamples" in the config), @see SyncDeviceInputBuffer::run
+         *
+         */
+        unsigned int streamChunkSamples = 1;
+
         /**
          * @brief Construct a new Buffer Descriptor object
          *
@@ -168,6 +241,44 @@ namespace Finn {
         shape_t foldedShape;
     };
 
+    /**
+     * @brief Host side settings found by the autotune mode of the driver for one card and model. They apply to the driver as a whole and are stored with the first
+     * device of a config.
+     *
+     */
+    struct DriverTuning {
+        /**
+         * @brief Batch size of every inference
+         *
+         */
+        unsigned int batchSize = 1;
+        /**
+         * @brief Number of host threads that pack and unpack, 0 keeps the default of the driver
+         *
+         */
+        unsigned int hostThreads = 0;
+        /**
+         * @brief Number of buffer slots every synchronous DeviceBuffer rotates between, i.e. the pipeline depth of inferSynchronousPipelined
+         *
+         */
+        unsigned int bufferSlots = 1;
+        /**
+         * @brief Throughput in samples per second measured with these settings (informational)
+         *
+         */
+        double throughput = 0;
+        /**
+         * @brief 99th percentile of the batch latency in microseconds measured with these settings (informational)
+         *
+         */
+        double latencyP99 = 0;
+        /**
+         * @brief Bound on the 99th percentile of the batch latency in microseconds the settings were chosen under, 0 if unbounded (informational)
+         *
+         */
+        double latencyBound = 0;
+    };
+
     /**
      * @brief Helper struct to structure input data for DeviceHandler creation
      *
@@ -193,6 +304,62 @@ namespace Finn {
          *
          */
         std::vector<std::shared_ptr<BufferDescriptor>> odmas;
+        /**
+         * @brief Strategy used to wait for kernel completion on this device (optional, "waitPolicy" in the config)
+         *
+         */
+        WAIT_POLICY waitPolicy = WAIT_POLICY::SPIN;
+        /**
+         * @brief Number of register polls before WAIT_POLICY::SPIN_YIELD yields the CPU (optional, "spinBudget" in the config)
+         *
+         */
+        unsigned int spinBudget = defaultSpinBudget;
+        /**
+         * @brief Milliseconds a synchronous kernel run may take before waiting for it fails with a KernelTimeoutError, 0 to wait forever (optional, "executeTimeoutMs" in
+         * the config)
+         *
+         */
+        unsigned int executeTimeoutMs = 0;
+        /**
+         * @brief Memory cap in bytes for the archived results of every asynchronous output buffer on this device, 0 if unbounded (optional, "archiveCapacity" in the config)
+         *
+         */
+        std::size_t archiveCapacity = defaultArchiveCapacity;
+        /**
+         * @brief Placement of the threads and host buffers of this device (optional, "affinityPolicy" in the config)
+         *
+         */
+        AFFINITY_POLICY affinityPolicy = AFFINITY_POLICY::NONE;
+        /**
+         * @brief The idmas and odmas are replicated compute units of one design: the i-th idma feeds the i-th odma, and every pair can run a batch independently of the
+         * others (optional, "replicatedComputeUnits" in the config)
+         *
+         */
+        bool replicatedComputeUnits = false;
+        /**
+         * @brief Allocate one buffer object per memory bank and carve the synchronous buffers of this device from it, sized exactly instead of to the next power of two
+         * (optional, "memoryArena" in the config)
+         *
+         */
+        bool memoryArena = false;
+        /**
+         * @brief Kind of platform the device is (optional, "platform" in the config). Buffers on PLATFORM::EMBEDDED are never synced and always carved from a memory
+         * arena, so they take one contiguous allocation per memory bank.
+         *
+         */
+        PLATFORM platform = PLATFORM::ALVEO;
+        /**
+         * @brief Allocate the buffers of a PLATFORM::EMBEDDED device cacheable, for programmable logic that reads and writes host memory through cache coherent ports
+         * (e.g. HPC ports). Packing and unpacking are much faster on cached memory. Leave it off for non coherent ports, then buffers are not cached. (optional,
+         * "coherentMemory" in the config)
+         *
+         */
+        bool coherentMemory = false;
+        /**
+         * @brief Settings found by the autotune mode (optional, "tuning" in the config, only read from the first device)
+         *
+         */
+        std::optional<DriverTuning> tuning;
 
         /**
          * @brief Construct a new Device Wrapper object
@@ -226,6 +393,27 @@ namespace Finn {
 
 
     /***** JSON CONVERSION FUNCTIONS ******/
+    /**
+     * @brief BufferLink -> JSON
+     *
+     * @param j
+     * @param link
+     */
+    // NOLINTNEXTLINE
+    void inline to_json(json& j, const BufferLink& link) { j = json{{"xrtDeviceIndex", link.xrtDeviceIndex}, {"kernelName", link.kernelName}}; }
+
+    /**
+     * @brief JSON -> BufferLink
+     *
+     * @param j
+     * @param link
+     */
+    // NOLINTNEXTLINE
+    void inline from_json(const json& j, BufferLink& link) {
+        j.at("xrtDeviceIndex").get_to(link.xrtDeviceIndex);
+        j.at("kernelName").get_to(link.kernelName);
+    }
+
     /**
      * @brief JSON -> ExtendedBufferDescriptor
      *
@@ -233,7 +421,19 @@ namespace Finn {
      * @param ebd
      */
     // NOLINTNEXTLINE
-    void inline to_json(json& j, const ExtendedBufferDescriptor& ebd) { j = json{{"kernelName", ebd.kernelName}, {"packedShape", ebd.packedShape}, {"normalShape", ebd.normalShape}, {"foldedShape", ebd.foldedShape}}; }
+    void inline to_json(json& j, const ExtendedBufferDescriptor& ebd) {
+        j = json{{"kernelName", ebd.kernelName}, {"packedShape", ebd.packedShape}, {"normalShape", ebd.normalShape}, {"foldedShape", ebd.foldedShape}};
+        if (ebd.producer) {
+            j["producer"] = *ebd.producer;
+        }
+        if (ebd.cycleCounterOffset) {
+            j["cycleCounterOffset"] = *ebd.cycleCounterOffset;
+        }
+        if (ebd.transferMode != TRANSFER_MODE::MEMORY_BUFFERED) {
+            j["transferMode"] = ebd.transferMode;
+            j["streamChunkSamples"] = ebd.streamChunkSamples;
+        }
+    }
 
     /**
      * @brief ExtendedBufferDescriptor -> JSON
@@ -247,6 +447,56 @@ namespace Finn {
         j.at("packedShape").get_to(ebd.packedShape);
         j.at("normalShape").get_to(ebd.normalShape);
         j.at("foldedShape").get_to(ebd.foldedShape);
+        if (j.contains("producer")) {
+            ebd.producer = j.at("producer").get<BufferLink>();
+        }
+        if (j.contains("cycleCounterOffset")) {
+            ebd.cycleCounterOffset = j.at("cycleCounterOffset").get<uint32_t>();
+        }
+        if (j.contains("transferMode")) {
+            j.at("transferMode").get_to(ebd.transferMode);
+        }
+        if (j.contains("streamChunkSamples")) {
+            j.at("streamChunkSamples").get_to(ebd.streamChunkSamples);
+        }
+    }
+
+    /**
+     * @brief DriverTuning -> JSON
+     *
+     * @param j
+     * @param tuning
+     */
+    // NOLINTNEXTLINE
+    void inline to_json(json& j, const DriverTuning& tuning) {
+        j = json{{"batchSize", tuning.batchSize}, {"hostThreads", tuning.hostThreads}, {"bufferSlots", tuning.bufferSlots},
+                 {"throughput", tuning.throughput}, {"latencyP99", tuning.latencyP99}, {"latencyBound", tuning.latencyBound}};
+    }
+
+    /**
+     * @brief JSON -> DriverTuning. Only the batch size is required, the measured values are informational.
+     *
+     * @param j
+     * @param tuning
+     */
+    // NOLINTNEXTLINE
+    void inline from_json(const json& j, DriverTuning& tuning) {
+        j.at("batchSize").get_to(tuning.batchSize);
+        if (j.contains("hostThreads")) {
+            j.at("hostThreads").get_to(tuning.hostThreads);
+        }
+        if (j.contains("bufferSlots")) {
+            j.at("bufferSlots").get_to(tuning.bufferSlots);
+        }
+        if (j.contains("throughput")) {
+            j.at("throughput").get_to(tuning.throughput);
+        }
+        if (j.contains("latencyP99")) {
+            j.at("latencyP99").get_to(tuning.latencyP99);
+        }
+        if (j.contains("latencyBound")) {
+            j.at("latencyBound").get_to(tuning.latencyBound);
+        }
     }
 
     /**
@@ -263,6 +513,36 @@ namespace Finn {
         devWrap.idmas = std::vector<std::shared_ptr<BufferDescriptor>>(vec.begin(), vec.end());
         vec = j.at("odmas").get<std::vector<std::shared_ptr<ExtendedBufferDescriptor>>>();
         devWrap.odmas = std::vector<std::shared_ptr<BufferDescriptor>>(vec.begin(), vec.end());
+        if (j.contains("waitPolicy")) {
+            j.at("waitPolicy").get_to(devWrap.waitPolicy);
+        }
+        if (j.contains("spinBudget")) {
+            j.at("spinBudget").get_to(devWrap.spinBudget);
+        }
+        if (j.contains("executeTimeoutMs")) {
+            j.at("executeTimeoutMs").get_to(devWrap.executeTimeoutMs);
+        }
+        if (j.contains("archiveCapacity")) {
+            j.at("archiveCapacity").get_to(devWrap.archiveCapacity);
+        }
+        if (j.contains("affinityPolicy")) {
+            j.at("affinityPolicy").get_to(devWrap.affinityPolicy);
+        }
+        if (j.contains("replicatedComputeUnits")) {
+            j.at("replicatedComputeUnits").get_to(devWrap.replicatedComputeUnits);
+        }
+        if (j.contains("memoryArena")) {
+            j.at("memoryArena").get_to(devWrap.memoryArena);
+        }
+        if (j.contains("platform")) {
+            j.at("platform").get_to(devWrap.platform);
+        }
+        if (j.contains("coherentMemory")) {
+            j.at("coherentMemory").get_to(devWrap.coherentMemory);
+        }
+        if (j.contains("tuning")) {
+            devWrap.tuning = j.at("tuning").get<DriverTuning>();
+        }
     }
 
     /**
@@ -286,6 +566,35 @@ namespace Finn {
         return config;
     }
 
+    /**
+     * @brief Store a tuning with the first device of a config file. All other content of the file is kept as it is.
+     *
+     * @param configPath Config to read
+     * @param tuning
+     * @param outputPath File the updated config is written to, the config itself if empty
+     */
+    inline void writeTuningToConfig(const std::filesystem::path& configPath, const DriverTuning& tuning, const std::filesystem::path& outputPath = {}) {
+        if (!std::filesystem::exists(configPath) || !std::filesystem::is_regular_file(configPath)) {
+            throw std::filesystem::filesystem_error("File " + configPath.string() + " not found. Abort.", std::error_code());
+        }
+        json dataJson;
+        {
+            std::ifstream file(configPath);
+            dataJson = json::parse(file);
+        }
+        if (!dataJson.is_array() || dataJson.empty()) {
+            throw std::invalid_argument("Config " + configPath.string() + " contains no device to store the tuning with.");
+        }
+        dataJson[0]["tuning"] = tuning;
+        const auto& target = outputPath.empty() ? configPath : outputPath;
+        std::ofstream file(target, std::ios::trunc);
+        if (!file) {
+            throw std::filesystem::filesystem_error("Could not open " + target.string() + " for writing.", std::error_code());
+        }
+        constexpr int indentation = 4;
+        file << dataJson.dump(indentation) << "\n";
+    }
+
     /**
      * @brief Get the normal, folded and packed shapes for a specific device and dma
      *
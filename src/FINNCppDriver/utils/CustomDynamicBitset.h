@@ -16,7 +16,7 @@
 
 #include <FINNCppDriver/utils/AlignedAllocator.hpp>
 #include <algorithm>
-#include <array>
+#include <bit>
 #include <cstdint>
 #include <cstring>
 #include <iterator>
@@ -25,29 +25,61 @@
 #include <vector>
 
 /**
- * @brief A storage class to store a dynamic amount of bits. Assumes that each bit is set to 1 at most once. Bits cannot be reset.
+ * @brief A storage class to store a dynamic amount of bits. Assumes that each bit is set to 1 at most once. Bits cannot be reset. The bits are stored in 64 bit words, bit n
+ * is bit n % 64 of word n / 64. On a little endian host this is the same memory layout as a byte array in which bit n is bit n % 8 of byte n / 8, which is the layout of
+ * all byte outputs.
  *
  */
 class DynamicBitset {
      private:
     constexpr static std::size_t bitsPerByte = 8;
+    constexpr static std::size_t bitsPerWord = 64;
     size_t bytes;
     size_t capacity;
+    size_t cursor = 0;
+    std::vector<uint64_t, AlignedAllocator<uint64_t>> words;
 
+    /**
+     * @brief Mask of the bits of the last word that belong to the bitset
+     *
+     * @return uint64_t
+     */
+    uint64_t lastWordMask() const {
+        const std::size_t used = capacity % bitsPerWord;
+        return (used == 0) ? ~uint64_t{0} : ((uint64_t{1} << used) - 1);
+    }
 
-     public:
     /**
-     * @brief Internal storage of bits in bitset
+     * @brief Get the byte at the given byte index
      *
+     * @param index
+     * @return uint8_t
      */
-    std::vector<uint8_t, AlignedAllocator<uint8_t>> bits;
+    uint8_t byteAt(std::size_t index) const { return static_cast<uint8_t>(words[index / sizeof(uint64_t)] >> ((index % sizeof(uint64_t)) * bitsPerByte)); }
 
+    /**
+     * @brief Or up to 64 bits into the bitset, starting at bit n. Bits beyond the last word are dropped.
+     *
+     * @param value
+     * @param n
+     */
+    void orBits(uint64_t value, std::size_t n) {
+        const std::size_t word = n / bitsPerWord;
+        const std::size_t offset = n % bitsPerWord;
+        words[word] |= value << offset;
+        if (offset != 0 && word + 1 < words.size()) {
+            words[word + 1] |= value >> (bitsPerWord - offset);
+        }
+    }
+
+     public:
     /**
      * @brief Construct a new Dynamic Bitset
      *
      * @param n Number of bits that should be stored
      */
-    DynamicBitset(const std::size_t& n) : bytes(((n / bitsPerByte) + ((n % bitsPerByte != 0) ? 1 : 0))), capacity(bytes * bitsPerByte), bits(bytes, 0) {}
+    DynamicBitset(const std::size_t& n)
+        : bytes(((n / bitsPerByte) + ((n % bitsPerByte != 0) ? 1 : 0))), capacity(bytes * bitsPerByte), words(FinnUtils::fastDivCeil(bytes, sizeof(uint64_t)), 0) {}
     /**
      * @brief Move constructor
      *
@@ -67,7 +99,8 @@ class DynamicBitset {
     DynamicBitset& operator=(DynamicBitset&& other) {
         capacity = other.capacity;
         bytes = other.bytes;
-        std::swap(this->bits, other.bits);
+        cursor = other.cursor;
+        std::swap(this->words, other.words);
         return *this;
     }
 
@@ -98,6 +131,13 @@ class DynamicBitset {
      */
     std::size_t numBytes() const { return bytes; }
 
+    /**
+     * @brief Returns the number of 64 bit words used to store the bitset
+     *
+     * @return std::size_t
+     */
+    std::size_t numWords() const { return words.size(); }
+
     /**
      * @brief Tests if all of the bits contained in the dynamic bitset is set.
      *
@@ -105,12 +145,17 @@ class DynamicBitset {
      * @return false
      */
     bool all() const {
-        for (auto&& elem : bits) {
-            if (elem != 255U) {
-                return false;
-            }
+        if (words.empty()) {
+            return true;
         }
-        return true;
+        const std::size_t full = words.size() - 1;
+        const uint64_t* data = words.data();
+        uint64_t acc = ~uint64_t{0};
+#pragma omp simd reduction(& : acc)
+        for (std::size_t i = 0; i < full; ++i) {
+            acc &= data[i];
+        }
+        return acc == ~uint64_t{0} && (words.back() & lastWordMask()) == lastWordMask();
     }
 
     /**
@@ -120,12 +165,17 @@ class DynamicBitset {
      * @return false
      */
     bool none() const {
-        for (auto&& elem : bits) {
-            if (elem != 0) {
-                return false;
-            }
+        if (words.empty()) {
+            return true;
         }
-        return true;
+        const std::size_t full = words.size() - 1;
+        const uint64_t* data = words.data();
+        uint64_t acc = 0;
+#pragma omp simd reduction(| : acc)
+        for (std::size_t i = 0; i < full; ++i) {
+            acc |= data[i];
+        }
+        return acc == 0 && (words.back() & lastWordMask()) == 0;
     }
 
     /**
@@ -133,11 +183,7 @@ class DynamicBitset {
      *
      * @param n
      */
-    void setSingleBit(std::size_t n) {
-        std::size_t index = n / bitsPerByte;
-        std::size_t bit = n % bitsPerByte;
-        bits[index] |= static_cast<uint8_t>(1U << bit);
-    }
+    void setSingleBit(std::size_t n) { words[n / bitsPerWord] |= uint64_t{1} << (n % bitsPerWord); }
 
     /**
      * @brief Sets multiple bytes at once based on the provided input. Cannot overwrite already set bits. Always assumes that n is still in vector.
@@ -149,38 +195,35 @@ class DynamicBitset {
     template<typename T>
     void setByte(const T x, std::size_t n) {
         static_assert(std::is_unsigned<T>::value, "DynamicBitset is only supported for unsigned types");
-        std::array<uint8_t, sizeof(T)> input;
-        const std::size_t bitOffset = n % bitsPerByte;
-        const std::size_t byte = n / bitsPerByte;
-        const std::size_t bitShift = sizeof(T) * bitsPerByte - bitOffset;
-        constexpr std::size_t inputSize = sizeof(T);
-        if (bitOffset != 0) {
-            // handle overflow nach links beim shiften
-            const T bitMask = static_cast<T>(0xFF) << bitShift;
-            const T overflow = (bitMask & x);
-            if (overflow != 0) {
-                auto overflowConverted = static_cast<uint8_t>(overflow >> bitShift);
-                bits[byte + inputSize] |= overflowConverted;
-            }
-            const T x2 = x << bitOffset;
-            std::memcpy(input.data(), &x2, sizeof(T));
-        } else {
-            std::memcpy(input.data(), &x, sizeof(T));
-        }
+        static_assert(sizeof(T) <= sizeof(uint64_t), "DynamicBitset can only set up to 64 bits at once");
+        orBits(static_cast<uint64_t>(x), n);
+    }
 
-        const std::size_t cpySize = bytes - byte;
-        uint8_t* bytePtr = bits.data();
-        bytePtr[byte] |= input[0];
-        if (cpySize <= 1) {
+    /**
+     * @brief Appends the lowest width bits of value at the write cursor and advances the cursor by width. Bits above width are ignored. Starts at bit 0 after construction,
+     * so a sequence of appends writes the values back to back without padding. Always assumes that the appended bits are still in the bitset.
+     *
+     * @param value
+     * @param width Number of bits, at most 64
+     */
+    void appendBits(uint64_t value, std::size_t width) {
+        if (width == 0) {
             return;
         }
-        if (inputSize > cpySize) {
-            std::memcpy(&bytePtr[byte + 1], &input.data()[1], cpySize - 1);
-        } else {
-            std::memcpy(&bytePtr[byte + 1], &input.data()[1], inputSize - 1);
+        if (width < bitsPerWord) {
+            value &= (uint64_t{1} << width) - 1;
         }
+        orBits(value, cursor);
+        cursor += width;
     }
 
+    /**
+     * @brief Returns the bit position the next appendBits call writes to
+     *
+     * @return std::size_t
+     */
+    std::size_t getCursor() const { return cursor; }
+
     /**
      * @brief Copies the internal storage vector to the provided container
      *
@@ -189,17 +232,28 @@ class DynamicBitset {
      */
     template<typename T>
     void outputBytes(std::back_insert_iterator<T> it) const {
-        for (auto&& elem : bits) {
-            it = elem;
+        for (std::size_t i = 0; i < bytes; ++i) {
+            it = byteAt(i);
         }
     }
 
     /**
-     * @brief Moves the internal storage vector. The original Dynamic Bitset can not be used after this call!
+     * @brief Returns the stored bits as bytes. The original Dynamic Bitset can not be used after this call!
      *
      * @return std::vector<uint8_t, AlignedAllocator<uint8_t>>
      */
-    std::vector<uint8_t, AlignedAllocator<uint8_t>> getStorageVec() { return std::move(bits); }
+    std::vector<uint8_t, AlignedAllocator<uint8_t>> getStorageVec() {
+        std::vector<uint8_t, AlignedAllocator<uint8_t>> ret(bytes);
+        if constexpr (std::endian::native == std::endian::little) {
+            std::memcpy(ret.data(), words.data(), bytes);
+        } else {
+            for (std::size_t i = 0; i < bytes; ++i) {
+                ret[i] = byteAt(i);
+            }
+        }
+        words = {};
+        return ret;
+    }
 
     /**
      * @brief Converts a DynamicBitset to a string representation
@@ -209,23 +263,31 @@ class DynamicBitset {
     // NOLINTNEXTLINE
     std::string to_string() const {
         std::stringstream out;
-        for (int i = static_cast<int>(bits.size()) - 1; i >= 0; --i) {
+        for (std::size_t i = bytes; i-- > 0;) {
+            const uint8_t byte = byteAt(i);
             for (std::size_t j = 0; j < 8; ++j) {
-                out << (0 != (bits[static_cast<std::size_t>(i)] & (128U >> j)));
+                out << (0 != (byte & (128U >> j)));
             }
         }
         return out.str();
     }
 
     /**
-     * @brief Bitwise OR assignment operator. Should only be used in the context of OpenMP multithreading. Does not perform checks if the two Bitsets are of equal length!
+     * @brief Bitwise OR assignment operator. Should only be used in the context of OpenMP multithreading. Only the words both bitsets have in common are merged, the two
+     * Bitsets are expected to be of equal length.
      *
      * @param lhs first bitset (gets modified by operation)
      * @param rhs second bitset
      * @return DynamicBitset& merged bitset
      */
     friend DynamicBitset& operator|=(DynamicBitset& lhs, const DynamicBitset& rhs) {
-        std::transform(lhs.bits.begin(), lhs.bits.end(), rhs.bits.begin(), lhs.bits.begin(), [](uint8_t& lhsByte, const uint8_t& rhsByte) { return lhsByte | rhsByte; });
+        const std::size_t count = std::min(lhs.words.size(), rhs.words.size());
+        uint64_t* __restrict out = lhs.words.data();
+        const uint64_t* __restrict in = rhs.words.data();
+#pragma omp simd
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i] |= in[i];
+        }
         return lhs;
     }
 };
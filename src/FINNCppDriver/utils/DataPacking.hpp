@@ -21,11 +21,18 @@
 #include <FINNCppDriver/utils/AlignedAllocator.hpp>
 #include <FINNCppDriver/utils/DynamicMdSpan.hpp>
 #include <FINNCppDriver/utils/FinnDatatypes.hpp>
+#include <FINNCppDriver/utils/Instrumentation.hpp>
+#include <FINNCppDriver/utils/PackingKernels.hpp>
+#include <FINNCppDriver/utils/ThreadPool.hpp>
+#include <FINNCppDriver/utils/TransferPlan.h>
 #include <algorithm>
 #include <bitset>
 #include <concepts>
 #include <cstdint>
 #include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
 
 namespace Finn {
     /**
@@ -370,11 +377,19 @@ namespace Finn {
     template<IsDatatype U>
     DynamicBitset mergeBitsets(const Finn::vector<UnpackingAutoRetType::UnsignedRetType<U>>& input) {
         constexpr std::size_t bits = U().bitwidth();
+        // Every thread ors into a private copy of the whole bitset, so the input has to be large enough to amortise the merge of the copies
+        constexpr std::size_t minElementsPerThread = 1UL << 14;
         const std::size_t outputSize = input.size() * bits;
-        // const std::size_t numThreads = std::min(static_cast<std::size_t>(omp_get_num_procs()), input.size() / 100);
+        const auto numThreads = static_cast<int>(std::clamp(input.size() / minElementsPerThread, std::size_t{1}, static_cast<std::size_t>(omp_get_num_procs())));
         DynamicBitset ret(outputSize);
 
-        // #pragma omp parallel for schedule(guided) shared(input, outputSize) reduction(bitsetOR : ret) default(none) num_threads(numThreads) if (input.size() > (static_cast<std::size_t>(omp_get_num_procs()) * 100))
+        if (numThreads == 1) {
+            for (auto&& elem : input) {
+                ret.appendBits(elem, bits);
+            }
+            return ret;
+        }
+#pragma omp parallel for schedule(static) shared(input) reduction(bitsetOR : ret) default(none) num_threads(numThreads)
         for (std::size_t i = 0; i < input.size(); ++i) {
             ret.setByte(input[i], i * bits);
         }
@@ -399,7 +414,7 @@ namespace Finn {
      */
     namespace detail {
         /**
-         * @brief Implementation of packing a single preprocessed range into a vector of bytes without padding
+         * @brief Implementation of packing a single range into a vector of bytes without padding
          *
          * @tparam U Finn Datatype of input data
          * @tparam IteratorType
@@ -409,15 +424,10 @@ namespace Finn {
          */
         template<IsDatatype U, typename IteratorType>
         Finn::vector<uint8_t> packImpl(IteratorType first, IteratorType last) {
-            constexpr size_t bitw = U().bitwidth();
-            if constexpr (bitw == 8) {                      // FINN Datatype is a byte long
-                return Finn::vector<uint8_t>(first, last);  // It fits exactly in a byte, so casting should be fine
-            } else {
-                // TODO(linusjun): For full bytes this is maybe overkill. So change it?
-                auto bitsetvector = toBitset<U, true, false>(first, last);
-                auto mergedBitset = mergeBitsets<U>(bitsetvector);
-                return bitsetToByteVector<uint8_t>(mergedBitset);
-            }
+            constexpr std::size_t byte = 8;
+            Finn::vector<uint8_t> packed(FinnUtils::fastDivCeil(static_cast<std::size_t>(std::distance(first, last)) * U().bitwidth(), byte));
+            packing::packInto<U>(first, last, packed.data());
+            return packed;
         }
     }  // namespace detail
 
@@ -438,60 +448,11 @@ namespace Finn {
             []<bool flag = false>() { static_assert(flag, "Big-endian architectures are currently not supported!"); }
             ();
         } else if constexpr (std::endian::native == std::endian::little) {
-            constexpr bool isFix = U().isFixedPoint();
-            constexpr bool isInt = U().isInteger();
-            if constexpr (isFix) {  // Datatype is Fixed Point Number
-                constexpr std::size_t bytes = FinnUtils::fastDivCeil(U().bitwidth(), 8UL);
-                if constexpr (std::is_floating_point_v<T>) {  // floating point T have no shift operation, so replace with multiplication
-                    std::transform(first, last, first, [](const T& val) { return val * (1 << U().fracBits()); });
-                } else {
-                    std::transform(first, last, first, [](const T& val) { return val << U().fracBits(); });
-                }
-
-                // Use smallest possible datatype for storing data
-                using FourBytesOrLonger = typename std::conditional<bytes <= 4, uint32_t, uint64_t>::type;
-                using TwoBytesOrLonger = typename std::conditional<bytes == 2, uint16_t, FourBytesOrLonger>::type;
-                using OneByteOrLonger = typename std::conditional<bytes == 1, uint8_t, TwoBytesOrLonger>::type;
-
-                Finn::vector<OneByteOrLonger> vec(first, last);
-                return detail::packImpl<DatatypeInt<U().bitwidth()>>(vec.begin(), vec.end());
-            } else if constexpr (std::is_floating_point_v<T> && isInt) {  // Datatype is integer number stored in floating point inputs
-                // Use smallest possible datatype for storing data
-                if constexpr (sizeof(T) >= 4 || sizeof(T) <= 8) {
-                    using VecType = typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type;
-                    Finn::vector<VecType> input(first, last);
-                    return detail::packImpl<U>(input.begin(), input.end());
-                } else {
-                    []<bool flag = false>() { static_assert(flag, "Weird floating point data length. Not supported!"); }
-                    ();
-                }
-            } else if constexpr (std::is_floating_point_v<T>) {  // Datatype is floating point number
+            if constexpr (std::is_floating_point_v<T>) {
                 static_assert(sizeof(float) == 4 && sizeof(double) == 8 && std::numeric_limits<T>::is_iec559, "Floating point format is not iee754 or unexpected type width!");
-                if constexpr (sizeof(T) == 8) {            // FINN only supports 32 bit floating point numbers
-                    Finn::vector<float> vec(first, last);  // This cast is necessary to make sure, that data is in a 32-bit floating point format before the bitcast.
-                    Finn::vector<uint32_t> input;
-                    input.resize(static_cast<std::size_t>(std::distance(first, last)));
-                    std::transform(vec.begin(), vec.end(), input.begin(), [](const float& val) { return std::bit_cast<uint32_t>(val); });
-                    return detail::packImpl<U>(input.begin(), input.end());
-                } else if constexpr (sizeof(T) == 4) {
-                    Finn::vector<uint32_t> input;
-                    input.resize(static_cast<std::size_t>(std::distance(first, last)));
-                    std::transform(first, last, input.begin(), [](const T& val) { return std::bit_cast<uint32_t>(val); });
-                    return detail::packImpl<U>(input.begin(), input.end());
-                } else {
-                    []<bool flag = false>() { static_assert(flag, "Weird floating point data length. Not supported!"); }
-                    ();
-                }
-            } else if constexpr (!isInt && std::is_integral_v<T>) {  // Datatype is float stored in ints
-                Finn::vector<float> vec(first, last);                // This cast is necessary to make sure, that data is in a 32-bit floating point format before the bitcast.
-                Finn::vector<uint32_t> input;
-                input.resize(static_cast<std::size_t>(std::distance(first, last)));
-                std::transform(vec.begin(), vec.end(), input.begin(), [](const float& val) { return std::bit_cast<uint32_t>(val); });  // This conversion can overflow, but thats the user responsibility
-                return detail::packImpl<U>(input.begin(), input.end());
-
-            } else {  // Everything else
-                return detail::packImpl<U>(first, last);
             }
+            // Scaling, quantization and bitcasts are fused into the packing kernels, so the input is neither copied nor modified
+            return detail::packImpl<U>(first, last);
         } else {
             []<bool flag = false>() { static_assert(flag, "Mixed-endian architectures are currently not supported!"); }
             ();
@@ -528,7 +489,7 @@ namespace Finn {
     }
 
     /**
-     * @brief Function to pack multi dimensional input arrays
+     * @brief Function to pack multi dimensional input arrays into a caller provided buffer (e.g. the mapped memory of a DeviceBuffer)
      *
      * @tparam U Finn Datatype of input data
      * @tparam IteratorType
@@ -536,133 +497,311 @@ namespace Finn {
      * @param last  Iterator to last element of input
      * @param dynamicSpan DynamicMdSpan object that describes the folded structure of the input
      * @param elementsInnerMostDim number of elements in the inner most dimension
-     * @return Finn::vector<uint8_t> Vector of packed bytes
+     * @param output Buffer the packed bytes are written to. Has to be at least as large as the packed input
+     * @param pool Thread pool the inner dimensions are distributed over. Packs on the calling thread if nullptr
+     * @return std::size_t Number of bytes written to output
      */
     template<IsDatatype U, typename IteratorType>
-    Finn::vector<uint8_t> packMultiDimensionalInputs(IteratorType first, IteratorType last, const Finn::DynamicMdSpan<IteratorType>& dynamicSpan, const std::size_t elementsInnerMostDim) {
-        auto innerVecs = dynamicSpan.getMostInnerDims();
+    std::size_t packMultiDimensionalInputs(IteratorType first, IteratorType last, const Finn::DynamicMdSpan<IteratorType>& dynamicSpan, const std::size_t elementsInnerMostDim, std::span<uint8_t> output,
+                                           ThreadPool* pool = nullptr) {
+        const auto& innerVecs = dynamicSpan.getMostInnerDims();
         std::size_t innerVecSize = innerVecs.size();
 
-        // preallocate memory to make copy more efficient
         const std::size_t payloadBitsPerInnerDim = elementsInnerMostDim * U().bitwidth();
         constexpr std::size_t byte = 8;
         const std::size_t neededBytesPerInnerDim = FinnUtils::fastDivCeil(payloadBitsPerInnerDim, byte);
         const std::size_t neededBytesTotal = neededBytesPerInnerDim * innerVecSize;
 
-        Finn::vector<uint8_t> packedMerged(neededBytesTotal);
-        std::size_t threadcount = std::min({(innerVecSize >> 5), static_cast<std::size_t>(omp_get_num_procs()), FinnUtils::fastLog2(innerVecSize) << 1});
-        omp_set_num_threads(threadcount);
-        //        std::cout << (std::min({(innerVecSize >> 5), static_cast<std::size_t>(omp_get_num_procs()), FinnUtils::fastLog2(innerVecSize2)<<1})) << "\n";
+        if (output.size() < neededBytesTotal) {
+            FinnUtils::logAndError<std::length_error>("Output buffer for packing is too small (" + std::to_string(output.size()) + " bytes given, " + std::to_string(neededBytesTotal) + " bytes needed)!");
+        }
+
+        const auto packRange = [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                detail::packing::packInto<U>(innerVecs[i].begin(), innerVecs[i].end(), output.data() + i * neededBytesPerInnerDim);
+            }
+        };
+        if (pool != nullptr) {
+            using T = typename std::iterator_traits<IteratorType>::value_type;
+            pool->parallelFor(innerVecSize, elementsInnerMostDim * sizeof(T) + neededBytesPerInnerDim, packRange);
+        } else {
+            packRange(0, innerVecSize);
+        }
+
+        return neededBytesTotal;
+    }
 
-        // for each most inner dimension
-#pragma omp parallel for
-        for (std::size_t i = 0; i < innerVecSize; ++i) {
-            auto packed = Finn::pack<U>(innerVecs[i].begin(), innerVecs[i].end());
-            // combine packing results
-            std::copy(packed.begin(), packed.end(), packedMerged.begin() + i * neededBytesPerInnerDim);
+    namespace detail::packing {
+        /**
+         * @brief Rows of a tile of a permuted input that are gathered together, chosen so that the gathered elements of a tile stay in the L1 cache
+         *
+         * @param elementsPerRow
+         * @return std::size_t
+         */
+        inline std::size_t permutedTileRows(std::size_t elementsPerRow) {
+            constexpr std::size_t tileElements = 4096;
+            return std::max<std::size_t>(1, tileElements / elementsPerRow);
         }
+    }  // namespace detail::packing
 
+    /**
+     * @brief Transpose, fold and pack an input that is stored in another layout than the normal shape (e.g. NCHW instead of NHWC) in a single pass over the source.
+     * Rows are processed in tiles: the elements of a tile are gathered into a small buffer position by position, so consecutive rows read neighbouring source
+     * elements whenever the row axis is contiguous in the source, and every gathered row is then packed like in packMultiDimensionalInputs.
+     *
+     * @tparam U Finn Datatype of input data
+     * @tparam IteratorType Random access iterator over the source data
+     * @param first Iterator to first element of input
+     * @param last  Iterator to last element of input
+     * @param plan Layout of the transfer. Has to be created for the bitwidth of U
+     * @param layout Layout of every sample of the source
+     * @param output Buffer the packed bytes are written to. Has to hold at least plan.bytes() bytes
+     * @param pool Thread pool the tiles are distributed over. Packs on the calling thread if nullptr
+     * @return std::size_t Number of bytes written to output
+     */
+    template<IsDatatype U, std::random_access_iterator IteratorType>
+    std::size_t packPermutedInputs(IteratorType first, IteratorType last, const TransferPlan& plan, const InputLayout& layout, std::span<uint8_t> output, ThreadPool* pool = nullptr) {
+        using T = typename std::iterator_traits<IteratorType>::value_type;
+        const shape_t normal = layout.normalShape();
+        const std::size_t batch = plan.foldedShape[0];
+        const std::size_t rowsPerSample = plan.innerDims / batch;
+        const std::size_t rowElements = plan.elementsPerInnerDim;
+        if (plan.bitwidth != U().bitwidth()) {
+            FinnUtils::logAndError<std::invalid_argument>("Transfer plan was created for a different datatype!");
+        }
+        if (static_cast<std::size_t>(std::distance(first, last)) != plan.elements()) {
+            FinnUtils::logAndError<std::length_error>("Input length (" + std::to_string(std::distance(first, last)) + ") does not match the folded shape " + FinnUtils::shapeToString(plan.foldedShape) + "!");
+        }
+        if (output.size() < plan.bytes()) {
+            FinnUtils::logAndError<std::length_error>("Output buffer for packing is too small (" + std::to_string(output.size()) + " bytes given, " + std::to_string(plan.bytes()) + " bytes needed)!");
+        }
+        // Folding only splits the innermost normal axis into rows
+        if (layout.elements() * batch != plan.elements() || normal.back() % rowElements != 0) {
+            FinnUtils::logAndError<std::invalid_argument>("Input layout with normal shape " + FinnUtils::shapeToString(normal) + " does not match the folded shape " + FinnUtils::shapeToString(plan.foldedShape) + "!");
+        }
+        FINN_TIME_STAGE(PACK);
+
+        const std::vector<std::size_t> strides = layout.normalStrides();
+        const std::size_t sampleElements = layout.elements();
+        const std::size_t rowsPerLine = normal.back() / rowElements;
+        const std::size_t elementStride = strides.back();
+        const std::size_t tileRows = detail::packing::permutedTileRows(rowElements);
+        // Offset of the first element of a row in the source
+        auto rowOffset = [&](std::size_t row) {
+            const std::size_t sample = row / rowsPerSample;
+            std::size_t position = row % rowsPerSample;
+            std::size_t offset = sample * sampleElements + (position % rowsPerLine) * rowElements * elementStride;
+            position /= rowsPerLine;
+            for (std::size_t axis = normal.size() - 1; axis > 0; --axis) {
+                offset += (position % normal[axis - 1]) * strides[axis - 1];
+                position /= normal[axis - 1];
+            }
+            return offset;
+        };
+
+        const std::size_t tiles = FinnUtils::fastDivCeil(plan.innerDims, tileRows);
+        const auto packTiles = [&](std::size_t begin, std::size_t end) {
+            std::vector<T> gathered(tileRows * rowElements);
+            std::vector<std::size_t> offsets(tileRows);
+            for (std::size_t tile = begin; tile < end; ++tile) {
+                const std::size_t firstRow = tile * tileRows;
+                const std::size_t rows = std::min(tileRows, plan.innerDims - firstRow);
+                for (std::size_t row = 0; row < rows; ++row) {
+                    offsets[row] = rowOffset(firstRow + row);
+                }
+                for (std::size_t element = 0; element < rowElements; ++element) {
+                    const std::size_t shift = element * elementStride;
+                    for (std::size_t row = 0; row < rows; ++row) {
+                        gathered[row * rowElements + element] = first[static_cast<std::ptrdiff_t>(offsets[row] + shift)];
+                    }
+                }
+                for (std::size_t row = 0; row < rows; ++row) {
+                    const auto rowBegin = gathered.begin() + static_cast<std::ptrdiff_t>(row * rowElements);
+                    uint8_t* packed = output.data() + (firstRow + row) * plan.bytesPerInnerDim;
+                    const std::size_t written = detail::packing::packInto<U>(rowBegin, rowBegin + static_cast<std::ptrdiff_t>(rowElements), packed);
+                    std::fill(packed + written, packed + plan.bytesPerInnerDim, uint8_t{0});
+                }
+            }
+        };
+        if (pool != nullptr) {
+            pool->parallelFor(tiles, tileRows * (rowElements * sizeof(T) + plan.bytesPerInnerDim), packTiles);
+        } else {
+            packTiles(0, tiles);
+        }
+        return plan.bytes();
+    }
+
+    /**
+     * @brief Function to pack multi dimensional input arrays into a caller provided buffer, following a precomputed TransferPlan. No memory is allocated.
+     * Inputs whose plan has a source layout are packed by packPermutedInputs.
+     *
+     * @tparam U Finn Datatype of input data
+     * @tparam IteratorType Random access iterator over the folded input
+     * @param first Iterator to first element of input
+     * @param last  Iterator to last element of input
+     * @param plan Layout of the transfer. Has to be created for the bitwidth of U
+     * @param output Buffer the packed bytes are written to. Has to hold at least plan.bytes() bytes
+     * @param pool Thread pool the inner dimensions are distributed over. Packs on the calling thread if nullptr
+     * @return std::size_t Number of bytes written to output
+     */
+    template<IsDatatype U, std::random_access_iterator IteratorType>
+    std::size_t packMultiDimensionalInputs(IteratorType first, IteratorType last, const TransferPlan& plan, std::span<uint8_t> output, ThreadPool* pool = nullptr) {
+        if (plan.sourceLayout && !plan.sourceLayout->isIdentity()) {
+            return packPermutedInputs<U>(first, last, plan, *plan.sourceLayout, output, pool);
+        }
+        if (plan.bitwidth != U().bitwidth()) {
+            FinnUtils::logAndError<std::invalid_argument>("Transfer plan was created for a different datatype!");
+        }
+        if (static_cast<std::size_t>(std::distance(first, last)) != plan.elements()) {
+            FinnUtils::logAndError<std::length_error>("Input length (" + std::to_string(std::distance(first, last)) + ") does not match the folded shape " + FinnUtils::shapeToString(plan.foldedShape) + "!");
+        }
+        if (output.size() < plan.bytes()) {
+            FinnUtils::logAndError<std::length_error>("Output buffer for packing is too small (" + std::to_string(output.size()) + " bytes given, " + std::to_string(plan.bytes()) + " bytes needed)!");
+        }
+        FINN_TIME_STAGE(PACK);
+
+        const auto packRange = [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                const auto rowBegin = first + static_cast<std::ptrdiff_t>(i * plan.elementsPerInnerDim);
+                uint8_t* row = output.data() + i * plan.bytesPerInnerDim;
+                const std::size_t written = detail::packing::packInto<U>(rowBegin, rowBegin + static_cast<std::ptrdiff_t>(plan.elementsPerInnerDim), row);
+                std::fill(row + written, row + plan.bytesPerInnerDim, uint8_t{0});
+            }
+        };
+        if (pool != nullptr) {
+            using T = typename std::iterator_traits<IteratorType>::value_type;
+            pool->parallelFor(plan.innerDims, plan.elementsPerInnerDim * sizeof(T) + plan.bytesPerInnerDim, packRange);
+        } else {
+            packRange(0, plan.innerDims);
+        }
+        return plan.bytes();
+    }
+
+    /**
+     * @brief Like packMultiDimensionalInputs with a TransferPlan, but the row geometry is taken from compile time shapes. The loop over the elements of a row and the
+     * padding of a row are fixed at compile time, so the kernel is fully specialised for the network.
+     *
+     * @tparam U Finn Datatype of input data
+     * @tparam Shape StaticBufferShape of the input buffer
+     * @tparam IteratorType Random access iterator over the folded input
+     * @param first Iterator to first element of input
+     * @param last  Iterator to last element of input
+     * @param innerDims Number of rows to pack, Shape::innerDimsPerSample per batch element
+     * @param output Buffer the packed bytes are written to. Has to hold at least innerDims * Shape::bytesPerInnerDim bytes
+     * @param pool Thread pool the inner dimensions are distributed over. Packs on the calling thread if nullptr
+     * @return std::size_t Number of bytes written to output
+     */
+    template<IsDatatype U, typename Shape, std::random_access_iterator IteratorType>
+    std::size_t packStaticInputs(IteratorType first, IteratorType last, std::size_t innerDims, std::span<uint8_t> output, ThreadPool* pool = nullptr) {
+        static_assert(Shape::template fits<U>(), "The static input shape does not fit the bitwidth of the input datatype!");
+        constexpr std::size_t elements = Shape::elementsPerInnerDim;
+        constexpr std::size_t bytes = Shape::bytesPerInnerDim;
+        constexpr std::size_t usedBytes = (elements * U().bitwidth() + 7) / 8;
+        if (static_cast<std::size_t>(std::distance(first, last)) != innerDims * elements || output.size() < innerDims * bytes) {
+            FinnUtils::logAndError<std::length_error>("Input (" + std::to_string(std::distance(first, last)) + " elements) or output (" + std::to_string(output.size()) + " bytes) do not match the static shapes of " + std::to_string(innerDims) + " rows!");
+        }
+        FINN_TIME_STAGE(PACK);
+
+        const auto packRange = [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                const auto rowBegin = first + static_cast<std::ptrdiff_t>(i * elements);
+                uint8_t* row = output.data() + i * bytes;
+                detail::packing::packInto<U>(rowBegin, rowBegin + static_cast<std::ptrdiff_t>(elements), row);
+                if constexpr (usedBytes < bytes) {
+                    std::fill_n(row + usedBytes, bytes - usedBytes, uint8_t{0});
+                }
+            }
+        };
+        if (pool != nullptr) {
+            using T = typename std::iterator_traits<IteratorType>::value_type;
+            pool->parallelFor(innerDims, elements * sizeof(T) + bytes, packRange);
+        } else {
+            packRange(0, innerDims);
+        }
+        return innerDims * bytes;
+    }
+
+    /**
+     * @brief Function to pack multi dimensional input arrays
+     *
+     * @tparam U Finn Datatype of input data
+     * @tparam IteratorType
+     * @param first Iterator to first element of input
+     * @param last  Iterator to last element of input
+     * @param dynamicSpan DynamicMdSpan object that describes the folded structure of the input
+     * @param elementsInnerMostDim number of elements in the inner most dimension
+     * @param pool Thread pool the inner dimensions are distributed over. Packs on the calling thread if nullptr
+     * @return Finn::vector<uint8_t> Vector of packed bytes
+     */
+    template<IsDatatype U, typename IteratorType>
+    Finn::vector<uint8_t> packMultiDimensionalInputs(IteratorType first, IteratorType last, const Finn::DynamicMdSpan<IteratorType>& dynamicSpan, const std::size_t elementsInnerMostDim, ThreadPool* pool = nullptr) {
+        // preallocate memory to make copy more efficient
+        constexpr std::size_t byte = 8;
+        const std::size_t neededBytesTotal = FinnUtils::fastDivCeil(elementsInnerMostDim * U().bitwidth(), byte) * dynamicSpan.getMostInnerDims().size();
+
+        Finn::vector<uint8_t> packedMerged(neededBytesTotal);
+        packMultiDimensionalInputs<U, IteratorType>(first, last, dynamicSpan, elementsInnerMostDim, std::span<uint8_t>(packedMerged.data(), packedMerged.size()), pool);
         return packedMerged;
     }
 
 
     /**
-     * @brief Unpacks a byte vector into a vector of T containing U.
+     * @brief Unpacks a byte range into a caller provided buffer of T containing U. No memory is allocated.
      *
      * @tparam U FinnDatatype that is contained in byte array
-     * @tparam T Type of return vector. Is usually autodeduced, but it is also supported to use larger types for outputs: ex.: uint16_t instead of uint8_t is valid.
+     * @tparam T Type of output buffer. Is usually autodeduced, but it is also supported to use larger types for outputs: ex.: uint16_t instead of uint8_t is valid.
      * @tparam typename Unnamed template param is used to enable the function only for supported types
-     * @param inp Byte vector
+     * @param inp Byte range
+     * @param out Output buffer. Has to be large enough to hold all unpacked elements
      * @param padding Number of padding bits inserted into last byte of input
-     * @return Finn::vector<T> Vector of T containing U
+     * @return std::size_t Number of elements written to out
      */
-    template<IsDatatype U, bool reverseByte = false, typename T = UnpackingAutoRetType::AutoRetType<U>, typename = std::enable_if_t<IsCorrectFinnType<U, T>()>>
-    Finn::vector<T> unpack(std::span<uint8_t>& inp, std::size_t padding = 0) {
+    template<IsDatatype U, typename T = UnpackingAutoRetType::AutoRetType<U>, typename = std::enable_if_t<IsCorrectFinnType<U, T>()>>
+    std::size_t unpackInto(std::span<const uint8_t> inp, std::span<T> out, std::size_t padding = 0) {
         static_assert(U().bitwidth() <= 64, "Finn Datatypes with more than 64 bit are not supported!");
 
-        constexpr std::size_t neededBytes = FinnUtils::fastDivCeil(U().bitwidth(), 8UL);
-
-        using FourBytesOrLonger = typename std::conditional<neededBytes <= 4, int32_t, int64_t>::type;
-        using TwoBytesOrLonger = typename std::conditional<neededBytes == 2, int16_t, FourBytesOrLonger>::type;
-        using FixedPointType = typename std::conditional<neededBytes == 1, int8_t, TwoBytesOrLonger>::type;
-        using RetType = typename std::conditional<U().isFixedPoint(), FixedPointType, T>::type;
-
         if (inp.empty()) {
             FinnUtils::logAndError<std::runtime_error>("Input to unpacking operation is empty! Abord.");
         }
 
-        if constexpr (reverseByte) {
-            std::reverse(inp.begin(), inp.end());
-        }
-
         if ((inp.size() * 8 - padding) % U().bitwidth() != 0) {
             FinnUtils::logAndError<std::runtime_error>("Amount of input elements is not a multiple of output elements");
         }
 
         constexpr size_t bitw = U().bitwidth();
-        constexpr bool isSigned = U().sign();
-        if constexpr (bitw / 8.0 == neededBytes) {  // complete Bytes, therefore no padding after here
-            Finn::vector<RetType> ret(inp.size() / neededBytes, 0);
-            for (std::size_t i = 0; i < ret.size(); ++i) {
-                const std::size_t offset = i * neededBytes;
-                if constexpr (isSigned) {  // TODO(linusjun): Test if this needs to be optimized or put into a seperate loop to allow vectorization.
-                    if ((-128 & inp[offset + neededBytes - 1]) != 0) {
-                        ret[i] = -1;
-                    }
-                }
-                std::memcpy(&ret.data()[i], &inp.data()[offset], neededBytes);
-            }
-            constexpr bool isFixed = U().isFixedPoint();
-            if constexpr (isFixed) {
-                Finn::vector<float> fixedRet(ret.size());
-                std::transform(ret.begin(), ret.end(), fixedRet.begin(), [](const RetType& val) { return static_cast<float>(val) / (1 << U().fracBits()); });
-                return fixedRet;
-            } else {
-                return ret;
-            }
+        const std::size_t elementsInInput = ((inp.size() * 8) - padding) / bitw;
 
+        if (out.size() < elementsInInput) {
+            FinnUtils::logAndError<std::length_error>("Output buffer for unpacking is too small (" + std::to_string(out.size()) + " elements given, " + std::to_string(elementsInInput) + " elements needed)!");
+        }
 
-        } else {
-            constexpr std::size_t bitwidth = U().bitwidth();
-
-            using FourBytesOrLongerUnsigned = typename std::conditional<bitwidth <= 32, uint64_t, __uint128_t>::type;
-            using TwoBytesOrLongerUnsigned = typename std::conditional<bitwidth <= 16, uint32_t, FourBytesOrLongerUnsigned>::type;
-            using BufferType = typename std::conditional<bitwidth <= 8, uint16_t, TwoBytesOrLongerUnsigned>::type;
-
-            constexpr BufferType mask = createMask<BufferType>(bitwidth);
-            const std::size_t elementsInInput = ((inp.size() * 8) - padding) / U().bitwidth();
-            Finn::vector<RetType> ret(elementsInInput, 0);
-
-            for (std::size_t index = 0; index < elementsInInput; ++index) {
-                const std::size_t lowerBit = index * bitwidth;
-                const std::size_t lowerBorderByte = lowerBit / 8;                   // Intentionally rounding down
-                const std::size_t upperBorderByte = (lowerBit + bitwidth - 1) / 8;  // Intentionally rounding down
-                const std::size_t numBytes = upperBorderByte - lowerBorderByte + 1;
-                const std::size_t shiftOffset = lowerBit - (lowerBorderByte * 8);
-
-                BufferType buffer = 0;                                         // This buffer is big enough to contain two FinnDatatype elements. Therefore no problem if one FinnDatatype element is shifted.
-                std::memcpy(&buffer, &inp.data()[lowerBorderByte], numBytes);  // Fill Buffer with from byte inputs
-                buffer = static_cast<BufferType>(buffer >> shiftOffset);       // remove remaining bits from previous element
-                buffer &= mask;                                                // remove bits from next element
-
-                constexpr bool isSigned = U().sign();
-                if constexpr (isSigned) {  // TODO(linusjun): Test if this needs to be optimized or put into a seperate loop to allow vectorization.
-                    if (((BufferType(1U) << (bitwidth - 1)) & buffer) != 0) {
-                        buffer |= ~mask;
-                    }
-                }
-                ret[index] = static_cast<RetType>(buffer);
-            }
+        detail::packing::unpackTo<U, T>(inp.data(), inp.size(), elementsInInput, out.data());
+        return elementsInInput;
+    }
 
-            constexpr bool isFixed = U().isFixedPoint();
-            if constexpr (isFixed) {
-                Finn::vector<float> fixedRet(ret.size());
-                std::transform(ret.begin(), ret.end(), fixedRet.begin(), [](const RetType& val) { return static_cast<float>(static_cast<FixedPointType>(val)) / (1 << U().fracBits()); });
-                return fixedRet;
-            } else {
-                return ret;
-            }
+    /**
+     * @brief Unpacks a byte vector into a vector of T containing U.
+     *
+     * @tparam U FinnDatatype that is contained in byte array
+     * @tparam T Type of return vector. Is usually autodeduced, but it is also supported to use larger types for outputs: ex.: uint16_t instead of uint8_t is valid.
+     * @tparam typename Unnamed template param is used to enable the function only for supported types
+     * @param inp Byte vector
+     * @param padding Number of padding bits inserted into last byte of input
+     * @return Finn::vector<T> Vector of T containing U
+     */
+    template<IsDatatype U, bool reverseByte = false, typename T = UnpackingAutoRetType::AutoRetType<U>, typename = std::enable_if_t<IsCorrectFinnType<U, T>()>>
+    Finn::vector<T> unpack(std::span<uint8_t>& inp, std::size_t padding = 0) {
+        if constexpr (reverseByte) {
+            std::reverse(inp.begin(), inp.end());
+        }
+
+        if (inp.empty()) {
+            FinnUtils::logAndError<std::runtime_error>("Input to unpacking operation is empty! Abord.");
         }
+
+        Finn::vector<T> ret(((inp.size() * 8) - padding) / U().bitwidth());
+        unpackInto<U, T>(inp, std::span<T>(ret.data(), ret.size()), padding);
+        return ret;
     }
 
     /**
@@ -681,6 +820,97 @@ namespace Finn {
         return unpack<U, reverseByte, T>(spa, padding);
     }
 
+    /**
+     * @brief Unpacks a multi-dimensional packed byte range (e.g. the mapped memory of an output DeviceBuffer) into a caller provided buffer, following a precomputed TransferPlan.
+     * No memory is allocated.
+     *
+     * @tparam U FinnDatatype that is contained in byte array
+     * @tparam T Type of output buffer. Usually autodeduced.
+     * @param packed Linearized packed bytes. Has to hold at least plan.bytes() bytes
+     * @param plan Layout of the transfer. Has to be created for the bitwidth of U
+     * @param output Output buffer. Has to hold at least plan.elements() elements
+     * @param pool Thread pool the inner dimensions are distributed over. Unpacks on the calling thread if nullptr
+     * @return std::size_t Number of elements written to output
+     */
+    template<IsDatatype U, typename T = UnpackingAutoRetType::AutoRetType<U>, typename = std::enable_if_t<IsCorrectFinnType<U, T>()>>
+    std::size_t unpackMultiDimensionalOutputs(std::span<const uint8_t> packed, const TransferPlan& plan, std::span<T> output, ThreadPool* pool = nullptr) {
+        if (plan.bitwidth != U().bitwidth()) {
+            FinnUtils::logAndError<std::invalid_argument>("Transfer plan was created for a different datatype!");
+        }
+        if (packed.size() < plan.bytes()) {
+            FinnUtils::logAndError<std::length_error>("Packed input is smaller than its packed shape " + FinnUtils::shapeToString(plan.packedShape) + "!");
+        }
+        if (output.size() < plan.elements()) {
+            FinnUtils::logAndError<std::length_error>("Output buffer for unpacking is too small (" + std::to_string(output.size()) + " elements given, " + std::to_string(plan.elements()) + " elements needed)!");
+        }
+        FINN_TIME_STAGE(UNPACK);
+
+        const auto unpackRange = [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                detail::packing::unpackTo<U, T>(packed.data() + i * plan.bytesPerInnerDim, plan.bytesPerInnerDim, plan.elementsPerInnerDim, output.data() + i * plan.elementsPerInnerDim);
+            }
+        };
+        if (pool != nullptr) {
+            pool->parallelFor(plan.innerDims, plan.bytesPerInnerDim + plan.elementsPerInnerDim * sizeof(T), unpackRange);
+        } else {
+            unpackRange(0, plan.innerDims);
+        }
+        return plan.elements();
+    }
+
+    /**
+     * @brief Like unpackMultiDimensionalOutputs with a TransferPlan, but the row geometry is taken from compile time shapes, @see packStaticInputs
+     *
+     * @tparam U FinnDatatype that is contained in byte array
+     * @tparam Shape StaticBufferShape of the output buffer
+     * @tparam T Type of output buffer. Usually autodeduced.
+     * @param packed Linearized packed bytes. Has to hold at least innerDims * Shape::bytesPerInnerDim bytes
+     * @param innerDims Number of rows to unpack, Shape::innerDimsPerSample per batch element
+     * @param output Output buffer. Has to hold at least innerDims * Shape::elementsPerInnerDim elements
+     * @param pool Thread pool the inner dimensions are distributed over. Unpacks on the calling thread if nullptr
+     * @return std::size_t Number of elements written to output
+     */
+    template<IsDatatype U, typename Shape, typename T = UnpackingAutoRetType::AutoRetType<U>, typename = std::enable_if_t<IsCorrectFinnType<U, T>()>>
+    std::size_t unpackStaticOutputs(std::span<const uint8_t> packed, std::size_t innerDims, std::span<T> output, ThreadPool* pool = nullptr) {
+        static_assert(Shape::template fits<U>(), "The static output shape does not fit the bitwidth of the output datatype!");
+        constexpr std::size_t elements = Shape::elementsPerInnerDim;
+        constexpr std::size_t bytes = Shape::bytesPerInnerDim;
+        if (packed.size() < innerDims * bytes || output.size() < innerDims * elements) {
+            FinnUtils::logAndError<std::length_error>("Packed input (" + std::to_string(packed.size()) + " bytes) or output (" + std::to_string(output.size()) + " elements) do not match the static shapes of " + std::to_string(innerDims) + " rows!");
+        }
+        FINN_TIME_STAGE(UNPACK);
+
+        const auto unpackRange = [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                detail::packing::unpackTo<U, T>(packed.data() + i * bytes, bytes, elements, output.data() + i * elements);
+            }
+        };
+        if (pool != nullptr) {
+            pool->parallelFor(innerDims, bytes + elements * sizeof(T), unpackRange);
+        } else {
+            unpackRange(0, innerDims);
+        }
+        return innerDims * elements;
+    }
+
+    /**
+     * @brief Unpacks a multi-dimensional packed byte range (e.g. the mapped memory of an output DeviceBuffer) into a caller provided buffer. No intermediate vectors are allocated.
+     * Builds a TransferPlan on every call, prefer the overload taking a plan for repeated transfers.
+     *
+     * @tparam U FinnDatatype that is contained in byte array
+     * @tparam T Type of output buffer. Usually autodeduced.
+     * @param packed Linearized packed bytes, laid out as described by packedShape
+     * @param packedShape Packed shape of the byte range. The last dimension is the number of bytes per innermost dimension
+     * @param foldedShape Shape of the unpacked target
+     * @param output Output buffer. Has to hold at least shapeToElements(foldedShape) elements
+     * @param pool Thread pool the inner dimensions are distributed over. Unpacks on the calling thread if nullptr
+     * @return std::size_t Number of elements written to output
+     */
+    template<IsDatatype U, typename T = UnpackingAutoRetType::AutoRetType<U>, typename = std::enable_if_t<IsCorrectFinnType<U, T>()>>
+    std::size_t unpackMultiDimensionalOutputs(std::span<const uint8_t> packed, const shapePacked_t& packedShape, const shapeFolded_t& foldedShape, std::span<T> output, ThreadPool* pool = nullptr) {
+        return unpackMultiDimensionalOutputs<U, T>(packed, TransferPlan(foldedShape, packedShape, U().bitwidth()), output, pool);
+    }
+
     /**
      * @brief Unpacks multi-dimensional output vectors
      *
@@ -692,25 +922,31 @@ namespace Finn {
      * @param end Iterator to the end of linearized byte array
      * @param dynSpan DynamicMdSpan describing the structure of the byte array
      * @param foldedShape Shape of the target vector
+     * @param pool Thread pool the inner dimensions are distributed over. Unpacks on the calling thread if nullptr
      * @return Finn::vector<T> Vector of T containing U
      */
     template<IsDatatype U, std::input_iterator IteratorType, bool reverseByte = false, typename T = UnpackingAutoRetType::AutoRetType<U>, typename = std::enable_if_t<IsCorrectFinnType<U, T>()>>
-    Finn::vector<T> unpackMultiDimensionalOutputs(IteratorType begin, IteratorType end, const Finn::DynamicMdSpan<IteratorType>& dynSpan, const shapeFolded_t& foldedShape)
+    Finn::vector<T> unpackMultiDimensionalOutputs(IteratorType begin, IteratorType end, const Finn::DynamicMdSpan<IteratorType>& dynSpan, const shapeFolded_t& foldedShape, ThreadPool* pool = nullptr)
         requires(std::is_same_v<uint8_t, typename std::iterator_traits<IteratorType>::value_type>)
     {
         constexpr std::size_t bytes = 8;
-        auto innerDimVecs = dynSpan.getMostInnerDims();
-        std::size_t innerVecSize = innerDimVecs.size();
+        const auto& innerDimVecs = dynSpan.getMostInnerDims();
         const std::size_t padding = innerDimVecs[0].size() * bytes - foldedShape.back() * U().bitwidth();
 
         // preallocate memory to make copy more efficient
         const std::size_t retSizeTotal = FinnUtils::shapeToElements(foldedShape);
         Finn::vector<T> unpackedMerged(retSizeTotal);
+        std::span<T> out(unpackedMerged.data(), unpackedMerged.size());
 
-#pragma omp parallel for
-        for (std::size_t i = 0; i < innerDimVecs.size(); ++i) {
-            auto unpacked = Finn::unpack<U>(innerDimVecs[i], padding);
-            std::copy(unpacked.begin(), unpacked.end(), unpackedMerged.begin() + i * foldedShape.back());
+        const auto unpackRange = [&](std::size_t first, std::size_t last) {
+            for (std::size_t i = first; i < last; ++i) {
+                unpackInto<U, T>(innerDimVecs[i], out.subspan(i * foldedShape.back(), foldedShape.back()), padding);
+            }
+        };
+        if (pool != nullptr) {
+            pool->parallelFor(innerDimVecs.size(), innerDimVecs[0].size() + foldedShape.back() * sizeof(T), unpackRange);
+        } else {
+            unpackRange(0, innerDimVecs.size());
         }
 
         return unpackedMerged;
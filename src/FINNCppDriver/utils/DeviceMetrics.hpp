@@ -0,0 +1,346 @@
+/**
+ * @file DeviceMetrics.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Counters for the transfers and kernel executions of device buffers, and the utilisation and bandwidth derived from them
+ * @version 0.1
+ * @date 2024-03-10
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef DEVICEMETRICS
+#define DEVICEMETRICS
+
+#include <FINNCppDriver/utils/Logger.h>
+#include <FINNCppDriver/utils/Types.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Finn {
+    /**
+     * @brief Counters of one device buffer at one point in time
+     *
+     */
+    struct BufferMetricsSnapshot {
+        /**
+         * @brief Kernel name of the buffer
+         *
+         */
+        std::string kernelName;
+        /**
+         * @brief Direction of the buffer
+         *
+         */
+        IO ioMode = IO::INPUT;
+        /**
+         * @brief Number of kernel starts
+         *
+         */
+        std::uint64_t invocations = 0;
+        /**
+         * @brief Number of kernel completions the driver waited for. Synchronous inputs are never waited for, their kernels finish before the outputs.
+         *
+         */
+        std::uint64_t completions = 0;
+        /**
+         * @brief Number of syncs between the host and the device memory
+         *
+         */
+        std::uint64_t transfers = 0;
+        /**
+         * @brief Bytes moved between the host and the device memory
+         *
+         */
+        std::uint64_t bytes = 0;
+        /**
+         * @brief Time the transfers were in flight
+         *
+         */
+        std::chrono::nanoseconds transferTime{0};
+        /**
+         * @brief Time from the start of the kernel until the driver saw it idle again, summed over all completions
+         *
+         */
+        std::chrono::nanoseconds busyTime{0};
+        /**
+         * @brief Sum of the cycle counter of the IP core after every completion. Only counted for buffers with a BufferDescriptor::cycleCounterOffset.
+         *
+         */
+        std::uint64_t deviceCycles = 0;
+        /**
+         * @brief Number of kernel runs that missed the execute timeout
+         *
+         */
+        std::uint64_t timeouts = 0;
+
+        /**
+         * @brief Achieved bandwidth of the transfers
+         *
+         * @return double Bytes per second while a transfer was in flight, 0 without transfers
+         */
+        double bandwidth() const { return (transferTime.count() > 0) ? static_cast<double>(bytes) / std::chrono::duration<double>(transferTime).count() : 0.0; }
+
+        /**
+         * @brief Fraction of a time window the kernel was busy
+         *
+         * @param window
+         * @return double
+         */
+        double utilisation(std::chrono::nanoseconds window) const { return (window.count() > 0) ? std::min(1.0, static_cast<double>(busyTime.count()) / static_cast<double>(window.count())) : 0.0; }
+    };
+
+    /**
+     * @brief Counters of one device buffer. Updated by the thread that drives the buffer and read by any other thread, so all counters are relaxed atomics.
+     *
+     */
+    class BufferMetrics {
+         private:
+        std::atomic<std::uint64_t> invocations = 0;
+        std::atomic<std::uint64_t> completions = 0;
+        std::atomic<std::uint64_t> transfers = 0;
+        std::atomic<std::uint64_t> bytes = 0;
+        std::atomic<std::int64_t> transferNs = 0;
+        std::atomic<std::int64_t> busyNs = 0;
+        std::atomic<std::uint64_t> deviceCycles = 0;
+        std::atomic<std::uint64_t> timeouts = 0;
+
+         public:
+        /**
+         * @brief Count a kernel start
+         *
+         */
+        void countInvocation() { invocations.fetch_add(1, std::memory_order_relaxed); }
+
+        /**
+         * @brief Count a finished transfer
+         *
+         * @param transferredBytes
+         * @param duration Time the transfer was in flight
+         */
+        void countTransfer(std::uint64_t transferredBytes, std::chrono::nanoseconds duration) {
+            transfers.fetch_add(1, std::memory_order_relaxed);
+            bytes.fetch_add(transferredBytes, std::memory_order_relaxed);
+            transferNs.fetch_add(duration.count(), std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Count a kernel completion
+         *
+         * @param busy Time from the start of the kernel until it was seen idle
+         */
+        void countCompletion(std::chrono::nanoseconds busy) {
+            completions.fetch_add(1, std::memory_order_relaxed);
+            busyNs.fetch_add(busy.count(), std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Count the cycles the IP core reported for a run
+         *
+         * @param cycles
+         */
+        void countCycles(std::uint64_t cycles) { deviceCycles.fetch_add(cycles, std::memory_order_relaxed); }
+
+        /**
+         * @brief Count a kernel run that missed the execute timeout
+         *
+         */
+        void countTimeout() { timeouts.fetch_add(1, std::memory_order_relaxed); }
+
+        /**
+         * @brief Read all counters. Counts updated concurrently may be split between this and the next snapshot.
+         *
+         * @param kernelName
+         * @param ioMode
+         * @return BufferMetricsSnapshot
+         */
+        BufferMetricsSnapshot snapshot(const std::string& kernelName, IO ioMode) const {
+            return {kernelName,
+                    ioMode,
+                    invocations.load(std::memory_order_relaxed),
+                    completions.load(std::memory_order_relaxed),
+                    transfers.load(std::memory_order_relaxed),
+                    bytes.load(std::memory_order_relaxed),
+                    std::chrono::nanoseconds(transferNs.load(std::memory_order_relaxed)),
+                    std::chrono::nanoseconds(busyNs.load(std::memory_order_relaxed)),
+                    deviceCycles.load(std::memory_order_relaxed),
+                    timeouts.load(std::memory_order_relaxed)};
+        }
+
+        /**
+         * @brief Set all counters to zero. Counts updated concurrently may be lost.
+         *
+         */
+        void reset() {
+            invocations.store(0, std::memory_order_relaxed);
+            completions.store(0, std::memory_order_relaxed);
+            transfers.store(0, std::memory_order_relaxed);
+            bytes.store(0, std::memory_order_relaxed);
+            transferNs.store(0, std::memory_order_relaxed);
+            busyNs.store(0, std::memory_order_relaxed);
+            deviceCycles.store(0, std::memory_order_relaxed);
+            timeouts.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * @brief Counters of all buffers of a device at one point in time
+     *
+     */
+    struct DeviceMetricsSnapshot {
+        /**
+         * @brief XRT device index
+         *
+         */
+        unsigned int deviceIndex = 0;
+        /**
+         * @brief Time since the counters were last reset
+         *
+         */
+        std::chrono::nanoseconds window{0};
+        /**
+         * @brief One entry per idma and odma
+         *
+         */
+        std::vector<BufferMetricsSnapshot> buffers;
+
+        /**
+         * @brief Bytes moved in one direction by all buffers of the device
+         *
+         * @param ioMode
+         * @return std::uint64_t
+         */
+        std::uint64_t bytes(IO ioMode) const {
+            std::uint64_t sum = 0;
+            for (auto&& buffer : buffers) {
+                sum += (buffer.ioMode == ioMode) ? buffer.bytes : 0;
+            }
+            return sum;
+        }
+
+        /**
+         * @brief Time the device was busy. The odmas are started first and finish last, so the busiest buffer spans the whole dataflow pipeline of its runs.
+         *
+         * @return std::chrono::nanoseconds
+         */
+        std::chrono::nanoseconds busyTime() const {
+            std::chrono::nanoseconds busiest{0};
+            for (auto&& buffer : buffers) {
+                busiest = std::max(busiest, buffer.busyTime);
+            }
+            return busiest;
+        }
+
+        /**
+         * @brief Fraction of the window the device was busy, @see busyTime
+         *
+         * @return double
+         */
+        double utilisation() const { return (window.count() > 0) ? std::min(1.0, static_cast<double>(busyTime().count()) / static_cast<double>(window.count())) : 0.0; }
+    };
+
+    /**
+     * @brief Format the metrics of several devices as a table, one line per buffer
+     *
+     * @param devices
+     * @return std::string
+     */
+    inline std::string formatDeviceMetrics(const std::vector<DeviceMetricsSnapshot>& devices) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2);
+        for (auto&& device : devices) {
+            out << "device " << device.deviceIndex << ": utilisation " << device.utilisation() * 100.0 << "% over " << std::chrono::duration<double>(device.window).count() << "s\n";
+            out << std::left << std::setw(48) << "  buffer" << std::right << std::setw(12) << "runs" << std::setw(12) << "done" << std::setw(14) << "MB" << std::setw(12) << "MB/s" << std::setw(12) << "busy[%]"
+                << std::setw(16) << "cycles" << "\n";
+            for (auto&& buffer : device.buffers) {
+                constexpr double bytesPerMB = 1e6;
+                out << std::left << std::setw(48) << ("  " + buffer.kernelName) << std::right << std::setw(12) << buffer.invocations << std::setw(12) << buffer.completions << std::setw(14)
+                    << static_cast<double>(buffer.bytes) / bytesPerMB << std::setw(12) << buffer.bandwidth() / bytesPerMB << std::setw(12) << buffer.utilisation(device.window) * 100.0 << std::setw(16)
+                    << buffer.deviceCycles << "\n";
+            }
+        }
+        return out.str();
+    }
+
+    /**
+     * @brief Pulls metrics from a source periodically on a background thread and hands them to a sink, until it is destroyed
+     *
+     */
+    class MetricsExporter {
+         public:
+        /**
+         * @brief Produces the current metrics
+         *
+         */
+        using source_t = std::function<std::vector<DeviceMetricsSnapshot>()>;
+        /**
+         * @brief Consumes the metrics of one period
+         *
+         */
+        using sink_t = std::function<void(const std::vector<DeviceMetricsSnapshot>&)>;
+
+         private:
+        std::mutex wakeupMutex;
+        std::condition_variable_any wakeup;
+        std::jthread exporter;
+
+        /**
+         * @brief A logger prefix to determine the source of a log write
+         *
+         * @return std::string
+         */
+        static std::string loggerPrefix() { return "[MetricsExporter] "; }
+
+         public:
+        /**
+         * @brief Start exporting
+         *
+         * @param interval Time between two exports
+         * @param source
+         * @param sink Empty to log the metrics as a table
+         */
+        MetricsExporter(std::chrono::milliseconds interval, source_t source, sink_t sink = {}) {
+            if (!sink) {
+                sink = [](const std::vector<DeviceMetricsSnapshot>& devices) { FINN_LOG(Logger::getLogger(), loglevel::info) << loggerPrefix() << "Device metrics:\n" << formatDeviceMetrics(devices); };
+            }
+            exporter = std::jthread([this, interval, source = std::move(source), sink = std::move(sink)](const std::stop_token& stoken) {
+                std::unique_lock lock(wakeupMutex);
+                while (!wakeup.wait_for(lock, stoken, interval, [&stoken]() { return stoken.stop_requested(); })) {
+                    sink(source());
+                }
+            });
+        }
+
+        MetricsExporter(MetricsExporter&&) = delete;
+        MetricsExporter(const MetricsExporter&) = delete;
+        MetricsExporter& operator=(MetricsExporter&&) = delete;
+        MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+        /**
+         * @brief Stop exporting. Waits for an export that is in progress.
+         *
+         */
+        ~MetricsExporter() {
+            exporter.request_stop();
+            if (exporter.joinable()) {
+                exporter.join();
+            }
+        }
+    };
+}  // namespace Finn
+
+#endif  // DEVICEMETRICS
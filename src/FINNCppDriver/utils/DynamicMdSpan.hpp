@@ -121,9 +121,9 @@ namespace Finn {
         /**
          * @brief Get the Most Inner Dims object
          *
-         * @return std::vector<std::span<T>>
+         * @return const std::vector<std::span<T>>&
          */
-        std::vector<std::span<T>> getMostInnerDims() const { return mostInnerDims; }
+        const std::vector<std::span<T>>& getMostInnerDims() const { return mostInnerDims; }
     };
 
 }  // namespace Finn
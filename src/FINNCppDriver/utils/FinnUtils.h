@@ -191,6 +191,20 @@ namespace FinnUtils {
      */
     inline constexpr size_t getActualBufferSize(size_t requiredBytes) { return requiredBytes == 0 ? 4096UL : std::max(4096UL, (2UL << fastLog2Ceil(requiredBytes) - 1)); }
 
+    /**
+     * @brief Alignment of the sub-buffers carved from a device memory arena. Every sub-buffer starts on a page, so its DMA transfers are as aligned as they are for a buffer object of its own.
+     *
+     */
+    constexpr size_t subBufferAlignment = 4096;
+
+    /**
+     * @brief Size of a sub-buffer of a device memory arena: the exact number of bytes, rounded up to the next multiple of subBufferAlignment
+     *
+     * @param requiredBytes
+     * @return size_t
+     */
+    inline constexpr size_t getAlignedBufferSize(size_t requiredBytes) { return requiredBytes == 0 ? subBufferAlignment : (requiredBytes + subBufferAlignment - 1) / subBufferAlignment * subBufferAlignment; }
+
     /**
      * @brief Put some newlines into the log script for clearer reading
      *
@@ -257,6 +271,18 @@ namespace FinnUtils {
 #endif
     }
 
+    /**
+     * @brief Hint to the CPU that the caller is spinning in a busy wait loop. Reduces power and frees pipeline resources for the sibling hyperthread.
+     *
+     */
+    inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield" ::: "memory");
+#endif
+    }
+
     /**
      * @brief First log the message as an error into the logger, then throw the passed error!
      *
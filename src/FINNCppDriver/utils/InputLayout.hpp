@@ -0,0 +1,127 @@
+/**
+ * @file InputLayout.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Memory layout of host inputs that are not given in the normal shape of the network, e.g. NCHW tensors of an NHWC network
+ * @version 0.1
+ * @date 2024-03-18
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef INPUTLAYOUT
+#define INPUTLAYOUT
+
+#include <FINNCppDriver/utils/FinnUtils.h>
+#include <FINNCppDriver/utils/Types.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Finn {
+    /**
+     * @brief Layout of one sample of a host input as a permutation of the normal shape. Axis d of the normal shape is axis permutation[d] of the source tensor. The
+     * batch dimension is not part of the layout, samples always follow each other. Packing with a layout reads the source in place, so no transposed copy is made.
+     *
+     */
+    struct InputLayout {
+        /**
+         * @brief Shape of one sample as it is stored on the host, without the batch dimension
+         *
+         */
+        shape_t sourceShape;
+        /**
+         * @brief Source axis of every normal axis
+         *
+         */
+        std::vector<std::size_t> permutation;
+
+        /**
+         * @brief Construct an empty layout
+         *
+         */
+        InputLayout() = default;
+
+        /**
+         * @brief Construct a new layout
+         *
+         * @param pSourceShape Shape of one sample on the host
+         * @param pPermutation Source axis of every normal axis, has to be a permutation of 0 ... sourceShape.size() - 1
+         */
+        InputLayout(const shape_t& pSourceShape, const std::vector<std::size_t>& pPermutation) : sourceShape(pSourceShape), permutation(pPermutation) {
+            std::vector<std::size_t> sorted(permutation);
+            std::sort(sorted.begin(), sorted.end());
+            std::vector<std::size_t> axes(sourceShape.size());
+            std::iota(axes.begin(), axes.end(), 0);
+            if (sourceShape.empty() || sorted != axes) {
+                FinnUtils::logAndError<std::invalid_argument>("Input layout with source shape " + FinnUtils::shapeToString(sourceShape) + " needs a permutation of all its axes!");
+            }
+        }
+
+        /**
+         * @brief Layout of channels first (NCHW) inputs to a network with channels last (NHWC) normal shape
+         *
+         * @param normalShape Normal shape of the network input, including the batch dimension
+         * @return InputLayout
+         */
+        static InputLayout channelsFirst(const shape_t& normalShape) {
+            if (normalShape.size() < 3) {
+                FinnUtils::logAndError<std::invalid_argument>("A channels first layout needs a normal shape with batch, spatial and channel dimensions, got " + FinnUtils::shapeToString(normalShape) + "!");
+            }
+            // Source: C, spatial axes. Normal: spatial axes, C
+            shape_t source{normalShape.back()};
+            source.insert(source.end(), normalShape.begin() + 1, normalShape.end() - 1);
+            std::vector<std::size_t> permutation(source.size());
+            std::iota(permutation.begin(), permutation.end() - 1, 1);
+            permutation.back() = 0;
+            return {source, permutation};
+        }
+
+        /**
+         * @brief Shape of one sample in the normal layout of the network
+         *
+         * @return shape_t
+         */
+        shape_t normalShape() const {
+            shape_t normal(permutation.size());
+            std::transform(permutation.begin(), permutation.end(), normal.begin(), [this](std::size_t axis) { return sourceShape[axis]; });
+            return normal;
+        }
+
+        /**
+         * @brief Distance in the source of neighbouring elements along every normal axis
+         *
+         * @return std::vector<std::size_t>
+         */
+        std::vector<std::size_t> normalStrides() const {
+            std::vector<std::size_t> sourceStrides(sourceShape.size(), 1);
+            for (std::size_t axis = sourceShape.size() - 1; axis > 0; --axis) {
+                sourceStrides[axis - 1] = sourceStrides[axis] * sourceShape[axis];
+            }
+            std::vector<std::size_t> strides(permutation.size());
+            std::transform(permutation.begin(), permutation.end(), strides.begin(), [&sourceStrides](std::size_t axis) { return sourceStrides[axis]; });
+            return strides;
+        }
+
+        /**
+         * @brief Number of elements of one sample
+         *
+         * @return std::size_t
+         */
+        std::size_t elements() const { return FinnUtils::shapeToElements(sourceShape); }
+
+        /**
+         * @brief True if the source already is in the normal layout
+         *
+         * @return bool
+         */
+        bool isIdentity() const { return std::is_sorted(permutation.begin(), permutation.end()); }
+    };
+}  // namespace Finn
+
+#endif  // INPUTLAYOUT
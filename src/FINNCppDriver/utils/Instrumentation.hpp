@@ -0,0 +1,302 @@
+/**
+ * @file Instrumentation.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Per stage latency recording of the driver. Removed at compile time unless FINN_ENABLE_INSTRUMENTATION is defined.
+ * @version 0.1
+ * @date 2024-02-23
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef INSTRUMENTATION
+#define INSTRUMENTATION
+
+#include <FINNCppDriver/utils/Logger.h>
+
+#include <FINNCppDriver/utils/LatencyHistogram.hpp>
+#include <FINNCppDriver/utils/TimelineTracer.hpp>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Finn {
+    /**
+     * @brief Stages of an inference whose latency is recorded
+     *
+     */
+    enum class STAGE : std::size_t {
+        VALIDATE = 0,          ///< Checking the input against the buffer shapes
+        PACK = 1,              ///< Packing the folded input into the device format
+        SYNC_TO_DEVICE = 2,    ///< Syncing an input buffer object to the device
+        EXECUTE = 3,           ///< Writing the registers that start an IP core
+        WAIT = 4,              ///< Waiting for an IP core to finish
+        SYNC_FROM_DEVICE = 5,  ///< Syncing an output buffer object from the device
+        UNPACK = 6,            ///< Unpacking the device format into the folded output
+        COUNT = 7
+    };
+
+    /**
+     * @brief Number of recorded stages
+     *
+     */
+    constexpr std::size_t stageCount = static_cast<std::size_t>(STAGE::COUNT);
+
+    /**
+     * @brief Get a printable name of a stage
+     *
+     * @param stage
+     * @return const char*
+     */
+    constexpr const char* stageName(STAGE stage) {
+        constexpr std::array<const char*, stageCount> names = {"validate", "pack", "syncToDevice", "execute", "wait", "syncFromDevice", "unpack"};
+        return (stage < STAGE::COUNT) ? names[static_cast<std::size_t>(stage)] : "invalid";
+    }
+
+    /**
+     * @brief Process wide store of the stage latencies. Every thread records into its own set of histograms, so recording never takes a lock. The sets of
+     * terminated threads are handed to new threads, which keeps the memory bounded by the largest number of concurrently recording threads.
+     *
+     */
+    class LatencyRecorder {
+         private:
+        struct Shard {
+            std::array<LatencyHistogram, stageCount> stages;
+        };
+
+        /**
+         * @brief Returns the shard of the calling thread to the recorder once the thread ends
+         *
+         */
+        struct ShardHandle {
+            LatencyRecorder& recorder;
+            Shard* shard;
+            explicit ShardHandle(LatencyRecorder& pRecorder) : recorder(pRecorder), shard(pRecorder.acquireShard()) {}
+            ShardHandle(ShardHandle&&) = delete;
+            ShardHandle(const ShardHandle&) = delete;
+            ShardHandle& operator=(ShardHandle&&) = delete;
+            ShardHandle& operator=(const ShardHandle&) = delete;
+            ~ShardHandle() { recorder.releaseShard(shard); }
+        };
+
+        mutable std::mutex shardsMutex;
+        std::vector<std::unique_ptr<Shard>> shards;
+        std::vector<Shard*> freeShards;
+
+        std::mutex dumpMutex;
+        std::condition_variable_any dumpWakeup;
+        std::jthread dumpThread;
+
+        LatencyRecorder() = default;
+
+        Shard* acquireShard() {
+            std::lock_guard guard(shardsMutex);
+            if (!freeShards.empty()) {
+                Shard* shard = freeShards.back();
+                freeShards.pop_back();
+                return shard;
+            }
+            return shards.emplace_back(std::make_unique<Shard>()).get();
+        }
+
+        void releaseShard(Shard* shard) {
+            std::lock_guard guard(shardsMutex);
+            freeShards.push_back(shard);
+        }
+
+        Shard& localShard() {
+            thread_local ShardHandle handle(*this);
+            return *handle.shard;
+        }
+
+        /**
+         * @brief A logger prefix to determine the source of a log write
+         *
+         * @return std::string
+         */
+        static std::string loggerPrefix() { return "[LatencyRecorder] "; }
+
+         public:
+        LatencyRecorder(LatencyRecorder&&) = delete;
+        LatencyRecorder(const LatencyRecorder&) = delete;
+        LatencyRecorder& operator=(LatencyRecorder&&) = delete;
+        LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+        ~LatencyRecorder() = default;
+
+        /**
+         * @brief Get the recorder of the process
+         *
+         * @return LatencyRecorder&
+         */
+        static LatencyRecorder& global() {
+            static LatencyRecorder recorder;
+            return recorder;
+        }
+
+        /**
+         * @brief Record one sample for a stage in the histogram of the calling thread
+         *
+         * @param stage
+         * @param duration
+         */
+        void record(STAGE stage, std::chrono::nanoseconds duration) { localShard().stages[static_cast<std::size_t>(stage)].record(static_cast<std::uint64_t>(std::max<std::int64_t>(0, duration.count()))); }
+
+        /**
+         * @brief Summarize the samples of all threads for a stage
+         *
+         * @param stage
+         * @return LatencySummary
+         */
+        LatencySummary summary(STAGE stage) const {
+            std::array<std::uint64_t, LatencyHistogram::bucketCount> merged{};
+            std::uint64_t sum = 0;
+            std::uint64_t max = 0;
+            {
+                std::lock_guard guard(shardsMutex);
+                for (auto&& shard : shards) {
+                    shard->stages[static_cast<std::size_t>(stage)].accumulate(merged, sum, max);
+                }
+            }
+            return LatencyHistogram::summarize(merged, sum, max);
+        }
+
+        /**
+         * @brief Drop all samples. Samples recorded concurrently may be lost.
+         *
+         */
+        void reset() {
+            std::lock_guard guard(shardsMutex);
+            for (auto&& shard : shards) {
+                for (auto&& histogram : shard->stages) {
+                    histogram.reset();
+                }
+            }
+        }
+
+        /**
+         * @brief Format the summaries of all stages that have samples as a table, one line per stage, in microseconds
+         *
+         * @return std::string
+         */
+        std::string report() const {
+            std::ostringstream out;
+            out << std::fixed << std::setprecision(2);
+            out << std::left << std::setw(16) << "stage" << std::right << std::setw(12) << "count" << std::setw(12) << "mean[us]" << std::setw(12) << "p50[us]" << std::setw(12) << "p99[us]" << std::setw(12)
+                << "p999[us]" << std::setw(12) << "max[us]" << "\n";
+            for (std::size_t i = 0; i < stageCount; ++i) {
+                const auto stage = static_cast<STAGE>(i);
+                const LatencySummary s = summary(stage);
+                if (s.count == 0) {
+                    continue;
+                }
+                constexpr double nsPerUs = 1000.0;
+                out << std::left << std::setw(16) << stageName(stage) << std::right << std::setw(12) << s.count << std::setw(12) << s.mean / nsPerUs << std::setw(12) << static_cast<double>(s.p50) / nsPerUs
+                    << std::setw(12) << static_cast<double>(s.p99) / nsPerUs << std::setw(12) << static_cast<double>(s.p999) / nsPerUs << std::setw(12) << static_cast<double>(s.max) / nsPerUs << "\n";
+            }
+            return out.str();
+        }
+
+        /**
+         * @brief Log the report periodically from a background thread. Replaces a running dump.
+         *
+         * @param interval
+         */
+        void startPeriodicDump(std::chrono::milliseconds interval) {
+            stopPeriodicDump();
+            dumpThread = std::jthread([this, interval](std::stop_token stoken) {
+                std::unique_lock lock(dumpMutex);
+                while (!dumpWakeup.wait_for(lock, stoken, interval, [&stoken]() { return stoken.stop_requested(); })) {
+                    FINN_LOG(Logger::getLogger(), loglevel::info) << loggerPrefix() << "Stage latencies:\n" << report();
+                }
+            });
+        }
+
+        /**
+         * @brief Stop the periodic dump, if one is running
+         *
+         */
+        void stopPeriodicDump() {
+            if (dumpThread.joinable()) {
+                dumpThread.request_stop();
+                dumpThread.join();
+            }
+        }
+    };
+
+    /**
+     * @brief Records the time from its construction to its destruction for a stage, and as a span of the calling thread if the timeline tracer is enabled
+     *
+     */
+    class ScopedStageTimer {
+         private:
+        STAGE stage;
+        std::chrono::steady_clock::time_point start;
+
+         public:
+        /**
+         * @brief Start timing a stage
+         *
+         * @param pStage
+         */
+        explicit ScopedStageTimer(STAGE pStage) : stage(pStage), start(std::chrono::steady_clock::now()) {}
+        ScopedStageTimer(ScopedStageTimer&&) = delete;
+        ScopedStageTimer(const ScopedStageTimer&) = delete;
+        ScopedStageTimer& operator=(ScopedStageTimer&&) = delete;
+        ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+        ~ScopedStageTimer() {
+            const auto end = std::chrono::steady_clock::now();
+            LatencyRecorder::global().record(stage, end - start);
+            TimelineTracer::global().record(stageName(stage), start, end);
+        }
+    };
+}  // namespace Finn
+
+// NOLINTBEGIN
+#define FINN_STAGE_TIMER_CONCAT_IMPL(a, b) a##b
+#define FINN_STAGE_TIMER_CONCAT(a, b) FINN_STAGE_TIMER_CONCAT_IMPL(a, b)
+#ifdef FINN_ENABLE_INSTRUMENTATION
+    /**
+     * @brief Time the rest of the enclosing scope as the given Finn::STAGE
+     *
+     */
+    #define FINN_TIME_STAGE(STAGE_NAME) const Finn::ScopedStageTimer FINN_STAGE_TIMER_CONCAT(finnStageTimer, __LINE__)(Finn::STAGE::STAGE_NAME)
+    /**
+     * @brief Record the rest of the enclosing scope as a span of the calling thread on the timeline, without a latency histogram. NAME has to be a string literal.
+     *
+     */
+    #define FINN_TRACE_SCOPE(NAME) const Finn::ScopedTimelineEvent FINN_STAGE_TIMER_CONCAT(finnTimelineEvent, __LINE__)(NAME)
+    /**
+     * @brief Name the timeline track of the calling thread
+     *
+     */
+    #define FINN_TRACE_THREAD_NAME(NAME) Finn::TimelineTracer::global().nameThread(NAME)
+#else
+    /**
+     * @brief Removed, because FINN_ENABLE_INSTRUMENTATION is not defined
+     *
+     */
+    #define FINN_TIME_STAGE(STAGE_NAME) static_cast<void>(0)
+    /**
+     * @brief Removed, because FINN_ENABLE_INSTRUMENTATION is not defined
+     *
+     */
+    #define FINN_TRACE_SCOPE(NAME) static_cast<void>(0)
+    /**
+     * @brief Removed, because FINN_ENABLE_INSTRUMENTATION is not defined
+     *
+     */
+    #define FINN_TRACE_THREAD_NAME(NAME) static_cast<void>(0)
+#endif  // FINN_ENABLE_INSTRUMENTATION
+// NOLINTEND
+
+#endif  // INSTRUMENTATION
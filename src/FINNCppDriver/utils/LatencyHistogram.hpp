@@ -0,0 +1,234 @@
+/**
+ * @file LatencyHistogram.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Log-linear latency histogram with a bounded relative error, in the spirit of HdrHistogram
+ * @version 0.1
+ * @date 2024-02-23
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef LATENCYHISTOGRAM
+#define LATENCYHISTOGRAM
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace Finn {
+    /**
+     * @brief Summary of the samples of one or more LatencyHistograms. All values are in nanoseconds.
+     *
+     */
+    struct LatencySummary {
+        /**
+         * @brief Number of samples
+         *
+         */
+        std::uint64_t count = 0;
+        /**
+         * @brief Arithmetic mean of the samples
+         *
+         */
+        double mean = 0;
+        /**
+         * @brief Largest sample
+         *
+         */
+        std::uint64_t max = 0;
+        /**
+         * @brief Median
+         *
+         */
+        std::uint64_t p50 = 0;
+        /**
+         * @brief 99th percentile
+         *
+         */
+        std::uint64_t p99 = 0;
+        /**
+         * @brief 99.9th percentile
+         *
+         */
+        std::uint64_t p999 = 0;
+    };
+
+    /**
+     * @brief Histogram of nanosecond samples. Values below 2^subBucketBits are counted exactly, larger values fall into one of 2^subBucketBits linear sub-buckets
+     * of their power of two, so every recorded value is reported with a relative error below 2^-subBucketBits (about 3%). Values of more than 2^maxMagnitude ns
+     * (about 4.9 hours) are clamped.
+     *
+     * Recording is wait-free but meant for a single writing thread per histogram; counters are updated with relaxed loads and stores instead of read-modify-write
+     * operations. Any thread may read the histogram concurrently and merge several of them into one summary.
+     *
+     */
+    class LatencyHistogram {
+         public:
+        /**
+         * @brief Number of bits of precision per power of two
+         *
+         */
+        static constexpr unsigned int subBucketBits = 5;
+        /**
+         * @brief Largest power of two that can be recorded
+         *
+         */
+        static constexpr unsigned int maxMagnitude = 43;
+        /**
+         * @brief Number of linear sub-buckets per power of two
+         *
+         */
+        static constexpr std::size_t subBuckets = std::size_t{1} << subBucketBits;
+        /**
+         * @brief Total number of buckets
+         *
+         */
+        static constexpr std::size_t bucketCount = subBuckets + (maxMagnitude - subBucketBits + 1) * subBuckets;
+
+         private:
+        std::array<std::atomic<std::uint64_t>, bucketCount> counts{};
+        std::atomic<std::uint64_t> total = 0;
+        std::atomic<std::uint64_t> sum = 0;
+        std::atomic<std::uint64_t> largest = 0;
+
+        static void increment(std::atomic<std::uint64_t>& counter, std::uint64_t by) { counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed); }
+
+         public:
+        /**
+         * @brief Index of the bucket a value is counted in
+         *
+         * @param value
+         * @return std::size_t
+         */
+        static constexpr std::size_t bucketIndex(std::uint64_t value) {
+            value = std::min<std::uint64_t>(value, (std::uint64_t{2} << maxMagnitude) - 1);
+            if (value < subBuckets) {
+                return static_cast<std::size_t>(value);
+            }
+            const unsigned int magnitude = static_cast<unsigned int>(std::bit_width(value)) - 1;
+            const unsigned int shift = magnitude - subBucketBits;
+            return subBuckets + shift * subBuckets + static_cast<std::size_t>((value >> shift) - subBuckets);
+        }
+
+        /**
+         * @brief Largest value that is counted in the given bucket
+         *
+         * @param index
+         * @return std::uint64_t
+         */
+        static constexpr std::uint64_t bucketUpperBound(std::size_t index) {
+            if (index < subBuckets) {
+                return index;
+            }
+            const std::size_t shift = (index - subBuckets) / subBuckets;
+            const std::uint64_t sub = subBuckets + (index - subBuckets) % subBuckets;
+            return ((sub + 1) << shift) - 1;
+        }
+
+        /**
+         * @brief Count one sample. Only one thread may record into a histogram.
+         *
+         * @param nanoseconds
+         */
+        void record(std::uint64_t nanoseconds) {
+            increment(counts[bucketIndex(nanoseconds)], 1);
+            increment(total, 1);
+            increment(sum, nanoseconds);
+            if (nanoseconds > largest.load(std::memory_order_relaxed)) {
+                largest.store(nanoseconds, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * @brief Reset all counters. Samples recorded concurrently may be lost.
+         *
+         */
+        void reset() {
+            for (auto&& count : counts) {
+                count.store(0, std::memory_order_relaxed);
+            }
+            total.store(0, std::memory_order_relaxed);
+            sum.store(0, std::memory_order_relaxed);
+            largest.store(0, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Number of recorded samples
+         *
+         * @return std::uint64_t
+         */
+        std::uint64_t size() const { return total.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Add the counters of this histogram to the given accumulators
+         *
+         * @param pCounts Per bucket counts
+         * @param pSum Sum of all samples
+         * @param pMax Largest sample
+         */
+        void accumulate(std::array<std::uint64_t, bucketCount>& pCounts, std::uint64_t& pSum, std::uint64_t& pMax) const {
+            for (std::size_t i = 0; i < bucketCount; ++i) {
+                pCounts[i] += counts[i].load(std::memory_order_relaxed);
+            }
+            pSum += sum.load(std::memory_order_relaxed);
+            pMax = std::max(pMax, largest.load(std::memory_order_relaxed));
+        }
+
+        /**
+         * @brief Summarize accumulated counters
+         *
+         * @param pCounts Per bucket counts
+         * @param pSum Sum of all samples
+         * @param pMax Largest sample
+         * @return LatencySummary
+         */
+        static LatencySummary summarize(const std::array<std::uint64_t, bucketCount>& pCounts, std::uint64_t pSum, std::uint64_t pMax) {
+            LatencySummary summary;
+            for (auto count : pCounts) {
+                summary.count += count;
+            }
+            if (summary.count == 0) {
+                return summary;
+            }
+            summary.mean = static_cast<double>(pSum) / static_cast<double>(summary.count);
+            summary.max = pMax;
+            auto percentile = [&](double quantile) {
+                const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(quantile * static_cast<double>(summary.count))));
+                std::uint64_t seen = 0;
+                for (std::size_t i = 0; i < bucketCount; ++i) {
+                    seen += pCounts[i];
+                    if (seen >= rank) {
+                        // The bucket bound may exceed the largest sample, which is known exactly
+                        return std::min(bucketUpperBound(i), pMax);
+                    }
+                }
+                return pMax;
+            };
+            summary.p50 = percentile(0.5);
+            summary.p99 = percentile(0.99);
+            summary.p999 = percentile(0.999);
+            return summary;
+        }
+
+        /**
+         * @brief Summarize this histogram
+         *
+         * @return LatencySummary
+         */
+        LatencySummary summary() const {
+            std::array<std::uint64_t, bucketCount> merged{};
+            std::uint64_t mergedSum = 0;
+            std::uint64_t mergedMax = 0;
+            accumulate(merged, mergedSum, mergedMax);
+            return summarize(merged, mergedSum, mergedMax);
+        }
+    };
+}  // namespace Finn
+
+#endif  // LATENCYHISTOGRAM
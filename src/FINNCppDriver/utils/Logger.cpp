@@ -12,47 +12,112 @@
 
 #include "Logger.h"
 
-#include <boost/core/enable_if.hpp>                       // for lazy_enable...
-#include <boost/exception/exception.hpp>                  // for exception
-#include <boost/log/core/core.hpp>                        // IWYU pragma: keep
-#include <boost/log/core/record.hpp>                      // IWYU pragma: keep
-#include <boost/log/detail/attachable_sstream_buf.hpp>    // IWYU pragma: keep
-#include <boost/log/detail/attr_output_impl.hpp>          // IWYU pragma: keep
-#include <boost/log/expressions/formatter.hpp>            // IWYU pragma: keep
-#include <boost/log/keywords/auto_flush.hpp>              // IWYU pragma: keep
-#include <boost/log/keywords/file_name.hpp>               // IWYU pragma: keep
-#include <boost/log/keywords/format.hpp>                  // IWYU pragma: keep
-#include <boost/log/keywords/rotation_size.hpp>           // IWYU pragma: keep
-#include <boost/log/keywords/severity.hpp>                // IWYU pragma: keep
-#include <boost/log/keywords/time_based_rotation.hpp>     // IWYU pragma: keep
-#include <boost/log/sinks/sync_frontend.hpp>              // IWYU pragma: keep
-#include <boost/log/sinks/text_file_backend.hpp>          // IWYU pragma: keep
-#include <boost/log/sources/record_ostream.hpp>           // IWYU pragma: keep
-#include <boost/log/utility/setup/common_attributes.hpp>  // IWYU pragma: keep
-#include <boost/log/utility/setup/console.hpp>            // IWYU pragma: keep
-#include <boost/log/utility/setup/formatter_parser.hpp>   // IWYU pragma: keep
-#include <boost/parameter/keyword.hpp>                    // for keyword
-#include <boost/smart_ptr/make_shared_object.hpp>         // for make_shared
-#include <boost/smart_ptr/shared_ptr.hpp>                 // for shared_ptr
-#include <boost/thread/exceptions.hpp>                    // for thread_inte...
-#include <iostream>                                       // for streamsize
+#ifdef FINN_LIGHTWEIGHT_LOGGING
+    #include <ctime>     // for localtime_r
+    #include <iomanip>   // for put_time
+    #include <iostream>  // for clog
+    #include <mutex>     // for mutex
+
+// NOLINTBEGIN
+    #ifdef NDEBUG
+DevNull dev_null;
+    #endif  // NDEBUG
+// NOLINTEND
+
+void LightweightLogger::write(loglevel::severity_level severity, const std::string& message) {
+    static constexpr const char* names[] = {"trace", "debug", "info", "warning", "error", "fatal"};
+    const auto now = std::chrono::system_clock::now();
+    const std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+    const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count() % 1000000;
+    std::tm local{};
+    localtime_r(&seconds, &local);
+    static std::mutex mutex;
+    std::lock_guard guard(mutex);
+    std::clog << "[" << std::put_time(&local, "%Y-%m-%d %H:%M:%S") << "." << std::setfill('0') << std::setw(6) << micros << std::setfill(' ') << "] [" << names[severity] << "]: " << message << "\n";
+}
+
+// cppcheck-suppress unusedFunction
+logger_type& Logger::getLogger() {
+    static LightweightLogger logger;
+    return logger;
+}
+
+Logger::Logger() = default;
+
+Logger::~Logger() { std::clog.flush(); }
+
+void Logger::flush() { std::clog.flush(); }
+
+void Logger::initLogging() {}
+#else
+    #include <boost/core/enable_if.hpp>                       // for lazy_enable...
+    #include <boost/exception/exception.hpp>                  // for exception
+    #include <boost/log/core/core.hpp>                        // IWYU pragma: keep
+    #include <boost/log/core/record.hpp>                      // IWYU pragma: keep
+    #include <boost/log/detail/attachable_sstream_buf.hpp>    // IWYU pragma: keep
+    #include <boost/log/detail/attr_output_impl.hpp>          // IWYU pragma: keep
+    #include <boost/log/expressions/formatter.hpp>            // IWYU pragma: keep
+    #include <boost/log/keywords/auto_flush.hpp>              // IWYU pragma: keep
+    #include <boost/log/keywords/file_name.hpp>               // IWYU pragma: keep
+    #include <boost/log/keywords/format.hpp>                  // IWYU pragma: keep
+    #include <boost/log/keywords/rotation_size.hpp>           // IWYU pragma: keep
+    #include <boost/log/keywords/severity.hpp>                // IWYU pragma: keep
+    #include <boost/log/keywords/time_based_rotation.hpp>     // IWYU pragma: keep
+    #include <boost/core/null_deleter.hpp>                    // for null_deleter
+    #include <boost/log/sinks/async_frontend.hpp>             // IWYU pragma: keep
+    #include <boost/log/sinks/sync_frontend.hpp>              // IWYU pragma: keep
+    #include <boost/log/sinks/text_file_backend.hpp>          // IWYU pragma: keep
+    #include <boost/log/sinks/text_ostream_backend.hpp>       // IWYU pragma: keep
+    #include <boost/log/sinks/unbounded_fifo_queue.hpp>       // IWYU pragma: keep
+    #include <boost/log/sources/record_ostream.hpp>           // IWYU pragma: keep
+    #include <boost/log/utility/setup/common_attributes.hpp>  // IWYU pragma: keep
+    #include <boost/log/utility/setup/console.hpp>            // IWYU pragma: keep
+    #include <boost/log/utility/setup/formatter_parser.hpp>   // IWYU pragma: keep
+    #include <boost/parameter/keyword.hpp>                    // for keyword
+    #include <boost/smart_ptr/make_shared_object.hpp>         // for make_shared
+    #include <boost/smart_ptr/shared_ptr.hpp>                 // for shared_ptr
+    #include <boost/thread/exceptions.hpp>                    // for thread_inte...
+    #include <iostream>                                       // for streamsize
 
 /**
  * @brief Abbrieviation for boost logging type
  *
  */
 using backend_type = bl::sinks::text_file_backend;
+/**
+ * @brief Abbrieviation for boost logging type
+ *
+ */
+using console_backend_type = bl::sinks::text_ostream_backend;
+    #ifdef FINN_ENABLE_ASYNC_LOGGING
+/**
+ * @brief Records are formatted and written by a dedicated thread of the sink. Logging threads only push them into a lock free queue.
+ *
+ */
+using sink_type = bl::sinks::asynchronous_sink<backend_type, bl::sinks::unbounded_fifo_queue>;
+/**
+ * @brief Abbrieviation for boost logging type
+ *
+ */
+using console_sink_type = bl::sinks::asynchronous_sink<console_backend_type, bl::sinks::unbounded_fifo_queue>;
+    #else
 /**
  * @brief Abbrieviation for boost logging type
  *
  */
 using sink_type = bl::sinks::synchronous_sink<backend_type>;
+/**
+ * @brief Abbrieviation for boost logging type
+ *
+ */
+using console_sink_type = bl::sinks::synchronous_sink<console_backend_type>;
+    #endif  // FINN_ENABLE_ASYNC_LOGGING
 namespace kw = bl::keywords;
 
 // NOLINTBEGIN
-#ifdef NDEBUG
+    #ifdef NDEBUG
 DevNull dev_null;
-#endif  // NDEBUG
+    #endif  // NDEBUG
 // NOLINTEND
 
 namespace Details {
@@ -62,6 +127,19 @@ namespace Details {
      */
     // NOLINTNEXTLINE
     logger_type boostLogger;
+
+    /**
+     * @brief Sinks of the global logger, kept to write out their queued records on shutdown
+     *
+     */
+    // NOLINTNEXTLINE
+    finnBoost::shared_ptr<sink_type> fileSink;
+    /**
+     * @brief @see fileSink
+     *
+     */
+    // NOLINTNEXTLINE
+    finnBoost::shared_ptr<console_sink_type> consoleSink;
 }  // namespace Details
 
 // cppcheck-suppress unusedFunction
@@ -73,13 +151,28 @@ logger_type& Logger::getLogger() {
 Logger::Logger() {
     auto backend = finnBoost::make_shared<backend_type>(kw::file_name = "finnLog_%N.log", kw::rotation_size = 10 * 1024 * 1024, kw::time_based_rotation = bl::sinks::file::rotation_at_time_point(0, 0, 0), kw::auto_flush = true);
 
-    auto sink = finnBoost::make_shared<sink_type>(backend);
-    sink->set_formatter(bl::parse_formatter(logFormat));
+    Details::fileSink = finnBoost::make_shared<sink_type>(backend);
+    Details::fileSink->set_formatter(bl::parse_formatter(logFormat));
 
-    bl::core::get()->add_sink(sink);
+    bl::core::get()->add_sink(Details::fileSink);
     initLogging();
 }
 
+Logger::~Logger() {
+    auto core = bl::core::get();
+    core->remove_sink(Details::fileSink);
+    core->remove_sink(Details::consoleSink);
+    #ifdef FINN_ENABLE_ASYNC_LOGGING
+    // Stop the dedicated threads of the sinks, flush then writes the records still queued on this thread
+    Details::fileSink->stop();
+    Details::consoleSink->stop();
+    #endif  // FINN_ENABLE_ASYNC_LOGGING
+    Details::fileSink->flush();
+    Details::consoleSink->flush();
+}
+
+void Logger::flush() { bl::core::get()->flush(); }
+
 void Logger::initLogging() {
     static bool init = false;
     if (!init) {
@@ -87,8 +180,14 @@ void Logger::initLogging() {
         bl::register_simple_formatter_factory<bl::trivial::severity_level, char>("Severity");
         finnBoost::log::add_common_attributes();
 
-        bl::add_console_log(std::clog, bl::keywords::format = logFormat);
+        auto backend = finnBoost::make_shared<console_backend_type>();
+        backend->add_stream(finnBoost::shared_ptr<std::ostream>(&std::clog, finnBoost::null_deleter()));
+        backend->auto_flush(true);
+        Details::consoleSink = finnBoost::make_shared<console_sink_type>(backend);
+        Details::consoleSink->set_formatter(bl::parse_formatter(logFormat));
+        bl::core::get()->add_sink(Details::consoleSink);
         return;
     }
     BOOST_LOG_SEV(Details::boostLogger, bl::trivial::warning) << "Do not init the logger more than once!";
-}
\ No newline at end of file
+}
+#endif  // FINN_LIGHTWEIGHT_LOGGING
@@ -13,21 +13,98 @@
 #ifndef LOGGING_H
 #define LOGGING_H
 
+#include <atomic>   // for atomic
+#include <chrono>   // for steady_clock
+#include <cstddef>  // for size_t
+#include <ostream>  // for ostream
+#include <string>   // for allocator, string
+
+#ifdef FINN_LIGHTWEIGHT_LOGGING
+    #include <sstream>  // for ostringstream
+
+namespace loglevel {
+    /**
+     * @brief Severities of the lightweight logger, in the order of the Boost.Log trivial severities
+     *
+     */
+    enum severity_level { trace, debug, info, warning, error, fatal };
+}  // namespace loglevel
+
+/**
+ * @brief Logger of builds without Boost.Log (FINN_LIGHTWEIGHT_LOGGING), e.g. for embedded platforms. Writes every record to std::clog, there is no log file. All
+ * copies write through the same lock.
+ *
+ */
+class LightweightLogger {
+     public:
+    /**
+     * @brief Write one record. Thread safe, records of different threads are not interleaved.
+     *
+     * @param severity
+     * @param message
+     */
+    void write(loglevel::severity_level severity, const std::string& message);
+};
+
 /**
- * @brief Define boost logging to be linked dynamically
+ * @brief Abrieviation of the logging type
  *
  */
-// NOLINTNEXTLINE
-#define BOOST_LOG_DYN_LINK 1
-
-// IWYU pragma: no_include <FINNCppDriver/utils/Logger.h>
-#include <boost/log/detail/config.hpp>                // IWYU pragma: keep
-#include <boost/log/sources/severity_feature.hpp>     // IWYU pragma: keep
-#include <boost/log/sources/severity_logger.hpp>      // IWYU pragma: keep
-#include <boost/log/trivial.hpp>                      // IWYU pragma: keep
-#include <boost/smart_ptr/intrusive_ptr.hpp>          // IWYU pragma: keep
-#include <boost/smart_ptr/intrusive_ref_counter.hpp>  // IWYU pragma: keep
-#include <string>                                     // for allocator, string
+using logger_type = LightweightLogger;
+
+/**
+ * @brief One record of the lightweight logger. Collects the streamed message and writes it at the end of the logging statement.
+ *
+ */
+class LightweightRecord {
+     private:
+    logger_type& logger;
+    loglevel::severity_level severity;
+    std::ostringstream stream;
+
+     public:
+    /**
+     * @brief Start a new record
+     *
+     * @param pLogger
+     * @param pSeverity
+     */
+    LightweightRecord(logger_type& pLogger, loglevel::severity_level pSeverity) : logger(pLogger), severity(pSeverity) {}
+    LightweightRecord(LightweightRecord&&) = delete;
+    LightweightRecord(const LightweightRecord&) = delete;
+    LightweightRecord& operator=(LightweightRecord&&) = delete;
+    LightweightRecord& operator=(const LightweightRecord&) = delete;
+    ~LightweightRecord() { logger.write(severity, stream.str()); }
+
+    /**
+     * @brief Get the stream the message is written to
+     *
+     * @return std::ostream&
+     */
+    std::ostream& get() { return stream; }
+};
+
+    /**
+     * @brief Start a record of the given severity
+     *
+     */
+    // NOLINTNEXTLINE
+    #define FINN_LOG_RECORD(LOGGER, SEV) LightweightRecord(LOGGER, SEV).get()
+#else
+    /**
+     * @brief Define boost logging to be linked dynamically
+     *
+     */
+    // NOLINTNEXTLINE
+    #define BOOST_LOG_DYN_LINK 1
+
+    // IWYU pragma: no_include <FINNCppDriver/utils/Logger.h>
+    #include <boost/log/detail/config.hpp>                // IWYU pragma: keep
+    #include <boost/log/sources/severity_feature.hpp>     // IWYU pragma: keep
+    #include <boost/log/sources/severity_logger.hpp>      // IWYU pragma: keep
+    #include <boost/log/trivial.hpp>                      // IWYU pragma: keep
+    #include <boost/smart_ptr/intrusive_ptr.hpp>          // IWYU pragma: keep
+    #include <boost/smart_ptr/intrusive_ref_counter.hpp>  // IWYU pragma: keep
 
 namespace bl = finnBoost::log;
 namespace loglevel = bl::trivial;
@@ -38,12 +115,113 @@ namespace loglevel = bl::trivial;
  */
 using logger_type = bl::sources::severity_logger<bl::trivial::severity_level>;
 
+    /**
+     * @brief Start a record of the given severity
+     *
+     */
+    // NOLINTNEXTLINE
+    #define FINN_LOG_RECORD(LOGGER, SEV) BOOST_LOG_SEV(LOGGER, SEV)
+#endif  // FINN_LIGHTWEIGHT_LOGGING
+
+#ifndef FINN_LOG_MIN_SEVERITY
+    /**
+     * @brief Records with a lower severity are removed at compile time by all FINN logging macros (0 = trace, 1 = debug, 2 = info, 3 = warning, 4 = error, 5 = fatal)
+     *
+     */
+    // NOLINTNEXTLINE
+    #define FINN_LOG_MIN_SEVERITY 0
+#endif  // FINN_LOG_MIN_SEVERITY
+
+/**
+ * @brief Check if records of the given severity are compiled in, @see FINN_LOG_MIN_SEVERITY
+ *
+ * @param severity
+ * @return true
+ * @return false
+ */
+constexpr bool finnLogEnabled(loglevel::severity_level severity) { return static_cast<int>(severity) >= FINN_LOG_MIN_SEVERITY; }
+
+/**
+ * @brief Lets one record per interval through a call site, for messages on hot paths like per transfer messages. Counts the records it drops in between.
+ *
+ */
+class LogRateLimiter {
+     private:
+    std::chrono::steady_clock::duration interval;
+    std::atomic<std::chrono::steady_clock::rep> nextAllowed{0};
+    std::atomic<std::size_t> suppressed{0};
+
+     public:
+    /**
+     * @brief Construct a new Log Rate Limiter object
+     *
+     * @param pInterval Minimum time between two records
+     */
+    explicit LogRateLimiter(std::chrono::steady_clock::duration pInterval) : interval(pInterval) {}
+
+    /**
+     * @brief Check if a record may be written now. Thread safe and lock free.
+     *
+     * @return true
+     * @return false The record has to be dropped
+     */
+    bool allow() {
+        const auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+        auto next = nextAllowed.load(std::memory_order_relaxed);
+        if (now < next || !nextAllowed.compare_exchange_strong(next, now + interval.count(), std::memory_order_relaxed)) {
+            suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Get the number of records dropped since the last call and reset it
+     *
+     * @return std::size_t
+     */
+    std::size_t takeSuppressed() { return suppressed.exchange(0, std::memory_order_relaxed); }
+};
+
+/**
+ * @brief Prefix of a rate limited record that reports the number of records dropped before it
+ *
+ */
+struct LogSuppressed {
+    std::size_t count;
+};
+
+/**
+ * @brief Print a LogSuppressed prefix, nothing if no record was dropped
+ *
+ * @param stream
+ * @param suppressed
+ * @return std::ostream&
+ */
+inline std::ostream& operator<<(std::ostream& stream, const LogSuppressed& suppressed) {
+    if (suppressed.count > 0) {
+        stream << "(" << suppressed.count << " similar messages suppressed) ";
+    }
+    return stream;
+}
+
 /**
- * @brief redefine Boost Logger for FINN
+ * @brief redefine Boost Logger for FINN. Records below FINN_LOG_MIN_SEVERITY are removed at compile time.
  *
  */
 // NOLINTBEGIN
-#define FINN_LOG(LOGGER, SEV) BOOST_LOG_SEV(LOGGER, SEV)
+#define FINN_LOG(LOGGER, SEV)                                                  \
+    for (bool finnLogOnce = finnLogEnabled(SEV); finnLogOnce; finnLogOnce = false) \
+    FINN_LOG_RECORD(LOGGER, SEV)
+
+/**
+ * @brief Like FINN_LOG, but writes at most one record per INTERVAL (a std::chrono duration) and call site. Dropped records are counted in the next written one.
+ *
+ */
+#define FINN_LOG_THROTTLED(LOGGER, SEV, INTERVAL)                                                              \
+    if (static LogRateLimiter finnLogLimiter(INTERVAL); !finnLogEnabled(SEV) || !finnLogLimiter.allow()) { \
+    } else                                                                                                     \
+        FINN_LOG_RECORD(LOGGER, SEV) << LogSuppressed{finnLogLimiter.takeSuppressed()}
 #ifdef NDEBUG
 extern class [[maybe_unused]] DevNull {
 } dev_null;
@@ -67,7 +245,7 @@ DevNull& operator<<(DevNull& dest, [[maybe_unused]] T) {
         // NOLINTEND
 
 /**
- * @brief Singleton class that provides logger functionality for the driver. Based on the boost severity logger
+ * @brief Singleton class that provides logger functionality for the driver. Based on the boost severity logger, or on LightweightLogger with FINN_LIGHTWEIGHT_LOGGING
  *
  */
 class Logger {
@@ -97,16 +275,22 @@ class Logger {
     Logger& operator=(Logger&&) = delete;
 
     /**
-     * @brief Destroy the Logger object
+     * @brief Destroy the Logger object. Writes the records that are still queued by asynchronous sinks.
      *
      */
-    ~Logger() = default;
+    ~Logger();
     /**
      * @brief Move constructor
      *
      */
     Logger(Logger&&) = default;
 
+    /**
+     * @brief Block until all records logged so far are written. With asynchronous logging, records are otherwise written by a background thread some time later.
+     *
+     */
+    static void flush();
+
      private:
     void initLogging();
     Logger();
@@ -0,0 +1,431 @@
+/**
+ * @file MemoryArena.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Monotonic arena for per inference temporaries, optionally backed by hugepages
+ * @version 0.1
+ * @date 2024-02-19
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef MEMORYARENA
+#define MEMORYARENA
+
+#include <FINNCppDriver/utils/Logger.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+    #include <sys/mman.h>
+#endif
+
+namespace Finn {
+    /**
+     * @brief Counters of a MemoryArena
+     *
+     */
+    struct ArenaStats {
+        /**
+         * @brief Number of memory blocks requested from the operating system. Stays constant in steady state.
+         *
+         */
+        std::size_t blockAllocations = 0;
+        /**
+         * @brief Number of allocations served from the arena
+         *
+         */
+        std::size_t allocations = 0;
+        /**
+         * @brief Number of bytes currently handed out (including alignment padding)
+         *
+         */
+        std::size_t bytesInUse = 0;
+        /**
+         * @brief Largest value bytesInUse ever had
+         *
+         */
+        std::size_t highWater = 0;
+        /**
+         * @brief Total size of all blocks
+         *
+         */
+        std::size_t capacity = 0;
+        /**
+         * @brief Number of full resets
+         *
+         */
+        std::size_t resets = 0;
+        /**
+         * @brief True if at least one block is backed by explicit (hugetlbfs) hugepages
+         *
+         */
+        bool hugePages = false;
+    };
+
+    /**
+     * @brief Monotonic (bump pointer) allocator for temporaries that live for one request. Allocations only advance a pointer, deallocations are free, and the whole arena
+     * is released at once with reset() or by a Scope. Memory blocks are requested from the operating system once and kept between requests. If a request needed more than
+     * one block, reset() merges them into a single block, so in steady state the arena does not allocate at all. Blocks are prefaulted when they are created, so no first
+     * touch page faults happen during an inference. Optionally, blocks are backed by 2 MiB hugepages to reduce TLB misses.
+     * @attention Not thread safe. Use one arena per thread (@see threadLocal).
+     *
+     */
+    class MemoryArena {
+         public:
+        /**
+         * @brief Size of a hugepage on x86_64 and aarch64 (with 4 KiB base pages)
+         *
+         */
+        static constexpr std::size_t hugePageSize = 2UL * 1024 * 1024;
+        /**
+         * @brief Default size of the first block
+         *
+         */
+        static constexpr std::size_t defaultBlockSize = hugePageSize;
+        /**
+         * @brief Default alignment of allocations, matches AlignedAllocator
+         *
+         */
+        static constexpr std::size_t defaultAlignment = 64;
+
+        /**
+         * @brief Position in the arena, @see mark and rewind
+         *
+         */
+        struct Marker {
+            std::size_t block = 0;
+            std::size_t offset = 0;
+            std::size_t bytesInUse = 0;
+        };
+
+        /**
+         * @brief Rewinds the arena to the position it had at construction, releasing everything allocated in between. Scopes can be nested.
+         *
+         */
+        class Scope {
+             private:
+            MemoryArena& arena;
+            Marker marker;
+
+             public:
+            /**
+             * @brief Construct a new Scope
+             *
+             * @param pArena
+             */
+            explicit Scope(MemoryArena& pArena) : arena(pArena), marker(pArena.mark()) {}
+            Scope(Scope&&) = delete;
+            Scope(const Scope&) = delete;
+            Scope& operator=(Scope&&) = delete;
+            Scope& operator=(const Scope&) = delete;
+            /**
+             * @brief Destroy the Scope object and rewind the arena
+             *
+             */
+            ~Scope() { arena.rewind(marker); }
+        };
+
+         private:
+        struct Block {
+            std::byte* data = nullptr;
+            std::size_t size = 0;
+            bool mapped = false;
+        };
+
+        std::vector<Block> blocks;
+        std::size_t currentBlock = 0;
+        std::size_t offset = 0;
+        std::size_t blockSize;
+        bool useHugePages;
+        ArenaStats stats;
+
+        /**
+         * @brief A logger prefix to determine the source of a log write
+         *
+         * @return std::string
+         */
+        static std::string loggerPrefix() { return "[MemoryArena] "; }
+
+        /**
+         * @brief Default hugepage setting of the arenas created by threadLocal
+         *
+         * @return std::atomic<bool>&
+         */
+        static std::atomic<bool>& threadLocalHugePages() {
+            static std::atomic<bool> enabled = false;
+            return enabled;
+        }
+
+        static std::size_t roundUp(std::size_t value, std::size_t multiple) { return (value + multiple - 1) / multiple * multiple; }
+
+        /**
+         * @brief Request a new, prefaulted block from the operating system
+         *
+         * @param minBytes
+         * @return Block
+         */
+        Block allocateBlock(std::size_t minBytes) {
+            Block block;
+#ifdef __linux__
+            if (useHugePages) {
+                block.size = roundUp(minBytes, hugePageSize);
+                void* ptr = mmap(nullptr, block.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+                if (ptr != MAP_FAILED) {
+                    stats.hugePages = true;
+                    block.data = static_cast<std::byte*>(ptr);
+                    block.mapped = true;
+                    return block;
+                }
+                FINN_LOG(Logger::getLogger(), loglevel::warning) << loggerPrefix() << "No explicit hugepages available, falling back to transparent hugepages";
+            } else {
+                block.size = roundUp(minBytes, 4096);
+            }
+            void* ptr = mmap(nullptr, block.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (ptr == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            if (useHugePages) {
+                madvise(ptr, block.size, MADV_HUGEPAGE);
+            }
+            block.data = static_cast<std::byte*>(ptr);
+            block.mapped = true;
+#else
+            block.size = roundUp(minBytes, defaultAlignment);
+            block.data = static_cast<std::byte*>(std::aligned_alloc(defaultAlignment, block.size));
+            if (block.data == nullptr) {
+                throw std::bad_alloc();
+            }
+#endif
+            // Prefault, so the first inference does not pay for the page faults
+            std::fill(block.data, block.data + block.size, std::byte{0});
+            return block;
+        }
+
+        static void releaseBlock(Block& block) {
+#ifdef __linux__
+            if (block.mapped) {
+                munmap(block.data, block.size);
+                return;
+            }
+#endif
+            std::free(block.data);
+        }
+
+        void addBlock(std::size_t minBytes) {
+            blocks.push_back(allocateBlock(minBytes));
+            ++stats.blockAllocations;
+            stats.capacity += blocks.back().size;
+        }
+
+         public:
+        /**
+         * @brief Construct a new Memory Arena. The first block is allocated right away.
+         *
+         * @param pBlockSize Size of the first block and minimum size of all further blocks
+         * @param pUseHugePages Back the blocks with 2 MiB hugepages. Uses explicit hugepages if the system has some reserved, transparent hugepages otherwise.
+         */
+        explicit MemoryArena(std::size_t pBlockSize = defaultBlockSize, bool pUseHugePages = false) : blockSize(std::max<std::size_t>(pBlockSize, defaultAlignment)), useHugePages(pUseHugePages) {
+            addBlock(blockSize);
+        }
+
+        /**
+         * @brief Destroy the Memory Arena object and return all blocks to the operating system
+         *
+         */
+        ~MemoryArena() {
+            for (auto&& block : blocks) {
+                releaseBlock(block);
+            }
+        }
+
+        MemoryArena(MemoryArena&&) = delete;
+        MemoryArena(const MemoryArena&) = delete;
+        MemoryArena& operator=(MemoryArena&&) = delete;
+        MemoryArena& operator=(const MemoryArena&) = delete;
+
+        /**
+         * @brief Allocate memory that stays valid until the arena is reset or rewound past it
+         *
+         * @param bytes
+         * @param alignment Power of two
+         * @return void*
+         */
+        [[nodiscard]] void* allocate(std::size_t bytes, std::size_t alignment = defaultAlignment) {
+            while (true) {
+                Block& block = blocks[currentBlock];
+                const auto address = reinterpret_cast<std::uintptr_t>(block.data) + offset;
+                const std::size_t padding = (alignment - (address % alignment)) % alignment;
+                if (offset + padding + bytes <= block.size) {
+                    offset += padding + bytes;
+                    stats.bytesInUse += padding + bytes;
+                    stats.highWater = std::max(stats.highWater, stats.bytesInUse);
+                    ++stats.allocations;
+                    return block.data + offset - bytes;
+                }
+                // The rest of the current block is skipped and counts as used until the next reset
+                stats.bytesInUse += block.size - offset;
+                if (currentBlock + 1 == blocks.size()) {
+                    addBlock(std::max(blockSize, bytes + alignment));
+                }
+                ++currentBlock;
+                offset = 0;
+            }
+        }
+
+        /**
+         * @brief Release everything allocated from the arena. If more than one block was needed, they are replaced by a single block that fits all of them.
+         *
+         */
+        void reset() {
+            if (blocks.size() > 1) {
+                const std::size_t total = stats.capacity;
+                for (auto&& block : blocks) {
+                    releaseBlock(block);
+                }
+                blocks.clear();
+                stats.capacity = 0;
+                addBlock(total);
+            }
+            currentBlock = 0;
+            offset = 0;
+            stats.bytesInUse = 0;
+            ++stats.resets;
+        }
+
+        /**
+         * @brief Get the current position of the arena
+         *
+         * @return Marker
+         */
+        Marker mark() const { return {currentBlock, offset, stats.bytesInUse}; }
+
+        /**
+         * @brief Release everything that was allocated after the given position. Rewinding to the start of the arena is a reset().
+         *
+         * @param marker
+         */
+        void rewind(const Marker& marker) {
+            if (marker.block == 0 && marker.offset == 0) {
+                reset();
+                return;
+            }
+            currentBlock = marker.block;
+            offset = marker.offset;
+            stats.bytesInUse = marker.bytesInUse;
+        }
+
+        /**
+         * @brief Get the counters of the arena
+         *
+         * @return const ArenaStats&
+         */
+        const ArenaStats& getStats() const { return stats; }
+
+        /**
+         * @brief Arena of the calling thread, created on first use
+         *
+         * @return MemoryArena&
+         */
+        static MemoryArena& threadLocal() {
+            thread_local MemoryArena arena(defaultBlockSize, threadLocalHugePages().load(std::memory_order_relaxed));
+            return arena;
+        }
+
+        /**
+         * @brief Back the arenas that threadLocal creates from now on with hugepages
+         *
+         * @param enabled
+         */
+        static void setThreadLocalHugePages(bool enabled) { threadLocalHugePages().store(enabled, std::memory_order_relaxed); }
+    };
+
+    /**
+     * @brief STL allocator that draws from a MemoryArena. Deallocation does nothing, the memory is released with the arena.
+     *
+     * @tparam T
+     */
+    template<typename T>
+    class ArenaAllocator {
+         private:
+        MemoryArena* arena;
+
+        template<typename U>
+        friend class ArenaAllocator;
+
+         public:
+        /**
+         * @brief Value type of the allocator
+         *
+         */
+        using value_type = T;
+
+        /**
+         * @brief Construct a new Arena Allocator object
+         *
+         * @param pArena
+         */
+        explicit ArenaAllocator(MemoryArena& pArena) noexcept : arena(&pArena) {}
+
+        /**
+         * @brief Construct a new Arena Allocator object for another type on the same arena
+         *
+         * @tparam U
+         * @param other
+         */
+        template<typename U>
+        // NOLINTNEXTLINE
+        ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+        /**
+         * @brief Allocate n elements
+         *
+         * @param n
+         * @return T*
+         */
+        [[nodiscard]] T* allocate(std::size_t n) {
+            if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+                throw std::bad_array_new_length();
+            }
+            return static_cast<T*>(arena->allocate(n * sizeof(T), std::max(alignof(T), MemoryArena::defaultAlignment)));
+        }
+
+        /**
+         * @brief Does nothing, the memory is released with the arena
+         *
+         */
+        void deallocate(T* /*p*/, std::size_t /*n*/) noexcept {}
+
+        /**
+         * @brief Allocators are equal if they draw from the same arena
+         *
+         * @tparam U
+         * @param other
+         * @return true
+         * @return false
+         */
+        template<typename U>
+        bool operator==(const ArenaAllocator<U>& other) const noexcept {
+            return arena == other.arena;
+        }
+    };
+
+    /**
+     * @brief Vector whose storage lives in a MemoryArena
+     *
+     * @tparam T
+     */
+    template<typename T>
+    using arena_vector = std::vector<T, ArenaAllocator<T>>;
+}  // namespace Finn
+
+#endif  // MEMORYARENA
@@ -0,0 +1,319 @@
+/**
+ * @file MemoryBudget.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Sizing of the host memory of a driver to a budget, and the footprint the buffers of a driver currently have
+ * @version 0.1
+ * @date 2024-03-14
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef MEMORYBUDGET
+#define MEMORYBUDGET
+
+#include <FINNCppDriver/utils/FinnUtils.h>
+#include <FINNCppDriver/utils/Types.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Finn {
+    /**
+     * @brief Host memory held by one device buffer
+     *
+     */
+    struct BufferFootprint {
+        /**
+         * @brief Kernel name of the buffer
+         *
+         */
+        std::string kernelName;
+        /**
+         * @brief Direction of the buffer
+         *
+         */
+        IO ioMode = IO::INPUT;
+        /**
+         * @brief Host side of the XRT buffer objects, summed over all buffer slots
+         *
+         */
+        std::size_t bufferObjectBytes = 0;
+        /**
+         * @brief Ring buffer of an asynchronous buffer
+         *
+         */
+        std::size_t ringBufferBytes = 0;
+        /**
+         * @brief Results currently held by the archive of an asynchronous output
+         *
+         */
+        std::size_t archiveBytes = 0;
+        /**
+         * @brief Cap of the archive of an asynchronous output, 0 if unbounded
+         *
+         */
+        std::size_t archiveCapacity = 0;
+
+        /**
+         * @brief Memory currently held
+         *
+         * @return std::size_t
+         */
+        std::size_t total() const { return bufferObjectBytes + ringBufferBytes + archiveBytes; }
+    };
+
+    /**
+     * @brief Host memory held by the buffers of one device
+     *
+     */
+    struct DeviceFootprint {
+        /**
+         * @brief XRT device index
+         *
+         */
+        unsigned int deviceIndex = 0;
+        /**
+         * @brief One entry per allocated idma and odma, empty while the buffers of the device are not allocated
+         *
+         */
+        std::vector<BufferFootprint> buffers;
+
+        /**
+         * @brief Memory currently held by all buffers of the device
+         *
+         * @return std::size_t
+         */
+        std::size_t total() const {
+            std::size_t sum = 0;
+            for (auto&& buffer : buffers) {
+                sum += buffer.total();
+            }
+            return sum;
+        }
+    };
+
+    /**
+     * @brief Host memory of a driver
+     *
+     */
+    struct MemoryFootprint {
+        /**
+         * @brief One entry per device
+         *
+         */
+        std::vector<DeviceFootprint> devices;
+        /**
+         * @brief Staging memory reserved for the packed inputs of asynchronous requests
+         *
+         */
+        std::size_t stagingBytes = 0;
+        /**
+         * @brief Budget of the driver, 0 if unbounded
+         *
+         */
+        std::size_t budget = 0;
+
+        /**
+         * @brief Memory of all devices plus the staging memory
+         *
+         * @return std::size_t
+         */
+        std::size_t total() const {
+            std::size_t sum = stagingBytes;
+            for (auto&& device : devices) {
+                sum += device.total();
+            }
+            return sum;
+        }
+    };
+
+    /**
+     * @brief Format a footprint as a table, one line per buffer
+     *
+     * @param footprint
+     * @return std::string
+     */
+    inline std::string formatMemoryFootprint(const MemoryFootprint& footprint) {
+        constexpr double bytesPerMB = 1e6;
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2);
+        out << "host memory: " << static_cast<double>(footprint.total()) / bytesPerMB << "MB";
+        if (footprint.budget > 0) {
+            out << " of " << static_cast<double>(footprint.budget) / bytesPerMB << "MB budget";
+        }
+        out << " (staging " << static_cast<double>(footprint.stagingBytes) / bytesPerMB << "MB)\n";
+        for (auto&& device : footprint.devices) {
+            out << "device " << device.deviceIndex << ": " << static_cast<double>(device.total()) / bytesPerMB << "MB\n";
+            out << std::left << std::setw(48) << "  buffer" << std::right << std::setw(14) << "bo[MB]" << std::setw(14) << "ring[MB]" << std::setw(14) << "archive[MB]" << std::setw(14) << "cap[MB]" << "\n";
+            for (auto&& buffer : device.buffers) {
+                out << std::left << std::setw(48) << ("  " + buffer.kernelName) << std::right << std::setw(14) << static_cast<double>(buffer.bufferObjectBytes) / bytesPerMB << std::setw(14)
+                    << static_cast<double>(buffer.ringBufferBytes) / bytesPerMB << std::setw(14) << static_cast<double>(buffer.archiveBytes) / bytesPerMB << std::setw(14)
+                    << static_cast<double>(buffer.archiveCapacity) / bytesPerMB << "\n";
+            }
+        }
+        return out.str();
+    }
+
+    /**
+     * @brief Memory a buffer of the config will need, in terms of its settings
+     *
+     */
+    struct BufferDemand {
+        /**
+         * @brief Kernel name of the buffer
+         *
+         */
+        std::string kernelName;
+        /**
+         * @brief Direction of the buffer
+         *
+         */
+        IO ioMode = IO::INPUT;
+        /**
+         * @brief True for synchronous buffers, which allocate one buffer object per slot for the whole batch. Asynchronous buffers have one buffer object and a ring buffer,
+         * both for the whole batch.
+         *
+         */
+        bool synchronous = true;
+        /**
+         * @brief Packed bytes of one sample
+         *
+         */
+        std::size_t bytesPerSample = 0;
+        /**
+         * @brief Configured archive cap of an asynchronous output, 0 if unbounded
+         *
+         */
+        std::size_t archiveCapacity = 0;
+        /**
+         * @brief True if the buffer objects of a synchronous buffer are sub-buffers of a device memory arena, which are sized exactly instead of to a power of two
+         *
+         */
+        bool fromArena = false;
+
+        /**
+         * @brief Memory of the buffer without its archive
+         *
+         * @param maxBatch Batch size the buffer is allocated for
+         * @param slots Number of buffer slots of synchronous buffers
+         * @return std::size_t
+         */
+        std::size_t bytes(unsigned int maxBatch, unsigned int slots) const {
+            if (synchronous) {
+                return (fromArena ? FinnUtils::getAlignedBufferSize(bytesPerSample * maxBatch) : FinnUtils::getActualBufferSize(bytesPerSample * maxBatch)) * slots;
+            }
+            return FinnUtils::getActualBufferSize(bytesPerSample * maxBatch) + bytesPerSample * maxBatch;
+        }
+
+        /**
+         * @brief Check if the buffer keeps results in an archive
+         *
+         * @return true
+         * @return false
+         */
+        bool archives() const { return !synchronous && ioMode == IO::OUTPUT; }
+    };
+
+    /**
+     * @brief Settings that fit a budget
+     *
+     */
+    struct MemoryPlan {
+        /**
+         * @brief Number of buffer slots of synchronous buffers
+         *
+         */
+        unsigned int bufferSlots = 1;
+        /**
+         * @brief Archive cap of every asynchronous output, 0 to keep the configured caps (only if no budget is set)
+         *
+         */
+        std::size_t archiveCapacity = 0;
+        /**
+         * @brief Memory the driver needs at most with these settings
+         *
+         */
+        std::size_t bytes = 0;
+        /**
+         * @brief True if the settings were reduced to fit the budget
+         *
+         */
+        bool degraded = false;
+    };
+
+    /**
+     * @brief Size the buffers of a driver to a budget. The batch size is never reduced, as callers rely on it. Unbounded archives always get a cap, as they could
+     * grow beyond any budget. With MEMORY_POLICY::DEGRADE buffer slots are given up first, then the archives are shrunk to the memory that is left, but never below
+     * one sample.
+     *
+     * @param demands One entry per buffer of the driver
+     * @param maxBatch Batch size the buffers are allocated for
+     * @param slots Requested number of buffer slots
+     * @param stagingBytes Staging memory needed in addition to the buffers
+     * @param budget Memory budget in bytes, 0 if unbounded
+     * @param policy
+     * @return MemoryPlan
+     * @throws std::runtime_error If the settings do not fit the budget and cannot be reduced any further
+     */
+    inline MemoryPlan planMemory(const std::vector<BufferDemand>& demands, unsigned int maxBatch, unsigned int slots, std::size_t stagingBytes, std::size_t budget, MEMORY_POLICY policy) {
+        auto withoutArchives = [&](unsigned int bufferSlots) {
+            std::size_t sum = stagingBytes;
+            for (auto&& demand : demands) {
+                sum += demand.bytes(maxBatch, bufferSlots);
+            }
+            return sum;
+        };
+        std::size_t archives = 0;
+        std::size_t smallestArchive = 0;
+        // Smallest configured cap, 0 if all archives are unbounded
+        std::size_t configuredArchive = 0;
+        for (auto&& demand : demands) {
+            if (demand.archives()) {
+                ++archives;
+                smallestArchive = std::max(smallestArchive, demand.bytesPerSample);
+                if (demand.archiveCapacity > 0) {
+                    configuredArchive = (configuredArchive == 0) ? demand.archiveCapacity : std::min(configuredArchive, demand.archiveCapacity);
+                }
+            }
+        }
+
+        MemoryPlan plan;
+        plan.bufferSlots = slots;
+        if (budget == 0) {
+            plan.bytes = withoutArchives(slots) + archives * configuredArchive;
+            return plan;
+        }
+        const std::size_t archiveMinimum = archives * smallestArchive;
+        if (policy == MEMORY_POLICY::DEGRADE) {
+            while (plan.bufferSlots > 1 && withoutArchives(plan.bufferSlots) + archiveMinimum > budget) {
+                --plan.bufferSlots;
+                plan.degraded = true;
+            }
+        }
+        const std::size_t needed = withoutArchives(plan.bufferSlots) + archiveMinimum;
+        if (needed > budget) {
+            FinnUtils::logAndError<std::runtime_error>("The host buffers need " + std::to_string(needed) + " bytes for a batch size of " + std::to_string(maxBatch) + " and " + std::to_string(plan.bufferSlots) +
+                                                       " buffer slot(s), which exceeds the memory budget of " + std::to_string(budget) + " bytes!");
+        }
+        if (archives > 0) {
+            const std::size_t share = (budget - withoutArchives(plan.bufferSlots)) / archives;
+            if (configuredArchive > share && policy != MEMORY_POLICY::DEGRADE) {
+                FinnUtils::logAndError<std::runtime_error>("The archives of the asynchronous outputs need " + std::to_string(configuredArchive) + " bytes each, but only " + std::to_string(share) +
+                                                           " bytes per archive are left in the memory budget of " + std::to_string(budget) + " bytes!");
+            }
+            plan.degraded = plan.degraded || configuredArchive > share;
+            plan.archiveCapacity = (configuredArchive == 0) ? share : std::min(configuredArchive, share);
+        }
+        plan.bytes = withoutArchives(plan.bufferSlots) + archives * plan.archiveCapacity;
+        return plan;
+    }
+}  // namespace Finn
+
+#endif  // MEMORYBUDGET
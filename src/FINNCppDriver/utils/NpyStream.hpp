@@ -0,0 +1,300 @@
+/**
+ * @file NpyStream.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Chunked reading and writing of .npy files that do not have to fit into memory
+ * @version 0.1
+ * @date 2024-03-01
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef NPYSTREAM
+#define NPYSTREAM
+
+#include <FINNCppDriver/utils/FinnUtils.h>
+#include <FINNCppDriver/utils/Types.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Finn {
+    /**
+     * @brief Numpy type string of T, e.g. "<f4" for float
+     *
+     * @tparam T
+     * @return std::string
+     */
+    template<typename T>
+    std::string npyTypestring() {
+        static_assert(std::is_arithmetic_v<T>, "Only arithmetic types can be stored in a npy file");
+        char kind = 'u';
+        if constexpr (std::is_same_v<T, bool>) {
+            kind = 'b';
+        } else if constexpr (std::is_floating_point_v<T>) {
+            kind = 'f';
+        } else if constexpr (std::is_signed_v<T>) {
+            kind = 'i';
+        }
+        return std::string(sizeof(T) == 1 ? "|" : "<") + kind + std::to_string(sizeof(T));
+    }
+
+    namespace detail {
+        /**
+         * @brief Magic string every npy file starts with
+         *
+         */
+        constexpr std::array<char, 6> npyMagic = {'\x93', 'N', 'U', 'M', 'P', 'Y'};
+        /**
+         * @brief Alignment of the end of the npy header, as required by the format
+         *
+         */
+        constexpr std::size_t npyHeaderAlignment = 64;
+    }  // namespace detail
+
+    /**
+     * @brief Reads the array of a C-ordered .npy file in chunks along its first axis. Only the header is parsed up front, so the file can be larger than the memory.
+     *
+     */
+    class NpyReader {
+         private:
+        std::ifstream stream;
+        std::string typestring;
+        shape_t shape;
+        std::size_t itemSize = 0;
+        std::size_t elementsRead = 0;
+
+        static std::string loggerPrefix() { return "[NpyReader] "; }
+
+        void parseHeader(const std::string& header) {
+            auto valueOf = [&header](const std::string& key) {
+                const auto pos = header.find("'" + key + "'");
+                if (pos == std::string::npos) {
+                    FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Key " + key + " is missing in the npy header!");
+                }
+                return header.find(':', pos) + 1;
+            };
+
+            const auto descrBegin = header.find('\'', valueOf("descr")) + 1;
+            typestring = header.substr(descrBegin, header.find('\'', descrBegin) - descrBegin);
+            if (typestring.size() < 3) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Invalid type string " + typestring + " in the npy header!");
+            }
+            if (typestring[0] == '>') {
+                FinnUtils::logAndError<std::runtime_error>("At the moment only files created on little endian systems are supported!\n");
+            }
+            itemSize = std::stoul(typestring.substr(2));
+
+            if (header.compare(header.find_first_not_of(' ', valueOf("fortran_order")), 4, "True") == 0) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Fortran ordered npy files can not be read in chunks!");
+            }
+
+            const auto shapeBegin = header.find('(', valueOf("shape")) + 1;
+            const auto shapeEnd = header.find(')', shapeBegin);
+            const std::string dims = header.substr(shapeBegin, shapeEnd - shapeBegin);
+            for (std::size_t pos = 0; pos < dims.size();) {
+                const auto next = dims.find(',', pos);
+                const auto dim = dims.substr(pos, next - pos);
+                if (dim.find_first_not_of(' ') != std::string::npos) {
+                    shape.push_back(std::stoul(dim));
+                }
+                if (next == std::string::npos) {
+                    break;
+                }
+                pos = next + 1;
+            }
+        }
+
+         public:
+        /**
+         * @brief Open the file and parse its header
+         *
+         * @param path
+         */
+        explicit NpyReader(const std::filesystem::path& path) : stream(path, std::ifstream::binary) {
+            if (!stream) {
+                FinnUtils::logAndError<std::runtime_error>("io error: failed to open a file.");
+            }
+            std::array<char, detail::npyMagic.size()> magic{};
+            stream.read(magic.data(), magic.size());
+            if (!stream || magic != detail::npyMagic) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + path.string() + " is not a npy file!");
+            }
+            std::array<unsigned char, 2> version{};
+            stream.read(reinterpret_cast<char*>(version.data()), version.size());
+            // Version 1 stores the header length in 2 bytes, versions 2 and 3 in 4 bytes, all little endian
+            const std::size_t lengthBytes = (version[0] == 1) ? 2 : 4;
+            std::array<unsigned char, 4> length{};
+            stream.read(reinterpret_cast<char*>(length.data()), static_cast<std::streamsize>(lengthBytes));
+            std::size_t headerLength = 0;
+            for (std::size_t i = lengthBytes; i > 0; --i) {
+                headerLength = (headerLength << 8) | length[i - 1];
+            }
+            std::string header(headerLength, '\0');
+            stream.read(header.data(), static_cast<std::streamsize>(headerLength));
+            if (!stream) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Truncated header in " + path.string() + "!");
+            }
+            parseHeader(header);
+        }
+
+        /**
+         * @brief Numpy type string of the stored values, e.g. "<f4"
+         *
+         * @return const std::string&
+         */
+        const std::string& getTypestring() const { return typestring; }
+
+        /**
+         * @brief Shape of the stored array
+         *
+         * @return const shape_t&
+         */
+        const shape_t& getShape() const { return shape; }
+
+        /**
+         * @brief Size of one stored value in bytes
+         *
+         * @return std::size_t
+         */
+        std::size_t getItemSize() const { return itemSize; }
+
+        /**
+         * @brief Number of stored values
+         *
+         * @return std::size_t
+         */
+        std::size_t elements() const { return std::accumulate(shape.begin(), shape.end(), std::size_t{1}, std::multiplies<>()); }
+
+        /**
+         * @brief Number of values that were not read yet
+         *
+         * @return std::size_t
+         */
+        std::size_t remaining() const { return elements() - elementsRead; }
+
+        /**
+         * @brief Read the next values into the given buffer. T has to match the type string of the file.
+         *
+         * @tparam T
+         * @param out Filled with up to out.size() values
+         * @return std::size_t Number of values read, 0 at the end of the array
+         */
+        template<typename T>
+        std::size_t read(std::span<T> out) {
+            if (sizeof(T) != itemSize) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Reading values of " + std::to_string(sizeof(T)) + " bytes from a npy file of type " + typestring + "!");
+            }
+            const std::size_t count = std::min(out.size(), remaining());
+            stream.read(reinterpret_cast<char*>(out.data()), static_cast<std::streamsize>(count * sizeof(T)));
+            if (static_cast<std::size_t>(stream.gcount()) != count * sizeof(T)) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "The npy file ended before all values announced in its header were read!");
+            }
+            elementsRead += count;
+            return count;
+        }
+    };
+
+    /**
+     * @brief Writes a .npy file incrementally. The shape is fixed when the file is created, the values are appended in chunks.
+     *
+     */
+    class NpyWriter {
+         private:
+        std::ofstream stream;
+        std::string typestring;
+        std::size_t expectedElements;
+        std::size_t elementsWritten = 0;
+
+        static std::string loggerPrefix() { return "[NpyWriter] "; }
+
+         public:
+        /**
+         * @brief Create the file and write its header
+         *
+         * @param path
+         * @param pTypestring Numpy type string of the values, @see npyTypestring
+         * @param shape Shape of the whole array
+         */
+        NpyWriter(const std::filesystem::path& path, const std::string& pTypestring, const shape_t& shape)
+            : stream(path, std::ofstream::binary), typestring(pTypestring), expectedElements(std::accumulate(shape.begin(), shape.end(), std::size_t{1}, std::multiplies<>())) {
+            if (!stream) {
+                FinnUtils::logAndError<std::runtime_error>("io error: failed to open a file.");
+            }
+            std::string dims;
+            for (auto dim : shape) {
+                dims += (dims.empty() ? "" : ", ") + std::to_string(dim);
+            }
+            if (shape.size() == 1) {
+                dims += ",";
+            }
+            std::string header = "{'descr': '" + typestring + "', 'fortran_order': False, 'shape': (" + dims + "), }";
+            // Magic, version and the 4 byte length precede the header, which is padded with spaces and terminated by a newline
+            constexpr std::size_t preamble = detail::npyMagic.size() + 2 + 4;
+            const std::size_t total = (preamble + header.size() + 1 + detail::npyHeaderAlignment - 1) / detail::npyHeaderAlignment * detail::npyHeaderAlignment;
+            header.append(total - preamble - header.size() - 1, ' ');
+            header.push_back('\n');
+
+            stream.write(detail::npyMagic.data(), detail::npyMagic.size());
+            const std::array<char, 2> version = {2, 0};
+            stream.write(version.data(), version.size());
+            const auto length = static_cast<std::uint32_t>(header.size());
+            const std::array<char, 4> lengthBytes = {static_cast<char>(length & 0xFF), static_cast<char>((length >> 8) & 0xFF), static_cast<char>((length >> 16) & 0xFF), static_cast<char>((length >> 24) & 0xFF)};
+            stream.write(lengthBytes.data(), lengthBytes.size());
+            stream.write(header.data(), static_cast<std::streamsize>(header.size()));
+        }
+
+        /**
+         * @brief Append values. T has to match the type string the file was created with.
+         *
+         * @tparam T
+         * @param values
+         */
+        template<typename T>
+        void append(std::span<const T> values) {
+            if (npyTypestring<T>() != typestring) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Appending values of type " + npyTypestring<T>() + " to a npy file of type " + typestring + "!");
+            }
+            if (elementsWritten + values.size() > expectedElements) {
+                FinnUtils::logAndError<std::length_error>(loggerPrefix() + "Appending more values than the shape of the npy file holds!");
+            }
+            stream.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size_bytes()));
+            if (!stream) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Writing to the npy file failed!");
+            }
+            elementsWritten += values.size();
+        }
+
+        /**
+         * @brief Flush and close the file
+         *
+         */
+        void close() {
+            if (elementsWritten != expectedElements) {
+                FinnUtils::logAndError<std::length_error>(loggerPrefix() + "Closing a npy file after " + std::to_string(elementsWritten) + " of " + std::to_string(expectedElements) + " values were written!");
+            }
+            stream.close();
+        }
+
+        /**
+         * @brief Number of values written so far
+         *
+         * @return std::size_t
+         */
+        std::size_t written() const { return elementsWritten; }
+    };
+}  // namespace Finn
+
+#endif  // NPYSTREAM
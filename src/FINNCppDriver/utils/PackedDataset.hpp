@@ -0,0 +1,306 @@
+/**
+ * @file PackedDataset.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief File format for data that is already packed into the device format of an input or output buffer
+ * @version 0.1
+ * @date 2024-03-04
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef PACKEDDATASET
+#define PACKEDDATASET
+
+#include <FINNCppDriver/utils/ConfigurationStructs.h>
+#include <FINNCppDriver/utils/FinnUtils.h>
+#include <FINNCppDriver/utils/Types.h>
+
+#include <FINNCppDriver/utils/FinnDatatypes.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+namespace Finn {
+    /**
+     * @brief Describe a FINN datatype, so that packed data can only be used with the datatype it was packed for
+     *
+     * @tparam D
+     * @return json
+     */
+    template<typename D>
+    json describeDatatype() {
+        return {{"bitwidth", D().bitwidth()}, {"signed", D().sign()}, {"integer", D().isInteger()}, {"fixedPoint", D().isFixedPoint()}, {"min", D().min()}, {"max", D().max()}};
+    }
+
+    /**
+     * @brief Header of a packed dataset. The data following it consists of samples of bytesPerSample packed bytes each.
+     *
+     */
+    struct PackedDatasetHeader {
+        /**
+         * @brief "input" for data packed for an idma, "output" for results read from an odma
+         *
+         */
+        std::string kind;
+        /**
+         * @brief Description of the FINN datatype, @see describeDatatype
+         *
+         */
+        json datatype;
+        /**
+         * @brief Folded shape of one sample
+         *
+         */
+        shapeFolded_t foldedShape;
+        /**
+         * @brief Packed shape of one sample
+         *
+         */
+        shapePacked_t packedShape;
+        /**
+         * @brief Number of stored samples
+         *
+         */
+        std::size_t samples = 0;
+
+        /**
+         * @brief Number of packed bytes per sample
+         *
+         * @return std::size_t
+         */
+        std::size_t bytesPerSample() const { return FinnUtils::shapeToElements(packedShape); }
+
+        /**
+         * @brief Check that data with this header can be used for the given buffer and datatype
+         *
+         * @param pKind "input" or "output"
+         * @param pDatatype @see describeDatatype
+         * @param descriptor Buffer the data is used for
+         */
+        void validate(const std::string& pKind, const json& pDatatype, const ExtendedBufferDescriptor& descriptor) const {
+            if (kind != pKind) {
+                FinnUtils::logAndError<std::runtime_error>("Packed dataset holds " + kind + " data, but " + pKind + " data is required!");
+            }
+            if (datatype != pDatatype) {
+                FinnUtils::logAndError<std::runtime_error>("Packed dataset was packed for datatype " + datatype.dump() + ", but the driver uses " + pDatatype.dump() + "!");
+            }
+            if (foldedShape != descriptor.foldedShape || packedShape != descriptor.packedShape) {
+                FinnUtils::logAndError<std::runtime_error>("Shapes of the packed dataset do not match buffer " + descriptor.kernelName + "!");
+            }
+        }
+    };
+
+    /**
+     * @brief PackedDatasetHeader -> JSON
+     *
+     * @param j
+     * @param header
+     */
+    // NOLINTNEXTLINE
+    inline void to_json(json& j, const PackedDatasetHeader& header) {
+        j = json{{"kind", header.kind}, {"datatype", header.datatype}, {"foldedShape", header.foldedShape}, {"packedShape", header.packedShape}, {"samples", header.samples}};
+    }
+
+    /**
+     * @brief JSON -> PackedDatasetHeader
+     *
+     * @param j
+     * @param header
+     */
+    // NOLINTNEXTLINE
+    inline void from_json(const json& j, PackedDatasetHeader& header) {
+        j.at("kind").get_to(header.kind);
+        header.datatype = j.at("datatype");
+        j.at("foldedShape").get_to(header.foldedShape);
+        j.at("packedShape").get_to(header.packedShape);
+        j.at("samples").get_to(header.samples);
+    }
+
+    namespace detail {
+        /**
+         * @brief Magic string every packed dataset starts with
+         *
+         */
+        constexpr std::array<char, 8> packedDatasetMagic = {'F', 'I', 'N', 'N', 'P', 'A', 'C', 'K'};
+        /**
+         * @brief Format version, stored after the magic
+         *
+         */
+        constexpr std::uint32_t packedDatasetVersion = 1;
+        /**
+         * @brief The packed data starts at a multiple of this
+         *
+         */
+        constexpr std::size_t packedDatasetAlignment = 64;
+
+        inline void writeU32(std::ostream& stream, std::uint32_t value) {
+            const std::array<char, 4> bytes = {static_cast<char>(value & 0xFF), static_cast<char>((value >> 8) & 0xFF), static_cast<char>((value >> 16) & 0xFF), static_cast<char>((value >> 24) & 0xFF)};
+            stream.write(bytes.data(), bytes.size());
+        }
+
+        inline std::uint32_t readU32(std::istream& stream) {
+            std::array<unsigned char, 4> bytes{};
+            stream.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+            return static_cast<std::uint32_t>(bytes[0]) | (static_cast<std::uint32_t>(bytes[1]) << 8) | (static_cast<std::uint32_t>(bytes[2]) << 16) | (static_cast<std::uint32_t>(bytes[3]) << 24);
+        }
+    }  // namespace detail
+
+    /**
+     * @brief Check if the file is a packed dataset
+     *
+     * @param path
+     * @return true
+     * @return false
+     */
+    inline bool isPackedDataset(const std::filesystem::path& path) {
+        std::ifstream stream(path, std::ifstream::binary);
+        std::array<char, detail::packedDatasetMagic.size()> magic{};
+        stream.read(magic.data(), magic.size());
+        return stream && magic == detail::packedDatasetMagic;
+    }
+
+    /**
+     * @brief Reads a packed dataset sample by sample
+     *
+     */
+    class PackedDatasetReader {
+         private:
+        std::ifstream stream;
+        PackedDatasetHeader header;
+        std::size_t samplesRead = 0;
+
+        static std::string loggerPrefix() { return "[PackedDatasetReader] "; }
+
+         public:
+        /**
+         * @brief Open the file and parse its header
+         *
+         * @param path
+         */
+        explicit PackedDatasetReader(const std::filesystem::path& path) : stream(path, std::ifstream::binary) {
+            if (!stream) {
+                FinnUtils::logAndError<std::runtime_error>("io error: failed to open a file.");
+            }
+            std::array<char, detail::packedDatasetMagic.size()> magic{};
+            stream.read(magic.data(), magic.size());
+            if (!stream || magic != detail::packedDatasetMagic) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + path.string() + " is not a packed dataset!");
+            }
+            if (const auto version = detail::readU32(stream); version != detail::packedDatasetVersion) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Unsupported packed dataset version " + std::to_string(version) + "!");
+            }
+            std::string text(detail::readU32(stream), '\0');
+            stream.read(text.data(), static_cast<std::streamsize>(text.size()));
+            if (!stream) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Truncated header in " + path.string() + "!");
+            }
+            header = json::parse(text).get<PackedDatasetHeader>();
+        }
+
+        /**
+         * @brief Get the header of the dataset
+         *
+         * @return const PackedDatasetHeader&
+         */
+        const PackedDatasetHeader& getHeader() const { return header; }
+
+        /**
+         * @brief Number of samples that were not read yet
+         *
+         * @return std::size_t
+         */
+        std::size_t remaining() const { return header.samples - samplesRead; }
+
+        /**
+         * @brief Read as many whole samples as fit into the buffer
+         *
+         * @param out
+         * @return std::size_t Number of samples read, 0 at the end of the dataset
+         */
+        std::size_t read(std::span<uint8_t> out) {
+            const std::size_t count = std::min(out.size() / header.bytesPerSample(), remaining());
+            const std::size_t bytes = count * header.bytesPerSample();
+            stream.read(reinterpret_cast<char*>(out.data()), static_cast<std::streamsize>(bytes));
+            if (static_cast<std::size_t>(stream.gcount()) != bytes) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "The packed dataset ended before all samples announced in its header were read!");
+            }
+            samplesRead += count;
+            return count;
+        }
+    };
+
+    /**
+     * @brief Writes a packed dataset incrementally. The number of samples is fixed when the file is created.
+     *
+     */
+    class PackedDatasetWriter {
+         private:
+        std::ofstream stream;
+        PackedDatasetHeader header;
+        std::size_t samplesWritten = 0;
+
+        static std::string loggerPrefix() { return "[PackedDatasetWriter] "; }
+
+         public:
+        /**
+         * @brief Create the file and write its header
+         *
+         * @param path
+         * @param pHeader
+         */
+        PackedDatasetWriter(const std::filesystem::path& path, const PackedDatasetHeader& pHeader) : stream(path, std::ofstream::binary), header(pHeader) {
+            if (!stream) {
+                FinnUtils::logAndError<std::runtime_error>("io error: failed to open a file.");
+            }
+            std::string text = json(header).dump();
+            constexpr std::size_t preamble = detail::packedDatasetMagic.size() + 2 * sizeof(std::uint32_t);
+            const std::size_t total = (preamble + text.size() + detail::packedDatasetAlignment - 1) / detail::packedDatasetAlignment * detail::packedDatasetAlignment;
+            text.append(total - preamble - text.size(), ' ');
+            stream.write(detail::packedDatasetMagic.data(), detail::packedDatasetMagic.size());
+            detail::writeU32(stream, detail::packedDatasetVersion);
+            detail::writeU32(stream, static_cast<std::uint32_t>(text.size()));
+            stream.write(text.data(), static_cast<std::streamsize>(text.size()));
+        }
+
+        /**
+         * @brief Append whole samples
+         *
+         * @param packed A multiple of bytesPerSample bytes
+         */
+        void append(std::span<const uint8_t> packed) {
+            if (packed.size() % header.bytesPerSample() != 0) {
+                FinnUtils::logAndError<std::length_error>(loggerPrefix() + "Appending " + std::to_string(packed.size()) + " bytes, which is not a multiple of the sample size " + std::to_string(header.bytesPerSample()) + "!");
+            }
+            const std::size_t count = packed.size() / header.bytesPerSample();
+            if (samplesWritten + count > header.samples) {
+                FinnUtils::logAndError<std::length_error>(loggerPrefix() + "Appending more samples than announced in the header!");
+            }
+            stream.write(reinterpret_cast<const char*>(packed.data()), static_cast<std::streamsize>(packed.size()));
+            if (!stream) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Writing to the packed dataset failed!");
+            }
+            samplesWritten += count;
+        }
+
+        /**
+         * @brief Flush and close the file
+         *
+         */
+        void close() {
+            if (samplesWritten != header.samples) {
+                FinnUtils::logAndError<std::length_error>(loggerPrefix() + "Closing a packed dataset after " + std::to_string(samplesWritten) + " of " + std::to_string(header.samples) + " samples were written!");
+            }
+            stream.close();
+        }
+    };
+}  // namespace Finn
+
+#endif  // PACKEDDATASET
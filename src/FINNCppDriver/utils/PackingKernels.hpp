@@ -0,0 +1,626 @@
+/**
+ * @file PackingKernels.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Bit packing and unpacking kernels specialised on the bitwidth of the FINN datatype
+ * @version 0.1
+ * @date 2024-01-15
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef PACKINGKERNELS
+#define PACKINGKERNELS
+
+#include <FINNCppDriver/utils/FinnUtils.h>
+
+#include <FINNCppDriver/utils/FinnDatatypes.hpp>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #define FINN_PACKING_X86_DISPATCH 1
+    #include <immintrin.h>
+#endif
+
+namespace Finn {
+    /**
+     * @brief Internal implementations. Should not be used by user.
+     *
+     */
+    namespace detail {
+        /**
+         * @brief Bit packing and unpacking kernels. All kernels use the same layout: element i occupies bits [i * bitwidth, (i + 1) * bitwidth) of the output, LSB first, without padding.
+         *
+         */
+        namespace packing {
+            /**
+             * @brief Mask with the lowest bits bits set
+             *
+             * @tparam bits
+             */
+            template<std::size_t bits>
+            constexpr uint64_t laneMask = (bits >= 64) ? ~uint64_t{0} : ((uint64_t{1} << bits) - 1);
+
+            /**
+             * @brief Quantize a floating point value to the integer representation of U. Fixed point values are scaled by 2^fracBits, then all values are rounded to the nearest
+             * integer (ties to even, as numpy does) and clamped to the range of U. NaN is mapped to the minimum.
+             *
+             * @tparam U Finn Datatype (integer or fixed point)
+             * @tparam T Floating point type of the value
+             * @param val
+             * @return uint64_t Two's complement representation, not yet masked
+             */
+            template<IsDatatype U, std::floating_point T>
+            uint64_t quantize(T val) {
+                constexpr std::size_t bits = U().bitwidth();
+                constexpr bool isFix = U().isFixedPoint();
+                constexpr double lowest = isFix ? -static_cast<double>(uint64_t{1} << (bits - 1)) : U().min();
+                constexpr double highest = isFix ? static_cast<double>((uint64_t{1} << (bits - 1)) - 1) : U().max();
+
+                double scaled = static_cast<double>(val);
+                if constexpr (isFix) {
+                    scaled *= static_cast<double>(uint64_t{1} << U().fracBits());
+                }
+                scaled = std::nearbyint(scaled);
+                if constexpr (bits == 64) {
+                    // highest rounds up to 2^63 or 2^64, which does not fit into the result, so the maximum is returned without converting it back
+                    if (scaled >= (U().sign() ? 0x1p63 : 0x1p64)) {
+                        return U().sign() ? static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) : std::numeric_limits<uint64_t>::max();
+                    }
+                }
+                if (!(scaled >= lowest)) {  // Also catches NaN
+                    scaled = lowest;
+                } else if (scaled > highest) {
+                    scaled = highest;
+                }
+                if constexpr (U().sign()) {
+                    return static_cast<uint64_t>(static_cast<int64_t>(scaled));
+                } else {
+                    return static_cast<uint64_t>(scaled);
+                }
+            }
+
+            /**
+             * @brief Convert a single value into its bit representation in U, masked to the bitwidth of U. Conversions that are needed for the combination of U and T (fixed point
+             * scaling, quantization of floating point inputs, bitcasts to IEEE 754 single precision) are applied here, so that the kernels never need temporary buffers.
+             *
+             * @tparam U Finn Datatype
+             * @tparam T Storage type of the value
+             * @param val
+             * @return uint64_t
+             */
+            template<IsDatatype U, typename T>
+            uint64_t toLane(T val) {
+                constexpr uint64_t mask = laneMask<U().bitwidth()>;
+                if constexpr (!U().isInteger() && !U().isFixedPoint()) {  // Datatype is a 32 bit floating point number
+                    return std::bit_cast<uint32_t>(static_cast<float>(val));
+                } else if constexpr (std::is_same_v<U, DatatypeBipolar>) {
+                    if constexpr (std::is_floating_point_v<T>) {
+                        return val > 0 ? 1 : 0;
+                    } else {
+                        return (static_cast<uint64_t>(static_cast<std::make_unsigned_t<T>>(val)) + 1) >> 1 & 1;  // -1 -> 0, 1 -> 1
+                    }
+                } else if constexpr (std::is_floating_point_v<T>) {
+                    return quantize<U>(val) & mask;
+                } else if constexpr (U().isFixedPoint()) {
+                    return (static_cast<uint64_t>(static_cast<std::make_unsigned_t<T>>(val)) << U().fracBits()) & mask;
+                } else {
+                    return static_cast<uint64_t>(static_cast<std::make_unsigned_t<T>>(val)) & mask;
+                }
+            }
+
+            /**
+             * @brief Write the lowest bytes of word to out (little endian)
+             *
+             * @param word
+             * @param out
+             * @param bytes
+             */
+            inline void storeWord(uint64_t word, uint8_t* out, std::size_t bytes = sizeof(uint64_t)) { std::memcpy(out, &word, bytes); }
+
+            /**
+             * @brief Kernel for bitwidths that divide a byte (1, 2 and 4 bit). Fills one 64 bit word per iteration with a fixed trip count.
+             *
+             * @tparam U Finn Datatype
+             * @tparam IteratorType
+             * @param first
+             * @param last
+             * @param out
+             * @return std::size_t Number of bytes written
+             */
+            template<IsDatatype U, typename IteratorType>
+            std::size_t packSubByte(IteratorType first, IteratorType last, uint8_t* out) {
+                constexpr std::size_t bits = U().bitwidth();
+                constexpr std::size_t perWord = 64 / bits;
+                const auto count = static_cast<std::size_t>(std::distance(first, last));
+                const std::size_t fullWords = count / perWord;
+                for (std::size_t w = 0; w < fullWords; ++w) {
+                    uint64_t word = 0;
+                    for (std::size_t k = 0; k < perWord; ++k, ++first) {
+                        word |= toLane<U>(*first) << (k * bits);
+                    }
+                    storeWord(word, out + w * sizeof(uint64_t));
+                }
+                const std::size_t rest = count - fullWords * perWord;
+                if (rest != 0) {
+                    uint64_t word = 0;
+                    for (std::size_t k = 0; k < rest; ++k, ++first) {
+                        word |= toLane<U>(*first) << (k * bits);
+                    }
+                    storeWord(word, out + fullWords * sizeof(uint64_t), FinnUtils::fastDivCeil(rest * bits, std::size_t{8}));
+                }
+                return FinnUtils::fastDivCeil(count * bits, std::size_t{8});
+            }
+
+            /**
+             * @brief Generic kernel for arbitrary bitwidths. Accumulates the values in a 64 bit word and flushes it whenever it is full.
+             *
+             * @tparam U Finn Datatype
+             * @tparam IteratorType
+             * @param first
+             * @param last
+             * @param out
+             * @return std::size_t Number of bytes written
+             */
+            template<IsDatatype U, typename IteratorType>
+            std::size_t packGeneric(IteratorType first, IteratorType last, uint8_t* out) {
+                constexpr std::size_t bits = U().bitwidth();
+                static_assert(bits <= 64, "Datatypes with more than 64 bits are not supported!");
+                uint8_t* const begin = out;
+                uint64_t acc = 0;
+                std::size_t filled = 0;
+                for (; first != last; ++first) {
+                    const uint64_t lane = toLane<U>(*first);
+                    acc |= lane << filled;
+                    filled += bits;
+                    if (filled >= 64) {
+                        storeWord(acc, out);
+                        out += sizeof(uint64_t);
+                        filled -= 64;
+                        // Carry the bits of lane that did not fit into the flushed word
+                        acc = (filled != 0) ? (lane >> (bits - filled)) : 0;
+                    }
+                }
+                if (filled != 0) {
+                    const std::size_t tailBytes = FinnUtils::fastDivCeil(filled, std::size_t{8});
+                    storeWord(acc, out, tailBytes);
+                    out += tailBytes;
+                }
+                return static_cast<std::size_t>(out - begin);
+            }
+
+#ifdef FINN_PACKING_X86_DISPATCH
+            /**
+             * @brief Check once whether the CPU supports AVX2
+             *
+             * @return true
+             * @return false
+             */
+            inline bool hasAvx2() {
+                static const bool supported = __builtin_cpu_supports("avx2") != 0;
+                return supported;
+            }
+
+            /**
+             * @brief Inputs the binarised AVX2 kernels can load directly: bytes, 32 bit integers and floats
+             *
+             * @tparam T
+             */
+            template<typename T>
+            constexpr bool isBinaryAvx2Type = (std::is_integral_v<T> && !std::is_same_v<T, bool> && (sizeof(T) == 1 || sizeof(T) == 4)) || std::is_same_v<T, float>;
+
+            /**
+             * @brief AVX2 kernel for 1 bit datatypes (binary, UInt<1>, Int<1> and bipolar). Every value is turned into its bit with one shift or compare per vector, movemask
+             * collects the bits of 8 or 32 values at once, so 64 values become one packed word per iteration. The bits are exactly those of toLane. Returns the number of values
+             * consumed, which is always a multiple of 64.
+             *
+             * @tparam U Finn Datatype with a bitwidth of 1
+             * @tparam T Input type, @see isBinaryAvx2Type
+             * @param in
+             * @param count
+             * @param out
+             * @return std::size_t Number of values packed
+             */
+            template<IsDatatype U, typename T>
+            __attribute__((target("avx2"))) std::size_t packBinaryAvx2(const T* in, std::size_t count, uint8_t* out) {
+                static_assert(U().bitwidth() == 1 && isBinaryAvx2Type<T>);
+                constexpr bool bipolar = std::is_same_v<U, DatatypeBipolar>;
+                constexpr std::size_t block = 64;
+                std::size_t i = 0;
+                for (; i + block <= count; i += block, out += block / 8) {
+                    uint64_t word = 0;
+                    if constexpr (sizeof(T) == 1) {
+                        for (std::size_t half = 0; half < 2; ++half) {
+                            __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + half * 32));
+                            if constexpr (bipolar) {
+                                // The bipolar bit is bit 1 of val + 1 (-1 -> 0, 1 -> 1), move it to bit 7
+                                values = _mm256_slli_epi16(_mm256_add_epi8(values, _mm256_set1_epi8(1)), 6);
+                            } else {
+                                values = _mm256_slli_epi16(values, 7);
+                            }
+                            word |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(values))} << (half * 32);
+                        }
+                    } else {
+                        for (std::size_t quarter = 0; quarter < 8; ++quarter) {
+                            __m256 sign;
+                            if constexpr (std::is_same_v<T, float>) {
+                                // Same decisions as quantize (round to nearest even, then clamp) and the bipolar case of toLane
+                                const __m256 values = _mm256_loadu_ps(in + i + quarter * 8);
+                                if constexpr (bipolar) {
+                                    sign = _mm256_cmp_ps(values, _mm256_setzero_ps(), _CMP_GT_OQ);
+                                } else if constexpr (U().sign()) {
+                                    sign = _mm256_cmp_ps(values, _mm256_set1_ps(-0.5F), _CMP_NGE_UQ);
+                                } else {
+                                    sign = _mm256_cmp_ps(values, _mm256_set1_ps(0.5F), _CMP_GT_OQ);
+                                }
+                            } else {
+                                const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + quarter * 8));
+                                if constexpr (bipolar) {
+                                    sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(values, _mm256_set1_epi32(1)), 30));
+                                } else {
+                                    sign = _mm256_castsi256_ps(_mm256_slli_epi32(values, 31));
+                                }
+                            }
+                            word |= uint64_t{static_cast<uint32_t>(_mm256_movemask_ps(sign))} << (quarter * 8);
+                        }
+                    }
+                    storeWord(word, out);
+                }
+                return i;
+            }
+
+            /**
+             * @brief AVX2 kernel for 2 and 4 bit values stored in bytes. Packs 32 values per iteration and returns the number of values consumed, which is always a multiple of 8,
+             * so that the scalar kernels can continue on a byte boundary.
+             *
+             * @tparam bits
+             * @param in
+             * @param count
+             * @param out
+             * @return std::size_t Number of values packed
+             */
+            template<std::size_t bits>
+            __attribute__((target("avx2"))) std::size_t packBytesAvx2(const uint8_t* in, std::size_t count, uint8_t* out) {
+                constexpr std::size_t block = 32;
+                const __m256i mask = _mm256_set1_epi8(static_cast<char>(laneMask<bits>));
+                std::size_t i = 0;
+                for (; i + block <= count; i += block, out += block * bits / 8) {
+                    const __m256i values = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)), mask);
+                    if constexpr (bits == 2) {
+                        // Merge pairs (a + 4b), then pairs of pairs (x + 16y): every 32 bit lane holds one packed byte
+                        const __m256i pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi16(0x0401));
+                        const __m256i quads = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00100001));
+                        const __m256i bytes = _mm256_packus_epi16(_mm256_packus_epi32(quads, quads), _mm256_setzero_si256());
+                        const auto low = static_cast<uint32_t>(_mm256_cvtsi256_si32(bytes));
+                        const auto high = static_cast<uint32_t>(_mm256_extract_epi32(bytes, 4));
+                        std::memcpy(out, &low, sizeof(low));
+                        std::memcpy(out + sizeof(low), &high, sizeof(high));
+                    } else {
+                        // Merge pairs (a + 16b): every 16 bit lane holds one packed byte
+                        const __m256i pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi16(0x1001));
+                        const __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(pairs, pairs), 0b00001000);
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(bytes));
+                    }
+                }
+                return i;
+            }
+#endif
+
+            /**
+             * @brief Pack the range [first, last) of values of U into out. out has to hold at least ceil(distance(first, last) * bitwidth / 8) bytes.
+             * The input is only read, every value is converted on the fly by toLane. The kernel is selected at compile time based on the bitwidth of U; if the CPU supports AVX2, contiguous byte inputs of 2 and 4 bit datatypes and contiguous byte, 32 bit
+             * and float inputs of 1 bit datatypes use vectorised kernels.
+             *
+             * @tparam U Finn Datatype
+             * @tparam IteratorType Iterator over integral or floating point values
+             * @param first
+             * @param last
+             * @param out
+             * @return std::size_t Number of bytes written
+             */
+            template<IsDatatype U, typename IteratorType>
+            std::size_t packInto(IteratorType first, IteratorType last, uint8_t* out) {
+                using T = typename std::iterator_traits<IteratorType>::value_type;
+                static_assert(std::is_integral_v<T> || std::is_floating_point_v<T>, "The packing kernels expect integral or floating point inputs!");
+                constexpr std::size_t bits = U().bitwidth();
+                if constexpr (bits == 8) {
+                    std::transform(first, last, out, [](const T& val) { return static_cast<uint8_t>(toLane<U>(val)); });
+                    return static_cast<std::size_t>(std::distance(first, last));
+                } else if constexpr (bits == 1 && U().isInteger()) {
+#ifdef FINN_PACKING_X86_DISPATCH
+                    if constexpr (std::contiguous_iterator<IteratorType> && isBinaryAvx2Type<T>) {
+                        if (hasAvx2()) {
+                            const auto count = static_cast<std::size_t>(std::distance(first, last));
+                            const std::size_t done = packBinaryAvx2<U>(std::to_address(first), count, out);
+                            return done / 8 + packSubByte<U>(first + static_cast<std::ptrdiff_t>(done), last, out + done / 8);
+                        }
+                    }
+#endif
+                    return packSubByte<U>(first, last, out);
+                } else if constexpr (8 % bits == 0) {
+#ifdef FINN_PACKING_X86_DISPATCH
+                    if constexpr (std::contiguous_iterator<IteratorType> && std::is_integral_v<T> && sizeof(T) == 1 && U().isInteger()) {
+                        if (hasAvx2()) {
+                            const auto count = static_cast<std::size_t>(std::distance(first, last));
+                            const std::size_t done = packBytesAvx2<bits>(reinterpret_cast<const uint8_t*>(std::to_address(first)), count, out);
+                            return done * bits / 8 + packSubByte<U>(first + static_cast<std::ptrdiff_t>(done), last, out + done * bits / 8);
+                        }
+                    }
+#endif
+                    return packSubByte<U>(first, last, out);
+                } else {
+                    return packGeneric<U>(first, last, out);
+                }
+            }
+
+            /**
+             * @brief Branch-free sign extension of the lowest bits bits of val
+             *
+             * @tparam bits
+             * @param val Value that has no bits set above bit bits - 1
+             * @return int64_t
+             */
+            template<std::size_t bits>
+            constexpr int64_t signExtend(uint64_t val) {
+                constexpr uint64_t signBit = uint64_t{1} << (bits - 1);
+                return static_cast<int64_t>((val ^ signBit) - signBit);
+            }
+
+            /**
+             * @brief Convert the bit representation of a single value of U into T. Sign extension and the fixed point scale are applied in the same step.
+             *
+             * @tparam U Finn Datatype
+             * @tparam T Output type
+             * @param lane Value masked to the bitwidth of U
+             * @return T
+             */
+            template<IsDatatype U, typename T>
+            constexpr T fromLane(uint64_t lane) {
+                constexpr std::size_t bits = U().bitwidth();
+                if constexpr (!U().isInteger() && !U().isFixedPoint()) {
+                    return std::bit_cast<float>(static_cast<uint32_t>(lane));
+                } else if constexpr (std::is_same_v<U, DatatypeBipolar>) {
+                    return static_cast<T>(lane != 0 ? 1 : -1);
+                } else if constexpr (U().isFixedPoint()) {
+                    constexpr float scale = 1.0F / static_cast<float>(uint64_t{1} << U().fracBits());
+                    const int64_t val = U().sign() ? signExtend<bits>(lane) : static_cast<int64_t>(lane);
+                    return static_cast<T>(static_cast<float>(val) * scale);
+                } else if constexpr (U().sign()) {
+                    return static_cast<T>(signExtend<bits>(lane));
+                } else {
+                    return static_cast<T>(lane);
+                }
+            }
+
+            /**
+             * @brief Read up to bytes bytes from in into the lowest bytes of a word (little endian)
+             *
+             * @tparam Word
+             * @param in
+             * @param bytes
+             * @return Word
+             */
+            template<typename Word = uint64_t>
+            inline Word loadWord(const uint8_t* in, std::size_t bytes = sizeof(Word)) {
+                Word word = 0;
+                std::memcpy(&word, in, bytes);
+                return word;
+            }
+
+            /**
+             * @brief Unpacking kernel for bitwidths that divide a byte (1, 2 and 4 bit). Extracts the values of one 64 bit word per iteration with a fixed trip count.
+             *
+             * @tparam U Finn Datatype
+             * @tparam T Output type
+             * @param in
+             * @param count Number of values to unpack
+             * @param out
+             */
+            template<IsDatatype U, typename T>
+            void unpackSubByte(const uint8_t* in, std::size_t count, T* out) {
+                constexpr std::size_t bits = U().bitwidth();
+                constexpr std::size_t perWord = 64 / bits;
+                const std::size_t fullWords = count / perWord;
+                for (std::size_t w = 0; w < fullWords; ++w, out += perWord) {
+                    const uint64_t word = loadWord(in + w * sizeof(uint64_t));
+                    for (std::size_t k = 0; k < perWord; ++k) {
+                        out[k] = fromLane<U, T>((word >> (k * bits)) & laneMask<bits>);
+                    }
+                }
+                const std::size_t rest = count - fullWords * perWord;
+                if (rest != 0) {
+                    const uint64_t word = loadWord(in + fullWords * sizeof(uint64_t), FinnUtils::fastDivCeil(rest * bits, std::size_t{8}));
+                    for (std::size_t k = 0; k < rest; ++k) {
+                        out[k] = fromLane<U, T>((word >> (k * bits)) & laneMask<bits>);
+                    }
+                }
+            }
+
+            /**
+             * @brief Unpacking kernel for bitwidths that are a multiple of 8. Every value is read with a fixed size copy.
+             *
+             * @tparam U Finn Datatype
+             * @tparam T Output type
+             * @param in
+             * @param count Number of values to unpack
+             * @param out
+             */
+            template<IsDatatype U, typename T>
+            void unpackWholeBytes(const uint8_t* in, std::size_t count, T* out) {
+                constexpr std::size_t bytes = U().bitwidth() / 8;
+                for (std::size_t i = 0; i < count; ++i) {
+                    out[i] = fromLane<U, T>(loadWord(in + i * bytes, bytes));
+                }
+            }
+
+            /**
+             * @brief Generic unpacking kernel for arbitrary bitwidths. Every value is extracted from an unaligned word load; only the values at the end of the input, where a full word
+             * load would read past the input, use a shorter copy.
+             *
+             * @tparam U Finn Datatype
+             * @tparam T Output type
+             * @param in
+             * @param inBytes Size of the input in bytes
+             * @param count Number of values to unpack
+             * @param out
+             */
+            template<IsDatatype U, typename T>
+            void unpackGeneric(const uint8_t* in, std::size_t inBytes, std::size_t count, T* out) {
+                constexpr std::size_t bits = U().bitwidth();
+                static_assert(bits <= 64, "Datatypes with more than 64 bits are not supported!");
+                // A value starts at most 7 bits into its first byte, so values wider than 57 bits can span 9 bytes
+                using Word = std::conditional_t<(bits <= 57), uint64_t, __uint128_t>;
+                const auto extract = [](Word word, std::size_t lowerBit) { return static_cast<uint64_t>(word >> (lowerBit % 8)) & laneMask<bits>; };
+
+                const std::size_t safe = (inBytes >= sizeof(Word)) ? std::min(count, ((inBytes - sizeof(Word)) * 8) / bits + 1) : 0;
+                std::size_t i = 0;
+                for (; i < safe; ++i) {
+                    const std::size_t lowerBit = i * bits;
+                    out[i] = fromLane<U, T>(extract(loadWord<Word>(in + lowerBit / 8), lowerBit));
+                }
+                for (; i < count; ++i) {
+                    const std::size_t lowerBit = i * bits;
+                    const std::size_t lowerByte = lowerBit / 8;
+                    const std::size_t bytes = std::min(sizeof(Word), inBytes - lowerByte);
+                    out[i] = fromLane<U, T>(extract(loadWord<Word>(in + lowerByte, bytes), lowerBit));
+                }
+            }
+
+#ifdef FINN_PACKING_X86_DISPATCH
+            /**
+             * @brief AVX2 kernel that expands the bits of 1 bit datatypes into bytes or 32 bit values. Every output lane tests the bit belonging to it, the result selects between the
+             * two values the datatype can take (fromLane of 0 and 1), so bipolar and signed values need no extra step. Produces 32 values per iteration and returns the number of
+             * values unpacked, which is always a multiple of 32.
+             *
+             * @tparam U Finn Datatype with a bitwidth of 1
+             * @tparam T Output type of 1 or 4 bytes
+             * @param in
+             * @param count
+             * @param out
+             * @return std::size_t Number of values unpacked
+             */
+            template<IsDatatype U, typename T>
+            __attribute__((target("avx2"))) std::size_t unpackBinaryAvx2(const uint8_t* in, std::size_t count, T* out) {
+                static_assert(U().bitwidth() == 1 && (sizeof(T) == 1 || sizeof(T) == 4));
+                constexpr std::size_t block = 32;
+                std::size_t i = 0;
+                if constexpr (sizeof(T) == 1) {
+                    const __m256i clear = _mm256_set1_epi8(std::bit_cast<char>(fromLane<U, T>(0)));
+                    const __m256i set = _mm256_set1_epi8(std::bit_cast<char>(fromLane<U, T>(1)));
+                    // Broadcast 4 bytes, give each output byte a copy of its source byte and test the bit belonging to it
+                    const __m256i index = _mm256_setr_epi64x(0x0000000000000000, 0x0101010101010101, 0x0202020202020202, 0x0303030303030303);
+                    const __m256i bitSelect = _mm256_set1_epi64x(static_cast<int64_t>(0x8040201008040201));
+                    for (; i + block <= count; i += block, in += block / 8) {
+                        const __m256i spread = _mm256_shuffle_epi8(_mm256_set1_epi32(static_cast<int>(loadWord<uint32_t>(in))), index);
+                        const __m256i bitSet = _mm256_cmpeq_epi8(_mm256_and_si256(spread, bitSelect), bitSelect);
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_blendv_epi8(clear, set, bitSet));
+                    }
+                } else {
+                    const __m256i clear = _mm256_set1_epi32(std::bit_cast<int32_t>(fromLane<U, T>(0)));
+                    const __m256i set = _mm256_set1_epi32(std::bit_cast<int32_t>(fromLane<U, T>(1)));
+                    const __m256i bitSelect = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+                    for (; i + block <= count; i += block, in += block / 8) {
+                        for (std::size_t b = 0; b < block / 8; ++b) {
+                            const __m256i bitSet = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(in[b]), bitSelect), bitSelect);
+                            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + b * 8), _mm256_blendv_epi8(clear, set, bitSet));
+                        }
+                    }
+                }
+                return i;
+            }
+
+            /**
+             * @brief AVX2 kernel that unpacks 2 and 4 bit values into bytes. Produces 32 values per iteration and returns the number of values unpacked, which is always a multiple
+             * of 32, so that the scalar kernels can continue on a byte boundary.
+             *
+             * @tparam bits
+             * @tparam isSigned Whether the values are sign extended
+             * @param in
+             * @param count
+             * @param out
+             * @return std::size_t Number of values unpacked
+             */
+            template<std::size_t bits, bool isSigned>
+            __attribute__((target("avx2"))) std::size_t unpackBytesAvx2(const uint8_t* in, std::size_t count, uint8_t* out) {
+                constexpr std::size_t block = 32;
+                std::size_t i = 0;
+                for (; i + block <= count; i += block, in += block * bits / 8) {
+                    __m256i values;
+                    if constexpr (bits == 2) {
+                        // Widen every byte to 32 bit and move its four values into the four bytes of the lane
+                        const __m256i b = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in)));
+                        const __m256i spread = _mm256_or_si256(_mm256_or_si256(b, _mm256_slli_epi32(b, 6)), _mm256_or_si256(_mm256_slli_epi32(b, 12), _mm256_slli_epi32(b, 18)));
+                        values = _mm256_and_si256(spread, _mm256_set1_epi32(0x03030303));
+                    } else {
+                        // Widen every byte to 16 bit and move its high nibble into the high byte of the lane
+                        const __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in)));
+                        values = _mm256_and_si256(_mm256_or_si256(b, _mm256_slli_epi16(b, 4)), _mm256_set1_epi16(0x0F0F));
+                    }
+                    if constexpr (isSigned) {
+                        const __m256i signBit = _mm256_set1_epi8(static_cast<char>(1U << (bits - 1)));
+                        values = _mm256_sub_epi8(_mm256_xor_si256(values, signBit), signBit);
+                    }
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), values);
+                }
+                return i;
+            }
+#endif
+
+            /**
+             * @brief Unpack count values of U from in into out. in has to hold at least inBytes >= ceil(count * bitwidth / 8) bytes.
+             * The kernel is selected at compile time based on the bitwidth of U; if the CPU supports AVX2, 2 and 4 bit integer datatypes unpacked into bytes and 1 bit datatypes
+             * unpacked into bytes, 32 bit integers or floats use vectorised kernels.
+             *
+             * @tparam U Finn Datatype
+             * @tparam T Output type
+             * @param in
+             * @param inBytes
+             * @param count
+             * @param out
+             */
+            template<IsDatatype U, typename T>
+            void unpackTo(const uint8_t* in, std::size_t inBytes, std::size_t count, T* out) {
+                constexpr std::size_t bits = U().bitwidth();
+                if constexpr (bits == 1 && U().isInteger()) {
+#ifdef FINN_PACKING_X86_DISPATCH
+                    if constexpr ((std::is_integral_v<T> || std::is_same_v<T, float>) && (sizeof(T) == 1 || sizeof(T) == 4)) {
+                        if (hasAvx2()) {
+                            const std::size_t done = unpackBinaryAvx2<U, T>(in, count, out);
+                            unpackSubByte<U, T>(in + done / 8, count - done, out + done);
+                            return;
+                        }
+                    }
+#endif
+                    unpackSubByte<U, T>(in, count, out);
+                } else if constexpr (8 % bits == 0 && bits != 8) {
+#ifdef FINN_PACKING_X86_DISPATCH
+                    if constexpr (std::is_integral_v<T> && sizeof(T) == 1 && !U().isFixedPoint()) {
+                        if (hasAvx2()) {
+                            const std::size_t done = unpackBytesAvx2<bits, U().sign()>(in, count, reinterpret_cast<uint8_t*>(out));
+                            unpackSubByte<U, T>(in + done * bits / 8, count - done, out + done);
+                            return;
+                        }
+                    }
+#endif
+                    unpackSubByte<U, T>(in, count, out);
+                } else if constexpr (bits % 8 == 0) {
+                    unpackWholeBytes<U, T>(in, count, out);
+                } else {
+                    unpackGeneric<U, T>(in, inBytes, count, out);
+                }
+            }
+        }  // namespace packing
+    }  // namespace detail
+}  // namespace Finn
+
+#endif  // PACKINGKERNELS
@@ -0,0 +1,165 @@
+/**
+ * @file Postprocessing.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Host postprocessing stages that reduce packed outputs to class indices without unpacking them first
+ * @version 0.1
+ * @date 2024-03-07
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef POSTPROCESSING_HPP
+#define POSTPROCESSING_HPP
+
+#include <FINNCppDriver/utils/FinnUtils.h>
+#include <FINNCppDriver/utils/Types.h>
+
+#include <FINNCppDriver/utils/DataPacking.hpp>
+#include <FINNCppDriver/utils/FinnDatatypes.hpp>
+#include <FINNCppDriver/utils/Instrumentation.hpp>
+#include <FINNCppDriver/utils/ThreadPool.hpp>
+#include <FINNCppDriver/utils/TransferPlan.h>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Finn {
+    /**
+     * @brief Index reported for result places that no class filled, e.g. if fewer than k classes reached the threshold
+     *
+     */
+    constexpr std::size_t noClass = std::numeric_limits<std::size_t>::max();
+
+    /**
+     * @brief A postprocessing stage. Every output sample is reduced to resultsPerSample() class indices, ordered from the largest value down. Ties are won by the lower index.
+     * The class index is the position of a value in the flattened output of the sample.
+     *
+     */
+    struct Postprocessing {
+        /**
+         * @brief Applied reduction
+         *
+         */
+        POSTPROCESSING kind = POSTPROCESSING::ARGMAX;
+        /**
+         * @brief Number of indices per sample for TOPK and THRESHOLD
+         *
+         */
+        std::size_t k = 1;
+        /**
+         * @brief Smallest value a class needs for THRESHOLD
+         *
+         */
+        double minimum = 0.0;
+
+        /**
+         * @brief Index of the largest value per sample
+         *
+         * @return Postprocessing
+         */
+        static Postprocessing argmax() { return {POSTPROCESSING::ARGMAX, 1, 0.0}; }
+
+        /**
+         * @brief Indices of the k largest values per sample
+         *
+         * @param pK
+         * @return Postprocessing
+         */
+        static Postprocessing topK(std::size_t pK) { return {POSTPROCESSING::TOPK, pK, 0.0}; }
+
+        /**
+         * @brief Indices of the at most k largest values per sample that are at least pMinimum. Unused places hold noClass.
+         *
+         * @param pMinimum
+         * @param pK
+         * @return Postprocessing
+         */
+        static Postprocessing threshold(double pMinimum, std::size_t pK = 1) { return {POSTPROCESSING::THRESHOLD, pK, pMinimum}; }
+
+        /**
+         * @brief Number of indices written per sample
+         *
+         * @return std::size_t
+         */
+        std::size_t resultsPerSample() const { return (kind == POSTPROCESSING::ARGMAX) ? 1 : k; }
+    };
+
+    /**
+     * @brief Reduce every sample of a packed output to class indices. The packed rows of a sample are unpacked one at a time into a scratch row and folded into the running
+     * top k, so the full unpacked output is never materialised.
+     *
+     * @tparam U FinnDatatype that is contained in the packed bytes
+     * @tparam V Type the values are compared in. Usually autodeduced.
+     * @param packed Packed output, e.g. the mapped output buffer. Has to hold at least plan.bytes() bytes
+     * @param plan Transfer plan of the output, its first folded dimension is the number of samples
+     * @param stage
+     * @param output Receives stage.resultsPerSample() indices per sample
+     * @param pool Thread pool the samples are distributed over. Reduces on the calling thread if nullptr
+     * @return std::size_t Number of indices written to output
+     */
+    template<IsDatatype U, typename V = UnpackingAutoRetType::AutoRetType<U>>
+    std::size_t postprocessPacked(std::span<const uint8_t> packed, const TransferPlan& plan, const Postprocessing& stage, std::span<std::size_t> output, ThreadPool* pool = nullptr) {
+        if (plan.bitwidth != U().bitwidth()) {
+            FinnUtils::logAndError<std::invalid_argument>("Transfer plan was created for a different datatype!");
+        }
+        if (stage.kind == POSTPROCESSING::INVALID || stage.resultsPerSample() == 0) {
+            FinnUtils::logAndError<std::invalid_argument>("Postprocessing has to keep at least one class per sample!");
+        }
+        if (packed.size() < plan.bytes()) {
+            FinnUtils::logAndError<std::length_error>("Packed input is smaller than its packed shape " + FinnUtils::shapeToString(plan.packedShape) + "!");
+        }
+        const std::size_t samples = plan.foldedShape[0];
+        const std::size_t perSample = stage.resultsPerSample();
+        if (output.size() < samples * perSample) {
+            FinnUtils::logAndError<std::length_error>("Output buffer for postprocessing is too small (" + std::to_string(output.size()) + " indices given, " + std::to_string(samples * perSample) + " indices needed)!");
+        }
+        FINN_TIME_STAGE(UNPACK);
+
+        const std::size_t rowsPerSample = plan.innerDims / samples;
+        const bool filtered = stage.kind == POSTPROCESSING::THRESHOLD;
+        const auto reduceRange = [&](std::size_t begin, std::size_t end) {
+            std::vector<V> row(plan.elementsPerInnerDim);
+            std::vector<std::pair<V, std::size_t>> best;
+            best.reserve(perSample);
+            for (std::size_t sample = begin; sample < end; ++sample) {
+                best.clear();
+                for (std::size_t r = 0; r < rowsPerSample; ++r) {
+                    detail::packing::unpackTo<U, V>(packed.data() + (sample * rowsPerSample + r) * plan.bytesPerInnerDim, plan.bytesPerInnerDim, plan.elementsPerInnerDim, row.data());
+                    for (std::size_t j = 0; j < plan.elementsPerInnerDim; ++j) {
+                        const V value = row[j];
+                        if ((filtered && static_cast<double>(value) < stage.minimum) || (best.size() == perSample && !(value > best.back().first))) {
+                            continue;
+                        }
+                        if (best.size() < perSample) {
+                            best.emplace_back(value, r * plan.elementsPerInnerDim + j);
+                        } else {
+                            best.back() = {value, r * plan.elementsPerInnerDim + j};
+                        }
+                        // Keep best sorted from the largest value down, an equal value stays behind the earlier index
+                        for (std::size_t i = best.size() - 1; i > 0 && best[i].first > best[i - 1].first; --i) {
+                            std::swap(best[i], best[i - 1]);
+                        }
+                    }
+                }
+                for (std::size_t i = 0; i < perSample; ++i) {
+                    output[sample * perSample + i] = (i < best.size()) ? best[i].second : noClass;
+                }
+            }
+        };
+        if (pool != nullptr) {
+            pool->parallelFor(samples, rowsPerSample * (plan.bytesPerInnerDim + plan.elementsPerInnerDim * sizeof(V)), reduceRange);
+        } else {
+            reduceRange(0, samples);
+        }
+        return samples * perSample;
+    }
+}  // namespace Finn
+
+#endif  // POSTPROCESSING_HPP
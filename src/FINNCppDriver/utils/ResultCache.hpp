@@ -0,0 +1,224 @@
+/**
+ * @file ResultCache.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief LRU cache of packed results keyed by the packed input of a sample
+ * @version 0.1
+ * @date 2024-03-17
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef RESULTCACHE
+#define RESULTCACHE
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace Finn {
+    /**
+     * @brief Counters of a ResultCache
+     *
+     */
+    struct ResultCacheStatistics {
+        /**
+         * @brief Samples served from the cache
+         *
+         */
+        std::size_t hits = 0;
+        /**
+         * @brief Samples that had to be run on the device
+         *
+         */
+        std::size_t misses = 0;
+        /**
+         * @brief Entries dropped to stay within the capacity
+         *
+         */
+        std::size_t evictions = 0;
+        /**
+         * @brief Batches that were served completely from the cache, without running the device
+         *
+         */
+        std::size_t skippedBatches = 0;
+        /**
+         * @brief Number of cached samples
+         *
+         */
+        std::size_t entries = 0;
+        /**
+         * @brief Bytes of the cached inputs and results
+         *
+         */
+        std::size_t bytes = 0;
+        std::size_t maxEntries = 0;
+        std::size_t maxBytes = 0;
+
+        /**
+         * @brief Share of the samples that were served from the cache
+         *
+         * @return double 0 if no sample was looked up yet
+         */
+        double hitRate() const { return (hits + misses > 0) ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0; }
+    };
+
+    /**
+     * @brief Least recently used cache of the packed results of single samples, keyed by their packed input. Entries keep a copy of the input, so hash collisions can
+     * never return the result of another sample. Packed data is independent of the host datatype the results are unpacked to and much smaller for narrow datatypes.
+     *
+     */
+    class ResultCache {
+         private:
+        struct Entry {
+            std::uint64_t hash;
+            std::vector<uint8_t> input;
+            std::vector<uint8_t> result;
+
+            std::size_t bytes() const { return input.size() + result.size(); }
+        };
+
+        std::list<Entry> entries;
+        std::unordered_map<std::uint64_t, std::list<Entry>::iterator> index;
+        std::size_t maxBytes;
+        std::size_t maxEntries;
+        ResultCacheStatistics statistics;
+        mutable std::mutex mutex;
+
+        void evictOldest() {
+            statistics.bytes -= entries.back().bytes();
+            index.erase(entries.back().hash);
+            entries.pop_back();
+            ++statistics.evictions;
+        }
+
+         public:
+        /**
+         * @brief Construct a new cache
+         *
+         * @param pMaxBytes Upper bound on the bytes of cached inputs and results, 0 for no bound
+         * @param pMaxEntries Upper bound on the number of cached samples, 0 for no bound
+         */
+        ResultCache(std::size_t pMaxBytes, std::size_t pMaxEntries) : maxBytes(pMaxBytes), maxEntries(pMaxEntries) {
+            statistics.maxBytes = maxBytes;
+            statistics.maxEntries = maxEntries;
+        }
+
+        /**
+         * @brief Hash packed bytes eight at a time. Much cheaper than packing, so looking up a sample costs a fraction of what it saves on a hit.
+         *
+         * @param bytes
+         * @return std::uint64_t
+         */
+        static std::uint64_t hash(std::span<const uint8_t> bytes) {
+            constexpr std::uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+            auto mix = [](std::uint64_t value) {
+                value ^= value >> 33U;
+                value *= 0xFF51AFD7ED558CCDULL;
+                value ^= value >> 33U;
+                return value;
+            };
+            std::uint64_t state = bytes.size() * multiplier;
+            std::size_t offset = 0;
+            for (; offset + sizeof(std::uint64_t) <= bytes.size(); offset += sizeof(std::uint64_t)) {
+                std::uint64_t word = 0;
+                std::memcpy(&word, bytes.data() + offset, sizeof(word));
+                state = (state ^ mix(word)) * multiplier;
+            }
+            std::uint64_t tail = 0;
+            if (offset < bytes.size()) {
+                std::memcpy(&tail, bytes.data() + offset, bytes.size() - offset);
+            }
+            return mix((state ^ mix(tail)) * multiplier);
+        }
+
+        /**
+         * @brief Look up the result of a sample and mark it as recently used
+         *
+         * @param input Packed input of the sample
+         * @param result Receives the packed result on a hit, has to have the size of the cached result
+         * @return true if the sample was cached
+         */
+        bool lookup(std::span<const uint8_t> input, std::span<uint8_t> result) {
+            const std::uint64_t key = hash(input);
+            std::lock_guard guard(mutex);
+            auto found = index.find(key);
+            if (found == index.end() || !std::equal(input.begin(), input.end(), found->second->input.begin(), found->second->input.end()) || found->second->result.size() != result.size()) {
+                ++statistics.misses;
+                return false;
+            }
+            entries.splice(entries.begin(), entries, found->second);
+            std::copy(found->second->result.begin(), found->second->result.end(), result.begin());
+            ++statistics.hits;
+            return true;
+        }
+
+        /**
+         * @brief Cache the result of a sample, evicting the least recently used samples if the cache is full. A sample larger than the whole cache is not cached.
+         *
+         * @param input Packed input of the sample
+         * @param result Packed result of the sample
+         */
+        void insert(std::span<const uint8_t> input, std::span<const uint8_t> result) {
+            const std::size_t bytes = input.size() + result.size();
+            if (maxBytes > 0 && bytes > maxBytes) {
+                return;
+            }
+            const std::uint64_t key = hash(input);
+            std::lock_guard guard(mutex);
+            if (auto found = index.find(key); found != index.end()) {
+                // Same input cached again, or a hash collision that replaces the other sample
+                statistics.bytes -= found->second->bytes();
+                entries.erase(found->second);
+                index.erase(found);
+            }
+            while (!entries.empty() && ((maxEntries > 0 && entries.size() >= maxEntries) || (maxBytes > 0 && statistics.bytes + bytes > maxBytes))) {
+                evictOldest();
+            }
+            entries.push_front({key, std::vector<uint8_t>(input.begin(), input.end()), std::vector<uint8_t>(result.begin(), result.end())});
+            index.emplace(key, entries.begin());
+            statistics.bytes += bytes;
+        }
+
+        /**
+         * @brief Count a batch that did not need the device
+         *
+         */
+        void countSkippedBatch() {
+            std::lock_guard guard(mutex);
+            ++statistics.skippedBatches;
+        }
+
+        /**
+         * @brief Drop all entries. The counters are kept.
+         *
+         */
+        void clear() {
+            std::lock_guard guard(mutex);
+            entries.clear();
+            index.clear();
+            statistics.bytes = 0;
+        }
+
+        /**
+         * @brief Get the counters of the cache
+         *
+         * @return ResultCacheStatistics
+         */
+        ResultCacheStatistics getStatistics() const {
+            std::lock_guard guard(mutex);
+            ResultCacheStatistics current = statistics;
+            current.entries = entries.size();
+            return current;
+        }
+    };
+}  // namespace Finn
+
+#endif  // RESULTCACHE
@@ -1,8 +1,8 @@
 /**
  * @file RingBuffer.hpp
  * @author Bjarne Wintermann (bjarne.wintermann@uni-paderborn.de), Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
- * @brief Implements a wrapper for the circular buffer of boost
- * @version 2.0
+ * @brief Implements a lock-free, part-granular single-producer/single-consumer ring buffer
+ * @version 3.0
  * @date 2023-11-14
  *
  * @copyright Copyright (c) 2023
@@ -16,36 +16,64 @@
 
 #include <FINNCppDriver/utils/FinnUtils.h>
 #include <FINNCppDriver/utils/Logger.h>
+#include <FINNCppDriver/utils/Types.h>
 
 #include <algorithm>
 #include <atomic>
-#include <boost/circular_buffer.hpp>
-#include <condition_variable>
+#include <cstdint>
 #include <iterator>
-#include <mutex>
-#include <numeric>
 #include <span>
-#include <syncstream>
-#include <thread>
-#include <tuple>
-#include <type_traits>
+#include <stop_token>
+#include <string>
 #include <vector>
 
 namespace Finn {
     /**
-     * @brief Wrapper class for boost::circular_buffer, which handles abstraction.
+     * @brief Ring buffer made up of a fixed number of parts with a fixed number of elements each.
+     *
+     * The buffer is lock-free for exactly one producer and one consumer thread. Producers can either copy data in with store() or fill a part
+     * in place by claiming it with claimWrite() and publishing it with commitWrite(). Consumers likewise drain with read() or claimRead()/commitRead().
+     * In multithreaded mode claiming blocks on an atomic wait (futex on Linux) until a part becomes available or the supplied stop token is triggered.
+     * In singlethreaded mode claiming never blocks and returns an empty span instead.
+     *
+     * @attention If several threads need to act as consumer (or producer) they have to serialize these accesses themselves.
      *
      * @tparam T
+     * @tparam multiThreaded Enables the blocking claim operations
      */
     template<typename T, bool multiThreaded = false>
     class RingBuffer {
-        finnBoost::circular_buffer<T> buffer;
-
-        std::mutex readWriteMutex;
-        std::condition_variable cv;
+        /**
+         * @brief Assumed cache line size, used to keep the producer and consumer counters from false sharing
+         *
+         */
+        static constexpr std::size_t cacheLineSize = 64;
 
+        Finn::vector<T> buffer;
+        std::size_t parts;
         std::size_t elementsPerPart;
 
+        /**
+         * @brief Number of parts ever committed by the producer. Only written by the producer.
+         *
+         */
+        alignas(cacheLineSize) std::atomic<std::size_t> head = 0;
+        /**
+         * @brief Number of parts ever released by the consumer. Only written by the consumer.
+         *
+         */
+        alignas(cacheLineSize) std::atomic<std::size_t> tail = 0;
+        /**
+         * @brief Bumped whenever a part is committed (or a stop is requested) to wake a blocked consumer
+         *
+         */
+        alignas(cacheLineSize) std::atomic<std::uint32_t> writeEvents = 0;
+        /**
+         * @brief Bumped whenever a part is released (or a stop is requested) to wake a blocked producer
+         *
+         */
+        alignas(cacheLineSize) std::atomic<std::uint32_t> readEvents = 0;
+
         /**
          * @brief A small prefix to determine the source of the log write
          *
@@ -53,7 +81,51 @@ namespace Finn {
          */
         std::string static loggerPrefix() { return "[RingBuffer] "; }
 
-        std::size_t freeSpaceNotLocked() const { return buffer.capacity() - buffer.size(); }
+        /**
+         * @brief Get a span over the part with the given (monotonic) part counter
+         *
+         * @param counter
+         * @return std::span<T>
+         */
+        std::span<T> partSpan(std::size_t counter) { return {buffer.data() + (counter % parts) * elementsPerPart, elementsPerPart}; }
+
+        /**
+         * @brief Number of parts that are committed but not yet released
+         *
+         * @return std::size_t
+         */
+        std::size_t validParts() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+
+        /**
+         * @brief Block on the given event counter until the predicate holds or a stop was requested
+         *
+         * @tparam Pred
+         * @param events Event counter to wait on
+         * @param pred Condition to wait for
+         * @param stoken Stop token that aborts the wait
+         * @return true Predicate holds
+         * @return false Stop was requested
+         */
+        template<typename Pred>
+        static bool blockUntil(std::atomic<std::uint32_t>& events, Pred pred, const std::stop_token& stoken) {
+            if (pred()) {
+                return true;
+            }
+            std::stop_callback wakeUp(stoken, [&events]() {
+                events.fetch_add(1, std::memory_order_release);
+                events.notify_all();
+            });
+            while (true) {
+                const auto seen = events.load(std::memory_order_acquire);
+                if (pred()) {
+                    return true;
+                }
+                if (stoken.stop_requested()) {
+                    return false;
+                }
+                events.wait(seen, std::memory_order_acquire);
+            }
+        }
 
          public:
         /**
@@ -64,7 +136,7 @@ namespace Finn {
          * @param pParts
          * @param pElementsPerPart
          */
-        RingBuffer(const size_t pParts, const size_t pElementsPerPart) : buffer(pElementsPerPart * pParts), elementsPerPart(pElementsPerPart) {
+        RingBuffer(const size_t pParts, const size_t pElementsPerPart) : buffer(pElementsPerPart * pParts), parts(pParts), elementsPerPart(pElementsPerPart) {
             auto logger = Logger::getLogger();
             FINN_LOG(logger, loglevel::info) << "Ringbuffer initialised with " << pElementsPerPart << " Elements per Part and " << pParts << " Parts.\n";
             if (pElementsPerPart * pParts == 0) {
@@ -74,10 +146,12 @@ namespace Finn {
 
         /**
          * @brief Construct a new Ring Buffer object (Move constructor)
+         * @attention Neither buffer may be in use by another thread while moving
          *
          * @param other
          */
-        RingBuffer(RingBuffer&& other) noexcept : buffer(std::move(other.buffer)), elementsPerPart(other.elementsPerPart) {}
+        RingBuffer(RingBuffer&& other) noexcept
+            : buffer(std::move(other.buffer)), parts(other.parts), elementsPerPart(other.elementsPerPart), head(other.head.load()), tail(other.tail.load()) {}
 
         RingBuffer(const RingBuffer& other) = delete;
         virtual ~RingBuffer() = default;
@@ -90,14 +164,7 @@ namespace Finn {
          * @return true success
          * @return false failure
          */
-        bool empty() {
-            if constexpr (multiThreaded) {
-                std::lock_guard guard(readWriteMutex);
-                return buffer.empty();
-            } else {
-                return buffer.empty();
-            }
-        }
+        bool empty() const { return validParts() == 0; }
 
         /**
          * @brief Tests if ring buffer is full
@@ -105,29 +172,14 @@ namespace Finn {
          * @return true success
          * @return false failure
          */
-        bool full() {
-            if constexpr (multiThreaded) {
-                std::lock_guard guard(readWriteMutex);
-                return buffer.full();
-            } else {
-                // std::cout << "" << "\n";
-                return buffer.full();
-            }
-        }
+        bool full() const { return validParts() == parts; }
 
         /**
          * @brief Get the availble free space in the driver
          *
          * @return std::size_t
          */
-        std::size_t freeSpace() {
-            if constexpr (multiThreaded) {
-                std::lock_guard guard(readWriteMutex);
-                return buffer.capacity() - buffer.size();
-            } else {
-                return buffer.capacity() - buffer.size();
-            }
-        }
+        std::size_t freeSpace() const { return (parts - validParts()) * elementsPerPart; }
 
         /**
          *
@@ -138,11 +190,11 @@ namespace Finn {
          */
         size_t size(SIZE_SPECIFIER ss) const {
             if (ss == SIZE_SPECIFIER::TOTAL_DATA_SIZE) {
-                return buffer.capacity();
+                return buffer.size();
             } else if (ss == SIZE_SPECIFIER::BYTES) {
-                return buffer.capacity() * sizeof(T);
+                return buffer.size() * sizeof(T);
             } else if (ss == SIZE_SPECIFIER::BATCHSIZE) {
-                return buffer.capacity() / elementsPerPart;
+                return parts;
             } else if (ss == SIZE_SPECIFIER::FEATUREMAP_SIZE) {
                 return elementsPerPart;
             } else {
@@ -152,16 +204,77 @@ namespace Finn {
         }
 
         /**
-         * @brief Get the number of batch elements that can be stored in the buffer
+         * @brief Get the number of batch elements that are currently stored in the buffer
          *
          * @return size_t
          */
-        size_t size() {
+        size_t size() const { return validParts(); }
+
+        /**
+         * @brief Claim the next free part for writing (producer only). The part becomes visible to the consumer once commitWrite() is called.
+         * In multithreaded mode this blocks until a part is free; an empty span is returned if a stop was requested or, in singlethreaded mode, if the buffer is full.
+         *
+         * @param stoken Aborts the blocking wait
+         * @return std::span<T> Part to fill in place
+         */
+        std::span<T> claimWrite(std::stop_token stoken = {}) {
+            const std::size_t current = head.load(std::memory_order_relaxed);
+            auto hasSpace = [this, current]() { return current - tail.load(std::memory_order_acquire) < parts; };
             if constexpr (multiThreaded) {
-                std::lock_guard guard(readWriteMutex);
-                return buffer.size() / elementsPerPart;
+                if (!blockUntil(readEvents, hasSpace, stoken)) {
+                    return {};
+                }
             } else {
-                return buffer.size() / elementsPerPart;
+                if (!hasSpace()) {
+                    return {};
+                }
+            }
+            return partSpan(current);
+        }
+
+        /**
+         * @brief Publish the part previously returned by claimWrite() (producer only)
+         *
+         */
+        void commitWrite() {
+            head.fetch_add(1, std::memory_order_release);
+            if constexpr (multiThreaded) {
+                writeEvents.fetch_add(1, std::memory_order_release);
+                writeEvents.notify_one();
+            }
+        }
+
+        /**
+         * @brief Claim the oldest valid part for reading (consumer only). The part stays valid until commitRead() is called.
+         * In multithreaded mode this blocks until a part is available; an empty span is returned if a stop was requested or, in singlethreaded mode, if the buffer is empty.
+         *
+         * @param stoken Aborts the blocking wait
+         * @return std::span<const T> Part to drain in place
+         */
+        std::span<const T> claimRead(std::stop_token stoken = {}) {
+            const std::size_t current = tail.load(std::memory_order_relaxed);
+            auto hasData = [this, current]() { return head.load(std::memory_order_acquire) != current; };
+            if constexpr (multiThreaded) {
+                if (!blockUntil(writeEvents, hasData, stoken)) {
+                    return {};
+                }
+            } else {
+                if (!hasData()) {
+                    return {};
+                }
+            }
+            return partSpan(current);
+        }
+
+        /**
+         * @brief Release the part previously returned by claimRead() (consumer only)
+         *
+         */
+        void commitRead() {
+            tail.fetch_add(1, std::memory_order_release);
+            if constexpr (multiThreaded) {
+                readEvents.fetch_add(1, std::memory_order_release);
+                readEvents.notify_one();
             }
         }
 
@@ -182,34 +295,23 @@ namespace Finn {
             if (datasize % elementsPerPart != 0) {
                 FinnUtils::logAndError<std::runtime_error>("It is not possible to store data that is not a multiple of a part! Datasize: " + std::to_string(datasize) + ", Elements per Part: " + std::to_string(elementsPerPart) + "\n");
             }
-            if (datasize > buffer.capacity()) {
+            if (datasize > buffer.size()) {
                 FinnUtils::logAndError<std::runtime_error>("It is not possible to store more data in the buffer, than capacity available!");
             }
-            if constexpr (multiThreaded) {
-                // lock buffer
-                std::unique_lock lk(readWriteMutex);
-                if (datasize > freeSpaceNotLocked()) {
-                    // go to sleep and wait until enough space available
-                    cv.wait(lk, [&datasize, this] { return datasize <= freeSpaceNotLocked(); });
-                }
-                // put data into buffer
-                buffer.insert(buffer.end(), first, last);
-
-                // Manual unlocking is done before notifying, to avoid waking up
-                // the waiting thread only to block again
-                lk.unlock();
-                cv.notify_one();
-                return true;
-
-            } else {
-                if (datasize > freeSpaceNotLocked()) {
+            if constexpr (!multiThreaded) {
+                if (datasize > freeSpace()) {
                     // Data could not be stored
                     return false;
                 }
-                // put data into buffer
-                buffer.insert(buffer.end(), first, last);
-                return true;
             }
+            for (std::size_t stored = 0; stored < datasize; stored += elementsPerPart) {
+                auto part = claimWrite();
+                auto next = std::next(first, static_cast<std::ptrdiff_t>(elementsPerPart));
+                std::copy(first, next, part.begin());
+                first = next;
+                commitWrite();
+            }
+            return true;
         }
 
         /**
@@ -248,43 +350,13 @@ namespace Finn {
          */
         template<typename IteratorType>
         bool read(IteratorType outputIt, std::stop_token stoken = {}) {
-            if constexpr (multiThreaded) {
-                // lock buffer
-                std::unique_lock lk(readWriteMutex);
-
-                if (buffer.size() < elementsPerPart) {
-                    // Not enough data so block
-                    // go to sleep and wait until enough data available
-                    using namespace std::literals::chrono_literals;
-                    while (!cv.wait_for(lk, 2000ms, [this] { return buffer.size() >= elementsPerPart; })) {
-                        if (stoken.stop_requested()) {
-                            return false;
-                        }
-                    }
-                }
-
-                // read data
-                auto begin = buffer.begin();
-                std::copy(begin, begin + elementsPerPart, outputIt);
-                buffer.erase(begin, begin + elementsPerPart);
-
-                // Manual unlocking is done before notifying, to avoid waking up
-                // the waiting thread only to block again
-                lk.unlock();
-                cv.notify_one();
-                return true;
-
-            } else {
-                if (buffer.size() < elementsPerPart) {
-                    // Not enough data so fail
-                    return false;
-                }
-
-                auto begin = buffer.begin();
-                std::copy(begin, begin + elementsPerPart, outputIt);
-                buffer.erase(begin, begin + elementsPerPart);
-                return true;
+            auto part = claimRead(stoken);
+            if (part.empty()) {
+                return false;
             }
+            std::copy(part.begin(), part.end(), outputIt);
+            commitRead();
+            return true;
         }
 
         /**
@@ -298,30 +370,21 @@ namespace Finn {
          */
         template<typename IteratorType>
         bool readAllValidParts(IteratorType outputIt) {
+            const std::size_t available = validParts();
+            if (available == 0) {
+                return false;
+            }
+            const std::size_t first = tail.load(std::memory_order_relaxed);
+            for (std::size_t i = 0; i < available; ++i) {
+                auto part = partSpan(first + i);
+                outputIt = std::copy(part.begin(), part.end(), outputIt);
+            }
+            tail.fetch_add(available, std::memory_order_release);
             if constexpr (multiThreaded) {
-                std::unique_lock lk(readWriteMutex);
-                if (buffer.empty()) {
-                    return false;
-                }
-
-                std::copy(buffer.begin(), buffer.end(), outputIt);
-                buffer.clear();
-
-                // Manual unlocking is done before notifying, to avoid waking up
-                // the waiting thread only to block again
-                lk.unlock();
-                cv.notify_one();
-                return true;
-            } else {
-                if (buffer.empty()) {
-                    return false;
-                }
-
-                std::copy(buffer.begin(), buffer.end(), outputIt);
-                buffer.clear();
-
-                return true;
+                readEvents.fetch_add(1, std::memory_order_release);
+                readEvents.notify_one();
             }
+            return true;
         }
 
         /**
@@ -336,37 +399,24 @@ namespace Finn {
          */
         template<typename IteratorType>
         bool readWithoutInvalidation(IteratorType outputIt, int index = -1) {
-            if constexpr (multiThreaded) {
-                std::unique_lock lk(readWriteMutex);
-                if (buffer.empty()) {
-                    return false;
-                }
-
-                if (index == -1) {
-                    std::copy(buffer.begin(), buffer.end(), outputIt);
-                } else {
-                    std::copy(buffer.begin() + elementsPerPart * index, buffer.begin() + elementsPerPart * (index + 1), outputIt);
+            const std::size_t available = validParts();
+            if (available == 0) {
+                return false;
+            }
+            const std::size_t first = tail.load(std::memory_order_relaxed);
+            if (index == -1) {
+                for (std::size_t i = 0; i < available; ++i) {
+                    auto part = partSpan(first + i);
+                    outputIt = std::copy(part.begin(), part.end(), outputIt);
                 }
-
-
-                // Manual unlocking is done before notifying, to avoid waking up
-                // the waiting thread only to block again
-                lk.unlock();
-                cv.notify_one();
-                return true;
             } else {
-                if (buffer.empty()) {
+                if (static_cast<std::size_t>(index) >= available) {
                     return false;
                 }
-
-                if (index == -1) {
-                    std::copy(buffer.begin(), buffer.end(), outputIt);
-                } else {
-                    std::copy(buffer.begin() + elementsPerPart * index, buffer.begin() + elementsPerPart * (index + 1), outputIt);
-                }
-
-                return true;
+                auto part = partSpan(first + static_cast<std::size_t>(index));
+                std::copy(part.begin(), part.end(), outputIt);
             }
+            return true;
         }
     };
 }  // namespace Finn
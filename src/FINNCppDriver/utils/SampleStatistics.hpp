@@ -0,0 +1,129 @@
+/**
+ * @file SampleStatistics.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Descriptive statistics of measured samples, used by the benchmark modes of the driver
+ * @version 0.1
+ * @date 2024-02-26
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef SAMPLESTATISTICS
+#define SAMPLESTATISTICS
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <nlohmann/json.hpp>
+#include <numeric>
+#include <vector>
+
+namespace Finn {
+    /**
+     * @brief Exact statistics of a set of samples. Percentiles use the nearest rank method, the variance is the unbiased sample variance.
+     *
+     */
+    struct SampleStatistics {
+        /**
+         * @brief Number of samples
+         *
+         */
+        std::size_t count = 0;
+        /**
+         * @brief Arithmetic mean
+         *
+         */
+        double mean = 0;
+        /**
+         * @brief Sample variance
+         *
+         */
+        double variance = 0;
+        /**
+         * @brief Sample standard deviation
+         *
+         */
+        double stddev = 0;
+        /**
+         * @brief Smallest sample
+         *
+         */
+        double min = 0;
+        /**
+         * @brief Largest sample
+         *
+         */
+        double max = 0;
+        /**
+         * @brief Median
+         *
+         */
+        double p50 = 0;
+        /**
+         * @brief 90th percentile
+         *
+         */
+        double p90 = 0;
+        /**
+         * @brief 99th percentile
+         *
+         */
+        double p99 = 0;
+        /**
+         * @brief 99.9th percentile
+         *
+         */
+        double p999 = 0;
+
+        /**
+         * @brief Compute the statistics of the given samples
+         *
+         * @param samples Reordered by the computation
+         * @return SampleStatistics
+         */
+        static SampleStatistics compute(std::vector<double>& samples) {
+            SampleStatistics stats;
+            stats.count = samples.size();
+            if (samples.empty()) {
+                return stats;
+            }
+            std::sort(samples.begin(), samples.end());
+            stats.min = samples.front();
+            stats.max = samples.back();
+            stats.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(stats.count);
+            if (stats.count > 1) {
+                double squares = 0;
+                for (double sample : samples) {
+                    squares += (sample - stats.mean) * (sample - stats.mean);
+                }
+                stats.variance = squares / static_cast<double>(stats.count - 1);
+                stats.stddev = std::sqrt(stats.variance);
+            }
+            auto percentile = [&samples](double quantile) {
+                const auto rank = static_cast<std::size_t>(std::ceil(quantile * static_cast<double>(samples.size())));
+                return samples[std::clamp<std::size_t>(rank, 1, samples.size()) - 1];
+            };
+            stats.p50 = percentile(0.5);
+            stats.p90 = percentile(0.9);
+            stats.p99 = percentile(0.99);
+            stats.p999 = percentile(0.999);
+            return stats;
+        }
+    };
+
+    /**
+     * @brief SampleStatistics -> JSON
+     *
+     * @param j
+     * @param stats
+     */
+    // NOLINTNEXTLINE
+    inline void to_json(nlohmann::json& j, const SampleStatistics& stats) {
+        j = nlohmann::json{{"count", stats.count}, {"mean", stats.mean}, {"variance", stats.variance}, {"stddev", stats.stddev}, {"min", stats.min}, {"max", stats.max},
+                           {"p50", stats.p50},     {"p90", stats.p90},   {"p99", stats.p99},           {"p999", stats.p999}};
+    }
+}  // namespace Finn
+
+#endif  // SAMPLESTATISTICS
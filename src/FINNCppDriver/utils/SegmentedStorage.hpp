@@ -0,0 +1,253 @@
+/**
+ * @file SegmentedStorage.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Bounded storage of batch elements in fixed-size chunks that are handed out without copying
+ * @version 0.1
+ * @date 2024-02-21
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef SEGMENTEDSTORAGE
+#define SEGMENTEDSTORAGE
+
+#include <FINNCppDriver/utils/FinnUtils.h>
+#include <FINNCppDriver/utils/Types.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <utility>
+
+namespace Finn {
+    /**
+     * @brief Queue of batch elements (parts) that is stored in chunks of partsPerChunk parts each. Appending never moves data that was already stored, and taking
+     * the contents only swaps the chunks out under the lock. The number of stored parts can be capped; producers then either fail to append or wait until a
+     * consumer took the contents, which puts backpressure onto them instead of growing without bound.
+     *
+     * @tparam T Type of the stored values
+     */
+    template<typename T>
+    class SegmentedStorage {
+         public:
+        /**
+         * @brief Chunks in the order they were filled. Every chunk holds a multiple of elementsPerPart values, all but the last one exactly partsPerChunk parts.
+         *
+         */
+        using chunks_t = std::deque<Finn::vector<T>>;
+
+         private:
+        std::size_t elementsPerPart;
+        std::size_t partsPerChunk;
+        /**
+         * @brief Maximum number of stored parts, 0 if unbounded
+         *
+         */
+        std::size_t maxParts;
+        std::size_t storedParts = 0;
+        chunks_t chunks;
+        mutable std::mutex storageMutex;
+        std::condition_variable_any spaceFreed;
+
+        bool hasSpace() const { return maxParts == 0 || storedParts < maxParts; }
+
+         public:
+        /**
+         * @brief Construct a new Segmented Storage object
+         *
+         * @param pElementsPerPart Number of values per part
+         * @param pPartsPerChunk Number of parts per chunk
+         * @param pMaxParts Maximum number of stored parts, 0 if unbounded
+         */
+        SegmentedStorage(std::size_t pElementsPerPart, std::size_t pPartsPerChunk, std::size_t pMaxParts = 0) : elementsPerPart(pElementsPerPart), partsPerChunk(pPartsPerChunk), maxParts(pMaxParts) {
+            if (elementsPerPart == 0 || partsPerChunk == 0) {
+                FinnUtils::logAndError<std::invalid_argument>("SegmentedStorage needs at least one element per part and one part per chunk!");
+            }
+        }
+
+        SegmentedStorage(SegmentedStorage&&) = delete;
+        SegmentedStorage(const SegmentedStorage&) = delete;
+        SegmentedStorage& operator=(SegmentedStorage&&) = delete;
+        SegmentedStorage& operator=(const SegmentedStorage&) = delete;
+        ~SegmentedStorage() = default;
+
+        /**
+         * @brief Append one part if the capacity permits it
+         *
+         * @param part Exactly elementsPerPart values
+         * @return true
+         * @return false The storage is full
+         */
+        bool tryAppend(std::span<const T> part) {
+            if (part.size() != elementsPerPart) {
+                FinnUtils::logAndError<std::length_error>("Part of " + std::to_string(part.size()) + " values does not match the part size " + std::to_string(elementsPerPart) + " of the storage!");
+            }
+            std::lock_guard guard(storageMutex);
+            if (!hasSpace()) {
+                return false;
+            }
+            if (chunks.empty() || chunks.back().size() == partsPerChunk * elementsPerPart) {
+                chunks.emplace_back().reserve(partsPerChunk * elementsPerPart);
+            }
+            chunks.back().insert(chunks.back().end(), part.begin(), part.end());
+            ++storedParts;
+            return true;
+        }
+
+        /**
+         * @brief Block until at least one part can be appended
+         *
+         * @param stoken Aborts the wait
+         * @return true
+         * @return false Stop was requested before space became available
+         */
+        bool waitForSpace(std::stop_token stoken) {
+            std::unique_lock lock(storageMutex);
+            return spaceFreed.wait(lock, stoken, [this]() { return hasSpace(); });
+        }
+
+        /**
+         * @brief Take all chunks out of the storage. Only swaps the chunk list under the lock.
+         *
+         * @return chunks_t
+         */
+        chunks_t takeChunks() {
+            chunks_t taken;
+            {
+                std::lock_guard guard(storageMutex);
+                taken.swap(chunks);
+                storedParts = 0;
+            }
+            spaceFreed.notify_all();
+            return taken;
+        }
+
+        /**
+         * @brief Take the whole contents as one contiguous vector. A single chunk is moved out, several chunks are joined after the lock was released.
+         *
+         * @return Finn::vector<T>
+         */
+        Finn::vector<T> take() {
+            chunks_t taken = takeChunks();
+            if (taken.empty()) {
+                return {};
+            }
+            if (taken.size() == 1) {
+                return std::move(taken.front());
+            }
+            std::size_t total = 0;
+            for (auto&& chunk : taken) {
+                total += chunk.size();
+            }
+            Finn::vector<T> joined;
+            joined.reserve(total);
+            for (auto&& chunk : taken) {
+                joined.insert(joined.end(), chunk.begin(), chunk.end());
+            }
+            return joined;
+        }
+
+        /**
+         * @brief Drop the contents
+         *
+         */
+        void clear() { takeChunks(); }
+
+        /**
+         * @brief Set the maximum number of stored parts. Parts that are already stored are kept, even if they exceed the new capacity.
+         *
+         * @param pMaxParts 0 if unbounded
+         */
+        void setCapacity(std::size_t pMaxParts) {
+            {
+                std::lock_guard guard(storageMutex);
+                maxParts = pMaxParts;
+            }
+            spaceFreed.notify_all();
+        }
+
+        /**
+         * @brief Get the maximum number of stored parts, 0 if unbounded
+         *
+         * @return std::size_t
+         */
+        std::size_t getCapacity() const {
+            std::lock_guard guard(storageMutex);
+            return maxParts;
+        }
+
+        /**
+         * @brief Number of stored parts
+         *
+         * @return std::size_t
+         */
+        std::size_t size() const {
+            std::lock_guard guard(storageMutex);
+            return storedParts;
+        }
+
+        /**
+         * @brief Number of stored values
+         *
+         * @return std::size_t
+         */
+        std::size_t elements() const { return size() * elementsPerPart; }
+
+        /**
+         * @brief Number of chunks currently in use
+         *
+         * @return std::size_t
+         */
+        std::size_t chunkCount() const {
+            std::lock_guard guard(storageMutex);
+            return chunks.size();
+        }
+
+        /**
+         * @brief Check if no part can be appended
+         *
+         * @return true
+         * @return false
+         */
+        bool full() const {
+            std::lock_guard guard(storageMutex);
+            return !hasSpace();
+        }
+
+        /**
+         * @brief Check if no part is stored
+         *
+         * @return true
+         * @return false
+         */
+        bool empty() const { return size() == 0; }
+
+        /**
+         * @brief Number of values per part
+         *
+         * @return std::size_t
+         */
+        std::size_t getElementsPerPart() const { return elementsPerPart; }
+
+        /**
+         * @brief Number of parts per chunk
+         *
+         * @return std::size_t
+         */
+        std::size_t getPartsPerChunk() const { return partsPerChunk; }
+
+#ifdef UNITTEST
+        chunks_t& testGetChunks() { return chunks; }
+#endif
+    };
+}  // namespace Finn
+
+#endif  // SEGMENTEDSTORAGE
@@ -0,0 +1,539 @@
+/**
+ * @file SharedMemoryRing.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Request slots in POSIX shared memory through which local processes hand packed samples to an inference daemon
+ * @version 0.1
+ * @date 2024-03-09
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef SHAREDMEMORYRING
+#define SHAREDMEMORYRING
+
+#include <FINNCppDriver/utils/FinnUtils.h>
+#include <FINNCppDriver/utils/Logger.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace Finn {
+    /**
+     * @brief State of a request slot. A slot is claimed by a client (FREE -> WRITING), filled and submitted (SUBMITTED), taken by the daemon (RUNNING) and handed back
+     * with its result (DONE or FAILED). The client reads the result and frees the slot again.
+     *
+     */
+    enum class SLOT_STATE : uint32_t { FREE = 0, WRITING = 1, SUBMITTED = 2, RUNNING = 3, DONE = 4, FAILED = 5 };
+
+    /**
+     * @brief Blocking helper for waiting on a value in shared memory. Futex based atomic waits are process private, so waiting spins first, then yields and finally
+     * sleeps with a short period.
+     *
+     */
+    class SharedMemoryBackoff {
+        static constexpr unsigned int spinRounds = 256;
+        static constexpr unsigned int yieldRounds = 64;
+        static constexpr std::chrono::microseconds sleepPeriod{20};
+        unsigned int rounds = 0;
+
+         public:
+        /**
+         * @brief Wait a little longer than the last time
+         *
+         */
+        void pause() {
+            if (rounds < spinRounds) {
+                ++rounds;
+            } else if (rounds < spinRounds + yieldRounds) {
+                ++rounds;
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(sleepPeriod);
+            }
+        }
+
+        /**
+         * @brief Start spinning again, e.g. after work was found
+         *
+         */
+        void reset() { rounds = 0; }
+    };
+
+    /**
+     * @brief A fixed number of request slots in a named POSIX shared memory object. Every slot holds the packed input of one sample and the packed output the daemon
+     * writes back. The daemon creates the ring for its accelerator, clients open it by name and write their samples in the device format directly into the slots,
+     * so neither side copies or packs more than once.
+     *
+     * The mapping may be at a different address in every process, so the ring only stores offsets. Its atomics are lock free and therefore usable across processes.
+     *
+     * The ring records the process id of the daemon and of the client that holds a slot. A ring left behind by a daemon that died is replaced by the next daemon
+     * that creates it, and slots held by clients that died are handed back by reclaimAbandoned().
+     *
+     */
+    class SharedMemoryRing {
+         public:
+        /**
+         * @brief Layout version, a client refuses to attach to a ring of another version
+         *
+         */
+        static constexpr uint32_t layoutVersion = 2;
+
+         private:
+        static constexpr uint64_t ringMagic = 0x46494e4e52494e47;  // "FINNRING"
+        static constexpr std::size_t cacheLineSize = 64;
+
+        static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free && std::atomic<pid_t>::is_always_lock_free,
+                      "Shared memory rings need address free atomics!");
+
+        /**
+         * @brief Placed at the start of the shared memory object
+         *
+         */
+        struct alignas(cacheLineSize) Header {
+            /**
+             * @brief Written last when the ring is created, a client only attaches to a completely initialized ring
+             *
+             */
+            std::atomic<uint64_t> magic;
+            uint32_t version;
+            uint32_t slots;
+            uint64_t inputBytes;
+            uint64_t outputBytes;
+            uint64_t slotStride;
+            /**
+             * @brief Tickets order the submissions of all clients, the daemon serves the oldest first
+             *
+             */
+            std::atomic<uint64_t> nextTicket;
+            /**
+             * @brief Cleared by the daemon when it shuts down, clients stop waiting for results then
+             *
+             */
+            std::atomic<uint32_t> serving;
+            /**
+             * @brief Process that created the ring. Placed after the fields of older layouts, so that a stale ring of any version can be recognized.
+             *
+             */
+            std::atomic<pid_t> daemon;
+        };
+
+        /**
+         * @brief Precedes the input and output bytes of every slot
+         *
+         */
+        struct alignas(cacheLineSize) Slot {
+            std::atomic<uint32_t> state;
+            uint64_t ticket;
+            /**
+             * @brief Process of the client that acquired the slot, 0 while the slot is free
+             *
+             */
+            std::atomic<pid_t> client;
+        };
+
+        std::string name;
+        void* mapping = nullptr;
+        std::size_t mappedBytes = 0;
+        bool owner = false;
+
+        /**
+         * @brief A logger prefix to determine the source of a log write
+         *
+         * @return std::string
+         */
+        static std::string loggerPrefix() { return "[SharedMemoryRing] "; }
+
+        static constexpr std::size_t roundUp(std::size_t bytes) { return (bytes + cacheLineSize - 1) / cacheLineSize * cacheLineSize; }
+
+        static std::size_t strideFor(std::size_t inputBytes, std::size_t outputBytes) { return sizeof(Slot) + roundUp(inputBytes) + roundUp(outputBytes); }
+
+        Header& header() const { return *static_cast<Header*>(mapping); }
+
+        Slot& slotHeader(std::size_t slot) const {
+            if (slot >= header().slots) {
+                FinnUtils::logAndError<std::out_of_range>(loggerPrefix() + "Slot " + std::to_string(slot) + " does not exist in ring " + name + "!");
+            }
+            return *reinterpret_cast<Slot*>(static_cast<std::byte*>(mapping) + sizeof(Header) + slot * header().slotStride);
+        }
+
+        static void* map(int descriptor, std::size_t bytes, const std::string& pName) {
+            void* address = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+            if (address == MAP_FAILED) {
+                close(descriptor);
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Could not map shared memory " + pName + ": " + std::strerror(errno));
+            }
+            return address;
+        }
+
+        /**
+         * @brief Check if a process still exists. A process of another user that cannot be signalled still counts as alive.
+         *
+         * @param pid
+         * @return true
+         * @return false
+         */
+        static bool alive(pid_t pid) { return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM); }
+
+        /**
+         * @brief Check if an existing shared memory object is a ring whose daemon stopped serving it or died without removing it
+         *
+         * @param pName
+         * @return true
+         * @return false The object is served, still being created or no ring at all
+         */
+        static bool abandoned(const std::string& pName) {
+            const int descriptor = shm_open(pName.c_str(), O_RDONLY, 0);
+            if (descriptor < 0) {
+                return false;
+            }
+            struct stat info {};
+            if (fstat(descriptor, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(Header)) {
+                close(descriptor);
+                return false;
+            }
+            void* address = mmap(nullptr, sizeof(Header), PROT_READ, MAP_SHARED, descriptor, 0);
+            close(descriptor);
+            if (address == MAP_FAILED) {
+                return false;
+            }
+            const Header& head = *static_cast<const Header*>(address);
+            bool stale = false;
+            if (head.magic.load(std::memory_order_acquire) == ringMagic) {
+                // Rings of an older layout do not record their daemon, they can only be recognized by the serving flag
+                stale = head.serving.load(std::memory_order_acquire) == 0 || (head.version == layoutVersion && !alive(head.daemon.load(std::memory_order_relaxed)));
+            }
+            munmap(address, sizeof(Header));
+            return stale;
+        }
+
+        /**
+         * @brief Exclusively create the shared memory object of a ring. A stale ring of the same name is removed first.
+         *
+         * @param pName
+         * @return int Descriptor of the new object
+         */
+        static int createObject(const std::string& pName) {
+            int descriptor = shm_open(pName.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+            int error = errno;
+            if (descriptor < 0 && error == EEXIST && abandoned(pName)) {
+                FINN_LOG(Logger::getLogger(), loglevel::warning) << loggerPrefix() << "Removing stale ring " << pName << " of a daemon that is gone";
+                shm_unlink(pName.c_str());
+                descriptor = shm_open(pName.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+                error = errno;
+            }
+            if (descriptor < 0) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Could not create shared memory " + pName + ": " + std::strerror(error));
+            }
+            return descriptor;
+        }
+
+        SharedMemoryRing(std::string pName, void* pMapping, std::size_t pMappedBytes, bool pOwner) : name(std::move(pName)), mapping(pMapping), mappedBytes(pMappedBytes), owner(pOwner) {}
+
+         public:
+        /**
+         * @brief Create a new ring. Fails if a ring of that name is served by another daemon. A ring whose daemon died or stopped serving is replaced.
+         *
+         * @param pName Name of the shared memory object, starting with "/"
+         * @param slots Number of requests that can be in flight at once
+         * @param inputBytes Packed input bytes of one sample
+         * @param outputBytes Packed output bytes of one sample
+         * @return SharedMemoryRing The owner of the ring, removes the shared memory object when destroyed
+         */
+        static SharedMemoryRing create(const std::string& pName, std::size_t slots, std::size_t inputBytes, std::size_t outputBytes) {
+            if (slots == 0 || slots > UINT32_MAX || inputBytes == 0 || outputBytes == 0) {
+                FinnUtils::logAndError<std::invalid_argument>(loggerPrefix() + "A ring needs at least one slot and non empty samples!");
+            }
+            const std::size_t stride = strideFor(inputBytes, outputBytes);
+            const std::size_t bytes = sizeof(Header) + slots * stride;
+            const int descriptor = createObject(pName);
+            if (ftruncate(descriptor, static_cast<off_t>(bytes)) != 0) {
+                close(descriptor);
+                shm_unlink(pName.c_str());
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Could not size shared memory " + pName + ": " + std::strerror(errno));
+            }
+            void* address = nullptr;
+            try {
+                address = map(descriptor, bytes, pName);
+            } catch (...) {
+                shm_unlink(pName.c_str());
+                throw;
+            }
+            close(descriptor);
+            SharedMemoryRing ring(pName, address, bytes, true);
+            // ftruncate zero fills, so every slot starts FREE. The magic is written last, a client that attaches in between sees an invalid ring.
+            auto* head = new (address) Header{0, layoutVersion, static_cast<uint32_t>(slots), inputBytes, outputBytes, stride};
+            for (std::size_t i = 0; i < slots; ++i) {
+                new (&ring.slotHeader(i)) Slot{};
+            }
+            head->serving.store(1, std::memory_order_relaxed);
+            head->daemon.store(getpid(), std::memory_order_relaxed);
+            head->magic.store(ringMagic, std::memory_order_release);
+            return ring;
+        }
+
+        /**
+         * @brief Attach to the ring of a daemon
+         *
+         * @param pName Name of the shared memory object
+         * @return SharedMemoryRing
+         */
+        static SharedMemoryRing open(const std::string& pName) {
+            const int descriptor = shm_open(pName.c_str(), O_RDWR, 0);
+            if (descriptor < 0) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Could not open shared memory " + pName + ", is the daemon running? " + std::strerror(errno));
+            }
+            struct stat info {};
+            if (fstat(descriptor, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(Header)) {
+                close(descriptor);
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Shared memory " + pName + " is not a request ring!");
+            }
+            const auto bytes = static_cast<std::size_t>(info.st_size);
+            void* address = map(descriptor, bytes, pName);
+            close(descriptor);
+            SharedMemoryRing ring(pName, address, bytes, false);
+            const Header& head = ring.header();
+            if (head.magic.load(std::memory_order_acquire) != ringMagic || head.version != layoutVersion || sizeof(Header) + head.slots * head.slotStride > bytes) {
+                FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Shared memory " + pName + " is not a request ring of layout version " + std::to_string(layoutVersion) + "!");
+            }
+            return ring;
+        }
+
+        SharedMemoryRing(SharedMemoryRing&& other) noexcept : name(std::move(other.name)), mapping(std::exchange(other.mapping, nullptr)), mappedBytes(other.mappedBytes), owner(std::exchange(other.owner, false)) {}
+        SharedMemoryRing(const SharedMemoryRing&) = delete;
+        SharedMemoryRing& operator=(SharedMemoryRing&&) = delete;
+        SharedMemoryRing& operator=(const SharedMemoryRing&) = delete;
+
+        /**
+         * @brief Unmap the ring. The owner also removes the name, clients that are still attached keep their mapping.
+         *
+         */
+        ~SharedMemoryRing() {
+            if (mapping == nullptr) {
+                return;
+            }
+            if (owner) {
+                header().serving.store(0, std::memory_order_release);
+                shm_unlink(name.c_str());
+            }
+            munmap(mapping, mappedBytes);
+        }
+
+        const std::string& getName() const { return name; }
+
+        std::size_t slots() const { return header().slots; }
+
+        std::size_t inputBytes() const { return header().inputBytes; }
+
+        std::size_t outputBytes() const { return header().outputBytes; }
+
+        /**
+         * @brief Check if the daemon still serves the ring
+         *
+         * @return true
+         * @return false
+         */
+        bool serving() const { return header().serving.load(std::memory_order_acquire) != 0; }
+
+        /**
+         * @brief Stop serving, clients waiting for a result get an error
+         *
+         */
+        void stopServing() { header().serving.store(0, std::memory_order_release); }
+
+        /**
+         * @brief Packed input of a slot
+         *
+         * @param slot
+         * @return std::span<uint8_t>
+         */
+        std::span<uint8_t> input(std::size_t slot) const { return {reinterpret_cast<uint8_t*>(&slotHeader(slot) + 1), header().inputBytes}; }
+
+        /**
+         * @brief Packed output of a slot
+         *
+         * @param slot
+         * @return std::span<uint8_t>
+         */
+        std::span<uint8_t> output(std::size_t slot) const { return {reinterpret_cast<uint8_t*>(&slotHeader(slot) + 1) + roundUp(header().inputBytes), header().outputBytes}; }
+
+        /**
+         * @brief Current state of a slot
+         *
+         * @param slot
+         * @return SLOT_STATE
+         */
+        SLOT_STATE state(std::size_t slot) const { return static_cast<SLOT_STATE>(slotHeader(slot).state.load(std::memory_order_acquire)); }
+
+        /**
+         * @brief Ticket of the last submission in a slot
+         *
+         * @param slot
+         * @return uint64_t
+         */
+        uint64_t ticket(std::size_t slot) const { return slotHeader(slot).ticket; }
+
+        /**
+         * @brief Atomically move a slot from one state to another
+         *
+         * @param slot
+         * @param expected
+         * @param desired
+         * @return true The slot was in the expected state and is now in the desired one
+         * @return false The slot is in another state
+         */
+        bool transition(std::size_t slot, SLOT_STATE expected, SLOT_STATE desired) {
+            auto current = static_cast<uint32_t>(expected);
+            return slotHeader(slot).state.compare_exchange_strong(current, static_cast<uint32_t>(desired), std::memory_order_acq_rel, std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Publish a state written by the only current user of a slot, e.g. the result of the daemon
+         *
+         * @param slot
+         * @param desired
+         */
+        void publish(std::size_t slot, SLOT_STATE desired) { slotHeader(slot).state.store(static_cast<uint32_t>(desired), std::memory_order_release); }
+
+        /**
+         * @brief Claim a free slot for writing a request. Blocks while all slots are in use.
+         *
+         * @return std::size_t The claimed slot
+         */
+        std::size_t acquire() {
+            SharedMemoryBackoff backoff;
+            // Start at a different slot per ticket so that clients do not all contend on slot 0
+            const std::size_t start = static_cast<std::size_t>(header().nextTicket.load(std::memory_order_relaxed));
+            while (true) {
+                for (std::size_t i = 0; i < slots(); ++i) {
+                    const std::size_t slot = (start + i) % slots();
+                    if (transition(slot, SLOT_STATE::FREE, SLOT_STATE::WRITING)) {
+                        slotHeader(slot).client.store(getpid(), std::memory_order_relaxed);
+                        return slot;
+                    }
+                }
+                if (!serving()) {
+                    FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Daemon of ring " + name + " stopped serving!");
+                }
+                backoff.pause();
+            }
+        }
+
+        /**
+         * @brief Hand a written slot to the daemon
+         *
+         * @param slot Slot returned by acquire, its input holds a packed sample
+         */
+        void submit(std::size_t slot) {
+            Slot& entry = slotHeader(slot);
+            if (static_cast<SLOT_STATE>(entry.state.load(std::memory_order_relaxed)) != SLOT_STATE::WRITING) {
+                FinnUtils::logAndError<std::logic_error>(loggerPrefix() + "Only acquired slots can be submitted!");
+            }
+            entry.ticket = header().nextTicket.fetch_add(1, std::memory_order_relaxed);
+            entry.state.store(static_cast<uint32_t>(SLOT_STATE::SUBMITTED), std::memory_order_release);
+        }
+
+        /**
+         * @brief Wait for the result of a submitted slot. The slot stays owned by the caller until release().
+         *
+         * @param slot
+         * @return std::span<const uint8_t> Packed output of the sample
+         */
+        std::span<const uint8_t> wait(std::size_t slot) {
+            SharedMemoryBackoff backoff;
+            while (true) {
+                const auto current = state(slot);
+                if (current == SLOT_STATE::DONE) {
+                    return output(slot);
+                }
+                if (current == SLOT_STATE::FAILED) {
+                    FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Daemon could not run the request in slot " + std::to_string(slot) + "!");
+                }
+                if (!serving()) {
+                    FinnUtils::logAndError<std::runtime_error>(loggerPrefix() + "Daemon of ring " + name + " stopped serving!");
+                }
+                backoff.pause();
+            }
+        }
+
+        /**
+         * @brief Give a slot back after its result was read
+         *
+         * @param slot
+         */
+        void release(std::size_t slot) {
+            slotHeader(slot).client.store(0, std::memory_order_relaxed);
+            publish(slot, SLOT_STATE::FREE);
+        }
+
+        /**
+         * @brief Free the slots held by clients that died before they released them, while writing their request or before reading its result. Requests such a
+         * client submitted are still run and freed once their result is ready. Called periodically by the daemon.
+         *
+         * @return std::size_t Number of freed slots
+         */
+        std::size_t reclaimAbandoned() {
+            std::size_t reclaimed = 0;
+            for (std::size_t slot = 0; slot < slots(); ++slot) {
+                const SLOT_STATE current = state(slot);
+                if (current != SLOT_STATE::WRITING && current != SLOT_STATE::DONE && current != SLOT_STATE::FAILED) {
+                    continue;
+                }
+                // 0 if the client did not record itself yet
+                const pid_t client = slotHeader(slot).client.load(std::memory_order_relaxed);
+                if (client == 0 || alive(client)) {
+                    continue;
+                }
+                // Nobody else changes the slot: its client is gone and it is not free
+                slotHeader(slot).client.store(0, std::memory_order_relaxed);
+                if (transition(slot, current, SLOT_STATE::FREE)) {
+                    ++reclaimed;
+                }
+            }
+            return reclaimed;
+        }
+
+        /**
+         * @brief Run one packed sample through the daemon, copying its result out
+         *
+         * @param packedInput Exactly inputBytes() bytes
+         * @param packedOutput Receives outputBytes() bytes
+         */
+        void infer(std::span<const uint8_t> packedInput, std::span<uint8_t> packedOutput) {
+            if (packedInput.size() != inputBytes() || packedOutput.size() < outputBytes()) {
+                FinnUtils::logAndError<std::length_error>(loggerPrefix() + "Requests of ring " + name + " have " + std::to_string(inputBytes()) + " input and " + std::to_string(outputBytes()) + " output bytes!");
+            }
+            const std::size_t slot = acquire();
+            std::copy(packedInput.begin(), packedInput.end(), input(slot).begin());
+            submit(slot);
+            try {
+                auto result = wait(slot);
+                std::copy(result.begin(), result.end(), packedOutput.begin());
+            } catch (...) {
+                release(slot);
+                throw;
+            }
+            release(slot);
+        }
+    };
+}  // namespace Finn
+
+#endif  // SHAREDMEMORYRING
@@ -0,0 +1,159 @@
+/**
+ * @file StaticShapes.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Compile time shapes of the input and output buffers of a fixed network
+ * @version 0.1
+ * @date 2024-03-06
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef STATICSHAPES
+#define STATICSHAPES
+
+#include <FINNCppDriver/utils/ConfigurationStructs.h>
+#include <FINNCppDriver/utils/FinnUtils.h>
+#include <FINNCppDriver/utils/TransferPlan.h>
+
+#include <FINNCppDriver/utils/FinnDatatypes.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+namespace Finn {
+    /**
+     * @brief Build a shape usable as template argument of StaticBufferShape, e.g. staticShape(1, 10, 30)
+     *
+     * @tparam Dims
+     * @param dims
+     * @return constexpr std::array<unsigned int, sizeof...(Dims)>
+     */
+    template<typename... Dims>
+    constexpr std::array<unsigned int, sizeof...(Dims)> staticShape(Dims... dims) {
+        return {static_cast<unsigned int>(dims)...};
+    }
+
+    /**
+     * @brief Marks a buffer whose shapes are only known at runtime from the config. This is the default of the BaseDriver.
+     *
+     */
+    struct DynamicBufferShape {
+        /**
+         * @brief @see StaticBufferShape::isStatic
+         *
+         */
+        static constexpr bool isStatic = false;
+
+        /**
+         * @brief Runtime shapes are checked when the TransferPlan of the buffer is built
+         *
+         * @tparam U
+         * @return true
+         */
+        template<IsDatatype U>
+        static constexpr bool fits() {
+            return true;
+        }
+    };
+
+    /**
+     * @brief Shapes of a buffer that are known at compile time, usually from the FinnDriverUsedShapes.h header generated by the FINN compiler. All shapes include the
+     * batch dimension as first dimension, like the shapes of the config. Packing and unpacking use the constant row geometry, so the kernels are unrolled for the
+     * innermost folded dimension and its padding.
+     *
+     * @tparam NormalShape
+     * @tparam FoldedShape
+     * @tparam PackedShape
+     */
+    template<auto NormalShape, auto FoldedShape, auto PackedShape>
+    struct StaticBufferShape {
+        static_assert(FoldedShape.size() > 1 && PackedShape.size() > 1, "Static shapes have to include the batch dimension!");
+        static_assert(FoldedShape.back() > 0 && PackedShape.back() > 0, "Static shapes may not be empty!");
+
+        /**
+         * @brief Shapes are available at compile time
+         *
+         */
+        static constexpr bool isStatic = true;
+        /**
+         * @brief Normal shape of one batch element
+         *
+         */
+        static constexpr auto normalShape = NormalShape;
+        /**
+         * @brief Folded shape of one batch element
+         *
+         */
+        static constexpr auto foldedShape = FoldedShape;
+        /**
+         * @brief Packed shape of one batch element
+         *
+         */
+        static constexpr auto packedShape = PackedShape;
+        /**
+         * @brief Number of folded elements per row, @see TransferPlan
+         *
+         */
+        static constexpr std::size_t elementsPerInnerDim = FoldedShape.back();
+        /**
+         * @brief Number of packed bytes per row, @see TransferPlan
+         *
+         */
+        static constexpr std::size_t bytesPerInnerDim = PackedShape.back();
+        /**
+         * @brief Number of rows per batch element
+         *
+         */
+        static constexpr std::size_t innerDimsPerSample = FinnUtils::shapeToElementsConstexpr(PackedShape) / PackedShape[0] / bytesPerInnerDim;
+        /**
+         * @brief Number of folded elements per batch element
+         *
+         */
+        static constexpr std::size_t elementsPerSample = innerDimsPerSample * elementsPerInnerDim;
+        /**
+         * @brief Number of packed bytes per batch element
+         *
+         */
+        static constexpr std::size_t bytesPerSample = innerDimsPerSample * bytesPerInnerDim;
+
+        static_assert(FinnUtils::shapeToElementsConstexpr(FoldedShape) / FoldedShape[0] / elementsPerInnerDim == innerDimsPerSample, "Folded shape does not fit into the packed shape!");
+        static_assert(FinnUtils::shapeToElementsConstexpr(NormalShape) / NormalShape[0] == elementsPerSample, "Normal and folded shape hold a different number of elements!");
+
+        /**
+         * @brief Check if a row of elementsPerInnerDim values of U fits into bytesPerInnerDim bytes
+         *
+         * @tparam U
+         * @return true
+         * @return false
+         */
+        template<IsDatatype U>
+        static constexpr bool fits() {
+            return elementsPerInnerDim * U().bitwidth() <= bytesPerInnerDim * 8;
+        }
+
+        /**
+         * @brief Check if the buffer described by the config has these shapes. The batch dimension is not compared.
+         *
+         * @param descriptor
+         * @return true
+         * @return false
+         */
+        static bool matches(const ExtendedBufferDescriptor& descriptor) {
+            auto equalPerSample = [](const auto& expected, const shape_t& actual) { return actual.size() == expected.size() && std::equal(expected.begin() + 1, expected.end(), actual.begin() + 1); };
+            return equalPerSample(NormalShape, descriptor.normalShape) && equalPerSample(FoldedShape, descriptor.foldedShape) && equalPerSample(PackedShape, descriptor.packedShape);
+        }
+
+        /**
+         * @brief Check if a transfer plan has the row geometry of these shapes, so that the static kernels can be used for it
+         *
+         * @param plan
+         * @return true
+         * @return false
+         */
+        static bool matches(const TransferPlan& plan) { return plan.elementsPerInnerDim == elementsPerInnerDim && plan.bytesPerInnerDim == bytesPerInnerDim; }
+    };
+}  // namespace Finn
+
+#endif  // STATICSHAPES
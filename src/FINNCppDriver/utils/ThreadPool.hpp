@@ -0,0 +1,251 @@
+/**
+ * @file ThreadPool.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Persistent host worker pool used to parallelize packing and unpacking
+ * @version 0.1
+ * @date 2024-01-22
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef THREADPOOL
+#define THREADPOOL
+
+#include <FINNCppDriver/utils/Logger.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace Finn {
+    /**
+     * @brief Fixed size pool of persistent worker threads for data parallel host work (packing and unpacking).
+     *
+     * Work is submitted with parallelFor, which splits a range of equally sized items into contiguous chunks of at least grainBytes bytes. The calling thread works
+     * on chunks as well, so a pool of n threads spawns n - 1 workers. Ranges that are too small to be split are executed inline without waking any worker. Workers
+     * sleep on an atomic wait between jobs, so an idle pool costs no CPU time. Unlike OpenMP the pool has no process wide state, so it does not interfere with other
+     * OpenMP users in the same process.
+     *
+     * @attention Only one parallelFor runs on the pool at a time. Concurrent or nested calls are executed inline on the calling thread.
+     */
+    class ThreadPool {
+         public:
+        /**
+         * @brief Minimum number of bytes per chunk if nothing else is specified
+         *
+         */
+        static constexpr std::size_t defaultGrainBytes = 64UL * 1024;
+
+        /**
+         * @brief Default number of threads (including the calling thread): one per hardware thread, like the OpenMP loops the pool replaced
+         *
+         * @return std::size_t
+         */
+        static std::size_t defaultThreads() { return std::max<std::size_t>(std::thread::hardware_concurrency(), 1); }
+
+         private:
+        std::size_t grain;
+
+        std::mutex submitMutex;
+        std::atomic<uint32_t> generation = 0;
+        std::atomic<bool> stopping = false;
+        std::atomic<std::size_t> nextChunk = 0;
+        // Waited on, so kept at 32 bit to map directly onto a futex
+        std::atomic<uint32_t> outstanding = 0;
+
+        // Description of the current job. Only written by the submitter while no participant is active
+        std::size_t jobItems = 0;
+        std::size_t jobChunks = 0;
+        void* jobContext = nullptr;
+        void (*jobInvoke)(void*, std::size_t, std::size_t) = nullptr;
+        std::mutex errorMutex;
+        std::exception_ptr jobError;
+
+        std::vector<std::jthread> workers;
+
+        /**
+         * @brief True on threads that currently execute a chunk
+         *
+         * @return bool&
+         */
+        static bool& inParallelRegion() {
+            thread_local bool inside = false;
+            return inside;
+        }
+
+        /**
+         * @brief A logger prefix to determine the source of a log write
+         *
+         * @return std::string
+         */
+        static std::string loggerPrefix() { return "[ThreadPool] "; }
+
+        /**
+         * @brief Process chunks of the current job until none are left, then check out of the job
+         *
+         */
+        void participate() {
+            inParallelRegion() = true;
+            for (std::size_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed); chunk < jobChunks; chunk = nextChunk.fetch_add(1, std::memory_order_relaxed)) {
+                const std::size_t begin = chunk * jobItems / jobChunks;
+                const std::size_t end = (chunk + 1) * jobItems / jobChunks;
+                try {
+                    jobInvoke(jobContext, begin, end);
+                } catch (...) {
+                    std::lock_guard guard(errorMutex);
+                    if (!jobError) {
+                        jobError = std::current_exception();
+                    }
+                }
+            }
+            inParallelRegion() = false;
+            if (outstanding.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                outstanding.notify_all();
+            }
+        }
+
+        /**
+         * @brief Main loop of a worker thread
+         *
+         */
+        void workerLoop() {
+            // Start from the initial generation: a job may already be published before this thread runs, and it has to take part in it
+            uint32_t seen = 0;
+            while (true) {
+                generation.wait(seen, std::memory_order_acquire);
+                seen = generation.load(std::memory_order_acquire);
+                if (stopping.load(std::memory_order_acquire)) {
+                    return;
+                }
+                participate();
+            }
+        }
+
+        /**
+         * @brief Pin a worker thread to a CPU
+         *
+         * @param thread
+         * @param cpu
+         */
+        static void pin(std::jthread& thread, unsigned int cpu) {
+#ifdef __linux__
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            if (pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &set) != 0) {
+                FINN_LOG(Logger::getLogger(), loglevel::warning) << loggerPrefix() << "Could not pin worker thread to CPU " << cpu;
+            }
+#else
+            FINN_LOG(Logger::getLogger(), loglevel::warning) << loggerPrefix() << "Thread affinity is not supported on this platform, ignoring CPU " << cpu << " for thread " << thread.get_id();
+#endif
+        }
+
+         public:
+        /**
+         * @brief Construct a new Thread Pool
+         *
+         * @param threads Number of threads working on a job, including the calling thread. 1 executes everything inline.
+         * @param cpus CPUs the workers are pinned to (worker i is pinned to cpus[i % cpus.size()]). Empty to not pin the workers.
+         * @param grainBytes Minimum number of bytes a chunk of work has to contain
+         */
+        explicit ThreadPool(std::size_t threads = defaultThreads(), const std::vector<unsigned int>& cpus = {}, std::size_t grainBytes = defaultGrainBytes) : grain(std::max<std::size_t>(grainBytes, 1)) {
+            const std::size_t workerCount = std::max<std::size_t>(threads, 1) - 1;
+            workers.reserve(workerCount);
+            for (std::size_t i = 0; i < workerCount; ++i) {
+                workers.emplace_back([this]() { workerLoop(); });
+                if (!cpus.empty()) {
+                    pin(workers.back(), cpus[i % cpus.size()]);
+                }
+            }
+        }
+
+        /**
+         * @brief Destroy the Thread Pool object. Waits for the workers to terminate.
+         *
+         */
+        ~ThreadPool() {
+            stopping.store(true, std::memory_order_release);
+            generation.fetch_add(1, std::memory_order_release);
+            generation.notify_all();
+            workers.clear();
+        }
+
+        ThreadPool(ThreadPool&&) = delete;
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(ThreadPool&&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * @brief Number of threads working on a job, including the calling thread
+         *
+         * @return std::size_t
+         */
+        std::size_t size() const { return workers.size() + 1; }
+
+        /**
+         * @brief Minimum number of bytes per chunk
+         *
+         * @return std::size_t
+         */
+        std::size_t grainBytes() const { return grain; }
+
+        /**
+         * @brief Call fn(begin, end) for contiguous subranges that together cover [0, items). Returns once all subranges are processed.
+         * The number of subranges is chosen such that every subrange contains at least grainBytes() bytes, but there are never more subranges than threads.
+         * Exceptions thrown by fn are rethrown on the calling thread.
+         *
+         * @tparam F Callable with signature void(std::size_t, std::size_t)
+         * @param items Number of items
+         * @param bytesPerItem Number of bytes processed per item, used to balance the chunks
+         * @param fn
+         */
+        template<typename F>
+        void parallelFor(std::size_t items, std::size_t bytesPerItem, F&& fn) {
+            const std::size_t minItemsPerChunk = std::max<std::size_t>(grain / std::max<std::size_t>(bytesPerItem, 1), 1);
+            const std::size_t chunks = std::min(size(), (items + minItemsPerChunk - 1) / minItemsPerChunk);
+            if (chunks <= 1 || inParallelRegion()) {
+                fn(std::size_t{0}, items);
+                return;
+            }
+            std::unique_lock lock(submitMutex, std::try_to_lock);
+            if (!lock.owns_lock()) {
+                fn(std::size_t{0}, items);
+                return;
+            }
+
+            using Callable = std::remove_reference_t<F>;
+            jobItems = items;
+            jobChunks = chunks;
+            jobContext = const_cast<void*>(static_cast<const void*>(std::addressof(fn)));
+            jobInvoke = [](void* context, std::size_t begin, std::size_t end) { (*static_cast<Callable*>(context))(begin, end); };
+            jobError = nullptr;
+            nextChunk.store(0, std::memory_order_relaxed);
+            outstanding.store(static_cast<uint32_t>(size()), std::memory_order_relaxed);
+            generation.fetch_add(1, std::memory_order_release);
+            generation.notify_all();
+
+            participate();
+            // Every worker checks out of every job, so no worker can still touch the job description once this returns
+            for (uint32_t left = outstanding.load(std::memory_order_acquire); left != 0; left = outstanding.load(std::memory_order_acquire)) {
+                outstanding.wait(left, std::memory_order_acquire);
+            }
+            if (jobError) {
+                std::rethrow_exception(jobError);
+            }
+        }
+    };
+}  // namespace Finn
+
+#endif  // THREADPOOL
@@ -0,0 +1,379 @@
+/**
+ * @file TimelineTracer.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Opt-in recording of host and device activity as begin/end events, exported in the Chrome trace format (also read by Perfetto)
+ * @version 0.1
+ * @date 2024-03-19
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef TIMELINETRACER
+#define TIMELINETRACER
+
+#include <FINNCppDriver/utils/FinnUtils.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace Finn {
+    /**
+     * @brief Default number of events every thread keeps before it overwrites its oldest ones
+     *
+     */
+    constexpr std::size_t defaultTimelineCapacity = 1U << 16U;
+
+    /**
+     * @brief One span of activity on a track
+     *
+     */
+    struct TimelineEvent {
+        /**
+         * @brief Name of the span. Has to outlive the tracer, usually a string literal.
+         *
+         */
+        const char* name = "";
+        std::chrono::steady_clock::time_point begin;
+        std::chrono::steady_clock::time_point end;
+        /**
+         * @brief Track the span is shown on
+         *
+         */
+        std::uint32_t track = 0;
+        /**
+         * @brief Buffer slot the span worked on, -1 if it is not tied to a slot
+         *
+         */
+        std::int64_t slot = -1;
+        /**
+         * @brief Samples the span moved, 0 if not known
+         *
+         */
+        std::uint32_t samples = 0;
+    };
+
+    /**
+     * @brief Process wide recorder of timeline events. Disabled by default, then recording costs one relaxed atomic load. Every thread records into a ring of its own,
+     * so threads only contend with an export. Host spans go to one track per thread, device spans (a kernel run from its start until it was seen finished) to one
+     * track per compute unit and device.
+     *
+     */
+    class TimelineTracer {
+         private:
+        struct Track {
+            std::uint32_t process;
+            std::uint32_t thread;
+            std::string processName;
+            std::string threadName;
+        };
+
+        struct Shard {
+            std::mutex mutex;
+            std::vector<TimelineEvent> events;
+            std::size_t next = 0;
+            std::size_t recorded = 0;
+            std::uint32_t track = 0;
+        };
+
+        /**
+         * @brief Returns the shard of the calling thread to the tracer once the thread ends. Its events stay until they are overwritten by the next thread using it.
+         *
+         */
+        struct ShardHandle {
+            TimelineTracer& tracer;
+            Shard* shard;
+            explicit ShardHandle(TimelineTracer& pTracer) : tracer(pTracer), shard(pTracer.acquireShard()) {}
+            ShardHandle(ShardHandle&&) = delete;
+            ShardHandle(const ShardHandle&) = delete;
+            ShardHandle& operator=(ShardHandle&&) = delete;
+            ShardHandle& operator=(const ShardHandle&) = delete;
+            ~ShardHandle() { tracer.releaseShard(shard); }
+        };
+
+        std::atomic<bool> enabled{false};
+        std::atomic<std::size_t> capacity{defaultTimelineCapacity};
+        const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+        mutable std::mutex mutex;
+        std::vector<Track> tracks;
+        std::vector<std::unique_ptr<Shard>> shards;
+        std::vector<Shard*> freeShards;
+        std::uint32_t hostThreads = 0;
+
+        TimelineTracer() = default;
+
+        std::uint32_t addTrack(std::uint32_t process, const std::string& processName, const std::string& threadName) {
+            const auto thread = static_cast<std::uint32_t>(std::count_if(tracks.begin(), tracks.end(), [process](const Track& track) { return track.process == process; }));
+            tracks.push_back({process, thread, processName, threadName});
+            return static_cast<std::uint32_t>(tracks.size() - 1);
+        }
+
+        Shard* acquireShard() {
+            std::lock_guard guard(mutex);
+            Shard* shard = nullptr;
+            if (!freeShards.empty()) {
+                shard = freeShards.back();
+                freeShards.pop_back();
+            } else {
+                shard = shards.emplace_back(std::make_unique<Shard>()).get();
+            }
+            // A new thread gets a new track, even if it reuses the ring of a terminated one
+            shard->track = addTrack(0, "host", "thread " + std::to_string(hostThreads++));
+            return shard;
+        }
+
+        void releaseShard(Shard* shard) {
+            std::lock_guard guard(mutex);
+            freeShards.push_back(shard);
+        }
+
+        Shard& localShard() {
+            thread_local ShardHandle handle(*this);
+            return *handle.shard;
+        }
+
+        void push(Shard& shard, const TimelineEvent& event) {
+            std::lock_guard guard(shard.mutex);
+            const std::size_t size = capacity.load(std::memory_order_relaxed);
+            if (shard.events.size() != size) {
+                shard.events.assign(size, TimelineEvent{});
+                shard.next = 0;
+                shard.recorded = 0;
+            }
+            shard.events[shard.next] = event;
+            shard.next = (shard.next + 1) % size;
+            shard.recorded = std::min(shard.recorded + 1, size);
+        }
+
+        double micros(std::chrono::steady_clock::time_point time) const { return std::chrono::duration<double, std::micro>(time - epoch).count(); }
+
+         public:
+        TimelineTracer(TimelineTracer&&) = delete;
+        TimelineTracer(const TimelineTracer&) = delete;
+        TimelineTracer& operator=(TimelineTracer&&) = delete;
+        TimelineTracer& operator=(const TimelineTracer&) = delete;
+        ~TimelineTracer() = default;
+
+        /**
+         * @brief Get the tracer of the process
+         *
+         * @return TimelineTracer&
+         */
+        static TimelineTracer& global() {
+            static TimelineTracer tracer;
+            return tracer;
+        }
+
+        /**
+         * @brief Drop all events and start recording
+         *
+         * @param eventsPerThread Size of the ring of every thread
+         */
+        void enable(std::size_t eventsPerThread = defaultTimelineCapacity) {
+            if (eventsPerThread == 0) {
+                FinnUtils::logAndError<std::invalid_argument>("The timeline needs room for at least one event per thread!");
+            }
+            capacity.store(eventsPerThread, std::memory_order_relaxed);
+            clear();
+            enabled.store(true, std::memory_order_release);
+        }
+
+        /**
+         * @brief Stop recording. The recorded events are kept for an export.
+         *
+         */
+        void disable() { enabled.store(false, std::memory_order_release); }
+
+        /**
+         * @brief Check if events are recorded
+         *
+         * @return true
+         * @return false
+         */
+        bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Drop all recorded events
+         *
+         */
+        void clear() {
+            std::lock_guard guard(mutex);
+            for (auto&& shard : shards) {
+                std::lock_guard shardGuard(shard->mutex);
+                shard->next = 0;
+                shard->recorded = 0;
+            }
+        }
+
+        /**
+         * @brief Get the track of a compute unit on a device. Repeated calls with the same arguments return the same track.
+         *
+         * @param deviceIndex XRT device index
+         * @param computeUnit Name of the compute unit, e.g. the kernel name of an idma
+         * @return std::uint32_t
+         */
+        std::uint32_t deviceTrack(unsigned int deviceIndex, const std::string& computeUnit) {
+            std::lock_guard guard(mutex);
+            const std::uint32_t process = deviceIndex + 1;
+            auto found = std::find_if(tracks.begin(), tracks.end(), [&](const Track& track) { return track.process == process && track.threadName == computeUnit; });
+            if (found != tracks.end()) {
+                return static_cast<std::uint32_t>(found - tracks.begin());
+            }
+            return addTrack(process, "device " + std::to_string(deviceIndex), computeUnit);
+        }
+
+        /**
+         * @brief Name the track of the calling thread, e.g. after the buffer an asynchronous worker thread serves
+         *
+         * @param name
+         */
+        void nameThread(const std::string& name) {
+            const std::uint32_t track = localShard().track;
+            std::lock_guard guard(mutex);
+            tracks[track].threadName = name;
+        }
+
+        /**
+         * @brief Record a span of the calling thread on its own track. Does nothing while the tracer is disabled.
+         *
+         * @param name Has to outlive the tracer, usually a string literal
+         * @param begin
+         * @param end
+         */
+        void record(const char* name, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end) {
+            if (!isEnabled()) {
+                return;
+            }
+            Shard& shard = localShard();
+            push(shard, {name, begin, end, shard.track});
+        }
+
+        /**
+         * @brief Record a span on another track, e.g. a kernel run on the track of its compute unit. Does nothing while the tracer is disabled.
+         *
+         * @param track @see deviceTrack
+         * @param name Has to outlive the tracer, usually a string literal
+         * @param begin
+         * @param end
+         * @param slot Buffer slot the span worked on, -1 for none
+         * @param samples Samples the span moved, 0 if not known
+         */
+        void record(std::uint32_t track, const char* name, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end, std::int64_t slot = -1, std::uint32_t samples = 0) {
+            if (!isEnabled()) {
+                return;
+            }
+            push(localShard(), {name, begin, end, track, slot, samples});
+        }
+
+        /**
+         * @brief Get the number of events that are currently kept
+         *
+         * @return std::size_t
+         */
+        std::size_t eventCount() const {
+            std::lock_guard guard(mutex);
+            std::size_t count = 0;
+            for (auto&& shard : shards) {
+                std::lock_guard shardGuard(shard->mutex);
+                count += shard->recorded;
+            }
+            return count;
+        }
+
+        /**
+         * @brief Export the kept events in the Chrome trace event format, as complete ("X") events in microseconds with one process per device and one for the host
+         *
+         * @return nlohmann::json
+         */
+        nlohmann::json chromeTrace() const {
+            nlohmann::json events = nlohmann::json::array();
+            std::lock_guard guard(mutex);
+            std::vector<bool> used(tracks.size(), false);
+            for (auto&& shard : shards) {
+                std::lock_guard shardGuard(shard->mutex);
+                const std::size_t size = shard->events.size();
+                for (std::size_t i = 0; i < shard->recorded; ++i) {
+                    const TimelineEvent& event = shard->events[(shard->next + size - shard->recorded + i) % size];
+                    const Track& track = tracks[event.track];
+                    used[event.track] = true;
+                    nlohmann::json entry = {{"name", event.name}, {"ph", "X"}, {"ts", micros(event.begin)}, {"dur", std::chrono::duration<double, std::micro>(event.end - event.begin).count()},
+                                            {"pid", track.process}, {"tid", track.thread}};
+                    if (event.slot >= 0) {
+                        entry["args"]["slot"] = event.slot;
+                    }
+                    if (event.samples > 0) {
+                        entry["args"]["samples"] = event.samples;
+                    }
+                    events.push_back(std::move(entry));
+                }
+            }
+            for (std::size_t i = 0; i < tracks.size(); ++i) {
+                if (!used[i]) {
+                    continue;
+                }
+                events.push_back({{"name", "process_name"}, {"ph", "M"}, {"pid", tracks[i].process}, {"args", {{"name", tracks[i].processName}}}});
+                events.push_back({{"name", "thread_name"}, {"ph", "M"}, {"pid", tracks[i].process}, {"tid", tracks[i].thread}, {"args", {{"name", tracks[i].threadName}}}});
+            }
+            return {{"traceEvents", events}, {"displayTimeUnit", "ns"}};
+        }
+
+        /**
+         * @brief Write the kept events to a file, @see chromeTrace. The file can be opened in chrome://tracing or ui.perfetto.dev.
+         *
+         * @param path
+         */
+        void writeChromeTrace(const std::filesystem::path& path) const {
+            std::ofstream file(path);
+            if (!file) {
+                FinnUtils::logAndError<std::runtime_error>("Could not open " + path.string() + " to write the timeline!");
+            }
+            file << chromeTrace().dump();
+        }
+    };
+
+    /**
+     * @brief Records the time from its construction to its destruction as a span of the calling thread, if the timeline tracer is enabled
+     *
+     */
+    class ScopedTimelineEvent {
+         private:
+        const char* name;
+        bool active;
+        std::chrono::steady_clock::time_point start;
+
+         public:
+        /**
+         * @brief Start a span
+         *
+         * @param pName Has to outlive the tracer, usually a string literal
+         */
+        explicit ScopedTimelineEvent(const char* pName) : name(pName), active(TimelineTracer::global().isEnabled()) {
+            if (active) {
+                start = std::chrono::steady_clock::now();
+            }
+        }
+        ScopedTimelineEvent(ScopedTimelineEvent&&) = delete;
+        ScopedTimelineEvent(const ScopedTimelineEvent&) = delete;
+        ScopedTimelineEvent& operator=(ScopedTimelineEvent&&) = delete;
+        ScopedTimelineEvent& operator=(const ScopedTimelineEvent&) = delete;
+        ~ScopedTimelineEvent() {
+            if (active) {
+                TimelineTracer::global().record(name, start, std::chrono::steady_clock::now());
+            }
+        }
+    };
+}  // namespace Finn
+
+#endif  // TIMELINETRACER
@@ -0,0 +1,243 @@
+/**
+ * @file TrafficLog.hpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Compact binary log of inference requests, recorded from a running driver and replayed to benchmark on the same traffic
+ * @version 0.1
+ * @date 2024-03-12
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef TRAFFICLOG
+#define TRAFFICLOG
+
+#include <FINNCppDriver/utils/FinnUtils.h>
+
+#include <FINNCppDriver/utils/ArrivalSchedule.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Finn {
+    /**
+     * @brief Layout of a traffic log. All fields are stored in host byte order, a byte order mark in the header rejects logs of other hosts.
+     *
+     * header: magic "FINNTRAF", uint32 version, uint32 byte order mark, uint32 flags
+     * record: uint64 nanoseconds since the capture started, uint32 samples, uint32 packed input bytes, followed by the packed input bytes
+     *
+     */
+    namespace TrafficLogFormat {
+        constexpr std::array<char, 8> magic = {'F', 'I', 'N', 'N', 'T', 'R', 'A', 'F'};
+        constexpr std::uint32_t version = 1;
+        constexpr std::uint32_t byteOrderMark = 0x01020304;
+        /**
+         * @brief Flag of logs that hold the packed inputs of their requests
+         *
+         */
+        constexpr std::uint32_t flagInputs = 0x1;
+    }  // namespace TrafficLogFormat
+
+    /**
+     * @brief One recorded request
+     *
+     */
+    struct TrafficRecord {
+        /**
+         * @brief Time since the capture started
+         *
+         */
+        std::chrono::nanoseconds timestamp{0};
+        /**
+         * @brief Batch size of the request
+         *
+         */
+        std::uint32_t samples = 0;
+        /**
+         * @brief Packed input of the request in the device format, empty if inputs were not recorded
+         *
+         */
+        std::vector<uint8_t> input;
+    };
+
+    /**
+     * @brief Appends requests to a traffic log. Safe to use from several threads, requests are written in the order they are recorded.
+     *
+     */
+    class TrafficRecorder {
+         private:
+        std::mutex mutex;
+        std::ofstream file;
+        bool withInputs;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::size_t records = 0;
+
+        template<typename T>
+        void write(const T& value) {
+            file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+         public:
+        /**
+         * @brief Create or truncate a log and write its header. The capture starts now.
+         *
+         * @param path
+         * @param recordInputs Also store the packed input bytes of every request, so the replay sends the recorded data instead of synthetic data
+         */
+        TrafficRecorder(const std::filesystem::path& path, bool recordInputs) : file(path, std::ios::binary | std::ios::trunc), withInputs(recordInputs) {
+            if (!file) {
+                FinnUtils::logAndError<std::runtime_error>("Could not open traffic log " + path.string() + " for writing!");
+            }
+            file.write(TrafficLogFormat::magic.data(), TrafficLogFormat::magic.size());
+            write(TrafficLogFormat::version);
+            write(TrafficLogFormat::byteOrderMark);
+            write(recordInputs ? TrafficLogFormat::flagInputs : std::uint32_t{0});
+        }
+
+        TrafficRecorder(TrafficRecorder&&) = delete;
+        TrafficRecorder(const TrafficRecorder&) = delete;
+        TrafficRecorder& operator=(TrafficRecorder&&) = delete;
+        TrafficRecorder& operator=(const TrafficRecorder&) = delete;
+        ~TrafficRecorder() = default;
+
+        /**
+         * @brief Record a request that arrived now
+         *
+         * @param samples Batch size of the request
+         * @param packedInput Packed input of the request, only stored if inputs are recorded
+         */
+        void record(std::uint32_t samples, std::span<const uint8_t> packedInput) {
+            const auto bytes = withInputs ? static_cast<std::uint32_t>(packedInput.size()) : std::uint32_t{0};
+            std::lock_guard guard(mutex);
+            // Taken under the lock, so the timestamps of the log are ascending
+            const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+            write(static_cast<std::uint64_t>(time.count()));
+            write(samples);
+            write(bytes);
+            file.write(reinterpret_cast<const char*>(packedInput.data()), bytes);
+            ++records;
+        }
+
+        /**
+         * @brief Number of requests recorded so far
+         *
+         * @return std::size_t
+         */
+        std::size_t count() {
+            std::lock_guard guard(mutex);
+            return records;
+        }
+
+        /**
+         * @brief Write everything recorded so far to the file
+         *
+         */
+        void flush() {
+            std::lock_guard guard(mutex);
+            file.flush();
+        }
+    };
+
+    /**
+     * @brief A traffic log read back into memory
+     *
+     */
+    struct TrafficLog {
+        /**
+         * @brief True if the records hold their packed inputs
+         *
+         */
+        bool hasInputs = false;
+        /**
+         * @brief Requests in the order they were recorded
+         *
+         */
+        std::vector<TrafficRecord> records;
+
+        /**
+         * @brief Largest batch size of all requests
+         *
+         * @return std::uint32_t
+         */
+        std::uint32_t maxSamples() const {
+            std::uint32_t largest = 0;
+            for (auto&& record : records) {
+                largest = std::max(largest, record.samples);
+            }
+            return largest;
+        }
+
+        /**
+         * @brief Intended send times of the requests, relative to the first one
+         *
+         * @param speedup Factor the recorded gaps are divided by. 0 sends all requests at once, to replay at the highest rate the driver sustains.
+         * @return ArrivalSchedule
+         */
+        ArrivalSchedule arrivals(double speedup = 1.0) const {
+            if (speedup < 0) {
+                FinnUtils::logAndError<std::invalid_argument>("The replay speedup must not be negative!");
+            }
+            ArrivalSchedule schedule;
+            schedule.reserve(records.size());
+            for (auto&& record : records) {
+                const auto offset = record.timestamp - records.front().timestamp;
+                schedule.emplace_back((speedup == 0) ? std::chrono::nanoseconds(0) : std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double, std::nano>(static_cast<double>(offset.count()) / speedup)));
+            }
+            return schedule;
+        }
+    };
+
+    /**
+     * @brief Read a traffic log written by a TrafficRecorder. A log that was cut off while recording is read up to its last complete record.
+     *
+     * @param path
+     * @return TrafficLog
+     */
+    inline TrafficLog readTrafficLog(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            FinnUtils::logAndError<std::runtime_error>("Could not open traffic log " + path.string() + "!");
+        }
+        auto read = [&file](auto& value) { return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(value))); };
+        std::array<char, TrafficLogFormat::magic.size()> magic{};
+        std::uint32_t version = 0;
+        std::uint32_t byteOrder = 0;
+        std::uint32_t flags = 0;
+        if (!read(magic) || magic != TrafficLogFormat::magic || !read(version) || !read(byteOrder) || !read(flags)) {
+            FinnUtils::logAndError<std::runtime_error>(path.string() + " is not a traffic log!");
+        }
+        if (version != TrafficLogFormat::version || byteOrder != TrafficLogFormat::byteOrderMark) {
+            FinnUtils::logAndError<std::runtime_error>("Traffic log " + path.string() + " was written by another driver version or on a host with another byte order!");
+        }
+        TrafficLog log;
+        log.hasInputs = (flags & TrafficLogFormat::flagInputs) != 0;
+        for (;;) {
+            std::uint64_t time = 0;
+            TrafficRecord record;
+            std::uint32_t bytes = 0;
+            if (!read(time) || !read(record.samples) || !read(bytes)) {
+                break;
+            }
+            record.timestamp = std::chrono::nanoseconds(time);
+            record.input.resize(bytes);
+            if (!file.read(reinterpret_cast<char*>(record.input.data()), bytes)) {
+                break;
+            }
+            log.records.emplace_back(std::move(record));
+        }
+        return log;
+    }
+}  // namespace Finn
+
+#endif  // TRAFFICLOG
@@ -0,0 +1,135 @@
+/**
+ * @file TransferPlan.h
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Precomputed layout of a buffer transfer between the folded host format and the packed device format
+ * @version 0.1
+ * @date 2024-01-29
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef TRANSFERPLAN
+#define TRANSFERPLAN
+
+#include <FINNCppDriver/utils/FinnUtils.h>
+#include <FINNCppDriver/utils/Types.h>
+
+#include <FINNCppDriver/utils/InputLayout.hpp>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace Finn {
+    /**
+     * @brief Describes how the folded elements of a buffer map onto its packed bytes. The packed data consists of innerDims rows of bytesPerInnerDim bytes, each holding the
+     * elementsPerInnerDim elements of one innermost folded dimension followed by paddingBits padding bits. Packing and unpacking iterate over these rows without
+     * building any intermediate views, so a plan is meant to be built once per buffer and batch size and then reused for every transfer.
+     *
+     */
+    struct TransferPlan {
+        /**
+         * @brief Folded shape of the host data, including the batch dimension
+         *
+         */
+        shapeFolded_t foldedShape;
+        /**
+         * @brief Packed shape of the device data, including the batch dimension
+         *
+         */
+        shapePacked_t packedShape;
+        /**
+         * @brief Number of innermost dimensions (rows)
+         *
+         */
+        std::size_t innerDims = 0;
+        /**
+         * @brief Number of folded elements per row
+         *
+         */
+        std::size_t elementsPerInnerDim = 0;
+        /**
+         * @brief Number of packed bytes per row
+         *
+         */
+        std::size_t bytesPerInnerDim = 0;
+        /**
+         * @brief Number of padding bits at the end of every row
+         *
+         */
+        std::size_t paddingBits = 0;
+        /**
+         * @brief Bitwidth of the FINN datatype the plan was built for
+         *
+         */
+        std::size_t bitwidth = 0;
+        /**
+         * @brief Layout the host data of an input is stored in if it is not the normal shape, empty otherwise. Packing reads the rows straight from this layout.
+         *
+         */
+        std::shared_ptr<const InputLayout> sourceLayout;
+
+        /**
+         * @brief Construct an empty plan
+         *
+         */
+        TransferPlan() = default;
+
+        /**
+         * @brief Construct a new Transfer Plan
+         *
+         * @param pFoldedShape
+         * @param pPackedShape
+         * @param pBitwidth Bitwidth of the FINN datatype
+         */
+        TransferPlan(const shapeFolded_t& pFoldedShape, const shapePacked_t& pPackedShape, std::size_t pBitwidth) : foldedShape(pFoldedShape), packedShape(pPackedShape), bitwidth(pBitwidth) {
+            if (foldedShape.empty() || packedShape.empty() || foldedShape.back() == 0 || packedShape.back() == 0) {
+                FinnUtils::logAndError<std::invalid_argument>("Cannot create a transfer plan for empty shapes!");
+            }
+            elementsPerInnerDim = foldedShape.back();
+            bytesPerInnerDim = packedShape.back();
+            innerDims = FinnUtils::shapeToElements(packedShape) / bytesPerInnerDim;
+            if (FinnUtils::shapeToElements(foldedShape) / elementsPerInnerDim != innerDims || elementsPerInnerDim * bitwidth > bytesPerInnerDim * 8) {
+                FinnUtils::logAndError<std::invalid_argument>("Folded shape " + FinnUtils::shapeToString(foldedShape) + " does not fit into packed shape " + FinnUtils::shapeToString(packedShape) + "!");
+            }
+            paddingBits = bytesPerInnerDim * 8 - elementsPerInnerDim * bitwidth;
+        }
+
+        /**
+         * @brief Create a plan for the given number of batch elements. The first dimension of both shapes is replaced by batchSize.
+         *
+         * @param pFoldedShape
+         * @param pPackedShape
+         * @param batchSize
+         * @param pBitwidth Bitwidth of the FINN datatype
+         * @return TransferPlan
+         */
+        static TransferPlan forBatchSize(shapeFolded_t pFoldedShape, shapePacked_t pPackedShape, unsigned int batchSize, std::size_t pBitwidth) {
+            if (!pFoldedShape.empty()) {
+                pFoldedShape[0] = batchSize;
+            }
+            if (!pPackedShape.empty()) {
+                pPackedShape[0] = batchSize;
+            }
+            return {pFoldedShape, pPackedShape, pBitwidth};
+        }
+
+        /**
+         * @brief Total number of folded elements
+         *
+         * @return std::size_t
+         */
+        std::size_t elements() const { return innerDims * elementsPerInnerDim; }
+
+        /**
+         * @brief Total number of packed bytes
+         *
+         * @return std::size_t
+         */
+        std::size_t bytes() const { return innerDims * bytesPerInnerDim; }
+    };
+}  // namespace Finn
+
+#endif  // TRANSFERPLAN
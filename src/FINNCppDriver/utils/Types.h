@@ -14,6 +14,10 @@
 #define TYPES
 
 #include <FINNCppDriver/utils/AlignedAllocator.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
 #include <vector>
 
 // TODO(linusjun): Clean up this file. Half of these types are no longer used...
@@ -31,10 +35,11 @@ namespace Finn {
 }  // namespace Finn
 
 /**
- * @brief Platform enum
+ * @brief Platform enum. ALVEO cards are attached over PCIe and have device memory of their own, on EMBEDDED SoCs (Zynq UltraScale+, Kria) the programmable logic
+ * shares the DDR of the host.
  *
  */
-enum class PLATFORM { ALVEO = 0, INVALID = -1 };
+enum class PLATFORM { ALVEO = 0, EMBEDDED = 1, INVALID = -1 };
 
 /**
  * @brief Driver mode enum
@@ -60,6 +65,51 @@ enum class BUFFER_OP_RESULT { SUCCESS = 0, FAILURE = -1, OVER_BOUNDS_WRITE = -2,
  */
 enum class TRANSFER_MODE { MEMORY_BUFFERED = 0, STREAMED = 1, INVALID = -1 };
 
+/**
+ * @brief Strategy used to wait for the completion of a kernel run
+ *
+ */
+enum class WAIT_POLICY { SPIN = 0, SPIN_YIELD = 1, INTERRUPT = 2, INVALID = -1 };
+
+/**
+ * @brief Strategy used to distribute work over the devices of an accelerator. ROUND_ROBIN cycles through the devices, LEAST_OUTSTANDING picks the device with the fewest running or queued requests.
+ *
+ */
+enum class SCHEDULING_POLICY { ROUND_ROBIN = 0, LEAST_OUTSTANDING = 1, INVALID = -1 };
+
+/**
+ * @brief Placement of the host side of a device. NONE leaves threads and memory wherever the OS puts them, DEVICE_LOCAL runs the buffer worker threads and host packing
+ * threads of a device on the CPUs of the NUMA node its PCIe slot is attached to and allocates its host buffers from that node.
+ *
+ */
+enum class AFFINITY_POLICY { NONE = 0, DEVICE_LOCAL = 1, INVALID = -1 };
+
+/**
+ * @brief Reaction of a driver with a host memory budget to settings that do not fit it. FAIL rejects them before anything is allocated, DEGRADE first gives up buffer
+ * slots (pipeline depth) and then shrinks the archives of asynchronous outputs, and only fails if the buffers for the batch size alone do not fit.
+ *
+ */
+enum class MEMORY_POLICY { FAIL = 0, DEGRADE = 1, INVALID = -1 };
+
+/**
+ * @brief Reduction applied to every output sample on the host. ARGMAX keeps the index of the largest value, TOPK the indices of the k largest values, THRESHOLD the indices of
+ * the at most k largest values that reach a minimum.
+ *
+ */
+enum class POSTPROCESSING { ARGMAX = 0, TOPK = 1, THRESHOLD = 2, INVALID = -1 };
+
+/**
+ * @brief Default number of register polls before WAIT_POLICY::SPIN_YIELD starts to yield the CPU
+ *
+ */
+constexpr unsigned int defaultSpinBudget = 1000;
+
+/**
+ * @brief Default memory cap in bytes for the results an asynchronous output buffer archives until they are retrieved. Once it is reached, the buffer stops reading from the device.
+ *
+ */
+constexpr std::size_t defaultArchiveCapacity = 256UL * 1024 * 1024;
+
 /**
  * @brief IO mode; General purpose, no specific usecase
  *
@@ -102,6 +152,12 @@ using shapePacked_t = std::vector<unsigned int>;
  */
 using shape_t = std::vector<unsigned int>;
 
+/**
+ * @brief Callback that receives the packed result of a single batch element during asynchronous inference
+ *
+ */
+using packedResultCallback_t = std::function<void(std::span<const uint8_t>)>;
+
 /**
  * @brief Type for byte lengths
  *
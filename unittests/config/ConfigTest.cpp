@@ -9,8 +9,12 @@
  * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
  *
  */
+#include <FINNCppDriver/utils/ConfigurationStructs.h>
 #include <FINNCppDriver/utils/Types.h>
 
+#include <filesystem>
+#include <fstream>
+
 #include "gtest/gtest.h"
 
 /*
@@ -20,6 +24,133 @@ TEST(ConfigTest, JsonConversion) {
 }
 */
 
+TEST(ConfigTest, WaitPolicyConversion) {
+    auto j = json::parse(R"({"xclbinPath":"test.xclbin", "xrtDeviceIndex":0, "idmas":[], "odmas":[], "waitPolicy":"spinYield", "spinBudget":50})");
+    Finn::DeviceWrapper devWrap;
+    Finn::from_json(j, devWrap);
+    EXPECT_EQ(devWrap.waitPolicy, WAIT_POLICY::SPIN_YIELD);
+    EXPECT_EQ(devWrap.spinBudget, 50);
+
+    j.erase("spinBudget");
+    j["waitPolicy"] = "interrupt";
+    Finn::from_json(j, devWrap);
+    EXPECT_EQ(devWrap.waitPolicy, WAIT_POLICY::INTERRUPT);
+
+    j["waitPolicy"] = "sleep";
+    Finn::from_json(j, devWrap);
+    EXPECT_EQ(devWrap.waitPolicy, WAIT_POLICY::INVALID);
+
+    j.erase("waitPolicy");
+    Finn::DeviceWrapper defaultWrap;
+    Finn::from_json(j, defaultWrap);
+    EXPECT_EQ(defaultWrap.waitPolicy, WAIT_POLICY::SPIN);
+    EXPECT_EQ(defaultWrap.spinBudget, defaultSpinBudget);
+    EXPECT_EQ(defaultWrap.executeTimeoutMs, 0);
+
+    j["executeTimeoutMs"] = 250;
+    Finn::from_json(j, devWrap);
+    EXPECT_EQ(devWrap.executeTimeoutMs, 250);
+}
+
+TEST(ConfigTest, ProducerConversion) {
+    auto j = json::parse(R"({"xclbinPath":"stage1.xclbin", "xrtDeviceIndex":1, "odmas":[],
+        "idmas":[{"kernelName":"idma0", "packedShape":[1,10,1], "normalShape":[1,10], "foldedShape":[1,10,1], "producer":{"xrtDeviceIndex":0, "kernelName":"odma0"}}]})");
+    Finn::DeviceWrapper devWrap;
+    Finn::from_json(j, devWrap);
+    ASSERT_EQ(devWrap.idmas.size(), 1);
+    ASSERT_TRUE(devWrap.idmas[0]->producer.has_value());
+    EXPECT_EQ(devWrap.idmas[0]->producer->xrtDeviceIndex, 0);
+    EXPECT_EQ(devWrap.idmas[0]->producer->kernelName, "odma0");
+
+    // Round trip through JSON
+    json back = *std::dynamic_pointer_cast<Finn::ExtendedBufferDescriptor>(devWrap.idmas[0]);
+    EXPECT_EQ(back.at("producer").at("kernelName"), "odma0");
+
+    j["idmas"][0].erase("producer");
+    Finn::from_json(j, devWrap);
+    EXPECT_FALSE(devWrap.idmas[0]->producer.has_value());
+}
+
+TEST(ConfigTest, TransferModeConversion) {
+    auto j = json::parse(R"({"xclbinPath":"test.xclbin", "xrtDeviceIndex":0, "odmas":[],
+        "idmas":[{"kernelName":"idma0", "packedShape":[1,10,1], "normalShape":[1,10], "foldedShape":[1,10,1], "transferMode":"streamed", "streamChunkSamples":8}]})");
+    Finn::DeviceWrapper devWrap;
+    Finn::from_json(j, devWrap);
+    ASSERT_EQ(devWrap.idmas.size(), 1);
+    EXPECT_EQ(devWrap.idmas[0]->transferMode, TRANSFER_MODE::STREAMED);
+    EXPECT_EQ(devWrap.idmas[0]->streamChunkSamples, 8);
+
+    // Round trip through JSON
+    json back = *std::dynamic_pointer_cast<Finn::ExtendedBufferDescriptor>(devWrap.idmas[0]);
+    EXPECT_EQ(back.at("transferMode"), "streamed");
+    EXPECT_EQ(back.at("streamChunkSamples"), 8);
+
+    j["idmas"][0]["transferMode"] = "dma";
+    Finn::from_json(j, devWrap);
+    EXPECT_EQ(devWrap.idmas[0]->transferMode, TRANSFER_MODE::INVALID);
+
+    j["idmas"][0].erase("transferMode");
+    j["idmas"][0].erase("streamChunkSamples");
+    Finn::from_json(j, devWrap);
+    EXPECT_EQ(devWrap.idmas[0]->transferMode, TRANSFER_MODE::MEMORY_BUFFERED);
+    EXPECT_EQ(devWrap.idmas[0]->streamChunkSamples, 1);
+}
+
+TEST(ConfigTest, PlatformConversion) {
+    auto j = json::parse(R"({"xclbinPath":"test.xclbin", "xrtDeviceIndex":0, "idmas":[], "odmas":[], "platform":"embedded", "coherentMemory":true})");
+    Finn::DeviceWrapper devWrap;
+    Finn::from_json(j, devWrap);
+    EXPECT_EQ(devWrap.platform, PLATFORM::EMBEDDED);
+    EXPECT_TRUE(devWrap.coherentMemory);
+
+    j["platform"] = "versal";
+    Finn::from_json(j, devWrap);
+    EXPECT_EQ(devWrap.platform, PLATFORM::INVALID);
+
+    j.erase("platform");
+    j.erase("coherentMemory");
+    Finn::DeviceWrapper defaultWrap;
+    Finn::from_json(j, defaultWrap);
+    EXPECT_EQ(defaultWrap.platform, PLATFORM::ALVEO);
+    EXPECT_FALSE(defaultWrap.coherentMemory);
+}
+
+TEST(ConfigTest, TuningConversion) {
+    auto j = json::parse(R"({"xclbinPath":"test.xclbin", "xrtDeviceIndex":0, "idmas":[], "odmas":[], "tuning":{"batchSize":16, "hostThreads":4}})");
+    Finn::DeviceWrapper devWrap;
+    Finn::from_json(j, devWrap);
+    ASSERT_TRUE(devWrap.tuning.has_value());
+    EXPECT_EQ(devWrap.tuning->batchSize, 16);
+    EXPECT_EQ(devWrap.tuning->hostThreads, 4);
+    EXPECT_EQ(devWrap.tuning->bufferSlots, 1);
+
+    j.erase("tuning");
+    Finn::DeviceWrapper untuned;
+    Finn::from_json(j, untuned);
+    EXPECT_FALSE(untuned.tuning.has_value());
+
+    // The tuning is stored with the first device, everything else is kept
+    const std::filesystem::path configPath = "tuning-test-config.json";
+    {
+        std::ofstream file(configPath);
+        file << json::array({j, j}).dump();
+    }
+    Finn::DriverTuning tuning;
+    tuning.batchSize = 32;
+    tuning.bufferSlots = 2;
+    tuning.throughput = 1000;
+    Finn::writeTuningToConfig(configPath, tuning);
+    auto config = Finn::createConfigFromPath(configPath);
+    std::filesystem::remove(configPath);
+    ASSERT_EQ(config.deviceWrappers.size(), 2);
+    ASSERT_TRUE(config.deviceWrappers[0].tuning.has_value());
+    EXPECT_EQ(config.deviceWrappers[0].tuning->batchSize, 32);
+    EXPECT_EQ(config.deviceWrappers[0].tuning->bufferSlots, 2);
+    EXPECT_DOUBLE_EQ(config.deviceWrappers[0].tuning->throughput, 1000);
+    EXPECT_FALSE(config.deviceWrappers[1].tuning.has_value());
+    EXPECT_EQ(config.deviceWrappers[0].xclbin, "test.xclbin");
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
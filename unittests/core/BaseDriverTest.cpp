@@ -20,10 +20,20 @@
 #include <FINNCppDriver/core/DeviceBuffer/SyncDeviceBuffers.hpp>
 #include <FINNCppDriver/utils/FinnDatatypes.hpp>
 #include <FINNCppDriver/utils/join.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <future>
+#include <numeric>
+#include <set>
+#include <span>
+#include <thread>
 
 #include "gtest/gtest.h"
 #include "xrt/xrt_device.h"
 #include "xrt/xrt_kernel.h"
+#include "xrt_simulation.h"
 
 // Provides config and shapes
 #include "UnittestConfig.h"
@@ -39,7 +49,11 @@ class BaseDriverTest : public ::testing::Test {
         tmpfile.close();
     }
 
-    void TearDown() override { std::filesystem::remove(fn); }
+    void TearDown() override {
+        // The other tests rely on the mock completing instantly
+        xrt::simulation::configure({});
+        std::filesystem::remove(fn);
+    }
 };
 
 class TestDriver : public Finn::Driver<true> {
@@ -105,6 +119,990 @@ TEST_F(BaseDriverTest, syncInferenceTest) {
     EXPECT_EQ(results, expected);
 }
 
+TEST_F(BaseDriverTest, syncInferenceLatencyTest) {
+    auto driver = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 1, true);
+    driver.resetLatencyStatistics();
+    Finn::vector<int8_t> data(300, 1);
+    for (int i = 0; i < 3; ++i) {
+        auto results = driver.inferSynchronous(data.begin(), data.end());
+    }
+#ifdef FINN_ENABLE_INSTRUMENTATION
+    // Every stage of the synchronous path is recorded once per inference
+    for (auto stage : {Finn::STAGE::VALIDATE, Finn::STAGE::PACK, Finn::STAGE::SYNC_TO_DEVICE, Finn::STAGE::EXECUTE, Finn::STAGE::WAIT, Finn::STAGE::SYNC_FROM_DEVICE, Finn::STAGE::UNPACK}) {
+        const auto summary = driver.getStageLatency(stage);
+        EXPECT_GE(summary.count, 3) << Finn::stageName(stage);
+        EXPECT_LE(summary.p50, summary.p99);
+        EXPECT_LE(summary.p999, summary.max);
+    }
+    EXPECT_NE(driver.getLatencyReport().find("unpack"), std::string::npos);
+#else
+    EXPECT_EQ(driver.getStageLatency(Finn::STAGE::PACK).count, 0);
+#endif
+    driver.resetLatencyStatistics();
+    EXPECT_EQ(driver.getStageLatency(Finn::STAGE::PACK).count, 0);
+}
+
+TEST_F(BaseDriverTest, timelineTest) {
+    auto driver = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 1, true);
+    Finn::vector<int8_t> data(300, 1);
+    driver.startTimeline();
+    auto results = driver.inferSynchronous(data.begin(), data.end());
+    driver.stopTimeline();
+    const std::filesystem::path path = "timeline.json";
+    driver.writeTimeline(path);
+    std::ifstream file(path);
+    const auto trace = nlohmann::json::parse(file);
+    std::filesystem::remove(path);
+
+    std::vector<std::string> names;
+    for (auto&& event : trace["traceEvents"]) {
+        if (event["ph"] == "X") {
+            names.push_back(event["name"]);
+        }
+    }
+#ifdef FINN_ENABLE_INSTRUMENTATION
+    for (auto&& name : {"pack", "execute", "unpack", "run"}) {
+        EXPECT_NE(std::find(names.begin(), names.end(), name), names.end()) << name;
+    }
+#else
+    EXPECT_TRUE(names.empty());
+#endif
+    // Nothing is recorded after stopping
+    const auto recorded = Finn::TimelineTracer::global().eventCount();
+    results = driver.inferSynchronous(data.begin(), data.end());
+    EXPECT_EQ(Finn::TimelineTracer::global().eventCount(), recorded);
+}
+
+TEST_F(BaseDriverTest, syncInferenceZeroCopyTest) {
+    auto driver = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 1, true);
+
+    Finn::vector<int8_t> data(300, 1);
+    Finn::vector<uint8_t> outdata(driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, outputDmaName), 1);
+
+    // Setup fake output data
+    driver.getDeviceHandler(0).getOutputBuffer(outputDmaName)->testSetMap(outdata);
+
+    // Borrow the packed results directly from the output buffer
+    auto packed = driver.inferSynchronousPacked(data.begin(), data.end(), 0, inputDmaName, 0, outputDmaName);
+    EXPECT_EQ(packed.size(), driver.size(SIZE_SPECIFIER::TOTAL_DATA_SIZE, 0, outputDmaName));
+    EXPECT_TRUE(std::all_of(packed.begin(), packed.end(), [](uint8_t val) { return val == 1; }));
+
+    // Unpack into a user provided buffer
+    std::vector<uint8_t> results(driver.size(SIZE_SPECIFIER::TOTAL_DATA_SIZE, 0, outputDmaName), 0);
+    auto written = driver.inferSynchronous(data.begin(), data.end(), std::span<uint8_t>(results), 0, inputDmaName, 0, outputDmaName);
+    EXPECT_EQ(written, results.size());
+    EXPECT_TRUE(std::all_of(results.begin(), results.end(), [](uint8_t val) { return val == 1; }));
+
+    std::vector<uint8_t> tooSmall(results.size() - 1);
+    EXPECT_THROW(driver.inferSynchronous(data.begin(), data.end(), std::span<uint8_t>(tooSmall), 0, inputDmaName, 0, outputDmaName), std::length_error);
+}
+
+TEST_F(BaseDriverTest, syncInferenceStreamingTest) {
+    // 10 packed bytes per sample, so chunks are rounded up to 32 samples to start at 64 byte aligned addresses. 40 samples run as one full and one partial chunk.
+    constexpr unsigned int batchSize = 40;
+    auto driver = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, batchSize, true);
+    const std::size_t outputSize = driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, outputDmaName);
+    Finn::vector<uint8_t> outdata(outputSize * batchSize);
+    // The output datatype is a single bit, every third sample is set so that results at a wrong offset differ
+    for (std::size_t i = 0; i < outdata.size(); ++i) {
+        outdata[i] = static_cast<uint8_t>((i / outputSize) % 3 == 0);
+    }
+    driver.getDeviceHandler(0).getOutputBuffer(outputDmaName)->testSetMap(outdata);
+    driver.resetDeviceMetrics();
+
+    Finn::vector<int8_t> data(300 * batchSize, 1);
+    std::vector<uint8_t> results(outdata.size(), 42);
+    std::vector<std::pair<std::size_t, std::size_t>> chunks;
+    auto written = driver.inferSynchronousStreaming(data.begin(), data.end(), std::span<uint8_t>(results), 1, [&](std::size_t firstSample, std::span<const uint8_t> chunk) {
+        // Every chunk is complete when it is delivered, later chunks are not unpacked yet
+        EXPECT_TRUE(std::equal(chunk.begin(), chunk.end(), outdata.begin() + static_cast<std::ptrdiff_t>(firstSample * outputSize)));
+        EXPECT_TRUE(std::all_of(results.begin() + static_cast<std::ptrdiff_t>(firstSample * outputSize + chunk.size()), results.end(), [](uint8_t val) { return val == 42; }));
+        chunks.emplace_back(firstSample, chunk.size() / outputSize);
+    });
+    EXPECT_EQ(written, results.size());
+    EXPECT_EQ(std::vector<uint8_t>(outdata.begin(), outdata.end()), results);
+    EXPECT_EQ(chunks, (std::vector<std::pair<std::size_t, std::size_t>>{{0, 32}, {32, 8}}));
+
+    // The odma was started once per chunk and every chunk was synced on its own
+    for (auto&& buffer : driver.getDeviceMetrics()[0].buffers) {
+        if (buffer.kernelName == outputDmaName) {
+            EXPECT_EQ(buffer.invocations, 2);
+            EXPECT_EQ(buffer.transfers, 2);
+            EXPECT_EQ(buffer.bytes, outdata.size());
+        }
+    }
+
+    std::vector<uint8_t> tooSmall(results.size() - 1);
+    EXPECT_THROW(driver.inferSynchronousStreaming(data.begin(), data.end(), std::span<uint8_t>(tooSmall), 8, [](std::size_t, std::span<const uint8_t>) {}), std::length_error);
+}
+
+TEST_F(BaseDriverTest, captureTest) {
+    auto driver = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 2, true);
+    const std::filesystem::path logPath = "capture-test.bin";
+    Finn::vector<int8_t> data(300 * 2, 1);
+    Finn::vector<uint8_t> packed(driver.getPackedInputBytes(0, inputDmaName));
+
+    driver.startCapture(logPath, true);
+    auto results = driver.inferSynchronous(data.begin(), data.end());
+    // Packing without running is no request
+    driver.packBatch(data.begin(), data.end(), std::span<uint8_t>(packed), 0, inputDmaName);
+    auto prepacked = driver.inferSynchronousPrepacked(std::span<const uint8_t>(packed), 0, inputDmaName, 0, outputDmaName);
+    driver.setBatchSize(1);
+    results = driver.inferSynchronous(data.begin(), data.begin() + 300);
+    EXPECT_EQ(driver.stopCapture(), 3);
+    EXPECT_EQ(driver.stopCapture(), 0);
+
+    const auto log = Finn::readTrafficLog(logPath);
+    std::filesystem::remove(logPath);
+    ASSERT_EQ(log.records.size(), 3);
+    EXPECT_TRUE(log.hasInputs);
+    EXPECT_EQ(log.records[0].samples, 2);
+    EXPECT_EQ(log.records[0].input, std::vector<uint8_t>(packed.begin(), packed.end()));
+    EXPECT_EQ(log.records[1].input, log.records[0].input);
+    EXPECT_EQ(log.records[2].samples, 1);
+    EXPECT_EQ(log.records[2].input.size(), packed.size() / 2);
+    EXPECT_LE(log.records[0].timestamp, log.records[2].timestamp);
+}
+
+TEST_F(BaseDriverTest, resultCacheTest) {
+    auto driver = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 2, true);
+    EXPECT_THROW(driver.enableResultCache(0, 0), std::invalid_argument);
+    EXPECT_FALSE(driver.getResultCacheStatistics().has_value());
+    driver.enableResultCache(1 << 20);
+    const std::size_t outputSize = driver.getPackedOutputBytes(0, outputDmaName) / 2;
+    auto batch = [](int8_t first, int8_t second) {
+        Finn::vector<int8_t> data(300 * 2, first);
+        std::fill(data.begin() + 300, data.end(), second);
+        return data;
+    };
+    auto setDeviceResults = [&](uint8_t offset) {
+        Finn::vector<uint8_t> outdata(outputSize * 2);
+        std::iota(outdata.begin(), outdata.end(), offset);
+        driver.getDeviceHandler(0).getOutputBuffer(outputDmaName)->testSetMap(outdata);
+        return outdata;
+    };
+    auto unpack = [&](const Finn::vector<uint8_t>& packed) {
+        Finn::vector<uint8_t> unpacked(driver.getOutputElementsPerSample() * 2);
+        driver.unpackBatch(std::span<const uint8_t>(packed), std::span<uint8_t>(unpacked), 0, outputDmaName);
+        return unpacked;
+    };
+    auto inputBytes = [&]() {
+        const auto metrics = driver.getDeviceMetrics();
+        for (auto&& buffer : metrics[0].buffers) {
+            if (buffer.kernelName == inputDmaName) {
+                return buffer.bytes;
+            }
+        }
+        return std::uint64_t{0};
+    };
+
+    const auto first = setDeviceResults(1);
+    auto data = batch(1, 2);
+    EXPECT_EQ(driver.inferSynchronous(data.begin(), data.end()), unpack(first));
+
+    // The miss is moved to the front of the batch and run alone, the hit is served from the cache
+    const auto second = setDeviceResults(100);
+    driver.resetDeviceMetrics();
+    data = batch(3, 1);
+    auto results = driver.inferSynchronous(data.begin(), data.end());
+    Finn::vector<uint8_t> expected(second.begin(), second.begin() + static_cast<std::ptrdiff_t>(outputSize));
+    expected.insert(expected.end(), first.begin(), first.begin() + static_cast<std::ptrdiff_t>(outputSize));
+    EXPECT_EQ(results, unpack(expected));
+    EXPECT_EQ(inputBytes(), driver.getPackedInputBytes(0, inputDmaName) / 2);
+
+    // Only hits do not touch the device
+    driver.resetDeviceMetrics();
+    data = batch(1, 2);
+    EXPECT_EQ(driver.inferSynchronous(data.begin(), data.end()), unpack(first));
+    EXPECT_EQ(inputBytes(), 0);
+
+    auto statistics = driver.getResultCacheStatistics().value();
+    EXPECT_EQ(statistics.hits, 3);
+    EXPECT_EQ(statistics.misses, 3);
+    EXPECT_EQ(statistics.skippedBatches, 1);
+    EXPECT_EQ(statistics.entries, 3);
+    EXPECT_EQ(statistics.bytes, 3 * (driver.getPackedInputBytes(0, inputDmaName) / 2 + outputSize));
+    EXPECT_DOUBLE_EQ(statistics.hitRate(), 0.5);
+
+    // The least recently used sample is evicted first
+    driver.enableResultCache(0, 2);
+    data = batch(1, 2);
+    results = driver.inferSynchronous(data.begin(), data.end());
+    data = batch(3, 1);
+    results = driver.inferSynchronous(data.begin(), data.end());
+    statistics = driver.getResultCacheStatistics().value();
+    EXPECT_EQ(statistics.entries, 2);
+    EXPECT_EQ(statistics.evictions, 1);
+    data = batch(1, 3);
+    results = driver.inferSynchronous(data.begin(), data.end());
+    EXPECT_EQ(driver.getResultCacheStatistics()->skippedBatches, 1);
+
+    driver.disableResultCache();
+    EXPECT_FALSE(driver.getResultCacheStatistics().has_value());
+}
+
+TEST_F(BaseDriverTest, inputLayoutTest) {
+    Finn::Config config = unittestConfig;
+    auto descriptor = std::make_shared<Finn::ExtendedBufferDescriptor>(*std::dynamic_pointer_cast<Finn::ExtendedBufferDescriptor>(config.deviceWrappers[0].idmas[0]));
+    // Ten pixels of 30 channels, channels last
+    descriptor->normalShape = {1, 10, 30};
+    config.deviceWrappers[0].idmas[0] = descriptor;
+    auto driver = Finn::Driver<true>(config, 0, inputDmaName, 0, outputDmaName, 2, true);
+
+    Finn::vector<int8_t> channelsLast(300 * 2);
+    Finn::vector<int8_t> channelsFirst(300 * 2);
+    for (std::size_t sample = 0; sample < 2; ++sample) {
+        for (std::size_t pixel = 0; pixel < 10; ++pixel) {
+            for (std::size_t channel = 0; channel < 30; ++channel) {
+                const auto value = static_cast<int8_t>((sample * 7 + pixel * 3 + channel) % 100 - 50);
+                channelsLast[sample * 300 + pixel * 30 + channel] = value;
+                channelsFirst[sample * 300 + channel * 10 + pixel] = value;
+            }
+        }
+    }
+    Finn::vector<uint8_t> expected(driver.getPackedInputBytes(0, inputDmaName));
+    driver.packBatch(channelsLast.begin(), channelsLast.end(), std::span<uint8_t>(expected), 0, inputDmaName);
+
+    driver.setInputLayout(Finn::InputLayout::channelsFirst(descriptor->normalShape));
+    Finn::vector<uint8_t> packed(expected.size());
+    driver.packBatch(channelsFirst.begin(), channelsFirst.end(), std::span<uint8_t>(packed), 0, inputDmaName);
+    EXPECT_EQ(packed, expected);
+    // The layout survives a change of the batch size
+    driver.setBatchSize(1);
+    auto results = driver.inferSynchronous(channelsFirst.begin(), channelsFirst.begin() + 300);
+    EXPECT_TRUE(std::equal(expected.begin(), expected.begin() + static_cast<std::ptrdiff_t>(expected.size() / 2), driver.getDeviceHandler(0).getInputBuffer(inputDmaName)->getMap().begin()));
+
+    driver.clearInputLayout(0, inputDmaName);
+    driver.setBatchSize(2);
+    driver.packBatch(channelsLast.begin(), channelsLast.end(), std::span<uint8_t>(packed), 0, inputDmaName);
+    EXPECT_EQ(packed, expected);
+    EXPECT_THROW(driver.setInputLayout(Finn::InputLayout({10, 3, 10}, {0, 1, 2})), std::invalid_argument);
+}
+
+TEST_F(BaseDriverTest, applyTuningTest) {
+    auto driver = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 2, true);
+    EXPECT_FALSE(driver.getConfiguredTuning().has_value());
+
+    Finn::DriverTuning tuning;
+    tuning.batchSize = 4;
+    tuning.hostThreads = 2;
+    tuning.bufferSlots = 2;
+    driver.applyTuning(tuning);
+    EXPECT_EQ(driver.getBatchSize(), 4);
+    EXPECT_GE(driver.getMaxBatchSize(), 4);
+    EXPECT_EQ(driver.getHostThreadPool().size(), 2);
+    EXPECT_EQ(driver.getBufferSlots(), 2);
+
+    // An explicit batch size is kept, 0 host threads keeps the pool
+    tuning.batchSize = 8;
+    tuning.hostThreads = 0;
+    driver.applyTuning(tuning, false);
+    EXPECT_EQ(driver.getBatchSize(), 4);
+    EXPECT_EQ(driver.getHostThreadPool().size(), 2);
+
+    Finn::vector<int8_t> data(300 * 4 * 2, 1);
+    std::vector<uint8_t> results(driver.getOutputElementsPerSample() * 4 * 2);
+    EXPECT_EQ(driver.inferSynchronousPipelined(data.begin(), data.end(), std::span<uint8_t>(results), 0, inputDmaName, 0, outputDmaName), results.size());
+
+    tuning.bufferSlots = 0;
+    EXPECT_THROW(driver.applyTuning(tuning), std::invalid_argument);
+}
+
+TEST_F(BaseDriverTest, memoryBudgetTest) {
+    auto driver = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 2, true);
+    // Buffers are allocated on first use, but the plan already knows what they will need: one 4096 byte buffer object per idma and odma
+    EXPECT_EQ(driver.getMemoryPlan().bytes, 8192);
+    EXPECT_THROW(driver.setMemoryBudget(8000), std::runtime_error);
+    EXPECT_EQ(driver.getMemoryBudget(), 0);
+    driver.setMemoryBudget(10000);
+
+    EXPECT_THROW(driver.setBufferSlots(2), std::runtime_error);
+    EXPECT_EQ(driver.getBufferSlots(), 1);
+    EXPECT_THROW(driver.setMaxBatchSize(100), std::runtime_error);
+    EXPECT_EQ(driver.getMaxBatchSize(), 2);
+
+    Finn::vector<int8_t> data(300 * 2, 1);
+    auto results = driver.inferSynchronous(data.begin(), data.end());
+    auto footprint = driver.getMemoryFootprint();
+    ASSERT_EQ(footprint.devices.size(), 1);
+    ASSERT_EQ(footprint.devices[0].buffers.size(), 2);
+    EXPECT_EQ(footprint.total(), 8192);
+    EXPECT_EQ(footprint.budget, 10000);
+
+    // Degrading gives up buffer slots instead
+    driver.setMemoryBudget(20000, MEMORY_POLICY::DEGRADE);
+    driver.setBufferSlots(4);
+    EXPECT_EQ(driver.getBufferSlots(), 2);
+    results = driver.inferSynchronous(data.begin(), data.end());
+    EXPECT_EQ(driver.getMemoryFootprint().total(), 8192 * 2);
+    driver.setMemoryBudget(10000, MEMORY_POLICY::DEGRADE);
+    EXPECT_EQ(driver.getBufferSlots(), 1);
+
+    driver.setMemoryBudget(0);
+    driver.setBufferSlots(3);
+    EXPECT_EQ(driver.getBufferSlots(), 3);
+}
+
+TEST_F(BaseDriverTest, asyncMemoryBudgetTest) {
+    auto driver = Finn::Driver<false>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 4, true);
+    driver.setArchiveCapacity(0);
+    const auto unbounded = driver.getMemoryPlan();
+    // An unbounded archive is capped to what is left of the budget
+    driver.setMemoryBudget(unbounded.bytes + 1000);
+    EXPECT_EQ(driver.getMemoryPlan().archiveCapacity, 1000);
+    EXPECT_THROW(driver.setArchiveCapacity(2000), std::runtime_error);
+    driver.setArchiveCapacity(500);
+    EXPECT_EQ(driver.getMemoryPlan().archiveCapacity, 500);
+
+    const auto footprint = driver.getMemoryFootprint();
+    ASSERT_EQ(footprint.devices.size(), 1);
+    ASSERT_EQ(footprint.devices[0].buffers.size(), 2);
+    for (auto&& buffer : footprint.devices[0].buffers) {
+        EXPECT_GT(buffer.ringBufferBytes, 0);
+        if (buffer.ioMode == IO::OUTPUT) {
+            EXPECT_EQ(buffer.archiveCapacity, 500);
+        }
+    }
+}
+
+TEST_F(BaseDriverTest, syncInferenceStaticShapesTest) {
+    using InputShape = Finn::StaticBufferShape<Finn::staticShape(1, 300), Finn::staticShape(1, 10, 30), Finn::staticShape(1, 10, 8)>;
+    using OutputShape = Finn::StaticBufferShape<Finn::staticShape(1, 10), Finn::staticShape(1, 10, 1), Finn::staticShape(1, 10, 1)>;
+    auto driver = Finn::BaseDriver<true, InputFinnType, OutputFinnType, uint8_t, InputShape, OutputShape>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 2, true);
+    auto reference = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 2, true);
+
+    Finn::vector<int8_t> data(600);
+    std::iota(data.begin(), data.end(), 0);
+    std::transform(data.begin(), data.end(), data.begin(), [](int8_t val) { return static_cast<int8_t>(val % 4 - 2); });
+    Finn::vector<uint8_t> outdata(driver.size(SIZE_SPECIFIER::TOTAL_DATA_SIZE, 0, outputDmaName));
+    std::iota(outdata.begin(), outdata.end(), 0);
+    driver.getDeviceHandler(0).getOutputBuffer(outputDmaName)->testSetMap(outdata);
+    reference.getDeviceHandler(0).getOutputBuffer(outputDmaName)->testSetMap(outdata);
+
+    // The specialised kernels pack and unpack exactly like the runtime shaped ones
+    auto results = driver.inferSynchronous(data.begin(), data.end());
+    auto expected = reference.inferSynchronous(data.begin(), data.end());
+    EXPECT_EQ(results, expected);
+    EXPECT_EQ(driver.getDeviceHandler(0).getInputBuffer(inputDmaName)->testGetMap(), reference.getDeviceHandler(0).getInputBuffer(inputDmaName)->testGetMap());
+
+    // Shapes generated for a different network are rejected
+    using OtherShape = Finn::StaticBufferShape<Finn::staticShape(1, 200), Finn::staticShape(1, 10, 20), Finn::staticShape(1, 10, 5)>;
+    EXPECT_THROW((Finn::BaseDriver<true, InputFinnType, OutputFinnType, uint8_t, OtherShape, OutputShape>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 1, true)), std::invalid_argument);
+}
+
+TEST_F(BaseDriverTest, syncInferencePostprocessedTest) {
+    auto driver = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 2, true);
+
+    Finn::vector<int8_t> data(600, 1);
+    // Two samples of 10 binary classes
+    Finn::vector<uint8_t> outdata{0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    driver.getDeviceHandler(0).getOutputBuffer(outputDmaName)->testSetMap(outdata);
+
+    EXPECT_EQ(driver.inferSynchronousPostprocessed(data.begin(), data.end(), Finn::Postprocessing::argmax()), (Finn::vector<std::size_t>{3, 0}));
+    EXPECT_EQ(driver.inferSynchronousPostprocessed(data.begin(), data.end(), Finn::Postprocessing::threshold(1, 2)), (Finn::vector<std::size_t>{3, 6, Finn::noClass, Finn::noClass}));
+
+    std::vector<std::size_t> topK(2 * 3);
+    EXPECT_EQ(driver.inferSynchronousPostprocessed(data.begin(), data.end(), Finn::Postprocessing::topK(3), std::span<std::size_t>(topK), 0, inputDmaName, 0, outputDmaName), topK.size());
+    EXPECT_EQ(topK, (std::vector<std::size_t>{3, 6, 0, 0, 1, 2}));
+    std::vector<std::size_t> tooSmall(5);
+    EXPECT_THROW(driver.postprocessBatch(std::span<const uint8_t>(outdata.data(), outdata.size()), Finn::Postprocessing::topK(3), std::span<std::size_t>(tooSmall), 0, outputDmaName), std::length_error);
+}
+
+TEST_F(BaseDriverTest, syncInferenceSessionTest) {
+    auto driver = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 2, true);
+    EXPECT_FALSE(decltype(driver)::InferenceSession().valid());
+
+    Finn::vector<int8_t> data(600, 1);
+    Finn::vector<uint8_t> outdata{0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+    driver.getDeviceHandler(0).getOutputBuffer(outputDmaName)->testSetMap(outdata);
+
+    auto session = driver.prepare();
+    EXPECT_TRUE(session.valid());
+    EXPECT_EQ(session.getInputPlan().bytes(), driver.getPackedInputBytes(0, inputDmaName));
+    EXPECT_EQ(session.getOutputPlan().elements(), outdata.size());
+
+    // The session has to produce the same results as the name based calls
+    Finn::vector<uint8_t> results(outdata.size());
+    EXPECT_EQ(session.infer(data.begin(), data.end(), std::span<uint8_t>(results)), outdata.size());
+    EXPECT_EQ(results, outdata);
+    EXPECT_EQ(driver.inferSynchronous(data.begin(), data.end()), results);
+    const auto packed = session.inferPacked(data.begin(), data.end());
+    EXPECT_EQ(packed.size(), driver.getPackedOutputBytes(0, outputDmaName));
+    EXPECT_EQ(packed.data(), driver.getOutputBuffer(0, outputDmaName)->getMap().data());
+    std::vector<std::size_t> indices(2);
+    EXPECT_EQ(session.inferPostprocessed(data.begin(), data.end(), Finn::Postprocessing::argmax(), std::span<std::size_t>(indices)), 2);
+    EXPECT_EQ(indices, (std::vector<std::size_t>{3, 9}));
+    EXPECT_THROW(session.infer(data.begin(), data.end() - 1, std::span<uint8_t>(results)), std::length_error);
+
+    // Changing the batch size invalidates the resolved plans
+    driver.setBatchSize(1);
+    EXPECT_FALSE(session.valid());
+    EXPECT_THROW((void)session.inferPacked(data.begin(), data.begin() + 300), std::logic_error);
+    session = driver.prepare(0, inputDmaName, 0, outputDmaName);
+    EXPECT_TRUE(session.valid());
+    EXPECT_EQ(session.infer(data.begin(), data.begin() + 300, std::span<uint8_t>(results)), 10);
+    EXPECT_TRUE(std::equal(results.begin(), results.begin() + 10, outdata.begin()));
+}
+
+TEST_F(BaseDriverTest, syncInferencePrepackedTest) {
+    auto driver = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 1, true);
+
+    Finn::vector<int8_t> data(300, 1);
+    driver.getDeviceHandler(0).getOutputBuffer(outputDmaName)->testSetMap(Finn::vector<uint8_t>(driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, outputDmaName), 1));
+
+    // Packing once ahead of time has to yield the same bytes that end up in the input buffer when packing on the fly
+    Finn::vector<uint8_t> packedInput(driver.getPackedInputBytes(0, inputDmaName));
+    driver.packBatch(data.begin(), data.end(), std::span<uint8_t>(packedInput), 0, inputDmaName);
+    auto onTheFly = driver.inferSynchronousPacked(data.begin(), data.end(), 0, inputDmaName, 0, outputDmaName);
+    const auto map = driver.getPackedInputMap(0, inputDmaName);
+    EXPECT_TRUE(std::equal(map.begin(), map.end(), packedInput.begin(), packedInput.end()));
+    const Finn::vector<uint8_t> packedOutput(onTheFly.begin(), onTheFly.end());
+
+    std::fill(map.begin(), map.end(), 0);
+    auto prepacked = driver.inferSynchronousPrepacked(std::span<const uint8_t>(packedInput), 0, inputDmaName, 0, outputDmaName);
+    EXPECT_TRUE(std::equal(map.begin(), map.end(), packedInput.begin(), packedInput.end()));
+    EXPECT_EQ(prepacked.size(), driver.getPackedOutputBytes(0, outputDmaName));
+    EXPECT_TRUE(std::equal(prepacked.begin(), prepacked.end(), packedOutput.begin(), packedOutput.end()));
+
+    // Unpacking the packed results separately has to match unpacking them during inference
+    std::vector<uint8_t> unpacked(driver.getOutputElementsPerSample());
+    EXPECT_EQ(driver.unpackBatch(prepacked, std::span<uint8_t>(unpacked), 0, outputDmaName), unpacked.size());
+    std::vector<uint8_t> results(driver.getOutputElementsPerSample());
+    driver.inferSynchronous(data.begin(), data.end(), std::span<uint8_t>(results), 0, inputDmaName, 0, outputDmaName);
+    EXPECT_EQ(unpacked, results);
+
+    EXPECT_THROW(driver.inferSynchronousPrepacked(std::span<const uint8_t>(packedInput).first(1), 0, inputDmaName, 0, outputDmaName), std::runtime_error);
+}
+
+TEST_F(BaseDriverTest, syncInferencePipelinedTest) {
+    auto driver = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 1, true);
+    driver.setBufferSlots(2);
+    EXPECT_EQ(driver.getBufferSlots(), 2);
+
+    // Every output slot gets its own fake output data, so the results show which slot a batch was read from
+    auto outputBuffer = driver.getDeviceHandler(0).getOutputBuffer(outputDmaName);
+    EXPECT_EQ(outputBuffer->getBufferSlots(), 2);
+    const std::size_t outputSize = driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, outputDmaName);
+    for (std::size_t slot = 0; slot < 2; ++slot) {
+        outputBuffer->setActiveBufferSlot(slot);
+        outputBuffer->testSetMap(Finn::vector<uint8_t>(outputSize, static_cast<uint8_t>(slot)));
+    }
+    outputBuffer->setActiveBufferSlot(0);
+
+    constexpr std::size_t batches = 3;
+    Finn::vector<int8_t> data(300 * batches, 1);
+    std::vector<uint8_t> results(outputSize * batches, 42);
+    auto written = driver.inferSynchronousPipelined(data.begin(), data.end(), std::span<uint8_t>(results), 0, inputDmaName, 0, outputDmaName);
+    EXPECT_EQ(written, results.size());
+    for (std::size_t batch = 0; batch < batches; ++batch) {
+        EXPECT_TRUE(std::all_of(results.begin() + batch * outputSize, results.begin() + (batch + 1) * outputSize, [batch](uint8_t val) { return val == batch % 2; }));
+    }
+
+    // Both input slots were used and hold the same packed data, because all batches are equal
+    auto inputBuffer = driver.getDeviceHandler(0).getInputBuffer(inputDmaName);
+    auto packed0 = inputBuffer->getMap(0);
+    auto packed1 = inputBuffer->getMap(1);
+    EXPECT_TRUE(std::equal(packed0.begin(), packed0.end(), packed1.begin()));
+    EXPECT_TRUE(std::any_of(packed1.begin(), packed1.end(), [](uint8_t val) { return val != 0; }));
+    EXPECT_EQ(inputBuffer->getActiveBufferSlot(), 0);
+
+    Finn::vector<int8_t> wrongSize(301, 1);
+    EXPECT_THROW(driver.inferSynchronousPipelined(wrongSize.begin(), wrongSize.end(), std::span<uint8_t>(results), 0, inputDmaName, 0, outputDmaName), std::runtime_error);
+}
+
+/**
+ * @brief Copy of the unittest config with a second, identical device
+ *
+ * @return Finn::Config
+ */
+Finn::Config twoDeviceConfig() {
+    Finn::Config config = unittestConfig;
+    Finn::DeviceWrapper second = config.deviceWrappers[0];
+    second.xrtDeviceIndex = 1;
+    config.deviceWrappers.emplace_back(second);
+    return config;
+}
+
+TEST_F(BaseDriverTest, syncInferenceVariableBatchTest) {
+    auto driver = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 4, true);
+    EXPECT_EQ(driver.getMaxBatchSize(), 4);
+    const std::size_t outputSize = driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, outputDmaName);
+    driver.getDeviceHandler(0).getOutputBuffer(outputDmaName)->testSetMap(Finn::vector<uint8_t>(outputSize * 4, 1));
+
+    const std::size_t packedSampleBytes = driver.getPackedInputBytes(0, inputDmaName) / driver.getBatchSize();
+    // The second round is served from the plans cached for each batch size in the first one
+    for (uint batch : {2U, 4U, 1U, 2U, 4U, 1U}) {
+        driver.setBatchSize(batch);
+        EXPECT_EQ(driver.getMaxBatchSize(), 4);
+        EXPECT_EQ(driver.getInputBuffer(0, inputDmaName)->getMaxBatchSize(), 4);
+        EXPECT_EQ(driver.getPackedInputBytes(0, inputDmaName), packedSampleBytes * batch);
+        Finn::vector<int8_t> data(300 * batch, 1);
+        auto results = driver.inferSynchronous(data.begin(), data.end());
+        EXPECT_EQ(results, Finn::vector<uint8_t>(outputSize * batch, 1));
+    }
+
+    driver.setMaxBatchSize(2);
+    EXPECT_EQ(driver.getBatchSize(), 1);
+    EXPECT_EQ(driver.getInputBuffer(0, inputDmaName)->getMaxBatchSize(), 2);
+}
+
+TEST_F(BaseDriverTest, deviceSchedulingTest) {
+    Finn::Accelerator accelerator(twoDeviceConfig().deviceWrappers, true, 1);
+    EXPECT_EQ(accelerator.deviceCount(), 2);
+    EXPECT_EQ(accelerator.getSchedulingPolicy(), SCHEDULING_POLICY::LEAST_OUTSTANDING);
+    {
+        // A busy device is skipped as long as another one is idle
+        auto first = accelerator.acquireDevice();
+        EXPECT_EQ(accelerator.getOutstandingWork(first.position()), 1);
+        for (int i = 0; i < 3; ++i) {
+            auto second = accelerator.acquireDevice();
+            EXPECT_NE(second.position(), first.position());
+        }
+    }
+    EXPECT_EQ(accelerator.getOutstandingWork(0), 0);
+    EXPECT_EQ(accelerator.getOutstandingWork(1), 0);
+
+    accelerator.setSchedulingPolicy(SCHEDULING_POLICY::ROUND_ROBIN);
+    std::size_t previous = accelerator.acquireDevice().position();
+    for (int i = 0; i < 4; ++i) {
+        const std::size_t current = accelerator.acquireDevice().position();
+        EXPECT_EQ(current, (previous + 1) % 2);
+        previous = current;
+    }
+    EXPECT_THROW(accelerator.setSchedulingPolicy(SCHEDULING_POLICY::INVALID), std::invalid_argument);
+}
+
+TEST_F(BaseDriverTest, syncInferenceDataParallelTest) {
+    auto driver = Finn::Driver<true>(twoDeviceConfig(), 0, inputDmaName, 0, outputDmaName, 1, true);
+
+    // Every device gets its own fake output data, so the results show which device a batch ran on
+    const std::size_t outputSize = driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, outputDmaName);
+    for (unsigned int device = 0; device < 2; ++device) {
+        driver.getDeviceHandler(device).getOutputBuffer(outputDmaName)->testSetMap(Finn::vector<uint8_t>(outputSize, static_cast<uint8_t>(device)));
+    }
+
+    constexpr std::size_t batches = 8;
+    Finn::vector<int8_t> data(300 * batches, 1);
+    for (auto policy : {SCHEDULING_POLICY::ROUND_ROBIN, SCHEDULING_POLICY::LEAST_OUTSTANDING}) {
+        driver.setSchedulingPolicy(policy);
+        std::vector<uint8_t> results(outputSize * batches, 42);
+        auto written = driver.inferSynchronousDataParallel(data.begin(), data.end(), std::span<uint8_t>(results));
+        EXPECT_EQ(written, results.size());
+
+        std::size_t onSecondDevice = 0;
+        for (std::size_t batch = 0; batch < batches; ++batch) {
+            auto batchBegin = results.begin() + static_cast<std::ptrdiff_t>(batch * outputSize);
+            // Every batch was written completely and by a single device
+            EXPECT_TRUE(std::all_of(batchBegin, batchBegin + static_cast<std::ptrdiff_t>(outputSize), [&](uint8_t val) { return val == *batchBegin && val < 2; }));
+            onSecondDevice += *batchBegin;
+        }
+        if (policy == SCHEDULING_POLICY::ROUND_ROBIN) {
+            EXPECT_EQ(onSecondDevice, batches / 2);
+        }
+        // Both devices received the packed input
+        for (unsigned int device = 0; device < 2; ++device) {
+            auto packed = driver.getDeviceHandler(device).getInputBuffer(inputDmaName)->getMap();
+            EXPECT_TRUE(std::any_of(packed.begin(), packed.end(), [](uint8_t val) { return val != 0; }));
+        }
+    }
+
+    Finn::vector<int8_t> wrongSize(301, 1);
+    std::vector<uint8_t> results(outputSize * batches);
+    EXPECT_THROW(driver.inferSynchronousDataParallel(wrongSize.begin(), wrongSize.end(), std::span<uint8_t>(results)), std::runtime_error);
+}
+
+TEST_F(BaseDriverTest, executeTimeoutTest) {
+    auto driver = Finn::Driver<true>(twoDeviceConfig(), 0, inputDmaName, 0, outputDmaName, 1, true);
+    driver.setExecuteTimeout(std::chrono::milliseconds(5));
+    driver.setSchedulingPolicy(SCHEDULING_POLICY::ROUND_ROBIN);
+    const std::size_t outputSize = driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, outputDmaName);
+    for (unsigned int device = 0; device < 2; ++device) {
+        driver.getDeviceHandler(device).getOutputBuffer(outputDmaName)->testSetMap(Finn::vector<uint8_t>(outputSize, static_cast<uint8_t>(device)));
+    }
+    auto hang = [](std::set<unsigned int> devices) {
+        std::lock_guard guard(xrt::device::mock_mutex);
+        xrt::ip::mock_hung_devices = std::move(devices);
+    };
+
+    // Batches that time out on the second device are run again on the first one
+    hang({1});
+    Finn::vector<int8_t> data(300, 1);
+    for (int i = 0; i < 4; ++i) {
+        std::vector<uint8_t> result(outputSize, 42);
+        EXPECT_EQ(driver.inferSynchronousScheduled(data.begin(), data.end(), std::span<uint8_t>(result)), outputSize);
+        EXPECT_EQ(result, std::vector<uint8_t>(outputSize, 0));
+    }
+    EXPECT_FALSE(driver.getDeviceHandler(0).isStuck());
+    EXPECT_TRUE(driver.getDeviceHandler(1).isStuck());
+    EXPECT_EQ(driver.getAccelerator().getOutstandingWork(1), 0);
+
+    hang({});
+    EXPECT_EQ(driver.recoverStuckDevices(), 1);
+    EXPECT_FALSE(driver.getDeviceHandler(1).isStuck());
+    EXPECT_EQ(driver.getDeviceHandler(1).getRecoveries(), 1);
+
+    // Without a healthy device the timeout is passed on
+    hang({0, 1});
+    std::vector<uint8_t> result(outputSize);
+    EXPECT_THROW(driver.inferSynchronousScheduled(data.begin(), data.end(), std::span<uint8_t>(result)), Finn::KernelTimeoutError);
+    EXPECT_THROW(driver.inferSynchronousScheduled(data.begin(), data.end(), std::span<uint8_t>(result)), Finn::KernelTimeoutError);
+
+    // The watchdog brings both devices back
+    hang({});
+    driver.startWatchdog(std::chrono::milliseconds(1));
+    const auto giveUp = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while ((driver.getDeviceHandler(0).isStuck() || driver.getDeviceHandler(1).isStuck()) && std::chrono::steady_clock::now() < giveUp) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    driver.stopWatchdog();
+    EXPECT_FALSE(driver.getDeviceHandler(0).isStuck());
+    EXPECT_FALSE(driver.getDeviceHandler(1).isStuck());
+    EXPECT_EQ(driver.inferSynchronousScheduled(data.begin(), data.end(), std::span<uint8_t>(result)), outputSize);
+}
+
+TEST_F(BaseDriverTest, recoveryInvalidatesSessionTest) {
+    auto driver = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 1, true);
+    driver.setExecuteTimeout(std::chrono::milliseconds(5));
+    auto hang = [](std::set<unsigned int> devices) {
+        std::lock_guard guard(xrt::device::mock_mutex);
+        xrt::ip::mock_hung_devices = std::move(devices);
+    };
+    Finn::vector<int8_t> data(300, 1);
+    std::vector<uint8_t> results(driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, outputDmaName));
+
+    // Recovery frees the buffers the session maps, so the session must not be used anymore
+    auto session = driver.prepare();
+    hang({0});
+    EXPECT_THROW(session.infer(data.begin(), data.end(), std::span<uint8_t>(results)), Finn::KernelTimeoutError);
+    hang({});
+    EXPECT_TRUE(session.valid());
+    EXPECT_EQ(driver.recoverStuckDevices(), 1);
+    EXPECT_FALSE(session.valid());
+    EXPECT_THROW(session.infer(data.begin(), data.end(), std::span<uint8_t>(results)), std::logic_error);
+    session = driver.prepare();
+    EXPECT_EQ(session.infer(data.begin(), data.end(), std::span<uint8_t>(results)), results.size());
+
+    // The same holds for devices recovered by the watchdog, which does not go through the driver
+    hang({0});
+    EXPECT_THROW(session.infer(data.begin(), data.end(), std::span<uint8_t>(results)), Finn::KernelTimeoutError);
+    hang({});
+    driver.startWatchdog(std::chrono::milliseconds(1));
+    const auto giveUp = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (driver.getDeviceHandler(0).isStuck() && std::chrono::steady_clock::now() < giveUp) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    driver.stopWatchdog();
+    EXPECT_FALSE(driver.getDeviceHandler(0).isStuck());
+    EXPECT_THROW(session.infer(data.begin(), data.end(), std::span<uint8_t>(results)), std::logic_error);
+}
+
+TEST_F(BaseDriverTest, syncInferenceConcurrentTest) {
+    {
+        // Buffer sets are checked out independently of each other and of the device lock
+        Finn::Accelerator accelerator(unittestConfig.deviceWrappers, true, 1, 2);
+        auto first = accelerator.acquireBufferSet();
+        auto second = accelerator.acquireBufferSet();
+        EXPECT_NE(first.slot(), second.slot());
+        EXPECT_EQ(accelerator.getAvailableBufferSets(0), 0);
+        EXPECT_EQ(accelerator.getOutstandingWork(0), 2);
+        auto deviceLock = first.lockDevice();
+        EXPECT_TRUE(deviceLock.owns_lock());
+    }
+
+    auto driver = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 1, true);
+    constexpr unsigned int slots = 3;
+    driver.setBufferSlots(slots);
+    EXPECT_EQ(driver.getAccelerator().getAvailableBufferSets(0), slots);
+
+    // Neighbouring slots get different fake output data (the output is binary), so mixed up slots show in the results
+    const std::size_t outputSize = driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, outputDmaName);
+    auto& handler = driver.getDeviceHandler(0);
+    for (std::size_t slot = 0; slot < slots; ++slot) {
+        handler.setActiveBufferSlot(slot);
+        handler.getOutputBuffer(outputDmaName)->testSetMap(Finn::vector<uint8_t>(outputSize, static_cast<uint8_t>(slot % 2)));
+    }
+
+    constexpr std::size_t threads = 4;
+    constexpr std::size_t inferences = 25;
+    std::vector<std::size_t> valid(threads, 0);
+    {
+        std::vector<std::jthread> clients;
+        for (std::size_t client = 0; client < threads; ++client) {
+            clients.emplace_back([&, client]() {
+                Finn::vector<int8_t> data(300, static_cast<int8_t>(client));
+                std::vector<uint8_t> results(outputSize);
+                for (std::size_t i = 0; i < inferences; ++i) {
+                    std::fill(results.begin(), results.end(), 42);
+                    driver.inferSynchronousScheduled(data.begin(), data.end(), std::span<uint8_t>(results));
+                    // Every result was unpacked completely from a single slot
+                    if (std::all_of(results.begin(), results.end(), [&](uint8_t val) { return val == results.front() && val < 2; })) {
+                        ++valid[client];
+                    }
+                }
+            });
+        }
+    }
+    EXPECT_EQ(std::accumulate(valid.begin(), valid.end(), std::size_t{0}), threads * inferences);
+    EXPECT_EQ(driver.getAccelerator().getAvailableBufferSets(0), slots);
+    EXPECT_EQ(driver.getAccelerator().getOutstandingWork(0), 0);
+}
+
+TEST_F(BaseDriverTest, syncInferenceReplicatedTest) {
+    // The design is replicated on the card, the second idma/odma pair has the same shapes as the first one
+    Finn::Config config = unittestConfig;
+    const std::string secondInput = "StreamingDataflowPartition_0:{idma1}";
+    const std::string secondOutput = "StreamingDataflowPartition_2:{odma1}";
+    auto& devWrap = config.deviceWrappers[0];
+    auto replicaInput = std::make_shared<Finn::ExtendedBufferDescriptor>(*std::dynamic_pointer_cast<Finn::ExtendedBufferDescriptor>(devWrap.idmas[0]));
+    replicaInput->kernelName = secondInput;
+    auto replicaOutput = std::make_shared<Finn::ExtendedBufferDescriptor>(*std::dynamic_pointer_cast<Finn::ExtendedBufferDescriptor>(devWrap.odmas[0]));
+    replicaOutput->kernelName = secondOutput;
+    devWrap.idmas.emplace_back(replicaInput);
+    devWrap.odmas.emplace_back(replicaOutput);
+    devWrap.replicatedComputeUnits = true;
+
+    auto driver = Finn::Driver<true>(config, 0, inputDmaName, 0, outputDmaName, 1, true);
+    EXPECT_EQ(driver.getComputeUnitPairCount(), 2);
+    {
+        // Two callers get different pairs and neither holds the device
+        auto first = driver.getAccelerator().acquireComputeUnits();
+        auto second = driver.getAccelerator().acquireComputeUnits();
+        EXPECT_NE(first.index(), second.index());
+        EXPECT_EQ(driver.getAccelerator().getAvailableComputeUnits(0), 0);
+        EXPECT_EQ(second.pair().inputKernelName, (second.index() == 0) ? inputDmaName : secondInput);
+    }
+    EXPECT_EQ(driver.getAccelerator().getAvailableComputeUnits(0), 2);
+
+    // Every pair gets its own fake output data, so the results show which pair a batch ran on
+    const std::size_t outputSize = driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, outputDmaName);
+    auto& device = driver.getDeviceHandler(0);
+    device.getOutputBuffer(outputDmaName)->testSetMap(Finn::vector<uint8_t>(outputSize, 0));
+    device.getOutputBuffer(secondOutput)->testSetMap(Finn::vector<uint8_t>(outputSize, 1));
+
+    constexpr std::size_t batches = 8;
+    Finn::vector<int8_t> data(300 * batches, 1);
+    std::vector<uint8_t> results(outputSize * batches, 42);
+    auto written = driver.inferSynchronousDataParallel(data.begin(), data.end(), std::span<uint8_t>(results));
+    EXPECT_EQ(written, results.size());
+    for (std::size_t batch = 0; batch < batches; ++batch) {
+        auto batchBegin = results.begin() + static_cast<std::ptrdiff_t>(batch * outputSize);
+        // Every batch was written completely and by a single pair
+        EXPECT_TRUE(std::all_of(batchBegin, batchBegin + static_cast<std::ptrdiff_t>(outputSize), [&](uint8_t val) { return val == *batchBegin && val < 2; }));
+    }
+    EXPECT_EQ(driver.getAccelerator().getOutstandingWork(0), 0);
+
+    // A single batch on the second pair only touches its own buffers
+    {
+        auto first = driver.getAccelerator().acquireComputeUnits();
+        std::vector<uint8_t> single(outputSize, 42);
+        driver.inferSynchronousReplicated(data.begin(), data.begin() + 300, std::span<uint8_t>(single));
+        EXPECT_EQ(single, std::vector<uint8_t>(outputSize, static_cast<uint8_t>(first.index() == 0)));
+    }
+
+    // Replicas have to be identical
+    devWrap.odmas[1] = std::make_shared<Finn::ExtendedBufferDescriptor>(secondOutput, shape_t{1, 4, 1}, shape_t{1, 4}, shape_t{1, 4, 1});
+    EXPECT_THROW(auto mismatched = Finn::Driver<true>(config, 0, inputDmaName, 0, outputDmaName, 1, true), std::invalid_argument);
+}
+
+TEST_F(BaseDriverTest, syncInferenceModelParallelTest) {
+    // Device 0 runs the first part of the network, its output feeds device 1 which produces the results
+    Finn::Config config = twoDeviceConfig();
+    const std::string linkName = "StreamingDataflowPartition_1:{idma0}";
+    auto link = std::make_shared<Finn::ExtendedBufferDescriptor>(linkName, shape_t{1, 10, 1}, shape_t{1, 10}, shape_t{1, 10, 1});
+    link->producer = Finn::BufferLink{0, outputDmaName};
+    config.deviceWrappers[1].idmas = {link};
+    // Device 1 is listed first, the pipeline order is taken from the links
+    std::swap(config.deviceWrappers[0], config.deviceWrappers[1]);
+
+    auto driver = Finn::Driver<true>(config, 0, inputDmaName, 0, outputDmaName, 1, true);
+    EXPECT_EQ(driver.getPipelineDepth(), 2);
+
+    const std::size_t outputSize = driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 1, outputDmaName);
+    Finn::vector<uint8_t> intermediate(driver.size(SIZE_SPECIFIER::FEATUREMAP_SIZE, 0, outputDmaName));
+    std::iota(intermediate.begin(), intermediate.end(), 0);
+    driver.getDeviceHandler(0).getOutputBuffer(outputDmaName)->testSetMap(intermediate);
+    driver.getDeviceHandler(1).getOutputBuffer(outputDmaName)->testSetMap(Finn::vector<uint8_t>(outputSize, 1));
+
+    constexpr std::size_t batches = 3;
+    Finn::vector<int8_t> data(300 * batches, 1);
+    std::vector<uint8_t> results(outputSize * batches, 42);
+    auto written = driver.inferSynchronousModelParallel(data.begin(), data.end(), std::span<uint8_t>(results));
+    EXPECT_EQ(written, results.size());
+    EXPECT_TRUE(std::all_of(results.begin(), results.end(), [](uint8_t val) { return val == 1; }));
+
+    // The second stage received the output of the first one without going through the host
+    EXPECT_EQ(driver.getDeviceHandler(1).getInputBuffer(linkName)->testGetMap(), intermediate);
+
+    // Without links the pipeline is disabled
+    auto single = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 1, true);
+    EXPECT_EQ(single.getPipelineDepth(), 0);
+}
+
+TEST_F(BaseDriverTest, syncInferenceMultiIOTest) {
+    // Second input and output on the same device
+    Finn::Config config = unittestConfig;
+    const std::string secondInput = "StreamingDataflowPartition_0:{idma1}";
+    const std::string secondOutput = "StreamingDataflowPartition_2:{odma1}";
+    config.deviceWrappers[0].idmas.emplace_back(std::make_shared<Finn::ExtendedBufferDescriptor>(secondInput, shape_t{1, 5, 2}, shape_t{1, 40}, shape_t{1, 5, 8}));
+    config.deviceWrappers[0].odmas.emplace_back(std::make_shared<Finn::ExtendedBufferDescriptor>(secondOutput, shape_t{1, 4, 1}, shape_t{1, 4}, shape_t{1, 4, 1}));
+    auto driver = Finn::Driver<true>(config, 0, inputDmaName, 0, outputDmaName, 1, true);
+    EXPECT_EQ(driver.getInputKernelNames(0), (std::vector<std::string>{inputDmaName, secondInput}));
+    EXPECT_EQ(driver.getOutputKernelNames(0), (std::vector<std::string>{outputDmaName, secondOutput}));
+
+    auto& device = driver.getDeviceHandler(0);
+    device.getOutputBuffer(outputDmaName)->testSetMap(Finn::vector<uint8_t>(10, 1));
+    device.getOutputBuffer(secondOutput)->testSetMap(Finn::vector<uint8_t>{0, 1, 1, 0});
+
+    Finn::vector<int8_t> first(300, 1);
+    Finn::vector<int8_t> second(40, -1);
+    auto results = driver.inferSynchronousMultiIO(std::vector<std::span<const int8_t>>{first, second});
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_EQ(results[0], Finn::vector<uint8_t>(10, 1));
+    EXPECT_EQ(results[1], (Finn::vector<uint8_t>{0, 1, 1, 0}));
+
+    // Both inputs were packed into their own buffers: -1 as INT2 is 0b11
+    auto packedSecond = device.getInputBuffer(secondInput)->testGetMap();
+    EXPECT_TRUE(std::all_of(packedSecond.begin(), packedSecond.end(), [](uint8_t val) { return val == 0xFF; }));
+    auto packedFirst = device.getInputBuffer(inputDmaName)->testGetMap();
+    EXPECT_EQ(packedFirst[0], 0x55);
+
+    EXPECT_THROW(auto missing = driver.inferSynchronousMultiIO(std::vector<std::span<const int8_t>>{first}), std::invalid_argument);
+    Finn::vector<int8_t> wrongSize(39, 1);
+    EXPECT_ANY_THROW(auto wrong = driver.inferSynchronousMultiIO(std::vector<std::span<const int8_t>>{first, wrongSize}));
+}
+
+TEST_F(BaseDriverTest, asyncResultCallbackTest) {
+    auto driver = Finn::Driver<false>(unittestConfig, hostBufferSize);
+    using V = Finn::Driver<false>::AutoDeducedRetType;
+    const std::size_t expectedSize = FinnUtils::shapeToElements(static_cast<Finn::ExtendedBufferDescriptor*>(unittestConfig.deviceWrappers[0].odmas[0].get())->foldedShape);
+
+    // The output is started for the samples every input run moved, so every stored batch element produces one result
+    std::atomic<std::size_t> calls = 0;
+    std::atomic<std::size_t> receivedSize = 0;
+    driver.setResultCallback([&](std::span<const V> result) {
+        receivedSize = result.size();
+        ++calls;
+        calls.notify_one();
+    });
+    auto& input = driver.getDeviceHandler(0).getInputBuffer(inputDmaName);
+    Finn::vector<uint8_t> packed(input->size(SIZE_SPECIFIER::FEATUREMAP_SIZE) * 3, 1);
+    EXPECT_TRUE(input->store({packed.begin(), packed.end()}));
+    for (std::size_t seen = calls.load(); seen < 3; seen = calls.load()) {
+        calls.wait(seen);
+    }
+    driver.setResultCallback({});
+    EXPECT_EQ(receivedSize.load(), expectedSize);
+
+    // Without a callback the results are archived and can be fetched with getResults
+    EXPECT_TRUE(input->store({packed.begin(), packed.end()}));
+    while (driver.getResults(0, outputDmaName, true).empty()) {
+        std::this_thread::yield();
+    }
+}
+
+namespace {
+    /**
+     * @brief Minimal fire and forget coroutine type to test the awaitable
+     *
+     */
+    struct DetachedTask {
+        struct promise_type {
+            DetachedTask get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    DetachedTask awaitInference(Finn::Driver<false>& driver, const Finn::vector<int8_t>& data, std::atomic<std::size_t>& resultSize) {
+        auto result = co_await driver.inferAwaitable(data.begin(), data.end(), 0, inputDmaName, 0, outputDmaName, 2);
+        resultSize = result.size();
+        resultSize.notify_one();
+    }
+
+    DetachedTask awaitChain(Finn::Driver<false>& driver, const Finn::vector<int8_t>& data, std::atomic<std::size_t>& completed, std::size_t length) {
+        for (std::size_t i = 0; i < length; ++i) {
+            // Resumed on the worker thread of the output, so every request after the first is submitted from there
+            auto result = co_await driver.inferAwaitable(data.begin(), data.end(), 0, inputDmaName, 0, outputDmaName, 2);
+            EXPECT_FALSE(result.empty());
+            ++completed;
+            completed.notify_one();
+        }
+    }
+}  // namespace
+
+TEST_F(BaseDriverTest, asyncInferTest) {
+    using namespace std::chrono_literals;
+    auto driver = Finn::Driver<false>(unittestConfig, hostBufferSize);
+    const std::size_t outputSize = driver.getOutputElementsPerSample();
+    Finn::vector<int8_t> data(driver.getInputElementsPerSample() * 2, 1);
+
+    // The worker thread of the output delivers one result per stored batch element to the pending requests
+    std::vector<std::future<Finn::vector<uint8_t>>> futures(6);
+    {
+        std::vector<std::jthread> clients;
+        for (std::size_t client = 0; client < 2; ++client) {
+            clients.emplace_back([&, client]() {
+                for (std::size_t i = client; i < futures.size(); i += 2) {
+                    futures[i] = driver.inferAsync(data.begin(), data.end(), 0, inputDmaName, 0, outputDmaName, 2);
+                }
+            });
+        }
+    }
+    for (auto&& future : futures) {
+        ASSERT_EQ(future.wait_for(10s), std::future_status::ready);
+        EXPECT_EQ(future.get().size(), outputSize * 2);
+    }
+    EXPECT_EQ(driver.getAsyncInFlight(0, outputDmaName), 0);
+
+    std::atomic<std::size_t> resultSize = 0;
+    awaitInference(driver, data, resultSize);
+    for (std::size_t seen = resultSize.load(); seen == 0; seen = resultSize.load()) {
+        resultSize.wait(seen);
+    }
+    EXPECT_EQ(resultSize.load(), outputSize * 2);
+
+    Finn::vector<int8_t> wrongSize(data.size() - 1, 1);
+    EXPECT_THROW(auto invalid = driver.inferAsync(wrongSize.begin(), wrongSize.end(), 0, inputDmaName, 0, outputDmaName, 2), std::runtime_error);
+}
+
+TEST_F(BaseDriverTest, asyncSubmitFromCompletionTest) {
+    using namespace std::chrono_literals;
+    auto driver = Finn::Driver<false>(unittestConfig, hostBufferSize);
+    Finn::vector<int8_t> data(driver.getInputElementsPerSample() * 2, 1);
+    // A slow kernel keeps the ring of the input full while the completions submit the next request
+    xrt::simulation::Model model;
+    model.kernelLatency = 20ms;
+    xrt::simulation::configure(model);
+
+    constexpr std::size_t chainLength = 4;
+    std::atomic<std::size_t> completed = 0;
+    awaitChain(driver, data, completed, chainLength);
+    std::vector<std::future<Finn::vector<uint8_t>>> futures(3 * hostBufferSize);
+    std::atomic<bool> submitted = false;
+    std::jthread producer([&]() {
+        for (auto&& future : futures) {
+            future = driver.inferAsync(data.begin(), data.end(), 0, inputDmaName, 0, outputDmaName, 2);
+        }
+        submitted = true;
+    });
+    // Does not wait for the producer, which is blocked on the full ring most of the time
+    while (!submitted) {
+        EXPECT_LE(driver.getAsyncInFlight(0, outputDmaName), futures.size() + 1);
+        std::this_thread::sleep_for(5ms);
+    }
+    producer.join();
+    for (auto&& future : futures) {
+        ASSERT_EQ(future.wait_for(10s), std::future_status::ready);
+    }
+    const auto deadline = std::chrono::steady_clock::now() + 10s;
+    while (completed.load() < chainLength && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    EXPECT_EQ(completed.load(), chainLength);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
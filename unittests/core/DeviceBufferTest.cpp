@@ -13,14 +13,21 @@
 #include <FINNCppDriver/utils/Logger.h>
 
 #include <FINNCppDriver/core/DeviceBuffer/AsyncDeviceBuffers.hpp>
+#include <FINNCppDriver/core/DeviceBuffer/DeviceMemoryArena.hpp>
 #include <FINNCppDriver/core/DeviceBuffer/SyncDeviceBuffers.hpp>
 #include <FINNCppDriver/utils/FinnDatatypes.hpp>
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <random>
 #include <span>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "xrt/xrt_device.h"
+#include "xrt_simulation.h"
 
 // Provides config and shapes for testing
 #include "UnittestConfig.h"
@@ -54,6 +61,392 @@ TEST_F(DBTest, DBOutputTest) {
     EXPECT_EQ(data, vec);
 }
 
+TEST_F(DBTest, DBLoadFromTest) {
+    Finn::SyncDeviceOutputBuffer<uint8_t> producer("OutputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts);
+    Finn::SyncDeviceInputBuffer<uint8_t> consumer("InputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts, 1, xrt::bo::flags::p2p);
+    Finn::vector<uint8_t> data(producer.size(SIZE_SPECIFIER::TOTAL_DATA_SIZE));
+    filler.fillRandom(data.begin(), data.end());
+    producer.testSetMap(data);
+
+    // The mocked buffer objects support device to device copies
+    EXPECT_TRUE(consumer.loadFrom(producer));
+    EXPECT_EQ(consumer.testGetMap(), data);
+    EXPECT_TRUE(consumer.run());
+
+    Finn::SyncDeviceOutputBuffer<uint8_t> tooSmall("OutputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts - 1);
+    EXPECT_THROW(consumer.loadFrom(tooSmall), std::length_error);
+}
+
+TEST_F(DBTest, DBMemoryArenaTest) {
+    const std::size_t bytes = FinnUtils::shapeToElements(FinnUnittest::myShapePacked) * FinnUnittest::parts;
+    auto arena = std::make_shared<Finn::DeviceMemoryArena>(device, FinnUtils::getAlignedBufferSize(bytes) * 3, 0);
+    Finn::SyncDeviceInputBuffer<uint8_t> input("InputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts, 2, xrt::bo::flags::normal, arena);
+    Finn::SyncDeviceOutputBuffer<uint8_t> output("OutputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts, 1, arena);
+
+    // Sub-buffers are sized exactly and aligned, not rounded up to a power of two
+    EXPECT_EQ(input.bufferObjectBytes(), bytes * 2);
+    EXPECT_EQ(arena->getUsed(), arena->getCapacity());
+    EXPECT_THROW(Finn::SyncDeviceOutputBuffer<uint8_t>("OutputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts, 1, arena), std::length_error);
+
+    // The slots do not overlap
+    Finn::vector<uint8_t> data(input.size(SIZE_SPECIFIER::TOTAL_DATA_SIZE));
+    filler.fillRandom(data.begin(), data.end());
+    input.store({data.begin(), data.end()});
+    input.setActiveBufferSlot(1);
+    Finn::vector<uint8_t> other(data.size(), 7);
+    input.store({other.begin(), other.end()});
+    output.testSetMap(other);
+    EXPECT_EQ(std::vector<uint8_t>(input.getMap(0).begin(), input.getMap(0).end()), std::vector<uint8_t>(data.begin(), data.end()));
+    EXPECT_EQ(std::vector<uint8_t>(input.getMap(1).begin(), input.getMap(1).end()), std::vector<uint8_t>(other.begin(), other.end()));
+    output.read();
+    EXPECT_EQ(output.getData(), other);
+}
+
+TEST_F(DBTest, DBWaitPolicyTest) {
+    Finn::SyncDeviceOutputBuffer<uint8_t> buffer("OutputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts);
+    EXPECT_EQ(buffer.getWaitPolicy(), WAIT_POLICY::SPIN);
+    EXPECT_TRUE(buffer.wait());
+
+    for (auto policy : {WAIT_POLICY::SPIN_YIELD, WAIT_POLICY::INTERRUPT, WAIT_POLICY::SPIN}) {
+        buffer.setWaitPolicy(policy, 10);
+        EXPECT_EQ(buffer.getWaitPolicy(), policy);
+        EXPECT_TRUE(buffer.run());
+        EXPECT_TRUE(buffer.wait());
+    }
+    EXPECT_THROW(buffer.setWaitPolicy(WAIT_POLICY::INVALID), std::invalid_argument);
+}
+
+TEST_F(DBTest, DBExecuteTimeoutTest) {
+    Finn::SyncDeviceOutputBuffer<uint8_t> buffer("OutputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts);
+    EXPECT_EQ(buffer.getExecuteTimeout().count(), 0);
+    EXPECT_THROW(buffer.setExecuteTimeout(std::chrono::microseconds(-1)), std::invalid_argument);
+    buffer.setExecuteTimeout(std::chrono::milliseconds(5));
+    EXPECT_EQ(buffer.getExecuteTimeout(), std::chrono::milliseconds(5));
+
+    {
+        std::lock_guard guard(xrt::device::mock_mutex);
+        xrt::ip::mock_hung_devices.insert(device.index);
+    }
+    for (auto policy : {WAIT_POLICY::SPIN, WAIT_POLICY::SPIN_YIELD, WAIT_POLICY::INTERRUPT}) {
+        buffer.setWaitPolicy(policy, 10);
+        EXPECT_TRUE(buffer.run());
+        const auto start = std::chrono::steady_clock::now();
+        EXPECT_THROW(buffer.wait(), Finn::KernelTimeoutError);
+        EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(5));
+    }
+    {
+        std::lock_guard guard(xrt::device::mock_mutex);
+        xrt::ip::mock_hung_devices.clear();
+    }
+    const auto metrics = buffer.getMetrics().snapshot("OutputBuffer", IO::OUTPUT);
+    EXPECT_EQ(metrics.timeouts, 3);
+    EXPECT_EQ(metrics.completions, 0);
+
+    // Runs that finish in time are not affected by the timeout
+    Finn::SyncDeviceOutputBuffer<uint8_t> healthy("OutputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts);
+    healthy.setExecuteTimeout(std::chrono::milliseconds(5));
+    EXPECT_TRUE(healthy.run());
+    EXPECT_TRUE(healthy.wait());
+    EXPECT_EQ(healthy.getMetrics().snapshot("OutputBuffer", IO::OUTPUT).timeouts, 0);
+}
+
+TEST_F(DBTest, DBAsyncOutputCallbackTest) {
+    Finn::AsyncDeviceOutputBuffer<uint8_t> buffer("OutputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts);
+    std::atomic<std::size_t> calls = 0;
+    std::atomic<std::size_t> receivedSize = 0;
+    buffer.setResultCallback([&](std::span<const uint8_t> result) {
+        receivedSize = result.size();
+        ++calls;
+        calls.notify_one();
+    });
+    // The mocked IP core finishes immediately, so results are published continuously
+    for (std::size_t seen = calls.load(); seen < 3; seen = calls.load()) {
+        calls.wait(seen);
+    }
+    EXPECT_EQ(receivedSize.load(), buffer.size(SIZE_SPECIFIER::FEATUREMAP_SIZE));
+
+    // Without a callback, results end up in the archive again
+    buffer.setResultCallback({});
+    buffer.setWaitPolicy(WAIT_POLICY::SPIN_YIELD, 10);
+    while (buffer.testGetRingBuffer().empty()) {
+        std::this_thread::yield();
+    }
+    buffer.archiveValidBufferParts();
+    EXPECT_FALSE(buffer.getData().empty());
+}
+
+TEST_F(DBTest, DBAsyncCallbackReentryTest) {
+    Finn::AsyncDeviceOutputBuffer<uint8_t> buffer("OutputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts);
+    std::atomic<std::size_t> calls = 0;
+    // A callback that calls into the buffer and removes itself must not block the worker
+    buffer.setResultCallback([&](std::span<const uint8_t>) {
+        EXPECT_EQ(buffer.getArchivedParts(), 0);
+        buffer.setResultCallback({});
+        ++calls;
+        calls.notify_one();
+    });
+    calls.wait(0);
+    while (buffer.testGetRingBuffer().empty()) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(calls.load(), 1);
+}
+
+TEST_F(DBTest, DBAsyncArchiveCapacityTest) {
+    Finn::AsyncDeviceOutputBuffer<uint8_t> buffer("OutputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts);
+    const std::size_t partSize = buffer.size(SIZE_SPECIFIER::FEATUREMAP_SIZE);
+    EXPECT_EQ(buffer.getArchiveCapacity(), defaultArchiveCapacity / partSize * partSize);
+    buffer.setArchiveCapacity(2 * partSize);
+    buffer.setWaitPolicy(WAIT_POLICY::SPIN_YIELD, 10);
+
+    // The mocked IP core never stops producing, so the worker has to stall once the ring buffer and the archive are full
+    while (!buffer.testGetRingBuffer().full() || buffer.getArchivedParts() < 2) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(buffer.getArchivedParts(), 2);
+    EXPECT_EQ(buffer.archiveValidBufferParts(), 0);
+
+    // Retrieving the archive lets the worker continue
+    EXPECT_EQ(buffer.getData().size(), 2 * partSize);
+    while (buffer.getArchivedParts() < 2) {
+        std::this_thread::yield();
+    }
+    auto chunks = buffer.getDataChunks();
+    ASSERT_FALSE(chunks.empty());
+    EXPECT_EQ(chunks.front().size() % partSize, 0);
+}
+
+TEST_F(DBTest, DBAsyncInputTest) {
+    Finn::AsyncDeviceInputBuffer<uint8_t> buffer("InputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts);
+    Finn::vector<uint8_t> data(buffer.size(SIZE_SPECIFIER::FEATUREMAP_SIZE));
+    filler.fillRandom(data.begin(), data.end());
+    EXPECT_TRUE(buffer.store({data.begin(), data.end()}));
+    // The worker thread moves the data to the device and runs the kernel
+    while (!buffer.testGetRingBuffer().empty()) {
+        std::this_thread::yield();
+    }
+    buffer.setWaitPolicy(WAIT_POLICY::INTERRUPT);
+    EXPECT_TRUE(buffer.store({data.begin(), data.end()}));
+    while (!buffer.testGetRingBuffer().empty()) {
+        std::this_thread::yield();
+    }
+}
+
+TEST_F(DBTest, DBAsyncCoalescingTest) {
+    // Every kernel run takes a while, so the samples stored during the first run are waiting for the worker together
+    xrt::simulation::Model model;
+    model.kernelLatency = std::chrono::milliseconds(50);
+    xrt::simulation::configure(model);
+    auto launches = std::make_shared<Finn::AsyncLaunchChannel>();
+    Finn::AsyncDeviceOutputBuffer<uint8_t> output("OutputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts, launches);
+    const std::size_t partSize = output.size(SIZE_SPECIFIER::FEATUREMAP_SIZE);
+    Finn::vector<uint8_t> fakeResults(FinnUnittest::parts * partSize);
+    for (std::size_t i = 0; i < fakeResults.size(); ++i) {
+        fakeResults[i] = static_cast<uint8_t>(i / partSize);
+    }
+    output.testSetMap(fakeResults);
+    std::mutex resultMutex;
+    std::vector<uint8_t> results;
+    std::atomic<std::size_t> calls = 0;
+    output.setResultCallback([&](std::span<const uint8_t> result) {
+        {
+            std::lock_guard guard(resultMutex);
+            results.push_back(result.front());
+        }
+        ++calls;
+        calls.notify_one();
+    });
+    // Without input nothing is read from the device
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(calls.load(), 0);
+
+    Finn::AsyncDeviceInputBuffer<uint8_t> input("InputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts, launches);
+    EXPECT_EQ(input.getMaxBatchSize(), FinnUnittest::parts);
+    EXPECT_EQ(input.getPackedShape()[0], 1);
+    Finn::vector<uint8_t> data(input.size(SIZE_SPECIFIER::FEATUREMAP_SIZE) * 5);
+    filler.fillRandom(data.begin(), data.end());
+    EXPECT_TRUE(input.store({data.begin(), data.begin() + static_cast<std::ptrdiff_t>(data.size() / 5)}));
+    while (!input.testGetRingBuffer().empty()) {
+        std::this_thread::yield();
+    }
+    EXPECT_TRUE(input.store({data.begin() + static_cast<std::ptrdiff_t>(data.size() / 5), data.end()}));
+    for (std::size_t seen = calls.load(); seen < 5; seen = calls.load()) {
+        calls.wait(seen);
+    }
+    xrt::simulation::configure({});
+
+    // One run for the first sample and one for the four that were stored while it ran, the output is started for as many samples
+    EXPECT_EQ(input.getMetrics().snapshot("InputBuffer", IO::INPUT).invocations, 2);
+    EXPECT_EQ(input.testGetMap().size(), input.size(SIZE_SPECIFIER::FEATUREMAP_SIZE));
+    EXPECT_EQ(output.getMetrics().snapshot("OutputBuffer", IO::OUTPUT).invocations, 2);
+    EXPECT_EQ(launches->pending(), 0);
+    std::lock_guard guard(resultMutex);
+    EXPECT_EQ(results, (std::vector<uint8_t>{0, 0, 1, 2, 3}));
+}
+
+TEST_F(DBTest, DBAsyncWaitPolicyTest) {
+    auto launches = std::make_shared<Finn::AsyncLaunchChannel>();
+    Finn::AsyncDeviceOutputBuffer<uint8_t> output("OutputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts, launches, WAIT_POLICY::SPIN_YIELD, 10);
+    Finn::AsyncDeviceInputBuffer<uint8_t> input("InputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts, launches, WAIT_POLICY::SPIN_YIELD, 10);
+    EXPECT_EQ(output.getWaitPolicy(), WAIT_POLICY::SPIN_YIELD);
+    EXPECT_EQ(input.getWaitPolicy(), WAIT_POLICY::SPIN_YIELD);
+    output.setArchiveCapacity(0);
+
+    // Pausing the workers over and over neither loses nor duplicates results
+    Finn::vector<uint8_t> data(input.size(SIZE_SPECIFIER::FEATUREMAP_SIZE));
+    filler.fillRandom(data.begin(), data.end());
+    constexpr std::size_t samples = 3 * FinnUnittest::parts;
+    for (std::size_t i = 0; i < samples; ++i) {
+        EXPECT_TRUE(input.store({data.begin(), data.end()}));
+        output.setWaitPolicy((i % 2 == 0) ? WAIT_POLICY::INTERRUPT : WAIT_POLICY::SPIN_YIELD, 10);
+        input.setWaitPolicy((i % 2 == 0) ? WAIT_POLICY::INTERRUPT : WAIT_POLICY::SPIN_YIELD, 10);
+        output.archiveValidBufferParts();
+    }
+    while (launches->pending() > 0 || !input.testGetRingBuffer().empty() || output.getArchivedParts() + output.testGetRingBuffer().size() < samples) {
+        output.archiveValidBufferParts();
+        std::this_thread::yield();
+    }
+    output.archiveValidBufferParts();
+    EXPECT_EQ(output.getArchivedParts(), samples);
+}
+
+TEST_F(DBTest, DBAsyncTransferTest) {
+    Finn::SyncDeviceInputBuffer<uint8_t> input("InputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts, 2);
+    Finn::SyncDeviceOutputBuffer<uint8_t> output("OutputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts, 2);
+    const std::size_t started = xrt::bo::async_handle::startedTransfers;
+    const std::size_t joined = xrt::bo::async_handle::joinedTransfers;
+
+    // The upload of slot 1 stays in flight while slot 0 runs and is read back, the run of slot 1 only joins it
+    input.upload(1);
+    EXPECT_TRUE(input.transferPending());
+    EXPECT_TRUE(input.run());
+    EXPECT_FALSE(input.transferPending());
+    output.startRead();
+    output.startRead();  // Already in flight
+    EXPECT_TRUE(output.transferPending());
+    EXPECT_TRUE(output.read());
+    EXPECT_FALSE(output.transferPending());
+    EXPECT_EQ(xrt::bo::async_handle::startedTransfers - started, 2);
+    EXPECT_EQ(xrt::bo::async_handle::joinedTransfers - joined, 2);
+
+    input.setActiveBufferSlot(1);
+    input.upload(1);
+    input.upload();  // Already in flight
+    EXPECT_TRUE(input.run());
+    EXPECT_FALSE(input.transferPending());
+    EXPECT_EQ(xrt::bo::async_handle::startedTransfers - started, 3);
+    EXPECT_EQ(xrt::bo::async_handle::joinedTransfers - joined, 3);
+    EXPECT_THROW(input.upload(2), std::out_of_range);
+}
+
+TEST_F(DBTest, DBMetricsTest) {
+    Finn::SyncDeviceInputBuffer<uint8_t> input("InputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts);
+    Finn::SyncDeviceOutputBuffer<uint8_t> output("OutputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts);
+    output.setCycleCounter(xrt::ip::mock_cycle_counter_offset);
+    const std::size_t bytes = FinnUtils::shapeToElements(FinnUnittest::myShapePacked) * FinnUnittest::parts;
+    for (int i = 0; i < 3; ++i) {
+        input.upload();
+        EXPECT_TRUE(output.run());
+        EXPECT_TRUE(input.run());
+        EXPECT_TRUE(output.wait());
+        EXPECT_TRUE(output.read());
+    }
+
+    const auto in = input.getMetrics().snapshot("InputBuffer", IO::INPUT);
+    EXPECT_EQ(in.invocations, 3);
+    // Synchronous inputs are never waited for
+    EXPECT_EQ(in.completions, 0);
+    EXPECT_EQ(in.transfers, 3);
+    EXPECT_EQ(in.bytes, 3 * bytes);
+    EXPECT_EQ(in.deviceCycles, 0);
+
+    const auto out = output.getMetrics().snapshot("OutputBuffer", IO::OUTPUT);
+    EXPECT_EQ(out.invocations, 3);
+    EXPECT_EQ(out.completions, 3);
+    EXPECT_EQ(out.transfers, 3);
+    EXPECT_GT(out.bytes, 0);
+    EXPECT_EQ(out.deviceCycles, 3 * xrt::ip::mock_cycle_counter);
+    EXPECT_GE(out.busyTime.count(), 0);
+
+    // A wait without a run in between is not counted twice
+    EXPECT_TRUE(output.wait());
+    EXPECT_EQ(output.getMetrics().snapshot("OutputBuffer", IO::OUTPUT).completions, 3);
+
+    // Counters handed in from outside keep counting
+    auto shared = std::make_shared<Finn::BufferMetrics>();
+    input.setMetrics(shared);
+    input.upload();
+    EXPECT_TRUE(input.run());
+    EXPECT_EQ(shared->snapshot("InputBuffer", IO::INPUT).invocations, 1);
+    shared->reset();
+    EXPECT_EQ(shared->snapshot("InputBuffer", IO::INPUT).bytes, 0);
+}
+
+TEST_F(DBTest, DBStreamedInputTest) {
+    Finn::SyncDeviceInputBuffer<uint8_t> input("InputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts);
+    EXPECT_EQ(input.getTransferMode(), TRANSFER_MODE::MEMORY_BUFFERED);
+    EXPECT_THROW(input.setTransferMode(TRANSFER_MODE::INVALID), std::invalid_argument);
+    EXPECT_THROW(input.setTransferMode(TRANSFER_MODE::STREAMED, 0), std::invalid_argument);
+    input.setTransferMode(TRANSFER_MODE::STREAMED, 1);
+    EXPECT_EQ(input.getTransferMode(), TRANSFER_MODE::STREAMED);
+
+    // 80 bytes per sample, so chunks have to be multiples of 4 samples to start at 64 byte aligned addresses
+    EXPECT_EQ(input.alignChunk(1), 4);
+    Finn::vector<uint8_t> data(input.size(SIZE_SPECIFIER::TOTAL_DATA_SIZE));
+    filler.fillRandom(data.begin(), data.end());
+    input.store({data.begin(), data.end()});
+    const auto started = xrt::bo::async_handle::startedTransfers;
+    input.upload();  // Streamed runs upload the active slot themselves
+    EXPECT_EQ(xrt::bo::async_handle::startedTransfers, started);
+    EXPECT_TRUE(input.run());
+
+    // Chunks of 4, 4 and 2 samples, each synced and executed on its own
+    const auto metrics = input.getMetrics().snapshot("InputBuffer", IO::INPUT);
+    EXPECT_EQ(metrics.transfers, 3);
+    EXPECT_EQ(metrics.bytes, data.size());
+    EXPECT_EQ(metrics.invocations, 3);
+    EXPECT_EQ(metrics.completions, 2);
+    EXPECT_EQ(input.testGetMap(), data);
+
+    // Data already on the device is not streamed again
+    Finn::SyncDeviceOutputBuffer<uint8_t> producer("OutputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts);
+    producer.testSetMap(data);
+    input.loadFrom(producer);
+    EXPECT_TRUE(input.run());
+    EXPECT_EQ(input.getMetrics().snapshot("InputBuffer", IO::INPUT).transfers, 4);
+    EXPECT_EQ(input.getMetrics().snapshot("InputBuffer", IO::INPUT).invocations, 4);
+}
+
+TEST_F(DBTest, DBSharedMemoryTest) {
+    Finn::SyncDeviceInputBuffer<uint8_t> input("InputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts);
+    Finn::SyncDeviceOutputBuffer<uint8_t> output("OutputBuffer", device, uuid, FinnUnittest::myShapePacked, FinnUnittest::parts);
+    EXPECT_FALSE(input.hasSharedMemory());
+    input.setSharedMemory(true);
+    output.setSharedMemory(true);
+    EXPECT_TRUE(input.hasSharedMemory());
+
+    Finn::vector<uint8_t> data(input.size(SIZE_SPECIFIER::TOTAL_DATA_SIZE));
+    filler.fillRandom(data.begin(), data.end());
+    input.store({data.begin(), data.end()});
+    output.testSetMap(data);
+    const auto started = xrt::bo::async_handle::startedTransfers;
+    input.upload();
+    output.startRead();
+    EXPECT_FALSE(input.transferPending());
+    EXPECT_EQ(xrt::bo::async_handle::startedTransfers, started);
+    EXPECT_TRUE(output.run());
+    EXPECT_TRUE(input.run());
+    EXPECT_TRUE(output.wait());
+    EXPECT_TRUE(output.read());
+    EXPECT_EQ(output.getData(), data);
+
+    // The kernels run as usual, but nothing is synced
+    EXPECT_EQ(input.getMetrics().snapshot("InputBuffer", IO::INPUT).invocations, 1);
+    EXPECT_EQ(input.getMetrics().snapshot("InputBuffer", IO::INPUT).transfers, 0);
+    EXPECT_EQ(output.getMetrics().snapshot("OutputBuffer", IO::OUTPUT).transfers, 0);
+    EXPECT_EQ(output.readChunk(0, 4).size(), 4 * output.bytesPerSample());
+    EXPECT_EQ(output.getMetrics().snapshot("OutputBuffer", IO::OUTPUT).transfers, 0);
+}
 
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
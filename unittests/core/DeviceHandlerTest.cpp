@@ -12,7 +12,9 @@
 
 #include <FINNCppDriver/core/DeviceHandler.h>
 #include <FINNCppDriver/utils/ConfigurationStructs.h>
+#include <FINNCppDriver/utils/Types.h>
 
+#include <FINNCppDriver/utils/Affinity.hpp>
 #include <algorithm>
 #include <filesystem>
 #include <fstream>
@@ -49,6 +51,12 @@ TEST_F(DeviceHandlerSetup, InitTest) {
     auto& kernel_devices = xrt::kernel::kernel_device;
     auto& kernel_uuids = xrt::kernel::kernel_uuid;
 
+    // Buffers are allocated on first use
+    EXPECT_FALSE(devicehandler.buffersAllocated());
+    EXPECT_EQ(kernel_names.size(), 0);
+    devicehandler.allocateBuffers();
+    EXPECT_TRUE(devicehandler.buffersAllocated());
+
     ASSERT_EQ(kernel_names.size(), 2);
     ASSERT_EQ(kernel_devices.size(), 2);
     ASSERT_EQ(kernel_uuids.size(), 2);
@@ -59,6 +67,11 @@ TEST_F(DeviceHandlerSetup, InitTest) {
 
     auto devicehandler2 = DeviceHandler(DeviceWrapper("somefile.xclbin", 4, {std::make_shared<BufferDescriptor>("inpName", shape_t({4}))}, {std::make_shared<BufferDescriptor>("outName", shape_t({4}))}), true, 100);
     EXPECT_EQ(xrt::device::device_costum_constructor_called, 2);
+    EXPECT_TRUE(devicehandler2.containsBuffer("inpName", IO::INPUT));
+    EXPECT_FALSE(devicehandler2.containsBuffer("inpName", IO::OUTPUT));
+    EXPECT_FALSE(devicehandler2.buffersAllocated());
+    EXPECT_EQ(devicehandler2.size(SIZE_SPECIFIER::BATCHSIZE, "inpName"), 100);
+    EXPECT_TRUE(devicehandler2.buffersAllocated());
 
     std::vector<std::string> ionames = {"inpName", "outName"};
     for (auto&& name : ionames) {
@@ -74,6 +87,33 @@ TEST_F(DeviceHandlerSetup, InitTest) {
     EXPECT_EQ(kernel_uuids[0], kernel_uuids[1]);
 }
 
+TEST_F(DeviceHandlerSetup, ReprogrammingTest) {
+    auto wrapper = [](const std::string& xclbin) { return DeviceWrapper(xclbin, 7U, {std::make_shared<BufferDescriptor>("a", shape_t({1}))}, {std::make_shared<BufferDescriptor>("b", shape_t({1}))}); };
+    const auto loads = xrt::device::load_xclbin_called;
+    auto first = DeviceHandler(wrapper(fn), true, 1);
+    EXPECT_TRUE(first.getStartupTimes().reprogrammed);
+    EXPECT_EQ(xrt::device::load_xclbin_called, loads + 1);
+
+    // The card keeps the xclbin, so a restarted driver does not program it again
+    auto second = DeviceHandler(wrapper(fn), true, 1);
+    EXPECT_FALSE(second.getStartupTimes().reprogrammed);
+    EXPECT_EQ(xrt::device::load_xclbin_called, loads + 1);
+    EXPECT_EQ(second.getStartupTimes().allocate.count(), 0);
+    EXPECT_TRUE(second.run());
+    EXPECT_GT(second.getStartupTimes().allocate.count(), 0);
+
+    // A different xclbin is loaded
+    const std::string other = "otherfile.xclbin";
+    {
+        std::fstream tmpfile(other, std::fstream::out);
+        tmpfile << "other stuff\n";
+    }
+    auto third = DeviceHandler(wrapper(other), true, 1);
+    EXPECT_TRUE(third.getStartupTimes().reprogrammed);
+    EXPECT_EQ(xrt::device::load_xclbin_called, loads + 2);
+    std::filesystem::remove(other);
+}
+
 TEST_F(DeviceHandlerSetup, ArgumentTest) {
     EXPECT_THROW(DeviceHandler(DeviceWrapper("", 0, {std::make_shared<BufferDescriptor>("a", shape_t({1}))}, {std::make_shared<BufferDescriptor>("b", shape_t({1}))}), true, 1), std::filesystem::filesystem_error);
     EXPECT_THROW(DeviceHandler(DeviceWrapper("somefile.xclbin", 0, {}, {std::make_shared<BufferDescriptor>("b", shape_t({1}))}), true, 1), std::invalid_argument);
@@ -86,6 +126,235 @@ TEST_F(DeviceHandlerSetup, ArgumentTest) {
         DeviceWrapper("somefile.xclbin", 0, {std::make_shared<BufferDescriptor>("a", shape_t({1})), std::make_shared<BufferDescriptor>("c", shape_t({1}))}, {std::make_shared<BufferDescriptor>("b", shape_t({1, 2}))}), true, 1));
 }
 
+TEST_F(DeviceHandlerSetup, VariableBatchSizeTest) {
+    auto devicehandler = DeviceHandler(DeviceWrapper("somefile.xclbin", 0U, {std::make_shared<BufferDescriptor>("a", shape_t({1, 4}))}, {std::make_shared<BufferDescriptor>("b", shape_t({1, 2}))}), true, 8);
+    EXPECT_EQ(devicehandler.getMaxBatchSize(), 8);
+
+    // Smaller batches only shrink the valid part of the buffers
+    devicehandler.setBatchSize(3);
+    EXPECT_EQ(devicehandler.getMaxBatchSize(), 8);
+    EXPECT_EQ(devicehandler.getInputBuffer("a")->getMaxBatchSize(), 8);
+    EXPECT_EQ(devicehandler.size(SIZE_SPECIFIER::BATCHSIZE, "a"), 3);
+    EXPECT_EQ(devicehandler.size(SIZE_SPECIFIER::TOTAL_DATA_SIZE, "a"), 12);
+    EXPECT_EQ(devicehandler.size(SIZE_SPECIFIER::TOTAL_DATA_SIZE, "b"), 6);
+    EXPECT_EQ(devicehandler.getInputBuffer("a")->getMap().size(), 12);
+    EXPECT_TRUE(devicehandler.run());
+    EXPECT_TRUE(devicehandler.wait());
+    EXPECT_TRUE(devicehandler.read());
+
+    // Larger batches reallocate
+    devicehandler.setBatchSize(16);
+    EXPECT_EQ(devicehandler.getMaxBatchSize(), 16);
+    EXPECT_EQ(devicehandler.getOutputBuffer("b")->getMaxBatchSize(), 16);
+    EXPECT_EQ(devicehandler.size(SIZE_SPECIFIER::TOTAL_DATA_SIZE, "b"), 32);
+
+    devicehandler.setMaxBatchSize(4);
+    EXPECT_EQ(devicehandler.size(SIZE_SPECIFIER::BATCHSIZE, "a"), 4);
+    EXPECT_EQ(devicehandler.getInputBuffer("a")->getMaxBatchSize(), 4);
+    EXPECT_THROW(devicehandler.getInputBuffer("a")->setActiveBatchSize(5), std::invalid_argument);
+    EXPECT_THROW(devicehandler.setBatchSize(0), std::invalid_argument);
+}
+
+TEST_F(DeviceHandlerSetup, MemoryArenaTest) {
+    DeviceWrapper devWrap("somefile.xclbin", 0U, {std::make_shared<BufferDescriptor>("a", shape_t({1, 3000}))}, {std::make_shared<BufferDescriptor>("b", shape_t({1, 2}))});
+    devWrap.memoryArena = true;
+    auto devicehandler = DeviceHandler(devWrap, true, 2, 2);
+    devicehandler.allocateBuffers();
+
+    // 6000 bytes per slot instead of the 8192 of a buffer object of its own
+    auto footprint = devicehandler.getMemoryFootprint();
+    ASSERT_EQ(footprint.buffers.size(), 2);
+    EXPECT_EQ(footprint.buffers[0].bufferObjectBytes, 6000 * 2);
+    EXPECT_EQ(footprint.buffers[1].bufferObjectBytes, 4 * 2);
+
+    Finn::vector<uint8_t> data(6000, 3);
+    EXPECT_TRUE(devicehandler.getInputBuffer("a")->store({data.begin(), data.end()}));
+    EXPECT_TRUE(devicehandler.run());
+    EXPECT_TRUE(devicehandler.wait());
+    EXPECT_TRUE(devicehandler.read());
+    auto map = devicehandler.getInputBuffer("a")->getMap();
+    EXPECT_TRUE(std::all_of(map.begin(), map.end(), [](uint8_t value) { return value == 3; }));
+
+    // Reallocation carves a new arena
+    devicehandler.setBatchSize(4);
+    devicehandler.allocateBuffers();
+    footprint = devicehandler.getMemoryFootprint();
+    ASSERT_EQ(footprint.buffers.size(), 2);
+    EXPECT_EQ(footprint.buffers[0].bufferObjectBytes, 12000 * 2);
+}
+
+TEST_F(DeviceHandlerSetup, AffinityPolicyTest) {
+    DeviceWrapper devWrap("somefile.xclbin", 0U, {std::make_shared<BufferDescriptor>("a", shape_t({1, 4}))}, {std::make_shared<BufferDescriptor>("b", shape_t({1, 2}))});
+    auto unplaced = DeviceHandler(devWrap, true, 2);
+    EXPECT_FALSE(unplaced.getNumaNode().has_value());
+    EXPECT_TRUE(unplaced.getLocalCpus().empty());
+
+    // The locality of the mocked card depends on the sysfs of the host, the handler has to work either way
+    devWrap.affinityPolicy = AFFINITY_POLICY::DEVICE_LOCAL;
+    const auto callerCpus = currentThreadCpus();
+    auto placed = DeviceHandler(devWrap, true, 2);
+    if (placed.getNumaNode()) {
+        EXPECT_EQ(placed.getLocalCpus(), numaNodeCpus(*placed.getNumaNode()));
+    } else {
+        EXPECT_TRUE(placed.getLocalCpus().empty());
+    }
+    placed.allocateBuffers();
+    EXPECT_TRUE(placed.buffersAllocated());
+    EXPECT_EQ(currentThreadCpus(), callerCpus);
+
+    devWrap.affinityPolicy = AFFINITY_POLICY::INVALID;
+    EXPECT_THROW(DeviceHandler(devWrap, true, 2), std::invalid_argument);
+}
+
+TEST_F(DeviceHandlerSetup, ComputeUnitPairsTest) {
+    DeviceWrapper devWrap("somefile.xclbin", 0U, {std::make_shared<BufferDescriptor>("a0", shape_t({1, 4})), std::make_shared<BufferDescriptor>("a1", shape_t({1, 4}))},
+                          {std::make_shared<BufferDescriptor>("b0", shape_t({1, 2})), std::make_shared<BufferDescriptor>("b1", shape_t({1, 2}))});
+    // Without replication only the first input and output form a pair
+    auto single = DeviceHandler(devWrap, true, 2);
+    ASSERT_EQ(single.getComputeUnitPairs().size(), 1);
+    EXPECT_EQ(single.getComputeUnitPairs()[0].inputKernelName, "a0");
+    EXPECT_EQ(single.getComputeUnitPairs()[0].outputKernelName, "b0");
+
+    devWrap.replicatedComputeUnits = true;
+    auto replicated = DeviceHandler(devWrap, true, 2);
+    ASSERT_EQ(replicated.getComputeUnitPairs().size(), 2);
+    EXPECT_EQ(replicated.getComputeUnitPairs()[1].inputKernelName, "a1");
+    EXPECT_EQ(replicated.getComputeUnitPairs()[1].outputKernelName, "b1");
+    for (auto&& pair : replicated.getComputeUnitPairs()) {
+        EXPECT_TRUE(replicated.run(pair));
+        EXPECT_TRUE(replicated.wait(pair));
+        EXPECT_TRUE(replicated.read(pair));
+    }
+
+    devWrap.odmas.pop_back();
+    EXPECT_THROW(DeviceHandler(devWrap, true, 2), std::invalid_argument);
+    devWrap.odmas.emplace_back(std::make_shared<BufferDescriptor>("b1", shape_t({1, 3})));
+    EXPECT_THROW(DeviceHandler(devWrap, true, 2), std::invalid_argument);
+}
+
+TEST_F(DeviceHandlerSetup, ExecuteTimeoutTest) {
+    DeviceWrapper devWrap(fn, 5U, {std::make_shared<BufferDescriptor>("a", shape_t({1}))}, {std::make_shared<BufferDescriptor>("b", shape_t({1}))});
+    devWrap.executeTimeoutMs = 5;
+    auto handler = DeviceHandler(devWrap, true, 1);
+    EXPECT_EQ(handler.getExecuteTimeout(), std::chrono::milliseconds(5));
+    {
+        std::lock_guard guard(xrt::device::mock_mutex);
+        xrt::ip::mock_hung_devices.insert(5);
+    }
+    EXPECT_TRUE(handler.run());
+    EXPECT_THROW(handler.wait(), KernelTimeoutError);
+    EXPECT_TRUE(handler.isStuck());
+    EXPECT_EQ(handler.getMetrics().buffers[1].timeouts, 1);
+    // No new run is started on kernels that are still busy
+    EXPECT_THROW(handler.run(), KernelTimeoutError);
+    {
+        std::lock_guard guard(xrt::device::mock_mutex);
+        xrt::ip::mock_hung_devices.clear();
+    }
+
+    // Reprogramming the card resets the kernels
+    const auto loads = xrt::device::load_xclbin_called;
+    handler.recover();
+    EXPECT_FALSE(handler.isStuck());
+    EXPECT_EQ(handler.getRecoveries(), 1);
+    EXPECT_EQ(xrt::device::load_xclbin_called, loads + 1);
+    EXPECT_TRUE(handler.run());
+    EXPECT_TRUE(handler.wait());
+    EXPECT_TRUE(handler.read());
+    EXPECT_EQ(handler.getMetrics().buffers[1].completions, 1);
+}
+
+TEST_F(DeviceHandlerSetup, MetricsTest) {
+    auto output = std::make_shared<BufferDescriptor>("b", shape_t({1, 2}));
+    output->cycleCounterOffset = xrt::ip::mock_cycle_counter_offset;
+    DeviceWrapper devWrap("somefile.xclbin", 0U, {std::make_shared<BufferDescriptor>("a", shape_t({1, 4}))}, {output});
+    auto handler = DeviceHandler(devWrap, true, 2);
+    auto runOnce = [&handler]() {
+        EXPECT_TRUE(handler.run());
+        EXPECT_TRUE(handler.wait());
+        EXPECT_TRUE(handler.read());
+    };
+    runOnce();
+    runOnce();
+    // The counters survive the reallocation of the buffers
+    handler.setMaxBatchSize(4);
+    runOnce();
+
+    auto metrics = handler.getMetrics();
+    EXPECT_EQ(metrics.deviceIndex, 0);
+    EXPECT_GT(metrics.window.count(), 0);
+    ASSERT_EQ(metrics.buffers.size(), 2);
+    EXPECT_EQ(metrics.buffers[0].kernelName, "a");
+    EXPECT_EQ(metrics.buffers[0].ioMode, IO::INPUT);
+    EXPECT_EQ(metrics.buffers[0].invocations, 3);
+    EXPECT_EQ(metrics.buffers[0].bytes, 3 * 8);
+    EXPECT_EQ(metrics.buffers[1].kernelName, "b");
+    EXPECT_EQ(metrics.buffers[1].completions, 3);
+    EXPECT_EQ(metrics.buffers[1].deviceCycles, 3 * xrt::ip::mock_cycle_counter);
+    EXPECT_EQ(metrics.bytes(IO::INPUT), metrics.buffers[0].bytes);
+    EXPECT_EQ(metrics.busyTime(), metrics.buffers[1].busyTime);
+    EXPECT_LE(metrics.utilisation(), 1.0);
+
+    handler.resetMetrics();
+    metrics = handler.getMetrics();
+    EXPECT_EQ(metrics.buffers[0].invocations, 0);
+    EXPECT_EQ(metrics.buffers[1].deviceCycles, 0);
+}
+
+TEST_F(DeviceHandlerSetup, StreamedTransferTest) {
+    auto input = std::make_shared<BufferDescriptor>("a", shape_t({1, 4}));
+    input->transferMode = TRANSFER_MODE::STREAMED;
+    input->streamChunkSamples = 16;
+    auto output = std::make_shared<BufferDescriptor>("b", shape_t({1, 2}));
+    DeviceWrapper devWrap("somefile.xclbin", 0U, {input}, {output});
+    auto handler = DeviceHandler(devWrap, true, 64);
+    handler.allocateBuffers();
+    EXPECT_EQ(handler.getInputBuffer("a")->getTransferMode(), TRANSFER_MODE::STREAMED);
+    EXPECT_TRUE(handler.run());
+    EXPECT_TRUE(handler.wait());
+    EXPECT_TRUE(handler.read());
+
+    // The batch of 64 samples is streamed in 4 chunks
+    auto metrics = handler.getMetrics();
+    ASSERT_EQ(metrics.buffers.size(), 2);
+    EXPECT_EQ(metrics.buffers[0].invocations, 4);
+    EXPECT_EQ(metrics.buffers[0].transfers, 4);
+    EXPECT_EQ(metrics.buffers[0].bytes, 64 * 4);
+    EXPECT_EQ(metrics.buffers[1].invocations, 1);
+
+    // Results can only be streamed back by the driver, see BaseDriver::inferSynchronousStreaming
+    output->transferMode = TRANSFER_MODE::STREAMED;
+    auto rejected = DeviceHandler(devWrap, true, 64);
+    EXPECT_THROW(rejected.allocateBuffers(), std::invalid_argument);
+}
+
+TEST_F(DeviceHandlerSetup, EmbeddedPlatformTest) {
+    DeviceWrapper devWrap("somefile.xclbin", 0U, {std::make_shared<BufferDescriptor>("a", shape_t({1, 3000}))}, {std::make_shared<BufferDescriptor>("b", shape_t({1, 2}))});
+    devWrap.coherentMemory = true;
+    EXPECT_THROW(DeviceHandler(devWrap, true, 2), std::invalid_argument);
+    devWrap.platform = PLATFORM::INVALID;
+    EXPECT_THROW(DeviceHandler(devWrap, true, 2), std::invalid_argument);
+
+    devWrap.platform = PLATFORM::EMBEDDED;
+    auto handler = DeviceHandler(devWrap, true, 2);
+    handler.allocateBuffers();
+    EXPECT_TRUE(handler.getInputBuffer("a")->hasSharedMemory());
+    EXPECT_TRUE(handler.getOutputBuffer("b")->hasSharedMemory());
+    // Carved from an arena without enabling it, so sized exactly
+    auto footprint = handler.getMemoryFootprint();
+    ASSERT_EQ(footprint.buffers.size(), 2);
+    EXPECT_EQ(footprint.buffers[0].bufferObjectBytes, 6000);
+
+    Finn::vector<uint8_t> data(6000, 5);
+    EXPECT_TRUE(handler.getInputBuffer("a")->store({data.begin(), data.end()}));
+    EXPECT_TRUE(handler.run());
+    EXPECT_TRUE(handler.wait());
+    EXPECT_TRUE(handler.read());
+    auto metrics = handler.getMetrics();
+    EXPECT_EQ(metrics.buffers[0].invocations, 1);
+    EXPECT_EQ(metrics.bytes(IO::INPUT), 0);
+    EXPECT_EQ(metrics.bytes(IO::OUTPUT), 0);
+}
 
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,113 @@
+/**
+ * @file DynamicBatcherTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the dynamic request batcher
+ * @version 0.1
+ * @date 2024-02-05
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/config/FinnDriverUsedDatatypes.h>
+#include <FINNCppDriver/utils/Types.h>
+
+#include <FINNCppDriver/core/BaseDriver.hpp>
+#include <FINNCppDriver/core/DynamicBatcher.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+// Provides config and shapes
+#include "UnittestConfig.h"
+using namespace FinnUnittest;
+
+using namespace std::chrono_literals;
+
+class DynamicBatcherTest : public ::testing::Test {
+     protected:
+    std::string fn = "finn-accel.xclbin";
+    std::unique_ptr<Finn::Driver<true>> driverPtr;
+    std::size_t outputSize = 0;
+
+    void SetUp() override {
+        std::fstream tmpfile(fn, std::fstream::out);
+        tmpfile << "some stuff\n";
+        tmpfile.close();
+        driverPtr = std::make_unique<Finn::Driver<true>>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 4, true);
+        outputSize = driverPtr->getOutputElementsPerSample();
+        driverPtr->getDeviceHandler(0).getOutputBuffer(outputDmaName)->testSetMap(Finn::vector<uint8_t>(outputSize * 4, 1));
+    }
+
+    void TearDown() override {
+        driverPtr.reset();
+        std::filesystem::remove(fn);
+    }
+};
+
+TEST_F(DynamicBatcherTest, CoalescingTest) {
+    auto& driver = *driverPtr;
+    Finn::vector<int8_t> sample(driver.getInputElementsPerSample(), 1);
+    std::vector<std::future<Finn::vector<uint8_t>>> futures(8);
+    {
+        // With a long deadline only full batches are dispatched
+        Finn::DynamicBatcher<Finn::Driver<true>, int8_t> batcher(driver, 10s);
+        EXPECT_EQ(batcher.getMaxBatch(), 4);
+        std::vector<std::jthread> clients;
+        for (std::size_t client = 0; client < 2; ++client) {
+            clients.emplace_back([&, client]() {
+                for (std::size_t i = client; i < futures.size(); i += 2) {
+                    futures[i] = batcher.submit(sample);
+                }
+            });
+        }
+        clients.clear();
+        for (auto&& future : futures) {
+            EXPECT_EQ(future.get(), Finn::vector<uint8_t>(outputSize, 1));
+        }
+        EXPECT_EQ(batcher.getBatchCount(), 2);
+        EXPECT_EQ(batcher.getRequestCount(), 8);
+        EXPECT_THROW(auto invalid = batcher.submit(std::span<const int8_t>(sample.data(), sample.size() - 1)), std::invalid_argument);
+    }
+    EXPECT_EQ(driver.getInputBuffer(0, inputDmaName)->getMaxBatchSize(), 4);
+}
+
+TEST_F(DynamicBatcherTest, DeadlineTest) {
+    auto& driver = *driverPtr;
+    Finn::vector<int8_t> sample(driver.getInputElementsPerSample(), 1);
+    Finn::DynamicBatcher<Finn::Driver<true>, int8_t> batcher(driver, 1ms, 8);
+    // The buffers were reallocated once for the larger batch
+    EXPECT_EQ(driver.getMaxBatchSize(), 8);
+    driver.getDeviceHandler(0).getOutputBuffer(outputDmaName)->testSetMap(Finn::vector<uint8_t>(outputSize * 8, 1));
+
+    // A single sample is dispatched once its deadline expires
+    auto future = batcher.submit(sample);
+    EXPECT_EQ(future.wait_for(10s), std::future_status::ready);
+    EXPECT_EQ(future.get(), Finn::vector<uint8_t>(outputSize, 1));
+    EXPECT_EQ(batcher.getBatchCount(), 1);
+    EXPECT_EQ(driver.getBatchSize(), 1);
+}
+
+TEST_F(DynamicBatcherTest, DrainOnDestructionTest) {
+    auto& driver = *driverPtr;
+    Finn::vector<int8_t> sample(driver.getInputElementsPerSample(), 1);
+    std::future<Finn::vector<uint8_t>> future;
+    {
+        Finn::DynamicBatcher<Finn::Driver<true>, int8_t> batcher(driver, 1h);
+        future = batcher.submit(sample);
+    }
+    EXPECT_EQ(future.wait_for(0s), std::future_status::ready);
+    EXPECT_EQ(future.get().size(), outputSize);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
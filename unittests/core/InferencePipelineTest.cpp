@@ -0,0 +1,184 @@
+/**
+ * @file InferencePipelineTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the staged inference pipeline
+ * @version 0.1
+ * @date 2024-03-21
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/config/FinnDriverUsedDatatypes.h>
+#include <FINNCppDriver/utils/Types.h>
+
+#include <FINNCppDriver/core/BaseDriver.hpp>
+#include <FINNCppDriver/core/InferencePipeline.hpp>
+#include <FINNCppDriver/utils/NpyStream.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+// Provides config and shapes
+#include "UnittestConfig.h"
+using namespace FinnUnittest;
+
+using namespace std::chrono_literals;
+
+class InferencePipelineTest : public ::testing::Test {
+     protected:
+    std::string fn = "finn-accel.xclbin";
+    std::unique_ptr<Finn::Driver<true>> driverPtr;
+    std::size_t inputSize = 0;
+    std::size_t outputSize = 0;
+
+    void SetUp() override {
+        std::fstream tmpfile(fn, std::fstream::out);
+        tmpfile << "some stuff\n";
+        tmpfile.close();
+        // Two cards, so the device stage has to schedule
+        Finn::Config config = unittestConfig;
+        Finn::DeviceWrapper second = config.deviceWrappers[0];
+        second.xrtDeviceIndex = 1;
+        config.deviceWrappers.emplace_back(second);
+        driverPtr = std::make_unique<Finn::Driver<true>>(config, 0, inputDmaName, 0, outputDmaName, 2, true);
+        inputSize = driverPtr->getInputElementsPerSample();
+        outputSize = driverPtr->getOutputElementsPerSample();
+        // Every device gets its own fake output data, so the results show which device a batch ran on
+        for (unsigned int device = 0; device < 2; ++device) {
+            driverPtr->getDeviceHandler(device).getOutputBuffer(outputDmaName)->testSetMap(Finn::vector<uint8_t>(outputSize * 2, static_cast<uint8_t>(device)));
+        }
+    }
+
+    void TearDown() override {
+        driverPtr.reset();
+        std::filesystem::remove(fn);
+    }
+};
+
+TEST_F(InferencePipelineTest, OrderedTest) {
+    Finn::PipelineOptions options;
+    options.packers = 2;
+    options.unpackers = 2;
+    Finn::InferencePipeline<Finn::Driver<true>, int8_t> pipeline(*driverPtr, options);
+    EXPECT_EQ(pipeline.getOptions().deviceWorkers, 2);
+    EXPECT_GT(pipeline.getOptions().batchBuffers, 0);
+
+    // 15 samples in batches of 2, the last batch is partial
+    constexpr std::size_t samples = 15;
+    Finn::vector<int8_t> input(samples * inputSize, 1);
+    std::vector<std::size_t> firstSamples;
+    std::vector<uint8_t> results;
+    const auto statistics = pipeline.run(Finn::iteratorSource(input.begin(), input.end()), [&](std::size_t firstSample, std::span<const uint8_t> batch) {
+        firstSamples.push_back(firstSample);
+        results.insert(results.end(), batch.begin(), batch.end());
+    });
+    EXPECT_EQ(statistics.batches, 8);
+    EXPECT_EQ(statistics.samples, samples);
+    EXPECT_GT(statistics.samplesPerSecond(), 0);
+    EXPECT_EQ(statistics.pack.threads, 2);
+    EXPECT_LE(statistics.device.utilisation(statistics.elapsed), 1.0);
+    ASSERT_EQ(firstSamples.size(), 8);
+    for (std::size_t batch = 0; batch < firstSamples.size(); ++batch) {
+        EXPECT_EQ(firstSamples[batch], batch * 2);
+    }
+    ASSERT_EQ(results.size(), samples * outputSize);
+    EXPECT_TRUE(std::all_of(results.begin(), results.end(), [](uint8_t val) { return val < 2; }));
+    // Both devices were used
+    EXPECT_NE(std::find(results.begin(), results.end(), 0), results.end());
+    EXPECT_NE(std::find(results.begin(), results.end(), 1), results.end());
+    EXPECT_EQ(driverPtr->getAccelerator().getOutstandingWork(0), 0);
+}
+
+TEST_F(InferencePipelineTest, SourcesTest) {
+    Finn::PipelineOptions options;
+    options.ordered = false;
+    Finn::InferencePipeline<Finn::Driver<true>, int8_t> pipeline(*driverPtr, options);
+    std::atomic<std::size_t> received = 0;
+    auto count = [&](std::size_t, std::span<const uint8_t> batch) { received += batch.size() / outputSize; };
+
+    std::size_t generated = 0;
+    auto statistics = pipeline.run(Finn::generatorSource<int8_t>(inputSize,
+                                                                 [&](std::span<int8_t> sample) {
+                                                                     std::fill(sample.begin(), sample.end(), static_cast<int8_t>(generated));
+                                                                     return ++generated <= 5;
+                                                                 }),
+                                   count);
+    EXPECT_EQ(statistics.samples, 5);
+    EXPECT_EQ(received, 5);
+
+    const std::filesystem::path path = "pipeline-input.npy";
+    {
+        Finn::NpyWriter writer(path, Finn::npyTypestring<int8_t>(), {6, inputSize});
+        Finn::vector<int8_t> values(6 * inputSize, 1);
+        writer.append(std::span<const int8_t>(values));
+        writer.close();
+    }
+    received = 0;
+    statistics = pipeline.run(Finn::npySource<int8_t>(path), count);
+    std::filesystem::remove(path);
+    EXPECT_EQ(statistics.batches, 3);
+    EXPECT_EQ(received, 6);
+}
+
+TEST_F(InferencePipelineTest, BackpressureTest) {
+    Finn::PipelineOptions options;
+    options.batchBuffers = 2;
+    Finn::InferencePipeline<Finn::Driver<true>, int8_t> pipeline(*driverPtr, options);
+    std::atomic<int> inFlight = 0;
+    std::atomic<int> maxInFlight = 0;
+    std::size_t produced = 0;
+    auto source = [&](std::span<int8_t> batch) -> std::size_t {
+        if (produced++ == 10) {
+            return 0;
+        }
+        const int current = ++inFlight;
+        maxInFlight = std::max(maxInFlight.load(), current);
+        std::fill(batch.begin(), batch.end(), 1);
+        return batch.size();
+    };
+    // A slow sink holds the source back instead of letting batches pile up
+    const auto statistics = pipeline.run(source, [&](std::size_t, std::span<const uint8_t>) {
+        std::this_thread::sleep_for(1ms);
+        --inFlight;
+    });
+    EXPECT_EQ(statistics.batches, 10);
+    EXPECT_LE(maxInFlight, 2);
+}
+
+TEST_F(InferencePipelineTest, ErrorTest) {
+    Finn::PipelineOptions invalid;
+    invalid.packers = 0;
+    EXPECT_THROW((Finn::InferencePipeline<Finn::Driver<true>, int8_t>(*driverPtr, invalid)), std::invalid_argument);
+
+    Finn::InferencePipeline<Finn::Driver<true>, int8_t> pipeline(*driverPtr);
+    Finn::vector<int8_t> input(10 * inputSize, 1);
+    // Only whole samples can be streamed
+    EXPECT_THROW(pipeline.run([](std::span<int8_t> batch) { return batch.size() - 1; }, [](std::size_t, std::span<const uint8_t>) {}), std::runtime_error);
+    // An error of the sink stops the run
+    std::size_t delivered = 0;
+    EXPECT_THROW(pipeline.run(Finn::iteratorSource(input.begin(), input.end()),
+                              [&](std::size_t, std::span<const uint8_t>) {
+                                  ++delivered;
+                                  throw std::logic_error("sink failed");
+                              }),
+                 std::logic_error);
+    EXPECT_EQ(delivered, 1);
+    // The pipeline can be run again afterwards
+    EXPECT_EQ(pipeline.run(Finn::iteratorSource(input.begin(), input.end()), [](std::size_t, std::span<const uint8_t>) {}).samples, 10);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,160 @@
+/**
+ * @file ModelHostTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for hosting several models on one card
+ * @version 0.1
+ * @date 2024-03-16
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/config/FinnDriverUsedDatatypes.h>
+#include <FINNCppDriver/utils/Types.h>
+
+#include <FINNCppDriver/core/BaseDriver.hpp>
+#include <FINNCppDriver/core/ModelHost.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "xrt/xrt_device.h"
+#include "xrt_simulation.h"
+
+// Provides config and shapes
+#include "UnittestConfig.h"
+using namespace FinnUnittest;
+
+using namespace std::chrono_literals;
+
+class ModelHostTest : public ::testing::Test {
+     protected:
+    const std::vector<std::string> xclbins = {"model-a.xclbin", "model-b.xclbin"};
+
+    void SetUp() override {
+        for (auto&& xclbin : xclbins) {
+            std::fstream tmpfile(xclbin, std::fstream::out);
+            tmpfile << "bitstream of " << xclbin << "\n";
+        }
+    }
+
+    void TearDown() override {
+        xrt::simulation::configure({});
+        for (auto&& xclbin : xclbins) {
+            std::filesystem::remove(xclbin);
+        }
+    }
+
+    /**
+     * @brief The unittest model on another xclbin, optionally with its compute units renamed so it can share an xclbin with the original
+     *
+     */
+    static Finn::Config model(const std::string& xclbin, const std::string& suffix = "") {
+        Finn::Config config = unittestConfig;
+        config.deviceWrappers[0].xclbin = xclbin;
+        for (auto&& descriptors : {&config.deviceWrappers[0].idmas, &config.deviceWrappers[0].odmas}) {
+            for (auto&& descriptor : *descriptors) {
+                auto copy = std::make_shared<Finn::ExtendedBufferDescriptor>(*std::dynamic_pointer_cast<Finn::ExtendedBufferDescriptor>(descriptor));
+                copy->kernelName += suffix;
+                descriptor = copy;
+            }
+        }
+        return config;
+    }
+};
+
+TEST_F(ModelHostTest, SwitchTest) {
+    Finn::ModelHost<Finn::Driver<true>> host;
+    host.addModel("a", model(xclbins[0]), 2);
+    host.addModel("b", model(xclbins[1]), 2);
+    EXPECT_THROW(host.addModel("a", model(xclbins[0])), std::invalid_argument);
+    EXPECT_FALSE(host.canCoHost("a", "b"));
+    EXPECT_TRUE(host.getResidentModels().empty());
+
+    const auto loads = xrt::device::load_xclbin_called;
+    Finn::vector<int8_t> input(300 * 2, 1);
+    EXPECT_EQ(host.infer<int8_t>("a", std::span<const int8_t>(input)).size(), 20);
+    EXPECT_TRUE(host.isResident("a"));
+    host.activate("a").setMaxBatchSize(8);
+
+    // Switching programs the card with the other xclbin
+    EXPECT_EQ(host.infer<int8_t>("b", std::span<const int8_t>(input).first(300)).size(), 10);
+    EXPECT_FALSE(host.isResident("a"));
+    EXPECT_EQ(xrt::device::load_xclbin_called, loads + 2);
+
+    // The settings of an evicted model are restored
+    auto& driver = host.activate("a");
+    EXPECT_EQ(driver.getMaxBatchSize(), 8);
+    EXPECT_EQ(driver.getBatchSize(), 2);
+    EXPECT_EQ(host.getStatistics().switches, 3);
+    EXPECT_EQ(host.getStatistics().evictions, 2);
+    EXPECT_GT(host.getStatistics().switchTime.count(), 0);
+
+    EXPECT_THROW(host.activate("c"), std::invalid_argument);
+    EXPECT_THROW(host.infer<int8_t>("a", std::span<const int8_t>(input).first(299)), std::invalid_argument);
+    host.removeModel("a");
+    EXPECT_EQ(host.getModels(), std::vector<std::string>{"b"});
+}
+
+TEST_F(ModelHostTest, CoHostTest) {
+    Finn::ModelHost<Finn::Driver<true>> host;
+    host.addModel("a", model(xclbins[0]));
+    host.addModel("c", model(xclbins[0], "_c"));
+    host.addModel("same", model(xclbins[0]));
+    EXPECT_TRUE(host.canCoHost("a", "c"));
+    // Two models cannot use the same compute units at once
+    EXPECT_FALSE(host.canCoHost("a", "same"));
+
+    host.activate("a");
+    const auto loads = xrt::device::load_xclbin_called;
+    host.activate("c");
+    EXPECT_EQ(host.getResidentModels(), (std::vector<std::string>{"a", "c"}));
+    EXPECT_EQ(xrt::device::load_xclbin_called, loads);
+
+    host.activate("same");
+    EXPECT_EQ(host.getResidentModels(), (std::vector<std::string>{"c", "same"}));
+}
+
+TEST_F(ModelHostTest, SchedulerTest) {
+    // Every inference takes long enough for the remaining requests to queue up behind the first one
+    xrt::simulation::Model simulation;
+    simulation.kernelLatency = 20ms;
+
+    for (auto maxWait : {1s, 0s}) {
+        Finn::ModelHost<Finn::Driver<true>> host;
+        host.addModel("a", model(xclbins[0]));
+        host.addModel("b", model(xclbins[1]));
+        host.activate("a");
+        xrt::simulation::configure(simulation);
+        Finn::vector<int8_t> input(300, 1);
+        std::vector<std::future<Finn::vector<uint8_t>>> results;
+        {
+            Finn::ModelScheduler<Finn::Driver<true>, int8_t> scheduler(host, std::chrono::duration_cast<std::chrono::microseconds>(maxWait));
+            for (auto&& name : {"a", "b", "a", "b", "a", "b"}) {
+                results.emplace_back(scheduler.submit(name, std::span<const int8_t>(input)));
+            }
+            EXPECT_THROW(auto unknown = scheduler.submit("c", std::span<const int8_t>(input)), std::invalid_argument);
+        }
+        xrt::simulation::configure({});
+        for (auto&& result : results) {
+            EXPECT_EQ(result.get().size(), 10);
+        }
+        // Grouped by model the card is switched once, without waiting it is switched for every request
+        if (maxWait > 0s) {
+            EXPECT_EQ(host.getStatistics().switches, 2);
+        } else {
+            EXPECT_GE(host.getStatistics().switches, 6);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,171 @@
+/**
+ * @file PythonBindingsTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the finn_driver Python module, run in an embedded interpreter against the XRT mock
+ * @version 0.1
+ * @date 2024-03-21
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/config/FinnDriverUsedDatatypes.h>
+#include <FINNCppDriver/utils/Types.h>
+#include <pybind11/embed.h>
+#include <pybind11/numpy.h>
+
+#include <FINNCppDriver/core/BaseDriver.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "xrt_simulation.h"
+
+// Provides config and shapes
+#include "UnittestConfig.h"
+using namespace FinnUnittest;
+
+using namespace std::chrono_literals;
+
+namespace py = pybind11;
+
+// Defined by PYBIND11_MODULE in FINNPythonBindings.cpp, which is compiled into this test
+extern "C" PyObject* PyInit_finn_driver();
+
+class PythonBindingsTest : public ::testing::Test {
+     protected:
+    std::string fn = "finn-accel.xclbin";
+    py::dict scope;
+
+    void SetUp() override {
+        std::fstream tmpfile(fn, std::fstream::out);
+        tmpfile << "some stuff\n";
+        tmpfile.close();
+        // Every test gets its own namespace, so no driver outlives its test
+        scope = py::module_::import("__main__").attr("__dict__").attr("copy")().cast<py::dict>();
+        scope["finn_driver"] = py::module_::import("finn_driver");
+        scope["np"] = py::module_::import("numpy");
+        scope["config"] = configFilePath;
+        scope["output_dtype"] = py::dtype::of<Finn::Driver<true>::AutoDeducedRetType>();
+    }
+
+    void TearDown() override {
+        scope.clear();
+        // The other tests rely on the mock completing instantly
+        xrt::simulation::configure({});
+        std::filesystem::remove(fn);
+    }
+
+    /**
+     * @brief Run Python code in the namespace of the test
+     *
+     * @param code
+     */
+    void run(const char* code) { py::exec(code, scope); }
+
+    /**
+     * @brief Get a variable of the namespace of the test
+     *
+     * @tparam T
+     * @param name
+     * @return T
+     */
+    template<typename T>
+    T get(const char* name) {
+        return scope[name].cast<T>();
+    }
+};
+
+TEST_F(PythonBindingsTest, ConversionTest) {
+    run(R"(
+driver = finn_driver.Driver(config, 1)
+samples = np.ones((2, driver.input_elements_per_sample), dtype=np.int8)
+outputs = driver.infer(samples)
+batch_size = driver.batch_size
+shape = outputs.shape
+expected_shape = (2,) + tuple(driver.output_shape[1:])
+dtype_matches = outputs.dtype == output_dtype
+owned = outputs.flags.owndata
+# A result that is still referenced is not overwritten by the next inference
+again = driver.infer(samples)
+shares = np.shares_memory(outputs, again)
+del again
+# Any integer dtype is packed in place, out receives the results
+out = np.empty_like(outputs)
+into_out = driver.infer(samples.astype(np.int32), out=out) is out
+single = driver.infer(samples[0]).shape
+classes = driver.infer_postprocessed(samples, finn_driver.Postprocessing.top_k(2)).shape
+)");
+    EXPECT_EQ(get<unsigned int>("batch_size"), 2U);
+    EXPECT_TRUE(scope["shape"].equal(scope["expected_shape"]));
+    EXPECT_TRUE(get<bool>("dtype_matches"));
+    EXPECT_FALSE(get<bool>("owned"));
+    EXPECT_FALSE(get<bool>("shares"));
+    EXPECT_TRUE(get<bool>("into_out"));
+    EXPECT_EQ(scope["single"].attr("__getitem__")(0).cast<int>(), 1);
+    EXPECT_TRUE(scope["classes"].equal(py::make_tuple(2, 2)));
+}
+
+TEST_F(PythonBindingsTest, ErrorTest) {
+    run(R"(
+driver = finn_driver.Driver(config, 1)
+n = driver.input_elements_per_sample
+samples = np.ones((2, n), dtype=np.int8)
+outputs = driver.infer(samples)
+errors = {}
+def expect(name, error, call):
+    try:
+        call()
+        errors[name] = False
+    except error:
+        errors[name] = True
+expect("size", ValueError, lambda: driver.infer(np.ones(n + 1, dtype=np.int8)))
+expect("contiguous", ValueError, lambda: driver.infer(np.ones((2, 2 * n), dtype=np.int8)[:, ::2]))
+expect("dtype", TypeError, lambda: driver.infer(np.ones(n, dtype=np.complex64)))
+expect("out_dtype", TypeError, lambda: driver.infer(samples, out=np.empty(outputs.size, dtype=np.complex128)))
+expect("out_readonly", TypeError, lambda: driver.infer(samples, out=np.frombuffer(bytes(outputs.nbytes), dtype=outputs.dtype)))
+expect("out_size", ValueError, lambda: driver.infer(samples, out=np.empty(1, dtype=outputs.dtype)))
+# C++ exceptions reach Python as exceptions, not as crashes
+expect("config", RuntimeError, lambda: finn_driver.Driver("missing.json", 1))
+)");
+    for (const char* name : {"size", "contiguous", "dtype", "out_dtype", "out_readonly", "out_size", "config"}) {
+        EXPECT_TRUE(scope["errors"][name].cast<bool>()) << name;
+    }
+}
+
+TEST_F(PythonBindingsTest, GilReleaseTest) {
+    run(R"(
+import threading
+import time
+driver = finn_driver.Driver(config, 1)
+samples = np.ones((1, driver.input_elements_per_sample), dtype=np.int8)
+)");
+    xrt::simulation::Model model;
+    model.kernelLatency = 300ms;
+    xrt::simulation::configure(model);
+    // The main thread only keeps counting while the inference runs if the GIL is released for it
+    run(R"(
+finished = threading.Event()
+def infer():
+    driver.infer(samples)
+    finished.set()
+worker = threading.Thread(target=infer)
+worker.start()
+ticks = 0
+while not finished.is_set():
+    ticks += 1
+    time.sleep(0.001)
+worker.join()
+)");
+    EXPECT_GT(get<int>("ticks"), 30);
+}
+
+int main(int argc, char** argv) {
+    PyImport_AppendInittab("finn_driver", &PyInit_finn_driver);
+    py::scoped_interpreter interpreter;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -230,6 +230,57 @@ TEST_F(RBTest, RBUtilFuncsTest) {
     EXPECT_EQ(rb.size(), rb.size(SIZE_SPECIFIER::BATCHSIZE) - 1);
 }
 
+TEST_F(RBTest, RBClaimCommitTest) {
+    // Fill every part in place
+    for (size_t i = 0; i < rb.size(SIZE_SPECIFIER::BATCHSIZE); i++) {
+        auto part = rb.claimWrite();
+        ASSERT_EQ(part.size(), elementsPerPart);
+        filler.fillRandom(part.begin(), part.end());
+        storedDatas.emplace_back(part.begin(), part.end());
+        rb.commitWrite();
+    }
+    EXPECT_TRUE(rb.full());
+    EXPECT_TRUE(rb.claimWrite().empty());
+
+    // Drain in place, in order
+    for (size_t i = 0; i < rb.size(SIZE_SPECIFIER::BATCHSIZE); i++) {
+        auto part = rb.claimRead();
+        ASSERT_EQ(part.size(), elementsPerPart);
+        EXPECT_TRUE(std::equal(part.begin(), part.end(), storedDatas[i].begin()));
+        rb.commitRead();
+    }
+    EXPECT_TRUE(rb.empty());
+    EXPECT_TRUE(rb.claimRead().empty());
+}
+
+TEST_F(RBTestBlocking, RBProducerConsumerTest) {
+    const std::size_t rounds = 10 * rb.size(SIZE_SPECIFIER::BATCHSIZE);
+    for (size_t i = 0; i < rounds; i++) {
+        filler.fillRandom(data.begin(), data.end());
+        storedDatas.push_back(data);
+    }
+
+    std::jthread producer([&]() {
+        for (auto&& part : storedDatas) {
+            EXPECT_TRUE(rb.store(part.begin(), part.end()));
+        }
+    });
+    for (size_t i = 0; i < rounds; i++) {
+        EXPECT_TRUE(rb.read(data.begin()));
+        EXPECT_EQ(storedDatas[i], data);
+    }
+    producer.join();
+    EXPECT_TRUE(rb.empty());
+}
+
+TEST_F(RBTestBlocking, RBStopTokenTest) {
+    std::stop_source source;
+    std::jthread consumer([&]() { EXPECT_FALSE(rb.read(data.begin(), source.get_token())); });
+    source.request_stop();
+    consumer.join();
+    EXPECT_TRUE(rb.empty());
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
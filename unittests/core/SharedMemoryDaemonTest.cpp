@@ -0,0 +1,221 @@
+/**
+ * @file SharedMemoryDaemonTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the shared memory request ring and the daemon serving it
+ * @version 0.1
+ * @date 2024-03-09
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/config/FinnDriverUsedDatatypes.h>
+#include <FINNCppDriver/utils/Types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <FINNCppDriver/core/BaseDriver.hpp>
+#include <FINNCppDriver/core/SharedMemoryDaemon.hpp>
+#include <FINNCppDriver/utils/SharedMemoryRing.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+// Provides config and shapes
+#include "UnittestConfig.h"
+using namespace FinnUnittest;
+
+using namespace std::chrono_literals;
+
+class SharedMemoryDaemonTest : public ::testing::Test {
+     protected:
+    std::string fn = "finn-accel.xclbin";
+    std::string ringName = "/finn-unittest-" + std::to_string(getpid());
+    std::unique_ptr<Finn::Driver<true>> driverPtr;
+    std::size_t inputBytes = 0;
+    std::size_t outputBytes = 0;
+
+    void SetUp() override {
+        std::fstream tmpfile(fn, std::fstream::out);
+        tmpfile << "some stuff\n";
+        tmpfile.close();
+        driverPtr = std::make_unique<Finn::Driver<true>>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 4, true);
+        inputBytes = driverPtr->getPackedInputBytes(0, inputDmaName) / 4;
+        outputBytes = driverPtr->getPackedOutputBytes(0, outputDmaName) / 4;
+    }
+
+    void TearDown() override {
+        driverPtr.reset();
+        std::filesystem::remove(fn);
+    }
+};
+
+TEST_F(SharedMemoryDaemonTest, RingTest) {
+    EXPECT_THROW(Finn::SharedMemoryRing::open(ringName), std::runtime_error);
+    EXPECT_THROW(Finn::SharedMemoryRing::create(ringName, 0, 1, 1), std::invalid_argument);
+    {
+        auto owner = Finn::SharedMemoryRing::create(ringName, 2, 3, 5);
+        EXPECT_THROW(Finn::SharedMemoryRing::create(ringName, 2, 3, 5), std::runtime_error);
+        auto client = Finn::SharedMemoryRing::open(ringName);
+        EXPECT_EQ(client.slots(), 2);
+        EXPECT_EQ(client.inputBytes(), 3);
+        EXPECT_EQ(client.outputBytes(), 5);
+        EXPECT_TRUE(client.serving());
+
+        const std::size_t slot = client.acquire();
+        EXPECT_EQ(owner.state(slot), Finn::SLOT_STATE::WRITING);
+        client.input(slot)[2] = 42;
+        client.submit(slot);
+        EXPECT_THROW(client.submit(slot), std::logic_error);
+        // Both mappings show the same memory
+        EXPECT_EQ(owner.input(slot)[2], 42);
+        EXPECT_TRUE(owner.transition(slot, Finn::SLOT_STATE::SUBMITTED, Finn::SLOT_STATE::RUNNING));
+        EXPECT_FALSE(owner.transition(slot, Finn::SLOT_STATE::SUBMITTED, Finn::SLOT_STATE::RUNNING));
+        owner.output(slot)[4] = 7;
+        owner.publish(slot, Finn::SLOT_STATE::DONE);
+        EXPECT_EQ(client.wait(slot)[4], 7);
+        client.release(slot);
+        EXPECT_EQ(owner.state(slot), Finn::SLOT_STATE::FREE);
+        EXPECT_THROW(client.input(2), std::out_of_range);
+
+        owner.stopServing();
+        const std::size_t pending = client.acquire();
+        client.submit(pending);
+        EXPECT_THROW(auto result = client.wait(pending), std::runtime_error);
+    }
+    // The owner removed the ring
+    EXPECT_THROW(Finn::SharedMemoryRing::open(ringName), std::runtime_error);
+}
+
+/**
+ * @brief Run a function in a child process that exits without any cleanup, like a crashed process
+ *
+ * @tparam F
+ * @param crash
+ * @return true The child ran the function without an exception
+ * @return false
+ */
+template<typename F>
+bool runCrashing(F&& crash) {
+    const pid_t child = fork();
+    if (child == 0) {
+        try {
+            crash();
+        } catch (...) {
+            _exit(1);
+        }
+        _exit(0);
+    }
+    int status = 0;
+    return child > 0 && waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+TEST_F(SharedMemoryDaemonTest, StaleRingTest) {
+    // A daemon that died leaves its ring behind, still marked as served
+    // The ring is leaked, so that its destructor does not remove it
+    ASSERT_TRUE(runCrashing([this]() { (void)new Finn::SharedMemoryRing(Finn::SharedMemoryRing::create(ringName, 2, 3, 5)); }));
+    EXPECT_TRUE(Finn::SharedMemoryRing::open(ringName).serving());
+    auto owner = Finn::SharedMemoryRing::create(ringName, 2, 3, 5);
+    EXPECT_TRUE(owner.serving());
+    EXPECT_EQ(owner.state(0), Finn::SLOT_STATE::FREE);
+    EXPECT_EQ(owner.state(1), Finn::SLOT_STATE::FREE);
+
+    // A client that died while writing its request holds its slot until it is reclaimed, slots of live clients are kept
+    ASSERT_TRUE(runCrashing([this]() { (void)Finn::SharedMemoryRing::open(ringName).acquire(); }));
+    const std::size_t live = owner.acquire();
+    EXPECT_EQ(owner.state(1 - live), Finn::SLOT_STATE::WRITING);
+    EXPECT_EQ(owner.reclaimAbandoned(), 1);
+    EXPECT_EQ(owner.state(1 - live), Finn::SLOT_STATE::FREE);
+    EXPECT_EQ(owner.state(live), Finn::SLOT_STATE::WRITING);
+    EXPECT_EQ(owner.reclaimAbandoned(), 0);
+}
+
+TEST_F(SharedMemoryDaemonTest, ServeTest) {
+    auto& driver = *driverPtr;
+    Finn::vector<uint8_t> outputMap(outputBytes * 4);
+    std::iota(outputMap.begin(), outputMap.end(), 0);
+    driver.getDeviceHandler(0).getOutputBuffer(outputDmaName)->testSetMap(outputMap);
+    Finn::SharedMemoryDaemon<Finn::Driver<true>> daemon(driver, ringName, 8, 10ms);
+    EXPECT_EQ(daemon.getMaxBatch(), 4);
+
+    auto client = Finn::SharedMemoryRing::open(ringName);
+    ASSERT_EQ(client.inputBytes(), inputBytes);
+    ASSERT_EQ(client.outputBytes(), outputBytes);
+    std::vector<uint8_t> sample(inputBytes);
+    std::iota(sample.begin(), sample.end(), 1);
+    std::vector<uint8_t> result(outputBytes);
+    // A single request is run as a batch of one once its deadline expired
+    client.infer(sample, result);
+    EXPECT_EQ(result, std::vector<uint8_t>(outputMap.begin(), outputMap.begin() + static_cast<std::ptrdiff_t>(outputBytes)));
+    auto inputMap = driver.getPackedInputMap(0, inputDmaName);
+    EXPECT_TRUE(std::equal(sample.begin(), sample.end(), inputMap.begin()));
+    EXPECT_EQ(daemon.getBatchCount(), 1);
+    EXPECT_EQ(daemon.getRequestCount(), 1);
+    EXPECT_THROW(client.infer(std::span<const uint8_t>(sample.data(), sample.size() - 1), result), std::length_error);
+}
+
+TEST_F(SharedMemoryDaemonTest, BatchAcrossClientsTest) {
+    auto& driver = *driverPtr;
+    driver.getDeviceHandler(0).getOutputBuffer(outputDmaName)->testSetMap(Finn::vector<uint8_t>(outputBytes * 4, 1));
+    {
+        // With a long deadline only full batches are run, so the requests of the clients have to share batches
+        Finn::SharedMemoryDaemon<Finn::Driver<true>> daemon(driver, ringName, 8, 10s);
+        std::vector<std::jthread> clients;
+        for (std::size_t i = 0; i < 4; ++i) {
+            clients.emplace_back([this]() {
+                auto client = Finn::SharedMemoryRing::open(ringName);
+                std::vector<uint8_t> sample(inputBytes, 1);
+                std::vector<uint8_t> result(outputBytes);
+                for (std::size_t request = 0; request < 2; ++request) {
+                    client.infer(sample, result);
+                    EXPECT_EQ(result, std::vector<uint8_t>(outputBytes, 1));
+                }
+            });
+        }
+        clients.clear();
+        EXPECT_EQ(daemon.getRequestCount(), 8);
+        EXPECT_EQ(daemon.getBatchCount(), 2);
+    }
+    EXPECT_EQ(driver.getBatchSize(), 4);
+}
+
+TEST_F(SharedMemoryDaemonTest, StopServesSubmittedTest) {
+    auto& driver = *driverPtr;
+    driver.getDeviceHandler(0).getOutputBuffer(outputDmaName)->testSetMap(Finn::vector<uint8_t>(outputBytes * 4, 1));
+    // With a long deadline the requests are still waiting for other clients when the daemon is stopped
+    auto daemon = std::make_unique<Finn::SharedMemoryDaemon<Finn::Driver<true>>>(driver, ringName, 8, 10s);
+    auto client = Finn::SharedMemoryRing::open(ringName);
+    std::vector<std::size_t> slots;
+    for (std::size_t i = 0; i < 2; ++i) {
+        slots.push_back(client.acquire());
+        client.submit(slots.back());
+    }
+    const auto start = std::chrono::steady_clock::now();
+    daemon.reset();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+    // Submitted requests are served before the ring is removed, the client keeps its mapping
+    for (std::size_t slot : slots) {
+        EXPECT_EQ(client.state(slot), Finn::SLOT_STATE::DONE);
+        auto result = client.wait(slot);
+        EXPECT_TRUE(std::equal(result.begin(), result.end(), std::vector<uint8_t>(outputBytes, 1).begin()));
+        client.release(slot);
+    }
+    // Requests after the shutdown fail instead of waiting forever
+    const std::size_t late = client.acquire();
+    client.submit(late);
+    EXPECT_THROW(client.wait(late), std::runtime_error);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
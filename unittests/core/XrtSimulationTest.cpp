@@ -0,0 +1,184 @@
+/**
+ * @file XrtSimulationTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the latency and bandwidth model of the XRT mock
+ * @version 0.1
+ * @date 2024-03-11
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/config/FinnDriverUsedDatatypes.h>
+#include <FINNCppDriver/utils/Types.h>
+
+#include <FINNCppDriver/core/Autotuner.hpp>
+#include <FINNCppDriver/core/BaseDriver.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "experimental/xrt_ip.h"
+#include "gtest/gtest.h"
+#include "xrt/xrt_bo.h"
+#include "xrt_simulation.h"
+
+// Provides config and shapes
+#include "UnittestConfig.h"
+using namespace FinnUnittest;
+
+using namespace std::chrono_literals;
+
+class XrtSimulationTest : public ::testing::Test {
+     protected:
+    std::string fn = "finn-accel.xclbin";
+    void SetUp() override {
+        std::fstream tmpfile(fn, std::fstream::out);
+        tmpfile << "some stuff\n";
+        tmpfile.close();
+        xrt::simulation::resetStatistics();
+    }
+
+    void TearDown() override {
+        // The other tests rely on the mock completing instantly
+        xrt::simulation::configure({});
+        std::filesystem::remove(fn);
+    }
+};
+
+TEST_F(XrtSimulationTest, ParseTest) {
+    auto model = xrt::simulation::parse("sync_latency_us=10,sync_gbps=12.5,kernel_latency_us=2,sample_ns=500,register_ns=800,wait=spin");
+    EXPECT_EQ(model.syncLatency, 10us);
+    EXPECT_DOUBLE_EQ(model.syncBandwidth, 12.5e9);
+    EXPECT_EQ(model.kernelLatency, 2us);
+    EXPECT_EQ(model.sampleTime, 500ns);
+    EXPECT_EQ(model.registerLatency, 800ns);
+    EXPECT_EQ(model.waitMode, xrt::simulation::WAIT_MODE::SPIN);
+    EXPECT_EQ(model.kernelTime(4), 4us);
+    EXPECT_EQ(model.syncTime(12500), 11us);
+    EXPECT_TRUE(model.active());
+
+    EXPECT_FALSE(xrt::simulation::parse("").active());
+    EXPECT_FALSE(xrt::simulation::parse("sample_ns=500,wait=none").active());
+    EXPECT_THROW(xrt::simulation::parse("sample_ns=fast"), std::invalid_argument);
+    EXPECT_THROW(xrt::simulation::parse("sample_ns"), std::invalid_argument);
+    EXPECT_THROW(xrt::simulation::parse("bandwidth=1"), std::invalid_argument);
+    EXPECT_THROW(xrt::simulation::parse("wait=forever"), std::invalid_argument);
+}
+
+TEST_F(XrtSimulationTest, SyncTest) {
+    xrt::simulation::Model model;
+    model.syncLatency = 2ms;
+    xrt::simulation::configure(model);
+    xrt::bo bo(xrt::device(0), 1024, 0);
+
+    auto start = std::chrono::steady_clock::now();
+    bo.sync(XCL_BO_SYNC_BO_TO_DEVICE, 1024, 0);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 2ms);
+
+    // Transfers in one direction share the link, the second one completes after the first
+    start = std::chrono::steady_clock::now();
+    auto first = bo.async(XCL_BO_SYNC_BO_FROM_DEVICE, 512, 0);
+    auto second = bo.async(XCL_BO_SYNC_BO_FROM_DEVICE, 512, 512);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 2ms);
+    EXPECT_GE(second.done - first.done, 2ms);
+    second.wait();
+    first.wait();
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 4ms);
+
+    auto stats = xrt::simulation::statistics();
+    EXPECT_EQ(stats.syncs, 3);
+    EXPECT_EQ(stats.syncedBytes, 2048);
+    EXPECT_EQ(stats.syncTime, 6ms);
+}
+
+TEST_F(XrtSimulationTest, KernelTest) {
+    xrt::simulation::Model model;
+    model.sampleTime = 1ms;
+    xrt::simulation::configure(model);
+    xrt::ip ip(xrt::device(0), xrt::uuid(), "test");
+    auto interrupt = ip.create_interrupt_notify();
+
+    ip.write_register(xrt::ip::mock_repetitions_offset, 5);
+    ip.write_register(0x0, 0x1);
+    EXPECT_EQ(ip.read_register(0x0), 0x1);
+    EXPECT_EQ(interrupt.wait(1ms), std::cv_status::timeout);
+    interrupt.wait();
+    EXPECT_EQ(ip.read_register(0x0), 0x4);
+    EXPECT_EQ(xrt::simulation::statistics().kernelRuns, 1);
+    EXPECT_EQ(xrt::simulation::statistics().kernelTime, 5ms);
+
+    // Without waiting only the simulated time is accounted
+    model.waitMode = xrt::simulation::WAIT_MODE::NONE;
+    xrt::simulation::configure(model);
+    ip.write_register(0x0, 0x1);
+    EXPECT_EQ(ip.read_register(0x0), 0x4);
+    EXPECT_EQ(xrt::simulation::statistics().kernelTime, 10ms);
+}
+
+TEST_F(XrtSimulationTest, InferenceTest) {
+    constexpr unsigned int batchSize = 4;
+    auto driver = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, batchSize, true);
+    xrt::simulation::Model model;
+    model.sampleTime = 1ms;
+    xrt::simulation::configure(model);
+    xrt::simulation::resetStatistics();
+    driver.resetDeviceMetrics();
+
+    Finn::vector<int8_t> data(300 * batchSize, 1);
+    std::vector<uint8_t> results(driver.getOutputElementsPerSample() * batchSize);
+    const auto start = std::chrono::steady_clock::now();
+    driver.inferSynchronous(data.begin(), data.end(), std::span<uint8_t>(results), 0, inputDmaName, 0, outputDmaName);
+
+    // The driver waits for the simulated run of the odma, and its metrics see the kernel busy for that long
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 4ms);
+    EXPECT_EQ(xrt::simulation::statistics().kernelRuns, 2);
+    for (auto&& buffer : driver.getDeviceMetrics()[0].buffers) {
+        if (buffer.kernelName == outputDmaName) {
+            EXPECT_GE(buffer.busyTime, 4ms);
+        }
+    }
+}
+
+TEST_F(XrtSimulationTest, AutotuneTest) {
+    auto driver = Finn::Driver<true>(unittestConfig, 0, inputDmaName, 0, outputDmaName, 1, true);
+    xrt::simulation::Model model;
+    model.kernelLatency = 1ms;
+    model.sampleTime = 50us;
+    xrt::simulation::configure(model);
+
+    Finn::AutotuneOptions options;
+    options.batchSizes = {32, 1, 8};
+    options.hostThreads = {1};
+    options.bufferSlots = {1};
+    options.latencyBound = 2500;
+    options.measureTime = 1ms;
+    options.minRuns = 2;
+    options.warmup = 0;
+    options.batchesPerRun = 2;
+    Finn::vector<int8_t> sample(300, 1);
+    auto result = Finn::autotune<int8_t>(driver, std::span<const int8_t>(sample), options);
+
+    // The fixed kernel latency favours large batches, until a batch takes longer than the bound
+    ASSERT_EQ(result.candidates.size(), 3);
+    EXPECT_TRUE(result.candidates[0].feasible);
+    EXPECT_TRUE(result.candidates[1].feasible);
+    EXPECT_FALSE(result.candidates[2].feasible);
+    EXPECT_GT(result.candidates[1].tuning.throughput, result.candidates[0].tuning.throughput);
+    ASSERT_TRUE(result.best.has_value());
+    EXPECT_EQ(result.best->batchSize, 8);
+    EXPECT_EQ(driver.getBatchSize(), 8);
+
+    options.latencyBound = 500;
+    EXPECT_FALSE(Finn::autotune<int8_t>(driver, std::span<const int8_t>(sample), options).best.has_value());
+    EXPECT_THROW(Finn::autotune<int8_t>(driver, std::span<const int8_t>(sample).first(299), options), std::invalid_argument);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,91 @@
+/**
+ * @file AffinityTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the discovery of device local CPUs and the scoped thread pinning
+ * @version 0.1
+ * @date 2024-03-08
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/Affinity.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+    /**
+     * @brief Fake sysfs tree with a card attached to node 1 and a card without locality information
+     *
+     */
+    class FakeSysfs : public ::testing::Test {
+         protected:
+        std::filesystem::path root = std::filesystem::temp_directory_path() / "finn_affinity_sysfs";
+
+        void write(const std::filesystem::path& file, const std::string& content) {
+            std::filesystem::create_directories(file.parent_path());
+            std::ofstream(file) << content;
+        }
+
+        void SetUp() override {
+            write(root / "bus/pci/devices/0000:3b:00.1/numa_node", "1\n");
+            write(root / "bus/pci/devices/0000:af:00.1/numa_node", "-1\n");
+            write(root / "devices/system/node/node0/cpulist", "0-3\n");
+            write(root / "devices/system/node/node1/cpulist", "4-5,12\n");
+        }
+
+        void TearDown() override { std::filesystem::remove_all(root); }
+    };
+}  // namespace
+
+TEST(AffinityTest, ParseCpuListTest) {
+    EXPECT_EQ(Finn::parseCpuList("0-3,8,10-11\n"), (std::vector<unsigned int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(Finn::parseCpuList("5,1-2,2"), (std::vector<unsigned int>{1, 2, 5}));
+    EXPECT_EQ(Finn::parseCpuList("x,3-1,7"), (std::vector<unsigned int>{7}));
+    EXPECT_TRUE(Finn::parseCpuList("").empty());
+}
+
+TEST_F(FakeSysfs, PciLocalityTest) {
+    EXPECT_EQ(Finn::pciNumaNode("0000:3b:00.1", root), 1U);
+    // XRT may report the address without PCI domain
+    EXPECT_EQ(Finn::pciNumaNode("3b:00.1", root), 1U);
+    EXPECT_FALSE(Finn::pciNumaNode("0000:af:00.1", root).has_value());
+    EXPECT_FALSE(Finn::pciNumaNode("0000:00:00.0", root).has_value());
+
+    EXPECT_EQ(Finn::pciLocalCpus("3b:00.1", root), (std::vector<unsigned int>{4, 5, 12}));
+    EXPECT_TRUE(Finn::pciLocalCpus("0000:af:00.1", root).empty());
+    EXPECT_TRUE(Finn::numaNodeCpus(7, root).empty());
+}
+
+TEST(AffinityTest, ScopedThreadAffinityTest) {
+    const auto original = Finn::currentThreadCpus();
+    {
+        Finn::ScopedThreadAffinity none({});
+        EXPECT_FALSE(none.active());
+        EXPECT_EQ(Finn::currentThreadCpus(), original);
+    }
+#ifdef __linux__
+    ASSERT_FALSE(original.empty());
+    {
+        Finn::ScopedThreadAffinity pinned({original.front()});
+        EXPECT_TRUE(pinned.active());
+        EXPECT_EQ(Finn::currentThreadCpus(), std::vector<unsigned int>{original.front()});
+        // Threads started in the scope inherit the restriction
+        std::vector<unsigned int> inherited;
+        std::thread([&inherited]() { inherited = Finn::currentThreadCpus(); }).join();
+        EXPECT_EQ(inherited, std::vector<unsigned int>{original.front()});
+    }
+    EXPECT_EQ(Finn::currentThreadCpus(), original);
+#endif
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
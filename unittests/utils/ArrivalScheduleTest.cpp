@@ -0,0 +1,73 @@
+/**
+ * @file ArrivalScheduleTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the arrival schedules of the load mode
+ * @version 0.1
+ * @date 2024-02-28
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/ArrivalSchedule.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "gtest/gtest.h"
+
+using namespace std::chrono_literals;
+
+TEST(ArrivalScheduleTest, PoissonTest) {
+    constexpr double rate = 1000;
+    constexpr std::size_t count = 100000;
+    const auto schedule = Finn::poissonArrivals(rate, count, 42);
+    ASSERT_EQ(schedule.size(), count);
+    EXPECT_TRUE(std::is_sorted(schedule.begin(), schedule.end()));
+    const double seconds = std::chrono::duration<double>(schedule.back()).count();
+    EXPECT_NEAR(static_cast<double>(count) / seconds, rate, rate * 0.02);
+    EXPECT_EQ(schedule, Finn::poissonArrivals(rate, count, 42));
+    EXPECT_THROW(Finn::poissonArrivals(0, count, 42), std::invalid_argument);
+}
+
+TEST(ArrivalScheduleTest, UniformTest) {
+    const auto schedule = Finn::uniformArrivals(100, 5);
+    ASSERT_EQ(schedule.size(), 5);
+    EXPECT_EQ(schedule.front(), 0ns);
+    for (std::size_t i = 1; i < schedule.size(); ++i) {
+        EXPECT_EQ(schedule[i] - schedule[i - 1], 10ms);
+    }
+    EXPECT_THROW(Finn::uniformArrivals(-1, 5), std::invalid_argument);
+}
+
+TEST(ArrivalScheduleTest, ReplayTest) {
+    const auto path = std::filesystem::temp_directory_path() / "finnArrivalScheduleTest.txt";
+    {
+        std::ofstream file(path);
+        file << "# recorded arrivals\n10.5\n\n10.0\n11.0\n";
+    }
+    const auto schedule = Finn::replayArrivals(path);
+    ASSERT_EQ(schedule.size(), 3);
+    EXPECT_EQ(schedule[0], 0ns);
+    EXPECT_EQ(schedule[1], 500ms);
+    EXPECT_EQ(schedule[2], 1s);
+
+    const auto faster = Finn::replayArrivals(path, 2.0);
+    EXPECT_EQ(faster[2], 500ms);
+
+    {
+        std::ofstream file(path, std::ios::app);
+        file << "later\n";
+    }
+    EXPECT_THROW(Finn::replayArrivals(path), std::runtime_error);
+    std::filesystem::remove(path);
+    EXPECT_THROW(Finn::replayArrivals(path), std::runtime_error);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,83 @@
+/**
+ * @file BoundedQueueTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the bounded queue connecting pipeline stages
+ * @version 0.1
+ * @date 2024-03-05
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/BoundedQueue.hpp>
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(BoundedQueueTest, OrderTest) {
+    Finn::BoundedQueue<int> queue(3);
+    EXPECT_EQ(queue.getCapacity(), 3);
+    EXPECT_TRUE(queue.push(1));
+    EXPECT_TRUE(queue.push(2));
+    EXPECT_EQ(queue.size(), 2);
+    EXPECT_EQ(queue.pop(), 1);
+    EXPECT_EQ(queue.pop(), 2);
+    queue.push(3);
+    queue.close();
+    // Queued elements are still delivered after closing, new ones are rejected
+    EXPECT_FALSE(queue.push(4));
+    EXPECT_EQ(queue.pop(), 3);
+    EXPECT_FALSE(queue.pop().has_value());
+    EXPECT_THROW(Finn::BoundedQueue<int>(0), std::invalid_argument);
+}
+
+TEST(BoundedQueueTest, CapacityTest) {
+    Finn::BoundedQueue<std::size_t> queue(2);
+    std::atomic<std::size_t> pushed = 0;
+    constexpr std::size_t elements = 1000;
+    std::jthread producer([&]() {
+        for (std::size_t i = 0; i < elements; ++i) {
+            queue.push(i);
+            ++pushed;
+        }
+        queue.close();
+    });
+    // The producer blocks as soon as the queue is full
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(pushed, 2);
+
+    std::vector<std::size_t> popped;
+    for (auto element = queue.pop(); element; element = queue.pop()) {
+        EXPECT_LE(queue.size(), 2);
+        popped.push_back(*element);
+    }
+    std::vector<std::size_t> expected(elements);
+    std::iota(expected.begin(), expected.end(), 0);
+    EXPECT_EQ(popped, expected);
+}
+
+TEST(BoundedQueueTest, CancelTest) {
+    Finn::BoundedQueue<int> queue(1);
+    std::stop_source stop;
+    std::jthread consumer([&]() { EXPECT_FALSE(queue.pop(stop.get_token()).has_value()); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    stop.request_stop();
+    consumer.join();
+
+    queue.push(1);
+    std::jthread producer([&]() { EXPECT_FALSE(queue.push(2, stop.get_token())); });
+    producer.join();
+    EXPECT_EQ(queue.size(), 1);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
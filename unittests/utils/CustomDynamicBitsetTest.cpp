@@ -57,6 +57,59 @@ TEST(CustomDynamicBitsetTest, MergeTest) {
     EXPECT_EQ(testString, set2.to_string());
 }
 
+TEST(CustomDynamicBitsetTest, AppendBitsTest) {
+    DynamicBitset set(72);
+    set.appendBits(0b101, 3);
+    set.appendBits(0xFF, 2);  // Only the lowest 2 bits are used
+    EXPECT_EQ(set.getCursor(), 5);
+    set.appendBits(0, 56);
+    set.appendBits(0b1001, 4);  // Crosses the word boundary
+    set.appendBits(~uint64_t{0}, 0);
+    EXPECT_EQ(set.getCursor(), 65);
+    std::vector<uint8_t> out;
+    set.outputBytes(std::back_inserter(out));
+    const std::vector<uint8_t> expected = {0b00011101, 0, 0, 0, 0, 0, 0, 0b00100000, 0b00000001};
+    EXPECT_EQ(out, expected);
+}
+
+TEST(CustomDynamicBitsetTest, AllNoneTest) {
+    for (std::size_t size : {8UL, 64UL, 100UL, 1000UL}) {
+        DynamicBitset set(size);
+        EXPECT_TRUE(set.none());
+        EXPECT_FALSE(set.all());
+        for (std::size_t i = 0; i + 1 < set.size(); ++i) {
+            set.setSingleBit(i);
+        }
+        EXPECT_FALSE(set.none());
+        EXPECT_FALSE(set.all());
+        set.setSingleBit(set.size() - 1);
+        EXPECT_TRUE(set.all()) << "Size " << size;
+    }
+}
+
+TEST(CustomDynamicBitsetTest, ByteLayoutTest) {
+    DynamicBitset set(100);
+    EXPECT_EQ(set.numBytes(), 13);
+    EXPECT_EQ(set.numWords(), 2);
+    set.setByte(uint64_t{0x0123456789ABCDEF}, 36);
+    auto bytes = set.getStorageVec();
+    ASSERT_EQ(bytes.size(), 13);
+    const std::vector<uint8_t> expected = {0, 0, 0, 0, 0xF0, 0xDE, 0xBC, 0x9A, 0x78, 0x56, 0x34, 0x12, 0x00};
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), bytes.begin()));
+}
+
+TEST(CustomDynamicBitsetTest, LargeMergeTest) {
+    DynamicBitset even(1000);
+    DynamicBitset odd(1000);
+    for (std::size_t i = 0; i < 1000; i += 2) {
+        even.setSingleBit(i);
+        odd.setSingleBit(i + 1);
+    }
+    EXPECT_FALSE(even.all());
+    even |= odd;
+    EXPECT_TRUE(even.all());
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
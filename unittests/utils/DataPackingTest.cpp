@@ -14,13 +14,17 @@
 
 #include <FINNCppDriver/utils/DataPacking.hpp>
 #include <FINNCppDriver/utils/DynamicMdSpan.hpp>
+#include <FINNCppDriver/utils/StaticShapes.hpp>
 #include <FINNCppDriver/utils/join.hpp>
 #include <algorithm>
 #include <array>
 #include <bitset>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <random>
 
 #include "gtest/gtest.h"
 
@@ -436,6 +440,48 @@ TEST(DataPacking, FloatingPointInputTest) {
     EXPECT_TRUE(mat23.size() == ret.size() && std::equal(ret.begin(), ret.end(), mat23.begin()));
 }
 
+TEST(DataPacking, FloatingPointQuantizationTest) {
+    // The input is only read
+    const Finn::vector<float> inp = {0.25F, -0.5F, 1.4F, 1.6F, 2.5F, -7.9F, 100.0F, -100.0F, std::nanf("")};
+    const Finn::vector<float> copy = inp;
+    auto ret = Finn::pack<Finn::DatatypeInt<4>>(inp.begin(), inp.end());
+    EXPECT_EQ(inp.size(), copy.size());
+    EXPECT_TRUE(std::equal(inp.begin(), inp.begin() + 8, copy.begin()));
+
+    // Rounded to nearest (ties to even) and clamped to [-8, 7]
+    auto unpacked = Finn::unpack<Finn::DatatypeInt<4>>(ret, 4);
+    const Finn::vector<int8_t> expected = {0, 0, 1, 2, 2, -8, 7, -8, -8};
+    EXPECT_EQ(unpacked, expected);
+
+    // Fixed point values are scaled, rounded and clamped before packing
+    const Finn::vector<double> fixedInp = {0.25, -0.3, 1.0, 7.99, -9.0};
+    ret = Finn::pack<Finn::DatatypeFixed<6, 3>>(fixedInp.begin(), fixedInp.end());
+    auto fixedUnpacked = Finn::unpack<Finn::DatatypeFixed<6, 3>>(ret, 2);
+    const Finn::vector<float> fixedExpected = {0.25F, -0.25F, 1.0F, 3.875F, -4.0F};
+    EXPECT_EQ(fixedUnpacked, fixedExpected);
+}
+
+TEST(DataPacking, FloatingPointSaturation64BitTest) {
+    // 2^63 and 2^64 are the first doubles above the largest 64 bit values and have to saturate to them
+    const Finn::vector<double> inp = {0x1p63, 0x1p64, 1e30, -0x1p63, -1e30, 42.0};
+    auto toWords = [](const auto& packed) {
+        Finn::vector<uint64_t> words(packed.size() / sizeof(uint64_t));
+        std::memcpy(words.data(), packed.data(), packed.size());
+        return words;
+    };
+
+    const auto signedWords = toWords(Finn::pack<Finn::DatatypeInt<64>>(inp.begin(), inp.end()));
+    constexpr auto maxInt = static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+    constexpr auto minInt = static_cast<uint64_t>(std::numeric_limits<int64_t>::min());
+    const Finn::vector<uint64_t> signedExpected = {maxInt, maxInt, maxInt, minInt, minInt, 42};
+    EXPECT_EQ(signedWords, signedExpected);
+
+    const auto unsignedWords = toWords(Finn::pack<Finn::DatatypeUInt<64>>(inp.begin(), inp.end()));
+    constexpr auto maxUint = std::numeric_limits<uint64_t>::max();
+    const Finn::vector<uint64_t> unsignedExpected = {uint64_t{1} << 63, maxUint, maxUint, 0, 0, 42};
+    EXPECT_EQ(unsignedWords, unsignedExpected);
+}
+
 TEST(DataPacking, IntegralToBitsetTest) {
     Finn::vector<uint8_t> inp = {0, 1, 2, 3, 4, 5, 6, 7};
     auto ret = Finn::toBitset<Finn::DatatypeUInt<3>, true, false>(inp);
@@ -504,6 +550,21 @@ TEST(DataPacking, DynamicBitsetParallel) {
     EXPECT_TRUE(bit.all());
 }
 
+TEST(DataPacking, MergeBitsetsParallel) {
+    // Large enough to be merged by several threads
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<unsigned int> dist(0, 127);
+    Finn::vector<uint8_t> inp(1UL << 17);
+    std::generate(inp.begin(), inp.end(), [&]() { return static_cast<uint8_t>(dist(gen)); });
+    auto bitsets = Finn::toBitset<Finn::DatatypeUInt<7>, true, false>(inp);
+    auto merged = Finn::mergeBitsets<Finn::DatatypeUInt<7>>(bitsets);
+    auto bytes = Finn::bitsetToByteVector(merged);
+
+    Finn::vector<uint8_t> expected(bytes.size());
+    Finn::detail::packing::packInto<Finn::DatatypeUInt<7>>(inp.begin(), inp.end(), expected.data());
+    EXPECT_EQ(bytes, expected);
+}
+
 TEST(DataPacking, UnpackingWrongSize) {
     Finn::vector<uint8_t> inp(20, 0);
     EXPECT_THROW((Finn::unpack<Finn::DatatypeUInt<7>, false, uint64_t>(inp)), std::runtime_error);
@@ -633,6 +694,21 @@ TEST(DataPacking, PackingMultiDimensionalInputs) {
     EXPECT_EQ(packed1, expectedResult1);
 }
 
+TEST(DataPacking, PackingMultiDimensionalInputsIntoSpan) {
+    Finn::vector<int> inp{
+        -9, -3, 2, 8, -5, -4, 4, -5, 5, -12,
+    };
+    Finn::DynamicMdSpan shape(inp.begin(), inp.end(), {1, 5, 2});
+    Finn::vector<uint8_t> output(12, 0xFF);
+    auto written = Finn::packMultiDimensionalInputs<Finn::DatatypeInt<5>>(inp.begin(), inp.end(), shape, 2, std::span<uint8_t>(output.data(), output.size()));
+    Finn::vector<uint8_t> expectedResult{183, 3, 2, 1, 155, 3, 100, 3, 133, 2, 0xFF, 0xFF};
+    EXPECT_EQ(written, 10);
+    EXPECT_EQ(output, expectedResult);
+
+    Finn::vector<uint8_t> tooSmall(9);
+    EXPECT_THROW(Finn::packMultiDimensionalInputs<Finn::DatatypeInt<5>>(inp.begin(), inp.end(), shape, 2, std::span<uint8_t>(tooSmall.data(), tooSmall.size())), std::length_error);
+}
+
 TEST(DataPacking, UnpackingMultiDimensionalInputs) {
     Finn::vector<uint8_t> inp1{12, 12, 12, 12, 12, 12, 12, 12, 12, 0};
     Finn::DynamicMdSpan shape(inp1.begin(), inp1.end(), {1, 10, 1});
@@ -653,6 +729,247 @@ TEST(DataPacking, UnpackingMultiDimensionalInputs) {
     EXPECT_EQ(unpackedMerged, expectedResult2);
 }
 
+TEST(DataPacking, UnpackingMultiDimensionalOutputsIntoSpan) {
+    std::vector<uint8_t> inp{
+        33, 0, 33, 0, 33, 0, 33, 0, 33, 0,
+    };
+    Finn::vector<int8_t> out(10, 0);
+    auto written = Finn::unpackMultiDimensionalOutputs<Finn::DatatypeInt<5>>(std::span<const uint8_t>(inp), {1, 5, 2}, {1, 5, 2}, std::span<int8_t>(out.data(), out.size()));
+
+    Finn::vector<int8_t> expectedResult{1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+    EXPECT_EQ(written, 10);
+    EXPECT_EQ(out, expectedResult);
+
+    Finn::vector<int8_t> tooSmall(9);
+    EXPECT_THROW(Finn::unpackMultiDimensionalOutputs<Finn::DatatypeInt<5>>(std::span<const uint8_t>(inp), {1, 5, 2}, {1, 5, 2}, std::span<int8_t>(tooSmall.data(), tooSmall.size())), std::length_error);
+}
+
+TEST(DataPacking, TransferPlanTest) {
+    auto plan = Finn::TransferPlan::forBatchSize({1, 5, 2}, {1, 5, 2}, 2, Finn::DatatypeInt<5>().bitwidth());
+    EXPECT_EQ(plan.innerDims, 10);
+    EXPECT_EQ(plan.elementsPerInnerDim, 2);
+    EXPECT_EQ(plan.bytesPerInnerDim, 2);
+    EXPECT_EQ(plan.paddingBits, 6);
+    EXPECT_EQ(plan.elements(), 20);
+    EXPECT_EQ(plan.bytes(), 20);
+    EXPECT_THROW(Finn::TransferPlan({1, 5, 4}, {1, 5, 2}, 5), std::invalid_argument);
+    EXPECT_THROW(Finn::TransferPlan({1, 4, 2}, {1, 5, 2}, 5), std::invalid_argument);
+
+    Finn::vector<int> inp{
+        -9, -3, 2, 8, -5, -4, 4, -5, 5, -12, -9, -3, 2, 8, -5, -4, 4, -5, 5, -12,
+    };
+    Finn::DynamicMdSpan shape(inp.begin(), inp.end(), {2, 5, 2});
+    auto expected = Finn::packMultiDimensionalInputs<Finn::DatatypeInt<5>>(inp.begin(), inp.end(), shape, 2);
+    Finn::vector<uint8_t> packed(plan.bytes(), 0xFF);
+    EXPECT_EQ(Finn::packMultiDimensionalInputs<Finn::DatatypeInt<5>>(inp.begin(), inp.end(), plan, std::span<uint8_t>(packed.data(), packed.size())), plan.bytes());
+    EXPECT_EQ(packed, expected);
+    EXPECT_THROW(Finn::packMultiDimensionalInputs<Finn::DatatypeInt<4>>(inp.begin(), inp.end(), plan, std::span<uint8_t>(packed.data(), packed.size())), std::invalid_argument);
+    EXPECT_THROW(Finn::packMultiDimensionalInputs<Finn::DatatypeInt<5>>(inp.begin(), inp.end() - 1, plan, std::span<uint8_t>(packed.data(), packed.size())), std::length_error);
+
+    Finn::vector<int8_t> unpacked(plan.elements());
+    EXPECT_EQ(Finn::unpackMultiDimensionalOutputs<Finn::DatatypeInt<5>>(std::span<const uint8_t>(packed.data(), packed.size()), plan, std::span<int8_t>(unpacked.data(), unpacked.size())), plan.elements());
+    EXPECT_TRUE(std::equal(unpacked.begin(), unpacked.end(), inp.begin()));
+}
+
+TEST(DataPacking, StaticShapesTest) {
+    using Shape = Finn::StaticBufferShape<Finn::staticShape(1, 10), Finn::staticShape(1, 5, 2), Finn::staticShape(1, 5, 2)>;
+    static_assert(Shape::innerDimsPerSample == 5 && Shape::elementsPerSample == 10 && Shape::bytesPerSample == 10);
+    static_assert(Shape::fits<Finn::DatatypeInt<5>>() && !Shape::fits<Finn::DatatypeInt<9>>());
+    auto plan = Finn::TransferPlan::forBatchSize({1, 5, 2}, {1, 5, 2}, 2, Finn::DatatypeInt<5>().bitwidth());
+    EXPECT_TRUE(Shape::matches(plan));
+    EXPECT_FALSE(Shape::matches(Finn::TransferPlan({1, 5, 1}, {1, 5, 2}, 5)));
+    EXPECT_TRUE(Shape::matches(Finn::ExtendedBufferDescriptor("idma0", {4, 5, 2}, {4, 10}, {4, 5, 2})));
+    EXPECT_FALSE(Shape::matches(Finn::ExtendedBufferDescriptor("idma0", {1, 5, 2}, {1, 10}, {1, 10, 1})));
+
+    Finn::vector<int> inp{
+        -9, -3, 2, 8, -5, -4, 4, -5, 5, -12, -9, -3, 2, 8, -5, -4, 4, -5, 5, -12,
+    };
+    Finn::vector<uint8_t> expected(plan.bytes());
+    Finn::packMultiDimensionalInputs<Finn::DatatypeInt<5>>(inp.begin(), inp.end(), plan, std::span<uint8_t>(expected.data(), expected.size()));
+    Finn::vector<uint8_t> packed(plan.bytes(), 0xFF);
+    EXPECT_EQ((Finn::packStaticInputs<Finn::DatatypeInt<5>, Shape>(inp.begin(), inp.end(), plan.innerDims, std::span<uint8_t>(packed.data(), packed.size()))), plan.bytes());
+    EXPECT_EQ(packed, expected);
+    EXPECT_THROW((Finn::packStaticInputs<Finn::DatatypeInt<5>, Shape>(inp.begin(), inp.end() - 1, plan.innerDims, std::span<uint8_t>(packed.data(), packed.size()))), std::length_error);
+
+    Finn::ThreadPool pool(2);
+    Finn::vector<int8_t> unpacked(plan.elements());
+    EXPECT_EQ((Finn::unpackStaticOutputs<Finn::DatatypeInt<5>, Shape>(std::span<const uint8_t>(packed.data(), packed.size()), plan.innerDims, std::span<int8_t>(unpacked.data(), unpacked.size()), &pool)), plan.elements());
+    EXPECT_TRUE(std::equal(unpacked.begin(), unpacked.end(), inp.begin()));
+    EXPECT_THROW((Finn::unpackStaticOutputs<Finn::DatatypeInt<5>, Shape>(std::span<const uint8_t>(packed.data(), packed.size() - 1), plan.innerDims, std::span<int8_t>(unpacked.data(), unpacked.size()))), std::length_error);
+}
+
+TEST(DataPacking, PermutedInputTest) {
+    EXPECT_THROW(Finn::InputLayout({3, 4}, {0, 0}), std::invalid_argument);
+    const auto layout = Finn::InputLayout::channelsFirst({1, 2, 3, 4});
+    EXPECT_EQ(layout.sourceShape, (shape_t{4, 2, 3}));
+    EXPECT_EQ(layout.normalShape(), (shape_t{2, 3, 4}));
+    EXPECT_EQ(layout.normalStrides(), (std::vector<std::size_t>{3, 1, 6}));
+    EXPECT_FALSE(layout.isIdentity());
+
+    Finn::ThreadPool pool(3);
+    // Channels folded into rows of two, and a large input that is packed in several tiles
+    for (const unsigned int height : {2U, 96U}) {
+        const shape_t normal{2, height, 5, 4};
+        auto plan = Finn::TransferPlan::forBatchSize({1, height, 5, 2, 2}, {1, height, 5, 2, 1}, 2, Finn::DatatypeInt<4>().bitwidth());
+        std::mt19937 gen(7);
+        std::uniform_int_distribution<int> dist(-8, 7);
+        Finn::vector<int8_t> channelsLast(plan.elements());
+        std::generate(channelsLast.begin(), channelsLast.end(), [&]() { return static_cast<int8_t>(dist(gen)); });
+        Finn::vector<int8_t> channelsFirst(channelsLast.size());
+        const std::size_t pixels = height * 5;
+        for (std::size_t sample = 0; sample < 2; ++sample) {
+            for (std::size_t pixel = 0; pixel < pixels; ++pixel) {
+                for (std::size_t channel = 0; channel < 4; ++channel) {
+                    channelsFirst[(sample * 4 + channel) * pixels + pixel] = channelsLast[(sample * pixels + pixel) * 4 + channel];
+                }
+            }
+        }
+        Finn::vector<uint8_t> expected(plan.bytes());
+        Finn::packMultiDimensionalInputs<Finn::DatatypeInt<4>>(channelsLast.begin(), channelsLast.end(), plan, std::span<uint8_t>(expected.data(), expected.size()));
+
+        plan.sourceLayout = std::make_shared<const Finn::InputLayout>(Finn::InputLayout::channelsFirst(normal));
+        for (Finn::ThreadPool* threads : {static_cast<Finn::ThreadPool*>(nullptr), &pool}) {
+            Finn::vector<uint8_t> packed(plan.bytes(), 0xFF);
+            EXPECT_EQ(Finn::packMultiDimensionalInputs<Finn::DatatypeInt<4>>(channelsFirst.begin(), channelsFirst.end(), plan, std::span<uint8_t>(packed.data(), packed.size()), threads), plan.bytes());
+            EXPECT_EQ(packed, expected) << "Height " << height;
+        }
+    }
+
+    auto plan = Finn::TransferPlan::forBatchSize({1, 2, 3, 1, 4}, {1, 2, 3, 1, 2}, 1, Finn::DatatypeInt<4>().bitwidth());
+    Finn::vector<int8_t> input(plan.elements());
+    Finn::vector<uint8_t> packed(plan.bytes());
+    // The channels cannot be folded into rows of three
+    const Finn::TransferPlan rowsOfThree({1, 8, 3}, {1, 8, 2}, 4);
+    Finn::vector<uint8_t> packedRows(rowsOfThree.bytes());
+    EXPECT_THROW(Finn::packPermutedInputs<Finn::DatatypeInt<4>>(input.begin(), input.end(), rowsOfThree, layout, std::span<uint8_t>(packedRows.data(), packedRows.size())), std::invalid_argument);
+    EXPECT_THROW(Finn::packPermutedInputs<Finn::DatatypeInt<4>>(input.begin(), input.end() - 1, plan, layout, std::span<uint8_t>(packed.data(), packed.size())), std::length_error);
+}
+
+template<typename U, typename T>
+void checkPackingKernel() {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(U().min(), U().max());
+    for (std::size_t length : {1UL, 7UL, 31UL, 32UL, 33UL, 64UL, 100UL, 259UL}) {
+        Finn::vector<T> inp(length);
+        std::generate(inp.begin(), inp.end(), [&]() { return static_cast<T>(dist(gen)); });
+        Finn::vector<T> copy(inp);
+        auto bitsets = Finn::toBitset<U, true, false>(copy.begin(), copy.end());
+        auto merged = Finn::mergeBitsets<U>(bitsets);
+        auto expected = Finn::bitsetToByteVector(merged);
+
+        Finn::vector<uint8_t> packed(expected.size() + 1, 0xAB);
+        EXPECT_EQ(Finn::detail::packing::packInto<U>(inp.begin(), inp.end(), packed.data()), expected.size());
+        EXPECT_TRUE(std::equal(expected.begin(), expected.end(), packed.begin())) << "Bitwidth " << U().bitwidth() << ", length " << length;
+        EXPECT_EQ(packed.back(), 0xAB);
+    }
+}
+
+TEST(DataPacking, PackingKernelsMatchBitsetPacking) {
+    checkPackingKernel<Finn::DatatypeUInt<1>, uint8_t>();
+    checkPackingKernel<Finn::DatatypeInt<2>, int8_t>();
+    checkPackingKernel<Finn::DatatypeUInt<2>, uint8_t>();
+    checkPackingKernel<Finn::DatatypeInt<3>, int8_t>();
+    checkPackingKernel<Finn::DatatypeInt<4>, int8_t>();
+    checkPackingKernel<Finn::DatatypeUInt<4>, int>();
+    checkPackingKernel<Finn::DatatypeInt<5>, int>();
+    checkPackingKernel<Finn::DatatypeUInt<7>, uint16_t>();
+    checkPackingKernel<Finn::DatatypeInt<12>, int16_t>();
+    checkPackingKernel<Finn::DatatypeUInt<16>, uint32_t>();
+    checkPackingKernel<Finn::DatatypeInt<27>, int>();
+}
+
+template<typename U, typename T>
+void checkUnpackingKernel() {
+    std::mt19937_64 gen(7);
+    std::uniform_int_distribution<int64_t> dist(static_cast<int64_t>(U().min()), static_cast<int64_t>(U().max()));
+    for (std::size_t length : {1UL, 8UL, 31UL, 32UL, 33UL, 64UL, 100UL, 259UL}) {
+        Finn::vector<T> inp(length);
+        std::generate(inp.begin(), inp.end(), [&]() { return static_cast<T>(dist(gen)); });
+        auto packed = Finn::pack<U>(inp);
+        const std::size_t padding = packed.size() * 8 - length * U().bitwidth();
+
+        Finn::vector<T> unpacked(length);
+        const std::size_t written = Finn::unpackInto<U, T>(std::span<const uint8_t>(packed.data(), packed.size()), std::span<T>(unpacked.data(), unpacked.size()), padding);
+        EXPECT_EQ(written, length);
+        EXPECT_EQ(unpacked, inp) << "Bitwidth " << U().bitwidth() << ", length " << length;
+    }
+}
+
+TEST(DataPacking, UnpackingKernelsRoundTrip) {
+    checkUnpackingKernel<Finn::DatatypeUInt<1>, uint8_t>();
+    checkUnpackingKernel<Finn::DatatypeInt<1>, int8_t>();
+    checkUnpackingKernel<Finn::DatatypeInt<2>, int8_t>();
+    checkUnpackingKernel<Finn::DatatypeUInt<2>, uint8_t>();
+    checkUnpackingKernel<Finn::DatatypeInt<4>, int8_t>();
+    checkUnpackingKernel<Finn::DatatypeUInt<4>, uint16_t>();
+    checkUnpackingKernel<Finn::DatatypeInt<3>, int8_t>();
+    checkUnpackingKernel<Finn::DatatypeInt<8>, int8_t>();
+    checkUnpackingKernel<Finn::DatatypeUInt<12>, uint16_t>();
+    checkUnpackingKernel<Finn::DatatypeInt<16>, int16_t>();
+    checkUnpackingKernel<Finn::DatatypeInt<24>, int32_t>();
+    checkUnpackingKernel<Finn::DatatypeInt<27>, int32_t>();
+    checkUnpackingKernel<Finn::DatatypeInt<60>, int64_t>();
+}
+
+template<typename U, typename T, typename Generator>
+void checkBinaryKernels(Generator generate) {
+    std::mt19937 gen(11);
+    for (std::size_t length : {1UL, 31UL, 63UL, 64UL, 65UL, 200UL}) {
+        Finn::vector<T> inp(length);
+        std::generate(inp.begin(), inp.end(), [&]() { return generate(gen); });
+        Finn::vector<uint8_t> expected((length + 7) / 8, 0);
+        for (std::size_t i = 0; i < length; ++i) {
+            expected[i / 8] |= static_cast<uint8_t>(Finn::detail::packing::toLane<U>(inp[i]) << (i % 8));
+        }
+
+        Finn::vector<uint8_t> packed(expected.size() + 1, 0xAB);
+        EXPECT_EQ(Finn::detail::packing::packInto<U>(inp.begin(), inp.end(), packed.data()), expected.size());
+        EXPECT_TRUE(std::equal(expected.begin(), expected.end(), packed.begin())) << "Length " << length;
+        EXPECT_EQ(packed.back(), 0xAB);
+
+        Finn::vector<T> unpacked(length);
+        Finn::detail::packing::unpackTo<U, T>(packed.data(), expected.size(), length, unpacked.data());
+        for (std::size_t i = 0; i < length; ++i) {
+            const uint64_t bit = (expected[i / 8] >> (i % 8)) & 1;
+            EXPECT_EQ(unpacked[i], (Finn::detail::packing::fromLane<U, T>(bit))) << "Length " << length << ", index " << i;
+        }
+    }
+}
+
+TEST(DataPacking, BinaryKernelsMatchScalarLanes) {
+    auto sign = [](auto& gen) { return (gen() & 1) != 0 ? 1 : -1; };
+    auto bit = [](auto& gen) { return static_cast<int>(gen() & 1); };
+    auto real = [](auto& gen) {
+        static constexpr std::array<float, 6> special{0.5F, -0.5F, 0.0F, -0.0F, 1.0F, std::numeric_limits<float>::quiet_NaN()};
+        return (gen() % 4 == 0) ? special[gen() % special.size()] : std::uniform_real_distribution<float>(-2.0F, 2.0F)(gen);
+    };
+    checkBinaryKernels<Finn::DatatypeBipolar, int8_t>([&](auto& gen) { return static_cast<int8_t>(sign(gen)); });
+    checkBinaryKernels<Finn::DatatypeBipolar, int32_t>([&](auto& gen) { return sign(gen); });
+    checkBinaryKernels<Finn::DatatypeBipolar, float>(real);
+    checkBinaryKernels<Finn::DatatypeBinary, uint8_t>([&](auto& gen) { return static_cast<uint8_t>(bit(gen)); });
+    checkBinaryKernels<Finn::DatatypeUInt<1>, uint32_t>([&](auto& gen) { return static_cast<uint32_t>(bit(gen)); });
+    checkBinaryKernels<Finn::DatatypeUInt<1>, float>(real);
+    checkBinaryKernels<Finn::DatatypeInt<1>, int8_t>([&](auto& gen) { return static_cast<int8_t>(-bit(gen)); });
+    checkBinaryKernels<Finn::DatatypeInt<1>, int32_t>([&](auto& gen) { return -bit(gen); });
+    checkBinaryKernels<Finn::DatatypeInt<1>, float>(real);
+    // Unvectorised inputs take the scalar kernels
+    checkBinaryKernels<Finn::DatatypeBipolar, int16_t>([&](auto& gen) { return static_cast<int16_t>(sign(gen)); });
+}
+
+TEST(DataPacking, BipolarRoundTrip) {
+    Finn::vector<int8_t> inp(100);
+    for (std::size_t i = 0; i < inp.size(); ++i) {
+        inp[i] = (i % 3 == 0) ? 1 : -1;
+    }
+    auto packed = Finn::pack<Finn::DatatypeBipolar>(inp);
+    Finn::vector<int8_t> unpacked(inp.size());
+    Finn::detail::packing::unpackTo<Finn::DatatypeBipolar, int8_t>(packed.data(), packed.size(), unpacked.size(), unpacked.data());
+    EXPECT_EQ(unpacked, inp);
+    Finn::vector<float> unpackedFloat(inp.size());
+    Finn::detail::packing::unpackTo<Finn::DatatypeBipolar, float>(packed.data(), packed.size(), unpackedFloat.size(), unpackedFloat.data());
+    EXPECT_TRUE(std::equal(inp.begin(), inp.end(), unpackedFloat.begin(), [](int8_t a, float b) { return static_cast<float>(a) == b; }));
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
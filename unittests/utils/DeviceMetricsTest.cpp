@@ -0,0 +1,101 @@
+/**
+ * @file DeviceMetricsTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the device metrics and their periodic export
+ * @version 0.1
+ * @date 2024-03-10
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/Types.h>
+
+#include <FINNCppDriver/utils/DeviceMetrics.hpp>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace std::chrono_literals;
+
+TEST(DeviceMetricsTest, SnapshotTest) {
+    Finn::BufferMetrics metrics;
+    metrics.countInvocation();
+    metrics.countInvocation();
+    metrics.countTransfer(1000, 1ms);
+    metrics.countTransfer(3000, 1ms);
+    metrics.countCompletion(250ms);
+    metrics.countCycles(42);
+
+    const auto snapshot = metrics.snapshot("odma0", IO::OUTPUT);
+    EXPECT_EQ(snapshot.kernelName, "odma0");
+    EXPECT_EQ(snapshot.invocations, 2);
+    EXPECT_EQ(snapshot.completions, 1);
+    EXPECT_EQ(snapshot.transfers, 2);
+    EXPECT_EQ(snapshot.bytes, 4000);
+    EXPECT_EQ(snapshot.deviceCycles, 42);
+    EXPECT_DOUBLE_EQ(snapshot.bandwidth(), 2e6);
+    EXPECT_DOUBLE_EQ(snapshot.utilisation(1s), 0.25);
+    EXPECT_DOUBLE_EQ(snapshot.utilisation(100ms), 1.0);
+    EXPECT_DOUBLE_EQ(snapshot.utilisation(0s), 0.0);
+
+    metrics.reset();
+    const auto cleared = metrics.snapshot("odma0", IO::OUTPUT);
+    EXPECT_EQ(cleared.invocations, 0);
+    EXPECT_EQ(cleared.bytes, 0);
+    EXPECT_DOUBLE_EQ(cleared.bandwidth(), 0.0);
+}
+
+TEST(DeviceMetricsTest, DeviceSnapshotTest) {
+    Finn::BufferMetrics input;
+    Finn::BufferMetrics output;
+    input.countTransfer(100, 1ms);
+    output.countTransfer(10, 1ms);
+    input.countCompletion(100ms);
+    output.countCompletion(400ms);
+    Finn::DeviceMetricsSnapshot device{3, 1s, {input.snapshot("idma0", IO::INPUT), output.snapshot("odma0", IO::OUTPUT)}};
+    EXPECT_EQ(device.bytes(IO::INPUT), 100);
+    EXPECT_EQ(device.bytes(IO::OUTPUT), 10);
+    EXPECT_EQ(device.busyTime(), 400ms);
+    EXPECT_DOUBLE_EQ(device.utilisation(), 0.4);
+
+    const std::string table = Finn::formatDeviceMetrics({device});
+    EXPECT_NE(table.find("device 3: utilisation 40.00%"), std::string::npos);
+    EXPECT_NE(table.find("idma0"), std::string::npos);
+    EXPECT_NE(table.find("odma0"), std::string::npos);
+}
+
+TEST(DeviceMetricsTest, ExporterTest) {
+    std::atomic<int> pulled = 0;
+    std::atomic<int> exported = 0;
+    {
+        Finn::MetricsExporter exporter(
+            1ms,
+            [&pulled]() {
+                ++pulled;
+                return std::vector<Finn::DeviceMetricsSnapshot>(2);
+            },
+            [&exported](const std::vector<Finn::DeviceMetricsSnapshot>& devices) { exported += static_cast<int>(devices.size()); });
+        const auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (exported < 4 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+    EXPECT_GE(pulled.load(), 2);
+    EXPECT_EQ(exported.load(), 2 * pulled.load());
+
+    // Stopping does not wait for the interval
+    const auto start = std::chrono::steady_clock::now();
+    { Finn::MetricsExporter idle(1h, []() { return std::vector<Finn::DeviceMetricsSnapshot>{}; }); }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 10s);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -37,6 +37,10 @@ TEST(UtilsTest, FinnUtilsTest) {
     EXPECT_EQ(FinnUtils::getActualBufferSize(4096), 4096);
     EXPECT_EQ(FinnUtils::getActualBufferSize(5000), 8192);
     EXPECT_EQ(FinnUtils::getActualBufferSize(8200), 16384);
+    EXPECT_EQ(FinnUtils::getAlignedBufferSize(0), 4096);
+    EXPECT_EQ(FinnUtils::getAlignedBufferSize(4096), 4096);
+    EXPECT_EQ(FinnUtils::getAlignedBufferSize(5000), 8192);
+    EXPECT_EQ(FinnUtils::getAlignedBufferSize(8200), 12288);
 }
 
 int main(int argc, char** argv) {
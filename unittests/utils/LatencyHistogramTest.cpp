@@ -0,0 +1,92 @@
+/**
+ * @file LatencyHistogramTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the latency histograms and the stage latency recorder
+ * @version 0.1
+ * @date 2024-02-23
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/Instrumentation.hpp>
+#include <FINNCppDriver/utils/LatencyHistogram.hpp>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+
+TEST(LatencyHistogramTest, BucketTest) {
+    using Finn::LatencyHistogram;
+    // Small values are exact, larger ones stay within the relative error of the sub-buckets
+    for (std::uint64_t value : {0UL, 1UL, 31UL, 32UL, 33UL, 1000UL, 123456UL, 987654321UL}) {
+        const auto index = LatencyHistogram::bucketIndex(value);
+        ASSERT_LT(index, LatencyHistogram::bucketCount);
+        const auto bound = LatencyHistogram::bucketUpperBound(index);
+        EXPECT_GE(bound, value);
+        EXPECT_LE(static_cast<double>(bound - value), static_cast<double>(value) / LatencyHistogram::subBuckets);
+    }
+    EXPECT_EQ(LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketIndex(31)), 31);
+    // Buckets are monotonic and the largest values are clamped into the last one
+    EXPECT_LT(LatencyHistogram::bucketIndex(1000), LatencyHistogram::bucketIndex(1100));
+    EXPECT_EQ(LatencyHistogram::bucketIndex(UINT64_MAX), LatencyHistogram::bucketCount - 1);
+}
+
+TEST(LatencyHistogramTest, PercentileTest) {
+    Finn::LatencyHistogram histogram;
+    EXPECT_EQ(histogram.summary().count, 0);
+    for (std::uint64_t i = 1; i <= 1000; ++i) {
+        histogram.record(i * 1000);
+    }
+    const auto summary = histogram.summary();
+    EXPECT_EQ(summary.count, 1000);
+    EXPECT_DOUBLE_EQ(summary.mean, 500500.0);
+    EXPECT_EQ(summary.max, 1000000);
+    EXPECT_NEAR(static_cast<double>(summary.p50), 500000.0, 500000.0 / Finn::LatencyHistogram::subBuckets);
+    EXPECT_NEAR(static_cast<double>(summary.p99), 990000.0, 990000.0 / Finn::LatencyHistogram::subBuckets);
+    EXPECT_LE(summary.p999, summary.max);
+
+    histogram.reset();
+    EXPECT_EQ(histogram.size(), 0);
+}
+
+TEST(LatencyHistogramTest, RecorderTest) {
+    auto& recorder = Finn::LatencyRecorder::global();
+    recorder.reset();
+    // Every thread records into its own histograms, the summary merges them
+    std::vector<std::jthread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&recorder]() {
+            for (int i = 0; i < 100; ++i) {
+                recorder.record(Finn::STAGE::WAIT, std::chrono::microseconds(10));
+            }
+        });
+    }
+    threads.clear();
+    const auto summary = recorder.summary(Finn::STAGE::WAIT);
+    EXPECT_EQ(summary.count, 400);
+    EXPECT_EQ(summary.max, 10000);
+    EXPECT_EQ(recorder.summary(Finn::STAGE::PACK).count, 0);
+    EXPECT_NE(recorder.report().find("wait"), std::string::npos);
+    EXPECT_EQ(recorder.report().find("pack"), std::string::npos);
+
+    {
+        const Finn::ScopedStageTimer timer(Finn::STAGE::PACK);
+    }
+    EXPECT_EQ(recorder.summary(Finn::STAGE::PACK).count, 1);
+
+    recorder.startPeriodicDump(std::chrono::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    recorder.stopPeriodicDump();
+    recorder.reset();
+    EXPECT_EQ(recorder.summary(Finn::STAGE::WAIT).count, 0);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,84 @@
+/**
+ * @file LoggerTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the rate limited and compile time filtered logging
+ * @version 0.1
+ * @date 2024-03-06
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/Logger.h>
+
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(LoggerTest, RateLimiterTest) {
+    LogRateLimiter limiter(std::chrono::hours(1));
+    EXPECT_TRUE(limiter.allow());
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_FALSE(limiter.allow());
+    }
+    EXPECT_EQ(limiter.takeSuppressed(), 5);
+    EXPECT_EQ(limiter.takeSuppressed(), 0);
+
+    LogRateLimiter unlimited(std::chrono::nanoseconds(0));
+    EXPECT_TRUE(unlimited.allow());
+    EXPECT_TRUE(unlimited.allow());
+    EXPECT_EQ(unlimited.takeSuppressed(), 0);
+}
+
+TEST(LoggerTest, RateLimiterConcurrentTest) {
+    LogRateLimiter limiter(std::chrono::hours(1));
+    std::atomic<int> allowed = 0;
+    {
+        std::vector<std::jthread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&]() {
+                for (int i = 0; i < 1000; ++i) {
+                    allowed += limiter.allow() ? 1 : 0;
+                }
+            });
+        }
+    }
+    EXPECT_EQ(allowed, 1);
+    EXPECT_EQ(limiter.takeSuppressed(), 3999);
+}
+
+TEST(LoggerTest, SuppressedPrefixTest) {
+    std::stringstream stream;
+    stream << LogSuppressed{0};
+    EXPECT_TRUE(stream.str().empty());
+    stream << LogSuppressed{3};
+    EXPECT_EQ(stream.str(), "(3 similar messages suppressed) ");
+}
+
+TEST(LoggerTest, ThrottledMacroTest) {
+    auto logger = Logger::getLogger();
+    int evaluated = 0;
+    auto argument = [&evaluated]() { return ++evaluated; };
+    for (int i = 0; i < 10; ++i) {
+        FINN_LOG_THROTTLED(logger, loglevel::info, std::chrono::hours(1)) << "Throttled message " << argument();
+    }
+    // The stream expression is only evaluated for records that are written
+    EXPECT_EQ(evaluated, finnLogEnabled(loglevel::info) ? 1 : 0);
+    Logger::flush();
+}
+
+TEST(LoggerTest, SeverityFilterTest) {
+    static_assert(finnLogEnabled(loglevel::fatal));
+    EXPECT_EQ(finnLogEnabled(loglevel::trace), FINN_LOG_MIN_SEVERITY <= 0);
+    EXPECT_EQ(finnLogEnabled(loglevel::info), FINN_LOG_MIN_SEVERITY <= 2);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
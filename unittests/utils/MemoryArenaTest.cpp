@@ -0,0 +1,103 @@
+/**
+ * @file MemoryArenaTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the memory arena
+ * @version 0.1
+ * @date 2024-02-19
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/Types.h>
+
+#include <FINNCppDriver/utils/DataPacking.hpp>
+#include <FINNCppDriver/utils/FinnDatatypes.hpp>
+#include <FINNCppDriver/utils/MemoryArena.hpp>
+#include <FINNCppDriver/utils/TransferPlan.h>
+#include <cstdint>
+#include <numeric>
+#include <span>
+
+#include "gtest/gtest.h"
+
+
+TEST(MemoryArenaTest, AllocateAndRewindTest) {
+    Finn::MemoryArena arena(4096);
+    EXPECT_EQ(arena.getStats().blockAllocations, 1);
+
+    void* first = arena.allocate(10);
+    void* second = arena.allocate(100, 256);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(first) % Finn::MemoryArena::defaultAlignment, 0);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(second) % 256, 0);
+    EXPECT_GE(arena.getStats().bytesInUse, 110);
+    {
+        Finn::MemoryArena::Scope scope(arena);
+        void* inner = arena.allocate(10);
+        EXPECT_NE(inner, first);
+    }
+    // The scope only releases what was allocated inside of it
+    void* third = arena.allocate(10);
+    EXPECT_GT(third, second);
+
+    arena.reset();
+    EXPECT_EQ(arena.getStats().bytesInUse, 0);
+    EXPECT_EQ(arena.allocate(10), first);
+}
+
+TEST(MemoryArenaTest, SteadyStateTest) {
+    Finn::MemoryArena arena(4096);
+    auto request = [&]() {
+        Finn::MemoryArena::Scope scope(arena);
+        Finn::arena_vector<uint16_t> data(10000, 7, Finn::ArenaAllocator<uint16_t>(arena));
+        Finn::arena_vector<uint8_t> other(5000, Finn::ArenaAllocator<uint8_t>(arena));
+        EXPECT_EQ(std::accumulate(data.begin(), data.end(), 0U), 70000U);
+    };
+    // The first request outgrows the first block, afterwards the blocks are merged into one
+    request();
+    const std::size_t blocks = arena.getStats().blockAllocations;
+    EXPECT_GT(blocks, 1);
+    EXPECT_GE(arena.getStats().capacity, arena.getStats().highWater);
+    for (int i = 0; i < 5; ++i) {
+        request();
+    }
+    EXPECT_EQ(arena.getStats().blockAllocations, blocks);
+    EXPECT_EQ(arena.getStats().resets, 6);
+}
+
+TEST(MemoryArenaTest, HugePagesTest) {
+    // Falls back to transparent hugepages if the system has no hugepages reserved
+    Finn::MemoryArena arena(1, true);
+    EXPECT_EQ(arena.getStats().capacity % Finn::MemoryArena::hugePageSize, 0);
+    auto* data = static_cast<uint8_t*>(arena.allocate(Finn::MemoryArena::hugePageSize));
+    data[0] = 1;
+    data[Finn::MemoryArena::hugePageSize - 1] = 2;
+    EXPECT_EQ(arena.getStats().blockAllocations, 1);
+}
+
+TEST(MemoryArenaTest, ZeroAllocationPackingTest) {
+    using F = Finn::DatatypeInt<2>;
+    const auto plan = Finn::TransferPlan::forBatchSize({1, 10, 30}, {1, 10, 8}, 4, F().bitwidth());
+    Finn::vector<int8_t> input(plan.elements(), 1);
+    Finn::vector<uint8_t> packed(plan.bytes());
+    Finn::packMultiDimensionalInputs<F>(input.begin(), input.end(), plan, std::span<uint8_t>(packed.data(), packed.size()));
+
+    // Packing into preallocated memory and gathering temporaries in the arena does not touch the heap
+    auto& arena = Finn::MemoryArena::threadLocal();
+    const std::size_t before = AlignedAllocationCounter::allocations.load();
+    for (int request = 0; request < 10; ++request) {
+        Finn::MemoryArena::Scope scope(arena);
+        Finn::arena_vector<int8_t> gathered(input.begin(), input.end(), Finn::ArenaAllocator<int8_t>(arena));
+        Finn::packMultiDimensionalInputs<F>(gathered.begin(), gathered.end(), plan, std::span<uint8_t>(packed.data(), packed.size()));
+    }
+    EXPECT_EQ(AlignedAllocationCounter::allocations.load(), before);
+
+    Finn::vector<uint8_t> counted(10);
+    EXPECT_EQ(AlignedAllocationCounter::allocations.load(), before + 1);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,105 @@
+/**
+ * @file MemoryBudgetTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the sizing of host buffers to a memory budget
+ * @version 0.1
+ * @date 2024-03-14
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/Types.h>
+
+#include <FINNCppDriver/utils/MemoryBudget.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+    std::vector<Finn::BufferDemand> syncDemands() { return {{"idma0", IO::INPUT, true, 80, 0}, {"odma0", IO::OUTPUT, true, 10, 0}}; }
+
+    std::vector<Finn::BufferDemand> asyncDemands(std::size_t archiveCapacity) { return {{"idma0", IO::INPUT, false, 80, 0}, {"odma0", IO::OUTPUT, false, 10, archiveCapacity}}; }
+}  // namespace
+
+TEST(MemoryBudgetTest, DemandTest) {
+    // Buffer objects are rounded up to a power of two of at least 4096 bytes
+    EXPECT_EQ(syncDemands()[0].bytes(2, 1), 4096);
+    EXPECT_EQ(syncDemands()[0].bytes(100, 3), 8192 * 3);
+    EXPECT_EQ(asyncDemands(0)[0].bytes(4, 3), 4096 + 320);
+    // Sub-buffers of a device memory arena are only rounded up to the alignment
+    auto arenaDemand = syncDemands()[0];
+    arenaDemand.fromArena = true;
+    EXPECT_EQ(arenaDemand.bytes(2, 1), 4096);
+    EXPECT_EQ(syncDemands()[0].bytes(300, 2), 32768 * 2);
+    EXPECT_EQ(arenaDemand.bytes(300, 2), 24576 * 2);
+    EXPECT_FALSE(syncDemands()[1].archives());
+    EXPECT_TRUE(asyncDemands(0)[1].archives());
+}
+
+TEST(MemoryBudgetTest, UnboundedTest) {
+    auto plan = Finn::planMemory(syncDemands(), 2, 3, 0, 0, MEMORY_POLICY::FAIL);
+    EXPECT_EQ(plan.bufferSlots, 3);
+    EXPECT_EQ(plan.bytes, 8192 * 3);
+    EXPECT_FALSE(plan.degraded);
+}
+
+TEST(MemoryBudgetTest, FailTest) {
+    EXPECT_THROW(Finn::planMemory(syncDemands(), 2, 2, 0, 10000, MEMORY_POLICY::FAIL), std::runtime_error);
+    auto plan = Finn::planMemory(syncDemands(), 2, 1, 0, 10000, MEMORY_POLICY::FAIL);
+    EXPECT_EQ(plan.bufferSlots, 1);
+    EXPECT_EQ(plan.bytes, 8192);
+    EXPECT_FALSE(plan.degraded);
+    // Staging memory counts as well
+    EXPECT_THROW(Finn::planMemory(syncDemands(), 2, 1, 2000, 10000, MEMORY_POLICY::FAIL), std::runtime_error);
+}
+
+TEST(MemoryBudgetTest, DegradeTest) {
+    auto plan = Finn::planMemory(syncDemands(), 2, 4, 0, 20000, MEMORY_POLICY::DEGRADE);
+    EXPECT_EQ(plan.bufferSlots, 2);
+    EXPECT_EQ(plan.bytes, 8192 * 2);
+    EXPECT_TRUE(plan.degraded);
+    // The batch size is never given up
+    EXPECT_THROW(Finn::planMemory(syncDemands(), 2, 4, 0, 5000, MEMORY_POLICY::DEGRADE), std::runtime_error);
+}
+
+TEST(MemoryBudgetTest, ArchiveTest) {
+    // 4416 bytes for the input, 4136 for the output and 320 for staging leave 1128 bytes for the archive
+    auto plan = Finn::planMemory(asyncDemands(0), 4, 1, 320, 10000, MEMORY_POLICY::FAIL);
+    EXPECT_EQ(plan.archiveCapacity, 1128);
+    EXPECT_EQ(plan.bytes, 10000);
+    EXPECT_FALSE(plan.degraded);
+
+    plan = Finn::planMemory(asyncDemands(500), 4, 1, 320, 10000, MEMORY_POLICY::FAIL);
+    EXPECT_EQ(plan.archiveCapacity, 500);
+
+    EXPECT_THROW(Finn::planMemory(asyncDemands(2000), 4, 1, 320, 10000, MEMORY_POLICY::FAIL), std::runtime_error);
+    plan = Finn::planMemory(asyncDemands(2000), 4, 1, 320, 10000, MEMORY_POLICY::DEGRADE);
+    EXPECT_EQ(plan.archiveCapacity, 1128);
+    EXPECT_TRUE(plan.degraded);
+
+    // Not even one sample fits into the archive
+    EXPECT_THROW(Finn::planMemory(asyncDemands(0), 4, 1, 320, 8875, MEMORY_POLICY::DEGRADE), std::runtime_error);
+}
+
+TEST(MemoryBudgetTest, FootprintTest) {
+    Finn::MemoryFootprint footprint;
+    footprint.budget = 100000;
+    footprint.stagingBytes = 100;
+    footprint.devices.push_back({0, {{"idma0", IO::INPUT, 4096, 320, 0, 0}, {"odma0", IO::OUTPUT, 4096, 40, 1000, 2000}}});
+    EXPECT_EQ(footprint.devices[0].total(), 4096 + 320 + 4096 + 40 + 1000);
+    EXPECT_EQ(footprint.total(), footprint.devices[0].total() + 100);
+
+    const std::string table = Finn::formatMemoryFootprint(footprint);
+    EXPECT_NE(table.find("budget"), std::string::npos);
+    EXPECT_NE(table.find("idma0"), std::string::npos);
+    EXPECT_NE(table.find("odma0"), std::string::npos);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,98 @@
+/**
+ * @file NpyStreamTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the chunked npy reader and writer
+ * @version 0.1
+ * @date 2024-03-01
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/NpyStream.hpp>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+class NpyStreamTest : public ::testing::Test {
+     protected:
+    std::filesystem::path fn = std::filesystem::temp_directory_path() / "finnNpyStreamTest.npy";
+    void TearDown() override { std::filesystem::remove(fn); }
+};
+
+TEST_F(NpyStreamTest, TypestringTest) {
+    EXPECT_EQ(Finn::npyTypestring<float>(), "<f4");
+    EXPECT_EQ(Finn::npyTypestring<double>(), "<f8");
+    EXPECT_EQ(Finn::npyTypestring<int16_t>(), "<i2");
+    EXPECT_EQ(Finn::npyTypestring<uint8_t>(), "|u1");
+    EXPECT_EQ(Finn::npyTypestring<bool>(), "|b1");
+}
+
+TEST_F(NpyStreamTest, RoundTripTest) {
+    std::vector<int16_t> data(3 * 5);
+    std::iota(data.begin(), data.end(), -7);
+    {
+        Finn::NpyWriter writer(fn, Finn::npyTypestring<int16_t>(), {3, 5});
+        writer.append(std::span<const int16_t>(data).first(5));
+        writer.append(std::span<const int16_t>(data).subspan(5));
+        EXPECT_THROW(writer.append(std::span<const int16_t>(data).first(1)), std::length_error);
+        EXPECT_THROW(writer.append(std::span<const float>()), std::runtime_error);
+        writer.close();
+    }
+    // The data has to start at a 64 byte boundary
+    EXPECT_EQ((std::filesystem::file_size(fn) - data.size() * sizeof(int16_t)) % 64, 0);
+
+    Finn::NpyReader reader(fn);
+    EXPECT_EQ(reader.getTypestring(), "<i2");
+    EXPECT_EQ(reader.getShape(), shape_t({3, 5}));
+    EXPECT_EQ(reader.elements(), 15);
+    std::vector<int16_t> chunk(4);
+    std::vector<int16_t> read;
+    for (std::size_t n = reader.read(std::span<int16_t>(chunk)); n > 0; n = reader.read(std::span<int16_t>(chunk))) {
+        read.insert(read.end(), chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(n));
+    }
+    EXPECT_EQ(read, data);
+    EXPECT_EQ(reader.remaining(), 0);
+    std::vector<float> wrongType(1);
+    EXPECT_THROW(reader.read(std::span<float>(wrongType)), std::runtime_error);
+}
+
+TEST_F(NpyStreamTest, NumpyHeaderTest) {
+    // Version 1 header as written by numpy.save for np.arange(4, dtype=np.uint8)
+    std::string header = "{'descr': '|u1', 'fortran_order': False, 'shape': (4,), }";
+    header.append(128 - 10 - header.size() - 1, ' ');
+    header.push_back('\n');
+    {
+        std::ofstream file(fn, std::ios::binary);
+        file << "\x93NUMPY" << '\x01' << '\x00' << static_cast<char>(header.size()) << '\x00' << header;
+        file.write("\x00\x01\x02\x03", 4);
+    }
+    Finn::NpyReader reader(fn);
+    EXPECT_EQ(reader.getShape(), shape_t({4}));
+    std::vector<uint8_t> values(8);
+    EXPECT_EQ(reader.read(std::span<uint8_t>(values)), 4);
+    EXPECT_EQ(values[3], 3);
+
+    {
+        std::ofstream file(fn, std::ios::binary);
+        file << "no npy file at all";
+    }
+    EXPECT_THROW(Finn::NpyReader{fn}, std::runtime_error);
+}
+
+TEST_F(NpyStreamTest, IncompleteWriteTest) {
+    Finn::NpyWriter writer(fn, Finn::npyTypestring<float>(), {2});
+    writer.append(std::span<const float>(std::vector<float>{1.0F}));
+    EXPECT_THROW(writer.close(), std::length_error);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,89 @@
+/**
+ * @file PackedDatasetTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the packed dataset reader and writer
+ * @version 0.1
+ * @date 2024-03-04
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/ConfigurationStructs.h>
+
+#include <FINNCppDriver/utils/FinnDatatypes.hpp>
+#include <FINNCppDriver/utils/PackedDataset.hpp>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+class PackedDatasetTest : public ::testing::Test {
+     protected:
+    std::filesystem::path fn = std::filesystem::temp_directory_path() / "finnPackedDatasetTest.bin";
+    Finn::ExtendedBufferDescriptor descriptor{"idma0", {1, 10, 8}, {1, 300}, {1, 10, 30}};
+    Finn::PackedDatasetHeader header{"input", Finn::describeDatatype<Finn::DatatypeInt<2>>(), descriptor.foldedShape, descriptor.packedShape, 3};
+    void TearDown() override { std::filesystem::remove(fn); }
+};
+
+TEST_F(PackedDatasetTest, RoundTripTest) {
+    EXPECT_EQ(header.bytesPerSample(), 80);
+    std::vector<uint8_t> data(3 * header.bytesPerSample());
+    std::iota(data.begin(), data.end(), 0);
+    {
+        Finn::PackedDatasetWriter writer(fn, header);
+        writer.append(std::span<const uint8_t>(data).first(header.bytesPerSample()));
+        writer.append(std::span<const uint8_t>(data).subspan(header.bytesPerSample()));
+        EXPECT_THROW(writer.append(std::span<const uint8_t>(data).first(header.bytesPerSample())), std::length_error);
+        writer.close();
+    }
+    EXPECT_TRUE(Finn::isPackedDataset(fn));
+    // The data has to start at a 64 byte boundary
+    EXPECT_EQ((std::filesystem::file_size(fn) - data.size()) % 64, 0);
+
+    Finn::PackedDatasetReader reader(fn);
+    EXPECT_EQ(reader.getHeader().samples, 3);
+    EXPECT_EQ(reader.getHeader().packedShape, descriptor.packedShape);
+    // Only whole samples are read, so two samples fit into a buffer of 2.5 samples
+    std::vector<uint8_t> chunk(header.bytesPerSample() * 5 / 2);
+    std::vector<uint8_t> read;
+    for (std::size_t n = reader.read(std::span<uint8_t>(chunk)); n > 0; n = reader.read(std::span<uint8_t>(chunk))) {
+        EXPECT_LE(n, 2);
+        read.insert(read.end(), chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(n * header.bytesPerSample()));
+    }
+    EXPECT_EQ(read, data);
+    EXPECT_EQ(reader.remaining(), 0);
+}
+
+TEST_F(PackedDatasetTest, ValidateTest) {
+    EXPECT_NO_THROW(header.validate("input", Finn::describeDatatype<Finn::DatatypeInt<2>>(), descriptor));
+    EXPECT_THROW(header.validate("output", Finn::describeDatatype<Finn::DatatypeInt<2>>(), descriptor), std::runtime_error);
+    EXPECT_THROW(header.validate("input", Finn::describeDatatype<Finn::DatatypeUInt<2>>(), descriptor), std::runtime_error);
+    Finn::ExtendedBufferDescriptor other{"idma0", {1, 5, 8}, {1, 150}, {1, 5, 30}};
+    EXPECT_THROW(header.validate("input", Finn::describeDatatype<Finn::DatatypeInt<2>>(), other), std::runtime_error);
+}
+
+TEST_F(PackedDatasetTest, InvalidFileTest) {
+    {
+        std::ofstream file(fn);
+        file << "no packed dataset at all";
+    }
+    EXPECT_FALSE(Finn::isPackedDataset(fn));
+    EXPECT_THROW(Finn::PackedDatasetReader{fn}, std::runtime_error);
+}
+
+TEST_F(PackedDatasetTest, IncompleteWriteTest) {
+    Finn::PackedDatasetWriter writer(fn, header);
+    EXPECT_THROW(writer.append(std::span<const uint8_t>(std::vector<uint8_t>(1))), std::length_error);
+    writer.append(std::span<const uint8_t>(std::vector<uint8_t>(header.bytesPerSample())));
+    EXPECT_THROW(writer.close(), std::length_error);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,110 @@
+/**
+ * @file PostprocessingTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the postprocessing stages on packed outputs
+ * @version 0.1
+ * @date 2024-03-07
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/Types.h>
+
+#include <FINNCppDriver/utils/DataPacking.hpp>
+#include <FINNCppDriver/utils/FinnDatatypes.hpp>
+#include <FINNCppDriver/utils/Postprocessing.hpp>
+#include <FINNCppDriver/utils/ThreadPool.hpp>
+#include <FINNCppDriver/utils/TransferPlan.h>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+    /**
+     * @brief 3 samples of 2 rows with 4 values of UInt<3> each, the classes of every sample are 0..7
+     *
+     */
+    const Finn::vector<int> values{
+        1, 5, 2, 0, 7, 3, 5, 1,  //
+        6, 6, 0, 2, 1, 1, 4, 6,  //
+        0, 0, 0, 0, 0, 0, 0, 0,
+    };
+
+    Finn::TransferPlan plan() { return Finn::TransferPlan::forBatchSize({1, 2, 4}, {1, 2, 2}, 3, Finn::DatatypeUInt<3>().bitwidth()); }
+
+    Finn::vector<uint8_t> pack() {
+        auto transferPlan = plan();
+        Finn::vector<uint8_t> packed(transferPlan.bytes());
+        Finn::packMultiDimensionalInputs<Finn::DatatypeUInt<3>>(values.begin(), values.end(), transferPlan, std::span<uint8_t>(packed.data(), packed.size()));
+        return packed;
+    }
+
+    Finn::vector<std::size_t> run(const Finn::Postprocessing& stage, Finn::ThreadPool* pool = nullptr) {
+        auto packed = pack();
+        Finn::vector<std::size_t> indices(3 * stage.resultsPerSample());
+        EXPECT_EQ(Finn::postprocessPacked<Finn::DatatypeUInt<3>>(std::span<const uint8_t>(packed.data(), packed.size()), plan(), stage, std::span<std::size_t>(indices.data(), indices.size()), pool), indices.size());
+        return indices;
+    }
+}  // namespace
+
+TEST(PostprocessingTest, ArgmaxTest) {
+    // Ties are won by the lower index
+    EXPECT_EQ(run(Finn::Postprocessing::argmax()), (Finn::vector<std::size_t>{4, 0, 0}));
+}
+
+TEST(PostprocessingTest, TopKTest) {
+    EXPECT_EQ(run(Finn::Postprocessing::topK(3)), (Finn::vector<std::size_t>{4, 1, 6, 0, 1, 7, 0, 1, 2}));
+}
+
+TEST(PostprocessingTest, ThresholdTest) {
+    const Finn::vector<std::size_t> expected{4, 1, 6, 0, 1, 7, Finn::noClass, Finn::noClass, Finn::noClass};
+    EXPECT_EQ(run(Finn::Postprocessing::threshold(5, 3)), expected);
+    EXPECT_EQ(run(Finn::Postprocessing::threshold(7)), (Finn::vector<std::size_t>{4, Finn::noClass, Finn::noClass}));
+}
+
+TEST(PostprocessingTest, ParallelMatchesSerialTest) {
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<int> dist(-8, 7);
+    auto transferPlan = Finn::TransferPlan::forBatchSize({1, 10, 100}, {1, 10, 50}, 64, Finn::DatatypeInt<4>().bitwidth());
+    Finn::vector<int8_t> inp(transferPlan.elements());
+    std::generate(inp.begin(), inp.end(), [&]() { return static_cast<int8_t>(dist(gen)); });
+    Finn::vector<uint8_t> packed(transferPlan.bytes());
+    Finn::packMultiDimensionalInputs<Finn::DatatypeInt<4>>(inp.begin(), inp.end(), transferPlan, std::span<uint8_t>(packed.data(), packed.size()));
+
+    Finn::ThreadPool pool(4, {}, 1);
+    Finn::vector<std::size_t> serial(64 * 5);
+    Finn::vector<std::size_t> parallel(64 * 5);
+    Finn::postprocessPacked<Finn::DatatypeInt<4>>(std::span<const uint8_t>(packed.data(), packed.size()), transferPlan, Finn::Postprocessing::topK(5), std::span<std::size_t>(serial.data(), serial.size()));
+    Finn::postprocessPacked<Finn::DatatypeInt<4>>(std::span<const uint8_t>(packed.data(), packed.size()), transferPlan, Finn::Postprocessing::topK(5), std::span<std::size_t>(parallel.data(), parallel.size()), &pool);
+    EXPECT_EQ(serial, parallel);
+    for (std::size_t sample = 0; sample < 64; ++sample) {
+        const auto first = inp.begin() + static_cast<std::ptrdiff_t>(sample * 1000);
+        EXPECT_EQ(serial[sample * 5], static_cast<std::size_t>(std::distance(first, std::max_element(first, first + 1000))));
+        for (std::size_t i = 1; i < 5; ++i) {
+            EXPECT_GE(first[static_cast<std::ptrdiff_t>(serial[sample * 5 + i - 1])], first[static_cast<std::ptrdiff_t>(serial[sample * 5 + i])]);
+        }
+    }
+}
+
+TEST(PostprocessingTest, InvalidArgumentsTest) {
+    auto packed = pack();
+    Finn::vector<std::size_t> indices(2);
+    EXPECT_THROW(Finn::postprocessPacked<Finn::DatatypeUInt<3>>(std::span<const uint8_t>(packed.data(), packed.size()), plan(), Finn::Postprocessing::argmax(), std::span<std::size_t>(indices.data(), indices.size())), std::length_error);
+    indices.resize(3);
+    EXPECT_THROW(Finn::postprocessPacked<Finn::DatatypeUInt<3>>(std::span<const uint8_t>(packed.data(), packed.size()), plan(), Finn::Postprocessing::topK(0), std::span<std::size_t>(indices.data(), indices.size())), std::invalid_argument);
+    EXPECT_THROW(Finn::postprocessPacked<Finn::DatatypeUInt<4>>(std::span<const uint8_t>(packed.data(), packed.size()), plan(), Finn::Postprocessing::argmax(), std::span<std::size_t>(indices.data(), indices.size())), std::invalid_argument);
+    EXPECT_THROW(Finn::postprocessPacked<Finn::DatatypeUInt<3>>(std::span<const uint8_t>(packed.data(), packed.size() - 1), plan(), Finn::Postprocessing::argmax(), std::span<std::size_t>(indices.data(), indices.size())), std::length_error);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
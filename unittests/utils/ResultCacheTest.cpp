@@ -0,0 +1,87 @@
+/**
+ * @file ResultCacheTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the LRU cache of packed results
+ * @version 0.1
+ * @date 2024-03-17
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/ResultCache.hpp>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+    std::vector<uint8_t> sample(uint8_t value, std::size_t bytes = 13) { return std::vector<uint8_t>(bytes, value); }
+}  // namespace
+
+TEST(ResultCacheTest, HashTest) {
+    EXPECT_EQ(Finn::ResultCache::hash(sample(1)), Finn::ResultCache::hash(sample(1)));
+    EXPECT_NE(Finn::ResultCache::hash(sample(1)), Finn::ResultCache::hash(sample(2)));
+    // The bytes after the last full word count as well
+    auto tail = sample(1);
+    tail.back() = 2;
+    EXPECT_NE(Finn::ResultCache::hash(sample(1)), Finn::ResultCache::hash(tail));
+    EXPECT_NE(Finn::ResultCache::hash(sample(0, 8)), Finn::ResultCache::hash(sample(0, 16)));
+    EXPECT_NO_THROW(Finn::ResultCache::hash({}));
+}
+
+TEST(ResultCacheTest, LookupTest) {
+    Finn::ResultCache cache(0, 10);
+    std::vector<uint8_t> result(4);
+    EXPECT_FALSE(cache.lookup(sample(1), std::span<uint8_t>(result)));
+    cache.insert(sample(1), sample(42, 4));
+    EXPECT_TRUE(cache.lookup(sample(1), std::span<uint8_t>(result)));
+    EXPECT_EQ(result, sample(42, 4));
+    // A result of another size is never handed out
+    std::vector<uint8_t> tooLarge(5);
+    EXPECT_FALSE(cache.lookup(sample(1), std::span<uint8_t>(tooLarge)));
+
+    auto statistics = cache.getStatistics();
+    EXPECT_EQ(statistics.hits, 1);
+    EXPECT_EQ(statistics.misses, 2);
+    EXPECT_EQ(statistics.entries, 1);
+    EXPECT_EQ(statistics.bytes, 13 + 4);
+
+    cache.clear();
+    EXPECT_FALSE(cache.lookup(sample(1), std::span<uint8_t>(result)));
+    EXPECT_EQ(cache.getStatistics().bytes, 0);
+    EXPECT_EQ(cache.getStatistics().hits, 1);
+}
+
+TEST(ResultCacheTest, EvictionTest) {
+    // Room for two entries of 17 bytes
+    Finn::ResultCache cache(40, 0);
+    std::vector<uint8_t> result(4);
+    cache.insert(sample(1), sample(1, 4));
+    cache.insert(sample(2), sample(2, 4));
+    EXPECT_TRUE(cache.lookup(sample(1), std::span<uint8_t>(result)));
+    cache.insert(sample(3), sample(3, 4));
+    EXPECT_TRUE(cache.lookup(sample(1), std::span<uint8_t>(result)));
+    EXPECT_FALSE(cache.lookup(sample(2), std::span<uint8_t>(result)));
+    EXPECT_TRUE(cache.lookup(sample(3), std::span<uint8_t>(result)));
+    EXPECT_EQ(cache.getStatistics().evictions, 1);
+    EXPECT_LE(cache.getStatistics().bytes, 40);
+
+    // Caching the same input again replaces its result
+    cache.insert(sample(3), sample(7, 4));
+    EXPECT_TRUE(cache.lookup(sample(3), std::span<uint8_t>(result)));
+    EXPECT_EQ(result, sample(7, 4));
+    EXPECT_EQ(cache.getStatistics().entries, 2);
+
+    // Samples larger than the cache are not cached
+    cache.insert(sample(4, 100), sample(4, 4));
+    EXPECT_FALSE(cache.lookup(sample(4, 100), std::span<uint8_t>(result)));
+    EXPECT_EQ(cache.getStatistics().entries, 2);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
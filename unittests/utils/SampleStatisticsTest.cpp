@@ -0,0 +1,60 @@
+/**
+ * @file SampleStatisticsTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the sample statistics of the benchmark modes
+ * @version 0.1
+ * @date 2024-02-26
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/SampleStatistics.hpp>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+
+TEST(SampleStatisticsTest, EmptyTest) {
+    std::vector<double> samples;
+    const auto stats = Finn::SampleStatistics::compute(samples);
+    EXPECT_EQ(stats.count, 0);
+    EXPECT_EQ(stats.p99, 0);
+}
+
+TEST(SampleStatisticsTest, PercentileTest) {
+    std::vector<double> samples(1000);
+    std::iota(samples.begin(), samples.end(), 1.0);
+    std::shuffle(samples.begin(), samples.end(), std::mt19937(42));
+    const auto stats = Finn::SampleStatistics::compute(samples);
+    EXPECT_EQ(stats.count, 1000);
+    EXPECT_DOUBLE_EQ(stats.mean, 500.5);
+    EXPECT_DOUBLE_EQ(stats.min, 1);
+    EXPECT_DOUBLE_EQ(stats.max, 1000);
+    EXPECT_DOUBLE_EQ(stats.p50, 500);
+    EXPECT_DOUBLE_EQ(stats.p90, 900);
+    EXPECT_DOUBLE_EQ(stats.p99, 990);
+    EXPECT_DOUBLE_EQ(stats.p999, 999);
+    // Unbiased variance of 1..n is n(n+1)/12
+    EXPECT_NEAR(stats.variance, 1000.0 * 1001.0 / 12.0, 1e-6);
+
+    const nlohmann::json j = stats;
+    EXPECT_DOUBLE_EQ(j.at("p99").get<double>(), 990);
+}
+
+TEST(SampleStatisticsTest, SingleSampleTest) {
+    std::vector<double> samples{3.5};
+    const auto stats = Finn::SampleStatistics::compute(samples);
+    EXPECT_DOUBLE_EQ(stats.p50, 3.5);
+    EXPECT_DOUBLE_EQ(stats.p999, 3.5);
+    EXPECT_DOUBLE_EQ(stats.variance, 0);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
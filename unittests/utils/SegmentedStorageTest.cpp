@@ -0,0 +1,95 @@
+/**
+ * @file SegmentedStorageTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the segmented storage
+ * @version 0.1
+ * @date 2024-02-21
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/Types.h>
+
+#include <FINNCppDriver/utils/SegmentedStorage.hpp>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+
+TEST(SegmentedStorageTest, ChunkingTest) {
+    Finn::SegmentedStorage<uint8_t> storage(2, 3);
+    for (uint8_t i = 0; i < 7; ++i) {
+        std::array<uint8_t, 2> part{i, i};
+        EXPECT_TRUE(storage.tryAppend(part));
+    }
+    EXPECT_EQ(storage.size(), 7);
+    EXPECT_EQ(storage.elements(), 14);
+    EXPECT_EQ(storage.chunkCount(), 3);
+    EXPECT_THROW(storage.tryAppend(std::array<uint8_t, 3>{}), std::length_error);
+
+    // Chunks are handed out as they were filled
+    auto chunks = storage.takeChunks();
+    ASSERT_EQ(chunks.size(), 3);
+    EXPECT_EQ(chunks[0], (Finn::vector<uint8_t>{0, 0, 1, 1, 2, 2}));
+    EXPECT_EQ(chunks[2], (Finn::vector<uint8_t>{6, 6}));
+    EXPECT_TRUE(storage.empty());
+    EXPECT_EQ(storage.chunkCount(), 0);
+}
+
+TEST(SegmentedStorageTest, TakeTest) {
+    Finn::SegmentedStorage<uint8_t> storage(1, 2);
+    EXPECT_TRUE(storage.take().empty());
+
+    // A single chunk is moved out without copying
+    EXPECT_TRUE(storage.tryAppend(std::array<uint8_t, 1>{1}));
+    const uint8_t* stored = storage.testGetChunks().front().data();
+    auto single = storage.take();
+    EXPECT_EQ(single.data(), stored);
+
+    for (uint8_t i = 0; i < 5; ++i) {
+        EXPECT_TRUE(storage.tryAppend(std::array<uint8_t, 1>{i}));
+    }
+    EXPECT_EQ(storage.take(), (Finn::vector<uint8_t>{0, 1, 2, 3, 4}));
+    EXPECT_TRUE(storage.empty());
+}
+
+TEST(SegmentedStorageTest, CapacityTest) {
+    Finn::SegmentedStorage<uint8_t> storage(1, 2, 3);
+    for (uint8_t i = 0; i < 3; ++i) {
+        EXPECT_TRUE(storage.tryAppend(std::array<uint8_t, 1>{i}));
+    }
+    EXPECT_TRUE(storage.full());
+    EXPECT_FALSE(storage.tryAppend(std::array<uint8_t, 1>{3}));
+
+    // A stop aborts waiting for space
+    std::stop_source stopped;
+    stopped.request_stop();
+    EXPECT_FALSE(storage.waitForSpace(stopped.get_token()));
+
+    // Taking the contents wakes up a waiting producer
+    std::jthread producer([&storage](std::stop_token stoken) {
+        if (storage.waitForSpace(stoken)) {
+            storage.tryAppend(std::array<uint8_t, 1>{42});
+        }
+    });
+    EXPECT_EQ(storage.take(), (Finn::vector<uint8_t>{0, 1, 2}));
+    producer.join();
+    EXPECT_EQ(storage.take(), (Finn::vector<uint8_t>{42}));
+
+    storage.setCapacity(0);
+    for (uint8_t i = 0; i < 10; ++i) {
+        EXPECT_TRUE(storage.tryAppend(std::array<uint8_t, 1>{i}));
+    }
+    EXPECT_FALSE(storage.full());
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,96 @@
+/**
+ * @file ThreadPoolTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the host thread pool
+ * @version 0.1
+ * @date 2024-01-22
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/Types.h>
+
+#include <FINNCppDriver/utils/DataPacking.hpp>
+#include <FINNCppDriver/utils/DynamicMdSpan.hpp>
+#include <FINNCppDriver/utils/ThreadPool.hpp>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+
+TEST(ThreadPoolTest, CoversRangeTest) {
+    Finn::ThreadPool pool(4, {}, 1);
+    EXPECT_EQ(pool.size(), 4);
+    for (std::size_t items : {0UL, 1UL, 3UL, 4UL, 1000UL}) {
+        std::vector<std::atomic<int>> hits(items);
+        std::atomic<std::size_t> calls = 0;
+        pool.parallelFor(items, 1, [&](std::size_t begin, std::size_t end) {
+            ++calls;
+            for (std::size_t i = begin; i < end; ++i) {
+                ++hits[i];
+            }
+        });
+        EXPECT_LE(calls.load(), pool.size());
+        for (auto&& hit : hits) {
+            EXPECT_EQ(hit.load(), 1);
+        }
+    }
+}
+
+TEST(ThreadPoolTest, GrainTest) {
+    Finn::ThreadPool pool(4, {}, 1024);
+    std::atomic<std::size_t> calls = 0;
+    // 100 items of 8 bytes are below the grain size and run inline
+    pool.parallelFor(100, 8, [&](std::size_t begin, std::size_t end) {
+        ++calls;
+        EXPECT_EQ(begin, 0);
+        EXPECT_EQ(end, 100);
+    });
+    EXPECT_EQ(calls.load(), 1);
+}
+
+TEST(ThreadPoolTest, NestedAndExceptionTest) {
+    Finn::ThreadPool pool(3, {0}, 1);
+    std::atomic<std::size_t> inner = 0;
+    pool.parallelFor(30, 1, [&](std::size_t begin, std::size_t end) { pool.parallelFor(end - begin, 1, [&](std::size_t b, std::size_t e) { inner += e - b; }); });
+    EXPECT_EQ(inner.load(), 30);
+
+    EXPECT_THROW(pool.parallelFor(30, 1, [](std::size_t begin, std::size_t) {
+        if (begin == 0) {
+            throw std::runtime_error("Error in chunk");
+        }
+    }),
+                 std::runtime_error);
+    // The pool is still usable afterwards
+    std::atomic<std::size_t> sum = 0;
+    pool.parallelFor(30, 1, [&](std::size_t begin, std::size_t end) { sum += end - begin; });
+    EXPECT_EQ(sum.load(), 30);
+}
+
+TEST(ThreadPoolTest, PackUnpackTest) {
+    Finn::ThreadPool pool(4, {}, 1);
+    const shape_t foldedShape = {1, 64, 30};
+    std::vector<int8_t> inp(FinnUtils::shapeToElements(foldedShape));
+    for (std::size_t i = 0; i < inp.size(); ++i) {
+        inp[i] = static_cast<int8_t>(static_cast<int>(i % 4) - 2);
+    }
+
+    Finn::DynamicMdSpan reshaped(inp.begin(), inp.end(), foldedShape);
+    auto serial = Finn::packMultiDimensionalInputs<Finn::DatatypeInt<2>>(inp.begin(), inp.end(), reshaped, foldedShape.back());
+    auto parallel = Finn::packMultiDimensionalInputs<Finn::DatatypeInt<2>>(inp.begin(), inp.end(), reshaped, foldedShape.back(), &pool);
+    EXPECT_EQ(serial, parallel);
+
+    const shape_t packedShape = {1, 64, 8};
+    std::vector<int8_t> unpacked(inp.size());
+    Finn::unpackMultiDimensionalOutputs<Finn::DatatypeInt<2>, int8_t>(std::span<const uint8_t>(parallel.data(), parallel.size()), packedShape, foldedShape, std::span<int8_t>(unpacked.data(), unpacked.size()), &pool);
+    EXPECT_EQ(unpacked, inp);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,146 @@
+/**
+ * @file TimelineTracerTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the timeline tracer and its Chrome trace export
+ * @version 0.1
+ * @date 2024-03-19
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/TimelineTracer.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+class TimelineTracerTest : public ::testing::Test {
+     protected:
+    Finn::TimelineTracer& tracer = Finn::TimelineTracer::global();
+
+    void TearDown() override {
+        tracer.disable();
+        tracer.clear();
+    }
+
+    /**
+     * @brief Complete events of the current trace with the given name
+     *
+     */
+    std::vector<nlohmann::json> spans(const std::string& name) const {
+        std::vector<nlohmann::json> found;
+        const auto trace = tracer.chromeTrace();
+        for (auto&& event : trace["traceEvents"]) {
+            if (event["ph"] == "X" && event["name"] == name) {
+                found.push_back(event);
+            }
+        }
+        return found;
+    }
+};
+
+TEST_F(TimelineTracerTest, DisabledTest) {
+    const auto now = std::chrono::steady_clock::now();
+    tracer.record("span", now, now);
+    { const Finn::ScopedTimelineEvent event("scoped"); }
+    EXPECT_EQ(tracer.eventCount(), 0);
+    EXPECT_THROW(tracer.enable(0), std::invalid_argument);
+    EXPECT_FALSE(tracer.isEnabled());
+}
+
+TEST_F(TimelineTracerTest, RingTest) {
+    tracer.enable(4);
+    const auto now = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; ++i) {
+        tracer.record(i < 6 ? "old" : "new", now + std::chrono::microseconds(i), now + std::chrono::microseconds(i + 1));
+    }
+    // Only the last events of every thread are kept, oldest first
+    EXPECT_EQ(tracer.eventCount(), 4);
+    auto kept = spans("new");
+    ASSERT_EQ(kept.size(), 4);
+    EXPECT_TRUE(spans("old").empty());
+    EXPECT_LT(kept.front()["ts"].get<double>(), kept.back()["ts"].get<double>());
+
+    // Enabling again starts a new recording
+    tracer.enable(4);
+    EXPECT_EQ(tracer.eventCount(), 0);
+}
+
+TEST_F(TimelineTracerTest, ChromeTraceTest) {
+    tracer.enable();
+    const auto device = tracer.deviceTrack(0, "idma0");
+    EXPECT_EQ(tracer.deviceTrack(0, "idma0"), device);
+    EXPECT_NE(tracer.deviceTrack(1, "idma0"), device);
+
+    const auto begin = std::chrono::steady_clock::now();
+    tracer.record(device, "run", begin, begin + std::chrono::microseconds(250), 1, 8);
+    tracer.record("pack", begin, begin + std::chrono::microseconds(100));
+
+    auto run = spans("run");
+    ASSERT_EQ(run.size(), 1);
+    EXPECT_EQ(run[0]["pid"], 1);
+    EXPECT_DOUBLE_EQ(run[0]["dur"].get<double>(), 250.0);
+    EXPECT_EQ(run[0]["args"]["slot"], 1);
+    EXPECT_EQ(run[0]["args"]["samples"], 8);
+    auto pack = spans("pack");
+    ASSERT_EQ(pack.size(), 1);
+    EXPECT_EQ(pack[0]["pid"], 0);
+    EXPECT_FALSE(pack[0].contains("args"));
+
+    // Only tracks with events are named
+    const auto trace = tracer.chromeTrace();
+    std::vector<std::string> processes;
+    std::vector<std::string> threads;
+    for (auto&& event : trace["traceEvents"]) {
+        if (event["ph"] == "M") {
+            (event["name"] == "process_name" ? processes : threads).push_back(event["args"]["name"]);
+        }
+    }
+    EXPECT_EQ(processes.size(), 2);
+    EXPECT_NE(std::find(processes.begin(), processes.end(), "device 0"), processes.end());
+    EXPECT_NE(std::find(threads.begin(), threads.end(), "idma0"), threads.end());
+    EXPECT_EQ(trace["displayTimeUnit"], "ns");
+
+    const std::filesystem::path path = "timeline-test.json";
+    tracer.writeChromeTrace(path);
+    std::ifstream file(path);
+    EXPECT_EQ(nlohmann::json::parse(file), trace);
+    std::filesystem::remove(path);
+    EXPECT_THROW(tracer.writeChromeTrace("missing-directory/timeline.json"), std::runtime_error);
+}
+
+TEST_F(TimelineTracerTest, ThreadTest) {
+    tracer.enable();
+    { const Finn::ScopedTimelineEvent event("main"); }
+    std::thread worker([this]() {
+        tracer.nameThread("worker");
+        const Finn::ScopedTimelineEvent event("worker span");
+    });
+    worker.join();
+
+    auto main = spans("main");
+    auto other = spans("worker span");
+    ASSERT_EQ(main.size(), 1);
+    ASSERT_EQ(other.size(), 1);
+    EXPECT_EQ(main[0]["pid"], other[0]["pid"]);
+    EXPECT_NE(main[0]["tid"], other[0]["tid"]);
+    bool named = false;
+    const auto trace = tracer.chromeTrace();
+    for (auto&& event : trace["traceEvents"]) {
+        named |= event["name"] == "thread_name" && event["tid"] == other[0]["tid"] && event["args"]["name"] == "worker";
+    }
+    EXPECT_TRUE(named);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,96 @@
+/**
+ * @file TrafficLogTest.cpp
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Unittest for the traffic log of the capture and replay modes
+ * @version 0.1
+ * @date 2024-03-12
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#include <FINNCppDriver/utils/TrafficLog.hpp>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace std::chrono_literals;
+
+class TrafficLogTest : public ::testing::Test {
+     protected:
+    std::filesystem::path path = "traffic-log-test.bin";
+    void TearDown() override { std::filesystem::remove(path); }
+};
+
+TEST_F(TrafficLogTest, RoundTripTest) {
+    const std::vector<uint8_t> first = {1, 2, 3, 4};
+    const std::vector<uint8_t> second = {5, 6};
+    {
+        Finn::TrafficRecorder recorder(path, true);
+        recorder.record(4, first);
+        std::this_thread::sleep_for(2ms);
+        recorder.record(2, second);
+        EXPECT_EQ(recorder.count(), 2);
+    }
+    const auto log = Finn::readTrafficLog(path);
+    EXPECT_TRUE(log.hasInputs);
+    ASSERT_EQ(log.records.size(), 2);
+    EXPECT_EQ(log.records[0].samples, 4);
+    EXPECT_EQ(log.records[0].input, first);
+    EXPECT_EQ(log.records[1].samples, 2);
+    EXPECT_EQ(log.records[1].input, second);
+    EXPECT_GE(log.records[1].timestamp - log.records[0].timestamp, 2ms);
+    EXPECT_EQ(log.maxSamples(), 4);
+}
+
+TEST_F(TrafficLogTest, WithoutInputsTest) {
+    {
+        Finn::TrafficRecorder recorder(path, false);
+        recorder.record(8, std::vector<uint8_t>(100, 1));
+    }
+    const auto log = Finn::readTrafficLog(path);
+    EXPECT_FALSE(log.hasInputs);
+    ASSERT_EQ(log.records.size(), 1);
+    EXPECT_EQ(log.records[0].samples, 8);
+    EXPECT_TRUE(log.records[0].input.empty());
+    EXPECT_EQ(std::filesystem::file_size(path), 20 + 16);
+}
+
+TEST_F(TrafficLogTest, ArrivalsTest) {
+    Finn::TrafficLog log;
+    log.records = {{10ms, 1, {}}, {12ms, 2, {}}, {20ms, 1, {}}};
+    EXPECT_EQ(log.arrivals(), (Finn::ArrivalSchedule{0ms, 2ms, 10ms}));
+    EXPECT_EQ(log.arrivals(2.0), (Finn::ArrivalSchedule{0ms, 1ms, 5ms}));
+    EXPECT_EQ(log.arrivals(0), (Finn::ArrivalSchedule{0ms, 0ms, 0ms}));
+    EXPECT_THROW(auto schedule = log.arrivals(-1), std::invalid_argument);
+}
+
+TEST_F(TrafficLogTest, InvalidLogTest) {
+    EXPECT_THROW(Finn::readTrafficLog("does-not-exist.bin"), std::runtime_error);
+    {
+        std::ofstream file(path);
+        file << "not a traffic log";
+    }
+    EXPECT_THROW(Finn::readTrafficLog(path), std::runtime_error);
+
+    // A log cut off in the middle of a record keeps its complete records
+    {
+        Finn::TrafficRecorder recorder(path, true);
+        recorder.record(1, std::vector<uint8_t>(8, 1));
+        recorder.record(1, std::vector<uint8_t>(8, 2));
+    }
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+    EXPECT_EQ(Finn::readTrafficLog(path).records.size(), 1);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,5 +1,17 @@
 #include "xclbin.h"
 
+#include <array>
+#include <cstring>
+#include <functional>
+
 #include "../xrt/xrt_kernel.h"
 
-std::vector<xrt::kernel> xrt::xclbin::get_kernels() const { return {}; }
\ No newline at end of file
+std::vector<xrt::kernel> xrt::xclbin::get_kernels() const { return {}; }
+
+xrt::uuid xrt::xclbin::get_uuid() const {
+    std::array<unsigned char, 16> id{};
+    const std::size_t hash = std::hash<std::string>{}(path);
+    std::memcpy(id.data(), &hash, sizeof(hash));
+    std::memcpy(id.data() + sizeof(hash), &hash, sizeof(hash));
+    return uuid(id.data());
+}
@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 
+#include "../xrt/xrt_uuid.h"
+
 namespace xrt {
 
     class kernel;
@@ -13,13 +15,20 @@ namespace xrt {
         xclbin() = default;
         xclbin(xclbin&&) = default;
         xclbin(const xclbin&) = default;
-        explicit xclbin(const std::string& filename){};
+        explicit xclbin(const std::string& filename) : path(filename){};
         xclbin& operator=(xclbin&&) = default;
         xclbin& operator=(const xclbin&) = default;
         ~xclbin() = default;
 
         std::vector<kernel> get_kernels() const;
 
+        /**
+         * get_uuid() - Get the uuid of the xclbin. The mock derives it from the file name, so different xclbins have different uuids.
+         */
+        uuid get_uuid() const;
+
+        std::string get_path() const { return path; }
+
         class ip {
              private:
             /* data */
@@ -36,6 +45,7 @@ namespace xrt {
 
 
          private:
+        std::string path;
     };
 
 }  // namespace xrt
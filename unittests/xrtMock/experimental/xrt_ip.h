@@ -4,9 +4,17 @@
 // Copyright (C) 2021-2022 Xilinx, Inc. All rights reserved.
 // Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <set>
 
 #include "xrt.h"
+#include "xrt_simulation.h"
 #include "xrt/xrt_device.h"
 #include "xrt/xrt_uuid.h"
 
@@ -34,7 +42,85 @@ namespace xrt {
      *     processes from accessing the same IP at the same time.
      */
     class ip {
+         private:
+        /**
+         * State of the mocked IP core, shared by all copies of the handle like in XRT
+         */
+        struct core {
+            std::atomic<uint32_t> repetitions = 1;
+            std::atomic<std::chrono::steady_clock::rep> idleAt = 0;
+
+            bool idle() const { return std::chrono::steady_clock::now().time_since_epoch().count() >= idleAt.load(); }
+            std::chrono::steady_clock::time_point idleTime() const { return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(idleAt.load())); }
+        };
+        std::shared_ptr<core> state = std::make_shared<core>();
+        unsigned int deviceIndex = 0;
+
+        /**
+         * Check if runs started on the device of this IP never finish
+         */
+        bool hung() const {
+            std::lock_guard guard(xrt::device::mock_mutex);
+            return mock_hung_devices.contains(deviceIndex);
+        }
+
          public:
+        /**
+         * @class interrupt
+         *
+         * @brief
+         * xrt::ip::interrupt represents an IP interrupt event. Waits complete when
+         * the run the simulation model scheduled for the IP is done, immediately
+         * without a model.
+         */
+        class interrupt {
+            std::shared_ptr<core> state;
+
+             public:
+            interrupt() = default;
+            explicit interrupt(std::shared_ptr<core> pState) : state(std::move(pState)) {}
+
+            /**
+             * enable() - Enable interrupt notification from the IP
+             */
+            void enable() {}
+
+            /**
+             * disable() - Disable interrupt notification from the IP
+             */
+            void disable() {}
+
+            /**
+             * wait() - Wait for the IP to raise an interrupt
+             */
+            void wait() {
+                if (state) {
+                    xrt::simulation::delayUntil(state->idleTime());
+                }
+            }
+
+            /**
+             * wait() - Wait for the IP to raise an interrupt or until the timeout expired
+             *
+             * @param timeout
+             *  Timeout for the wait
+             * @return
+             *  std::cv_status::no_timeout if the interrupt was raised
+             */
+            std::cv_status wait(const std::chrono::milliseconds& timeout) const {
+                if (!state) {
+                    return std::cv_status::no_timeout;
+                }
+                const auto deadline = std::chrono::steady_clock::now() + timeout;
+                if (state->idleTime() > deadline) {
+                    xrt::simulation::delayUntil(deadline);
+                    return std::cv_status::timeout;
+                }
+                xrt::simulation::delayUntil(state->idleTime());
+                return std::cv_status::no_timeout;
+            }
+        };
+
         /**
          * ip() - Construct empty ip object
          */
@@ -56,7 +142,7 @@ namespace xrt {
          *
          * Constructor throws on error.
          */
-        ip(const xrt::device& device, const xrt::uuid& xclbin_id, const std::string& name){};
+        ip(const xrt::device& device, const xrt::uuid& xclbin_id, const std::string& name) : deviceIndex(device.index){};
 
         /**
          * write_register() - Write to the address range of an ip
@@ -67,7 +153,14 @@ namespace xrt {
          *  Data to write
          *
          */
-        void write_register(uint32_t offset, uint32_t data){};
+        void write_register(uint32_t offset, uint32_t data) {
+            xrt::simulation::registerAccess();
+            if (offset == mock_repetitions_offset) {
+                state->repetitions = data;
+            } else if (offset == 0x0 && (data & 0x1) != 0) {
+                state->idleAt = hung() ? std::numeric_limits<std::chrono::steady_clock::rep>::max() : xrt::simulation::scheduleKernel(state->repetitions).time_since_epoch().count();
+            }
+        };
 
         /**
          * read_register() - Read data from ip address range
@@ -79,11 +172,39 @@ namespace xrt {
          *
          */
         uint32_t read_register(uint32_t offset) const {
+            xrt::simulation::registerAccess();
             if (offset == 0x0) {
-                return 0x4;
+                // ap_idle once the simulated run is done, ap_start while it is running
+                return state->idle() ? 0x4 : 0x1;
             }
-            return 0;
+            return (offset == mock_cycle_counter_offset) ? mock_cycle_counter : 0;
         };
+
+        /**
+         * Register the driver writes the number of repetitions of a run to, used for the kernel time of the simulation model
+         */
+        inline static constexpr uint32_t mock_repetitions_offset = 0x1C;
+        /**
+         * Register that the mock reports mock_cycle_counter for, to emulate IP cores with a cycle counter
+         */
+        inline static uint32_t mock_cycle_counter_offset = 0x40;
+        /**
+         * Value of the mocked cycle counter register
+         */
+        inline static uint32_t mock_cycle_counter = 1000;
+        /**
+         * Indices of the cards whose IP cores hang, runs started on them never become idle. Guarded by xrt::device::mock_mutex. Recreating the IP objects, e.g.
+         * after reprogramming the card, clears runs that hang.
+         */
+        inline static std::set<unsigned int> mock_hung_devices;
+
+        /**
+         * create_interrupt_notify() - Create an interrupt object for this IP
+         *
+         * @return
+         *  xrt::ip::interrupt object that can be used to wait for IP completion
+         */
+        interrupt create_interrupt_notify() { return interrupt(state); }
     };
 
 }  // namespace xrt
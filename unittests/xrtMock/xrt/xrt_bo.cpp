@@ -1,14 +1,38 @@
 #include "xrt_bo.h"
 
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
 #include "../xrt.h"
 #include "xrt_device.h"
 
-void xrt::bo::sync(xclBOSyncDirection syncMode) {
-    // FINN_LOG(logger, loglevel::debug) << "(xrtMock) xrt::bo object synced!\n";
+xrt::bo::bo(const bo& parent, size_t sz, size_t offset)
+    : device(parent.device), byteSize(sz), group(parent.group), boFlags(parent.boFlags), ownsMap(false), baseAddress(parent.baseAddress + offset), logger(Logger::getLogger()) {
+    if (parent.memmap == nullptr || offset + sz > parent.byteSize) {
+        throw std::runtime_error("(xrtMock) Invalid xrt::bo sub-buffer");
+    }
+    memmap = static_cast<uint8_t*>(parent.memmap) + offset;
+    FINN_LOG(logger, loglevel::debug) << "(xrtMock) xrt::bo sub-buffer created at offset " << offset << "!\n";
 }
 
+void xrt::bo::sync(xclBOSyncDirection syncMode) { sync(syncMode, byteSize, 0); }
+
 void xrt::bo::sync(xclBOSyncDirection dir, size_t sz, size_t offset) {
     // FINN_LOG(logger, loglevel::debug) << "(xrtMock) xrt::bo object synced!\n";
+    xrt::simulation::delayUntil(xrt::simulation::scheduleSync(dir, sz));
+}
+
+xrt::bo::async_handle xrt::bo::async(xclBOSyncDirection dir, size_t sz, size_t offset) {
+    ++async_handle::startedTransfers;
+    return {xrt::simulation::scheduleSync(dir, sz)};
+}
+
+void xrt::bo::copy(const bo& src, size_t sz, size_t srcOffset, size_t dstOffset) {
+    if (memmap == nullptr || src.memmap == nullptr || srcOffset + sz > src.byteSize || dstOffset + sz > byteSize) {
+        throw std::runtime_error("(xrtMock) Invalid xrt::bo copy");
+    }
+    std::memcpy(static_cast<uint8_t*>(memmap) + dstOffset, static_cast<const uint8_t*>(src.memmap) + srcOffset, sz);
 }
 
 /**
@@ -16,5 +40,7 @@ void xrt::bo::sync(xclBOSyncDirection dir, size_t sz, size_t offset) {
  */
 xrt::bo::~bo() {
     FINN_LOG(logger, loglevel::debug) << "(xrtMock) Destroying and freeing xrt::bo object!\n";
-    free(memmap);
+    if (ownsMap) {
+        free(memmap);
+    }
 }
\ No newline at end of file
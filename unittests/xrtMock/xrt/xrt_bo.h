@@ -3,27 +3,89 @@
 
 #include <FINNCppDriver/utils/Logger.h>
 
+#include <chrono>
+
 #include "../xrt.h"
+#include "../xrt_simulation.h"
 #include "xrt_device.h"
 
 namespace xrt {
     class bo {
+         public:
+        enum class flags : uint32_t { normal = 0, cacheable = 1U << 24U, p2p = 1U << 30U, svm = 1U << 27U, device_only = 1U << 28U, host_only = 1U << 29U };
+
+        /**
+         * @brief Handle of an asynchronous sync. The data of the mock is in place immediately, waiting only spends the time the simulation model gives the transfer
+         * and counts the joined transfers.
+         *
+         */
+        class async_handle {
+             public:
+            /**
+             * @brief Time the transfer is complete in the simulation model
+             *
+             */
+            std::chrono::steady_clock::time_point done{};
+
+            void wait() {
+                xrt::simulation::delayUntil(done);
+                ++joinedTransfers;
+            }
+            /**
+             * @brief Number of asynchronous transfers started over the lifetime of the process
+             *
+             */
+            static inline std::size_t startedTransfers = 0;
+            /**
+             * @brief Number of asynchronous transfers joined over the lifetime of the process
+             *
+             */
+            static inline std::size_t joinedTransfers = 0;
+        };
+
          private:
         xrt::device device;
         size_t byteSize;
         unsigned int group;
+        flags boFlags = flags::normal;
 
         void* memmap = nullptr;
+        /**
+         * @brief False for sub-buffers, whose map is part of the map of their parent
+         *
+         */
+        bool ownsMap = true;
+        uint64_t baseAddress = 0;
 
         logger_type& logger;
 
          public:
         bo(xrt::device pDevice, size_t pBytesize, unsigned int pGroup) : device(pDevice), byteSize(pBytesize), group(pGroup), logger(Logger::getLogger()) { FINN_LOG(logger, loglevel::debug) << "(xrtMock) xrt::bo object created!\n"; }
 
-        bo(bo&& other) noexcept : device(std::move(other.device)), byteSize(other.byteSize), group(other.group), memmap(nullptr), logger(Logger::getLogger()) { std::swap(memmap, other.memmap); }
+        bo(xrt::device pDevice, size_t pBytesize, flags pFlags, unsigned int pGroup) : device(pDevice), byteSize(pBytesize), group(pGroup), boFlags(pFlags), logger(Logger::getLogger()) {
+            FINN_LOG(logger, loglevel::debug) << "(xrtMock) xrt::bo object created with flags " << static_cast<uint32_t>(pFlags) << "!\n";
+        }
+
+        /**
+         * @brief Sub-buffer of sz bytes at offset into parent. The parent has to be mapped and has to outlive the sub-buffer.
+         *
+         */
+        bo(const bo& parent, size_t sz, size_t offset);
+
+        bo(bo&& other) noexcept
+            : device(std::move(other.device)), byteSize(other.byteSize), group(other.group), boFlags(other.boFlags), memmap(nullptr), ownsMap(other.ownsMap), baseAddress(other.baseAddress), logger(Logger::getLogger()) {
+            std::swap(memmap, other.memmap);
+        }
 
         void sync(xclBOSyncDirection);
         void sync(xclBOSyncDirection dir, size_t sz, size_t offset);
+        async_handle async(xclBOSyncDirection dir, size_t sz, size_t offset);
+        /**
+         * @brief Copy sz bytes from src into this buffer object. Both buffers have to be mapped, so the "device memory" of the mock is the memory map.
+         *
+         */
+        void copy(const bo& src, size_t sz, size_t srcOffset = 0, size_t dstOffset = 0);
+        flags get_flags() const { return boFlags; }
         ~bo();
 
         /**
@@ -35,13 +97,17 @@ namespace xrt {
          */
         template<typename T>
         T map() {
+            if (!ownsMap) {
+                return static_cast<T>(memmap);
+            }
             FINN_LOG(logger, loglevel::debug) << "(xrtMock) Map created from xrt::bo with byte size " << byteSize << "!\n";
             T createdMap = static_cast<T>(malloc(byteSize));
             memmap = createdMap;
             return createdMap;
         }
 
-        uint64_t address() const { return 0; };
+        uint64_t address() const { return baseAddress; };
+        size_t size() const { return byteSize; }
     };
 }  // namespace xrt
 
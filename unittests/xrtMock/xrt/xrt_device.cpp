@@ -1,24 +1,38 @@
 #include "xrt_device.h"
 
-#include <array>
-#include <numeric>
-
 namespace xrt {
 
-    device::device(unsigned int didx) {
+    device::device(unsigned int didx) : index(didx) {
+        std::lock_guard guard(mock_mutex);
         ++device_costum_constructor_called;
         device_param_didx = didx;
     }
 
-    uuid device::load_xclbin(const std::string& xclbin_fnm) {
-        loaded_xclbin = xclbin_fnm;
-        std::array<unsigned char, 16> id;
-        std::iota(id.begin(), id.end(), 1);
-        loadedUUID = uuid(id.data());
+    uuid device::load_xclbin(const std::string& xclbin_fnm) { return load_xclbin(xrt::xclbin(xclbin_fnm)); }
+
+    uuid device::load_xclbin(const xrt::xclbin& xclbin) {
+        std::lock_guard guard(mock_mutex);
+        ++load_xclbin_called;
+        loaded_xclbin = xclbin.get_path();
+        loadedUUID = xclbin.get_uuid();
+        programmed_cards.insert_or_assign(index, loadedUUID);
+        return loadedUUID;
+    }
+
+    uuid device::register_xclbin(const xrt::xclbin& xclbin) {
+        loadedUUID = xclbin.get_uuid();
         return loadedUUID;
     }
 
-    uuid device::get_xclbin_uuid() const { return loadedUUID; }
+    uuid device::get_xclbin_uuid() const {
+        std::lock_guard guard(mock_mutex);
+        if (auto card = programmed_cards.find(index); card != programmed_cards.end()) {
+            return card->second;
+        }
+        // A card without an xclbin reports the null uuid
+        const uuid_t null{};
+        return uuid(null);
+    }
 
     void device::reset() {}
-}  // namespace xrt
\ No newline at end of file
+}  // namespace xrt
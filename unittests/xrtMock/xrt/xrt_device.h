@@ -1,16 +1,42 @@
 #ifndef XRT_DEVICE_H
 #define XRT_DEVICE_H
 
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 
+#include "../experimental/xclbin.h"
 #include "xrt_uuid.h"
 
 namespace xrt {
+    namespace info {
+        /**
+         * Parameters that can be queried with device::get_info(). The mock only answers bdf.
+         */
+        enum class device : unsigned int { bdf, interface_uuid, kdma, max_clock_frequency_mhz, m2m, name, nodma };
+    }  // namespace info
+
     class device {
          public:
         inline static unsigned int device_costum_constructor_called = 0;
         inline static unsigned int device_param_didx = 0;
+        /**
+         * Number of xclbins that were loaded onto a card, registering an xclbin does not count
+         */
+        inline static unsigned int load_xclbin_called = 0;
+        /**
+         * The xclbin loaded on every card. Like on real hardware, it outlives the device objects.
+         */
+        inline static std::map<unsigned int, uuid> programmed_cards;
+        /**
+         * Guards the static state above, as devices are opened from multiple threads
+         */
+        inline static std::mutex mock_mutex;
+        /**
+         * PCIe address reported by get_info<info::device::bdf>() for every card
+         */
+        inline static std::string mock_bdf = "0000:00:00.0";
         /**
          * device() - Constructor for empty device
          */
@@ -112,7 +138,7 @@ namespace xrt {
          * This function registers an xclbin with the device, but
          * does not associate the xclbin with hardware resources.
          */
-        // uuid register_xclbin(const xrt::xclbin& xclbin);
+        uuid register_xclbin(const xrt::xclbin& xclbin);
         /// @endcond
 
         /**
@@ -152,7 +178,7 @@ namespace xrt {
          * caller.  The xrt::xclbin object must contain the complete axlf
          * structure.
          */
-        // uuid load_xclbin(const xrt::xclbin& xclbin);
+        uuid load_xclbin(const xrt::xclbin& xclbin);
 
         /**
          * get_xclbin_uuid() - Get UUID of xclbin image loaded on device
@@ -165,6 +191,20 @@ namespace xrt {
          */
         uuid get_xclbin_uuid() const;
 
+        /**
+         * get_info() - Retrieve device parameter information
+         *
+         * The mock returns every parameter as string, only bdf carries a meaningful value.
+         */
+        template<info::device param>
+        std::string get_info() const {
+            if constexpr (param == info::device::bdf) {
+                return mock_bdf;
+            } else {
+                return {};
+            }
+        }
+
 
          public:
         // std::shared_ptr<xrt_core::device> get_handle() const { return handle; }
@@ -176,6 +216,7 @@ namespace xrt {
 
          public:
         uuid loadedUUID;
+        unsigned int index = 0;
     };
 }  // namespace xrt
 
@@ -3,6 +3,7 @@
 #include <FINNCppDriver/utils/Logger.h>
 
 #include <iostream>
+#include <mutex>
 
 #include "../ert.h"
 
@@ -10,6 +11,8 @@ namespace xrt {
     kernel::kernel(const xrt::device& device, const xrt::uuid& xclbin_id, const std::string& name, cu_access_mode mode) {
         FINN_LOG(Logger::getLogger(), loglevel::debug) << "[xrt::kernel mock]"
                                                        << "Create kernel with name: " << name;
+        static std::mutex kernelMutex;
+        std::lock_guard guard(kernelMutex);
         kernel_device.emplace_back(device);
         kernel_uuid.emplace_back(xclbin_id);
         kernel_name.emplace_back(name);
@@ -0,0 +1,164 @@
+#include "xrt_simulation.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace xrt::simulation {
+    namespace {
+        struct State {
+            std::mutex mutex;
+            Model model;
+            Statistics statistics;
+            std::chrono::steady_clock::time_point linkFree[2]{};
+        };
+
+        Model fromEnvironment() {
+            const char* spec = std::getenv("FINN_XRT_SIMULATION");
+            return (spec == nullptr) ? Model{} : parse(spec);
+        }
+
+        State& state() {
+            static State instance{{}, fromEnvironment(), {}, {}};
+            return instance;
+        }
+
+        double toNumber(const std::string& key, const std::string& value) {
+            std::size_t used = 0;
+            double number = 0;
+            try {
+                number = std::stod(value, &used);
+            } catch (const std::exception&) {
+                used = 0;
+            }
+            if (used != value.size() || number < 0) {
+                throw std::invalid_argument("(xrtMock) Invalid value " + value + " for simulation parameter " + key);
+            }
+            return number;
+        }
+
+        std::chrono::nanoseconds fromUnit(double value, double nanosecondsPerUnit) { return std::chrono::nanoseconds(static_cast<std::int64_t>(value * nanosecondsPerUnit)); }
+    }  // namespace
+
+    Model parse(const std::string& spec) {
+        Model parsed;
+        std::size_t begin = 0;
+        while (begin < spec.size()) {
+            const std::size_t end = std::min(spec.find(',', begin), spec.size());
+            const std::string entry = spec.substr(begin, end - begin);
+            begin = end + 1;
+            if (entry.empty()) {
+                continue;
+            }
+            const std::size_t equals = entry.find('=');
+            if (equals == std::string::npos) {
+                throw std::invalid_argument("(xrtMock) Simulation parameter " + entry + " has no value");
+            }
+            const std::string key = entry.substr(0, equals);
+            const std::string value = entry.substr(equals + 1);
+            if (key == "wait") {
+                if (value == "none") {
+                    parsed.waitMode = WAIT_MODE::NONE;
+                } else if (value == "sleep") {
+                    parsed.waitMode = WAIT_MODE::SLEEP;
+                } else if (value == "spin") {
+                    parsed.waitMode = WAIT_MODE::SPIN;
+                } else {
+                    throw std::invalid_argument("(xrtMock) Unknown wait mode " + value);
+                }
+            } else if (key == "sync_latency_us") {
+                parsed.syncLatency = fromUnit(toNumber(key, value), 1e3);
+            } else if (key == "sync_gbps") {
+                parsed.syncBandwidth = toNumber(key, value) * 1e9;
+            } else if (key == "kernel_latency_us") {
+                parsed.kernelLatency = fromUnit(toNumber(key, value), 1e3);
+            } else if (key == "sample_ns") {
+                parsed.sampleTime = fromUnit(toNumber(key, value), 1);
+            } else if (key == "register_ns") {
+                parsed.registerLatency = fromUnit(toNumber(key, value), 1);
+            } else {
+                throw std::invalid_argument("(xrtMock) Unknown simulation parameter " + key);
+            }
+        }
+        return parsed;
+    }
+
+    Model model() {
+        std::lock_guard guard(state().mutex);
+        return state().model;
+    }
+
+    void configure(const Model& pModel) {
+        std::lock_guard guard(state().mutex);
+        state().model = pModel;
+        std::fill(std::begin(state().linkFree), std::end(state().linkFree), std::chrono::steady_clock::time_point{});
+    }
+
+    Statistics statistics() {
+        std::lock_guard guard(state().mutex);
+        return state().statistics;
+    }
+
+    void resetStatistics() {
+        std::lock_guard guard(state().mutex);
+        state().statistics = {};
+    }
+
+    void delayUntil(std::chrono::steady_clock::time_point until) {
+        switch (model().waitMode) {
+            case WAIT_MODE::SLEEP:
+                std::this_thread::sleep_until(until);
+                break;
+            case WAIT_MODE::SPIN:
+                while (std::chrono::steady_clock::now() < until) {
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    void delay(std::chrono::nanoseconds duration) {
+        if (duration.count() > 0) {
+            delayUntil(std::chrono::steady_clock::now() + duration);
+        }
+    }
+
+    void registerAccess() {
+        std::chrono::nanoseconds latency{0};
+        {
+            std::lock_guard guard(state().mutex);
+            ++state().statistics.registerAccesses;
+            latency = state().model.registerLatency;
+        }
+        delay(latency);
+    }
+
+    std::chrono::steady_clock::time_point scheduleSync(xclBOSyncDirection dir, std::size_t bytes) {
+        const auto now = std::chrono::steady_clock::now();
+        std::lock_guard guard(state().mutex);
+        auto& current = state();
+        const auto duration = current.model.syncTime(bytes);
+        ++current.statistics.syncs;
+        current.statistics.syncedBytes += bytes;
+        current.statistics.syncTime += duration;
+        if (current.model.waitMode == WAIT_MODE::NONE) {
+            return now;
+        }
+        auto& linkFree = current.linkFree[(dir == XCL_BO_SYNC_BO_TO_DEVICE) ? 0 : 1];
+        linkFree = std::max(linkFree, now) + duration;
+        return linkFree;
+    }
+
+    std::chrono::steady_clock::time_point scheduleKernel(std::uint32_t samples) {
+        const auto now = std::chrono::steady_clock::now();
+        std::lock_guard guard(state().mutex);
+        auto& current = state();
+        const auto duration = current.model.kernelTime(samples);
+        ++current.statistics.kernelRuns;
+        current.statistics.kernelTime += duration;
+        return (current.model.waitMode == WAIT_MODE::NONE) ? now : now + duration;
+    }
+}  // namespace xrt::simulation
@@ -0,0 +1,184 @@
+/**
+ * @file xrt_simulation.h
+ * @author Linus Jungemann (linus.jungemann@uni-paderborn.de) and others
+ * @brief Latency and bandwidth model of the XRT mock, so host side performance work can be evaluated without an FPGA
+ * @version 0.1
+ * @date 2024-03-11
+ *
+ * @copyright Copyright (c) 2024
+ * @license All rights reserved. This program and the accompanying materials are made available under the terms of the MIT license.
+ *
+ */
+
+#ifndef XRT_SIMULATION_H
+#define XRT_SIMULATION_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "xrt.h"
+
+namespace xrt::simulation {
+    /**
+     * @brief How simulated time is spent on the calling thread
+     *
+     */
+    enum class WAIT_MODE { NONE = 0, SLEEP = 1, SPIN = 2, INVALID = -1 };
+
+    /**
+     * @brief Cost model of the card. The default model costs nothing, which is the behaviour the unittests rely on.
+     *
+     */
+    struct Model {
+        /**
+         * @brief Fixed cost of every sync between host and device memory
+         *
+         */
+        std::chrono::nanoseconds syncLatency{0};
+        /**
+         * @brief Bandwidth of the PCIe link in bytes per second, per direction. 0 makes transfers free.
+         *
+         */
+        double syncBandwidth = 0;
+        /**
+         * @brief Fixed time of every kernel run from the start until the kernel is idle again
+         *
+         */
+        std::chrono::nanoseconds kernelLatency{0};
+        /**
+         * @brief Time the kernel needs per sample (repetition)
+         *
+         */
+        std::chrono::nanoseconds sampleTime{0};
+        /**
+         * @brief Cost of every read or write of a control register
+         *
+         */
+        std::chrono::nanoseconds registerLatency{0};
+        /**
+         * @brief NONE only accounts simulated time and completes everything immediately. SLEEP and SPIN make the calls take as long as the model says,
+         * SPIN is more precise for costs of a few microseconds.
+         *
+         */
+        WAIT_MODE waitMode = WAIT_MODE::SLEEP;
+
+        /**
+         * @brief Time a sync of the given size is in flight
+         *
+         * @param bytes
+         * @return std::chrono::nanoseconds
+         */
+        std::chrono::nanoseconds syncTime(std::size_t bytes) const {
+            const auto transfer = (syncBandwidth > 0) ? std::chrono::nanoseconds(static_cast<std::int64_t>(static_cast<double>(bytes) / syncBandwidth * 1e9)) : std::chrono::nanoseconds(0);
+            return syncLatency + transfer;
+        }
+
+        /**
+         * @brief Time a kernel run of the given number of samples takes
+         *
+         * @param samples
+         * @return std::chrono::nanoseconds
+         */
+        std::chrono::nanoseconds kernelTime(std::uint32_t samples) const { return kernelLatency + sampleTime * samples; }
+
+        /**
+         * @brief Check if anything costs time
+         *
+         * @return true
+         * @return false
+         */
+        bool active() const { return waitMode != WAIT_MODE::NONE && (syncLatency.count() > 0 || syncBandwidth > 0 || kernelTime(1).count() > 0 || registerLatency.count() > 0); }
+    };
+
+    /**
+     * @brief Simulated time spent since the last reset, summed over all threads
+     *
+     */
+    struct Statistics {
+        std::size_t syncs = 0;
+        std::size_t syncedBytes = 0;
+        std::chrono::nanoseconds syncTime{0};
+        std::size_t kernelRuns = 0;
+        std::chrono::nanoseconds kernelTime{0};
+        std::size_t registerAccesses = 0;
+    };
+
+    /**
+     * @brief Parse a model from a comma separated list of key=value pairs, e.g. "sync_latency_us=10,sync_gbps=12,kernel_latency_us=2,sample_ns=500,register_ns=800,wait=spin".
+     * Keys: sync_latency_us, sync_gbps (gigabytes per second), kernel_latency_us, sample_ns, register_ns, wait (none, sleep or spin).
+     *
+     * @param spec
+     * @return Model
+     * @throws std::invalid_argument for unknown keys or malformed values
+     */
+    Model parse(const std::string& spec);
+
+    /**
+     * @brief Get the current model. On first use it is read from the environment variable FINN_XRT_SIMULATION (@see parse), so benchmarks and the driver binary
+     * built against the mock can be run with a model without recompiling.
+     *
+     * @return Model
+     */
+    Model model();
+
+    /**
+     * @brief Replace the model. Runs in flight keep the times they were started with.
+     *
+     * @param pModel
+     */
+    void configure(const Model& pModel);
+
+    /**
+     * @brief Get the simulated time spent since the last reset
+     *
+     * @return Statistics
+     */
+    Statistics statistics();
+
+    /**
+     * @brief Reset the statistics
+     *
+     */
+    void resetStatistics();
+
+    /**
+     * @brief Spend time on the calling thread according to the wait mode of the model
+     *
+     * @param duration
+     */
+    void delay(std::chrono::nanoseconds duration);
+
+    /**
+     * @brief Wait until a point in time according to the wait mode of the model
+     *
+     * @param until
+     */
+    void delayUntil(std::chrono::steady_clock::time_point until);
+
+    /**
+     * @brief Account a register access and spend its latency
+     *
+     */
+    void registerAccess();
+
+    /**
+     * @brief Schedule a sync on the link of its direction. Transfers in the same direction share the bandwidth, so a transfer starts when the previous one is done.
+     *
+     * @param dir
+     * @param bytes
+     * @return std::chrono::steady_clock::time_point Time the transfer is complete
+     */
+    std::chrono::steady_clock::time_point scheduleSync(xclBOSyncDirection dir, std::size_t bytes);
+
+    /**
+     * @brief Account a kernel run
+     *
+     * @param samples
+     * @return std::chrono::steady_clock::time_point Time the kernel is idle again
+     */
+    std::chrono::steady_clock::time_point scheduleKernel(std::uint32_t samples);
+}  // namespace xrt::simulation
+
+#endif  // XRT_SIMULATION_H